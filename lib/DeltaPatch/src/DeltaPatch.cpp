@@ -0,0 +1,253 @@
+#include "DeltaPatch.h"
+
+#include <string.h>
+
+static uint32_t readLE32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+DeltaPatcher::DeltaPatcher(ReadOldFn readOld, WriteNewFn writeNew, void *ctx, HeaderFn onHeader)
+    : m_readOld(readOld), m_writeNew(writeNew), m_onHeader(onHeader), m_ctx(ctx),
+      m_state(ST_HEADER), m_result(DELTA_MORE), m_headerLen(0), m_varint(0), m_varintShift(0),
+      m_oldPos(0), m_diffLeft(0), m_extraLeft(0), m_literalLeft(0), m_written(0), m_outLen(0)
+{
+    memset(&m_header, 0, sizeof(m_header));
+}
+
+DeltaResult DeltaPatcher::feed(const uint8_t *data, size_t len)
+{
+    while ((m_result == DELTA_MORE) && (len > 0))
+    {
+        switch (m_state)
+        {
+        case ST_HEADER:
+        {
+            size_t n = DELTA_HEADER_SIZE - m_headerLen;
+            if (n > len)
+                n = len;
+            memcpy(m_headerBuf + m_headerLen, data, n);
+            m_headerLen += n;
+            data += n;
+            len -= n;
+            if (m_headerLen == DELTA_HEADER_SIZE)
+                parseHeader();
+            break;
+        }
+
+        case ST_SEEK:
+        {
+            uint32_t zz;
+            len--;
+            if (!varint(*data++, &zz))
+                break;
+            int32_t seek = (int32_t)(zz >> 1) ^ -(int32_t)(zz & 1);
+            int64_t pos = (int64_t)m_oldPos + seek;
+            if ((pos < 0) || (pos > m_header.oldSize))
+                return fail(DELTA_ERR_FORMAT);
+            m_oldPos = (uint32_t)pos;
+            m_state = ST_DIFF_LEN;
+            break;
+        }
+
+        case ST_DIFF_LEN:
+            len--;
+            if (varint(*data++, &m_diffLeft))
+                m_state = ST_EXTRA_LEN;
+            break;
+
+        case ST_EXTRA_LEN:
+            len--;
+            if (varint(*data++, &m_extraLeft))
+            {
+                uint64_t end = (uint64_t)m_written + m_diffLeft + m_extraLeft;
+                if ((end > m_header.newSize) || ((uint64_t)m_oldPos + m_diffLeft > m_header.oldSize))
+                    return fail(DELTA_ERR_FORMAT);
+                m_state = ST_TOKEN;
+                afterDiff();
+            }
+            break;
+
+        case ST_TOKEN:
+        {
+            uint32_t token;
+            len--;
+            if (!varint(*data++, &token))
+                break;
+            uint32_t n = token >> 1;
+            if ((n == 0) || (n > m_diffLeft))
+                return fail(DELTA_ERR_FORMAT);
+            m_diffLeft -= n;
+            if (token & 1)
+            {
+                m_literalLeft = n;
+                m_state = ST_LITERAL;
+            }
+            else if (copyOld(n) == DELTA_MORE)
+                afterDiff();
+            break;
+        }
+
+        case ST_LITERAL:
+        {
+            size_t n = m_literalLeft;
+            if (n > len)
+                n = len;
+            if (n > sizeof(m_old))
+                n = sizeof(m_old);
+            if (!m_readOld(m_ctx, m_oldPos, m_old, n))
+                return fail(DELTA_ERR_READ);
+            for (size_t i = 0; i < n; i++)
+                m_old[i] += data[i];
+            if (emit(m_old, n) != DELTA_MORE)
+                break;
+            m_oldPos += n;
+            m_literalLeft -= n;
+            data += n;
+            len -= n;
+            if (m_literalLeft == 0)
+                afterDiff();
+            break;
+        }
+
+        case ST_EXTRA:
+        {
+            size_t n = m_extraLeft;
+            if (n > len)
+                n = len;
+            if (emit(data, n) != DELTA_MORE)
+                break;
+            m_extraLeft -= n;
+            data += n;
+            len -= n;
+            if (m_extraLeft == 0)
+                endRecord();
+            break;
+        }
+
+        case ST_FINISHED:
+            // trailing bytes after the last record
+            return fail(DELTA_ERR_FORMAT);
+        }
+    }
+    return m_result;
+}
+
+bool DeltaPatcher::varint(uint8_t b, uint32_t *value)
+{
+    if (m_varintShift > 28)
+    {
+        fail(DELTA_ERR_FORMAT);
+        return false;
+    }
+    m_varint |= (uint32_t)(b & 0x7F) << m_varintShift;
+    m_varintShift += 7;
+    if (b & 0x80)
+        return false;
+
+    *value = m_varint;
+    m_varint = 0;
+    m_varintShift = 0;
+    return true;
+}
+
+DeltaResult DeltaPatcher::parseHeader()
+{
+    if (memcmp(m_headerBuf, "EDP1", 4) != 0)
+        return fail(DELTA_ERR_FORMAT);
+
+    m_header.oldSize = readLE32(m_headerBuf + 4);
+    m_header.newSize = readLE32(m_headerBuf + 8);
+    m_header.flags = readLE32(m_headerBuf + 12);
+    memcpy(m_header.newSha256, m_headerBuf + 16, 32);
+    memcpy(m_header.oldSha256, m_headerBuf + 48, 32);
+
+    if (m_header.flags != 0)
+        return fail(DELTA_ERR_FORMAT);
+    if ((m_onHeader != NULL) && !m_onHeader(m_ctx, m_header))
+        return fail(DELTA_ERR_ABORTED);
+
+    m_state = ST_SEEK;
+    if (m_header.newSize == 0)
+        return endRecord();
+    return DELTA_MORE;
+}
+
+// called whenever diff data may have run out: moves on to the extra bytes or the next record
+DeltaResult DeltaPatcher::afterDiff()
+{
+    if (m_diffLeft > 0)
+    {
+        m_state = ST_TOKEN;
+        return DELTA_MORE;
+    }
+    if (m_extraLeft > 0)
+    {
+        m_state = ST_EXTRA;
+        return DELTA_MORE;
+    }
+    return endRecord();
+}
+
+DeltaResult DeltaPatcher::endRecord()
+{
+    if (m_written < m_header.newSize)
+    {
+        m_state = ST_SEEK;
+        return DELTA_MORE;
+    }
+
+    m_state = ST_FINISHED;
+    if (flush() != DELTA_MORE)
+        return m_result;
+    m_result = DELTA_DONE;
+    return m_result;
+}
+
+DeltaResult DeltaPatcher::copyOld(uint32_t n)
+{
+    while (n > 0)
+    {
+        size_t chunk = n > sizeof(m_old) ? sizeof(m_old) : n;
+        if (!m_readOld(m_ctx, m_oldPos, m_old, chunk))
+            return fail(DELTA_ERR_READ);
+        if (emit(m_old, chunk) != DELTA_MORE)
+            return m_result;
+        m_oldPos += chunk;
+        n -= chunk;
+    }
+    return DELTA_MORE;
+}
+
+DeltaResult DeltaPatcher::emit(const uint8_t *buf, size_t len)
+{
+    m_written += len;
+    while (len > 0)
+    {
+        size_t n = sizeof(m_out) - m_outLen;
+        if (n > len)
+            n = len;
+        memcpy(m_out + m_outLen, buf, n);
+        m_outLen += n;
+        buf += n;
+        len -= n;
+        if ((m_outLen == sizeof(m_out)) && (flush() != DELTA_MORE))
+            return m_result;
+    }
+    return DELTA_MORE;
+}
+
+DeltaResult DeltaPatcher::flush()
+{
+    if ((m_outLen > 0) && !m_writeNew(m_ctx, m_out, m_outLen))
+        return fail(DELTA_ERR_WRITE);
+    m_outLen = 0;
+    return DELTA_MORE;
+}
+
+DeltaResult DeltaPatcher::fail(DeltaResult err)
+{
+    if (m_result == DELTA_MORE)
+        m_result = err;
+    return m_result;
+}
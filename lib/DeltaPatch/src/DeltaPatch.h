@@ -0,0 +1,109 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Streaming applier for the delta format written by tools/make_delta.py.
+//
+// A patch is a header followed by records. Each record moves the read position in the old
+// image by a signed offset, then produces diffLen bytes as old + diff (byte-wise, mod 256),
+// then appends extraLen bytes taken verbatim from the patch. Diff data is run-length coded:
+// a varint token t with t & 1 == 0 copies t >> 1 old bytes unchanged, t & 1 == 1 is followed
+// by t >> 1 diff bytes. All integers are little endian; varints are LEB128, the seek is
+// zigzag coded.
+//
+//   header: "EDP1", oldSize u32, newSize u32, flags u32 (0), newSha256[32], oldSha256[32]
+//   record: seek, diffLen, extraLen, diff tokens..., extra bytes...
+//
+// The patch is fed in arbitrary pieces as it arrives. Old bytes are fetched through a callback
+// (random access, e.g. from the running flash partition) and new bytes are handed out in
+// blocks, so the RAM used is two DELTA_BLOCK_SIZE buffers whatever the image size. The applier
+// does not hash anything; the header carries both digests for the caller to check.
+
+#ifndef DELTA_BLOCK_SIZE
+#define DELTA_BLOCK_SIZE 512
+#endif
+
+#define DELTA_HEADER_SIZE 80
+
+struct DeltaHeader
+{
+    uint32_t oldSize;
+    uint32_t newSize;
+    uint32_t flags;
+    uint8_t newSha256[32];
+    uint8_t oldSha256[32];
+};
+
+enum DeltaResult
+{
+    DELTA_MORE,        // all input consumed, feed more
+    DELTA_DONE,        // the new image is complete
+    DELTA_ERR_FORMAT,  // not a patch, or corrupt
+    DELTA_ERR_READ,    // reading the old image failed
+    DELTA_ERR_WRITE,   // the output callback refused data
+    DELTA_ERR_ABORTED  // the header callback rejected the patch
+};
+
+class DeltaPatcher
+{
+public:
+    typedef bool (*ReadOldFn)(void *ctx, uint32_t offset, uint8_t *buf, size_t len);
+    typedef bool (*WriteNewFn)(void *ctx, const uint8_t *buf, size_t len);
+    typedef bool (*HeaderFn)(void *ctx, const DeltaHeader &header); // false aborts
+
+    DeltaPatcher(ReadOldFn readOld, WriteNewFn writeNew, void *ctx, HeaderFn onHeader = NULL);
+
+    // applies the next piece of the patch; once DELTA_DONE or an error is returned
+    // every further call returns the same
+    DeltaResult feed(const uint8_t *data, size_t len);
+
+    const DeltaHeader &header() const { return m_header; }
+    uint32_t written() const { return m_written; } // new bytes produced so far
+
+private:
+    enum State
+    {
+        ST_HEADER,
+        ST_SEEK,
+        ST_DIFF_LEN,
+        ST_EXTRA_LEN,
+        ST_TOKEN,
+        ST_LITERAL,
+        ST_EXTRA,
+        ST_FINISHED
+    };
+
+    bool varint(uint8_t b, uint32_t *value); // true once a varint is complete
+    DeltaResult parseHeader();
+    DeltaResult afterDiff();
+    DeltaResult endRecord();
+    DeltaResult copyOld(uint32_t n);
+    DeltaResult emit(const uint8_t *buf, size_t len);
+    DeltaResult flush();
+    DeltaResult fail(DeltaResult err);
+
+    ReadOldFn m_readOld;
+    WriteNewFn m_writeNew;
+    HeaderFn m_onHeader;
+    void *m_ctx;
+
+    State m_state;
+    DeltaResult m_result;
+    DeltaHeader m_header;
+    uint8_t m_headerBuf[DELTA_HEADER_SIZE];
+    uint32_t m_headerLen;
+
+    uint32_t m_varint; // varint being decoded
+    int m_varintShift;
+
+    uint32_t m_oldPos;
+    uint32_t m_diffLeft;
+    uint32_t m_extraLeft;
+    uint32_t m_literalLeft;
+    uint32_t m_written; // bytes emitted, including those still in m_out
+
+    uint8_t m_old[DELTA_BLOCK_SIZE];
+    uint8_t m_out[DELTA_BLOCK_SIZE];
+    size_t m_outLen;
+};
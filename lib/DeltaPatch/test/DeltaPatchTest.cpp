@@ -0,0 +1,345 @@
+#include "DeltaPatch.h"
+#include "mbedtls/sha256.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+// Host test for DeltaPatcher against patches written by tools/make_delta.py. Builds an old and
+// a new firmware-like image, runs the script on them and applies the patch: in one piece and
+// in pieces of many sizes, truncated, corrupted, and against the wrong base image, which the
+// header callback (as otaDeltaCheckHeader() does on the device) must refuse before anything
+// is written. Exits with 1 if any check fails.
+//
+// Usage: deltatest path/to/make_delta.py
+
+typedef std::vector<uint8_t> Bytes;
+
+static int s_failures = 0;
+
+#define CHECK(cond, ...)                      \
+    do                                        \
+    {                                         \
+        if (!(cond))                          \
+        {                                     \
+            printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+            printf(__VA_ARGS__);              \
+            printf("\n");                     \
+            s_failures++;                     \
+        }                                     \
+    } while (0)
+
+static uint32_t s_seed = 12345;
+
+static uint32_t nextRandom()
+{
+    s_seed = s_seed * 1103515245 + 12345;
+    return s_seed >> 8;
+}
+
+static void sha256(const Bytes &data, uint8_t digest[32])
+{
+    mbedtls_sha256(data.data(), data.size(), digest, 0);
+}
+
+// code-like data: short repeated instruction patterns with embedded addresses, and tables
+static Bytes makeOldImage(size_t size)
+{
+    Bytes image;
+    while (image.size() < size)
+    {
+        uint32_t kind = nextRandom() % 4;
+        if (kind == 0)
+        {
+            uint32_t address = 0x400d0000 + (nextRandom() % 0x10000) * 4;
+            for (int i = 0; i < 4; i++)
+                image.push_back((uint8_t)(address >> (8 * i)));
+        }
+        else if (kind == 1)
+        {
+            static const uint8_t pattern[] = {0x36, 0x41, 0x00, 0x0c, 0x02, 0x1d, 0xf0, 0x00};
+            image.insert(image.end(), pattern, pattern + sizeof(pattern));
+        }
+        else
+        {
+            for (int i = 0; i < 16; i++)
+                image.push_back((uint8_t)nextRandom());
+        }
+    }
+    image.resize(size);
+    return image;
+}
+
+// what a rebuild does to an image: code inserted and removed, addresses moved, a longer tail
+static Bytes makeNewImage(const Bytes &old)
+{
+    Bytes image(old);
+    for (size_t i = 0; i + 4 <= image.size(); i += 64 + nextRandom() % 512)
+        image[i + 1] += 4;
+
+    Bytes inserted(777);
+    for (uint8_t &b : inserted)
+        b = (uint8_t)nextRandom();
+    image.insert(image.begin() + image.size() / 10, inserted.begin(), inserted.end());
+    image.erase(image.begin() + image.size() / 2, image.begin() + image.size() / 2 + 1500);
+    for (int i = 0; i < 3000; i++)
+        image.push_back((uint8_t)nextRandom());
+    return image;
+}
+
+static bool writeFile(const std::string &path, const Bytes &data)
+{
+    FILE *f = fopen(path.c_str(), "wb");
+    if (f == NULL)
+        return false;
+    bool ok = fwrite(data.data(), 1, data.size(), f) == data.size();
+    return (fclose(f) == 0) && ok;
+}
+
+static bool readFile(const std::string &path, Bytes &data)
+{
+    FILE *f = fopen(path.c_str(), "rb");
+    if (f == NULL)
+        return false;
+    uint8_t buf[4096];
+    size_t n;
+    data.clear();
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+        data.insert(data.end(), buf, buf + n);
+    fclose(f);
+    return true;
+}
+
+// one application of a patch, with the callbacks counting what happened
+struct Apply
+{
+    const Bytes *base;
+    Bytes output;
+    int writes;
+    bool checkBase; // refuse patches made against another image, like otaDeltaCheckHeader()
+};
+
+static bool readOld(void *ctx, uint32_t offset, uint8_t *buf, size_t len)
+{
+    const Bytes &base = *((Apply *)ctx)->base;
+    if ((offset > base.size()) || (len > base.size() - offset))
+        return false;
+    memcpy(buf, base.data() + offset, len);
+    return true;
+}
+
+static bool writeNew(void *ctx, const uint8_t *buf, size_t len)
+{
+    Apply *a = (Apply *)ctx;
+    a->writes++;
+    a->output.insert(a->output.end(), buf, buf + len);
+    return true;
+}
+
+static bool checkHeader(void *ctx, const DeltaHeader &header)
+{
+    Apply *a = (Apply *)ctx;
+    if (!a->checkBase)
+        return true;
+    uint8_t digest[32];
+    sha256(*a->base, digest);
+    return (header.oldSize == a->base->size()) && (memcmp(digest, header.oldSha256, sizeof(digest)) == 0);
+}
+
+// feeds patch in pieces of pieceSize bytes (0: random sizes up to 2 KB), stopping at the first
+// result other than DELTA_MORE
+static DeltaResult applyPatch(const Bytes &patch, const Bytes &base, size_t pieceSize, Apply &a,
+                              DeltaHeader *header = NULL)
+{
+    a.base = &base;
+    a.output.clear();
+    a.writes = 0;
+
+    DeltaPatcher patcher(readOld, writeNew, &a, checkHeader);
+    DeltaResult result = DELTA_MORE;
+    size_t pos = 0;
+    while ((result == DELTA_MORE) && (pos < patch.size()))
+    {
+        size_t n = pieceSize ? pieceSize : 1 + nextRandom() % 2048;
+        if (n > patch.size() - pos)
+            n = patch.size() - pos;
+        result = patcher.feed(patch.data() + pos, n);
+        pos += n;
+    }
+    if (header != NULL)
+        *header = patcher.header();
+    return result;
+}
+
+// a patch counts as accepted only when it completes and its output has the digest in its header
+static bool accepted(DeltaResult result, const Apply &a, const DeltaHeader &header)
+{
+    uint8_t digest[32];
+    sha256(a.output, digest);
+    return (result == DELTA_DONE) && (memcmp(digest, header.newSha256, sizeof(digest)) == 0);
+}
+
+static void testRoundTrip(const Bytes &patch, const Bytes &oldImage, const Bytes &newImage)
+{
+    Apply a = {};
+    a.checkBase = true;
+    DeltaHeader header;
+    DeltaResult result = applyPatch(patch, oldImage, patch.size(), a, &header);
+
+    CHECK(result == DELTA_DONE, "round trip: result %d", result);
+    CHECK(a.output == newImage, "round trip: output differs (%zu of %zu bytes)", a.output.size(), newImage.size());
+    CHECK(header.oldSize == oldImage.size() && header.newSize == newImage.size(), "round trip: header sizes %u %u",
+          header.oldSize, header.newSize);
+
+    uint8_t digest[32];
+    sha256(newImage, digest);
+    CHECK(memcmp(digest, header.newSha256, sizeof(digest)) == 0, "round trip: new image digest");
+    sha256(oldImage, digest);
+    CHECK(memcmp(digest, header.oldSha256, sizeof(digest)) == 0, "round trip: old image digest");
+
+    // once done every further call returns the same and writes nothing
+    DeltaPatcher patcher(readOld, writeNew, &a, NULL);
+    a.output.clear();
+    patcher.feed(patch.data(), patch.size());
+    CHECK(patcher.feed(patch.data(), patch.size()) == DELTA_DONE && a.output == newImage,
+          "round trip: input after the end changed the result");
+}
+
+static void testPieces(const Bytes &patch, const Bytes &oldImage, const Bytes &newImage)
+{
+    const size_t sizes[] = {1, 2, 3, 7, 13, 79, 80, 81, 511, DELTA_BLOCK_SIZE, 513, 4096, 0, 0, 0};
+    for (size_t size : sizes)
+    {
+        Apply a = {};
+        DeltaResult result = applyPatch(patch, oldImage, size, a);
+        CHECK(result == DELTA_DONE && a.output == newImage, "pieces of %zu: result %d, %zu bytes", size, result,
+              a.output.size());
+    }
+}
+
+static void testTruncated(const Bytes &patch, const Bytes &oldImage, const Bytes &newImage)
+{
+    const size_t cuts[] = {0, 10, DELTA_HEADER_SIZE - 1, DELTA_HEADER_SIZE, DELTA_HEADER_SIZE + 1, patch.size() / 3,
+                           patch.size() / 2, patch.size() - 100, patch.size() - 1};
+    for (size_t cut : cuts)
+    {
+        Bytes part(patch.begin(), patch.begin() + cut);
+        Apply a = {};
+        DeltaResult result = applyPatch(part, oldImage, 0, a);
+        CHECK(result == DELTA_MORE, "truncated at %zu: result %d", cut, result);
+        CHECK(a.output.size() < newImage.size(), "truncated at %zu: %zu bytes out", cut, a.output.size());
+    }
+}
+
+static void testCorrupt(const Bytes &patch, const Bytes &oldImage)
+{
+    Apply a = {};
+    DeltaHeader header;
+
+    Bytes badMagic(patch);
+    badMagic[0] = 'X';
+    CHECK(applyPatch(badMagic, oldImage, 0, a) == DELTA_ERR_FORMAT && a.writes == 0, "bad magic accepted");
+
+    Bytes badFlags(patch);
+    badFlags[12] = 1;
+    CHECK(applyPatch(badFlags, oldImage, 0, a) == DELTA_ERR_FORMAT && a.writes == 0, "unknown flags accepted");
+
+    // a seek far past the end of the old image in the first record
+    Bytes badSeek(patch.begin(), patch.begin() + DELTA_HEADER_SIZE);
+    const uint8_t seek[] = {0xfe, 0xff, 0xff, 0x0f};
+    badSeek.insert(badSeek.end(), seek, seek + sizeof(seek));
+    badSeek.insert(badSeek.end(), patch.begin() + DELTA_HEADER_SIZE + 1, patch.end());
+    CHECK(applyPatch(badSeek, oldImage, 0, a) == DELTA_ERR_FORMAT, "seek outside the old image accepted");
+
+    // a varint longer than 32 bits
+    Bytes longVarint(patch.begin(), patch.begin() + DELTA_HEADER_SIZE);
+    longVarint.insert(longVarint.end(), 6, 0x80);
+    CHECK(applyPatch(longVarint, oldImage, 0, a) == DELTA_ERR_FORMAT, "overlong varint accepted");
+
+    // single flipped bytes anywhere must never produce an image that passes the digest check
+    int detected = 0;
+    const int trials = 300;
+    for (int i = 0; i < trials; i++)
+    {
+        Bytes corrupt(patch);
+        size_t pos = nextRandom() % corrupt.size();
+        corrupt[pos] ^= (uint8_t)(1 + nextRandom() % 255);
+        a.checkBase = true;
+        DeltaResult result = applyPatch(corrupt, oldImage, 0, a, &header);
+        a.checkBase = false;
+        if (!accepted(result, a, header))
+            detected++;
+        else
+            CHECK(false, "corrupt byte at %zu accepted", pos);
+    }
+    printf("corrupt: %d of %d single byte corruptions refused\n", detected, trials);
+}
+
+static void testWrongBase(const Bytes &patch, const Bytes &oldImage)
+{
+    Bytes otherBase(oldImage);
+    otherBase[otherBase.size() / 3] ^= 0x55;
+
+    Apply a = {};
+    a.checkBase = true;
+    DeltaResult result = applyPatch(patch, otherBase, 0, a);
+    CHECK(result == DELTA_ERR_ABORTED, "wrong base: result %d", result);
+    CHECK(a.writes == 0 && a.output.empty(), "wrong base: %d writes before the refusal", a.writes);
+
+    Bytes shorterBase(oldImage.begin(), oldImage.end() - 1);
+    result = applyPatch(patch, shorterBase, 0, a);
+    CHECK(result == DELTA_ERR_ABORTED && a.writes == 0, "shorter base: result %d, %d writes", result, a.writes);
+
+    // without the check a short base fails on the read, never with a complete image
+    a.checkBase = false;
+    Bytes tinyBase(oldImage.begin(), oldImage.begin() + 100);
+    result = applyPatch(patch, tinyBase, 0, a);
+    CHECK(result == DELTA_ERR_READ || result == DELTA_ERR_FORMAT, "tiny base: result %d", result);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 2)
+    {
+        printf("usage: %s path/to/make_delta.py\n", argv[0]);
+        return 2;
+    }
+
+    char dir[] = "/tmp/deltatestXXXXXX";
+    if (mkdtemp(dir) == NULL)
+    {
+        perror("mkdtemp");
+        return 1;
+    }
+    std::string oldPath = std::string(dir) + "/old.bin";
+    std::string newPath = std::string(dir) + "/new.bin";
+    std::string patchPath = std::string(dir) + "/new.delta";
+
+    Bytes oldImage = makeOldImage(96 * 1024);
+    Bytes newImage = makeNewImage(oldImage);
+    Bytes patch;
+    std::string command = std::string("python3 ") + argv[1] + " " + oldPath + " " + newPath + " " + patchPath;
+    if (!writeFile(oldPath, oldImage) || !writeFile(newPath, newImage) || (system(command.c_str()) != 0) ||
+        !readFile(patchPath, patch))
+    {
+        printf("FAIL: could not make the patch with %s\n", argv[1]);
+        return 1;
+    }
+
+    testRoundTrip(patch, oldImage, newImage);
+    testPieces(patch, oldImage, newImage);
+    testTruncated(patch, oldImage, newImage);
+    testCorrupt(patch, oldImage);
+    testWrongBase(patch, oldImage);
+
+    unlink(oldPath.c_str());
+    unlink(newPath.c_str());
+    unlink(patchPath.c_str());
+    rmdir(dir);
+
+    printf("%s\n", s_failures ? "FAILED" : "passed");
+    return s_failures ? 1 : 0;
+}
@@ -0,0 +1,218 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+
+// A ring of the most recent frames, for clips that start before the event that triggers them.
+//
+// Frame bytes are copied back to back into one buffer the caller supplies (PSRAM on the
+// ESP32), and described by a ring of MaxFrames entries. push() never waits and never
+// allocates: it first drops frames older than the configured duration, then drops the oldest
+// frames until the new one fits in the buffer and in the descriptor ring. A frame larger than
+// the whole buffer is refused.
+//
+// There is one writer. Any number of readers copy frames out by sequence number while it keeps
+// pushing, without a lock: the writer retires a frame (advances oldestSeq()) before it reuses
+// its bytes or its descriptor, and a reader checks after its copy that the frame was not
+// retired meanwhile, so a frame overwritten during the copy is reported as gone rather than
+// returned torn. Readers that fall behind lose frames, the writer never waits for them.
+//
+// Only the C++ standard library is used; test/ runs it on the host with make.
+
+struct FrameRingInfo
+{
+    uint32_t seq;
+    uint32_t len;
+    uint32_t timeMs; // as given to push()
+};
+
+template <size_t MaxFrames>
+class FrameRing
+{
+public:
+    FrameRing() : m_buf(NULL), m_capacity(0), m_durationMs(0), m_head(0), m_oldest(0), m_next(0),
+                  m_expired(0), m_dropped(0), m_refused(0) {}
+
+    // buf must stay valid until the ring is no longer used. Frames older than durationMs
+    // (relative to the newest frame pushed) are dropped.
+    void begin(uint8_t *buf, size_t capacity, uint32_t durationMs)
+    {
+        m_buf = buf;
+        m_capacity = capacity;
+        m_durationMs = durationMs;
+        m_head = 0;
+        m_oldest.store(m_next.load(std::memory_order_relaxed), std::memory_order_release);
+    }
+
+    bool isReady() const { return m_buf != NULL; }
+    size_t capacity() const { return m_capacity; }
+    uint32_t durationMs() const { return m_durationMs; }
+
+    // copies a frame in, dropping the oldest frames to make room. False if it can never fit.
+    bool push(const uint8_t *data, size_t len, uint32_t timeMs)
+    {
+        if (m_buf == NULL || len == 0 || len > m_capacity)
+        {
+            m_refused.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        uint32_t oldest = m_oldest.load(std::memory_order_relaxed);
+        uint32_t next = m_next.load(std::memory_order_relaxed);
+
+        while (oldest != next && timeMs - slot(oldest).timeMs > m_durationMs)
+        {
+            retire(++oldest);
+            m_expired.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        size_t offset;
+        while (!findSpace(oldest, next, len, offset))
+        {
+            retire(++oldest);
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (next - oldest >= MaxFrames)
+        {
+            retire(++oldest);
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        memcpy(m_buf + offset, data, len);
+        Entry &e = slot(next);
+        e.offset = offset;
+        e.len = len;
+        e.timeMs = timeMs;
+        m_head = offset + len;
+        m_next.store(next + 1, std::memory_order_release);
+        return true;
+    }
+
+    // the frames held are oldestSeq() .. nextSeq() - 1
+    uint32_t oldestSeq() const { return m_oldest.load(std::memory_order_acquire); }
+    uint32_t nextSeq() const { return m_next.load(std::memory_order_acquire); }
+
+    // first frame still held that was pushed at or after timeMs, nextSeq() if there is none
+    uint32_t seqAtOrAfter(uint32_t timeMs) const
+    {
+        uint32_t seq = oldestSeq();
+        while (seq != nextSeq())
+        {
+            uint32_t t = slot(seq).timeMs;
+            if (!stillHeld(seq))
+            {
+                seq = oldestSeq(); // retired under us, resume from the new oldest
+                continue;
+            }
+            if ((int32_t)(t - timeMs) >= 0)
+                break;
+            seq++;
+        }
+        return seq;
+    }
+
+    // describes a held frame, false once it has been retired
+    bool info(uint32_t seq, FrameRingInfo &out) const
+    {
+        if (!held(seq))
+            return false;
+        const Entry &e = slot(seq);
+        out.seq = seq;
+        out.len = e.len;
+        out.timeMs = e.timeMs;
+        return stillHeld(seq);
+    }
+
+    // copies frame seq into dst (at most dstLen bytes). False if the frame is not held, was
+    // retired during the copy, or does not fit; out.len then still tells the size needed.
+    bool copy(uint32_t seq, uint8_t *dst, size_t dstLen, FrameRingInfo &out) const
+    {
+        if (!info(seq, out) || out.len > dstLen)
+            return false;
+        memcpy(dst, m_buf + slot(seq).offset, out.len);
+        return stillHeld(seq);
+    }
+
+    uint32_t expired() const { return m_expired.load(std::memory_order_relaxed); } // aged out of the duration
+    uint32_t dropped() const { return m_dropped.load(std::memory_order_relaxed); } // evicted early to make room
+    uint32_t refused() const { return m_refused.load(std::memory_order_relaxed); } // larger than the buffer
+
+private:
+    struct Entry
+    {
+        size_t offset;
+        uint32_t len;
+        uint32_t timeMs;
+    };
+
+    Entry &slot(uint32_t seq) { return m_entries[seq % MaxFrames]; }
+    const Entry &slot(uint32_t seq) const { return m_entries[seq % MaxFrames]; }
+
+    bool held(uint32_t seq) const
+    {
+        uint32_t oldest = oldestSeq();
+        return (seq - oldest) < (nextSeq() - oldest);
+    }
+
+    // after reading a frame: was it retired while we read?
+    bool stillHeld(uint32_t seq) const
+    {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return (int32_t)(seq - m_oldest.load(std::memory_order_relaxed)) >= 0;
+    }
+
+    void retire(uint32_t newOldest)
+    {
+        m_oldest.store(newOldest, std::memory_order_relaxed);
+        // readers must see the frame retired before they can see its bytes change
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    // where len bytes can go without touching a held frame. Held frames occupy one run
+    // from the oldest frame to m_head, possibly wrapping to the start of the buffer once.
+    bool findSpace(uint32_t oldest, uint32_t next, size_t len, size_t &offset) const
+    {
+        if (oldest == next)
+        {
+            offset = 0;
+            return true;
+        }
+
+        size_t tail = slot(oldest).offset;
+        bool wrapped = slot(next - 1).offset < tail;
+        if (!wrapped)
+        {
+            if (len <= m_capacity - m_head)
+            {
+                offset = m_head;
+                return true;
+            }
+            if (len <= tail)
+            {
+                offset = 0;
+                return true;
+            }
+            return false;
+        }
+
+        if (len <= tail - m_head)
+        {
+            offset = m_head;
+            return true;
+        }
+        return false;
+    }
+
+    uint8_t *m_buf;
+    size_t m_capacity;
+    uint32_t m_durationMs;
+    size_t m_head; // end of the newest frame, writer only
+    Entry m_entries[MaxFrames];
+    std::atomic<uint32_t> m_oldest;
+    std::atomic<uint32_t> m_next;
+    std::atomic<uint32_t> m_expired;
+    std::atomic<uint32_t> m_dropped;
+    std::atomic<uint32_t> m_refused;
+};
@@ -0,0 +1,285 @@
+#include "FrameRing.h"
+
+#include <stdio.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// Host test for FrameRing: eviction by age, by buffer space and by descriptors, placement as
+// the frames wrap around the buffer, refusal of frames that can never fit, and readers, on
+// this thread and on another one, finding out that a frame was retired rather than getting
+// its bytes torn. Exits with 1 if any check fails.
+
+static int s_failures = 0;
+
+#define CHECK(cond, ...)                                \
+    do                                                  \
+    {                                                   \
+        if (!(cond))                                    \
+        {                                               \
+            printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+            printf(__VA_ARGS__);                        \
+            printf("\n");                               \
+            s_failures++;                               \
+        }                                               \
+    } while (0)
+
+static uint32_t s_seed = 4321;
+
+static uint32_t nextRandom()
+{
+    s_seed = s_seed * 1103515245 + 12345;
+    return s_seed >> 8;
+}
+
+// frame contents that tell which frame they are: the sequence number, then bytes derived from it
+static void fillFrame(std::vector<uint8_t> &frame, uint32_t seq, size_t len)
+{
+    frame.resize(len);
+    for (size_t i = 0; i < len; i++)
+        frame[i] = (uint8_t)(seq * 31 + i);
+    if (len >= 4)
+        memcpy(frame.data(), &seq, 4);
+}
+
+static bool frameIntact(const uint8_t *data, size_t len, uint32_t seq)
+{
+    if (len >= 4 && memcmp(data, &seq, 4) != 0)
+        return false;
+    for (size_t i = 4; i < len; i++)
+    {
+        if (data[i] != (uint8_t)(seq * 31 + i))
+            return false;
+    }
+    return true;
+}
+
+// every held frame has its own bytes and the held frames fit in the buffer
+template <size_t N>
+static bool allIntact(const FrameRing<N> &ring, const char *what)
+{
+    std::vector<uint8_t> out(ring.capacity());
+    size_t total = 0;
+    for (uint32_t seq = ring.oldestSeq(); seq != ring.nextSeq(); seq++)
+    {
+        FrameRingInfo info;
+        if (!ring.copy(seq, out.data(), out.size(), info) || !frameIntact(out.data(), info.len, seq))
+        {
+            CHECK(false, "%s: frame %u damaged", what, seq);
+            return false;
+        }
+        total += info.len;
+    }
+    CHECK(total <= ring.capacity(), "%s: %zu bytes held in %zu", what, total, ring.capacity());
+    return true;
+}
+
+static void testAge()
+{
+    static uint8_t buf[4096];
+    FrameRing<64> ring;
+    ring.begin(buf, sizeof(buf), 100);
+
+    std::vector<uint8_t> frame;
+    for (uint32_t i = 0; i < 30; i++)
+    {
+        fillFrame(frame, ring.nextSeq(), 20);
+        CHECK(ring.push(frame.data(), frame.size(), 1000 + i * 10), "age: push %u", i);
+    }
+
+    // newest at 1290: frames from 1190 on are within the duration, the rest aged out
+    FrameRingInfo info = {};
+    CHECK(ring.info(ring.oldestSeq(), info) && info.timeMs == 1190, "age: oldest at %u", info.timeMs);
+    CHECK(ring.nextSeq() - ring.oldestSeq() == 11, "age: %u frames held", ring.nextSeq() - ring.oldestSeq());
+    CHECK(ring.expired() == 19 && ring.dropped() == 0, "age: expired %u dropped %u", ring.expired(), ring.dropped());
+    CHECK(ring.seqAtOrAfter(1245) == ring.oldestSeq() + 6, "age: seqAtOrAfter %u", ring.seqAtOrAfter(1245));
+    CHECK(ring.seqAtOrAfter(0) == ring.oldestSeq(), "age: seqAtOrAfter before the oldest");
+    CHECK(ring.seqAtOrAfter(2000) == ring.nextSeq(), "age: seqAtOrAfter after the newest");
+
+    // a gap longer than the duration leaves only the new frame
+    fillFrame(frame, ring.nextSeq(), 20);
+    ring.push(frame.data(), frame.size(), 5000);
+    CHECK(ring.nextSeq() - ring.oldestSeq() == 1, "age: %u frames after a gap", ring.nextSeq() - ring.oldestSeq());
+
+    // times wrap around at 2^32
+    ring.begin(buf, sizeof(buf), 100);
+    for (uint32_t i = 0; i < 20; i++)
+    {
+        fillFrame(frame, ring.nextSeq(), 20);
+        ring.push(frame.data(), frame.size(), 0xffffff00u + i * 20);
+    }
+    CHECK(ring.nextSeq() - ring.oldestSeq() == 6, "age: %u frames held across the time wrap",
+          ring.nextSeq() - ring.oldestSeq());
+    allIntact(ring, "age");
+}
+
+static void testBytes()
+{
+    static uint8_t buf[1000];
+    FrameRing<64> ring;
+    ring.begin(buf, sizeof(buf), 60000);
+
+    std::vector<uint8_t> frame;
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        fillFrame(frame, ring.nextSeq(), 300);
+        ring.push(frame.data(), frame.size(), i);
+    }
+    CHECK(ring.dropped() == 0, "bytes: dropped %u with room left", ring.dropped());
+
+    // 100 bytes left at the end: the oldest frame goes and the new one starts the buffer again
+    fillFrame(frame, ring.nextSeq(), 300);
+    ring.push(frame.data(), frame.size(), 3);
+    CHECK(ring.oldestSeq() == 1 && ring.nextSeq() == 4 && ring.dropped() == 1, "bytes: oldest %u dropped %u",
+          ring.oldestSeq(), ring.dropped());
+
+    // a large frame evicts as many as it needs
+    fillFrame(frame, ring.nextSeq(), 900);
+    ring.push(frame.data(), frame.size(), 4);
+    CHECK(ring.oldestSeq() == 4 && ring.nextSeq() == 5, "bytes: %u..%u held after a large frame", ring.oldestSeq(),
+          ring.nextSeq());
+
+    // a frame of exactly the buffer size fits on its own
+    fillFrame(frame, ring.nextSeq(), sizeof(buf));
+    CHECK(ring.push(frame.data(), frame.size(), 5), "bytes: full size frame refused");
+    CHECK(ring.nextSeq() - ring.oldestSeq() == 1, "bytes: full size frame shares the buffer");
+    allIntact(ring, "bytes");
+}
+
+static void testDescriptors()
+{
+    static uint8_t buf[4096];
+    FrameRing<4> ring;
+    ring.begin(buf, sizeof(buf), 60000);
+
+    std::vector<uint8_t> frame;
+    for (uint32_t i = 0; i < 10; i++)
+    {
+        fillFrame(frame, ring.nextSeq(), 10);
+        ring.push(frame.data(), frame.size(), i);
+    }
+    CHECK(ring.nextSeq() - ring.oldestSeq() == 4 && ring.oldestSeq() == 6, "descriptors: %u..%u held",
+          ring.oldestSeq(), ring.nextSeq());
+    CHECK(ring.dropped() == 6, "descriptors: dropped %u", ring.dropped());
+    allIntact(ring, "descriptors");
+}
+
+static void testWrap()
+{
+    static uint8_t buf[10000];
+    FrameRing<32> ring;
+    ring.begin(buf, sizeof(buf), 1000);
+
+    // frames of every size land wrapped around the buffer without overlapping one another
+    std::vector<uint8_t> frame;
+    for (uint32_t i = 0; i < 20000; i++)
+    {
+        size_t len = 1 + nextRandom() % (i % 100 == 0 ? sizeof(buf) : 1500);
+        uint32_t seq = ring.nextSeq();
+        fillFrame(frame, seq, len);
+        CHECK(ring.push(frame.data(), frame.size(), i * 7), "wrap: push of %zu refused", len);
+
+        // the newest frame is always held, and nothing more than fits
+        FrameRingInfo info;
+        CHECK(ring.info(seq, info) && info.len == len, "wrap: newest frame %u missing", seq);
+        if ((i % 97 == 0) && !allIntact(ring, "wrap"))
+            break;
+    }
+    allIntact(ring, "wrap");
+}
+
+static void testRefused()
+{
+    static uint8_t buf[500];
+    FrameRing<8> ring;
+
+    std::vector<uint8_t> frame;
+    fillFrame(frame, 0, 10);
+    CHECK(!ring.push(frame.data(), frame.size(), 0), "refused: push before begin() accepted");
+
+    ring.begin(buf, sizeof(buf), 60000);
+    ring.push(frame.data(), frame.size(), 0);
+    fillFrame(frame, 1, sizeof(buf) + 1);
+    CHECK(!ring.push(frame.data(), frame.size(), 1), "refused: oversize frame accepted");
+    CHECK(!ring.push(frame.data(), 0, 1), "refused: empty frame accepted");
+    CHECK(ring.refused() == 3, "refused: counted %u", ring.refused());
+    CHECK(ring.oldestSeq() == 0 && ring.nextSeq() == 1 && ring.dropped() == 0,
+          "refused: an oversize frame evicted frames");
+    allIntact(ring, "refused");
+}
+
+static void testRetired()
+{
+    static uint8_t buf[1000];
+    FrameRing<8> ring;
+    ring.begin(buf, sizeof(buf), 60000);
+
+    std::vector<uint8_t> frame;
+    fillFrame(frame, 0, 400);
+    ring.push(frame.data(), frame.size(), 0);
+
+    uint8_t out[1000];
+    FrameRingInfo info = {};
+    CHECK(!ring.copy(0, out, 399, info) && info.len == 400, "retired: copy into a short buffer");
+    CHECK(ring.copy(0, out, sizeof(out), info), "retired: copy of a held frame failed");
+
+    for (uint32_t i = 1; i < 4; i++)
+    {
+        fillFrame(frame, i, 400);
+        ring.push(frame.data(), frame.size(), i);
+    }
+    CHECK(!ring.info(0, info) && !ring.copy(0, out, sizeof(out), info), "retired: frame 0 still readable");
+    CHECK(!ring.copy(ring.nextSeq(), out, sizeof(out), info), "retired: frame not yet pushed readable");
+
+    // a reader on another thread: every copy that succeeds is the frame it asked for, whole
+    static uint8_t bigBuf[64 * 1024];
+    FrameRing<16> shared;
+    shared.begin(bigBuf, sizeof(bigBuf), 60000);
+    std::atomic<bool> stop(false);
+    uint32_t copied = 0;
+    uint32_t gone = 0;
+    uint32_t torn = 0;
+
+    std::thread reader([&]() {
+        std::vector<uint8_t> dst(sizeof(bigBuf));
+        FrameRingInfo readInfo;
+        while (!stop.load())
+        {
+            uint32_t seq = shared.oldestSeq(); // the next to be evicted, the most likely to tear
+            if (seq == shared.nextSeq())
+                continue;
+            if (!shared.copy(seq, dst.data(), dst.size(), readInfo))
+                gone++;
+            else if (!frameIntact(dst.data(), readInfo.len, seq))
+                torn++;
+            else
+                copied++;
+        }
+    });
+
+    std::vector<uint8_t> writeFrame;
+    for (uint32_t i = 0; i < 200000; i++)
+    {
+        fillFrame(writeFrame, shared.nextSeq(), 1000 + nextRandom() % 8000);
+        shared.push(writeFrame.data(), writeFrame.size(), i);
+    }
+    stop.store(true);
+    reader.join();
+
+    printf("retired: reader copied %u frames, found %u retired\n", copied, gone);
+    CHECK(torn == 0, "retired: %u torn frames returned", torn);
+    CHECK(copied > 0, "retired: the reader copied nothing");
+}
+
+int main()
+{
+    testAge();
+    testBytes();
+    testDescriptors();
+    testWrap();
+    testRefused();
+    testRetired();
+
+    printf("%s\n", s_failures ? "FAILED" : "passed");
+    return s_failures ? 1 : 0;
+}
@@ -0,0 +1,373 @@
+#include <Arduino.h>
+
+#include "HostPlatform.h"
+#include "esp_ota_ops.h"
+
+#include <atomic>
+#include <mutex>
+
+#include <poll.h>
+#include <sched.h>
+#include <unistd.h>
+
+#pragma region Timing
+
+void delay(uint32_t ms)
+{
+    vTaskDelay(pdMS_TO_TICKS(ms));
+}
+
+void delayMicroseconds(uint32_t us)
+{
+    usleep(us);
+}
+
+void yield(void)
+{
+    sched_yield();
+}
+
+#pragma endregion
+
+#pragma region GPIO
+
+// Levels are written from signal handlers, so they are lock-free atomics. A pin reads its output
+// level when it is an output, then the level driven from outside (HOST_GPIO, SIGUSR1/2), then
+// its pull. Driven levels are stored plus one, 0 is "not driven".
+static const int HOST_GPIO_COUNT = 40;
+static std::atomic<int8_t> s_outputLevel[HOST_GPIO_COUNT];
+static std::atomic<int8_t> s_inputLevel[HOST_GPIO_COUNT];
+static std::atomic<int8_t> s_pull[HOST_GPIO_COUNT];
+static std::atomic<uint8_t> s_mode[HOST_GPIO_COUNT];
+
+static void gpioInit()
+{
+    static std::once_flag once;
+    std::call_once(once, []() {
+        // "2:1,13:0"
+        const char *spec = hostEnv("HOST_GPIO", "");
+        while (*spec)
+        {
+            char *end;
+            long pin = strtol(spec, &end, 10);
+            if (*end != ':')
+                break;
+            long level = strtol(end + 1, &end, 10);
+            if (pin >= 0 && pin < HOST_GPIO_COUNT)
+                s_inputLevel[pin] = (level ? HIGH : LOW) + 1;
+            spec = (*end == ',') ? end + 1 : end;
+        }
+    });
+}
+
+void hostGpioPull(int pin, int pull)
+{
+    if (pin < 0 || pin >= HOST_GPIO_COUNT)
+        return;
+    gpioInit();
+    s_pull[pin] = pull;
+}
+
+void hostGpioSetInputs(uint64_t pins, int level)
+{
+    for (int pin = 0; pin < HOST_GPIO_COUNT; pin++)
+    {
+        if (pins & (1ULL << pin))
+            s_inputLevel[pin] = (level ? HIGH : LOW) + 1;
+    }
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    if (pin >= HOST_GPIO_COUNT)
+        return;
+    gpioInit();
+    s_mode[pin] = mode;
+    if (mode & PULLUP)
+        s_pull[pin] = 1;
+    else if (mode & PULLDOWN)
+        s_pull[pin] = -1;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+    if (pin >= HOST_GPIO_COUNT)
+        return;
+    s_outputLevel[pin] = val ? HIGH : LOW;
+}
+
+int digitalRead(uint8_t pin)
+{
+    if (pin >= HOST_GPIO_COUNT)
+        return LOW;
+    gpioInit();
+    if ((s_mode[pin] & OUTPUT) == OUTPUT)
+        return s_outputLevel[pin];
+    int level = s_inputLevel[pin];
+    if (level > 0)
+        return level - 1;
+    return (s_pull[pin] > 0) ? HIGH : LOW;
+}
+
+uint16_t analogRead(uint8_t pin)
+{
+    return digitalRead(pin) ? 4095 : 0;
+}
+
+// nothing drives the pins, so there is never an edge to report
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode)
+{
+    (void)pin, (void)handler, (void)mode;
+}
+
+void detachInterrupt(uint8_t pin)
+{
+    (void)pin;
+}
+
+#pragma endregion
+
+#pragma region Math
+
+long random(long howbig)
+{
+    if (howbig <= 0)
+        return 0;
+    return esp_random() % howbig;
+}
+
+long random(long howsmall, long howbig)
+{
+    if (howsmall >= howbig)
+        return howsmall;
+    return random(howbig - howsmall) + howsmall;
+}
+
+void randomSeed(unsigned long seed)
+{
+    (void)seed; // esp_random() is a hardware RNG on the ESP32 as well
+}
+
+long map(long x, long in_min, long in_max, long out_min, long out_max)
+{
+    if (in_max == in_min)
+        return out_min;
+    return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+#pragma endregion
+
+#pragma region Time
+
+// as setTimeZone() in esp32-hal-time.c: POSIX offsets are west of UTC, so the sign flips, and
+// "DST" with no rule follows the US dates as newlib does
+void configTime(long gmtOffset_sec, int daylightOffset_sec, const char *server1, const char *server2,
+                const char *server3)
+{
+    (void)server1, (void)server2, (void)server3;
+
+    long offset = -gmtOffset_sec;
+    char cst[24];
+    char cdt[24] = "DST";
+    if (offset % 3600)
+        snprintf(cst, sizeof(cst), "UTC%ld:%02ld:%02ld", offset / 3600, labs((offset % 3600) / 60), labs(offset % 60));
+    else
+        snprintf(cst, sizeof(cst), "UTC%ld", offset / 3600);
+    if (daylightOffset_sec != 3600)
+    {
+        long dst = offset - daylightOffset_sec;
+        if (dst % 3600)
+            snprintf(cdt, sizeof(cdt), "DST%ld:%02ld:%02ld", dst / 3600, labs((dst % 3600) / 60), labs(dst % 60));
+        else
+            snprintf(cdt, sizeof(cdt), "DST%ld", dst / 3600);
+    }
+
+    char tz[48];
+    snprintf(tz, sizeof(tz), "%s%s", cst, cdt);
+    setenv("TZ", tz, 1);
+    tzset();
+}
+
+void configTzTime(const char *tz, const char *server1, const char *server2, const char *server3)
+{
+    (void)server1, (void)server2, (void)server3;
+    setenv("TZ", tz, 1);
+    tzset();
+}
+
+bool getLocalTime(struct tm *info, uint32_t ms)
+{
+    uint32_t start = millis();
+    time_t now;
+    for (;;)
+    {
+        time(&now);
+        localtime_r(&now, info);
+        if (info->tm_year > (2016 - 1900))
+            return true;
+        if (millis() - start >= ms)
+            return false;
+        delay(10);
+    }
+}
+
+#pragma endregion
+
+#pragma region PSRAM
+
+bool psramInit()
+{
+    return psramFound();
+}
+
+bool psramFound()
+{
+    return heap_caps_get_total_size(MALLOC_CAP_SPIRAM) > 0;
+}
+
+void *ps_malloc(size_t size)
+{
+    return heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+}
+
+void *ps_calloc(size_t n, size_t size)
+{
+    return heap_caps_calloc(n, size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+}
+
+void *ps_realloc(void *ptr, size_t size)
+{
+    return heap_caps_realloc(ptr, size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+}
+
+#pragma endregion
+
+#pragma region Serial
+
+HardwareSerial Serial(0);
+
+int HardwareSerial::available()
+{
+    if (m_peek >= 0)
+        return 1;
+    pollfd pfd = {STDIN_FILENO, POLLIN, 0};
+    return (poll(&pfd, 1, 0) > 0 && (pfd.revents & POLLIN)) ? 1 : 0;
+}
+
+int HardwareSerial::read()
+{
+    int c = peek();
+    m_peek = -1;
+    return c;
+}
+
+int HardwareSerial::peek()
+{
+    if (m_peek < 0 && available())
+    {
+        unsigned char c;
+        if (::read(STDIN_FILENO, &c, 1) == 1)
+            m_peek = c;
+    }
+    return m_peek;
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+    return fwrite(buffer, 1, size, stdout);
+}
+
+void HardwareSerial::flush()
+{
+    fflush(stdout);
+}
+
+#pragma endregion
+
+#pragma region ESP
+
+EspClass ESP;
+
+uint32_t EspClass::getHeapSize()
+{
+    return heap_caps_get_total_size(MALLOC_CAP_INTERNAL);
+}
+
+uint32_t EspClass::getFreeHeap()
+{
+    return heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+}
+
+uint32_t EspClass::getMinFreeHeap()
+{
+    return heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL);
+}
+
+uint32_t EspClass::getMaxAllocHeap()
+{
+    return heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL);
+}
+
+uint32_t EspClass::getPsramSize()
+{
+    return heap_caps_get_total_size(MALLOC_CAP_SPIRAM);
+}
+
+uint32_t EspClass::getFreePsram()
+{
+    return heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+}
+
+uint32_t EspClass::getMinFreePsram()
+{
+    return heap_caps_get_minimum_free_size(MALLOC_CAP_SPIRAM);
+}
+
+uint32_t EspClass::getMaxAllocPsram()
+{
+    return heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM);
+}
+
+const char *EspClass::getSdkVersion()
+{
+    return esp_get_idf_version();
+}
+
+uint32_t EspClass::getSketchSize()
+{
+    const esp_partition_t *running = esp_ota_get_running_partition();
+    return running ? running->size : 0;
+}
+
+uint32_t EspClass::getFreeSketchSpace()
+{
+    const esp_partition_t *next = esp_ota_get_next_update_partition(NULL);
+    return next ? next->size : 0;
+}
+
+uint64_t EspClass::getEfuseMac()
+{
+    uint8_t mac[6];
+    esp_efuse_mac_get_default(mac);
+    uint64_t value = 0;
+    for (int i = 5; i >= 0; i--)
+        value = (value << 8) | mac[i];
+    return value;
+}
+
+uint32_t EspClass::getCycleCount()
+{
+    return (uint32_t)(micros() * getCpuFreqMHz());
+}
+
+void EspClass::restart()
+{
+    esp_restart();
+}
+
+void EspClass::deepSleep(uint32_t time_us)
+{
+    esp_deep_sleep(time_us);
+}
+
+#pragma endregion
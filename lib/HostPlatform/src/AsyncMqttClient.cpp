@@ -0,0 +1,501 @@
+#include "AsyncMqttClient.h"
+
+#include <Arduino.h>
+
+#include "HostPlatform.h"
+#include "WiFiClient.h"
+
+#include <algorithm>
+
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+
+// the payload the ESP32 gets in one onMessage() call: one TCP segment
+static const size_t MQTT_DELIVERY_CHUNK = 1460;
+
+enum
+{
+    MQTT_CONNECT = 0x10,
+    MQTT_CONNACK = 0x20,
+    MQTT_PUBLISH = 0x30,
+    MQTT_PUBACK = 0x40,
+    MQTT_PUBREC = 0x50,
+    MQTT_PUBREL = 0x62,
+    MQTT_PUBCOMP = 0x70,
+    MQTT_SUBSCRIBE = 0x82,
+    MQTT_SUBACK = 0x90,
+    MQTT_UNSUBSCRIBE = 0xA2,
+    MQTT_UNSUBACK = 0xB0,
+    MQTT_PINGREQ = 0xC0,
+    MQTT_PINGRESP = 0xD0,
+    MQTT_DISCONNECT = 0xE0
+};
+
+static void putUint16(std::string &out, uint16_t value)
+{
+    out += (char)(value >> 8);
+    out += (char)(value & 0xff);
+}
+
+static void putString(std::string &out, const char *data, size_t len)
+{
+    putUint16(out, (uint16_t)len);
+    out.append(data, len);
+}
+
+static uint16_t getUint16(const std::string &in, size_t pos)
+{
+    return (pos + 2 <= in.size()) ? (uint16_t)(((uint8_t)in[pos] << 8) | (uint8_t)in[pos + 1]) : 0;
+}
+
+AsyncMqttClient::AsyncMqttClient()
+    : m_useIp(false), m_port(1883), m_hasCredentials(false), m_willQos(0), m_willRetain(false), m_keepAlive(15),
+      m_cleanSession(true), m_maxTopicLength(128), m_state(DISCONNECTED), m_fd(-1), m_lastSendMs(0), m_packetId(0),
+      m_reason(AsyncMqttClientDisconnectReason::TCP_DISCONNECTED)
+{
+    char id[24];
+    snprintf(id, sizeof(id), "esp32-%06llx", (unsigned long long)ESP.getEfuseMac());
+    m_clientId = id;
+}
+
+#pragma region Settings
+
+AsyncMqttClient &AsyncMqttClient::setKeepAlive(uint16_t keepAlive)
+{
+    m_keepAlive = keepAlive;
+    return *this;
+}
+
+AsyncMqttClient &AsyncMqttClient::setClientId(const char *clientId)
+{
+    m_clientId = clientId ? clientId : "";
+    return *this;
+}
+
+AsyncMqttClient &AsyncMqttClient::setCleanSession(bool cleanSession)
+{
+    m_cleanSession = cleanSession;
+    return *this;
+}
+
+AsyncMqttClient &AsyncMqttClient::setMaxTopicLength(uint16_t maxTopicLength)
+{
+    m_maxTopicLength = maxTopicLength;
+    return *this;
+}
+
+AsyncMqttClient &AsyncMqttClient::setCredentials(const char *username, const char *password)
+{
+    m_hasCredentials = (username != nullptr);
+    m_username = username ? username : "";
+    m_password = password ? password : "";
+    return *this;
+}
+
+AsyncMqttClient &AsyncMqttClient::setWill(const char *topic, uint8_t qos, bool retain, const char *payload,
+                                          size_t length)
+{
+    m_willTopic = topic ? topic : "";
+    m_willPayload.assign(payload ? payload : "", payload ? (length ? length : strlen(payload)) : 0);
+    m_willQos = qos;
+    m_willRetain = retain;
+    return *this;
+}
+
+AsyncMqttClient &AsyncMqttClient::setServer(IPAddress ip, uint16_t port)
+{
+    m_useIp = true;
+    m_ip = ip;
+    m_port = port;
+    return *this;
+}
+
+AsyncMqttClient &AsyncMqttClient::setServer(const char *host, uint16_t port)
+{
+    m_useIp = false;
+    m_host = host ? host : "";
+    m_port = port;
+    return *this;
+}
+
+AsyncMqttClient &AsyncMqttClient::onConnect(OnConnectUserCallback callback)
+{
+    m_onConnect = callback;
+    return *this;
+}
+
+AsyncMqttClient &AsyncMqttClient::onDisconnect(OnDisconnectUserCallback callback)
+{
+    m_onDisconnect = callback;
+    return *this;
+}
+
+AsyncMqttClient &AsyncMqttClient::onSubscribe(OnSubscribeUserCallback callback)
+{
+    m_onSubscribe = callback;
+    return *this;
+}
+
+AsyncMqttClient &AsyncMqttClient::onUnsubscribe(OnUnsubscribeUserCallback callback)
+{
+    m_onUnsubscribe = callback;
+    return *this;
+}
+
+AsyncMqttClient &AsyncMqttClient::onMessage(OnMessageUserCallback callback)
+{
+    m_onMessage = callback;
+    return *this;
+}
+
+AsyncMqttClient &AsyncMqttClient::onPublish(OnPublishUserCallback callback)
+{
+    m_onPublish = callback;
+    return *this;
+}
+
+#pragma endregion
+
+#pragma region Connection
+
+void AsyncMqttClient::connect()
+{
+    int expected = DISCONNECTED;
+    if (!m_state.compare_exchange_strong(expected, CONNECTING))
+        return;
+    hostTaskStart("async_tcp", 8192, configMAX_PRIORITIES - 2, [this]() { run(); });
+}
+
+void AsyncMqttClient::disconnect(bool force)
+{
+    if (!force)
+        sendPacket(MQTT_DISCONNECT, "");
+    int fd = m_fd;
+    if (fd >= 0)
+        shutdown(fd, SHUT_RDWR); // wakes the connection task, which reports the disconnect
+}
+
+void AsyncMqttClient::run()
+{
+    std::string host = m_useIp ? std::string(m_ip.toString().c_str()) : m_host;
+    uint16_t port = m_port;
+    hostEndpointOverride("HOST_MQTT", host, port);
+
+    WiFiClient client;
+    m_reason = AsyncMqttClientDisconnectReason::TCP_DISCONNECTED;
+    if (client.connect(host.c_str(), port))
+    {
+        client.setNoDelay(true);
+        m_fd = client.fd();
+
+        std::string body;
+        putString(body, "MQTT", 4);
+        body += (char)4; // protocol level 3.1.1
+        uint8_t flags = m_cleanSession ? 0x02 : 0;
+        if (!m_willTopic.empty())
+            flags |= 0x04 | (m_willQos << 3) | (m_willRetain ? 0x20 : 0);
+        if (m_hasCredentials)
+            flags |= 0x80 | (m_password.empty() ? 0 : 0x40);
+        body += (char)flags;
+        putUint16(body, m_keepAlive);
+        putString(body, m_clientId.data(), m_clientId.size());
+        if (!m_willTopic.empty())
+        {
+            putString(body, m_willTopic.data(), m_willTopic.size());
+            putString(body, m_willPayload.data(), m_willPayload.size());
+        }
+        if (m_hasCredentials)
+        {
+            putString(body, m_username.data(), m_username.size());
+            if (!m_password.empty())
+                putString(body, m_password.data(), m_password.size());
+        }
+
+        uint8_t header;
+        std::string packet;
+        if (sendPacket(MQTT_CONNECT, body) && readPacket(m_fd, header, packet) && header == MQTT_CONNACK &&
+            packet.size() == 2)
+        {
+            if (packet[1] == 0)
+            {
+                m_state = CONNECTED;
+                {
+                    std::lock_guard<std::recursive_mutex> lock(hostAsyncTcpMutex());
+                    if (m_onConnect)
+                        m_onConnect(packet[0] & 0x01);
+                }
+
+                bool pingSent = false;
+                uint32_t pingSentMs = 0;
+                while (m_state == CONNECTED)
+                {
+                    pollfd pfd = {m_fd, POLLIN, 0};
+                    int ready = poll(&pfd, 1, 100);
+                    if (ready < 0 && errno != EINTR)
+                        break;
+                    if (ready > 0)
+                    {
+                        if (!readPacket(m_fd, header, packet))
+                            break;
+                        if (header == MQTT_PINGRESP)
+                            pingSent = false;
+                        else
+                            handlePacket(header, packet);
+                    }
+
+                    uint32_t now = millis();
+                    if (m_keepAlive == 0)
+                        continue;
+                    if (pingSent && now - pingSentMs > m_keepAlive * 1000UL)
+                        break; // the broker is gone
+                    if (!pingSent && now - m_lastSendMs >= m_keepAlive * 1000UL)
+                    {
+                        pingSent = sendPacket(MQTT_PINGREQ, "");
+                        pingSentMs = now;
+                    }
+                }
+            }
+            else
+                m_reason = (AsyncMqttClientDisconnectReason)packet[1];
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_sendMutex);
+        m_fd = -1;
+        client.stop();
+    }
+    m_pendingPubrel.clear();
+    m_state = DISCONNECTED;
+
+    std::lock_guard<std::recursive_mutex> lock(hostAsyncTcpMutex());
+    if (m_onDisconnect)
+        m_onDisconnect(m_reason);
+}
+
+#pragma endregion
+
+#pragma region Packets
+
+static bool readFully(int fd, void *buf, size_t len)
+{
+    uint8_t *p = (uint8_t *)buf;
+    while (len > 0)
+    {
+        ssize_t n = recv(fd, p, len, 0);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+bool AsyncMqttClient::readPacket(int fd, uint8_t &header, std::string &body)
+{
+    if (!readFully(fd, &header, 1))
+        return false;
+
+    size_t remaining = 0;
+    for (int shift = 0; shift < 28; shift += 7)
+    {
+        uint8_t digit;
+        if (!readFully(fd, &digit, 1))
+            return false;
+        remaining |= (size_t)(digit & 0x7f) << shift;
+        if (!(digit & 0x80))
+        {
+            body.resize(remaining);
+            return remaining == 0 || readFully(fd, &body[0], remaining);
+        }
+    }
+    return false; // malformed length
+}
+
+bool AsyncMqttClient::sendPacket(uint8_t header, const std::string &body)
+{
+    std::string packet(1, (char)header);
+    size_t remaining = body.size();
+    do
+    {
+        uint8_t digit = remaining & 0x7f;
+        remaining >>= 7;
+        packet += (char)(digit | (remaining ? 0x80 : 0));
+    } while (remaining);
+    packet += body;
+
+    std::lock_guard<std::mutex> lock(m_sendMutex);
+    int fd = m_fd;
+    if (fd < 0)
+        return false;
+    const char *p = packet.data();
+    size_t left = packet.size();
+    while (left > 0)
+    {
+        ssize_t n = send(fd, p, left, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        p += n;
+        left -= n;
+    }
+    m_lastSendMs = millis();
+    return true;
+}
+
+bool AsyncMqttClient::sendAck(uint8_t header, uint16_t packetId)
+{
+    std::string body;
+    putUint16(body, packetId);
+    return sendPacket(header, body);
+}
+
+uint16_t AsyncMqttClient::nextPacketId()
+{
+    std::lock_guard<std::mutex> lock(m_sendMutex);
+    if (++m_packetId == 0)
+        m_packetId = 1;
+    return m_packetId;
+}
+
+void AsyncMqttClient::handlePacket(uint8_t header, std::string &body)
+{
+    uint16_t packetId = getUint16(body, 0);
+    switch (header & 0xf0)
+    {
+    case MQTT_PUBLISH:
+        deliver(header, body);
+        break;
+    case MQTT_PUBACK & 0xf0:
+    case MQTT_PUBCOMP & 0xf0:
+    {
+        std::lock_guard<std::recursive_mutex> lock(hostAsyncTcpMutex());
+        if (m_onPublish)
+            m_onPublish(packetId);
+        break;
+    }
+    case MQTT_PUBREC & 0xf0:
+        sendAck(MQTT_PUBREL, packetId);
+        break;
+    case MQTT_PUBREL & 0xf0:
+        m_pendingPubrel.erase(packetId);
+        sendAck(MQTT_PUBCOMP, packetId);
+        break;
+    case MQTT_SUBACK:
+    {
+        std::lock_guard<std::recursive_mutex> lock(hostAsyncTcpMutex());
+        if (m_onSubscribe)
+            m_onSubscribe(packetId, body.size() > 2 ? (uint8_t)body[2] : 0x80);
+        break;
+    }
+    case MQTT_UNSUBACK:
+    {
+        std::lock_guard<std::recursive_mutex> lock(hostAsyncTcpMutex());
+        if (m_onUnsubscribe)
+            m_onUnsubscribe(packetId);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void AsyncMqttClient::deliver(uint8_t header, std::string &body)
+{
+    AsyncMqttClientMessageProperties properties;
+    properties.qos = (header >> 1) & 0x03;
+    properties.dup = header & 0x08;
+    properties.retain = header & 0x01;
+
+    size_t topicLen = getUint16(body, 0);
+    size_t pos = 2 + topicLen;
+    uint16_t packetId = 0;
+    if (properties.qos > 0)
+    {
+        packetId = getUint16(body, pos);
+        pos += 2;
+    }
+    if (pos > body.size())
+        return;
+
+    // a QoS 2 message the broker sends again before PUBREL has been handed over already
+    bool duplicate = (properties.qos == 2) && !m_pendingPubrel.insert(packetId).second;
+    if (!duplicate && topicLen <= m_maxTopicLength)
+    {
+        std::string topic = body.substr(2, topicLen);
+        size_t total = body.size() - pos;
+        std::lock_guard<std::recursive_mutex> lock(hostAsyncTcpMutex());
+        size_t index = 0;
+        do
+        {
+            size_t len = std::min(MQTT_DELIVERY_CHUNK, total - index);
+            if (m_onMessage)
+                m_onMessage(&topic[0], &body[pos + index], properties, len, index, total);
+            index += len;
+        } while (index < total);
+    }
+
+    if (properties.qos == 1)
+        sendAck(MQTT_PUBACK, packetId);
+    else if (properties.qos == 2)
+        sendAck(MQTT_PUBREC, packetId);
+}
+
+#pragma endregion
+
+#pragma region Requests
+
+uint16_t AsyncMqttClient::subscribe(const char *topic, uint8_t qos)
+{
+    if (!connected())
+        return 0;
+    uint16_t packetId = nextPacketId();
+    std::string body;
+    putUint16(body, packetId);
+    putString(body, topic, strlen(topic));
+    body += (char)qos;
+    return sendPacket(MQTT_SUBSCRIBE, body) ? packetId : 0;
+}
+
+uint16_t AsyncMqttClient::unsubscribe(const char *topic)
+{
+    if (!connected())
+        return 0;
+    uint16_t packetId = nextPacketId();
+    std::string body;
+    putUint16(body, packetId);
+    putString(body, topic, strlen(topic));
+    return sendPacket(MQTT_UNSUBSCRIBE, body) ? packetId : 0;
+}
+
+uint16_t AsyncMqttClient::publish(const char *topic, uint8_t qos, bool retain, const char *payload, size_t length,
+                                  bool dup, uint16_t message_id)
+{
+    if (!connected() || qos > 2)
+        return 0;
+    if (payload && length == 0)
+        length = strlen(payload);
+
+    uint16_t packetId = 0;
+    std::string body;
+    body.reserve(strlen(topic) + length + 4);
+    putString(body, topic, strlen(topic));
+    if (qos > 0)
+    {
+        packetId = message_id ? message_id : nextPacketId();
+        putUint16(body, packetId);
+    }
+    if (length)
+        body.append(payload, length);
+
+    uint8_t header = MQTT_PUBLISH | (dup ? 0x08 : 0) | (qos << 1) | (retain ? 0x01 : 0);
+    if (!sendPacket(header, body))
+        return 0;
+    return (qos == 0) ? 1 : packetId;
+}
+
+#pragma endregion
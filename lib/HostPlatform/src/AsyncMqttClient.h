@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <string>
+
+#include "IPAddress.h"
+
+enum class AsyncMqttClientDisconnectReason : uint8_t
+{
+    TCP_DISCONNECTED = 0,
+
+    MQTT_UNACCEPTABLE_PROTOCOL_VERSION = 1,
+    MQTT_IDENTIFIER_REJECTED = 2,
+    MQTT_SERVER_UNAVAILABLE = 3,
+    MQTT_MALFORMED_CREDENTIALS = 4,
+    MQTT_NOT_AUTHORIZED = 5,
+
+    ESP8266_NOT_ENOUGH_SPACE = 6,
+
+    TLS_BAD_FINGERPRINT = 7
+};
+
+struct AsyncMqttClientMessageProperties
+{
+    uint8_t qos;
+    bool dup;
+    bool retain;
+};
+
+typedef std::function<void(bool sessionPresent)> OnConnectUserCallback;
+typedef std::function<void(AsyncMqttClientDisconnectReason reason)> OnDisconnectUserCallback;
+typedef std::function<void(uint16_t packetId, uint8_t qos)> OnSubscribeUserCallback;
+typedef std::function<void(uint16_t packetId)> OnUnsubscribeUserCallback;
+typedef std::function<void(char *topic, char *payload, AsyncMqttClientMessageProperties properties, size_t len,
+                           size_t index, size_t total)>
+    OnMessageUserCallback;
+typedef std::function<void(uint16_t packetId)> OnPublishUserCallback;
+
+// MQTT 3.1.1 over a plain socket. The connection runs on its own "async_tcp" task and every
+// callback holds hostAsyncTcpMutex(), so they never overlap with the web server's handlers.
+// Incoming payloads are handed over in pieces of at most one TCP segment, as the ESP32 sees
+// them. HOST_MQTT ("host:port") replaces the server the app sets.
+class AsyncMqttClient
+{
+public:
+    AsyncMqttClient();
+
+    AsyncMqttClient &setKeepAlive(uint16_t keepAlive);
+    AsyncMqttClient &setClientId(const char *clientId);
+    AsyncMqttClient &setCleanSession(bool cleanSession);
+    AsyncMqttClient &setMaxTopicLength(uint16_t maxTopicLength);
+    AsyncMqttClient &setCredentials(const char *username, const char *password = nullptr);
+    AsyncMqttClient &setWill(const char *topic, uint8_t qos, bool retain, const char *payload = nullptr,
+                             size_t length = 0);
+    AsyncMqttClient &setServer(IPAddress ip, uint16_t port);
+    AsyncMqttClient &setServer(const char *host, uint16_t port);
+
+    AsyncMqttClient &onConnect(OnConnectUserCallback callback);
+    AsyncMqttClient &onDisconnect(OnDisconnectUserCallback callback);
+    AsyncMqttClient &onSubscribe(OnSubscribeUserCallback callback);
+    AsyncMqttClient &onUnsubscribe(OnUnsubscribeUserCallback callback);
+    AsyncMqttClient &onMessage(OnMessageUserCallback callback);
+    AsyncMqttClient &onPublish(OnPublishUserCallback callback);
+
+    bool connected() const { return m_state == CONNECTED; }
+    void connect();
+    void disconnect(bool force = false);
+    uint16_t subscribe(const char *topic, uint8_t qos);
+    uint16_t unsubscribe(const char *topic);
+    // returns the packet id, 1 for QoS 0, 0 when nothing was sent
+    uint16_t publish(const char *topic, uint8_t qos, bool retain, const char *payload = nullptr, size_t length = 0,
+                     bool dup = false, uint16_t message_id = 0);
+
+    const char *getClientId() { return m_clientId.c_str(); }
+
+private:
+    enum State
+    {
+        DISCONNECTED,
+        CONNECTING,
+        CONNECTED
+    };
+
+    void run();
+    bool readPacket(int fd, uint8_t &header, std::string &body);
+    void handlePacket(uint8_t header, std::string &body);
+    void deliver(uint8_t header, std::string &body);
+    bool sendPacket(uint8_t header, const std::string &body);
+    bool sendAck(uint8_t header, uint16_t packetId);
+    uint16_t nextPacketId();
+
+    std::string m_host;
+    IPAddress m_ip;
+    bool m_useIp;
+    uint16_t m_port;
+    std::string m_clientId;
+    std::string m_username;
+    std::string m_password;
+    bool m_hasCredentials;
+    std::string m_willTopic;
+    std::string m_willPayload;
+    uint8_t m_willQos;
+    bool m_willRetain;
+    uint16_t m_keepAlive;
+    bool m_cleanSession;
+    uint16_t m_maxTopicLength;
+
+    OnConnectUserCallback m_onConnect;
+    OnDisconnectUserCallback m_onDisconnect;
+    OnSubscribeUserCallback m_onSubscribe;
+    OnUnsubscribeUserCallback m_onUnsubscribe;
+    OnMessageUserCallback m_onMessage;
+    OnPublishUserCallback m_onPublish;
+
+    std::atomic<int> m_state;
+    std::atomic<int> m_fd;
+    std::atomic<uint32_t> m_lastSendMs;
+    std::mutex m_sendMutex;
+    uint16_t m_packetId;
+    std::set<uint16_t> m_pendingPubrel; // QoS 2 messages already delivered, waiting for PUBREL
+    AsyncMqttClientDisconnectReason m_reason;
+};
@@ -0,0 +1,1488 @@
+#include "ESPAsyncWebServer.h"
+
+#include "HostPlatform.h"
+
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <strings.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static const int WEB_HEADER_TIMEOUT_MS = 10000; // to get the request line and headers
+static const int WEB_IO_TIMEOUT_MS = 5000;      // between two pieces of a body or a frame
+static const size_t WEB_MAX_HEADER = 8192;
+static const size_t WEB_MAX_BODY = 16 * 1024 * 1024;
+static const size_t WEB_SEGMENT = 1460; // what the ESP32 hands over at a time: one TCP segment
+static const size_t WS_MAX_FRAME = 1024 * 1024;
+
+#pragma region Helpers
+
+static void sha1(const uint8_t *data, size_t len, uint8_t out[20])
+{
+    uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+    std::string msg((const char *)data, len);
+    msg += (char)0x80;
+    while (msg.size() % 64 != 56)
+        msg += (char)0;
+    uint64_t bits = (uint64_t)len * 8;
+    for (int i = 7; i >= 0; i--)
+        msg += (char)(bits >> (i * 8));
+
+    for (size_t block = 0; block < msg.size(); block += 64)
+    {
+        uint32_t w[80];
+        for (int i = 0; i < 16; i++)
+            w[i] = ((uint32_t)(uint8_t)msg[block + i * 4] << 24) | ((uint32_t)(uint8_t)msg[block + i * 4 + 1] << 16) |
+                   ((uint32_t)(uint8_t)msg[block + i * 4 + 2] << 8) | (uint8_t)msg[block + i * 4 + 3];
+        for (int i = 16; i < 80; i++)
+        {
+            uint32_t x = w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16];
+            w[i] = (x << 1) | (x >> 31);
+        }
+
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (int i = 0; i < 80; i++)
+        {
+            uint32_t f, k;
+            if (i < 20)
+                f = (b & c) | (~b & d), k = 0x5A827999;
+            else if (i < 40)
+                f = b ^ c ^ d, k = 0x6ED9EBA1;
+            else if (i < 60)
+                f = (b & c) | (b & d) | (c & d), k = 0x8F1BBCDC;
+            else
+                f = b ^ c ^ d, k = 0xCA62C1D6;
+            uint32_t t = ((a << 5) | (a >> 27)) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = (b << 30) | (b >> 2);
+            b = a;
+            a = t;
+        }
+        h[0] += a;
+        h[1] += b;
+        h[2] += c;
+        h[3] += d;
+        h[4] += e;
+    }
+
+    for (int i = 0; i < 20; i++)
+        out[i] = (uint8_t)(h[i / 4] >> (24 - (i % 4) * 8));
+}
+
+static const char BASE64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static String base64Encode(const uint8_t *data, size_t len)
+{
+    String out;
+    for (size_t i = 0; i < len; i += 3)
+    {
+        uint32_t v = (uint32_t)data[i] << 16;
+        if (i + 1 < len)
+            v |= (uint32_t)data[i + 1] << 8;
+        if (i + 2 < len)
+            v |= data[i + 2];
+        out += BASE64[(v >> 18) & 0x3f];
+        out += BASE64[(v >> 12) & 0x3f];
+        out += (i + 1 < len) ? BASE64[(v >> 6) & 0x3f] : '=';
+        out += (i + 2 < len) ? BASE64[v & 0x3f] : '=';
+    }
+    return out;
+}
+
+static std::string base64Decode(const char *text)
+{
+    std::string out;
+    uint32_t v = 0;
+    int bits = 0;
+    for (; *text && *text != '='; text++)
+    {
+        const char *p = strchr(BASE64, *text);
+        if (p == NULL)
+            continue;
+        v = (v << 6) | (p - BASE64);
+        bits += 6;
+        if (bits >= 8)
+        {
+            bits -= 8;
+            out += (char)((v >> bits) & 0xff);
+        }
+    }
+    return out;
+}
+
+static int hexDigit(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+static String urlDecode(const char *text, size_t len)
+{
+    std::string out;
+    for (size_t i = 0; i < len; i++)
+    {
+        if (text[i] == '+')
+            out += ' ';
+        else if (text[i] == '%' && i + 2 < len && hexDigit(text[i + 1]) >= 0 && hexDigit(text[i + 2]) >= 0)
+        {
+            out += (char)(hexDigit(text[i + 1]) * 16 + hexDigit(text[i + 2]));
+            i += 2;
+        }
+        else
+            out += text[i];
+    }
+    return String(out.c_str(), out.size());
+}
+
+// the value of attr="..." or attr=... in a header such as Content-Disposition
+static String headerAttribute(const String &header, const char *attr)
+{
+    String key = String(attr) + "=";
+    int pos = 0;
+    while ((pos = header.indexOf(key, pos)) >= 0)
+    {
+        if (pos == 0 || header[pos - 1] == ' ' || header[pos - 1] == ';')
+            break;
+        pos += key.length();
+    }
+    if (pos < 0)
+        return String();
+    pos += key.length();
+    if (header[pos] == '"')
+    {
+        int end = header.indexOf('"', pos + 1);
+        return header.substring(pos + 1, (end < 0) ? header.length() : end);
+    }
+    int end = header.indexOf(';', pos);
+    String value = header.substring(pos, (end < 0) ? header.length() : end);
+    value.trim();
+    return value;
+}
+
+static const char *contentTypeFor(const String &path)
+{
+    static const struct
+    {
+        const char *ext;
+        const char *type;
+    } types[] = {{".html", "text/html"},
+                 {".htm", "text/html"},
+                 {".css", "text/css"},
+                 {".json", "application/json"},
+                 {".js", "application/javascript"},
+                 {".png", "image/png"},
+                 {".gif", "image/gif"},
+                 {".jpg", "image/jpeg"},
+                 {".ico", "image/x-icon"},
+                 {".svg", "image/svg+xml"},
+                 {".eot", "font/eot"},
+                 {".woff", "font/woff"},
+                 {".woff2", "font/woff2"},
+                 {".ttf", "font/ttf"},
+                 {".xml", "text/xml"},
+                 {".pdf", "application/pdf"},
+                 {".zip", "application/zip"},
+                 {".gz", "application/x-gzip"}};
+    for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); i++)
+    {
+        if (path.endsWith(types[i].ext))
+            return types[i].type;
+    }
+    return "text/plain";
+}
+
+#pragma endregion
+
+#pragma region Connection
+
+// the socket of one request, with what was read past the headers kept for the body
+class AsyncWebHostConnection
+{
+public:
+    explicit AsyncWebHostConnection(int fd) : m_fd(fd) {}
+
+    int fd() const { return m_fd; }
+
+    bool write(const void *data, size_t len)
+    {
+        const uint8_t *p = (const uint8_t *)data;
+        while (len > 0)
+        {
+            ssize_t n = send(m_fd, p, len, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                return false;
+            p += n;
+            len -= n;
+        }
+        return true;
+    }
+
+    bool write(const String &text) { return write(text.c_str(), text.length()); }
+
+    // what arrives within timeoutMs, up to len; 0 when the peer closed or nothing came
+    size_t read(void *buf, size_t len, int timeoutMs)
+    {
+        if (!m_pending.empty())
+        {
+            size_t n = std::min(len, m_pending.size());
+            memcpy(buf, m_pending.data(), n);
+            m_pending.erase(0, n);
+            return n;
+        }
+        pollfd pfd = {m_fd, POLLIN, 0};
+        if (poll(&pfd, 1, timeoutMs) != 1)
+            return 0;
+        ssize_t n = recv(m_fd, buf, len, 0);
+        return (n > 0) ? n : 0;
+    }
+
+    bool readFully(void *buf, size_t len)
+    {
+        uint8_t *p = (uint8_t *)buf;
+        while (len > 0)
+        {
+            size_t n = read(p, len, WEB_IO_TIMEOUT_MS);
+            if (n == 0)
+                return false;
+            p += n;
+            len -= n;
+        }
+        return true;
+    }
+
+    // the request line and headers, without the blank line
+    bool readHead(std::string &head)
+    {
+        char buf[1024];
+        for (;;)
+        {
+            size_t end = m_pending.find("\r\n\r\n");
+            if (end != std::string::npos)
+            {
+                head = m_pending.substr(0, end);
+                m_pending.erase(0, end + 4);
+                return true;
+            }
+            if (m_pending.size() > WEB_MAX_HEADER)
+                return false;
+            pollfd pfd = {m_fd, POLLIN, 0};
+            if (poll(&pfd, 1, WEB_HEADER_TIMEOUT_MS) != 1)
+                return false;
+            ssize_t n = recv(m_fd, buf, sizeof(buf), 0);
+            if (n <= 0)
+                return false;
+            m_pending.append(buf, n);
+        }
+    }
+
+private:
+    int m_fd;
+    std::string m_pending;
+};
+
+IPAddress AsyncClient::remoteIP() const
+{
+    sockaddr_in addr = {};
+    socklen_t len = sizeof(addr);
+    if (getpeername(m_fd, (sockaddr *)&addr, &len) != 0)
+        return IPAddress();
+    return IPAddress(addr.sin_addr.s_addr);
+}
+
+uint16_t AsyncClient::remotePort() const
+{
+    sockaddr_in addr = {};
+    socklen_t len = sizeof(addr);
+    if (getpeername(m_fd, (sockaddr *)&addr, &len) != 0)
+        return 0;
+    return ntohs(addr.sin_port);
+}
+
+IPAddress AsyncClient::localIP() const
+{
+    sockaddr_in addr = {};
+    socklen_t len = sizeof(addr);
+    if (getsockname(m_fd, (sockaddr *)&addr, &len) != 0)
+        return IPAddress();
+    return IPAddress(addr.sin_addr.s_addr);
+}
+
+uint16_t AsyncClient::localPort() const
+{
+    sockaddr_in addr = {};
+    socklen_t len = sizeof(addr);
+    if (getsockname(m_fd, (sockaddr *)&addr, &len) != 0)
+        return 0;
+    return ntohs(addr.sin_port);
+}
+
+#pragma endregion
+
+#pragma region Responses
+
+AsyncWebServerResponse::AsyncWebServerResponse() : _code(0), _contentLength(0)
+{
+}
+
+bool AsyncWebServerResponse::addHeader(const char *name, const char *value, bool replaceExisting)
+{
+    for (std::list<AsyncWebHeader>::iterator it = _headers.begin(); it != _headers.end(); ++it)
+    {
+        if (it->name().equalsIgnoreCase(name))
+        {
+            if (!replaceExisting)
+                return false;
+            _headers.erase(it);
+            break;
+        }
+    }
+    _headers.emplace_back(name, value);
+    return true;
+}
+
+bool AsyncWebServerResponse::removeHeader(const char *name)
+{
+    for (std::list<AsyncWebHeader>::iterator it = _headers.begin(); it != _headers.end(); ++it)
+    {
+        if (it->name().equalsIgnoreCase(name))
+        {
+            _headers.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+const AsyncWebHeader *AsyncWebServerResponse::getHeader(const char *name) const
+{
+    for (const AsyncWebHeader &header : _headers)
+    {
+        if (header.name().equalsIgnoreCase(name))
+            return &header;
+    }
+    return NULL;
+}
+
+const char *AsyncWebServerResponse::responseCodeToString(int code)
+{
+    switch (code)
+    {
+    case 100: return "Continue";
+    case 101: return "Switching Protocols";
+    case 200: return "OK";
+    case 201: return "Created";
+    case 202: return "Accepted";
+    case 204: return "No Content";
+    case 206: return "Partial Content";
+    case 301: return "Moved Permanently";
+    case 302: return "Found";
+    case 303: return "See Other";
+    case 304: return "Not Modified";
+    case 307: return "Temporary Redirect";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 403: return "Forbidden";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 408: return "Request Time-out";
+    case 411: return "Length Required";
+    case 413: return "Request Entity Too Large";
+    case 414: return "Request-URI Too Large";
+    case 431: return "Request Header Fields Too Large";
+    case 500: return "Internal Server Error";
+    case 501: return "Not Implemented";
+    case 503: return "Service Unavailable";
+    default: return "";
+    }
+}
+
+String AsyncWebServerResponse::headerBlock(bool chunked) const
+{
+    String head = "HTTP/1.1 " + String(_code) + " " + responseCodeToString(_code) + "\r\n";
+    if (!getHeader("Connection"))
+        head += "Connection: close\r\n";
+    if (_contentType.length())
+        head += "Content-Type: " + _contentType + "\r\n";
+    if (chunked)
+        head += "Transfer-Encoding: chunked\r\n";
+    else if (_code != 101 && _code != 304)
+        head += "Content-Length: " + String((unsigned long)_contentLength) + "\r\n";
+    for (const AsyncWebHeader &header : _headers)
+        head += header.toString();
+    head += "\r\n";
+    return head;
+}
+
+bool AsyncWebServerResponse::send(AsyncWebHostConnection &conn, bool head)
+{
+    if (!conn.write(headerBlock(false)))
+        return false;
+    if (head || _contentLength == 0 || body() == NULL)
+        return true;
+    return conn.write(body(), _contentLength);
+}
+
+AsyncBasicResponse::AsyncBasicResponse(int code, const char *contentType, const char *content, size_t len)
+{
+    _code = code;
+    _contentType = contentType;
+    _content.assign(content ? content : "", (len == (size_t)-1) ? strlen(content ? content : "") : len);
+    _contentLength = _content.size();
+    // the ESP32 version sends text/plain for a body that has no type
+    if (_contentLength && !_contentType.length())
+        _contentType = "text/plain";
+}
+
+AsyncProgmemResponse::AsyncProgmemResponse(int code, const char *contentType, const uint8_t *content, size_t len)
+    : _content(content)
+{
+    _code = code;
+    _contentType = contentType;
+    _contentLength = len;
+}
+
+AsyncChunkedResponse::AsyncChunkedResponse(const char *contentType, AwsResponseFiller callback) : _callback(callback)
+{
+    _code = 200;
+    _contentType = contentType;
+}
+
+// The filler runs under the async_tcp lock with a buffer the size of a send window, and the
+// response ends when it returns 0. HTTP/1.0 clients get the data unframed up to the close.
+bool AsyncChunkedResponse::send(AsyncWebHostConnection &conn, bool head)
+{
+    if (!conn.write(headerBlock(true)))
+        return false;
+    if (head)
+        return true;
+
+    static const size_t WINDOW = 5744;
+    std::vector<uint8_t> buffer(WINDOW);
+    size_t index = 0;
+    for (;;)
+    {
+        size_t len;
+        {
+            std::lock_guard<std::recursive_mutex> lock(hostAsyncTcpMutex());
+            len = _callback(buffer.data(), buffer.size(), index);
+        }
+        if (len == RESPONSE_TRY_AGAIN)
+        {
+            usleep(1000);
+            continue;
+        }
+        char size[16];
+        snprintf(size, sizeof(size), "%zx\r\n", len);
+        if (!conn.write(size, strlen(size)) || !conn.write(buffer.data(), len) || !conn.write("\r\n", 2))
+            return false;
+        if (len == 0)
+            return true;
+        index += len;
+    }
+}
+
+AsyncFileResponse::AsyncFileResponse(FS &fs, const String &path, const char *contentType, bool download)
+{
+    _code = 200;
+    String gzPath = path + ".gz";
+    if (!download && !fs.exists(path) && fs.exists(gzPath))
+    {
+        _content = fs.open(gzPath, "r");
+        addHeader("Content-Encoding", "gzip");
+    }
+    else
+        _content = fs.open(path, "r");
+    if (!_content || _content.isDirectory())
+    {
+        _content = File();
+        _code = 404;
+        return;
+    }
+    _contentLength = _content.size();
+    _contentType = (contentType && *contentType) ? contentType : contentTypeFor(path);
+
+    int slash = path.lastIndexOf('/');
+    String filename = path.substring(slash + 1);
+    addHeader("Content-Disposition", (download ? "attachment; filename=\"" : "inline; filename=\"") + filename + "\"");
+}
+
+bool AsyncFileResponse::send(AsyncWebHostConnection &conn, bool head)
+{
+    if (!conn.write(headerBlock(false)))
+        return false;
+    if (head || !_content)
+        return true;
+
+    uint8_t buffer[WEB_SEGMENT * 4];
+    size_t n;
+    while ((n = _content.read(buffer, sizeof(buffer))) > 0)
+    {
+        if (!conn.write(buffer, n))
+            return false;
+    }
+    _content.close();
+    return true;
+}
+
+AsyncResponseStream::AsyncResponseStream(const char *contentType, size_t bufferSize)
+{
+    _code = 200;
+    _contentType = contentType;
+    _content.reserve(bufferSize);
+}
+
+size_t AsyncResponseStream::write(const uint8_t *data, size_t len)
+{
+    _content.append((const char *)data, len);
+    return len;
+}
+
+bool AsyncResponseStream::send(AsyncWebHostConnection &conn, bool head)
+{
+    _contentLength = _content.size();
+    if (!conn.write(headerBlock(false)))
+        return false;
+    return head || conn.write(_content.data(), _content.size());
+}
+
+// the 101 that turns the connection into a WebSocket
+class AsyncWebSocketResponse : public AsyncWebServerResponse
+{
+public:
+    explicit AsyncWebSocketResponse(const String &key)
+    {
+        _code = 101;
+        String accept = key + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+        uint8_t digest[20];
+        sha1((const uint8_t *)accept.c_str(), accept.length(), digest);
+        addHeader("Connection", "Upgrade");
+        addHeader("Upgrade", "websocket");
+        addHeader("Sec-WebSocket-Accept", base64Encode(digest, sizeof(digest)));
+    }
+};
+
+#pragma endregion
+
+#pragma region Handlers
+
+bool AsyncCallbackWebHandler::canHandle(AsyncWebServerRequest *request) const
+{
+    if (!(_method & request->method()))
+        return false;
+    if (_uri.length() && _uri.startsWith("/*."))
+        return request->url().endsWith(_uri.substring(_uri.lastIndexOf('.')));
+    if (_uri.length() && _uri.endsWith("*"))
+        return request->url().startsWith(_uri.substring(0, _uri.length() - 1));
+    if (_uri.length() && _uri != request->url() && !request->url().startsWith(_uri + "/"))
+        return false;
+    return true;
+}
+
+void AsyncCallbackWebHandler::handleRequest(AsyncWebServerRequest *request)
+{
+    if (_onRequest)
+        _onRequest(request);
+    else
+        request->send(404, "text/plain", "Not found");
+}
+
+void AsyncCallbackWebHandler::handleUpload(AsyncWebServerRequest *request, const String &filename, size_t index,
+                                           uint8_t *data, size_t len, bool final)
+{
+    if (_onUpload)
+        _onUpload(request, filename, index, data, len, final);
+}
+
+void AsyncCallbackWebHandler::handleBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index,
+                                         size_t total)
+{
+    if (_onBody)
+        _onBody(request, data, len, index, total);
+}
+
+#pragma endregion
+
+#pragma region Request
+
+AsyncWebServerRequest::AsyncWebServerRequest(AsyncWebServer *server, int fd)
+    : _tempObject(NULL), _server(server), _client(fd), _method(HTTP_GET), _version(0), _contentLength(0),
+      _handler(NULL), _response(NULL)
+{
+}
+
+AsyncWebServerRequest::~AsyncWebServerRequest()
+{
+    delete _response;
+    free(_tempObject);
+    if (_tempFile)
+        _tempFile.close();
+}
+
+const char *AsyncWebServerRequest::methodToString() const
+{
+    switch (_method)
+    {
+    case HTTP_GET: return "GET";
+    case HTTP_POST: return "POST";
+    case HTTP_DELETE: return "DELETE";
+    case HTTP_PUT: return "PUT";
+    case HTTP_PATCH: return "PATCH";
+    case HTTP_HEAD: return "HEAD";
+    case HTTP_OPTIONS: return "OPTIONS";
+    default: return "UNKNOWN";
+    }
+}
+
+bool AsyncWebServerRequest::authenticate(const char *username, const char *password, const char *realm,
+                                         bool passwordIsHash) const
+{
+    (void)realm, (void)passwordIsHash;
+    const AsyncWebHeader *auth = getHeader("Authorization");
+    if (auth == NULL || !auth->value().startsWith("Basic "))
+        return false;
+    std::string expected = std::string(username) + ":" + password;
+    return base64Decode(auth->value().c_str() + 6) == expected;
+}
+
+void AsyncWebServerRequest::requestAuthentication(const char *realm, bool isDigest)
+{
+    (void)isDigest;
+    AsyncWebServerResponse *response = beginResponse(401);
+    response->addHeader("WWW-Authenticate",
+                        String("Basic realm=\"") + ((realm && *realm) ? realm : "Login Required") + "\"");
+    send(response);
+}
+
+const AsyncWebHeader *AsyncWebServerRequest::getHeader(const char *name) const
+{
+    for (const AsyncWebHeader &header : _headers)
+    {
+        if (header.name().equalsIgnoreCase(name))
+            return &header;
+    }
+    return NULL;
+}
+
+const AsyncWebHeader *AsyncWebServerRequest::getHeader(size_t num) const
+{
+    for (const AsyncWebHeader &header : _headers)
+    {
+        if (num-- == 0)
+            return &header;
+    }
+    return NULL;
+}
+
+const String &AsyncWebServerRequest::header(const char *name) const
+{
+    static const String empty;
+    const AsyncWebHeader *h = getHeader(name);
+    return h ? h->value() : empty;
+}
+
+const AsyncWebParameter *AsyncWebServerRequest::getParam(const char *name, bool post, bool file) const
+{
+    for (const AsyncWebParameter &param : _params)
+    {
+        if (param.name() == name && param.isPost() == post && param.isFile() == file)
+            return &param;
+    }
+    return NULL;
+}
+
+const AsyncWebParameter *AsyncWebServerRequest::getParam(size_t num) const
+{
+    for (const AsyncWebParameter &param : _params)
+    {
+        if (num-- == 0)
+            return &param;
+    }
+    return NULL;
+}
+
+bool AsyncWebServerRequest::hasArg(const char *name) const
+{
+    for (const AsyncWebParameter &param : _params)
+    {
+        if (param.name() == name && !param.isFile())
+            return true;
+    }
+    return false;
+}
+
+const String &AsyncWebServerRequest::arg(const char *name) const
+{
+    static const String empty;
+    for (const AsyncWebParameter &param : _params)
+    {
+        if (param.name() == name && !param.isFile())
+            return param.value();
+    }
+    return empty;
+}
+
+void AsyncWebServerRequest::addParams(const char *data, size_t len, bool post)
+{
+    const char *end = data + len;
+    while (data < end)
+    {
+        const char *amp = (const char *)memchr(data, '&', end - data);
+        if (amp == NULL)
+            amp = end;
+        const char *eq = (const char *)memchr(data, '=', amp - data);
+        if (amp > data)
+        {
+            if (eq)
+                _params.emplace_back(urlDecode(data, eq - data), urlDecode(eq + 1, amp - eq - 1), post);
+            else
+                _params.emplace_back(urlDecode(data, amp - data), String(), post);
+        }
+        data = amp + 1;
+    }
+}
+
+// the last response handed to send() is the one that goes out
+void AsyncWebServerRequest::send(AsyncWebServerResponse *response)
+{
+    if (response == _response)
+        return;
+    delete _response;
+    _response = response;
+}
+
+void AsyncWebServerRequest::redirect(const char *url, int code)
+{
+    AsyncWebServerResponse *response = beginResponse(code);
+    response->addHeader("Location", url);
+    send(response);
+}
+
+AsyncWebServerResponse *AsyncWebServerRequest::beginResponse(int code, const char *contentType, const char *content,
+                                                             AwsTemplateProcessor callback)
+{
+    (void)callback;
+    return new AsyncBasicResponse(code, contentType, content);
+}
+
+AsyncWebServerResponse *AsyncWebServerRequest::beginResponse(int code, const String &contentType,
+                                                             const String &content, AwsTemplateProcessor callback)
+{
+    (void)callback;
+    return new AsyncBasicResponse(code, contentType.c_str(), content.c_str(), content.length());
+}
+
+AsyncWebServerResponse *AsyncWebServerRequest::beginResponse(int code, const char *contentType,
+                                                             const uint8_t *content, size_t len,
+                                                             AwsTemplateProcessor callback)
+{
+    (void)callback;
+    return new AsyncProgmemResponse(code, contentType, content, len);
+}
+
+AsyncWebServerResponse *AsyncWebServerRequest::beginResponse(FS &fs, const String &path, const char *contentType,
+                                                             bool download, AwsTemplateProcessor callback)
+{
+    (void)callback;
+    return new AsyncFileResponse(fs, path, contentType, download);
+}
+
+AsyncWebServerResponse *AsyncWebServerRequest::beginChunkedResponse(const char *contentType,
+                                                                    AwsResponseFiller callback,
+                                                                    AwsTemplateProcessor templateCallback)
+{
+    (void)templateCallback;
+    return new AsyncChunkedResponse(contentType, callback);
+}
+
+AsyncResponseStream *AsyncWebServerRequest::beginResponseStream(const char *contentType, size_t bufferSize)
+{
+    return new AsyncResponseStream(contentType, bufferSize);
+}
+
+#pragma endregion
+
+#pragma region WebSocket
+
+AsyncWebSocketClient::AsyncWebSocketClient(AsyncWebSocket *server, uint32_t id, int fd)
+    : _server(server), _id(id), _fd(fd), _wakeFd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)), _client(fd),
+      _status(WS_CONNECTED), _closeWhenFull(true), _frameNum(0), _messageOpcode(WS_TEXT)
+{
+}
+
+AsyncWebSocketClient::~AsyncWebSocketClient()
+{
+    if (_wakeFd >= 0)
+        ::close(_wakeFd);
+}
+
+size_t AsyncWebSocketClient::queueLen() const
+{
+    std::lock_guard<std::mutex> lock(_queueMutex);
+    return _queue.size();
+}
+
+// as on the ESP32 a client that lets WS_MAX_QUEUED_MESSAGES pile up is closed, or with
+// setCloseClientOnQueueFull(false) keeps its connection and loses the message
+bool AsyncWebSocketClient::queue(uint8_t opcode, AsyncWebSocketSharedBuffer data)
+{
+    if (_status != WS_CONNECTED)
+        return false;
+    {
+        std::lock_guard<std::mutex> lock(_queueMutex);
+        if (_queue.size() < WS_MAX_QUEUED_MESSAGES)
+            _queue.push_back({opcode, data});
+        else if (_closeWhenFull)
+            _status = WS_DISCONNECTING;
+        else
+            return false;
+    }
+    uint64_t one = 1;
+    ssize_t n = ::write(_wakeFd, &one, sizeof(one));
+    (void)n;
+    return _status == WS_CONNECTED;
+}
+
+bool AsyncWebSocketClient::text(const char *message, size_t len)
+{
+    return queue(WS_TEXT, std::make_shared<std::vector<uint8_t>>((const uint8_t *)message,
+                                                                 (const uint8_t *)message + len));
+}
+
+bool AsyncWebSocketClient::binary(AsyncWebSocketSharedBuffer buffer)
+{
+    return queue(WS_BINARY, buffer);
+}
+
+bool AsyncWebSocketClient::binary(const uint8_t *message, size_t len)
+{
+    return queue(WS_BINARY, std::make_shared<std::vector<uint8_t>>(message, message + len));
+}
+
+bool AsyncWebSocketClient::ping(const uint8_t *data, size_t len)
+{
+    return queue(WS_PING, std::make_shared<std::vector<uint8_t>>(data, data + len));
+}
+
+void AsyncWebSocketClient::close(uint16_t code, const char *message)
+{
+    if (_status != WS_CONNECTED)
+        return;
+    AsyncWebSocketSharedBuffer payload = std::make_shared<std::vector<uint8_t>>();
+    if (code)
+    {
+        payload->push_back(code >> 8);
+        payload->push_back(code & 0xff);
+        if (message)
+            payload->insert(payload->end(), message, message + strlen(message));
+    }
+    queue(WS_DISCONNECT, payload);
+    _status = WS_DISCONNECTING;
+}
+
+bool AsyncWebSocketClient::writeFrame(uint8_t opcode, const uint8_t *data, size_t len)
+{
+    uint8_t head[10];
+    size_t headLen = 2;
+    head[0] = 0x80 | opcode;
+    if (len < 126)
+        head[1] = len;
+    else if (len < 65536)
+    {
+        head[1] = 126;
+        head[2] = len >> 8;
+        head[3] = len & 0xff;
+        headLen = 4;
+    }
+    else
+    {
+        head[1] = 127;
+        for (int i = 0; i < 8; i++)
+            head[2 + i] = (uint8_t)((uint64_t)len >> (56 - i * 8));
+        headLen = 10;
+    }
+
+    AsyncWebHostConnection conn(_fd);
+    return conn.write(head, headLen) && (len == 0 || conn.write(data, len));
+}
+
+// one frame from the browser, which always masks them
+bool AsyncWebSocketClient::readFrame()
+{
+    AsyncWebHostConnection conn(_fd);
+    uint8_t head[2];
+    if (!conn.readFully(head, 2))
+        return false;
+
+    AwsFrameInfo info = {};
+    info.final = (head[0] & 0x80) != 0;
+    info.opcode = head[0] & 0x0f;
+    info.masked = (head[1] & 0x80) != 0;
+    info.len = head[1] & 0x7f;
+    if (info.len == 126 || info.len == 127)
+    {
+        uint8_t ext[8];
+        size_t extLen = (info.len == 126) ? 2 : 8;
+        if (!conn.readFully(ext, extLen))
+            return false;
+        info.len = 0;
+        for (size_t i = 0; i < extLen; i++)
+            info.len = (info.len << 8) | ext[i];
+    }
+    if (info.len > WS_MAX_FRAME)
+    {
+        writeFrame(WS_DISCONNECT, (const uint8_t *)"\x03\xf1", 2); // 1009, message too big
+        return false;
+    }
+    if (info.masked && !conn.readFully(info.mask, 4))
+        return false;
+
+    std::vector<uint8_t> payload(info.len + 1);
+    if (info.len && !conn.readFully(payload.data(), info.len))
+        return false;
+    if (info.masked)
+    {
+        for (size_t i = 0; i < info.len; i++)
+            payload[i] ^= info.mask[i % 4];
+    }
+    payload[info.len] = 0; // text frames can be used as C strings, as on the ESP32
+
+    switch (info.opcode)
+    {
+    case WS_DISCONNECT:
+        if (_status == WS_CONNECTED)
+            writeFrame(WS_DISCONNECT, payload.data(), std::min<size_t>(info.len, 2));
+        return false;
+    case WS_PING:
+        writeFrame(WS_PONG, payload.data(), info.len);
+        _server->event(this, WS_EVT_PING, NULL, payload.data(), info.len);
+        return true;
+    case WS_PONG:
+        _server->event(this, WS_EVT_PONG, NULL, payload.data(), info.len);
+        return true;
+    default:
+        if (info.opcode != WS_CONTINUATION)
+        {
+            _messageOpcode = info.opcode;
+            _frameNum = 0;
+        }
+        info.message_opcode = _messageOpcode;
+        info.num = _frameNum++;
+        info.index = 0;
+        _server->event(this, WS_EVT_DATA, &info, payload.data(), info.len);
+        return true;
+    }
+}
+
+void AsyncWebSocketClient::run()
+{
+    _server->event(this, WS_EVT_CONNECT, NULL, NULL, 0);
+
+    pollfd fds[2] = {{_fd, POLLIN, 0}, {_wakeFd, POLLIN, 0}};
+    bool open = true;
+    while (open)
+    {
+        if (poll(fds, 2, 1000) < 0 && errno != EINTR)
+            break;
+
+        if (fds[1].revents & POLLIN)
+        {
+            uint64_t count;
+            ssize_t n = ::read(_wakeFd, &count, sizeof(count));
+            (void)n;
+        }
+        for (;;)
+        {
+            Message message;
+            {
+                std::lock_guard<std::mutex> lock(_queueMutex);
+                if (_queue.empty())
+                    break;
+                message = _queue.front();
+            }
+            // the message stays queued while it is sent, queueLen() counts it
+            bool sent = writeFrame(message.opcode, message.data->data(), message.data->size());
+            {
+                std::lock_guard<std::mutex> lock(_queueMutex);
+                _queue.pop_front();
+            }
+            if (!sent || message.opcode == WS_DISCONNECT)
+            {
+                open = false;
+                break;
+            }
+        }
+        if (open && _status == WS_DISCONNECTING && queueLen() == 0)
+        {
+            // closed because the queue overflowed, a close() would have queued its own frame
+            writeFrame(WS_DISCONNECT, (const uint8_t *)"\x03\xf0", 2); // 1008, policy violation
+            break;
+        }
+
+        if (open && (fds[0].revents & (POLLIN | POLLHUP | POLLERR)))
+            open = readFrame();
+    }
+
+    _status = WS_DISCONNECTED;
+    {
+        std::lock_guard<std::mutex> lock(_queueMutex);
+        _queue.clear();
+    }
+    _server->event(this, WS_EVT_DISCONNECT, NULL, NULL, 0);
+}
+
+AsyncWebSocket::AsyncWebSocket(const String &url) : _url(url), _enabled(true), _nextId(1)
+{
+}
+
+AsyncWebSocket::~AsyncWebSocket()
+{
+}
+
+void AsyncWebSocket::event(AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len)
+{
+    std::lock_guard<std::recursive_mutex> lock(hostAsyncTcpMutex());
+    if (_eventHandler)
+        _eventHandler(this, client, type, arg, data, len);
+}
+
+size_t AsyncWebSocket::count()
+{
+    std::lock_guard<std::recursive_mutex> lock(_lock);
+    size_t n = 0;
+    for (const AsyncWebSocketClient &c : _clients)
+    {
+        if (c.status() == WS_CONNECTED)
+            n++;
+    }
+    return n;
+}
+
+AsyncWebSocketClient *AsyncWebSocket::client(uint32_t id)
+{
+    std::lock_guard<std::recursive_mutex> lock(_lock);
+    for (AsyncWebSocketClient &c : _clients)
+    {
+        if (c.id() == id && c.status() == WS_CONNECTED)
+            return &c;
+    }
+    return NULL;
+}
+
+void AsyncWebSocket::cleanupClients(uint16_t maxClients)
+{
+    std::lock_guard<std::recursive_mutex> lock(_lock);
+
+    // the oldest go first
+    size_t connected = count();
+    for (AsyncWebSocketClient &c : _clients)
+    {
+        if (connected <= maxClients)
+            break;
+        if (c.status() == WS_CONNECTED)
+        {
+            c.close();
+            connected--;
+        }
+    }
+}
+
+AsyncWebSocket::AsyncWebSocketClientList &AsyncWebSocket::getClients()
+{
+    return _clients;
+}
+
+void AsyncWebSocket::closeAll(uint16_t code, const char *message)
+{
+    std::lock_guard<std::recursive_mutex> lock(_lock);
+    for (AsyncWebSocketClient &c : _clients)
+        c.close(code, message);
+}
+
+AsyncWebSocket::SendStatus AsyncWebSocket::sendAll(uint8_t opcode, AsyncWebSocketSharedBuffer buffer)
+{
+    std::lock_guard<std::recursive_mutex> lock(_lock);
+    size_t tried = 0;
+    size_t queued = 0;
+    for (AsyncWebSocketClient &c : _clients)
+    {
+        if (c.status() != WS_CONNECTED)
+            continue;
+        tried++;
+        if (c.queue(opcode, buffer))
+            queued++;
+    }
+    if (queued == tried)
+        return ENQUEUED;
+    return queued ? PARTIALLY_ENQUEUED : DISCARDED;
+}
+
+AsyncWebSocket::SendStatus AsyncWebSocket::textAll(const char *message)
+{
+    return sendAll(WS_TEXT, std::make_shared<std::vector<uint8_t>>((const uint8_t *)message,
+                                                                   (const uint8_t *)message + strlen(message)));
+}
+
+AsyncWebSocket::SendStatus AsyncWebSocket::binaryAll(AsyncWebSocketSharedBuffer buffer)
+{
+    return sendAll(WS_BINARY, buffer);
+}
+
+bool AsyncWebSocket::canHandle(AsyncWebServerRequest *request) const
+{
+    if (!_enabled || request->method() != HTTP_GET || request->url() != _url)
+        return false;
+    const AsyncWebHeader *upgrade = request->getHeader("Upgrade");
+    return upgrade && upgrade->value().equalsIgnoreCase("websocket");
+}
+
+void AsyncWebSocket::handleRequest(AsyncWebServerRequest *request)
+{
+    const AsyncWebHeader *version = request->getHeader("Sec-WebSocket-Version");
+    const AsyncWebHeader *key = request->getHeader("Sec-WebSocket-Key");
+    if (version == NULL || version->value().toInt() != 13 || key == NULL)
+    {
+        AsyncWebServerResponse *response = request->beginResponse(400);
+        response->addHeader("Sec-WebSocket-Version", "13");
+        request->send(response);
+        return;
+    }
+    if (_handshakeHandler && !_handshakeHandler(request))
+    {
+        request->send(401);
+        return;
+    }
+    request->send(new AsyncWebSocketResponse(key->value()));
+}
+
+bool AsyncWebSocket::handleConnection(AsyncWebServerRequest *request, AsyncWebHostConnection &conn)
+{
+    if (request->_response == NULL || request->_response->code() != 101)
+        return false;
+    if (!request->_response->send(conn, false))
+        return true;
+
+    AsyncWebSocketClientList::iterator client;
+    {
+        std::lock_guard<std::recursive_mutex> lock(_lock);
+        client = _clients.emplace(_clients.end(), this, _nextId++, conn.fd());
+    }
+    client->run();
+
+    // gone from the list as soon as its connection ends, as on the ESP32
+    std::lock_guard<std::recursive_mutex> lock(_lock);
+    _clients.erase(client);
+    return true;
+}
+
+#pragma endregion
+
+#pragma region Server
+
+AsyncWebServer::AsyncWebServer(uint16_t port) : _port(port), _listenFd(-1)
+{
+}
+
+AsyncWebServer::~AsyncWebServer()
+{
+    end();
+    for (AsyncCallbackWebHandler *handler : _ownedHandlers)
+        delete handler;
+}
+
+AsyncCallbackWebHandler &AsyncWebServer::on(const char *uri, WebRequestMethodComposite method,
+                                            ArRequestHandlerFunction onRequest, ArUploadHandlerFunction onUpload,
+                                            ArBodyHandlerFunction onBody)
+{
+    AsyncCallbackWebHandler *handler = new AsyncCallbackWebHandler();
+    handler->setUri(uri);
+    handler->setMethod(method);
+    handler->onRequest(onRequest);
+    handler->onUpload(onUpload);
+    handler->onBody(onBody);
+    _ownedHandlers.push_back(handler);
+    addHandler(handler);
+    return *handler;
+}
+
+AsyncWebHandler &AsyncWebServer::addHandler(AsyncWebHandler *handler)
+{
+    std::lock_guard<std::recursive_mutex> lock(hostAsyncTcpMutex());
+    _handlers.push_back(handler);
+    return *handler;
+}
+
+bool AsyncWebServer::removeHandler(AsyncWebHandler *handler)
+{
+    std::lock_guard<std::recursive_mutex> lock(hostAsyncTcpMutex());
+    for (std::vector<AsyncWebHandler *>::iterator it = _handlers.begin(); it != _handlers.end(); ++it)
+    {
+        if (*it == handler)
+        {
+            _handlers.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+void AsyncWebServer::reset()
+{
+    std::lock_guard<std::recursive_mutex> lock(hostAsyncTcpMutex());
+    _handlers.clear();
+    _middleware.clear();
+    _catchAllHandler.onRequest(nullptr);
+    _catchAllHandler.onUpload(nullptr);
+    _catchAllHandler.onBody(nullptr);
+}
+
+void AsyncWebServer::begin()
+{
+    if (_listenFd >= 0)
+        return;
+
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return;
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(hostListenPort(_port));
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(fd, (sockaddr *)&addr, sizeof(addr)) != 0 || ::listen(fd, 8) != 0)
+    {
+        fprintf(stderr, "cannot listen on port %u: %s\n", hostListenPort(_port), strerror(errno));
+        ::close(fd);
+        return;
+    }
+    _listenFd = fd;
+    hostTaskStart("async_tcp", 4096, configMAX_PRIORITIES - 2, [this]() { listen(); });
+}
+
+void AsyncWebServer::end()
+{
+    int fd = _listenFd.exchange(-1);
+    if (fd >= 0)
+    {
+        shutdown(fd, SHUT_RDWR); // wakes the accepting task
+        ::close(fd);
+    }
+}
+
+void AsyncWebServer::listen()
+{
+    int listenFd;
+    while ((listenFd = _listenFd) >= 0)
+    {
+        pollfd pfd = {listenFd, POLLIN, 0};
+        if (poll(&pfd, 1, 200) != 1)
+            continue;
+        int fd = accept4(listenFd, NULL, NULL, SOCK_CLOEXEC);
+        if (fd < 0)
+            continue;
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        hostTaskStart("async_tcp", 16384, configMAX_PRIORITIES - 2, [this, fd]() {
+            handleConnection(fd);
+            ::close(fd);
+        });
+    }
+}
+
+AsyncWebHandler *AsyncWebServer::findHandler(AsyncWebServerRequest *request)
+{
+    std::lock_guard<std::recursive_mutex> lock(hostAsyncTcpMutex());
+    for (AsyncWebHandler *handler : _handlers)
+    {
+        if (handler->canHandle(request))
+            return handler;
+    }
+    return &_catchAllHandler;
+}
+
+// middleware first, each one deciding whether the rest runs, then the handler
+void AsyncWebServer::runHandler(AsyncWebServerRequest *request)
+{
+    std::function<void(size_t)> step = [&](size_t i) {
+        if (i < _middleware.size())
+            _middleware[i](request, [&step, i]() { step(i + 1); });
+        else
+            request->_handler->handleRequest(request);
+    };
+
+    std::lock_guard<std::recursive_mutex> lock(hostAsyncTcpMutex());
+    step(0);
+    if (request->_response == NULL)
+        request->send(501, "text/plain", "Handler did not handle the request");
+}
+
+static bool parseRequestLine(const std::string &line, WebRequestMethodComposite &method, std::string &target,
+                             uint8_t &version)
+{
+    size_t sp1 = line.find(' ');
+    size_t sp2 = line.rfind(' ');
+    if (sp1 == std::string::npos || sp2 == sp1)
+        return false;
+    std::string name = line.substr(0, sp1);
+    target = line.substr(sp1 + 1, sp2 - sp1 - 1);
+    version = (line.compare(sp2 + 1, std::string::npos, "HTTP/1.0") == 0) ? 0 : 1;
+
+    static const struct
+    {
+        const char *name;
+        WebRequestMethod method;
+    } methods[] = {{"GET", HTTP_GET},   {"POST", HTTP_POST}, {"DELETE", HTTP_DELETE},  {"PUT", HTTP_PUT},
+                   {"PATCH", HTTP_PATCH}, {"HEAD", HTTP_HEAD}, {"OPTIONS", HTTP_OPTIONS}};
+    for (size_t i = 0; i < sizeof(methods) / sizeof(methods[0]); i++)
+    {
+        if (name == methods[i].name)
+        {
+            method = methods[i].method;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Splits a multipart/form-data body: fields become post parameters, files go to the handler's
+// upload callback in segment sized pieces
+static void handleMultipart(AsyncWebServerRequest *request, AsyncWebHandler *handler, const std::string &body,
+                            const String &boundary, std::list<AsyncWebParameter> &params)
+{
+    std::string delimiter = std::string("--") + boundary.c_str();
+    size_t pos = body.find(delimiter);
+    while (pos != std::string::npos)
+    {
+        pos += delimiter.size();
+        if (body.compare(pos, 2, "--") == 0)
+            break;
+        size_t headEnd = body.find("\r\n\r\n", pos);
+        if (headEnd == std::string::npos)
+            break;
+        size_t next = body.find("\r\n" + delimiter, headEnd + 4);
+        if (next == std::string::npos)
+            break;
+
+        String disposition;
+        String partHead(body.data() + pos, headEnd - pos);
+        int at = 0;
+        while (at >= 0 && at < (int)partHead.length())
+        {
+            int eol = partHead.indexOf("\r\n", at);
+            String line = partHead.substring(at, (eol < 0) ? partHead.length() : eol);
+            if (line.startsWith("Content-Disposition:") || line.startsWith("content-disposition:"))
+                disposition = line.substring(20);
+            at = (eol < 0) ? -1 : eol + 2;
+        }
+
+        String name = headerAttribute(disposition, "name");
+        String filename = headerAttribute(disposition, "filename");
+        const char *data = body.data() + headEnd + 4;
+        size_t len = next - (headEnd + 4);
+        if (disposition.indexOf("filename=") >= 0)
+        {
+            params.emplace_back(name, filename, true, true, len);
+            std::lock_guard<std::recursive_mutex> lock(hostAsyncTcpMutex());
+            size_t index = 0;
+            do
+            {
+                size_t n = std::min(WEB_SEGMENT, len - index);
+                handler->handleUpload(request, filename, index, (uint8_t *)data + index, n, index + n == len);
+                index += n;
+            } while (index < len);
+        }
+        else
+            params.emplace_back(name, String(data, len), true);
+
+        pos = next + 2;
+    }
+}
+
+void AsyncWebServer::handleConnection(int fd)
+{
+    AsyncWebHostConnection conn(fd);
+    std::string head;
+    if (!conn.readHead(head))
+        return;
+
+    AsyncWebServerRequest request(this, fd);
+    std::string target;
+    size_t eol = head.find("\r\n");
+    if (!parseRequestLine(head.substr(0, eol), request._method, target, request._version))
+    {
+        AsyncBasicResponse(400).send(conn, false);
+        return;
+    }
+
+    size_t query = target.find('?');
+    request._url = urlDecode(target.data(), std::min(query, target.size()));
+    if (query != std::string::npos)
+        request.addParams(target.data() + query + 1, target.size() - query - 1, false);
+
+    while (eol != std::string::npos)
+    {
+        size_t start = eol + 2;
+        eol = head.find("\r\n", start);
+        std::string line = head.substr(start, (eol == std::string::npos) ? std::string::npos : eol - start);
+        size_t colon = line.find(':');
+        if (colon == std::string::npos)
+            continue;
+        size_t valueStart = line.find_first_not_of(' ', colon + 1);
+        String name(line.c_str(), colon);
+        String value = (valueStart == std::string::npos) ? String() : String(line.c_str() + valueStart);
+        request._headers.emplace_back(name, value);
+        if (name.equalsIgnoreCase("Host"))
+            request._host = value;
+        else if (name.equalsIgnoreCase("Content-Type"))
+            request._contentType = value;
+        else if (name.equalsIgnoreCase("Content-Length"))
+            request._contentLength = strtoul(value.c_str(), NULL, 10);
+    }
+
+    request._handler = findHandler(&request);
+
+    if (request._contentLength > WEB_MAX_BODY)
+    {
+        AsyncBasicResponse(413).send(conn, false);
+        return;
+    }
+    if (request._contentLength > 0)
+    {
+        std::string body(request._contentLength, '\0');
+        if (!conn.readFully(&body[0], body.size()))
+            return;
+
+        if (request.multipart())
+            handleMultipart(&request, request._handler, body, headerAttribute(request._contentType, "boundary"),
+                            request._params);
+        else if (request._contentType.startsWith("application/x-www-form-urlencoded"))
+            request.addParams(body.data(), body.size(), true);
+        else
+        {
+            std::lock_guard<std::recursive_mutex> lock(hostAsyncTcpMutex());
+            for (size_t index = 0; index < body.size(); index += WEB_SEGMENT)
+                request._handler->handleBody(&request, (uint8_t *)&body[index],
+                                             std::min(WEB_SEGMENT, body.size() - index), index, body.size());
+        }
+    }
+
+    runHandler(&request);
+    if (request._handler->handleConnection(&request, conn))
+        return;
+    request._response->send(conn, request._method == HTTP_HEAD);
+}
+
+#pragma endregion
@@ -0,0 +1,594 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "FS.h"
+#include "IPAddress.h"
+#include "Print.h"
+#include "WString.h"
+
+// The part of the ESP32Async web server API the app uses, over blocking sockets: one task per
+// connection, one request per connection (Connection: close). Handlers, middleware, upload and
+// WebSocket callbacks and chunk fillers all hold hostAsyncTcpMutex() while they run, as they
+// would all run on the async_tcp task; the sockets are written outside it. Authentication is
+// Basic only, requestAuthentication() asks for Basic whatever isDigest says.
+
+class AsyncWebServer;
+class AsyncWebServerRequest;
+class AsyncWebServerResponse;
+class AsyncWebSocket;
+class AsyncWebSocketClient;
+class AsyncWebHostConnection;
+
+typedef enum
+{
+    HTTP_GET = 0b00000001,
+    HTTP_POST = 0b00000010,
+    HTTP_DELETE = 0b00000100,
+    HTTP_PUT = 0b00001000,
+    HTTP_PATCH = 0b00010000,
+    HTTP_HEAD = 0b00100000,
+    HTTP_OPTIONS = 0b01000000,
+    HTTP_ANY = 0b01111111,
+} WebRequestMethod;
+
+typedef uint8_t WebRequestMethodComposite;
+
+// a filler returning this has nothing yet and is asked again
+#define RESPONSE_TRY_AGAIN 0xFFFFFFFF
+
+typedef std::function<size_t(uint8_t *buffer, size_t maxLen, size_t index)> AwsResponseFiller;
+typedef std::function<String(const String &)> AwsTemplateProcessor;
+
+typedef std::function<void(AsyncWebServerRequest *request)> ArRequestHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest *request, const String &filename, size_t index, uint8_t *data,
+                           size_t len, bool final)>
+    ArUploadHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total)>
+    ArBodyHandlerFunction;
+typedef std::function<void(void)> ArMiddlewareNext;
+typedef std::function<void(AsyncWebServerRequest *request, ArMiddlewareNext next)> ArMiddlewareCallback;
+
+class AsyncWebParameter
+{
+public:
+    AsyncWebParameter(const String &name, const String &value, bool form = false, bool file = false, size_t size = 0)
+        : _name(name), _value(value), _size(size), _isForm(form), _isFile(file)
+    {
+    }
+
+    const String &name() const { return _name; }
+    const String &value() const { return _value; }
+    size_t size() const { return _size; }
+    bool isPost() const { return _isForm; }
+    bool isFile() const { return _isFile; }
+
+private:
+    String _name;
+    String _value;
+    size_t _size;
+    bool _isForm;
+    bool _isFile;
+};
+
+class AsyncWebHeader
+{
+public:
+    AsyncWebHeader(const String &name, const String &value) : _name(name), _value(value) {}
+
+    const String &name() const { return _name; }
+    const String &value() const { return _value; }
+    String toString() const { return _name + ": " + _value + "\r\n"; }
+
+private:
+    String _name;
+    String _value;
+};
+
+// what request->client() gives access to
+class AsyncClient
+{
+public:
+    explicit AsyncClient(int fd) : m_fd(fd) {}
+
+    IPAddress remoteIP() const;
+    uint16_t remotePort() const;
+    IPAddress localIP() const;
+    uint16_t localPort() const;
+
+private:
+    int m_fd;
+};
+
+#pragma region Responses
+
+class AsyncWebServerResponse
+{
+public:
+    AsyncWebServerResponse();
+    virtual ~AsyncWebServerResponse() {}
+
+    void setCode(int code) { _code = code; }
+    int code() const { return _code; }
+    void setContentLength(size_t len) { _contentLength = len; }
+    void setContentType(const String &type) { _contentType = type; }
+    void setContentType(const char *type) { _contentType = type; }
+    bool addHeader(const char *name, const char *value, bool replaceExisting = true);
+    bool addHeader(const String &name, const String &value, bool replaceExisting = true)
+    {
+        return addHeader(name.c_str(), value.c_str(), replaceExisting);
+    }
+    bool removeHeader(const char *name);
+    const AsyncWebHeader *getHeader(const char *name) const;
+
+    static const char *responseCodeToString(int code);
+
+    // sends status, headers and body; false when the client went away
+    virtual bool send(AsyncWebHostConnection &conn, bool head);
+
+protected:
+    String headerBlock(bool chunked) const;
+    // the body, for the responses that have it in memory
+    virtual const uint8_t *body() const { return NULL; }
+
+    int _code;
+    String _contentType;
+    size_t _contentLength;
+    std::list<AsyncWebHeader> _headers;
+};
+
+class AsyncBasicResponse : public AsyncWebServerResponse
+{
+public:
+    AsyncBasicResponse(int code, const char *contentType = "", const char *content = "",
+                       size_t len = (size_t)-1);
+
+protected:
+    const uint8_t *body() const override { return (const uint8_t *)_content.data(); }
+
+    std::string _content;
+};
+
+// as AsyncProgmemResponse on the ESP32 the data is not copied, it must outlive the request
+class AsyncProgmemResponse : public AsyncWebServerResponse
+{
+public:
+    AsyncProgmemResponse(int code, const char *contentType, const uint8_t *content, size_t len);
+
+protected:
+    const uint8_t *body() const override { return _content; }
+
+    const uint8_t *_content;
+};
+
+class AsyncChunkedResponse : public AsyncWebServerResponse
+{
+public:
+    AsyncChunkedResponse(const char *contentType, AwsResponseFiller callback);
+    bool send(AsyncWebHostConnection &conn, bool head) override;
+
+private:
+    AwsResponseFiller _callback;
+};
+
+class AsyncFileResponse : public AsyncWebServerResponse
+{
+public:
+    AsyncFileResponse(FS &fs, const String &path, const char *contentType = "", bool download = false);
+    bool send(AsyncWebHostConnection &conn, bool head) override;
+
+private:
+    File _content;
+};
+
+class AsyncResponseStream : public AsyncWebServerResponse, public Print
+{
+public:
+    AsyncResponseStream(const char *contentType, size_t bufferSize);
+
+    size_t write(uint8_t data) override { return write(&data, 1); }
+    size_t write(const uint8_t *data, size_t len) override;
+    size_t available() const { return _content.size(); }
+    bool send(AsyncWebHostConnection &conn, bool head) override;
+
+    using Print::write;
+
+private:
+    std::string _content;
+};
+
+#pragma endregion
+
+#pragma region Handlers
+
+class AsyncWebHandler
+{
+public:
+    virtual ~AsyncWebHandler() {}
+    virtual bool canHandle(AsyncWebServerRequest *request) const = 0;
+    virtual void handleRequest(AsyncWebServerRequest *request) = 0;
+    virtual void handleUpload(AsyncWebServerRequest *request, const String &filename, size_t index, uint8_t *data,
+                              size_t len, bool final)
+    {
+        (void)request, (void)filename, (void)index, (void)data, (void)len, (void)final;
+    }
+    virtual void handleBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total)
+    {
+        (void)request, (void)data, (void)len, (void)index, (void)total;
+    }
+    virtual bool isRequestHandlerTrivial() const { return true; }
+    // takes the connection over after the request, as the WebSocket does
+    virtual bool handleConnection(AsyncWebServerRequest *request, AsyncWebHostConnection &conn)
+    {
+        (void)request, (void)conn;
+        return false;
+    }
+};
+
+class AsyncCallbackWebHandler : public AsyncWebHandler
+{
+public:
+    AsyncCallbackWebHandler() : _method(HTTP_ANY) {}
+
+    void setUri(const String &uri) { _uri = uri; }
+    void setMethod(WebRequestMethodComposite method) { _method = method; }
+    void onRequest(ArRequestHandlerFunction fn) { _onRequest = fn; }
+    void onUpload(ArUploadHandlerFunction fn) { _onUpload = fn; }
+    void onBody(ArBodyHandlerFunction fn) { _onBody = fn; }
+
+    bool canHandle(AsyncWebServerRequest *request) const override;
+    void handleRequest(AsyncWebServerRequest *request) override;
+    void handleUpload(AsyncWebServerRequest *request, const String &filename, size_t index, uint8_t *data, size_t len,
+                      bool final) override;
+    void handleBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) override;
+    bool isRequestHandlerTrivial() const override { return !_onRequest; }
+
+private:
+    friend class AsyncWebServer;
+
+    String _uri;
+    WebRequestMethodComposite _method;
+    ArRequestHandlerFunction _onRequest;
+    ArUploadHandlerFunction _onUpload;
+    ArBodyHandlerFunction _onBody;
+};
+
+#pragma endregion
+
+#pragma region Request
+
+class AsyncWebServerRequest
+{
+public:
+    File _tempFile;
+    void *_tempObject;
+
+    AsyncWebServerRequest(AsyncWebServer *server, int fd);
+    ~AsyncWebServerRequest();
+
+    AsyncClient *client() { return &_client; }
+    WebRequestMethodComposite method() const { return _method; }
+    const char *methodToString() const;
+    const String &url() const { return _url; }
+    const String &host() const { return _host; }
+    const String &contentType() const { return _contentType; }
+    size_t contentLength() const { return _contentLength; }
+    bool multipart() const { return _contentType.startsWith("multipart/"); }
+    uint8_t version() const { return _version; }
+
+    bool authenticate(const char *username, const char *password, const char *realm = NULL,
+                      bool passwordIsHash = false) const;
+    void requestAuthentication(const char *realm = NULL, bool isDigest = true);
+
+    size_t headers() const { return _headers.size(); }
+    bool hasHeader(const char *name) const { return getHeader(name) != NULL; }
+    bool hasHeader(const String &name) const { return hasHeader(name.c_str()); }
+    const AsyncWebHeader *getHeader(const char *name) const;
+    const AsyncWebHeader *getHeader(const String &name) const { return getHeader(name.c_str()); }
+    const AsyncWebHeader *getHeader(size_t num) const;
+    const String &header(const char *name) const;
+
+    size_t params() const { return _params.size(); }
+    bool hasParam(const char *name, bool post = false, bool file = false) const
+    {
+        return getParam(name, post, file) != NULL;
+    }
+    bool hasParam(const String &name, bool post = false, bool file = false) const
+    {
+        return hasParam(name.c_str(), post, file);
+    }
+    const AsyncWebParameter *getParam(const char *name, bool post = false, bool file = false) const;
+    const AsyncWebParameter *getParam(const String &name, bool post = false, bool file = false) const
+    {
+        return getParam(name.c_str(), post, file);
+    }
+    const AsyncWebParameter *getParam(size_t num) const;
+    bool hasArg(const char *name) const;
+    const String &arg(const char *name) const;
+    const String &arg(const String &name) const { return arg(name.c_str()); }
+
+    void send(AsyncWebServerResponse *response);
+    void send(int code, const char *contentType = "", const char *content = "",
+              AwsTemplateProcessor callback = nullptr)
+    {
+        (void)callback;
+        send(beginResponse(code, contentType, content));
+    }
+    void send(int code, const String &contentType, const String &content = String(),
+              AwsTemplateProcessor callback = nullptr)
+    {
+        (void)callback;
+        send(beginResponse(code, contentType, content));
+    }
+    void send(int code, const char *contentType, const uint8_t *content, size_t len,
+              AwsTemplateProcessor callback = nullptr)
+    {
+        (void)callback;
+        send(beginResponse(code, contentType, content, len));
+    }
+    void send(FS &fs, const String &path, const char *contentType = "", bool download = false,
+              AwsTemplateProcessor callback = nullptr)
+    {
+        (void)callback;
+        send(new AsyncFileResponse(fs, path, contentType, download));
+    }
+    void sendChunked(const char *contentType, AwsResponseFiller callback, AwsTemplateProcessor templateCallback = nullptr)
+    {
+        (void)templateCallback;
+        send(beginChunkedResponse(contentType, callback));
+    }
+    void redirect(const char *url, int code = 302);
+    void redirect(const String &url, int code = 302) { redirect(url.c_str(), code); }
+
+    AsyncWebServerResponse *beginResponse(int code, const char *contentType = "", const char *content = "",
+                                          AwsTemplateProcessor callback = nullptr);
+    AsyncWebServerResponse *beginResponse(int code, const String &contentType, const String &content,
+                                          AwsTemplateProcessor callback = nullptr);
+    AsyncWebServerResponse *beginResponse(int code, const char *contentType, const uint8_t *content, size_t len,
+                                          AwsTemplateProcessor callback = nullptr);
+    AsyncWebServerResponse *beginResponse(FS &fs, const String &path, const char *contentType = "",
+                                          bool download = false, AwsTemplateProcessor callback = nullptr);
+    AsyncWebServerResponse *beginChunkedResponse(const char *contentType, AwsResponseFiller callback,
+                                                 AwsTemplateProcessor templateCallback = nullptr);
+    AsyncResponseStream *beginResponseStream(const char *contentType, size_t bufferSize = 1460);
+
+private:
+    friend class AsyncWebServer;
+    friend class AsyncWebSocket;
+
+    void addParams(const char *data, size_t len, bool post);
+
+    AsyncWebServer *_server;
+    AsyncClient _client;
+    WebRequestMethodComposite _method;
+    uint8_t _version; // 0 = HTTP/1.0, 1 = HTTP/1.1
+    String _url;
+    String _host;
+    String _contentType;
+    size_t _contentLength;
+    std::list<AsyncWebHeader> _headers;
+    std::list<AsyncWebParameter> _params;
+    AsyncWebHandler *_handler;
+    AsyncWebServerResponse *_response;
+};
+
+#pragma endregion
+
+#pragma region WebSocket
+
+typedef enum
+{
+    WS_DISCONNECTED,
+    WS_CONNECTED,
+    WS_DISCONNECTING
+} AwsClientStatus;
+
+typedef enum
+{
+    WS_EVT_CONNECT,
+    WS_EVT_DISCONNECT,
+    WS_EVT_PING,
+    WS_EVT_PONG,
+    WS_EVT_ERROR,
+    WS_EVT_DATA
+} AwsEventType;
+
+typedef enum
+{
+    WS_CONTINUATION,
+    WS_TEXT,
+    WS_BINARY,
+    WS_DISCONNECT = 0x08,
+    WS_PING,
+    WS_PONG
+} AwsFrameType;
+
+typedef struct
+{
+    uint8_t message_opcode;
+    uint32_t num;
+    uint8_t final;
+    uint8_t masked;
+    uint8_t opcode;
+    uint64_t len;
+    uint8_t mask[4];
+    uint64_t index;
+} AwsFrameInfo;
+
+#ifndef WS_MAX_QUEUED_MESSAGES
+#define WS_MAX_QUEUED_MESSAGES 32
+#endif
+
+#ifndef DEFAULT_MAX_WS_CLIENTS
+#define DEFAULT_MAX_WS_CLIENTS 8
+#endif
+
+typedef std::shared_ptr<std::vector<uint8_t>> AsyncWebSocketSharedBuffer;
+
+typedef std::function<void(AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type, void *arg,
+                           uint8_t *data, size_t len)>
+    AwsEventHandler;
+typedef std::function<bool(AsyncWebServerRequest *request)> AwsHandshakeHandler;
+
+class AsyncWebSocketClient
+{
+public:
+    AsyncWebSocketClient(AsyncWebSocket *server, uint32_t id, int fd);
+    ~AsyncWebSocketClient();
+
+    uint32_t id() const { return _id; }
+    AwsClientStatus status() const { return _status; }
+    AsyncClient *client() { return &_client; }
+    IPAddress remoteIP() const { return _client.remoteIP(); }
+    uint16_t remotePort() const { return _client.remotePort(); }
+    AsyncWebSocket *server() { return _server; }
+
+    size_t queueLen() const;
+    bool queueIsFull() const { return queueLen() >= WS_MAX_QUEUED_MESSAGES; }
+    bool canSend() const { return !queueIsFull(); }
+    void setCloseClientOnQueueFull(bool close) { _closeWhenFull = close; }
+    bool willCloseClientOnQueueFull() const { return _closeWhenFull; }
+
+    bool text(const char *message) { return text(message, strlen(message)); }
+    bool text(const char *message, size_t len);
+    bool text(const String &message) { return text(message.c_str(), message.length()); }
+    bool binary(AsyncWebSocketSharedBuffer buffer);
+    bool binary(const uint8_t *message, size_t len);
+    bool ping(const uint8_t *data = NULL, size_t len = 0);
+    void close(uint16_t code = 0, const char *message = NULL);
+
+private:
+    friend class AsyncWebSocket;
+
+    struct Message
+    {
+        uint8_t opcode;
+        AsyncWebSocketSharedBuffer data;
+    };
+
+    bool queue(uint8_t opcode, AsyncWebSocketSharedBuffer data);
+    void run();
+    bool readFrame();
+    bool writeFrame(uint8_t opcode, const uint8_t *data, size_t len);
+
+    AsyncWebSocket *_server;
+    uint32_t _id;
+    int _fd;
+    int _wakeFd;
+    AsyncClient _client;
+    std::atomic<AwsClientStatus> _status;
+    std::atomic<bool> _closeWhenFull; // false: a message that finds the queue full is discarded
+    mutable std::mutex _queueMutex;
+    std::list<Message> _queue;
+    uint32_t _frameNum;
+    uint8_t _messageOpcode;
+};
+
+// As on the ESP32 the client list belongs to the connection tasks: they add and erase their
+// clients under _lock, and everything here except getClients() takes that lock. getClients()
+// hands out the bare list, so walking it from another task races those erases; use textAll(),
+// binaryAll() and the other locked calls, or hold on to a client only inside its events.
+class AsyncWebSocket : public AsyncWebHandler
+{
+public:
+    typedef std::list<AsyncWebSocketClient> AsyncWebSocketClientList;
+
+    enum SendStatus
+    {
+        DISCARDED = 0,
+        ENQUEUED = 1,
+        PARTIALLY_ENQUEUED = 2,
+    };
+
+    explicit AsyncWebSocket(const String &url);
+    ~AsyncWebSocket();
+
+    const char *url() const { return _url.c_str(); }
+    void enable(bool e) { _enabled = e; }
+    bool enabled() const { return _enabled; }
+    void onEvent(AwsEventHandler handler) { _eventHandler = handler; }
+    void handleHandshake(AwsHandshakeHandler handler) { _handshakeHandler = handler; }
+
+    size_t count();
+    AsyncWebSocketClient *client(uint32_t id);
+    bool hasClient(uint32_t id) { return client(id) != NULL; }
+    void cleanupClients(uint16_t maxClients = DEFAULT_MAX_WS_CLIENTS);
+    AsyncWebSocketClientList &getClients();
+
+    void closeAll(uint16_t code = 0, const char *message = NULL);
+    SendStatus textAll(const char *message);
+    SendStatus textAll(const String &message) { return textAll(message.c_str()); }
+    SendStatus binaryAll(AsyncWebSocketSharedBuffer buffer);
+
+    bool canHandle(AsyncWebServerRequest *request) const override;
+    void handleRequest(AsyncWebServerRequest *request) override;
+    bool handleConnection(AsyncWebServerRequest *request, AsyncWebHostConnection &conn) override;
+    bool isRequestHandlerTrivial() const override { return false; }
+
+private:
+    friend class AsyncWebSocketClient;
+
+    SendStatus sendAll(uint8_t opcode, AsyncWebSocketSharedBuffer buffer);
+    void event(AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len);
+
+    String _url;
+    bool _enabled;
+    AwsEventHandler _eventHandler;
+    AwsHandshakeHandler _handshakeHandler;
+    std::recursive_mutex _lock;
+    AsyncWebSocketClientList _clients;
+    std::atomic<uint32_t> _nextId;
+};
+
+#pragma endregion
+
+#pragma region Server
+
+class AsyncWebServer
+{
+public:
+    explicit AsyncWebServer(uint16_t port);
+    ~AsyncWebServer();
+
+    void begin();
+    void end();
+
+    AsyncCallbackWebHandler &on(const char *uri, ArRequestHandlerFunction onRequest)
+    {
+        return on(uri, HTTP_ANY, onRequest);
+    }
+    AsyncCallbackWebHandler &on(const char *uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest,
+                                ArUploadHandlerFunction onUpload = nullptr, ArBodyHandlerFunction onBody = nullptr);
+    AsyncWebHandler &addHandler(AsyncWebHandler *handler);
+    bool removeHandler(AsyncWebHandler *handler);
+
+    void onNotFound(ArRequestHandlerFunction fn) { _catchAllHandler.onRequest(fn); }
+    void onFileUpload(ArUploadHandlerFunction fn) { _catchAllHandler.onUpload(fn); }
+    void onRequestBody(ArBodyHandlerFunction fn) { _catchAllHandler.onBody(fn); }
+    void addMiddleware(ArMiddlewareCallback fn) { _middleware.push_back(fn); }
+
+    void reset();
+
+private:
+    friend class AsyncWebHostConnection;
+
+    void listen();
+    void handleConnection(int fd);
+    void runHandler(AsyncWebServerRequest *request);
+    AsyncWebHandler *findHandler(AsyncWebServerRequest *request);
+
+    uint16_t _port;
+    std::atomic<int> _listenFd;
+    std::vector<AsyncWebHandler *> _handlers;
+    std::vector<AsyncCallbackWebHandler *> _ownedHandlers;
+    AsyncCallbackWebHandler _catchAllHandler;
+    std::vector<ArMiddlewareCallback> _middleware;
+};
+
+#pragma endregion
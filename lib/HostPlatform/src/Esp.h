@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+
+// Sizes and versions a host can stand in for: the heap figures come from heap_caps, the chip
+// is an ESP32 rev 3 at 240 MHz with 4 MB of flash
+class EspClass
+{
+public:
+    uint32_t getHeapSize();
+    uint32_t getFreeHeap();
+    uint32_t getMinFreeHeap();
+    uint32_t getMaxAllocHeap();
+
+    uint32_t getPsramSize();
+    uint32_t getFreePsram();
+    uint32_t getMinFreePsram();
+    uint32_t getMaxAllocPsram();
+
+    uint8_t getChipRevision() { return 3; }
+    const char *getChipModel() { return "ESP32-D0WDQ6"; }
+    uint8_t getChipCores() { return 2; }
+    uint32_t getCpuFreqMHz() { return 240; }
+    const char *getSdkVersion();
+    uint32_t getFlashChipSize() { return 4 * 1024 * 1024; }
+    uint32_t getFlashChipSpeed() { return 40000000; }
+    uint32_t getSketchSize();
+    uint32_t getFreeSketchSpace();
+    uint64_t getEfuseMac();
+    uint32_t getCycleCount();
+
+    void restart() __attribute__((noreturn));
+    void deepSleep(uint32_t time_us) __attribute__((noreturn));
+};
+
+extern EspClass ESP;
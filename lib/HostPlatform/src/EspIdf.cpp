@@ -0,0 +1,814 @@
+#include <Arduino.h>
+
+#include "HostPlatform.h"
+#include "driver/gpio.h"
+#include "driver/rtc_io.h"
+#include "esp_mac.h"
+#include "esp_ota_ops.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "esp_task_wdt.h"
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <malloc.h>
+#include <sys/random.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#pragma region Errors and Logging
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code)
+    {
+    case ESP_OK:
+        return "ESP_OK";
+    case ESP_FAIL:
+        return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:
+        return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:
+        return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:
+        return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE:
+        return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND:
+        return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED:
+        return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT:
+        return "ESP_ERR_TIMEOUT";
+    case ESP_ERR_INVALID_RESPONSE:
+        return "ESP_ERR_INVALID_RESPONSE";
+    case ESP_ERR_INVALID_CRC:
+        return "ESP_ERR_INVALID_CRC";
+    case ESP_ERR_INVALID_VERSION:
+        return "ESP_ERR_INVALID_VERSION";
+    case ESP_ERR_INVALID_MAC:
+        return "ESP_ERR_INVALID_MAC";
+    case ESP_ERR_NOT_FINISHED:
+        return "ESP_ERR_NOT_FINISHED";
+    default:
+        return "UNKNOWN ERROR";
+    }
+}
+
+static std::atomic<int> s_logLevel(ESP_LOG_INFO);
+
+void esp_log_level_set(const char *tag, esp_log_level_t level)
+{
+    if (strcmp(tag, "*") == 0)
+        s_logLevel = level;
+}
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+{
+    (void)tag;
+    if (level > s_logLevel)
+        return;
+
+    va_list args;
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+}
+
+uint32_t esp_log_timestamp(void)
+{
+    return millis();
+}
+
+#pragma endregion
+
+#pragma region System
+
+esp_reset_reason_t esp_reset_reason(void)
+{
+    return (esp_reset_reason_t)hostResetReason();
+}
+
+void esp_restart(void)
+{
+    hostReboot(ESP_RST_SW, 0, ESP_SLEEP_WAKEUP_UNDEFINED, 0);
+}
+
+uint32_t esp_random(void)
+{
+    uint32_t value;
+    esp_fill_random(&value, sizeof(value));
+    return value;
+}
+
+void esp_fill_random(void *buf, size_t len)
+{
+    uint8_t *p = (uint8_t *)buf;
+    while (len > 0)
+    {
+        ssize_t n = getrandom(p, len, 0);
+        if (n <= 0)
+            continue;
+        p += n;
+        len -= n;
+    }
+}
+
+uint32_t esp_get_free_heap_size(void)
+{
+    return heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+}
+
+uint32_t esp_get_free_internal_heap_size(void)
+{
+    return heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+}
+
+uint32_t esp_get_minimum_free_heap_size(void)
+{
+    return heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT);
+}
+
+const char *esp_get_idf_version(void)
+{
+    return "v5.1-host";
+}
+
+#pragma endregion
+
+#pragma region MAC Address
+
+static bool parseMac(const char *text, uint8_t *mac)
+{
+    unsigned int b[6];
+    if (sscanf(text, "%x:%x:%x:%x:%x:%x", &b[0], &b[1], &b[2], &b[3], &b[4], &b[5]) != 6)
+        return false;
+    for (int i = 0; i < 6; i++)
+        mac[i] = (uint8_t)b[i];
+    return true;
+}
+
+esp_err_t esp_base_mac_addr_get(uint8_t *mac)
+{
+    static uint8_t base[6];
+    static std::once_flag once;
+    std::call_once(once, []() {
+        if (parseMac(hostEnv("HOST_MAC", ""), base))
+            return;
+
+        char name[256] = "";
+        gethostname(name, sizeof(name) - 1);
+        uint32_t hash = esp_rom_crc32_le(0, (const uint8_t *)name, strlen(name));
+        base[0] = 0x02; // locally administered
+        base[1] = 0x00;
+        base[2] = (uint8_t)(hash >> 24);
+        base[3] = (uint8_t)(hash >> 16);
+        base[4] = (uint8_t)(hash >> 8);
+        base[5] = (uint8_t)hash;
+    });
+    memcpy(mac, base, sizeof(base));
+    return ESP_OK;
+}
+
+esp_err_t esp_efuse_mac_get_default(uint8_t *mac)
+{
+    return esp_base_mac_addr_get(mac);
+}
+
+// the ESP32 derives the other interfaces by adding to the last byte
+esp_err_t esp_read_mac(uint8_t *mac, esp_mac_type_t type)
+{
+    esp_base_mac_addr_get(mac);
+    mac[5] += (uint8_t)type;
+    return ESP_OK;
+}
+
+#pragma endregion
+
+#pragma region Sleep
+
+static uint64_t s_wakeTimerUs = 0;
+static std::atomic<uint64_t> s_extWakePins(0);
+static std::atomic<int> s_extWakeLevel(1);
+static std::atomic<int> s_extWakeSource(ESP_SLEEP_WAKEUP_UNDEFINED);
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t time_in_us)
+{
+    s_wakeTimerUs = time_in_us;
+    return ESP_OK;
+}
+
+esp_err_t esp_sleep_enable_ext0_wakeup(gpio_num_t gpio_num, int level)
+{
+    if (!rtc_gpio_is_valid_gpio(gpio_num))
+        return ESP_ERR_INVALID_ARG;
+    s_extWakePins = 1ULL << gpio_num;
+    s_extWakeLevel = level ? 1 : 0;
+    s_extWakeSource = ESP_SLEEP_WAKEUP_EXT0;
+    return ESP_OK;
+}
+
+esp_err_t esp_sleep_enable_ext1_wakeup(uint64_t io_mask, esp_sleep_ext1_wakeup_mode_t level_mode)
+{
+    s_extWakePins = io_mask;
+    s_extWakeLevel = (level_mode == ESP_EXT1_WAKEUP_ANY_HIGH) ? 1 : 0;
+    s_extWakeSource = ESP_SLEEP_WAKEUP_EXT1;
+    return ESP_OK;
+}
+
+esp_err_t esp_sleep_disable_wakeup_source(esp_sleep_source_t source)
+{
+    if (source == ESP_SLEEP_WAKEUP_ALL || source == ESP_SLEEP_WAKEUP_TIMER)
+        s_wakeTimerUs = 0;
+    if (source == ESP_SLEEP_WAKEUP_ALL || source == s_extWakeSource)
+    {
+        s_extWakePins = 0;
+        s_extWakeSource = ESP_SLEEP_WAKEUP_UNDEFINED;
+    }
+    return ESP_OK;
+}
+
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause(void)
+{
+    return (esp_sleep_wakeup_cause_t)hostWakeupCause();
+}
+
+uint64_t esp_sleep_get_ext1_wakeup_status(void)
+{
+    return (hostWakeupCause() == ESP_SLEEP_WAKEUP_EXT1) ? hostExtWakeStatus() : 0;
+}
+
+void esp_deep_sleep_start(void)
+{
+    char level[4];
+    snprintf(level, sizeof(level), "%d", (int)s_extWakeLevel);
+    setenv("HOST_SLEEP_EXT_LEVEL", level, 1);
+    hostReboot(ESP_RST_DEEPSLEEP, s_wakeTimerUs, s_extWakeSource, s_extWakePins);
+}
+
+void esp_deep_sleep(uint64_t time_in_us)
+{
+    esp_sleep_enable_timer_wakeup(time_in_us);
+    esp_deep_sleep_start();
+}
+
+esp_err_t esp_light_sleep_start(void)
+{
+    if (s_wakeTimerUs > 0)
+        usleep(s_wakeTimerUs);
+    return ESP_OK;
+}
+
+// async-signal-safe: atomics only
+void hostWakeSignal(bool active)
+{
+    uint64_t pins = s_extWakePins;
+    int level = s_extWakeLevel;
+    hostGpioSetInputs(pins, active ? level : !level);
+}
+
+#pragma endregion
+
+#pragma region GPIO
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level)
+{
+    digitalWrite(gpio_num, level);
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio_num)
+{
+    return digitalRead(gpio_num);
+}
+
+esp_err_t gpio_set_direction(gpio_num_t gpio_num, gpio_mode_t mode)
+{
+    pinMode(gpio_num, (mode & GPIO_MODE_OUTPUT) ? OUTPUT : INPUT);
+    return ESP_OK;
+}
+
+esp_err_t gpio_reset_pin(gpio_num_t gpio_num)
+{
+    pinMode(gpio_num, INPUT);
+    hostGpioPull(gpio_num, 0);
+    return ESP_OK;
+}
+
+esp_err_t gpio_pullup_en(gpio_num_t gpio_num)
+{
+    hostGpioPull(gpio_num, 1);
+    return ESP_OK;
+}
+
+esp_err_t gpio_pullup_dis(gpio_num_t gpio_num)
+{
+    (void)gpio_num; // leaves a pulldown alone, as the hardware does
+    return ESP_OK;
+}
+
+esp_err_t gpio_pulldown_en(gpio_num_t gpio_num)
+{
+    hostGpioPull(gpio_num, -1);
+    return ESP_OK;
+}
+
+esp_err_t gpio_pulldown_dis(gpio_num_t gpio_num)
+{
+    (void)gpio_num;
+    return ESP_OK;
+}
+
+// levels already survive as long as the process does, and deep sleep ends it
+esp_err_t gpio_hold_en(gpio_num_t gpio_num)
+{
+    (void)gpio_num;
+    return ESP_OK;
+}
+
+esp_err_t gpio_hold_dis(gpio_num_t gpio_num)
+{
+    (void)gpio_num;
+    return ESP_OK;
+}
+
+void gpio_deep_sleep_hold_en(void)
+{
+}
+
+void gpio_deep_sleep_hold_dis(void)
+{
+}
+
+bool rtc_gpio_is_valid_gpio(gpio_num_t gpio_num)
+{
+    static const uint64_t rtcPins = (1ULL << 0) | (1ULL << 2) | (1ULL << 4) | (1ULL << 12) | (1ULL << 13) |
+                                    (1ULL << 14) | (1ULL << 15) | (1ULL << 25) | (1ULL << 26) | (1ULL << 27) |
+                                    (1ULL << 32) | (1ULL << 33) | (1ULL << 34) | (1ULL << 35) | (1ULL << 36) |
+                                    (1ULL << 37) | (1ULL << 38) | (1ULL << 39);
+    return gpio_num >= 0 && gpio_num < GPIO_NUM_MAX && (rtcPins & (1ULL << gpio_num));
+}
+
+esp_err_t rtc_gpio_init(gpio_num_t gpio_num)
+{
+    return rtc_gpio_is_valid_gpio(gpio_num) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t rtc_gpio_deinit(gpio_num_t gpio_num)
+{
+    return rtc_gpio_init(gpio_num);
+}
+
+esp_err_t rtc_gpio_pullup_en(gpio_num_t gpio_num)
+{
+    if (!rtc_gpio_is_valid_gpio(gpio_num))
+        return ESP_ERR_INVALID_ARG;
+    return gpio_pullup_en(gpio_num);
+}
+
+esp_err_t rtc_gpio_pullup_dis(gpio_num_t gpio_num)
+{
+    if (!rtc_gpio_is_valid_gpio(gpio_num))
+        return ESP_ERR_INVALID_ARG;
+    return gpio_pullup_dis(gpio_num);
+}
+
+esp_err_t rtc_gpio_pulldown_en(gpio_num_t gpio_num)
+{
+    if (!rtc_gpio_is_valid_gpio(gpio_num))
+        return ESP_ERR_INVALID_ARG;
+    return gpio_pulldown_en(gpio_num);
+}
+
+esp_err_t rtc_gpio_pulldown_dis(gpio_num_t gpio_num)
+{
+    if (!rtc_gpio_is_valid_gpio(gpio_num))
+        return ESP_ERR_INVALID_ARG;
+    return gpio_pulldown_dis(gpio_num);
+}
+
+esp_err_t rtc_gpio_hold_en(gpio_num_t gpio_num)
+{
+    return rtc_gpio_init(gpio_num);
+}
+
+esp_err_t rtc_gpio_hold_dis(gpio_num_t gpio_num)
+{
+    return rtc_gpio_init(gpio_num);
+}
+
+esp_err_t rtc_gpio_isolate(gpio_num_t gpio_num)
+{
+    return rtc_gpio_init(gpio_num);
+}
+
+#pragma endregion
+
+#pragma region Heap
+
+// under ASan the allocator is the sanitizer's and mallinfo2() sees nothing
+extern "C" size_t __sanitizer_get_current_allocated_bytes(void) __attribute__((weak));
+
+static std::mutex s_heapMutex;
+static std::map<void *, size_t> s_psramBlocks;
+static size_t s_psramUsed = 0;
+static size_t s_psramMinFree = SIZE_MAX;
+static size_t s_heapMinFree = SIZE_MAX;
+static esp_alloc_failed_hook_t s_allocFailedHook = NULL;
+
+static size_t heapSize()
+{
+    static const size_t size = hostEnvInt("HOST_HEAP_SIZE", 8 * 1024 * 1024);
+    return size;
+}
+
+static size_t psramSize()
+{
+    static const size_t size = hostEnvInt("HOST_PSRAM_SIZE", 4 * 1024 * 1024);
+    return size;
+}
+
+// callers hold s_heapMutex
+static size_t heapFreeLocked()
+{
+    size_t allocated = __sanitizer_get_current_allocated_bytes ? __sanitizer_get_current_allocated_bytes()
+                                                               : mallinfo2().uordblks;
+    allocated = (allocated > s_psramUsed) ? allocated - s_psramUsed : 0;
+    size_t free = (allocated < heapSize()) ? heapSize() - allocated : 0;
+    if (free < s_heapMinFree)
+        s_heapMinFree = free;
+    return free;
+}
+
+static size_t psramFreeLocked()
+{
+    size_t free = psramSize() - s_psramUsed;
+    if (free < s_psramMinFree)
+        s_psramMinFree = free;
+    return free;
+}
+
+static void allocFailed(size_t size, uint32_t caps, const char *function)
+{
+    if (s_allocFailedHook)
+        s_allocFailedHook(size, caps, function);
+}
+
+void *heap_caps_malloc(size_t size, uint32_t caps)
+{
+    std::unique_lock<std::mutex> lock(s_heapMutex);
+    if (caps & MALLOC_CAP_SPIRAM)
+    {
+        if (size > psramFreeLocked())
+        {
+            lock.unlock();
+            allocFailed(size, caps, __func__);
+            return NULL;
+        }
+        void *ptr = malloc(size);
+        if (ptr)
+        {
+            s_psramBlocks[ptr] = size;
+            s_psramUsed += size;
+            psramFreeLocked();
+        }
+        return ptr;
+    }
+
+    if (size > heapFreeLocked())
+    {
+        lock.unlock();
+        allocFailed(size, caps, __func__);
+        return NULL;
+    }
+    lock.unlock();
+    return malloc(size);
+}
+
+void *heap_caps_calloc(size_t n, size_t size, uint32_t caps)
+{
+    if (size != 0 && n > SIZE_MAX / size)
+        return NULL;
+    void *ptr = heap_caps_malloc(n * size, caps);
+    if (ptr)
+        memset(ptr, 0, n * size);
+    return ptr;
+}
+
+void *heap_caps_realloc(void *ptr, size_t size, uint32_t caps)
+{
+    if (ptr == NULL)
+        return heap_caps_malloc(size, caps);
+    if (size == 0)
+    {
+        heap_caps_free(ptr);
+        return NULL;
+    }
+
+    size_t oldSize;
+    {
+        std::lock_guard<std::mutex> lock(s_heapMutex);
+        auto block = s_psramBlocks.find(ptr);
+        oldSize = (block != s_psramBlocks.end()) ? block->second : malloc_usable_size(ptr);
+    }
+    void *moved = heap_caps_malloc(size, caps);
+    if (moved == NULL)
+        return NULL;
+    memcpy(moved, ptr, (oldSize < size) ? oldSize : size);
+    heap_caps_free(ptr);
+    return moved;
+}
+
+void heap_caps_free(void *ptr)
+{
+    if (ptr == NULL)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(s_heapMutex);
+        auto block = s_psramBlocks.find(ptr);
+        if (block != s_psramBlocks.end())
+        {
+            s_psramUsed -= block->second;
+            s_psramBlocks.erase(block);
+        }
+    }
+    free(ptr);
+}
+
+size_t heap_caps_get_total_size(uint32_t caps)
+{
+    return (caps & MALLOC_CAP_SPIRAM) ? psramSize() : heapSize();
+}
+
+size_t heap_caps_get_free_size(uint32_t caps)
+{
+    std::lock_guard<std::mutex> lock(s_heapMutex);
+    return (caps & MALLOC_CAP_SPIRAM) ? psramFreeLocked() : heapFreeLocked();
+}
+
+size_t heap_caps_get_minimum_free_size(uint32_t caps)
+{
+    std::lock_guard<std::mutex> lock(s_heapMutex);
+    if (caps & MALLOC_CAP_SPIRAM)
+    {
+        psramFreeLocked();
+        return s_psramMinFree;
+    }
+    heapFreeLocked();
+    return s_heapMinFree;
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps)
+{
+    return heap_caps_get_free_size(caps);
+}
+
+void heap_caps_get_info(multi_heap_info_t *info, uint32_t caps)
+{
+    memset(info, 0, sizeof(*info));
+    info->total_free_bytes = heap_caps_get_free_size(caps);
+    info->total_allocated_bytes = heap_caps_get_total_size(caps) - info->total_free_bytes;
+    info->largest_free_block = info->total_free_bytes;
+    info->minimum_free_bytes = heap_caps_get_minimum_free_size(caps);
+
+    std::lock_guard<std::mutex> lock(s_heapMutex);
+    if (caps & MALLOC_CAP_SPIRAM)
+        info->allocated_blocks = s_psramBlocks.size();
+    else
+        info->allocated_blocks = mallinfo2().ordblks;
+    info->free_blocks = 1;
+    info->total_blocks = info->allocated_blocks + info->free_blocks;
+}
+
+esp_err_t heap_caps_register_failed_alloc_callback(esp_alloc_failed_hook_t callback)
+{
+    s_allocFailedHook = callback;
+    return ESP_OK;
+}
+
+// the sanitizers do this properly
+bool heap_caps_check_integrity_all(bool print_errors)
+{
+    (void)print_errors;
+    return true;
+}
+
+#pragma endregion
+
+#pragma region CRC
+
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len)
+{
+    static uint32_t table[256];
+    static std::once_flag once;
+    std::call_once(once, []() {
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++)
+                c = (c & 1) ? (0xedb88320 ^ (c >> 1)) : (c >> 1);
+            table[i] = c;
+        }
+    });
+
+    crc = ~crc;
+    while (len--)
+        crc = table[(crc ^ *buf++) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+#pragma endregion
+
+#pragma region Partitions
+
+// Update checks images against this, room for an executable built with sanitizers; the
+// running partition is the executable rounded up to a flash sector
+static const uint32_t HOST_OTA_PARTITION_SIZE = 64 * 1024 * 1024;
+
+static esp_partition_t s_runningPartition;
+static esp_partition_t s_nextPartition;
+
+static void partitionsInit()
+{
+    static std::once_flag once;
+    std::call_once(once, []() {
+        struct stat st;
+        uint32_t size = (stat(hostFirmwarePath(), &st) == 0) ? st.st_size : 0;
+
+        s_runningPartition.type = ESP_PARTITION_TYPE_APP;
+        s_runningPartition.subtype = ESP_PARTITION_SUBTYPE_APP_OTA_0;
+        s_runningPartition.address = 0x10000;
+        s_runningPartition.size = (size + 0xfff) & ~0xfffu;
+        s_runningPartition.erase_size = 0x1000;
+        strcpy(s_runningPartition.label, "app0");
+
+        s_nextPartition.type = ESP_PARTITION_TYPE_APP;
+        s_nextPartition.subtype = ESP_PARTITION_SUBTYPE_APP_OTA_1;
+        s_nextPartition.address = s_runningPartition.address + HOST_OTA_PARTITION_SIZE;
+        s_nextPartition.size = HOST_OTA_PARTITION_SIZE;
+        s_nextPartition.erase_size = 0x1000;
+        strcpy(s_nextPartition.label, "app1");
+    });
+}
+
+// bytes past the end of the file read as erased flash
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset, void *dst, size_t size)
+{
+    if (partition == NULL || dst == NULL)
+        return ESP_ERR_INVALID_ARG;
+    if (src_offset > partition->size || size > partition->size - src_offset)
+        return ESP_ERR_INVALID_SIZE;
+
+    std::string next;
+    const char *path = hostFirmwarePath();
+    if (partition == &s_nextPartition)
+    {
+        next = hostPath("ota", "next");
+        path = next.c_str();
+    }
+
+    memset(dst, 0xff, size);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return (partition == &s_nextPartition) ? ESP_OK : ESP_FAIL;
+    ssize_t n = pread(fd, dst, size, src_offset);
+    close(fd);
+    return (n < 0) ? ESP_FAIL : ESP_OK;
+}
+
+const esp_partition_t *esp_ota_get_running_partition(void)
+{
+    partitionsInit();
+    return &s_runningPartition;
+}
+
+const esp_partition_t *esp_ota_get_boot_partition(void)
+{
+    return esp_ota_get_running_partition();
+}
+
+const esp_partition_t *esp_ota_get_next_update_partition(const esp_partition_t *start_from)
+{
+    (void)start_from;
+    partitionsInit();
+    return &s_nextPartition;
+}
+
+esp_err_t esp_ota_mark_app_valid_cancel_rollback(void)
+{
+    return ESP_OK;
+}
+
+#pragma endregion
+
+#pragma region Task Watchdog
+
+struct WatchedTask
+{
+    std::string name; // copies, a task that ends without esp_task_wdt_delete() is still reported
+    int core;
+    uint32_t lastReset;
+};
+
+static std::mutex s_wdtMutex;
+static std::map<TaskHandle_t, WatchedTask> s_wdtTasks;
+static uint32_t s_wdtTimeoutMs = 0;
+static bool s_wdtPanic = false;
+
+static void wdtCheck()
+{
+    while (true)
+    {
+        usleep(100000);
+
+        std::lock_guard<std::mutex> lock(s_wdtMutex);
+        uint32_t now = millis();
+        bool triggered = false;
+        for (auto &entry : s_wdtTasks)
+        {
+            WatchedTask &task = entry.second;
+            if (now - task.lastReset < s_wdtTimeoutMs)
+                continue;
+            if (!triggered)
+                fprintf(stderr, "E (%u) task_wdt: Task watchdog got triggered. The following tasks did not reset "
+                                "the watchdog in time:\n", now);
+            fprintf(stderr, "E (%u) task_wdt:  - %s (CPU %d)\n", now, task.name.c_str(), task.core);
+            task.lastReset = now; // reported again after another timeout, as on the ESP32
+            triggered = true;
+        }
+        if (triggered && s_wdtPanic)
+        {
+            fprintf(stderr, "E (%u) task_wdt: Aborting.\n", now);
+            hostReboot(ESP_RST_TASK_WDT, 0, ESP_SLEEP_WAKEUP_UNDEFINED, 0);
+        }
+    }
+}
+
+esp_err_t esp_task_wdt_init(uint32_t timeout, bool panic)
+{
+    static std::once_flag started;
+    {
+        std::lock_guard<std::mutex> lock(s_wdtMutex);
+        s_wdtTimeoutMs = timeout * 1000;
+        s_wdtPanic = panic;
+    }
+    std::call_once(started, []() { std::thread(wdtCheck).detach(); });
+    return ESP_OK;
+}
+
+esp_err_t esp_task_wdt_deinit(void)
+{
+    std::lock_guard<std::mutex> lock(s_wdtMutex);
+    if (!s_wdtTasks.empty())
+        return ESP_ERR_INVALID_STATE;
+    s_wdtTimeoutMs = 0;
+    return ESP_OK;
+}
+
+esp_err_t esp_task_wdt_add(TaskHandle_t handle)
+{
+    if (handle == NULL)
+        handle = xTaskGetCurrentTaskHandle();
+    std::lock_guard<std::mutex> lock(s_wdtMutex);
+    if (s_wdtTimeoutMs == 0 || handle == NULL)
+        return ESP_ERR_INVALID_STATE;
+    if (s_wdtTasks.count(handle))
+        return ESP_ERR_INVALID_ARG;
+    s_wdtTasks[handle] = WatchedTask{pcTaskGetName(handle), (int)xTaskGetAffinity(handle), (uint32_t)millis()};
+    return ESP_OK;
+}
+
+esp_err_t esp_task_wdt_reset(void)
+{
+    std::lock_guard<std::mutex> lock(s_wdtMutex);
+    auto it = s_wdtTasks.find(xTaskGetCurrentTaskHandle());
+    if (it == s_wdtTasks.end())
+        return ESP_ERR_NOT_FOUND;
+    it->second.lastReset = millis();
+    return ESP_OK;
+}
+
+esp_err_t esp_task_wdt_delete(TaskHandle_t handle)
+{
+    if (handle == NULL)
+        handle = xTaskGetCurrentTaskHandle();
+    std::lock_guard<std::mutex> lock(s_wdtMutex);
+    return s_wdtTasks.erase(handle) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t esp_task_wdt_status(TaskHandle_t handle)
+{
+    if (handle == NULL)
+        handle = xTaskGetCurrentTaskHandle();
+    std::lock_guard<std::mutex> lock(s_wdtMutex);
+    if (s_wdtTimeoutMs == 0)
+        return ESP_ERR_INVALID_STATE;
+    return s_wdtTasks.count(handle) ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+#pragma endregion
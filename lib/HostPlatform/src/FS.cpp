@@ -0,0 +1,352 @@
+#include "FS.h"
+
+#include "HostPlatform.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs
+{
+
+#pragma region File Handles
+
+class FileImpl
+{
+public:
+    FileImpl(const std::string &hostPath, const std::string &path, FILE *file, DIR *dir)
+        : m_hostPath(hostPath), m_path(path), m_file(file), m_dir(dir), m_lastWrite(false)
+    {
+        size_t slash = m_path.rfind('/');
+        m_name = (slash == std::string::npos) ? m_path : m_path.substr(slash + 1);
+    }
+
+    ~FileImpl() { close(); }
+
+    void close()
+    {
+        if (m_file)
+            fclose(m_file);
+        if (m_dir)
+            closedir(m_dir);
+        m_file = NULL;
+        m_dir = NULL;
+    }
+
+    // stdio needs a seek between a read and a write on the same stream, the ESP32 VFS does not
+    void direction(bool write)
+    {
+        if (m_file && write != m_lastWrite)
+            fseek(m_file, 0, SEEK_CUR);
+        m_lastWrite = write;
+    }
+
+    // the next entry that is not . or .., NULL at the end
+    struct dirent *nextEntry()
+    {
+        if (!m_dir)
+            return NULL;
+        struct dirent *entry;
+        while ((entry = readdir(m_dir)) != NULL)
+        {
+            if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0)
+                return entry;
+        }
+        return NULL;
+    }
+
+    std::string childPath(const char *name) const { return ((m_path == "/") ? "" : m_path) + "/" + name; }
+
+    std::string m_hostPath;
+    std::string m_path; // on the mounted file system
+    std::string m_name;
+    FILE *m_file;
+    DIR *m_dir;
+    bool m_lastWrite;
+};
+
+static FileImplPtr openHost(const std::string &hostPath, const std::string &path, const char *mode)
+{
+    struct stat st;
+    bool exists = (stat(hostPath.c_str(), &st) == 0);
+    if (exists && S_ISDIR(st.st_mode))
+    {
+        DIR *dir = opendir(hostPath.c_str());
+        return dir ? std::make_shared<FileImpl>(hostPath, path, (FILE *)NULL, dir) : FileImplPtr();
+    }
+    if (!exists && mode[0] == 'r')
+        return FileImplPtr();
+
+    // every descriptor is close-on-exec so a restart starts with none open
+    char hostMode[8];
+    snprintf(hostMode, sizeof(hostMode), "%se", mode);
+    FILE *file = fopen(hostPath.c_str(), hostMode);
+    return file ? std::make_shared<FileImpl>(hostPath, path, file, (DIR *)NULL) : FileImplPtr();
+}
+
+#pragma endregion
+
+#pragma region File
+
+size_t File::write(const uint8_t *buf, size_t size)
+{
+    if (!_p || !_p->m_file)
+        return 0;
+    _p->direction(true);
+    return fwrite(buf, 1, size, _p->m_file);
+}
+
+int File::available()
+{
+    if (!_p || !_p->m_file)
+        return 0;
+    size_t pos = position();
+    size_t end = size();
+    return (end > pos) ? (int)(end - pos) : 0;
+}
+
+int File::read()
+{
+    uint8_t c;
+    return (read(&c, 1) == 1) ? c : -1;
+}
+
+int File::peek()
+{
+    if (!_p || !_p->m_file)
+        return -1;
+    _p->direction(false);
+    int c = fgetc(_p->m_file);
+    if (c != EOF)
+        ungetc(c, _p->m_file);
+    return (c == EOF) ? -1 : c;
+}
+
+void File::flush()
+{
+    if (_p && _p->m_file)
+        fflush(_p->m_file);
+}
+
+size_t File::read(uint8_t *buf, size_t size)
+{
+    if (!_p || !_p->m_file)
+        return 0;
+    _p->direction(false);
+    return fread(buf, 1, size, _p->m_file);
+}
+
+bool File::seek(uint32_t pos, SeekMode mode)
+{
+    if (!_p || !_p->m_file)
+        return false;
+    static const int whence[] = {SEEK_SET, SEEK_CUR, SEEK_END};
+    return fseek(_p->m_file, pos, whence[mode]) == 0;
+}
+
+size_t File::position() const
+{
+    if (!_p || !_p->m_file)
+        return 0;
+    long pos = ftell(_p->m_file);
+    return (pos < 0) ? 0 : pos;
+}
+
+size_t File::size() const
+{
+    if (!_p || !_p->m_file)
+        return 0;
+    fflush(_p->m_file);
+    struct stat st;
+    return (fstat(fileno(_p->m_file), &st) == 0) ? st.st_size : 0;
+}
+
+bool File::setBufferSize(size_t size)
+{
+    if (!_p || !_p->m_file)
+        return false;
+    return setvbuf(_p->m_file, NULL, _IOFBF, size) == 0;
+}
+
+void File::close()
+{
+    if (_p)
+        _p->close();
+    _p = FileImplPtr();
+}
+
+File::operator bool() const
+{
+    return _p && (_p->m_file || _p->m_dir);
+}
+
+time_t File::getLastWrite()
+{
+    if (!_p)
+        return 0;
+    struct stat st;
+    return (stat(_p->m_hostPath.c_str(), &st) == 0) ? st.st_mtime : 0;
+}
+
+const char *File::path() const
+{
+    return _p ? _p->m_path.c_str() : NULL;
+}
+
+const char *File::name() const
+{
+    return _p ? _p->m_name.c_str() : NULL;
+}
+
+bool File::isDirectory(void)
+{
+    return _p && _p->m_dir;
+}
+
+File File::openNextFile(const char *mode)
+{
+    if (!_p)
+        return File();
+    struct dirent *entry = _p->nextEntry();
+    if (!entry)
+        return File();
+    return File(openHost(_p->m_hostPath + "/" + entry->d_name, _p->childPath(entry->d_name), mode));
+}
+
+String File::getNextFileName(void)
+{
+    return getNextFileName(NULL);
+}
+
+// the full path, as the ESP32 returns it, without opening the entry
+String File::getNextFileName(bool *isDir)
+{
+    if (!_p)
+        return "";
+    struct dirent *entry = _p->nextEntry();
+    if (!entry)
+        return "";
+
+    if (isDir)
+    {
+        struct stat st;
+        std::string host = _p->m_hostPath + "/" + entry->d_name;
+        *isDir = (stat(host.c_str(), &st) == 0) && S_ISDIR(st.st_mode);
+    }
+    return String(_p->childPath(entry->d_name).c_str());
+}
+
+void File::rewindDirectory(void)
+{
+    if (_p && _p->m_dir)
+        rewinddir(_p->m_dir);
+}
+
+#pragma endregion
+
+#pragma region FS
+
+bool FS::mount()
+{
+    hostPath(m_area);
+    m_mounted = true;
+    return true;
+}
+
+std::string FS::hostPathFor(const char *path)
+{
+    if (!m_mounted || path == NULL || path[0] != '/')
+        return "";
+    // nothing may reach outside the directory
+    for (const char *p = path; (p = strstr(p, "..")) != NULL; p += 2)
+    {
+        if ((p[-1] == '/') && (p[2] == '/' || p[2] == '\0'))
+            return "";
+    }
+    std::string host = hostPath(m_area, path);
+    while (host.size() > 1 && host.back() == '/')
+        host.pop_back();
+    return host;
+}
+
+File FS::open(const char *path, const char *mode, const bool create)
+{
+    std::string host = hostPathFor(path);
+    if (host.empty())
+        return File();
+
+    if (create && mode[0] != 'r')
+    {
+        for (size_t slash = host.find('/', strlen(hostRoot()) + 1); slash != std::string::npos;
+             slash = host.find('/', slash + 1))
+            ::mkdir(host.substr(0, slash).c_str(), 0755);
+    }
+    std::string fsPath(path);
+    while (fsPath.size() > 1 && fsPath.back() == '/')
+        fsPath.pop_back();
+    return File(openHost(host, fsPath, mode));
+}
+
+bool FS::exists(const char *path)
+{
+    std::string host = hostPathFor(path);
+    return !host.empty() && access(host.c_str(), F_OK) == 0;
+}
+
+bool FS::remove(const char *path)
+{
+    std::string host = hostPathFor(path);
+    return !host.empty() && unlink(host.c_str()) == 0;
+}
+
+bool FS::rename(const char *pathFrom, const char *pathTo)
+{
+    std::string from = hostPathFor(pathFrom);
+    std::string to = hostPathFor(pathTo);
+    return !from.empty() && !to.empty() && ::rename(from.c_str(), to.c_str()) == 0;
+}
+
+bool FS::mkdir(const char *path)
+{
+    std::string host = hostPathFor(path);
+    return !host.empty() && (::mkdir(host.c_str(), 0755) == 0 || errno == EEXIST);
+}
+
+bool FS::rmdir(const char *path)
+{
+    std::string host = hostPathFor(path);
+    return !host.empty() && ::rmdir(host.c_str()) == 0;
+}
+
+// file contents in whole 4 KB blocks, as LittleFS and FAT allocate them
+static size_t usedBytesIn(const std::string &dirPath)
+{
+    size_t used = 0;
+    DIR *dir = opendir(dirPath.c_str());
+    if (!dir)
+        return 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL)
+    {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+            continue;
+        std::string child = dirPath + "/" + entry->d_name;
+        struct stat st;
+        if (stat(child.c_str(), &st) != 0)
+            continue;
+        used += S_ISDIR(st.st_mode) ? 4096 + usedBytesIn(child) : (st.st_size + 4095) / 4096 * 4096;
+    }
+    closedir(dir);
+    return used;
+}
+
+size_t FS::usedBytesOnDisk()
+{
+    return m_mounted ? usedBytesIn(hostPath(m_area)) : 0;
+}
+
+#pragma endregion
+
+} // namespace fs
@@ -0,0 +1,317 @@
+#include "HTTPClient.h"
+
+#include <Arduino.h>
+
+#include "HostPlatform.h"
+
+#include <poll.h>
+#include <strings.h>
+
+HTTPClient::HTTPClient()
+    : m_client(NULL), m_port(80), m_userAgent("ESP32HTTPClient"), m_tcpTimeout(HTTPCLIENT_DEFAULT_TCP_TIMEOUT),
+      m_connectTimeout(HTTPCLIENT_DEFAULT_TCP_TIMEOUT), m_returnCode(0), m_size(-1), m_chunked(false)
+{
+}
+
+bool HTTPClient::begin(WiFiClient &client, String url)
+{
+    int scheme = url.indexOf("://");
+    if (scheme >= 0)
+    {
+        if (!url.substring(0, scheme).equalsIgnoreCase("http"))
+            return false;
+        url.remove(0, scheme + 3);
+    }
+
+    int slash = url.indexOf('/');
+    String host = (slash < 0) ? url : url.substring(0, slash);
+    String uri = (slash < 0) ? String("/") : url.substring(slash);
+    uint16_t port = 80;
+    int colon = host.indexOf(':');
+    if (colon >= 0)
+    {
+        port = host.substring(colon + 1).toInt();
+        host.remove(colon);
+    }
+    return begin(client, host, port, uri);
+}
+
+bool HTTPClient::begin(WiFiClient &client, String host, uint16_t port, String uri, bool https)
+{
+    if (https)
+        return false;
+    end();
+
+    std::string overrideHost = host.c_str();
+    if (hostEndpointOverride("HOST_HTTP", overrideHost, port))
+        host = overrideHost.c_str();
+
+    m_client = &client;
+    m_host = host;
+    m_port = port;
+    m_uri = uri;
+    m_headers = "";
+    return true;
+}
+
+void HTTPClient::end()
+{
+    if (m_client)
+        m_client->stop();
+    m_client = NULL;
+    m_returnCode = 0;
+    m_size = -1;
+    m_chunked = false;
+    for (RequestArgument &arg : m_collected)
+        arg.value = "";
+}
+
+void HTTPClient::addHeader(const String &name, const String &value, bool first, bool replace)
+{
+    (void)replace;
+    String line = name + ": " + value + "\r\n";
+    if (first)
+        m_headers = line + m_headers;
+    else
+        m_headers += line;
+}
+
+void HTTPClient::collectHeaders(const char *headerKeys[], const size_t headerKeysCount)
+{
+    m_collected.clear();
+    for (size_t i = 0; i < headerKeysCount; i++)
+        m_collected.push_back({headerKeys[i], ""});
+}
+
+String HTTPClient::header(const char *name)
+{
+    for (const RequestArgument &arg : m_collected)
+    {
+        if (arg.key.equalsIgnoreCase(name))
+            return arg.value;
+    }
+    return String();
+}
+
+String HTTPClient::header(size_t i)
+{
+    return (i < m_collected.size()) ? m_collected[i].value : String();
+}
+
+String HTTPClient::headerName(size_t i)
+{
+    return (i < m_collected.size()) ? m_collected[i].key : String();
+}
+
+bool HTTPClient::hasHeader(const char *name)
+{
+    return header(name).length() > 0;
+}
+
+int HTTPClient::GET()
+{
+    return sendRequest("GET");
+}
+
+int HTTPClient::returnError(int error)
+{
+    if (m_client)
+        m_client->stop();
+    return error;
+}
+
+int HTTPClient::sendRequest(const char *type, const uint8_t *payload, size_t size)
+{
+    if (!m_client)
+        return HTTPC_ERROR_NOT_CONNECTED;
+    if (!m_client->connect(m_host.c_str(), m_port, m_connectTimeout))
+        return returnError(HTTPC_ERROR_CONNECTION_REFUSED);
+
+    String request = String(type) + " " + m_uri + " HTTP/1.1\r\nHost: " + m_host;
+    if (m_port != 80)
+        request += ":" + String(m_port);
+    request += "\r\nUser-Agent: " + m_userAgent + "\r\nConnection: close\r\n";
+    request += "Accept-Encoding: identity;q=1,chunked;q=0.1,*;q=0\r\n";
+    if (m_authorization.length() > 0)
+        request += "Authorization: Basic " + m_authorization + "\r\n";
+    if (payload && size > 0)
+        request += "Content-Length: " + String((unsigned)size) + "\r\n";
+    request += m_headers + "\r\n";
+
+    if (m_client->write((const uint8_t *)request.c_str(), request.length()) != request.length())
+        return returnError(HTTPC_ERROR_SEND_HEADER_FAILED);
+    if (payload && size > 0 && m_client->write(payload, size) != size)
+        return returnError(HTTPC_ERROR_SEND_PAYLOAD_FAILED);
+
+    return handleHeaderResponse();
+}
+
+// waits up to the TCP timeout for each part of the response
+bool HTTPClient::readBytes(uint8_t *buf, size_t len)
+{
+    uint32_t start = millis();
+    while (len > 0)
+    {
+        int n = m_client->read(buf, len);
+        if (n < 0)
+            return false;
+        if (n == 0)
+        {
+            if (millis() - start > m_tcpTimeout)
+                return false;
+            pollfd pfd = {m_client->fd(), POLLIN, 0};
+            poll(&pfd, 1, 10);
+            continue;
+        }
+        buf += n;
+        len -= n;
+        start = millis();
+    }
+    return true;
+}
+
+bool HTTPClient::readLine(String &line)
+{
+    line = "";
+    for (;;)
+    {
+        uint8_t c;
+        if (!readBytes(&c, 1))
+            return false;
+        if (c == '\n')
+            break;
+        if (c != '\r')
+            line += (char)c;
+    }
+    return true;
+}
+
+int HTTPClient::handleHeaderResponse()
+{
+    m_size = -1;
+    m_chunked = false;
+    m_location = "";
+    for (RequestArgument &arg : m_collected)
+        arg.value = "";
+
+    String line;
+    if (!readLine(line))
+        return returnError(HTTPC_ERROR_READ_TIMEOUT);
+    if (!line.startsWith("HTTP/1."))
+        return returnError(HTTPC_ERROR_NO_HTTP_SERVER);
+    m_returnCode = line.substring(9, line.indexOf(' ', 9)).toInt();
+
+    while (readLine(line) && line.length() > 0)
+    {
+        int colon = line.indexOf(':');
+        if (colon < 0)
+            continue;
+        String name = line.substring(0, colon);
+        String value = line.substring(colon + 1);
+        value.trim();
+
+        if (name.equalsIgnoreCase("Content-Length"))
+            m_size = value.toInt();
+        else if (name.equalsIgnoreCase("Transfer-Encoding"))
+            m_chunked = value.equalsIgnoreCase("chunked");
+        else if (name.equalsIgnoreCase("Location"))
+            m_location = value;
+
+        for (RequestArgument &arg : m_collected)
+        {
+            if (arg.key.equalsIgnoreCase(name))
+                arg.value = (arg.value.length() > 0) ? arg.value + "," + value : value;
+        }
+    }
+    return (m_returnCode > 0) ? m_returnCode : returnError(HTTPC_ERROR_NO_HTTP_SERVER);
+}
+
+String HTTPClient::getString()
+{
+    String body;
+    if (!m_client)
+        return body;
+
+    uint8_t buf[1024];
+    if (m_chunked)
+    {
+        String line;
+        while (readLine(line))
+        {
+            long chunk = strtol(line.c_str(), NULL, 16);
+            if (chunk <= 0)
+                break;
+            while (chunk > 0)
+            {
+                size_t n = (chunk < (long)sizeof(buf)) ? chunk : sizeof(buf);
+                if (!readBytes(buf, n))
+                    return body;
+                body.concat((const char *)buf, n);
+                chunk -= n;
+            }
+            readLine(line); // the CRLF after the data
+        }
+    }
+    else if (m_size >= 0)
+    {
+        for (int left = m_size; left > 0;)
+        {
+            size_t n = (left < (int)sizeof(buf)) ? left : sizeof(buf);
+            if (!readBytes(buf, n))
+                break;
+            body.concat((const char *)buf, n);
+            left -= n;
+        }
+    }
+    else
+    {
+        // no length: the body ends when the server closes the connection
+        uint32_t start = millis();
+        while (millis() - start < m_tcpTimeout)
+        {
+            int n = m_client->read(buf, sizeof(buf));
+            if (n < 0)
+                break;
+            if (n == 0)
+            {
+                pollfd pfd = {m_client->fd(), POLLIN, 0};
+                poll(&pfd, 1, 10);
+                continue;
+            }
+            body.concat((const char *)buf, n);
+            start = millis();
+        }
+    }
+    return body;
+}
+
+String HTTPClient::errorToString(int error)
+{
+    switch (error)
+    {
+    case HTTPC_ERROR_CONNECTION_REFUSED:
+        return F("connection refused");
+    case HTTPC_ERROR_SEND_HEADER_FAILED:
+        return F("send header failed");
+    case HTTPC_ERROR_SEND_PAYLOAD_FAILED:
+        return F("send payload failed");
+    case HTTPC_ERROR_NOT_CONNECTED:
+        return F("not connected");
+    case HTTPC_ERROR_CONNECTION_LOST:
+        return F("connection lost");
+    case HTTPC_ERROR_NO_STREAM:
+        return F("no stream");
+    case HTTPC_ERROR_NO_HTTP_SERVER:
+        return F("no HTTP server");
+    case HTTPC_ERROR_TOO_LESS_RAM:
+        return F("too less ram");
+    case HTTPC_ERROR_ENCODING:
+        return F("Transfer-Encoding not supported");
+    case HTTPC_ERROR_STREAM_WRITE:
+        return F("Stream write error");
+    case HTTPC_ERROR_READ_TIMEOUT:
+        return F("read Timeout");
+    default:
+        return String();
+    }
+}
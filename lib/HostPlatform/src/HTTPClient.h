@@ -0,0 +1,117 @@
+#pragma once
+
+#include <vector>
+
+#include "WString.h"
+#include "WiFiClient.h"
+
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTPC_ERROR_SEND_HEADER_FAILED (-2)
+#define HTTPC_ERROR_SEND_PAYLOAD_FAILED (-3)
+#define HTTPC_ERROR_NOT_CONNECTED (-4)
+#define HTTPC_ERROR_CONNECTION_LOST (-5)
+#define HTTPC_ERROR_NO_STREAM (-6)
+#define HTTPC_ERROR_NO_HTTP_SERVER (-7)
+#define HTTPC_ERROR_TOO_LESS_RAM (-8)
+#define HTTPC_ERROR_ENCODING (-9)
+#define HTTPC_ERROR_STREAM_WRITE (-10)
+#define HTTPC_ERROR_READ_TIMEOUT (-11)
+
+#define HTTPCLIENT_DEFAULT_TCP_TIMEOUT (5000)
+
+typedef enum
+{
+    HTTP_CODE_CONTINUE = 100,
+    HTTP_CODE_OK = 200,
+    HTTP_CODE_CREATED = 201,
+    HTTP_CODE_ACCEPTED = 202,
+    HTTP_CODE_NO_CONTENT = 204,
+    HTTP_CODE_PARTIAL_CONTENT = 206,
+    HTTP_CODE_MOVED_PERMANENTLY = 301,
+    HTTP_CODE_FOUND = 302,
+    HTTP_CODE_SEE_OTHER = 303,
+    HTTP_CODE_NOT_MODIFIED = 304,
+    HTTP_CODE_TEMPORARY_REDIRECT = 307,
+    HTTP_CODE_PERMANENT_REDIRECT = 308,
+    HTTP_CODE_BAD_REQUEST = 400,
+    HTTP_CODE_UNAUTHORIZED = 401,
+    HTTP_CODE_FORBIDDEN = 403,
+    HTTP_CODE_NOT_FOUND = 404,
+    HTTP_CODE_METHOD_NOT_ALLOWED = 405,
+    HTTP_CODE_RANGE_NOT_SATISFIABLE = 416,
+    HTTP_CODE_INTERNAL_SERVER_ERROR = 500,
+    HTTP_CODE_NOT_IMPLEMENTED = 501,
+    HTTP_CODE_BAD_GATEWAY = 502,
+    HTTP_CODE_SERVICE_UNAVAILABLE = 503,
+    HTTP_CODE_GATEWAY_TIMEOUT = 504
+} t_http_codes;
+
+// Plain HTTP/1.1, one request per connection (Connection: close). HOST_HTTP ("host:port")
+// redirects every request, e.g. to the local tools/ota_server.py.
+class HTTPClient
+{
+public:
+    HTTPClient();
+    ~HTTPClient() { end(); }
+
+    bool begin(WiFiClient &client, String url);
+    bool begin(WiFiClient &client, String host, uint16_t port, String uri = "/", bool https = false);
+    void end();
+
+    void setUserAgent(const String &userAgent) { m_userAgent = userAgent; }
+    void setAuthorization(const char *auth) { m_authorization = auth; }
+    void setTimeout(uint16_t timeout) { m_tcpTimeout = timeout; }
+    void setConnectTimeout(int32_t connectTimeout) { m_connectTimeout = connectTimeout; }
+    void setReuse(bool reuse) { (void)reuse; }
+
+    void addHeader(const String &name, const String &value, bool first = false, bool replace = true);
+    void collectHeaders(const char *headerKeys[], const size_t headerKeysCount);
+    String header(const char *name);
+    String header(size_t i);
+    String headerName(size_t i);
+    int headers() { return m_collected.size(); }
+    bool hasHeader(const char *name);
+
+    int GET();
+    int POST(const String &payload) { return sendRequest("POST", (const uint8_t *)payload.c_str(), payload.length()); }
+    int POST(uint8_t *payload, size_t size) { return sendRequest("POST", payload, size); }
+    int PUT(const String &payload) { return sendRequest("PUT", (const uint8_t *)payload.c_str(), payload.length()); }
+    int sendRequest(const char *type, const uint8_t *payload = NULL, size_t size = 0);
+
+    int getSize() { return m_size; }
+    const String &getLocation() { return m_location; }
+    WiFiClient &getStream() { return *m_client; }
+    WiFiClient *getStreamPtr() { return connected() ? m_client : NULL; }
+    String getString();
+    bool connected() { return m_client && m_client->connected(); }
+
+    static String errorToString(int error);
+
+private:
+    struct RequestArgument
+    {
+        String key;
+        String value;
+    };
+
+    bool readLine(String &line);
+    bool readBytes(uint8_t *buf, size_t len);
+    int handleHeaderResponse();
+    int returnError(int error);
+
+    WiFiClient *m_client;
+    String m_host;
+    uint16_t m_port;
+    String m_uri;
+    String m_userAgent;
+    String m_authorization;
+    String m_headers;
+    uint16_t m_tcpTimeout;
+    int32_t m_connectTimeout;
+
+    std::vector<RequestArgument> m_collected;
+    int m_returnCode;
+    int m_size;
+    bool m_chunked;
+    String m_location;
+};
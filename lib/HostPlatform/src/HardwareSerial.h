@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Stream.h"
+
+// Serial is the terminal: output goes to stdout, input comes from stdin when there is some
+class HardwareSerial : public Stream
+{
+public:
+    explicit HardwareSerial(int uartNum) : m_uartNum(uartNum), m_peek(-1) {}
+
+    void begin(unsigned long baud, uint32_t config = 0, int8_t rxPin = -1, int8_t txPin = -1, bool invert = false,
+               unsigned long timeoutMs = 20000UL)
+    {
+        (void)baud, (void)config, (void)rxPin, (void)txPin, (void)invert, (void)timeoutMs;
+    }
+    void end() {}
+    void setDebugOutput(bool) {}
+
+    virtual int available();
+    virtual int read();
+    virtual int peek();
+    virtual size_t write(uint8_t c) { return write(&c, 1); }
+    virtual size_t write(const uint8_t *buffer, size_t size);
+    virtual int availableForWrite() { return 128; }
+    virtual void flush();
+
+    using Print::write;
+
+    operator bool() const { return true; }
+
+private:
+    int m_uartNum;
+    int m_peek;
+};
+
+extern HardwareSerial Serial;
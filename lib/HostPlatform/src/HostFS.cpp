@@ -0,0 +1,81 @@
+#include "LittleFS.h"
+#include "SD_MMC.h"
+
+#include "HostPlatform.h"
+
+#include <ftw.h>
+#include <stdio.h>
+
+#pragma region LittleFS
+
+LittleFSFS LittleFS;
+
+bool LittleFSFS::begin(bool formatOnFail, const char *basePath, uint8_t maxOpenFiles, const char *partitionLabel)
+{
+    (void)formatOnFail, (void)basePath, (void)maxOpenFiles, (void)partitionLabel;
+    return mount();
+}
+
+static int removeEntry(const char *path, const struct stat *st, int type, struct FTW *ftw)
+{
+    (void)st, (void)type;
+    // keeps the directory itself
+    return (ftw->level == 0) ? 0 : ::remove(path);
+}
+
+bool LittleFSFS::format()
+{
+    return nftw(hostPath(m_area).c_str(), removeEntry, 16, FTW_DEPTH | FTW_PHYS) == 0;
+}
+
+size_t LittleFSFS::totalBytes()
+{
+    return hostEnvInt("HOST_LITTLEFS_SIZE", 0x1E0000);
+}
+
+size_t LittleFSFS::usedBytes()
+{
+    return usedBytesOnDisk();
+}
+
+#pragma endregion
+
+#pragma region SD_MMC
+
+SDMMCFS SD_MMC;
+
+static uint64_t sdSize()
+{
+    return strtoull(hostEnv("HOST_SD_SIZE", "4294967296"), NULL, 0);
+}
+
+bool SDMMCFS::begin(const char *mountpoint, bool mode1bit, bool format_if_mount_failed, int sdmmc_frequency,
+                    uint8_t maxOpenFiles)
+{
+    (void)mountpoint, (void)mode1bit, (void)format_if_mount_failed, (void)sdmmc_frequency, (void)maxOpenFiles;
+    if (sdSize() == 0)
+        return false;
+    return mount();
+}
+
+sdcard_type_t SDMMCFS::cardType()
+{
+    return m_mounted ? CARD_SDHC : CARD_NONE;
+}
+
+uint64_t SDMMCFS::cardSize()
+{
+    return m_mounted ? sdSize() : 0;
+}
+
+uint64_t SDMMCFS::totalBytes()
+{
+    return cardSize();
+}
+
+uint64_t SDMMCFS::usedBytes()
+{
+    return usedBytesOnDisk();
+}
+
+#pragma endregion
@@ -0,0 +1,959 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "freertos/timers.h"
+
+#include "HostPlatform.h"
+#include "esp_timer.h"
+
+#include <errno.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <thread>
+#include <vector>
+
+#pragma region Time
+
+static const std::chrono::steady_clock::time_point s_boot = std::chrono::steady_clock::now();
+
+static uint64_t nowMicros()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - s_boot).count();
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(nowMicros() / 1000);
+}
+
+TickType_t xTaskGetTickCountFromISR(void)
+{
+    return xTaskGetTickCount();
+}
+
+extern "C" unsigned long millis(void)
+{
+    return (unsigned long)(uint32_t)(nowMicros() / 1000);
+}
+
+extern "C" unsigned long micros(void)
+{
+    return (unsigned long)(uint32_t)nowMicros();
+}
+
+extern "C" int64_t esp_timer_get_time(void)
+{
+    return (int64_t)nowMicros();
+}
+
+// waits on cv until pred or the ticks run out, portMAX_DELAY waits for ever
+template <typename Pred>
+static bool waitTicks(std::condition_variable &cv, std::unique_lock<std::mutex> &lock, TickType_t ticks, Pred pred)
+{
+    if (ticks == portMAX_DELAY)
+    {
+        cv.wait(lock, pred);
+        return true;
+    }
+    return cv.wait_for(lock, std::chrono::milliseconds(pdTICKS_TO_MS(ticks)), pred);
+}
+
+void vTaskDelay(const TickType_t xTicksToDelay)
+{
+    uint64_t ms = pdTICKS_TO_MS(xTicksToDelay);
+    if (ms == 0)
+    {
+        sched_yield();
+        return;
+    }
+    timespec ts = {(time_t)(ms / 1000), (long)(ms % 1000) * 1000000};
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR)
+        ;
+}
+
+BaseType_t xTaskDelayUntil(TickType_t *pxPreviousWakeTime, const TickType_t xTimeIncrement)
+{
+    TickType_t wake = *pxPreviousWakeTime + xTimeIncrement;
+    TickType_t now = xTaskGetTickCount();
+    *pxPreviousWakeTime = wake;
+    if ((int32_t)(wake - now) <= 0)
+        return pdFALSE;
+    vTaskDelay(wake - now);
+    return pdTRUE;
+}
+
+void vTaskDelayUntil(TickType_t *pxPreviousWakeTime, const TickType_t xTimeIncrement)
+{
+    xTaskDelayUntil(pxPreviousWakeTime, xTimeIncrement);
+}
+
+void vTaskYield(void)
+{
+    sched_yield();
+}
+
+#pragma endregion
+
+#pragma region Critical Sections
+
+void vPortCPUInitializeMutex(portMUX_TYPE *mux)
+{
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&mux->mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+void vPortEnterCritical(portMUX_TYPE *mux)
+{
+    pthread_mutex_lock(&mux->mutex);
+}
+
+void vPortExitCritical(portMUX_TYPE *mux)
+{
+    pthread_mutex_unlock(&mux->mutex);
+}
+
+#pragma endregion
+
+#pragma region Tasks
+
+#define STACK_PAINT 0xa5
+
+struct HostTask
+{
+    char name[configMAX_TASK_NAME_LEN];
+    std::function<void()> body;
+    UBaseType_t number;
+    UBaseType_t priority;
+    BaseType_t core;
+    uint8_t *stack; // lowest address, a guard page below it
+    size_t stackSize;
+    pthread_t thread;
+    bool deleted;
+
+    std::mutex notifyMutex;
+    std::condition_variable notifyCv;
+    uint32_t notifyValue;
+    bool notifyPending;
+};
+
+static std::mutex s_tasksMutex;
+static std::vector<HostTask *> s_tasks;
+static std::vector<HostTask *> s_deletedTasks; // their threads may still be unwinding
+static UBaseType_t s_taskNumber = 0;
+static thread_local HostTask *t_currentTask = NULL;
+
+// frees the stacks of deleted tasks whose threads have finished; holds s_tasksMutex
+static void reapDeletedTasks()
+{
+    for (size_t i = 0; i < s_deletedTasks.size();)
+    {
+        HostTask *task = s_deletedTasks[i];
+        if (pthread_tryjoin_np(task->thread, NULL) != 0)
+        {
+            i++;
+            continue;
+        }
+        munmap(task->stack - getpagesize(), task->stackSize + getpagesize());
+        delete task;
+        s_deletedTasks.erase(s_deletedTasks.begin() + i);
+    }
+}
+
+// Paints the stack; reading it back races with the task and may touch sanitizer redzones,
+// which is the point, so neither sanitizer looks at these two
+__attribute__((no_sanitize("address", "thread"))) static void paintStack(uint8_t *stack, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+        ((volatile uint8_t *)stack)[i] = STACK_PAINT;
+}
+
+__attribute__((no_sanitize("address", "thread"))) static uint32_t stackHighWaterMark(const HostTask *task)
+{
+    size_t untouched = 0;
+    while (untouched < task->stackSize && ((volatile uint8_t *)task->stack)[untouched] == STACK_PAINT)
+        untouched++;
+    return (uint32_t)untouched;
+}
+
+static void *taskEntry(void *arg)
+{
+    HostTask *task = (HostTask *)arg;
+    t_currentTask = task;
+    task->body();
+    vTaskDelete(NULL); // host side bodies may simply return
+    return NULL;
+}
+
+static TaskHandle_t startTask(const char *name, uint32_t stackDepth, UBaseType_t priority, BaseType_t core,
+                              std::function<void()> body)
+{
+    static const long scale = hostEnvInt("HOST_STACK_SCALE", 4);
+    size_t page = getpagesize();
+    size_t size = std::max<size_t>((size_t)stackDepth * scale, 64 * 1024);
+    size = (size + page - 1) / page * page;
+
+    uint8_t *mapping = (uint8_t *)mmap(NULL, size + page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK,
+                                       -1, 0);
+    if (mapping == MAP_FAILED)
+        return NULL;
+    mprotect(mapping, page, PROT_NONE); // overflow faults instead of corrupting the neighbour
+
+    HostTask *task = new HostTask();
+    strncpy(task->name, name ? name : "", sizeof(task->name) - 1);
+    task->body = body;
+    task->priority = priority;
+    task->core = core;
+    task->stack = mapping + page;
+    task->stackSize = size;
+    task->deleted = false;
+    task->notifyValue = 0;
+    task->notifyPending = false;
+    paintStack(task->stack, size);
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, task->stack, size);
+
+    std::lock_guard<std::mutex> lock(s_tasksMutex);
+    reapDeletedTasks();
+    task->number = ++s_taskNumber;
+    if (pthread_create(&task->thread, &attr, taskEntry, task) != 0)
+    {
+        pthread_attr_destroy(&attr);
+        munmap(mapping, size + page);
+        delete task;
+        return NULL;
+    }
+    pthread_attr_destroy(&attr);
+    pthread_setname_np(task->thread, task->name);
+    s_tasks.push_back(task);
+    return task;
+}
+
+TaskHandle_t hostTaskStart(const char *name, uint32_t stackDepth, UBaseType_t priority, std::function<void()> body)
+{
+    return startTask(name, stackDepth, priority, tskNO_AFFINITY, body);
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t pvTaskCode, const char *pcName, uint32_t usStackDepth,
+                                   void *pvParameters, UBaseType_t uxPriority, TaskHandle_t *pvCreatedTask,
+                                   BaseType_t xCoreID)
+{
+    std::string name = pcName ? pcName : "";
+    TaskHandle_t task = startTask(pcName, usStackDepth, uxPriority, xCoreID, [pvTaskCode, pvParameters, name]() {
+        pvTaskCode(pvParameters);
+        // as ESP-IDF does: a task function must delete itself rather than return
+        fprintf(stderr, "task %s returned from its function\n", name.c_str());
+        abort();
+    });
+    if (pvCreatedTask)
+        *pvCreatedTask = task;
+    return task ? pdPASS : errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t pvTaskCode, const char *pcName, uint32_t usStackDepth, void *pvParameters,
+                       UBaseType_t uxPriority, TaskHandle_t *pvCreatedTask)
+{
+    return xTaskCreatePinnedToCore(pvTaskCode, pcName, usStackDepth, pvParameters, uxPriority, pvCreatedTask,
+                                   tskNO_AFFINITY);
+}
+
+// Deleting another task cancels its thread, which only stops at a blocking call (delays,
+// waits, socket reads); FreeRTOS would stop it wherever it is
+void vTaskDelete(TaskHandle_t xTaskToDelete)
+{
+    HostTask *task = xTaskToDelete ? xTaskToDelete : t_currentTask;
+    if (task == NULL)
+        pthread_exit(NULL); // not a task, e.g. the main thread
+
+    {
+        std::lock_guard<std::mutex> lock(s_tasksMutex);
+        std::vector<HostTask *>::iterator it = std::find(s_tasks.begin(), s_tasks.end(), task);
+        if (it == s_tasks.end() || task->deleted)
+            return;
+        s_tasks.erase(it);
+        task->deleted = true;
+        s_deletedTasks.push_back(task);
+    }
+
+    if (task == t_currentTask)
+        pthread_exit(NULL);
+    pthread_cancel(task->thread);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return t_currentTask;
+}
+
+TaskHandle_t xTaskGetHandle(const char *pcNameToQuery)
+{
+    std::lock_guard<std::mutex> lock(s_tasksMutex);
+    for (size_t i = 0; i < s_tasks.size(); i++)
+        if (strcmp(s_tasks[i]->name, pcNameToQuery) == 0)
+            return s_tasks[i];
+    return NULL;
+}
+
+char *pcTaskGetName(TaskHandle_t xTaskToQuery)
+{
+    static char noTask[] = "";
+    HostTask *task = xTaskToQuery ? xTaskToQuery : t_currentTask;
+    return task ? task->name : noTask;
+}
+
+UBaseType_t uxTaskPriorityGet(TaskHandle_t xTask)
+{
+    HostTask *task = xTask ? xTask : t_currentTask;
+    return task ? task->priority : tskIDLE_PRIORITY;
+}
+
+void vTaskPrioritySet(TaskHandle_t xTask, UBaseType_t uxNewPriority)
+{
+    HostTask *task = xTask ? xTask : t_currentTask;
+    if (task)
+        task->priority = uxNewPriority;
+}
+
+BaseType_t xTaskGetAffinity(TaskHandle_t xTask)
+{
+    HostTask *task = xTask ? xTask : t_currentTask;
+    return task ? task->core : tskNO_AFFINITY;
+}
+
+BaseType_t xPortGetCoreID(void)
+{
+    // a task pinned to core 1 sees core 1, everything else runs "on" core 0
+    return (t_currentTask && t_currentTask->core == 1) ? 1 : 0;
+}
+
+eTaskState eTaskGetState(TaskHandle_t xTask)
+{
+    std::lock_guard<std::mutex> lock(s_tasksMutex);
+    if (std::find(s_tasks.begin(), s_tasks.end(), xTask) == s_tasks.end())
+        return eDeleted;
+    return (xTask == t_currentTask) ? eRunning : eReady;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t xTask)
+{
+    HostTask *task = xTask ? xTask : t_currentTask;
+    return task ? stackHighWaterMark(task) : 0;
+}
+
+UBaseType_t uxTaskGetNumberOfTasks(void)
+{
+    std::lock_guard<std::mutex> lock(s_tasksMutex);
+    return s_tasks.size();
+}
+
+UBaseType_t uxTaskGetSystemState(TaskStatus_t *const pxTaskStatusArray, const UBaseType_t uxArraySize,
+                                 uint32_t *const pulTotalRunTime)
+{
+    std::lock_guard<std::mutex> lock(s_tasksMutex);
+    if (pulTotalRunTime)
+        *pulTotalRunTime = 0;
+    if (s_tasks.size() > uxArraySize)
+        return 0;
+
+    for (size_t i = 0; i < s_tasks.size(); i++)
+    {
+        HostTask *task = s_tasks[i];
+        TaskStatus_t &status = pxTaskStatusArray[i];
+        status.xHandle = task;
+        status.pcTaskName = task->name;
+        status.xTaskNumber = task->number;
+        status.eCurrentState = (task == t_currentTask) ? eRunning : eReady;
+        status.uxCurrentPriority = task->priority;
+        status.uxBasePriority = task->priority;
+        status.ulRunTimeCounter = 0;
+        status.pxStackBase = task->stack;
+        status.usStackHighWaterMark = stackHighWaterMark(task);
+        status.xCoreID = task->core;
+    }
+    return s_tasks.size();
+}
+
+#pragma endregion
+
+#pragma region Task Notifications
+
+BaseType_t xTaskNotify(TaskHandle_t xTaskToNotify, uint32_t ulValue, eNotifyAction eAction)
+{
+    HostTask *task = xTaskToNotify;
+    std::lock_guard<std::mutex> lock(task->notifyMutex);
+    BaseType_t result = pdPASS;
+    switch (eAction)
+    {
+    case eSetBits:
+        task->notifyValue |= ulValue;
+        break;
+    case eIncrement:
+        task->notifyValue++;
+        break;
+    case eSetValueWithOverwrite:
+        task->notifyValue = ulValue;
+        break;
+    case eSetValueWithoutOverwrite:
+        if (task->notifyPending)
+            result = pdFAIL;
+        else
+            task->notifyValue = ulValue;
+        break;
+    default:
+        break;
+    }
+    task->notifyPending = true;
+    task->notifyCv.notify_all();
+    return result;
+}
+
+BaseType_t xTaskNotifyFromISR(TaskHandle_t xTaskToNotify, uint32_t ulValue, eNotifyAction eAction,
+                              BaseType_t *pxHigherPriorityTaskWoken)
+{
+    if (pxHigherPriorityTaskWoken)
+        *pxHigherPriorityTaskWoken = pdFALSE;
+    return xTaskNotify(xTaskToNotify, ulValue, eAction);
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t xTaskToNotify)
+{
+    return xTaskNotify(xTaskToNotify, 0, eIncrement);
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify, BaseType_t *pxHigherPriorityTaskWoken)
+{
+    xTaskNotifyFromISR(xTaskToNotify, 0, eIncrement, pxHigherPriorityTaskWoken);
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait)
+{
+    HostTask *task = t_currentTask;
+    configASSERT(task != NULL);
+    std::unique_lock<std::mutex> lock(task->notifyMutex);
+    waitTicks(task->notifyCv, lock, xTicksToWait, [task] { return task->notifyValue != 0; });
+    uint32_t value = task->notifyValue;
+    if (value != 0)
+        task->notifyValue = xClearCountOnExit ? 0 : value - 1;
+    task->notifyPending = false;
+    return value;
+}
+
+BaseType_t xTaskNotifyWait(uint32_t ulBitsToClearOnEntry, uint32_t ulBitsToClearOnExit, uint32_t *pulNotificationValue,
+                           TickType_t xTicksToWait)
+{
+    HostTask *task = t_currentTask;
+    configASSERT(task != NULL);
+    std::unique_lock<std::mutex> lock(task->notifyMutex);
+    if (!task->notifyPending)
+        task->notifyValue &= ~ulBitsToClearOnEntry;
+    bool notified = waitTicks(task->notifyCv, lock, xTicksToWait, [task] { return task->notifyPending; });
+    if (pulNotificationValue)
+        *pulNotificationValue = task->notifyValue;
+    if (notified)
+        task->notifyValue &= ~ulBitsToClearOnExit;
+    task->notifyPending = false;
+    return notified ? pdTRUE : pdFALSE;
+}
+
+#pragma endregion
+
+#pragma region Timers
+
+struct HostTimer
+{
+    std::string name;
+    TickType_t period;
+    bool autoReload;
+    void *id;
+    TimerCallbackFunction_t callback;
+    PendedFunction_t pended; // xTimerPendFunctionCall() jobs are one-shot timers with this set
+    void *pendedParam1;
+    uint32_t pendedParam2;
+
+    bool active;
+    bool running; // with a worker right now
+    bool deleted;
+    uint64_t dueUs;
+};
+
+static std::mutex s_timerMutex;
+static std::condition_variable s_timerCv;      // the service thread waits for the next expiry on this
+static std::condition_variable s_timerWorkCv;  // and the workers for expired timers
+static std::multimap<uint64_t, HostTimer *> s_timerQueue;
+static std::deque<HostTimer *> s_timerWork;
+static std::vector<HostTimer *> s_timers;
+static bool s_timerServiceStarted = false;
+
+static void timerSchedule(HostTimer *timer, uint64_t dueUs)
+{
+    for (std::multimap<uint64_t, HostTimer *>::iterator it = s_timerQueue.begin(); it != s_timerQueue.end(); ++it)
+    {
+        if (it->second == timer)
+        {
+            s_timerQueue.erase(it);
+            break;
+        }
+    }
+    timer->dueUs = dueUs;
+    if (timer->active)
+        s_timerQueue.insert(std::make_pair(dueUs, timer));
+    s_timerCv.notify_all();
+}
+
+static void timerService()
+{
+    std::unique_lock<std::mutex> lock(s_timerMutex);
+    while (true)
+    {
+        if (s_timerQueue.empty())
+        {
+            s_timerCv.wait(lock);
+            continue;
+        }
+
+        uint64_t now = nowMicros();
+        std::multimap<uint64_t, HostTimer *>::iterator first = s_timerQueue.begin();
+        if (first->first > now)
+        {
+            s_timerCv.wait_for(lock, std::chrono::microseconds(first->first - now));
+            continue;
+        }
+
+        HostTimer *timer = first->second;
+        s_timerQueue.erase(first);
+        if (timer->running)
+        {
+            // still busy with the last expiry, this one is missed
+            if (timer->autoReload)
+                timerSchedule(timer, now + timer->period * 1000ULL);
+            else
+                timer->active = false;
+            continue;
+        }
+
+        if (timer->autoReload)
+        {
+            uint64_t next = timer->dueUs + timer->period * 1000ULL;
+            timerSchedule(timer, (next > now) ? next : now + timer->period * 1000ULL);
+        }
+        else
+            timer->active = false;
+        timer->running = true;
+        s_timerWork.push_back(timer);
+        s_timerWorkCv.notify_one();
+    }
+}
+
+static void timerWorker()
+{
+    std::unique_lock<std::mutex> lock(s_timerMutex);
+    while (true)
+    {
+        s_timerWorkCv.wait(lock, [] { return !s_timerWork.empty(); });
+        HostTimer *timer = s_timerWork.front();
+        s_timerWork.pop_front();
+
+        lock.unlock();
+        if (timer->pended)
+            timer->pended(timer->pendedParam1, timer->pendedParam2);
+        else
+            timer->callback(timer);
+        lock.lock();
+
+        timer->running = false;
+        if (timer->deleted || timer->pended)
+        {
+            s_timers.erase(std::find(s_timers.begin(), s_timers.end(), timer));
+            delete timer;
+        }
+    }
+}
+
+// holds s_timerMutex
+static void startTimerService()
+{
+    if (s_timerServiceStarted)
+        return;
+    s_timerServiceStarted = true;
+
+    std::thread(timerService).detach();
+    long workers = std::max(1L, hostEnvInt("HOST_TIMER_THREADS", 1));
+    for (long i = 0; i < workers; i++)
+        hostTaskStart("Tmr Svc", 4096, configMAX_PRIORITIES - 1, timerWorker);
+}
+
+TimerHandle_t xTimerCreate(const char *pcTimerName, const TickType_t xTimerPeriodInTicks, const UBaseType_t uxAutoReload,
+                           void *const pvTimerID, TimerCallbackFunction_t pxCallbackFunction)
+{
+    if (xTimerPeriodInTicks == 0)
+        return NULL;
+
+    HostTimer *timer = new HostTimer();
+    timer->name = pcTimerName ? pcTimerName : "";
+    timer->period = xTimerPeriodInTicks;
+    timer->autoReload = uxAutoReload != pdFALSE;
+    timer->id = pvTimerID;
+    timer->callback = pxCallbackFunction;
+    timer->pended = NULL;
+    timer->active = false;
+    timer->running = false;
+    timer->deleted = false;
+    timer->dueUs = 0;
+
+    std::lock_guard<std::mutex> lock(s_timerMutex);
+    startTimerService();
+    s_timers.push_back(timer);
+    return timer;
+}
+
+BaseType_t xTimerStart(TimerHandle_t xTimer, TickType_t xTicksToWait)
+{
+    (void)xTicksToWait;
+    if (xTimer == NULL)
+        return pdFAIL;
+    std::lock_guard<std::mutex> lock(s_timerMutex);
+    xTimer->active = true;
+    timerSchedule(xTimer, nowMicros() + xTimer->period * 1000ULL);
+    return pdPASS;
+}
+
+BaseType_t xTimerReset(TimerHandle_t xTimer, TickType_t xTicksToWait)
+{
+    return xTimerStart(xTimer, xTicksToWait);
+}
+
+BaseType_t xTimerStop(TimerHandle_t xTimer, TickType_t xTicksToWait)
+{
+    (void)xTicksToWait;
+    if (xTimer == NULL)
+        return pdFAIL;
+    std::lock_guard<std::mutex> lock(s_timerMutex);
+    xTimer->active = false;
+    timerSchedule(xTimer, 0);
+    return pdPASS;
+}
+
+BaseType_t xTimerChangePeriod(TimerHandle_t xTimer, TickType_t xNewPeriod, TickType_t xTicksToWait)
+{
+    if (xTimer == NULL || xNewPeriod == 0)
+        return pdFAIL;
+    {
+        std::lock_guard<std::mutex> lock(s_timerMutex);
+        xTimer->period = xNewPeriod;
+    }
+    return xTimerStart(xTimer, xTicksToWait); // as in FreeRTOS, a dormant timer starts
+}
+
+BaseType_t xTimerDelete(TimerHandle_t xTimer, TickType_t xTicksToWait)
+{
+    (void)xTicksToWait;
+    if (xTimer == NULL)
+        return pdFAIL;
+    std::lock_guard<std::mutex> lock(s_timerMutex);
+    xTimer->active = false;
+    timerSchedule(xTimer, 0);
+    if (xTimer->running)
+        xTimer->deleted = true; // the worker frees it
+    else
+    {
+        s_timers.erase(std::find(s_timers.begin(), s_timers.end(), xTimer));
+        delete xTimer;
+    }
+    return pdPASS;
+}
+
+BaseType_t xTimerIsTimerActive(TimerHandle_t xTimer)
+{
+    std::lock_guard<std::mutex> lock(s_timerMutex);
+    return xTimer->active ? pdTRUE : pdFALSE;
+}
+
+void *pvTimerGetTimerID(const TimerHandle_t xTimer)
+{
+    std::lock_guard<std::mutex> lock(s_timerMutex);
+    return xTimer->id;
+}
+
+void vTimerSetTimerID(TimerHandle_t xTimer, void *pvNewID)
+{
+    std::lock_guard<std::mutex> lock(s_timerMutex);
+    xTimer->id = pvNewID;
+}
+
+const char *pcTimerGetName(TimerHandle_t xTimer)
+{
+    return xTimer->name.c_str();
+}
+
+TickType_t xTimerGetPeriod(TimerHandle_t xTimer)
+{
+    std::lock_guard<std::mutex> lock(s_timerMutex);
+    return xTimer->period;
+}
+
+TickType_t xTimerGetExpiryTime(TimerHandle_t xTimer)
+{
+    std::lock_guard<std::mutex> lock(s_timerMutex);
+    return (TickType_t)(xTimer->dueUs / 1000);
+}
+
+BaseType_t xTimerPendFunctionCall(PendedFunction_t xFunctionToPend, void *pvParameter1, uint32_t ulParameter2,
+                                  TickType_t xTicksToWait)
+{
+    (void)xTicksToWait;
+    HostTimer *job = new HostTimer();
+    job->name = "pended";
+    job->period = 1;
+    job->autoReload = false;
+    job->id = NULL;
+    job->callback = NULL;
+    job->pended = xFunctionToPend;
+    job->pendedParam1 = pvParameter1;
+    job->pendedParam2 = ulParameter2;
+    job->active = false;
+    job->running = true;
+    job->deleted = false;
+    job->dueUs = 0;
+
+    std::lock_guard<std::mutex> lock(s_timerMutex);
+    startTimerService();
+    s_timers.push_back(job);
+    s_timerWork.push_back(job);
+    s_timerWorkCv.notify_one();
+    return pdPASS;
+}
+
+#pragma endregion
+
+#pragma region Queues and Semaphores
+
+enum HostQueueKind
+{
+    QUEUE_ITEMS,
+    QUEUE_SEMAPHORE,
+    QUEUE_MUTEX,
+    QUEUE_RECURSIVE_MUTEX
+};
+
+struct HostQueue
+{
+    HostQueueKind kind;
+    UBaseType_t length;
+    UBaseType_t itemSize;
+    std::deque<std::vector<uint8_t> > items;
+    UBaseType_t count; // semaphores and mutexes
+    TaskHandle_t holder;
+    pthread_t holderThread; // mutexes can be taken outside of tasks too
+    UBaseType_t depth;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+};
+
+static HostQueue *newQueue(HostQueueKind kind, UBaseType_t length, UBaseType_t itemSize, UBaseType_t count)
+{
+    HostQueue *q = new HostQueue();
+    q->kind = kind;
+    q->length = length;
+    q->itemSize = itemSize;
+    q->count = count;
+    q->holder = NULL;
+    q->holderThread = 0;
+    q->depth = 0;
+    return q;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t uxQueueLength, UBaseType_t uxItemSize)
+{
+    if (uxQueueLength == 0)
+        return NULL;
+    return newQueue(QUEUE_ITEMS, uxQueueLength, uxItemSize, 0);
+}
+
+void vQueueDelete(QueueHandle_t xQueue)
+{
+    delete xQueue;
+}
+
+static BaseType_t queueSend(QueueHandle_t q, const void *item, TickType_t ticks, bool front, bool overwrite)
+{
+    std::unique_lock<std::mutex> lock(q->mutex);
+    if (overwrite && q->items.size() >= q->length)
+        q->items.pop_front();
+    if (!waitTicks(q->cv, lock, ticks, [q] { return q->items.size() < q->length; }))
+        return errQUEUE_FULL;
+
+    std::vector<uint8_t> copy((const uint8_t *)item, (const uint8_t *)item + q->itemSize);
+    if (front)
+        q->items.push_front(copy);
+    else
+        q->items.push_back(copy);
+    q->cv.notify_all();
+    return pdPASS;
+}
+
+BaseType_t xQueueSendToBack(QueueHandle_t xQueue, const void *pvItemToQueue, TickType_t xTicksToWait)
+{
+    return queueSend(xQueue, pvItemToQueue, xTicksToWait, false, false);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t xQueue, const void *pvItemToQueue, TickType_t xTicksToWait)
+{
+    return queueSend(xQueue, pvItemToQueue, xTicksToWait, true, false);
+}
+
+BaseType_t xQueueOverwrite(QueueHandle_t xQueue, const void *pvItemToQueue)
+{
+    return queueSend(xQueue, pvItemToQueue, 0, false, true);
+}
+
+static BaseType_t queueReceive(QueueHandle_t q, void *buffer, TickType_t ticks, bool remove)
+{
+    std::unique_lock<std::mutex> lock(q->mutex);
+    if (!waitTicks(q->cv, lock, ticks, [q] { return !q->items.empty(); }))
+        return errQUEUE_EMPTY;
+
+    memcpy(buffer, q->items.front().data(), q->itemSize);
+    if (remove)
+    {
+        q->items.pop_front();
+        q->cv.notify_all();
+    }
+    return pdPASS;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void *pvBuffer, TickType_t xTicksToWait)
+{
+    return queueReceive(xQueue, pvBuffer, xTicksToWait, true);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t xQueue, void *pvBuffer, TickType_t xTicksToWait)
+{
+    return queueReceive(xQueue, pvBuffer, xTicksToWait, false);
+}
+
+UBaseType_t uxQueueMessagesWaiting(const QueueHandle_t xQueue)
+{
+    std::lock_guard<std::mutex> lock(xQueue->mutex);
+    return (xQueue->kind == QUEUE_ITEMS) ? xQueue->items.size() : xQueue->count;
+}
+
+UBaseType_t uxQueueSpacesAvailable(const QueueHandle_t xQueue)
+{
+    std::lock_guard<std::mutex> lock(xQueue->mutex);
+    return xQueue->length - ((xQueue->kind == QUEUE_ITEMS) ? xQueue->items.size() : xQueue->count);
+}
+
+BaseType_t xQueueReset(QueueHandle_t xQueue)
+{
+    std::lock_guard<std::mutex> lock(xQueue->mutex);
+    xQueue->items.clear();
+    xQueue->cv.notify_all();
+    return pdPASS;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return newQueue(QUEUE_SEMAPHORE, 1, 0, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t uxMaxCount, UBaseType_t uxInitialCount)
+{
+    return newQueue(QUEUE_SEMAPHORE, uxMaxCount, 0, uxInitialCount);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return newQueue(QUEUE_MUTEX, 1, 0, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void)
+{
+    return newQueue(QUEUE_RECURSIVE_MUTEX, 1, 0, 1);
+}
+
+static bool holdsMutex(SemaphoreHandle_t s)
+{
+    return s->count == 0 && pthread_equal(s->holderThread, pthread_self());
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t xSemaphore, TickType_t xBlockTime)
+{
+    SemaphoreHandle_t s = xSemaphore;
+    std::unique_lock<std::mutex> lock(s->mutex);
+    if (s->kind == QUEUE_RECURSIVE_MUTEX && holdsMutex(s))
+    {
+        s->depth++;
+        return pdTRUE;
+    }
+    if (!waitTicks(s->cv, lock, xBlockTime, [s] { return s->count > 0; }))
+        return pdFALSE;
+    s->count--;
+    if (s->kind == QUEUE_MUTEX || s->kind == QUEUE_RECURSIVE_MUTEX)
+    {
+        s->holder = t_currentTask;
+        s->holderThread = pthread_self();
+        s->depth = 1;
+    }
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t xSemaphore)
+{
+    SemaphoreHandle_t s = xSemaphore;
+    std::lock_guard<std::mutex> lock(s->mutex);
+    if (s->kind == QUEUE_MUTEX || s->kind == QUEUE_RECURSIVE_MUTEX)
+    {
+        if (!holdsMutex(s))
+            return pdFALSE; // only the holder may give a mutex
+        if (--s->depth > 0)
+            return pdTRUE;
+        s->holder = NULL;
+        s->holderThread = 0;
+    }
+    else if (s->count >= s->length)
+        return pdFALSE;
+    s->count++;
+    s->cv.notify_all();
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t xMutex, TickType_t xBlockTime)
+{
+    return xSemaphoreTake(xMutex, xBlockTime);
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t xMutex)
+{
+    return xSemaphoreGive(xMutex);
+}
+
+UBaseType_t uxSemaphoreGetCount(SemaphoreHandle_t xSemaphore)
+{
+    std::lock_guard<std::mutex> lock(xSemaphore->mutex);
+    return xSemaphore->count;
+}
+
+TaskHandle_t xSemaphoreGetMutexHolder(SemaphoreHandle_t xMutex)
+{
+    std::lock_guard<std::mutex> lock(xMutex->mutex);
+    return xMutex->holder;
+}
+
+#pragma endregion
@@ -0,0 +1,330 @@
+#include "HostPlatform.h"
+
+#include <Arduino.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <malloc.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#pragma region Settings and Paths
+
+const char *hostEnv(const char *name, const char *fallback)
+{
+    const char *value = getenv(name);
+    return (value && *value) ? value : fallback;
+}
+
+long hostEnvInt(const char *name, long fallback)
+{
+    const char *value = getenv(name);
+    if (!value || !*value)
+        return fallback;
+    return strtol(value, NULL, 0);
+}
+
+const char *hostRoot()
+{
+    static std::string root;
+    static std::once_flag once;
+    std::call_once(once, []() {
+        root = hostEnv("HOST_ROOT", "./host_data");
+        mkdir(root.c_str(), 0755);
+    });
+    return root.c_str();
+}
+
+std::string hostPath(const char *area, const char *path)
+{
+    std::string dir = std::string(hostRoot()) + "/" + area;
+    mkdir(dir.c_str(), 0755);
+    if (path == NULL || *path == '\0')
+        return dir;
+    return dir + (path[0] == '/' ? "" : "/") + path;
+}
+
+uint16_t hostListenPort(uint16_t port)
+{
+    if (port >= 1024)
+        return port;
+    return port + hostEnvInt("HOST_PORT_OFFSET", 8000);
+}
+
+bool hostEndpointOverride(const char *envName, std::string &host, uint16_t &port)
+{
+    const char *value = getenv(envName);
+    if (!value || !*value)
+        return false;
+
+    const char *colon = strrchr(value, ':');
+    if (colon)
+    {
+        host.assign(value, colon - value);
+        port = (uint16_t)atoi(colon + 1);
+    }
+    else
+        host = value;
+    return true;
+}
+
+std::recursive_mutex &hostAsyncTcpMutex()
+{
+    static std::recursive_mutex mutex;
+    return mutex;
+}
+
+#if defined(__GLIBC__) && !__GLIBC_PREREQ(2, 38)
+extern "C" size_t strlcpy(char *dst, const char *src, size_t size)
+{
+    size_t len = strlen(src);
+    if (size > 0)
+    {
+        size_t n = (len < size - 1) ? len : size - 1;
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return len;
+}
+
+extern "C" size_t strlcat(char *dst, const char *src, size_t size)
+{
+    size_t used = strnlen(dst, size);
+    if (used == size)
+        return size + strlen(src);
+    return used + strlcpy(dst + used, src, size - used);
+}
+#endif
+
+#pragma endregion
+
+#pragma region RTC Memory
+
+// The linker brackets the RTC_DATA_ATTR section with these; they are NULL when the app has no
+// RTC variables
+extern "C" char __start_host_rtc_data[] __attribute__((weak));
+extern "C" char __stop_host_rtc_data[] __attribute__((weak));
+
+static std::string rtcMemoryPath()
+{
+    return std::string(hostRoot()) + "/rtc_memory.bin";
+}
+
+static size_t rtcMemorySize()
+{
+    if (__start_host_rtc_data == NULL || __stop_host_rtc_data == NULL)
+        return 0;
+    return __stop_host_rtc_data - __start_host_rtc_data;
+}
+
+// the section may hold sanitizer redzones between the variables, copy it as raw bytes
+__attribute__((no_sanitize("address"))) static void rtcMemoryCopy(char *dst, const char *src, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+        ((volatile char *)dst)[i] = src[i];
+}
+
+static void rtcMemorySave()
+{
+    size_t size = rtcMemorySize();
+    if (size == 0)
+        return;
+
+    std::string image(size, '\0');
+    rtcMemoryCopy(&image[0], __start_host_rtc_data, size);
+    FILE *f = fopen(rtcMemoryPath().c_str(), "wbe");
+    if (f)
+    {
+        fwrite(image.data(), 1, size, f);
+        fclose(f);
+    }
+}
+
+// only after a reset that keeps RTC memory, and only into a layout of the same size (an update
+// that adds RTC variables starts them from their initial values)
+static void rtcMemoryRestore()
+{
+    size_t size = rtcMemorySize();
+    if (size == 0)
+        return;
+
+    FILE *f = fopen(rtcMemoryPath().c_str(), "rbe");
+    if (!f)
+        return;
+    std::string image(size + 1, '\0');
+    size_t n = fread(&image[0], 1, size + 1, f);
+    fclose(f);
+    if (n == size)
+        rtcMemoryCopy(__start_host_rtc_data, image.data(), size);
+}
+
+#pragma endregion
+
+#pragma region Restart and Deep Sleep
+
+static int s_resetReason = ESP_RST_POWERON;
+static int s_wakeupCause = ESP_SLEEP_WAKEUP_UNDEFINED;
+static uint64_t s_extWakeStatus = 0;
+
+int hostResetReason()
+{
+    return s_resetReason;
+}
+
+int hostWakeupCause()
+{
+    return s_wakeupCause;
+}
+
+uint64_t hostExtWakeStatus()
+{
+    return s_extWakeStatus;
+}
+
+const char *hostFirmwarePath()
+{
+    static char path[PATH_MAX];
+    static std::once_flag once;
+    std::call_once(once, []() {
+        ssize_t n = readlink("/proc/self/exe", path, sizeof(path) - 1);
+        path[(n > 0) ? n : 0] = '\0';
+    });
+    return path;
+}
+
+static void setEnvNumber(const char *name, unsigned long long value)
+{
+    char text[24];
+    snprintf(text, sizeof(text), "%llu", value);
+    setenv(name, text, 1);
+}
+
+void hostReboot(int resetReason, uint64_t sleepUs, int extWakeCause, uint64_t extWakePins)
+{
+    fflush(stdout);
+    fflush(stderr);
+    rtcMemorySave();
+
+    setEnvNumber("HOST_RESET_REASON", resetReason);
+    setEnvNumber("HOST_SLEEP_US", sleepUs);
+    setEnvNumber("HOST_SLEEP_EXT_CAUSE", extWakeCause);
+    setEnvNumber("HOST_SLEEP_EXT_PINS", extWakePins);
+
+    // an image installed by Update boots from now on, as the ESP32 boots the new partition
+    std::string next = hostPath("ota", "next");
+    std::string running = hostPath("ota", "running");
+    const char *image = hostFirmwarePath();
+    if (access(next.c_str(), X_OK) == 0 && rename(next.c_str(), running.c_str()) == 0)
+        image = running.c_str();
+
+    // every descriptor the app opened is close-on-exec, the new process starts clean
+    char *argv[] = {(char *)image, NULL};
+    execv(image, argv);
+    fprintf(stderr, "cannot restart %s: %s\n", image, strerror(errno));
+    _exit(1);
+}
+
+// In the new process, before anything runs: the deep sleep itself. SIGUSR1 is blocked so an
+// external wakeup that arrives early is not lost.
+static void deepSleep(uint64_t sleepUs, int extWakeCause, uint64_t extWakePins)
+{
+    if (sleepUs == 0 && extWakePins == 0)
+    {
+        printf("Deep sleep without a wakeup source, powered off\n");
+        exit(0);
+    }
+
+    sigset_t wake;
+    sigemptyset(&wake);
+    sigaddset(&wake, SIGUSR1);
+    sigprocmask(SIG_BLOCK, &wake, NULL);
+
+    printf("Deep sleep:%s%s (pid %d)\n", (sleepUs > 0) ? " timer" : "",
+           (extWakePins != 0) ? " SIGUSR1" : "", (int)getpid());
+    fflush(stdout);
+
+    int sig;
+    if (sleepUs == 0)
+    {
+        while (sigwait(&wake, &sig) != 0)
+            ;
+    }
+    else
+    {
+        timespec timeout = {(time_t)(sleepUs / 1000000), (long)(sleepUs % 1000000) * 1000};
+        do
+            sig = sigtimedwait(&wake, NULL, &timeout);
+        while (sig < 0 && errno == EINTR);
+        if (sig < 0 || extWakePins == 0)
+            sig = 0; // the timer, or a SIGUSR1 nobody enabled
+    }
+    sigprocmask(SIG_UNBLOCK, &wake, NULL);
+
+    if (sig == SIGUSR1)
+    {
+        s_wakeupCause = extWakeCause;
+        s_extWakeStatus = extWakePins;
+    }
+    else
+        s_wakeupCause = ESP_SLEEP_WAKEUP_TIMER;
+}
+
+static void onWakeSignal(int sig)
+{
+    hostWakeSignal(sig == SIGUSR1);
+}
+
+#pragma endregion
+
+int main(int argc, char **argv)
+{
+    (void)argc, (void)argv;
+
+    // one malloc arena, so the heap figures (mallinfo2) cover every thread
+    mallopt(M_ARENA_MAX, 1);
+    signal(SIGPIPE, SIG_IGN);
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    const char *reason = getenv("HOST_RESET_REASON");
+    if (reason)
+    {
+        s_resetReason = atoi(reason);
+        uint64_t sleepUs = strtoull(hostEnv("HOST_SLEEP_US", "0"), NULL, 10);
+        int extWakeCause = hostEnvInt("HOST_SLEEP_EXT_CAUSE", ESP_SLEEP_WAKEUP_UNDEFINED);
+        uint64_t extWakePins = strtoull(hostEnv("HOST_SLEEP_EXT_PINS", "0"), NULL, 10);
+        int extWakeLevel = hostEnvInt("HOST_SLEEP_EXT_LEVEL", 1);
+        unsetenv("HOST_RESET_REASON");
+        unsetenv("HOST_SLEEP_US");
+        unsetenv("HOST_SLEEP_EXT_CAUSE");
+        unsetenv("HOST_SLEEP_EXT_PINS");
+        unsetenv("HOST_SLEEP_EXT_LEVEL");
+
+        if (s_resetReason == ESP_RST_DEEPSLEEP)
+            deepSleep(sleepUs, extWakeCause, extWakePins);
+        rtcMemoryRestore();
+        if (s_extWakeStatus != 0)
+            hostGpioSetInputs(s_extWakeStatus, extWakeLevel); // still active, it just woke us
+    }
+
+    signal(SIGUSR1, onWakeSignal);
+    signal(SIGUSR2, onWakeSignal);
+
+    static const long loopSleepUs = hostEnvInt("HOST_LOOP_US", 0);
+    hostTaskStart("loopTask", 8192, 1, []() {
+        setup();
+        for (;;)
+        {
+            loop();
+            if (loopSleepUs > 0)
+                usleep(loopSleepUs);
+        }
+    });
+
+    for (;;)
+        pause();
+}
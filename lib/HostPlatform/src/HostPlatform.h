@@ -0,0 +1,54 @@
+#pragma once
+
+// Host-only services shared by the stand-ins for the Arduino-ESP32 core, ESP-IDF and the
+// network libraries. Apps do not need this header; everything here is configured through
+// HOST_* environment variables (see README.md).
+
+#include <stdint.h>
+#include <functional>
+#include <mutex>
+#include <string>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// the directory that holds flash, SD card, NVS and RTC memory: HOST_ROOT, ./host_data by default
+const char *hostRoot();
+
+// hostRoot()/area/path, creating the area directory on first use
+std::string hostPath(const char *area, const char *path = "");
+
+const char *hostEnv(const char *name, const char *fallback);
+long hostEnvInt(const char *name, long fallback);
+
+// listening ports below 1024 move up by HOST_PORT_OFFSET (8000), so port 80 becomes 8080
+uint16_t hostListenPort(uint16_t port);
+
+// replaces host and port with the "host:port" in the environment variable, if it is set
+bool hostEndpointOverride(const char *envName, std::string &host, uint16_t &port);
+
+// Web server handlers and MQTT callbacks all run on the async_tcp task on the ESP32, so they
+// never overlap; their host threads take this lock for the same effect
+std::recursive_mutex &hostAsyncTcpMutex();
+
+// a FreeRTOS task (listed in uxTaskGetSystemState()) running a host side function
+TaskHandle_t hostTaskStart(const char *name, uint32_t stackDepth, UBaseType_t priority, std::function<void()> body);
+
+// Restarts the app in a fresh process: the same executable, or the one Update installed. RTC
+// memory is carried over. With ESP_RST_DEEPSLEEP the new process first sleeps for sleepUs
+// (0 = no timer) or until SIGUSR1 when extWakePins is not 0; with neither it powers off.
+[[noreturn]] void hostReboot(int resetReason, uint64_t sleepUs, int extWakeCause, uint64_t extWakePins);
+int hostResetReason();
+int hostWakeupCause();
+uint64_t hostExtWakeStatus(); // the pins that ended the deep sleep
+
+// Input levels come from HOST_GPIO ("2:1,13:0"), else from the pull set on the pin
+void hostGpioPull(int pin, int pull); // -1 down, 0 none, 1 up
+void hostGpioSetInputs(uint64_t pins, int level);
+
+// SIGUSR1 drives the pins enabled as external wakeup sources to their active level, SIGUSR2
+// back, so a running app sees the same signal that wakes a sleeping one
+void hostWakeSignal(bool active);
+
+// the executable that is running, what esp_ota_get_running_partition() reads
+const char *hostFirmwarePath();
@@ -0,0 +1,33 @@
+#include "IPAddress.h"
+
+#include <stdio.h>
+
+#include "Print.h"
+
+bool IPAddress::fromString(const char *address)
+{
+    unsigned int parts[4];
+    char end;
+    if (sscanf(address, "%u.%u.%u.%u%c", &parts[0], &parts[1], &parts[2], &parts[3], &end) != 4)
+        return false;
+    for (int i = 0; i < 4; i++)
+    {
+        if (parts[i] > 255)
+            return false;
+        m_address.bytes[i] = parts[i];
+    }
+    return true;
+}
+
+size_t IPAddress::printTo(Print &p) const
+{
+    return p.print(toString());
+}
+
+String IPAddress::toString() const
+{
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%u.%u.%u.%u", m_address.bytes[0], m_address.bytes[1], m_address.bytes[2],
+             m_address.bytes[3]);
+    return String(buf);
+}
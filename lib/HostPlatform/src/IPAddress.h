@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "Printable.h"
+#include "WString.h"
+
+// IPv4 only, stored in network byte order like lwIP
+class IPAddress : public Printable
+{
+public:
+    IPAddress() { m_address.dword = 0; }
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+    {
+        m_address.bytes[0] = a;
+        m_address.bytes[1] = b;
+        m_address.bytes[2] = c;
+        m_address.bytes[3] = d;
+    }
+    IPAddress(uint32_t address) { m_address.dword = address; }
+    IPAddress(const uint8_t *address) { memcpy(m_address.bytes, address, 4); }
+
+    bool fromString(const char *address);
+    bool fromString(const String &address) { return fromString(address.c_str()); }
+
+    operator uint32_t() const { return m_address.dword; }
+    bool operator==(const IPAddress &addr) const { return m_address.dword == addr.m_address.dword; }
+    bool operator!=(const IPAddress &addr) const { return !(*this == addr); }
+    bool operator==(const uint8_t *addr) const { return memcmp(addr, m_address.bytes, 4) == 0; }
+
+    uint8_t operator[](int index) const { return m_address.bytes[index]; }
+    uint8_t &operator[](int index) { return m_address.bytes[index]; }
+
+    IPAddress &operator=(uint32_t address)
+    {
+        m_address.dword = address;
+        return *this;
+    }
+
+    virtual size_t printTo(Print &p) const;
+    String toString() const;
+
+private:
+    union
+    {
+        uint8_t bytes[4];
+        uint32_t dword;
+    } m_address;
+};
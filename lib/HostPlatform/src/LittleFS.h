@@ -0,0 +1,20 @@
+#pragma once
+
+#include "FS.h"
+
+// The flash file system is HOST_ROOT/littlefs. Its size is HOST_LITTLEFS_SIZE, the spiffs
+// partition of no_ota.csv by default; it only shows in totalBytes(), writes are not limited.
+class LittleFSFS : public fs::FS
+{
+public:
+    LittleFSFS() : fs::FS("littlefs") {}
+
+    bool begin(bool formatOnFail = false, const char *basePath = "/littlefs", uint8_t maxOpenFiles = 10,
+               const char *partitionLabel = "spiffs");
+    bool format();
+    size_t totalBytes();
+    size_t usedBytes();
+    void end() { unmount(); }
+};
+
+extern LittleFSFS LittleFS;
@@ -0,0 +1,180 @@
+#include "Preferences.h"
+
+#include "HostPlatform.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// NVS limits namespace and key names to 15 characters
+static const size_t NVS_KEY_NAME_MAX = 15;
+
+static bool validName(const char *name)
+{
+    size_t len = name ? strlen(name) : 0;
+    return len > 0 && len <= NVS_KEY_NAME_MAX && strchr(name, '/') == NULL && strcmp(name, ".") != 0 &&
+           strcmp(name, "..") != 0;
+}
+
+bool Preferences::begin(const char *name, bool readOnly, const char *partition_label)
+{
+    (void)partition_label;
+    if (m_started || !validName(name))
+        return false;
+
+    m_dir = hostPath("nvs", name);
+    if (mkdir(m_dir.c_str(), 0755) != 0 && errno != EEXIST)
+        return false;
+    m_readOnly = readOnly;
+    m_started = true;
+    return true;
+}
+
+void Preferences::end()
+{
+    m_started = false;
+}
+
+std::string Preferences::keyPath(const char *key)
+{
+    if (!m_started || !validName(key))
+        return "";
+    return m_dir + "/" + key;
+}
+
+bool Preferences::clear()
+{
+    if (!m_started || m_readOnly)
+        return false;
+    DIR *dir = opendir(m_dir.c_str());
+    if (!dir)
+        return false;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL)
+    {
+        if (entry->d_name[0] != '.')
+            unlink((m_dir + "/" + entry->d_name).c_str());
+    }
+    closedir(dir);
+    return true;
+}
+
+bool Preferences::remove(const char *key)
+{
+    std::string path = keyPath(key);
+    if (path.empty() || m_readOnly)
+        return false;
+    return unlink(path.c_str()) == 0;
+}
+
+// written to a temporary file and renamed, so a crash leaves the old value or the new one
+size_t Preferences::put(const char *key, PreferenceType type, const void *value, size_t len)
+{
+    std::string path = keyPath(key);
+    if (path.empty() || m_readOnly)
+        return 0;
+
+    std::string tmp = path + ".tmp";
+    FILE *f = fopen(tmp.c_str(), "wbe");
+    if (!f)
+        return 0;
+    uint8_t tag = type;
+    bool ok = (fwrite(&tag, 1, 1, f) == 1) && (len == 0 || fwrite(value, 1, len, f) == len);
+    ok = (fclose(f) == 0) && ok;
+    if (!ok || rename(tmp.c_str(), path.c_str()) != 0)
+    {
+        unlink(tmp.c_str());
+        return 0;
+    }
+    return len;
+}
+
+bool Preferences::get(const char *key, PreferenceType type, std::string &value)
+{
+    std::string path = keyPath(key);
+    if (path.empty())
+        return false;
+
+    FILE *f = fopen(path.c_str(), "rbe");
+    if (!f)
+        return false;
+    int tag = fgetc(f);
+    value.clear();
+    char buf[256];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+        value.append(buf, n);
+    fclose(f);
+    return tag == type;
+}
+
+bool Preferences::isKey(const char *key)
+{
+    return getType(key) != PT_INVALID;
+}
+
+PreferenceType Preferences::getType(const char *key)
+{
+    std::string path = keyPath(key);
+    if (path.empty())
+        return PT_INVALID;
+    FILE *f = fopen(path.c_str(), "rbe");
+    if (!f)
+        return PT_INVALID;
+    int tag = fgetc(f);
+    fclose(f);
+    return (tag >= 0 && tag < PT_INVALID) ? (PreferenceType)tag : PT_INVALID;
+}
+
+size_t Preferences::putString(const char *key, const char *value)
+{
+    if (value == NULL)
+        return 0;
+    size_t len = strlen(value);
+    // the length written counts the terminator, as nvs_set_str() stores it
+    return put(key, PT_STR, value, len + 1) ? len : 0;
+}
+
+size_t Preferences::getString(const char *key, char *value, size_t maxLen)
+{
+    std::string stored;
+    if (!get(key, PT_STR, stored) || stored.empty())
+        return 0;
+    if (value == NULL)
+        return stored.size();
+    if (stored.size() > maxLen)
+        return 0;
+    memcpy(value, stored.data(), stored.size());
+    return stored.size();
+}
+
+String Preferences::getString(const char *key, const String defaultValue)
+{
+    std::string stored;
+    if (!get(key, PT_STR, stored) || stored.empty())
+        return defaultValue;
+    return String(stored.c_str());
+}
+
+size_t Preferences::getBytesLength(const char *key)
+{
+    std::string stored;
+    return get(key, PT_BLOB, stored) ? stored.size() : 0;
+}
+
+size_t Preferences::getBytes(const char *key, void *buf, size_t maxLen)
+{
+    std::string stored;
+    if (!get(key, PT_BLOB, stored) || stored.size() > maxLen)
+        return 0;
+    memcpy(buf, stored.data(), stored.size());
+    return stored.size();
+}
+
+// an NVS partition of 20 KB has 630 entries; the host has no such limit
+size_t Preferences::freeEntries()
+{
+    return 630;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <string>
+
+#include "WString.h"
+
+typedef enum
+{
+    PT_I8,
+    PT_U8,
+    PT_I16,
+    PT_U16,
+    PT_I32,
+    PT_U32,
+    PT_I64,
+    PT_U64,
+    PT_STR,
+    PT_BLOB,
+    PT_INVALID
+} PreferenceType;
+
+// NVS on the host: each namespace is a directory under HOST_ROOT/nvs and each key a file holding
+// its type and value. As in NVS, a key read back as a different type than it was written as
+// gives the default.
+class Preferences
+{
+public:
+    Preferences() : m_started(false), m_readOnly(false) {}
+
+    bool begin(const char *name, bool readOnly = false, const char *partition_label = NULL);
+    void end();
+
+    bool clear();
+    bool remove(const char *key);
+
+    size_t putChar(const char *key, int8_t value) { return put(key, PT_I8, &value, sizeof(value)); }
+    size_t putUChar(const char *key, uint8_t value) { return put(key, PT_U8, &value, sizeof(value)); }
+    size_t putShort(const char *key, int16_t value) { return put(key, PT_I16, &value, sizeof(value)); }
+    size_t putUShort(const char *key, uint16_t value) { return put(key, PT_U16, &value, sizeof(value)); }
+    size_t putInt(const char *key, int32_t value) { return put(key, PT_I32, &value, sizeof(value)); }
+    size_t putUInt(const char *key, uint32_t value) { return put(key, PT_U32, &value, sizeof(value)); }
+    size_t putLong(const char *key, int32_t value) { return putInt(key, value); }
+    size_t putULong(const char *key, uint32_t value) { return putUInt(key, value); }
+    size_t putLong64(const char *key, int64_t value) { return put(key, PT_I64, &value, sizeof(value)); }
+    size_t putULong64(const char *key, uint64_t value) { return put(key, PT_U64, &value, sizeof(value)); }
+    size_t putFloat(const char *key, float value) { return put(key, PT_BLOB, &value, sizeof(value)); }
+    size_t putDouble(const char *key, double value) { return put(key, PT_BLOB, &value, sizeof(value)); }
+    size_t putBool(const char *key, bool value) { return putUChar(key, value ? 1 : 0); }
+    size_t putString(const char *key, const char *value);
+    size_t putString(const char *key, String value) { return putString(key, value.c_str()); }
+    size_t putBytes(const char *key, const void *value, size_t len) { return put(key, PT_BLOB, value, len); }
+
+    bool isKey(const char *key);
+    PreferenceType getType(const char *key);
+
+    int8_t getChar(const char *key, int8_t defaultValue = 0) { return getValue(key, PT_I8, defaultValue); }
+    uint8_t getUChar(const char *key, uint8_t defaultValue = 0) { return getValue(key, PT_U8, defaultValue); }
+    int16_t getShort(const char *key, int16_t defaultValue = 0) { return getValue(key, PT_I16, defaultValue); }
+    uint16_t getUShort(const char *key, uint16_t defaultValue = 0) { return getValue(key, PT_U16, defaultValue); }
+    int32_t getInt(const char *key, int32_t defaultValue = 0) { return getValue(key, PT_I32, defaultValue); }
+    uint32_t getUInt(const char *key, uint32_t defaultValue = 0) { return getValue(key, PT_U32, defaultValue); }
+    int32_t getLong(const char *key, int32_t defaultValue = 0) { return getInt(key, defaultValue); }
+    uint32_t getULong(const char *key, uint32_t defaultValue = 0) { return getUInt(key, defaultValue); }
+    int64_t getLong64(const char *key, int64_t defaultValue = 0) { return getValue(key, PT_I64, defaultValue); }
+    uint64_t getULong64(const char *key, uint64_t defaultValue = 0) { return getValue(key, PT_U64, defaultValue); }
+    float getFloat(const char *key, float defaultValue = NAN) { return getValue(key, PT_BLOB, defaultValue); }
+    double getDouble(const char *key, double defaultValue = NAN) { return getValue(key, PT_BLOB, defaultValue); }
+    bool getBool(const char *key, bool defaultValue = false) { return getUChar(key, defaultValue ? 1 : 0) == 1; }
+    size_t getString(const char *key, char *value, size_t maxLen);
+    String getString(const char *key, String defaultValue = String());
+    size_t getBytesLength(const char *key);
+    size_t getBytes(const char *key, void *buf, size_t maxLen);
+    size_t freeEntries();
+
+private:
+    size_t put(const char *key, PreferenceType type, const void *value, size_t len);
+    bool get(const char *key, PreferenceType type, std::string &value);
+
+    template <typename T>
+    T getValue(const char *key, PreferenceType type, T defaultValue)
+    {
+        std::string value;
+        if (!get(key, type, value) || value.size() != sizeof(T))
+            return defaultValue;
+        T result;
+        memcpy(&result, value.data(), sizeof(T));
+        return result;
+    }
+
+    std::string keyPath(const char *key);
+
+    bool m_started;
+    bool m_readOnly;
+    std::string m_dir;
+};
@@ -0,0 +1,109 @@
+#include "Print.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+    size_t n = 0;
+    while (size--)
+    {
+        if (write(*buffer++) == 0)
+            break;
+        n++;
+    }
+    return n;
+}
+
+size_t Print::printf(const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    size_t n = vprintf(format, args);
+    va_end(args);
+    return n;
+}
+
+size_t Print::vprintf(const char *format, va_list args)
+{
+    char small[128];
+    va_list copy;
+    va_copy(copy, args);
+    int len = vsnprintf(small, sizeof(small), format, copy);
+    va_end(copy);
+    if (len < 0)
+        return 0;
+    if ((size_t)len < sizeof(small))
+        return write((const uint8_t *)small, len);
+
+    char *big = (char *)malloc(len + 1);
+    if (big == NULL)
+        return 0;
+    vsnprintf(big, len + 1, format, args);
+    size_t n = write((const uint8_t *)big, len);
+    free(big);
+    return n;
+}
+
+size_t Print::printNumber(unsigned long long n, uint8_t base)
+{
+    if (base < 2)
+        base = 10;
+    char buf[8 * sizeof(n) + 1];
+    char *str = &buf[sizeof(buf) - 1];
+    *str = '\0';
+    do
+    {
+        char c = n % base;
+        n /= base;
+        *--str = (c < 10) ? c + '0' : c + 'A' - 10;
+    } while (n);
+    return write(str);
+}
+
+size_t Print::print(long n, int base)
+{
+    return print((long long)n, base);
+}
+
+size_t Print::print(unsigned long n, int base)
+{
+    return printNumber(n, base);
+}
+
+size_t Print::print(long long n, int base)
+{
+    if (base == 0)
+        return write((uint8_t)n);
+    if (base == 10 && n < 0)
+        return print('-') + printNumber(-(unsigned long long)n, 10);
+    return printNumber((unsigned long long)n, base);
+}
+
+size_t Print::print(unsigned long long n, int base)
+{
+    if (base == 0)
+        return write((uint8_t)n);
+    return printNumber(n, base);
+}
+
+size_t Print::print(double number, int digits)
+{
+    if (isnan(number))
+        return print("nan");
+    if (isinf(number))
+        return print("inf");
+    if (number > 4294967040.0 || number < -4294967040.0)
+        return print("ovf"); // the same limits as the Arduino core
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.*f", digits, number);
+    return print(buf);
+}
+
+size_t Print::print(struct tm *timeinfo, const char *format)
+{
+    char buf[64];
+    size_t n = strftime(buf, sizeof(buf), format ? format : "%c", timeinfo);
+    return write((const uint8_t *)buf, n);
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "Printable.h"
+#include "WString.h"
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+// The Arduino-ESP32 Print: subclasses implement write(uint8_t), and write(buffer, size) when
+// they can do better than a byte at a time
+class Print
+{
+public:
+    Print() : m_writeError(0) {}
+    virtual ~Print() {}
+
+    int getWriteError() { return m_writeError; }
+    void clearWriteError() { setWriteError(0); }
+
+    virtual size_t write(uint8_t) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size);
+    size_t write(const char *str) { return str ? write((const uint8_t *)str, strlen(str)) : 0; }
+    size_t write(const char *buffer, size_t size) { return write((const uint8_t *)buffer, size); }
+    virtual int availableForWrite() { return 0; }
+    virtual void flush() {}
+
+    size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+    size_t vprintf(const char *format, va_list args);
+
+    size_t print(const __FlashStringHelper *ifsh) { return print((const char *)ifsh); }
+    size_t print(const String &s) { return write(s.c_str(), s.length()); }
+    size_t print(const char str[]) { return write(str); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned char n, int base = DEC) { return print((unsigned long)n, base); }
+    size_t print(int n, int base = DEC) { return print((long)n, base); }
+    size_t print(unsigned int n, int base = DEC) { return print((unsigned long)n, base); }
+    size_t print(long n, int base = DEC);
+    size_t print(unsigned long n, int base = DEC);
+    size_t print(long long n, int base = DEC);
+    size_t print(unsigned long long n, int base = DEC);
+    size_t print(double n, int digits = 2);
+    size_t print(const Printable &x) { return x.printTo(*this); }
+    size_t print(struct tm *timeinfo, const char *format = NULL);
+
+    template <typename T>
+    size_t println(const T &value)
+    {
+        size_t n = print(value);
+        return n + println();
+    }
+    template <typename T>
+    size_t println(const T &value, int modifier)
+    {
+        size_t n = print(value, modifier);
+        return n + println();
+    }
+    size_t println(const char str[])
+    {
+        size_t n = print(str);
+        return n + println();
+    }
+    size_t println(void) { return write("\r\n"); }
+
+protected:
+    void setWriteError(int err = 1) { m_writeError = err; }
+
+private:
+    size_t printNumber(unsigned long long n, uint8_t base);
+
+    int m_writeError;
+};
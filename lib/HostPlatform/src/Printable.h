@@ -0,0 +1,13 @@
+#pragma once
+
+#include <stddef.h>
+
+class Print;
+
+// something that knows how to print itself, e.g. an IPAddress
+class Printable
+{
+public:
+    virtual ~Printable() {}
+    virtual size_t printTo(Print &p) const = 0;
+};
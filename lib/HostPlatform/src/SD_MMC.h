@@ -0,0 +1,31 @@
+#pragma once
+
+#include "FS.h"
+
+typedef enum
+{
+    CARD_NONE,
+    CARD_MMC,
+    CARD_SD,
+    CARD_SDHC,
+    CARD_UNKNOWN
+} sdcard_type_t;
+
+// The card is HOST_ROOT/sdcard, an SDHC card of HOST_SD_SIZE bytes (4 GiB); HOST_SD_SIZE=0
+// takes it out, so begin() fails as it does with an empty slot
+class SDMMCFS : public fs::FS
+{
+public:
+    SDMMCFS() : fs::FS("sdcard") {}
+
+    bool setPins(int clk, int cmd, int d0) { return (void)clk, (void)cmd, (void)d0, true; }
+    bool begin(const char *mountpoint = "/sdcard", bool mode1bit = false, bool format_if_mount_failed = false,
+               int sdmmc_frequency = 20000, uint8_t maxOpenFiles = 5);
+    void end() { unmount(); }
+    sdcard_type_t cardType();
+    uint64_t cardSize();
+    uint64_t totalBytes();
+    uint64_t usedBytes();
+};
+
+extern SDMMCFS SD_MMC;
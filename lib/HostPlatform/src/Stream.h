@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Print.h"
+
+// The Arduino Stream: reads that wait up to the timeout (1 s by default) for the bytes asked for
+class Stream : public Print
+{
+public:
+    Stream() : m_timeout(1000), m_startMillis(0) {}
+
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    void setTimeout(unsigned long timeout) { m_timeout = timeout; }
+    unsigned long getTimeout(void) { return m_timeout; }
+
+    bool find(const char *target) { return findUntil(target, strlen(target), NULL, 0); }
+    bool find(const char *target, size_t length) { return findUntil(target, length, NULL, 0); }
+    bool find(char target) { return find(&target, 1); }
+    bool findUntil(const char *target, const char *terminator)
+    {
+        return findUntil(target, strlen(target), terminator, strlen(terminator));
+    }
+    bool findUntil(const char *target, size_t targetLen, const char *terminate, size_t termLen);
+
+    long parseInt();
+    float parseFloat();
+
+    virtual size_t readBytes(char *buffer, size_t length);
+    virtual size_t readBytes(uint8_t *buffer, size_t length) { return readBytes((char *)buffer, length); }
+    size_t readBytesUntil(char terminator, char *buffer, size_t length);
+    size_t readBytesUntil(char terminator, uint8_t *buffer, size_t length)
+    {
+        return readBytesUntil(terminator, (char *)buffer, length);
+    }
+    virtual String readString();
+    String readStringUntil(char terminator);
+
+protected:
+    int timedRead();
+    int timedPeek();
+    int peekNextDigit(bool detectDecimal);
+
+    unsigned long m_timeout;
+    unsigned long m_startMillis;
+};
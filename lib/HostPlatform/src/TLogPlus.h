@@ -0,0 +1,44 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "HardwareSerial.h"
+#include "Print.h"
+
+// TLogPlus with its Serial output only: whatever ArduinoLog writes ends up on stdout. Extra
+// sinks (syslog, web serial, MQTT) are ordinary Prints here.
+namespace TLogPlus
+{
+
+class TLog : public Print
+{
+public:
+    TLog() : m_serialEnabled(true) {}
+
+    void begin() {}
+    void loop() {}
+
+    void disableSerial(bool disable) { m_serialEnabled = !disable; }
+    void addPrintStream(const std::shared_ptr<Print> &stream) { m_streams.push_back(stream); }
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t *buffer, size_t size) override
+    {
+        if (m_serialEnabled)
+            Serial.write(buffer, size);
+        for (const std::shared_ptr<Print> &stream : m_streams)
+            stream->write(buffer, size);
+        return size;
+    }
+
+    using Print::write;
+
+private:
+    bool m_serialEnabled;
+    std::vector<std::shared_ptr<Print>> m_streams;
+};
+
+inline TLog Log;
+
+} // namespace TLogPlus
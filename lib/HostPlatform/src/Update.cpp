@@ -0,0 +1,180 @@
+#include "Update.h"
+
+#include "HostPlatform.h"
+#include "esp_ota_ops.h"
+
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+UpdateClass Update;
+
+static const char *s_errorStrings[] = {"No Error",
+                                       "Flash Write Failed",
+                                       "Flash Erase Failed",
+                                       "Flash Read Failed",
+                                       "Not Enough Space",
+                                       "Bad Size Given",
+                                       "Stream Read Timeout",
+                                       "MD5 Check Failed",
+                                       "Wrong Magic Byte",
+                                       "Could Not Activate The Firmware",
+                                       "Partition Could Not be Found",
+                                       "Bad Argument",
+                                       "Aborted"};
+
+static std::string imagePath(bool temporary)
+{
+    return hostPath("ota", temporary ? "next.tmp" : "next");
+}
+
+UpdateClass::UpdateClass() : m_error(UPDATE_ERROR_OK), m_size(0), m_progress(0), m_file(NULL)
+{
+}
+
+void UpdateClass::reset()
+{
+    if (m_file)
+        fclose(m_file);
+    m_file = NULL;
+    m_size = 0;
+    m_progress = 0;
+}
+
+void UpdateClass::fail(uint8_t error)
+{
+    reset();
+    unlink(imagePath(true).c_str());
+    m_error = error;
+}
+
+bool UpdateClass::begin(size_t size, int command, int ledPin, uint8_t ledOn, const char *label)
+{
+    (void)ledPin, (void)ledOn, (void)label;
+    if (m_size > 0)
+        return false;
+    m_error = UPDATE_ERROR_OK;
+
+    if (command != U_FLASH)
+    {
+        m_error = UPDATE_ERROR_BAD_ARGUMENT;
+        return false;
+    }
+
+    const esp_partition_t *partition = esp_ota_get_next_update_partition(NULL);
+    if (size == 0)
+    {
+        m_error = UPDATE_ERROR_SIZE;
+        return false;
+    }
+    if (size == UPDATE_SIZE_UNKNOWN)
+        size = partition->size;
+    else if (size > partition->size)
+    {
+        m_error = UPDATE_ERROR_SIZE;
+        return false;
+    }
+
+    m_file = fopen(imagePath(true).c_str(), "wbe");
+    if (!m_file)
+    {
+        m_error = UPDATE_ERROR_ERASE;
+        return false;
+    }
+    m_size = size;
+    m_progress = 0;
+    return true;
+}
+
+size_t UpdateClass::write(uint8_t *data, size_t len)
+{
+    if (hasError() || !isRunning())
+        return 0;
+    if (len > remaining())
+    {
+        fail(UPDATE_ERROR_SPACE);
+        return 0;
+    }
+
+    // the first bytes must make an executable, as the ESP32 checks for its image magic
+    static const uint8_t elfMagic[4] = {0x7f, 'E', 'L', 'F'};
+    for (size_t i = 0; i < len && m_progress + i < sizeof(elfMagic); i++)
+    {
+        if (data[i] != elfMagic[m_progress + i])
+        {
+            fail(UPDATE_ERROR_MAGIC_BYTE);
+            return 0;
+        }
+    }
+
+    if (fwrite(data, 1, len, m_file) != len)
+    {
+        fail(UPDATE_ERROR_WRITE);
+        return 0;
+    }
+    m_progress += len;
+    if (m_progressCallback)
+        m_progressCallback(m_progress, m_size);
+    return len;
+}
+
+size_t UpdateClass::writeStream(Stream &data)
+{
+    uint8_t buf[4096];
+    size_t written = 0;
+    while (remaining() > 0)
+    {
+        size_t want = (remaining() < sizeof(buf)) ? remaining() : sizeof(buf);
+        size_t n = data.readBytes(buf, want);
+        if (n == 0)
+        {
+            fail(UPDATE_ERROR_STREAM);
+            return written;
+        }
+        if (write(buf, n) != n)
+            return written;
+        written += n;
+    }
+    return written;
+}
+
+bool UpdateClass::end(bool evenIfRemaining)
+{
+    if (hasError() || m_size == 0)
+        return false;
+    if (!isFinished() && !evenIfRemaining)
+    {
+        fail(UPDATE_ERROR_ABORT);
+        return false;
+    }
+
+    bool written = (fflush(m_file) == 0) && (fsync(fileno(m_file)) == 0);
+    fclose(m_file);
+    m_file = NULL;
+    if (!written)
+    {
+        fail(UPDATE_ERROR_WRITE);
+        return false;
+    }
+
+    std::string tmp = imagePath(true);
+    if (chmod(tmp.c_str(), 0755) != 0 || rename(tmp.c_str(), imagePath(false).c_str()) != 0)
+    {
+        fail(UPDATE_ERROR_ACTIVATE);
+        return false;
+    }
+    reset();
+    return true;
+}
+
+void UpdateClass::abort()
+{
+    fail(UPDATE_ERROR_ABORT);
+}
+
+const char *UpdateClass::errorString()
+{
+    if (m_error < sizeof(s_errorStrings) / sizeof(s_errorStrings[0]))
+        return s_errorStrings[m_error];
+    return "UNKNOWN";
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <functional>
+
+#include "Print.h"
+#include "Stream.h"
+
+#define UPDATE_ERROR_OK (0)
+#define UPDATE_ERROR_WRITE (1)
+#define UPDATE_ERROR_ERASE (2)
+#define UPDATE_ERROR_READ (3)
+#define UPDATE_ERROR_SPACE (4)
+#define UPDATE_ERROR_SIZE (5)
+#define UPDATE_ERROR_STREAM (6)
+#define UPDATE_ERROR_MD5 (7)
+#define UPDATE_ERROR_MAGIC_BYTE (8)
+#define UPDATE_ERROR_ACTIVATE (9)
+#define UPDATE_ERROR_NO_PARTITION (10)
+#define UPDATE_ERROR_BAD_ARGUMENT (11)
+#define UPDATE_ERROR_ABORT (12)
+
+#define UPDATE_SIZE_UNKNOWN 0xFFFFFFFF
+
+#define U_FLASH 0
+#define U_SPIFFS 100
+#define U_AUTH 200
+
+// Firmware updates for the host: the image is a Linux executable (ELF rather than the ESP32
+// 0xE9 magic byte) written to HOST_ROOT/ota/next.tmp and moved to ota/next by end(); the next
+// restart runs it.
+class UpdateClass
+{
+public:
+    typedef std::function<void(size_t, size_t)> THandlerFunction_Progress;
+
+    UpdateClass();
+
+    UpdateClass &onProgress(THandlerFunction_Progress fn)
+    {
+        m_progressCallback = fn;
+        return *this;
+    }
+
+    bool begin(size_t size = UPDATE_SIZE_UNKNOWN, int command = U_FLASH, int ledPin = -1, uint8_t ledOn = 0,
+               const char *label = NULL);
+    size_t write(uint8_t *data, size_t len);
+    size_t writeStream(Stream &data);
+    bool end(bool evenIfRemaining = false);
+    void abort();
+
+    void printError(Print &out) { out.println(errorString()); }
+    const char *errorString();
+
+    bool hasError() { return m_error != UPDATE_ERROR_OK; }
+    uint8_t getError() { return m_error; }
+    void clearError() { m_error = UPDATE_ERROR_OK; }
+    bool isRunning() { return m_size > 0; }
+    bool isFinished() { return m_progress == m_size; }
+    size_t size() { return m_size; }
+    size_t progress() { return m_progress; }
+    size_t remaining() { return m_size - m_progress; }
+
+    bool canRollBack() { return false; }
+    bool rollBack() { return false; }
+
+private:
+    void reset();
+    void fail(uint8_t error);
+
+    uint8_t m_error;
+    size_t m_size;
+    size_t m_progress;
+    FILE *m_file;
+    THandlerFunction_Progress m_progressCallback;
+};
+
+extern UpdateClass Update;
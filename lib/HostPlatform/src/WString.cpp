@@ -0,0 +1,156 @@
+#include "WString.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <strings.h>
+
+const String emptyString;
+
+static std::string formatInteger(unsigned long long value, bool negative, unsigned char base)
+{
+    if (base < 2 || base > 36)
+        base = 10;
+    char buf[72];
+    char *p = buf + sizeof(buf);
+    *--p = 0;
+    do
+    {
+        int digit = value % base;
+        *--p = (digit < 10) ? '0' + digit : 'a' + digit - 10;
+        value /= base;
+    } while (value > 0);
+    if (negative)
+        *--p = '-';
+    return p;
+}
+
+// like Arduino: a negative number is only signed in base 10, otherwise it is its two's complement
+static std::string formatSigned(long long value, unsigned char base, unsigned long long mask)
+{
+    if (value < 0 && base == 10)
+        return formatInteger(-(unsigned long long)value, true, base);
+    return formatInteger((unsigned long long)value & mask, false, base);
+}
+
+String::String(unsigned char value, unsigned char base) : m_s(formatInteger(value, false, base)) {}
+String::String(int value, unsigned char base) : m_s(formatSigned(value, base, 0xffffffffULL)) {}
+String::String(unsigned int value, unsigned char base) : m_s(formatInteger(value, false, base)) {}
+String::String(long value, unsigned char base) : m_s(formatSigned(value, base, ~0ULL)) {}
+String::String(unsigned long value, unsigned char base) : m_s(formatInteger(value, false, base)) {}
+String::String(long long value, unsigned char base) : m_s(formatSigned(value, base, ~0ULL)) {}
+String::String(unsigned long long value, unsigned char base) : m_s(formatInteger(value, false, base)) {}
+
+String::String(float value, unsigned int decimalPlaces) : String((double)value, decimalPlaces) {}
+
+String::String(double value, unsigned int decimalPlaces)
+{
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.*f", (int)decimalPlaces, value);
+    m_s = buf;
+}
+
+bool String::equalsIgnoreCase(const String &s) const
+{
+    return length() == s.length() && strcasecmp(c_str(), s.c_str()) == 0;
+}
+
+bool String::equalsConstantTime(const String &s) const
+{
+    if (length() != s.length())
+        return false;
+    unsigned char diff = 0;
+    for (unsigned int i = 0; i < length(); i++)
+        diff |= m_s[i] ^ s.m_s[i];
+    return diff == 0;
+}
+
+char &String::operator[](unsigned int index)
+{
+    static char dummy;
+    if (index >= length())
+    {
+        dummy = 0;
+        return dummy;
+    }
+    return m_s[index];
+}
+
+void String::getBytes(unsigned char *buf, unsigned int bufsize, unsigned int index) const
+{
+    if (bufsize == 0 || buf == NULL)
+        return;
+    if (index >= length())
+    {
+        buf[0] = 0;
+        return;
+    }
+    unsigned int n = length() - index;
+    if (n > bufsize - 1)
+        n = bufsize - 1;
+    memcpy(buf, c_str() + index, n);
+    buf[n] = 0;
+}
+
+String String::substring(unsigned int beginIndex, unsigned int endIndex) const
+{
+    if (beginIndex > endIndex)
+    {
+        unsigned int t = beginIndex;
+        beginIndex = endIndex;
+        endIndex = t;
+    }
+    if (beginIndex >= length())
+        return String();
+    if (endIndex > length())
+        endIndex = length();
+    return String(c_str() + beginIndex, endIndex - beginIndex);
+}
+
+void String::replace(char find, char replace)
+{
+    for (size_t i = 0; i < m_s.length(); i++)
+        if (m_s[i] == find)
+            m_s[i] = replace;
+}
+
+void String::replace(const String &find, const String &replace)
+{
+    if (find.length() == 0)
+        return;
+    size_t pos = 0;
+    while ((pos = m_s.find(find.m_s, pos)) != std::string::npos)
+    {
+        m_s.replace(pos, find.length(), replace.m_s);
+        pos += replace.length();
+    }
+}
+
+void String::remove(unsigned int index, unsigned int count)
+{
+    if (index < length())
+        m_s.erase(index, count);
+}
+
+void String::toLowerCase()
+{
+    for (size_t i = 0; i < m_s.length(); i++)
+        m_s[i] = tolower((unsigned char)m_s[i]);
+}
+
+void String::toUpperCase()
+{
+    for (size_t i = 0; i < m_s.length(); i++)
+        m_s[i] = toupper((unsigned char)m_s[i]);
+}
+
+void String::trim()
+{
+    size_t begin = 0;
+    size_t end = m_s.length();
+    while (begin < end && isspace((unsigned char)m_s[begin]))
+        begin++;
+    while (end > begin && isspace((unsigned char)m_s[end - 1]))
+        end--;
+    m_s = m_s.substr(begin, end - begin);
+}
@@ -0,0 +1,215 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#include "pgmspace.h"
+
+// The Arduino String on top of std::string. Allocation failures throw instead of leaving an
+// invalid String, which the host never sees in practice.
+
+class __FlashStringHelper;
+#define FPSTR(pstr_pointer) (reinterpret_cast<const __FlashStringHelper *>(pstr_pointer))
+#define F(string_literal) (FPSTR(PSTR(string_literal)))
+
+class String
+{
+public:
+    String(const char *cstr = "") : m_s(cstr ? cstr : "") {}
+    String(const char *cstr, unsigned int length) : m_s(cstr ? cstr : "", cstr ? length : 0) {}
+    String(const uint8_t *cstr, unsigned int length) : m_s((const char *)cstr, length) {}
+    String(const String &str) : m_s(str.m_s) {}
+    String(String &&str) : m_s(std::move(str.m_s)) {}
+    String(const __FlashStringHelper *str) : m_s((const char *)str) {}
+    explicit String(char c) : m_s(1, c) {}
+    explicit String(unsigned char value, unsigned char base = 10);
+    explicit String(int value, unsigned char base = 10);
+    explicit String(unsigned int value, unsigned char base = 10);
+    explicit String(long value, unsigned char base = 10);
+    explicit String(unsigned long value, unsigned char base = 10);
+    explicit String(long long value, unsigned char base = 10);
+    explicit String(unsigned long long value, unsigned char base = 10);
+    explicit String(float value, unsigned int decimalPlaces = 2);
+    explicit String(double value, unsigned int decimalPlaces = 2);
+
+    String &operator=(const String &rhs)
+    {
+        m_s = rhs.m_s;
+        return *this;
+    }
+    String &operator=(String &&rhs)
+    {
+        m_s = std::move(rhs.m_s);
+        return *this;
+    }
+    String &operator=(const char *cstr)
+    {
+        m_s = cstr ? cstr : "";
+        return *this;
+    }
+    String &operator=(const __FlashStringHelper *str) { return *this = (const char *)str; }
+
+    bool reserve(unsigned int size)
+    {
+        m_s.reserve(size);
+        return true;
+    }
+    unsigned int length() const { return m_s.length(); }
+    bool isEmpty() const { return m_s.empty(); }
+    const char *c_str() const { return m_s.c_str(); }
+    char *begin() { return &m_s[0]; }
+    char *end() { return &m_s[0] + m_s.length(); }
+    const char *begin() const { return c_str(); }
+    const char *end() const { return c_str() + length(); }
+
+    bool concat(const String &str)
+    {
+        m_s += str.m_s;
+        return true;
+    }
+    bool concat(const char *cstr)
+    {
+        if (cstr == NULL)
+            return false;
+        m_s += cstr;
+        return true;
+    }
+    bool concat(const char *cstr, unsigned int length)
+    {
+        if (cstr == NULL)
+            return false;
+        m_s.append(cstr, length);
+        return true;
+    }
+    bool concat(const uint8_t *cstr, unsigned int length) { return concat((const char *)cstr, length); }
+    bool concat(char c)
+    {
+        m_s += c;
+        return true;
+    }
+    bool concat(const __FlashStringHelper *str) { return concat((const char *)str); }
+    bool concat(unsigned char num) { return concat(String(num)); }
+    bool concat(int num) { return concat(String(num)); }
+    bool concat(unsigned int num) { return concat(String(num)); }
+    bool concat(long num) { return concat(String(num)); }
+    bool concat(unsigned long num) { return concat(String(num)); }
+    bool concat(long long num) { return concat(String(num)); }
+    bool concat(unsigned long long num) { return concat(String(num)); }
+    bool concat(float num) { return concat(String(num)); }
+    bool concat(double num) { return concat(String(num)); }
+
+    template <typename T>
+    String &operator+=(const T &rhs)
+    {
+        concat(rhs);
+        return *this;
+    }
+
+    explicit operator bool() const { return true; }
+
+    int compareTo(const String &s) const { return m_s.compare(s.m_s); }
+    bool equals(const String &s) const { return m_s == s.m_s; }
+    bool equals(const char *cstr) const { return cstr ? m_s == cstr : m_s.empty(); }
+    bool equalsIgnoreCase(const String &s) const;
+    bool equalsConstantTime(const String &s) const;
+    bool operator==(const String &rhs) const { return equals(rhs); }
+    bool operator==(const char *cstr) const { return equals(cstr); }
+    bool operator!=(const String &rhs) const { return !equals(rhs); }
+    bool operator!=(const char *cstr) const { return !equals(cstr); }
+    bool operator<(const String &rhs) const { return compareTo(rhs) < 0; }
+    bool operator>(const String &rhs) const { return compareTo(rhs) > 0; }
+    bool operator<=(const String &rhs) const { return compareTo(rhs) <= 0; }
+    bool operator>=(const String &rhs) const { return compareTo(rhs) >= 0; }
+
+    bool startsWith(const String &prefix) const { return startsWith(prefix, 0); }
+    bool startsWith(const String &prefix, unsigned int offset) const
+    {
+        return offset + prefix.length() <= length() && m_s.compare(offset, prefix.length(), prefix.m_s) == 0;
+    }
+    bool endsWith(const String &suffix) const
+    {
+        return suffix.length() <= length() && m_s.compare(length() - suffix.length(), suffix.length(), suffix.m_s) == 0;
+    }
+
+    char charAt(unsigned int index) const { return index < length() ? m_s[index] : 0; }
+    void setCharAt(unsigned int index, char c)
+    {
+        if (index < length())
+            m_s[index] = c;
+    }
+    char operator[](unsigned int index) const { return charAt(index); }
+    char &operator[](unsigned int index);
+    void getBytes(unsigned char *buf, unsigned int bufsize, unsigned int index = 0) const;
+    void toCharArray(char *buf, unsigned int bufsize, unsigned int index = 0) const
+    {
+        getBytes((unsigned char *)buf, bufsize, index);
+    }
+
+    int indexOf(char ch, unsigned int fromIndex = 0) const { return found(m_s.find(ch, fromIndex)); }
+    int indexOf(const String &str, unsigned int fromIndex = 0) const { return found(m_s.find(str.m_s, fromIndex)); }
+    int lastIndexOf(char ch) const { return found(m_s.rfind(ch)); }
+    int lastIndexOf(char ch, unsigned int fromIndex) const { return found(m_s.rfind(ch, fromIndex)); }
+    int lastIndexOf(const String &str) const { return found(m_s.rfind(str.m_s)); }
+    int lastIndexOf(const String &str, unsigned int fromIndex) const { return found(m_s.rfind(str.m_s, fromIndex)); }
+    String substring(unsigned int beginIndex) const { return substring(beginIndex, length()); }
+    String substring(unsigned int beginIndex, unsigned int endIndex) const;
+
+    void replace(char find, char replace);
+    void replace(const String &find, const String &replace);
+    void remove(unsigned int index) { remove(index, (unsigned int)-1); }
+    void remove(unsigned int index, unsigned int count);
+    void toLowerCase();
+    void toUpperCase();
+    void trim();
+
+    long toInt() const { return atol(c_str()); }
+    float toFloat() const { return (float)atof(c_str()); }
+    double toDouble() const { return atof(c_str()); }
+
+private:
+    static int found(size_t pos) { return (pos == std::string::npos) ? -1 : (int)pos; }
+
+    std::string m_s;
+};
+
+// "a" + String(b) + c and friends; Arduino builds these with StringSumHelper, which is a String
+typedef String StringSumHelper;
+
+inline String operator+(const String &lhs, const String &rhs)
+{
+    String s(lhs);
+    s.concat(rhs);
+    return s;
+}
+inline String operator+(String &&lhs, const String &rhs)
+{
+    lhs.concat(rhs);
+    return std::move(lhs);
+}
+inline String operator+(const char *lhs, const String &rhs)
+{
+    String s(lhs);
+    s.concat(rhs);
+    return s;
+}
+inline String operator+(const __FlashStringHelper *lhs, const String &rhs) { return (const char *)lhs + rhs; }
+template <typename T>
+inline String operator+(const String &lhs, const T &rhs)
+{
+    String s(lhs);
+    s.concat(rhs);
+    return s;
+}
+template <typename T>
+inline String operator+(String &&lhs, const T &rhs)
+{
+    lhs.concat(rhs);
+    return std::move(lhs);
+}
+inline bool operator==(const char *lhs, const String &rhs) { return rhs.equals(lhs); }
+inline bool operator!=(const char *lhs, const String &rhs) { return !rhs.equals(lhs); }
+
+extern const String emptyString;
@@ -0,0 +1,256 @@
+#include "WiFi.h"
+
+#include "HostPlatform.h"
+#include "esp_mac.h"
+
+#include <Arduino.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+WiFiClass WiFi;
+
+#pragma region Events
+
+struct WiFiEventHandler
+{
+    wifi_event_id_t id;
+    arduino_event_id_t event;
+    WiFiEventCb cb;
+    WiFiEventFuncCb funcCb;
+};
+
+struct WiFiPendingEvent
+{
+    arduino_event_id_t event;
+    uint32_t delayMs;
+};
+
+static std::mutex s_eventMutex;
+static std::condition_variable s_eventReady;
+static std::deque<WiFiPendingEvent> s_events;
+static std::vector<WiFiEventHandler> s_handlers;
+static wifi_event_id_t s_nextHandlerId = 1;
+
+static void eventTask()
+{
+    for (;;)
+    {
+        WiFiPendingEvent pending;
+        std::vector<WiFiEventHandler> handlers;
+        {
+            std::unique_lock<std::mutex> lock(s_eventMutex);
+            s_eventReady.wait(lock, []() { return !s_events.empty(); });
+            pending = s_events.front();
+            s_events.pop_front();
+        }
+
+        if (pending.delayMs > 0)
+            delay(pending.delayMs);
+
+        {
+            std::lock_guard<std::mutex> lock(s_eventMutex);
+            handlers = s_handlers;
+        }
+        arduino_event_info_t info = {};
+        for (const WiFiEventHandler &handler : handlers)
+        {
+            if (handler.event != ARDUINO_EVENT_MAX && handler.event != pending.event)
+                continue;
+            if (handler.cb)
+                handler.cb(pending.event);
+            else if (handler.funcCb)
+                handler.funcCb(pending.event, info);
+        }
+    }
+}
+
+void WiFiClass::post(arduino_event_id_t event, uint32_t delayMs)
+{
+    static std::once_flag once;
+    std::call_once(once, []() { hostTaskStart("arduino_events", 4096, configMAX_PRIORITIES - 6, eventTask); });
+
+    std::lock_guard<std::mutex> lock(s_eventMutex);
+    s_events.push_back({event, delayMs});
+    s_eventReady.notify_one();
+}
+
+wifi_event_id_t WiFiClass::onEvent(WiFiEventCb cbEvent, arduino_event_id_t event)
+{
+    std::lock_guard<std::mutex> lock(s_eventMutex);
+    s_handlers.push_back({s_nextHandlerId, event, cbEvent, WiFiEventFuncCb()});
+    return s_nextHandlerId++;
+}
+
+wifi_event_id_t WiFiClass::onEvent(WiFiEventFuncCb cbEvent, arduino_event_id_t event)
+{
+    std::lock_guard<std::mutex> lock(s_eventMutex);
+    s_handlers.push_back({s_nextHandlerId, event, NULL, cbEvent});
+    return s_nextHandlerId++;
+}
+
+void WiFiClass::removeEvent(wifi_event_id_t id)
+{
+    std::lock_guard<std::mutex> lock(s_eventMutex);
+    for (auto it = s_handlers.begin(); it != s_handlers.end(); ++it)
+    {
+        if (it->id == id)
+        {
+            s_handlers.erase(it);
+            break;
+        }
+    }
+}
+
+#pragma endregion
+
+#pragma region Station
+
+WiFiClass::WiFiClass() : m_mode(WIFI_OFF), m_connected(false), m_knownAp(false), m_bssid{0x02, 0x00, 0x5E, 0x00, 0x00, 0x01},
+                         m_channel(6)
+{
+}
+
+bool WiFiClass::mode(wifi_mode_t mode)
+{
+    if (mode == m_mode)
+        return true;
+    if (mode == WIFI_OFF)
+    {
+        disconnect();
+        post(ARDUINO_EVENT_WIFI_STA_STOP);
+    }
+    else if (m_mode == WIFI_OFF)
+    {
+        post(ARDUINO_EVENT_WIFI_READY);
+        post(ARDUINO_EVENT_WIFI_STA_START);
+    }
+    m_mode = mode;
+    return true;
+}
+
+wl_status_t WiFiClass::begin(const char *ssid, const char *passphrase, int32_t channel, const uint8_t *bssid,
+                             bool connect)
+{
+    (void)passphrase;
+    mode(WIFI_STA);
+    m_ssid = ssid;
+    m_knownAp = (channel > 0) && (bssid != NULL);
+    if (m_knownAp)
+    {
+        memcpy(m_bssid, bssid, sizeof(m_bssid));
+        m_channel = channel;
+    }
+    if (connect && !m_connected)
+        reconnect();
+    return status();
+}
+
+bool WiFiClass::reconnect()
+{
+    if (m_mode == WIFI_OFF)
+        return false;
+    m_connected = true;
+    post(ARDUINO_EVENT_WIFI_STA_CONNECTED,
+         (m_knownAp ? 0 : hostEnvInt("HOST_WIFI_SCAN_MS", 100)) + hostEnvInt("HOST_WIFI_CONNECT_MS", 300));
+    post(ARDUINO_EVENT_WIFI_STA_GOT_IP, (m_staticIP != IPAddress()) ? 0 : hostEnvInt("HOST_WIFI_DHCP_MS", 100));
+    return true;
+}
+
+// a zero local_ip goes back to DHCP
+bool WiFiClass::config(IPAddress local_ip, IPAddress gateway, IPAddress subnet, IPAddress dns1, IPAddress dns2)
+{
+    (void)subnet, (void)dns2;
+    m_staticIP = local_ip;
+    m_gateway = gateway;
+    m_dns = dns1;
+    return true;
+}
+
+bool WiFiClass::disconnect(bool wifioff, bool eraseap)
+{
+    (void)eraseap;
+    if (m_connected)
+    {
+        m_connected = false;
+        post(ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+    }
+    if (wifioff)
+        mode(WIFI_OFF);
+    return true;
+}
+
+// the address other machines reach this one at: a UDP "connection" picks the outgoing
+// interface without sending anything
+IPAddress WiFiClass::localIP()
+{
+    if (!m_connected)
+        return IPAddress();
+    if (m_staticIP != IPAddress())
+        return m_staticIP;
+
+    IPAddress ip;
+    if (ip.fromString(hostEnv("HOST_IP", "")))
+        return ip;
+
+    ip = IPAddress(127, 0, 0, 1);
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return ip;
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(53);
+    inet_pton(AF_INET, "192.0.2.1", &addr.sin_addr);
+    socklen_t len = sizeof(addr);
+    if (connect(fd, (sockaddr *)&addr, sizeof(addr)) == 0 && getsockname(fd, (sockaddr *)&addr, &len) == 0)
+        ip = IPAddress(addr.sin_addr.s_addr);
+    close(fd);
+    return ip;
+}
+
+IPAddress WiFiClass::gatewayIP()
+{
+    if (m_connected && m_staticIP != IPAddress())
+        return m_gateway;
+    IPAddress ip = localIP();
+    if (ip != IPAddress())
+        ip[3] = 1;
+    return ip;
+}
+
+IPAddress WiFiClass::dnsIP(uint8_t dns_no)
+{
+    if (m_connected && m_staticIP != IPAddress())
+        return (dns_no == 0) ? m_dns : IPAddress();
+    return (dns_no == 0) ? gatewayIP() : IPAddress();
+}
+
+uint8_t *WiFiClass::macAddress(uint8_t *mac)
+{
+    esp_read_mac(mac, ESP_MAC_WIFI_STA);
+    return mac;
+}
+
+String WiFiClass::macAddress()
+{
+    uint8_t mac[6];
+    char text[18];
+    macAddress(mac);
+    snprintf(text, sizeof(text), "%02X:%02X:%02X:%02X:%02X:%02X", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    return String(text);
+}
+
+bool WiFiClass::setHostname(const char *hostname)
+{
+    m_hostname = hostname;
+    return true;
+}
+
+#pragma endregion
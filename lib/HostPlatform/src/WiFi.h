@@ -0,0 +1,123 @@
+#pragma once
+
+#include <functional>
+
+#include "IPAddress.h"
+#include "WString.h"
+#include "WiFiClient.h"
+#include "WiFiServer.h"
+#include "WiFiUdp.h"
+
+typedef enum
+{
+    ARDUINO_EVENT_WIFI_READY = 0,
+    ARDUINO_EVENT_WIFI_SCAN_DONE,
+    ARDUINO_EVENT_WIFI_STA_START,
+    ARDUINO_EVENT_WIFI_STA_STOP,
+    ARDUINO_EVENT_WIFI_STA_CONNECTED,
+    ARDUINO_EVENT_WIFI_STA_DISCONNECTED,
+    ARDUINO_EVENT_WIFI_STA_AUTHMODE_CHANGE,
+    ARDUINO_EVENT_WIFI_STA_GOT_IP,
+    ARDUINO_EVENT_WIFI_STA_GOT_IP6,
+    ARDUINO_EVENT_WIFI_STA_LOST_IP,
+    ARDUINO_EVENT_MAX
+} arduino_event_id_t;
+
+typedef arduino_event_id_t WiFiEvent_t;
+
+// the IDF 3 names, which have the same values
+#define SYSTEM_EVENT_WIFI_READY ARDUINO_EVENT_WIFI_READY
+#define SYSTEM_EVENT_STA_START ARDUINO_EVENT_WIFI_STA_START
+#define SYSTEM_EVENT_STA_STOP ARDUINO_EVENT_WIFI_STA_STOP
+#define SYSTEM_EVENT_STA_CONNECTED ARDUINO_EVENT_WIFI_STA_CONNECTED
+#define SYSTEM_EVENT_STA_DISCONNECTED ARDUINO_EVENT_WIFI_STA_DISCONNECTED
+#define SYSTEM_EVENT_STA_GOT_IP ARDUINO_EVENT_WIFI_STA_GOT_IP
+#define SYSTEM_EVENT_STA_LOST_IP ARDUINO_EVENT_WIFI_STA_LOST_IP
+
+typedef union
+{
+    uint32_t reserved;
+} arduino_event_info_t;
+
+typedef void (*WiFiEventCb)(arduino_event_id_t event);
+typedef std::function<void(arduino_event_id_t event, arduino_event_info_t info)> WiFiEventFuncCb;
+typedef size_t wifi_event_id_t;
+
+typedef enum
+{
+    WIFI_OFF = 0,
+    WIFI_STA = 1,
+    WIFI_AP = 2,
+    WIFI_AP_STA = 3
+} wifi_mode_t;
+
+typedef enum
+{
+    WL_NO_SHIELD = 255,
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_SCAN_COMPLETED = 2,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_CONNECTION_LOST = 5,
+    WL_DISCONNECTED = 6
+} wl_status_t;
+
+// The host's own network stands in for the station: begin() "associates" after
+// HOST_WIFI_SCAN_MS (100) + HOST_WIFI_CONNECT_MS (300) + HOST_WIFI_DHCP_MS (100) and the address
+// is HOST_IP, else the one the host reaches other machines from. A BSSID and channel given to
+// begin() skip the scan and a static address set with config() skips DHCP, as on the ESP32.
+// Events reach the handlers on an "arduino_events" task, in order, as on the ESP32.
+class WiFiClass
+{
+public:
+    WiFiClass();
+
+    wl_status_t begin(const char *ssid, const char *passphrase = NULL, int32_t channel = 0, const uint8_t *bssid = NULL,
+                      bool connect = true);
+    bool disconnect(bool wifioff = false, bool eraseap = false);
+    bool reconnect();
+    bool config(IPAddress local_ip, IPAddress gateway, IPAddress subnet, IPAddress dns1 = IPAddress(),
+                IPAddress dns2 = IPAddress());
+    bool mode(wifi_mode_t mode);
+    wifi_mode_t getMode() { return m_mode; }
+    bool setAutoReconnect(bool autoReconnect) { return (void)autoReconnect, true; }
+    bool setSleep(bool enabled) { return (void)enabled, true; }
+
+    wl_status_t status() { return m_connected ? WL_CONNECTED : WL_DISCONNECTED; }
+    bool isConnected() { return m_connected; }
+    IPAddress localIP();
+    IPAddress gatewayIP();
+    IPAddress subnetMask() { return IPAddress(255, 255, 255, 0); }
+    IPAddress dnsIP(uint8_t dns_no = 0);
+    uint8_t *BSSID() { return m_connected ? m_bssid : NULL; }
+    int32_t channel() { return m_connected ? m_channel : 0; }
+    uint8_t *macAddress(uint8_t *mac);
+    String macAddress();
+    String SSID() { return m_ssid; }
+    int8_t RSSI() { return m_connected ? -50 : 0; }
+
+    bool setHostname(const char *hostname);
+    bool hostname(const String &aHostname) { return setHostname(aHostname.c_str()); }
+    const char *getHostname() { return m_hostname.c_str(); }
+
+    wifi_event_id_t onEvent(WiFiEventCb cbEvent, arduino_event_id_t event = ARDUINO_EVENT_MAX);
+    wifi_event_id_t onEvent(WiFiEventFuncCb cbEvent, arduino_event_id_t event = ARDUINO_EVENT_MAX);
+    void removeEvent(wifi_event_id_t id);
+
+private:
+    void post(arduino_event_id_t event, uint32_t delayMs = 0);
+
+    wifi_mode_t m_mode;
+    volatile bool m_connected;
+    bool m_knownAp; // BSSID and channel given, no scan
+    IPAddress m_staticIP;
+    IPAddress m_gateway;
+    IPAddress m_dns;
+    uint8_t m_bssid[6];
+    int32_t m_channel;
+    String m_ssid;
+    String m_hostname;
+};
+
+extern WiFiClass WiFi;
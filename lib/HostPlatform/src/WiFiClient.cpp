@@ -0,0 +1,231 @@
+#include "WiFiClient.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+class WiFiClientSocketHandle
+{
+public:
+    explicit WiFiClientSocketHandle(int fd) : m_fd(fd) {}
+    ~WiFiClientSocketHandle() { close(m_fd); }
+
+    int fd() const { return m_fd; }
+
+private:
+    int m_fd;
+};
+
+WiFiClient::WiFiClient() : m_connected(false), m_timeoutMs(3000)
+{
+}
+
+WiFiClient::WiFiClient(int fd) : m_handle(new WiFiClientSocketHandle(fd)), m_connected(true), m_timeoutMs(3000)
+{
+}
+
+WiFiClient::~WiFiClient()
+{
+}
+
+int WiFiClient::fd() const
+{
+    return m_handle ? m_handle->fd() : -1;
+}
+
+int WiFiClient::connect(IPAddress ip, uint16_t port, int32_t timeoutMs)
+{
+    stop();
+
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (fd < 0)
+        return 0;
+
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = (uint32_t)ip;
+    int res = ::connect(fd, (sockaddr *)&addr, sizeof(addr));
+    if (res < 0 && errno == EINPROGRESS)
+    {
+        pollfd pfd = {fd, POLLOUT, 0};
+        int error = ETIMEDOUT;
+        socklen_t len = sizeof(error);
+        if (poll(&pfd, 1, timeoutMs) == 1)
+            getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len);
+        res = error ? -1 : 0;
+    }
+    if (res < 0)
+    {
+        close(fd);
+        return 0;
+    }
+
+    // blocking from here on: writes wait for the peer, reads check first
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+    m_handle.reset(new WiFiClientSocketHandle(fd));
+    m_connected = true;
+    return 1;
+}
+
+int WiFiClient::connect(const char *host, uint16_t port, int32_t timeoutMs)
+{
+    IPAddress ip;
+    if (!ip.fromString(host))
+    {
+        addrinfo hints = {};
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo *result;
+        if (getaddrinfo(host, NULL, &hints, &result) != 0)
+            return 0;
+        ip = ((sockaddr_in *)result->ai_addr)->sin_addr.s_addr;
+        freeaddrinfo(result);
+    }
+    return connect(ip, port, timeoutMs);
+}
+
+size_t WiFiClient::write(const uint8_t *buf, size_t size)
+{
+    if (!m_connected || !m_handle)
+        return 0;
+
+    size_t sent = 0;
+    while (sent < size)
+    {
+        ssize_t n = send(fd(), buf + sent, size - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+        {
+            m_connected = false;
+            break;
+        }
+        sent += n;
+    }
+    return sent;
+}
+
+int WiFiClient::available()
+{
+    if (!m_connected || !m_handle)
+        return 0;
+    int count = 0;
+    if (ioctl(fd(), FIONREAD, &count) < 0)
+        return 0;
+    return count;
+}
+
+int WiFiClient::read()
+{
+    uint8_t c;
+    return (read(&c, 1) == 1) ? c : -1;
+}
+
+int WiFiClient::read(uint8_t *buf, size_t size)
+{
+    if (!m_connected || !m_handle)
+        return -1;
+    ssize_t n = recv(fd(), buf, size, MSG_DONTWAIT);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR))
+    {
+        m_connected = false;
+        return -1;
+    }
+    return (n < 0) ? 0 : (int)n;
+}
+
+size_t WiFiClient::readBytes(char *buffer, size_t length)
+{
+    int n = read((uint8_t *)buffer, length);
+    return (n < 0) ? 0 : n;
+}
+
+int WiFiClient::peek()
+{
+    if (!m_connected || !m_handle)
+        return -1;
+    uint8_t c;
+    ssize_t n = recv(fd(), &c, 1, MSG_DONTWAIT | MSG_PEEK);
+    return (n == 1) ? c : -1;
+}
+
+// drops whatever has arrived, as the ESP32 does
+void WiFiClient::flush()
+{
+    uint8_t buf[256];
+    int n;
+    while ((n = available()) > 0)
+        read(buf, (n < (int)sizeof(buf)) ? n : sizeof(buf));
+}
+
+void WiFiClient::stop()
+{
+    m_handle.reset();
+    m_connected = false;
+}
+
+// still connected while there is data to read, even when the peer has closed
+uint8_t WiFiClient::connected()
+{
+    if (m_connected && m_handle)
+    {
+        uint8_t c;
+        ssize_t n = recv(fd(), &c, 1, MSG_DONTWAIT | MSG_PEEK);
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR))
+            m_connected = false;
+    }
+    return m_connected;
+}
+
+int WiFiClient::setNoDelay(bool nodelay)
+{
+    int flag = nodelay;
+    return setsockopt(fd(), IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+}
+
+bool WiFiClient::getNoDelay()
+{
+    int flag = 0;
+    socklen_t len = sizeof(flag);
+    getsockopt(fd(), IPPROTO_TCP, TCP_NODELAY, &flag, &len);
+    return flag != 0;
+}
+
+static bool socketAddress(int fd, bool peer, sockaddr_in &addr)
+{
+    socklen_t len = sizeof(addr);
+    if (fd < 0)
+        return false;
+    return (peer ? getpeername(fd, (sockaddr *)&addr, &len) : getsockname(fd, (sockaddr *)&addr, &len)) == 0;
+}
+
+IPAddress WiFiClient::remoteIP() const
+{
+    sockaddr_in addr;
+    return socketAddress(fd(), true, addr) ? IPAddress(addr.sin_addr.s_addr) : IPAddress();
+}
+
+uint16_t WiFiClient::remotePort() const
+{
+    sockaddr_in addr;
+    return socketAddress(fd(), true, addr) ? ntohs(addr.sin_port) : 0;
+}
+
+IPAddress WiFiClient::localIP() const
+{
+    sockaddr_in addr;
+    return socketAddress(fd(), false, addr) ? IPAddress(addr.sin_addr.s_addr) : IPAddress();
+}
+
+uint16_t WiFiClient::localPort() const
+{
+    sockaddr_in addr;
+    return socketAddress(fd(), false, addr) ? ntohs(addr.sin_port) : 0;
+}
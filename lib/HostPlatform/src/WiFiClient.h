@@ -0,0 +1,57 @@
+#pragma once
+
+#include <memory>
+
+#include "Client.h"
+#include "IPAddress.h"
+
+class WiFiClientSocketHandle;
+
+// A TCP connection. Copies share the socket, which closes when the last copy lets go of it or
+// on stop(). Reads never wait: readBytes() returns what has arrived, as on the ESP32.
+class WiFiClient : public Client
+{
+public:
+    WiFiClient();
+    explicit WiFiClient(int fd);
+    ~WiFiClient();
+
+    int connect(IPAddress ip, uint16_t port) override { return connect(ip, port, m_timeoutMs); }
+    int connect(IPAddress ip, uint16_t port, int32_t timeoutMs);
+    int connect(const char *host, uint16_t port) override { return connect(host, port, m_timeoutMs); }
+    int connect(const char *host, uint16_t port, int32_t timeoutMs);
+
+    size_t write(uint8_t data) override { return write(&data, 1); }
+    size_t write(const uint8_t *buf, size_t size) override;
+    size_t write_P(const char *buf, size_t size) { return write((const uint8_t *)buf, size); }
+    int available() override;
+    int read() override;
+    int read(uint8_t *buf, size_t size) override;
+    size_t readBytes(char *buffer, size_t length) override;
+    size_t readBytes(uint8_t *buffer, size_t length) override { return readBytes((char *)buffer, length); }
+    int peek() override;
+    void flush() override;
+    void stop() override;
+    uint8_t connected() override;
+
+    operator bool() override { return connected(); }
+    bool operator==(const WiFiClient &rhs) const { return m_handle == rhs.m_handle; }
+    bool operator!=(const WiFiClient &rhs) const { return !(*this == rhs); }
+
+    int fd() const;
+    int setNoDelay(bool nodelay);
+    bool getNoDelay();
+    void setConnectionTimeout(uint32_t milliseconds) { m_timeoutMs = milliseconds; }
+
+    IPAddress remoteIP() const;
+    uint16_t remotePort() const;
+    IPAddress localIP() const;
+    uint16_t localPort() const;
+
+    using Print::write;
+
+private:
+    std::shared_ptr<WiFiClientSocketHandle> m_handle;
+    bool m_connected;
+    int32_t m_timeoutMs;
+};
@@ -0,0 +1,66 @@
+#include "WiFiServer.h"
+
+#include "HostPlatform.h"
+
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+void WiFiServer::begin(uint16_t port)
+{
+    if (m_fd >= 0)
+        return;
+    if (port != 0)
+        m_port = port;
+
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (fd < 0)
+        return;
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(hostListenPort(m_port));
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(fd, (sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, m_maxClients) != 0)
+    {
+        fprintf(stderr, "cannot listen on port %u: %s\n", hostListenPort(m_port), strerror(errno));
+        ::close(fd);
+        return;
+    }
+    m_fd = fd;
+}
+
+void WiFiServer::end()
+{
+    if (m_fd >= 0)
+        ::close(m_fd);
+    m_fd = -1;
+}
+
+WiFiClient WiFiServer::accept()
+{
+    if (m_fd < 0)
+        return WiFiClient();
+    int fd = accept4(m_fd, NULL, NULL, SOCK_CLOEXEC);
+    if (fd < 0)
+        return WiFiClient();
+
+    WiFiClient client(fd);
+    if (m_noDelay)
+        client.setNoDelay(true);
+    return client;
+}
+
+bool WiFiServer::hasClient()
+{
+    if (m_fd < 0)
+        return false;
+    pollfd pfd = {m_fd, POLLIN, 0};
+    return poll(&pfd, 1, 0) == 1;
+}
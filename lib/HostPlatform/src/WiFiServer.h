@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Server.h"
+#include "WiFiClient.h"
+
+// Listens on all interfaces; ports below 1024 move up by HOST_PORT_OFFSET (see hostListenPort())
+class WiFiServer : public Server
+{
+public:
+    WiFiServer(uint16_t port = 80, uint8_t maxClients = 4)
+        : m_fd(-1), m_port(port), m_maxClients(maxClients), m_noDelay(false)
+    {
+    }
+    ~WiFiServer() { end(); }
+
+    void begin(uint16_t port = 0) override;
+    void end();
+    void close() { end(); }
+    void stop() { end(); }
+
+    // never waits: an invalid client when nobody is connecting
+    WiFiClient accept();
+    WiFiClient available() { return accept(); }
+    bool hasClient();
+
+    void setNoDelay(bool nodelay) { m_noDelay = nodelay; }
+    bool getNoDelay() { return m_noDelay; }
+    void setTimeout(unsigned long seconds) { (void)seconds; }
+
+    size_t write(uint8_t) override { return 0; }
+    using Print::write;
+
+    operator bool() { return m_fd >= 0; }
+
+private:
+    int m_fd;
+    uint16_t m_port;
+    uint8_t m_maxClients;
+    bool m_noDelay;
+};
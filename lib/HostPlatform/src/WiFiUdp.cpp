@@ -0,0 +1,149 @@
+#include "WiFiUdp.h"
+
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+bool WiFiUDP::open()
+{
+    if (m_fd < 0)
+        m_fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    return m_fd >= 0;
+}
+
+uint8_t WiFiUDP::begin(IPAddress address, uint16_t port)
+{
+    stop();
+    if (!open())
+        return 0;
+    int one = 1;
+    setsockopt(m_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = (uint32_t)address;
+    if (bind(m_fd, (sockaddr *)&addr, sizeof(addr)) != 0)
+    {
+        stop();
+        return 0;
+    }
+    return 1;
+}
+
+void WiFiUDP::stop()
+{
+    if (m_fd >= 0)
+        close(m_fd);
+    m_fd = -1;
+    m_tx.clear();
+    m_rx.clear();
+    m_rxPos = 0;
+}
+
+int WiFiUDP::beginPacket(IPAddress ip, uint16_t port)
+{
+    m_remoteIP = ip;
+    m_remotePort = port;
+    m_tx.clear();
+    return open() ? 1 : 0;
+}
+
+int WiFiUDP::beginPacket(const char *host, uint16_t port)
+{
+    IPAddress ip;
+    if (!ip.fromString(host))
+    {
+        addrinfo hints = {};
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_DGRAM;
+        addrinfo *result;
+        if (getaddrinfo(host, NULL, &hints, &result) != 0)
+            return 0;
+        ip = ((sockaddr_in *)result->ai_addr)->sin_addr.s_addr;
+        freeaddrinfo(result);
+    }
+    return beginPacket(ip, port);
+}
+
+size_t WiFiUDP::write(const uint8_t *buffer, size_t size)
+{
+    // the ESP32 buffers up to a full datagram as well
+    static const size_t UDP_TX_MAX = 1460;
+    if (m_tx.size() + size > UDP_TX_MAX)
+        size = UDP_TX_MAX - m_tx.size();
+    m_tx.append((const char *)buffer, size);
+    return size;
+}
+
+int WiFiUDP::endPacket()
+{
+    if (m_fd < 0)
+        return 0;
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(m_remotePort);
+    addr.sin_addr.s_addr = (uint32_t)m_remoteIP;
+    ssize_t n = sendto(m_fd, m_tx.data(), m_tx.size(), MSG_NOSIGNAL, (sockaddr *)&addr, sizeof(addr));
+    m_tx.clear();
+    return (n >= 0) ? 1 : 0;
+}
+
+int WiFiUDP::parsePacket()
+{
+    m_rx.clear();
+    m_rxPos = 0;
+    if (m_fd < 0)
+        return 0;
+
+    int size = 0;
+    if (ioctl(m_fd, FIONREAD, &size) < 0 || size <= 0)
+    {
+        // an empty datagram also reads as 0, but there is nothing to parse in one either
+        return 0;
+    }
+    m_rx.resize(size);
+    sockaddr_in addr = {};
+    socklen_t len = sizeof(addr);
+    ssize_t n = recvfrom(m_fd, &m_rx[0], size, MSG_DONTWAIT, (sockaddr *)&addr, &len);
+    if (n <= 0)
+    {
+        m_rx.clear();
+        return 0;
+    }
+    m_rx.resize(n);
+    m_remoteIP = addr.sin_addr.s_addr;
+    m_remotePort = ntohs(addr.sin_port);
+    return n;
+}
+
+int WiFiUDP::read()
+{
+    if (m_rxPos >= m_rx.size())
+        return -1;
+    return (uint8_t)m_rx[m_rxPos++];
+}
+
+int WiFiUDP::read(unsigned char *buffer, size_t len)
+{
+    size_t n = m_rx.size() - m_rxPos;
+    if (n > len)
+        n = len;
+    memcpy(buffer, m_rx.data() + m_rxPos, n);
+    m_rxPos += n;
+    return n;
+}
+
+int WiFiUDP::peek()
+{
+    return (m_rxPos < m_rx.size()) ? (uint8_t)m_rx[m_rxPos] : -1;
+}
+
+void WiFiUDP::flush()
+{
+    m_rx.clear();
+    m_rxPos = 0;
+}
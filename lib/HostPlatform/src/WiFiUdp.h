@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+
+#include "Udp.h"
+
+class WiFiUDP : public UDP
+{
+public:
+    WiFiUDP() : m_fd(-1), m_remotePort(0), m_rxPos(0) {}
+    ~WiFiUDP() { stop(); }
+
+    uint8_t begin(IPAddress address, uint16_t port);
+    uint8_t begin(uint16_t port) override { return begin(IPAddress(), port); }
+    void stop() override;
+
+    int beginPacket() { return beginPacket(m_remoteIP, m_remotePort); }
+    int beginPacket(IPAddress ip, uint16_t port) override;
+    int beginPacket(const char *host, uint16_t port) override;
+    int endPacket() override;
+    size_t write(uint8_t data) override { return write(&data, 1); }
+    size_t write(const uint8_t *buffer, size_t size) override;
+
+    int parsePacket() override;
+    int available() override { return m_rx.size() - m_rxPos; }
+    int read() override;
+    int read(unsigned char *buffer, size_t len) override;
+    int read(char *buffer, size_t len) override { return read((unsigned char *)buffer, len); }
+    int peek() override;
+    void flush() override;
+
+    IPAddress remoteIP() override { return m_remoteIP; }
+    uint16_t remotePort() override { return m_remotePort; }
+
+    using Print::write;
+
+private:
+    bool open();
+
+    int m_fd;
+    IPAddress m_remoteIP;
+    uint16_t m_remotePort;
+    std::string m_tx;
+    std::string m_rx;
+    size_t m_rxPos;
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+// Code and data placement means nothing on the host, except for RTC memory: variables marked
+// RTC_DATA_ATTR or RTC_NOINIT_ATTR are collected in one section that hostReboot() saves and
+// the next process restores, so they survive esp_restart() and deep sleep but not a fresh start.
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define IRAM_DATA_ATTR
+#define IRAM_BSS_ATTR
+#define EXT_RAM_ATTR
+#define EXT_RAM_BSS_ATTR
+#define WORD_ALIGNED_ATTR __attribute__((aligned(4)))
+#define NOINLINE_ATTR __attribute__((noinline))
+#define FORCE_INLINE_ATTR static inline __attribute__((always_inline))
+
+#define RTC_DATA_ATTR __attribute__((section("host_rtc_data")))
+#define RTC_RODATA_ATTR RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR RTC_DATA_ATTR
+#define RTC_SLOW_ATTR RTC_DATA_ATTR
+#define RTC_FAST_ATTR RTC_DATA_ATTR
+#define RTC_IRAM_ATTR
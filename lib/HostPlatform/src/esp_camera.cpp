@@ -0,0 +1,191 @@
+#include "esp_camera.h"
+
+#include <Arduino.h>
+#include <FileStreamer.h>
+#include <JPEGSamples.h>
+
+#include "HostPlatform.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+// The "sensor" plays HOST_CAMERA (an MJPEG file or a directory of .jpg files, see MJPEGFile)
+// in a loop at HOST_CAMERA_FPS, or the sample JPEG that ships with Micro-RTSP when it is not
+// set. As on the ESP32, fb_count buffers are allocated once, in PSRAM unless fb_location
+// says DRAM, and sized for the largest frame; a caller holding all of them waits up to the
+// driver's 4 s for one to come back. The frames keep their recorded size whatever frame_size
+// asks for, and both grab modes hand out the frame that is due next.
+
+static const uint32_t FB_GET_TIMEOUT_MS = 4000;
+
+struct HostFrameSource
+{
+    const uint8_t *data;
+    size_t len;
+    size_t width;
+    size_t height;
+};
+
+static std::mutex s_cameraMutex;
+static std::condition_variable s_bufferFree;
+static bool s_initialized = false;
+static MJPEGFile s_footage;
+static std::vector<HostFrameSource> s_frames;
+static std::vector<camera_fb_t *> s_free;
+static std::vector<camera_fb_t *> s_buffers;
+static pixformat_t s_format;
+static uint32_t s_frameUs;
+static uint64_t s_startUs;
+static uint64_t s_next; // frames handed out since init
+
+static bool addFrame(const uint8_t *data, size_t len)
+{
+    u_short width, height;
+    if (!jpegFrameSize(data, len, &width, &height))
+        return false;
+    s_frames.push_back({data, len, width, height});
+    return true;
+}
+
+static void freeBuffers()
+{
+    for (camera_fb_t *fb : s_buffers)
+    {
+        heap_caps_free(fb->buf);
+        delete fb;
+    }
+    s_buffers.clear();
+    s_free.clear();
+}
+
+esp_err_t esp_camera_init(const camera_config_t *config)
+{
+    std::lock_guard<std::mutex> lock(s_cameraMutex);
+    if (s_initialized)
+        return ESP_ERR_INVALID_STATE;
+    if (config->fb_count < 1)
+        return ESP_ERR_INVALID_ARG;
+
+    if (s_frames.empty())
+    {
+        const char *path = hostEnv("HOST_CAMERA", "");
+        if (*path)
+        {
+            if (s_footage.open(path))
+            {
+                for (size_t i = 0; i < s_footage.frameCount(); i++)
+                    addFrame(s_footage.frame(i).data, s_footage.frame(i).len);
+            }
+        }
+        else
+            addFrame(capture_jpg, capture_jpg_len);
+    }
+    if (s_frames.empty())
+    {
+        fprintf(stderr, "camera: no JPEG frames in %s\n", hostEnv("HOST_CAMERA", "the sample"));
+        return ESP_ERR_NOT_FOUND; // what a missing sensor reports
+    }
+
+    size_t largest = 0;
+    for (const HostFrameSource &frame : s_frames)
+        largest = std::max(largest, frame.len);
+
+    uint32_t caps = MALLOC_CAP_8BIT;
+    if (config->fb_location == CAMERA_FB_IN_PSRAM && heap_caps_get_total_size(MALLOC_CAP_SPIRAM) > 0)
+        caps |= MALLOC_CAP_SPIRAM;
+    else
+        caps |= MALLOC_CAP_INTERNAL;
+    for (size_t i = 0; i < config->fb_count; i++)
+    {
+        uint8_t *buf = (uint8_t *)heap_caps_malloc(largest, caps);
+        if (buf == NULL)
+        {
+            freeBuffers();
+            return ESP_ERR_NO_MEM;
+        }
+        camera_fb_t *fb = new camera_fb_t();
+        fb->buf = buf;
+        s_buffers.push_back(fb);
+        s_free.push_back(fb);
+    }
+
+    long fps = hostEnvInt("HOST_CAMERA_FPS", 25);
+    s_frameUs = 1000000 / ((fps > 0) ? fps : 25);
+    s_format = config->pixel_format;
+    s_startUs = esp_timer_get_time();
+    s_next = 0;
+    s_initialized = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_camera_deinit()
+{
+    std::lock_guard<std::mutex> lock(s_cameraMutex);
+    if (!s_initialized)
+        return ESP_ERR_INVALID_STATE;
+    freeBuffers(); // frames still held by the app become dangling, as on the ESP32
+    s_initialized = false;
+    return ESP_OK;
+}
+
+camera_fb_t *esp_camera_fb_get()
+{
+    camera_fb_t *fb;
+    uint64_t dueUs;
+    const HostFrameSource *frame;
+    {
+        std::unique_lock<std::mutex> lock(s_cameraMutex);
+        if (!s_initialized)
+            return NULL;
+        if (!s_bufferFree.wait_for(lock, std::chrono::milliseconds(FB_GET_TIMEOUT_MS),
+                                   []() { return !s_free.empty() || !s_initialized; }) ||
+            !s_initialized)
+        {
+            fprintf(stderr, "camera: failed to get the frame on time\n");
+            return NULL;
+        }
+        fb = s_free.back();
+        s_free.pop_back();
+
+        // a reader that falls behind gets the frame that is current, not a backlog
+        uint64_t now = esp_timer_get_time();
+        uint64_t current = (now - s_startUs) / s_frameUs;
+        if (s_next < current)
+            s_next = current;
+        dueUs = s_startUs + s_next * s_frameUs;
+        frame = &s_frames[s_next % s_frames.size()];
+        s_next++;
+    }
+
+    // the sensor delivers at its frame rate
+    int64_t waitUs = (int64_t)(dueUs - esp_timer_get_time());
+    if (waitUs > 0)
+        delayMicroseconds(waitUs);
+
+    memcpy(fb->buf, frame->data, frame->len);
+    fb->len = frame->len;
+    fb->width = frame->width;
+    fb->height = frame->height;
+    fb->format = s_format;
+    int64_t nowUs = esp_timer_get_time(); // like the driver, time since boot rather than wall time
+    fb->timestamp.tv_sec = nowUs / 1000000;
+    fb->timestamp.tv_usec = nowUs % 1000000;
+    return fb;
+}
+
+void esp_camera_fb_return(camera_fb_t *fb)
+{
+    if (fb == NULL)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(s_cameraMutex);
+        if (!s_initialized)
+            return;
+        s_free.push_back(fb);
+    }
+    s_bufferFree.notify_one();
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// The IDF 4.4 interface. A thread checks the subscribed tasks every 100 ms; one that has not
+// reset its timer within the timeout is reported on stderr like the ESP32 reports it, and with
+// panic set the app restarts with ESP_RST_TASK_WDT. The idle tasks the ESP32 subscribes have
+// no counterpart here.
+esp_err_t esp_task_wdt_init(uint32_t timeout, bool panic);
+esp_err_t esp_task_wdt_deinit(void);
+esp_err_t esp_task_wdt_add(TaskHandle_t handle); // NULL is the calling task
+esp_err_t esp_task_wdt_reset(void);
+esp_err_t esp_task_wdt_delete(TaskHandle_t handle);
+esp_err_t esp_task_wdt_status(TaskHandle_t handle);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// microseconds since the app started, the clock millis() and micros() are cut from
+int64_t esp_timer_get_time(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Queues copy items in and out as in FreeRTOS. Semaphores are queues of zero sized items.
+
+typedef struct HostQueue *QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t uxQueueLength, UBaseType_t uxItemSize);
+void vQueueDelete(QueueHandle_t xQueue);
+BaseType_t xQueueSendToBack(QueueHandle_t xQueue, const void *pvItemToQueue, TickType_t xTicksToWait);
+BaseType_t xQueueSendToFront(QueueHandle_t xQueue, const void *pvItemToQueue, TickType_t xTicksToWait);
+BaseType_t xQueueOverwrite(QueueHandle_t xQueue, const void *pvItemToQueue);
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void *pvBuffer, TickType_t xTicksToWait);
+BaseType_t xQueuePeek(QueueHandle_t xQueue, void *pvBuffer, TickType_t xTicksToWait);
+UBaseType_t uxQueueMessagesWaiting(const QueueHandle_t xQueue);
+UBaseType_t uxQueueSpacesAvailable(const QueueHandle_t xQueue);
+BaseType_t xQueueReset(QueueHandle_t xQueue);
+
+#define xQueueSend(xQueue, pvItemToQueue, xTicksToWait) xQueueSendToBack(xQueue, pvItemToQueue, xTicksToWait)
+#define xQueueSendFromISR(xQueue, pvItemToQueue, pxWoken) xQueueSendToBack(xQueue, pvItemToQueue, 0)
+#define xQueueSendToBackFromISR(xQueue, pvItemToQueue, pxWoken) xQueueSendToBack(xQueue, pvItemToQueue, 0)
+#define xQueueSendToFrontFromISR(xQueue, pvItemToQueue, pxWoken) xQueueSendToFront(xQueue, pvItemToQueue, 0)
+#define xQueueOverwriteFromISR(xQueue, pvItemToQueue, pxWoken) xQueueOverwrite(xQueue, pvItemToQueue)
+#define xQueueReceiveFromISR(xQueue, pvBuffer, pxWoken) xQueueReceive(xQueue, pvBuffer, 0)
+#define uxQueueMessagesWaitingFromISR(xQueue) uxQueueMessagesWaiting(xQueue)
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Software timers. A service thread keeps the expiry times and hands expired timers to a pool
+// of HOST_TIMER_THREADS "Tmr Svc" tasks. The default of one runs every callback in turn, as
+// the FreeRTOS timer task does; more let slow callbacks overlap, but a timer never runs
+// concurrently with itself.
+
+typedef struct HostTimer *TimerHandle_t;
+typedef void (*TimerCallbackFunction_t)(TimerHandle_t xTimer);
+typedef void (*PendedFunction_t)(void *, uint32_t);
+
+TimerHandle_t xTimerCreate(const char *pcTimerName, const TickType_t xTimerPeriodInTicks, const UBaseType_t uxAutoReload,
+                           void *const pvTimerID, TimerCallbackFunction_t pxCallbackFunction);
+BaseType_t xTimerStart(TimerHandle_t xTimer, TickType_t xTicksToWait);
+BaseType_t xTimerStop(TimerHandle_t xTimer, TickType_t xTicksToWait);
+BaseType_t xTimerReset(TimerHandle_t xTimer, TickType_t xTicksToWait);
+BaseType_t xTimerChangePeriod(TimerHandle_t xTimer, TickType_t xNewPeriod, TickType_t xTicksToWait);
+BaseType_t xTimerDelete(TimerHandle_t xTimer, TickType_t xTicksToWait);
+BaseType_t xTimerIsTimerActive(TimerHandle_t xTimer);
+void *pvTimerGetTimerID(const TimerHandle_t xTimer);
+void vTimerSetTimerID(TimerHandle_t xTimer, void *pvNewID);
+const char *pcTimerGetName(TimerHandle_t xTimer);
+TickType_t xTimerGetPeriod(TimerHandle_t xTimer);
+TickType_t xTimerGetExpiryTime(TimerHandle_t xTimer);
+BaseType_t xTimerPendFunctionCall(PendedFunction_t xFunctionToPend, void *pvParameter1, uint32_t ulParameter2,
+                                  TickType_t xTicksToWait);
+
+#define xTimerStartFromISR(xTimer, pxWoken) xTimerStart(xTimer, 0)
+#define xTimerStopFromISR(xTimer, pxWoken) xTimerStop(xTimer, 0)
+#define xTimerResetFromISR(xTimer, pxWoken) xTimerReset(xTimer, 0)
+#define xTimerChangePeriodFromISR(xTimer, xNewPeriod, pxWoken) xTimerChangePeriod(xTimer, xNewPeriod, 0)
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <stdint.h>
+
+// there are no registers: writes are dropped and reads return 0
+
+#define DR_REG_RTCCNTL_BASE 0x3ff48000
+#define RTC_CNTL_BROWN_OUT_REG (DR_REG_RTCCNTL_BASE + 0xd4)
+
+#define WRITE_PERI_REG(addr, val) ((void)(addr), (void)(val))
+#define READ_PERI_REG(addr) ((void)(addr), (uint32_t)0)
+#define SET_PERI_REG_MASK(reg, mask) ((void)(reg), (void)(mask))
+#define CLEAR_PERI_REG_MASK(reg, mask) ((void)(reg), (void)(mask))
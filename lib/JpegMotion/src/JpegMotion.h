@@ -0,0 +1,544 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Motion detection on the JPEG frames the camera already produces, without decoding them.
+//
+// JpegDcDecoder reads a baseline JPEG's entropy-coded data only far enough to recover the DC
+// coefficient of every luminance block, which is that block's mean brightness. The AC
+// coefficients still have to be Huffman-decoded to find where the next block starts, but they
+// are skipped: there is no dequantisation, no IDCT, no colour conversion and no output image.
+// The block means are averaged into a grid of a few hundred cells.
+//
+// MotionDetector keeps a slowly adapting background of that grid and counts the cells, inside
+// the enabled zones, that differ from it by more than a threshold. A change in the brightness
+// of the whole scene (lights, auto exposure) is subtracted first, so it does not count.
+
+#ifndef JPEG_DC_LOOKAHEAD
+#define JPEG_DC_LOOKAHEAD 9 // Huffman codes up to this many bits are decoded with one table lookup
+#endif
+
+class JpegDcDecoder
+{
+public:
+    JpegDcDecoder() : m_componentCount(0), m_width(0), m_height(0), m_restartInterval(0)
+    {
+        for (int i = 0; i < 4; i++)
+            m_dcQuant[i] = 1;
+    }
+
+    // Averages the brightness (0..255) of the luminance blocks into cols x rows cells. sums and
+    // counts hold cols * rows entries and are overwritten. False if the frame is not a baseline
+    // JPEG with 8 bit samples, or is damaged.
+    bool decode(const uint8_t *jpeg, size_t len, uint32_t *sums, uint16_t *counts, uint16_t cols, uint16_t rows)
+    {
+        memset(sums, 0, cols * rows * sizeof(uint32_t));
+        memset(counts, 0, cols * rows * sizeof(uint16_t));
+        m_componentCount = 0;
+        m_restartInterval = 0;
+        m_width = m_height = 0;
+        // every frame brings its own tables, none are kept from the last one
+        for (int i = 0; i < 4; i++)
+            m_huffman[i / 2][i % 2].defined = false;
+
+        if (len < 4 || jpeg[0] != 0xFF || jpeg[1] != 0xD8)
+            return false;
+
+        size_t pos = 2;
+        while (pos + 4 <= len)
+        {
+            if (jpeg[pos] != 0xFF)
+                return false;
+            uint8_t marker = jpeg[pos + 1];
+            if (marker == 0xFF)
+            {
+                pos++; // fill byte
+                continue;
+            }
+            size_t segLen = (jpeg[pos + 2] << 8) | jpeg[pos + 3];
+            if (segLen < 2 || pos + 2 + segLen > len)
+                return false;
+            const uint8_t *seg = jpeg + pos + 4;
+            segLen -= 2;
+
+            switch (marker)
+            {
+            case 0xDB:
+                if (!readQuantTables(seg, segLen))
+                    return false;
+                break;
+            case 0xC4:
+                if (!readHuffmanTables(seg, segLen))
+                    return false;
+                break;
+            case 0xC0:
+            case 0xC1:
+                if (!readFrame(seg, segLen))
+                    return false;
+                break;
+            case 0xC2: case 0xC3: case 0xC5: case 0xC6: case 0xC7:
+            case 0xC9: case 0xCA: case 0xCB: case 0xCD: case 0xCE: case 0xCF:
+                return false; // progressive, lossless, hierarchical or arithmetic coded
+            case 0xDD:
+                if (segLen < 2)
+                    return false;
+                m_restartInterval = (seg[0] << 8) | seg[1];
+                break;
+            case 0xDA:
+                if (!readScan(seg, segLen))
+                    return false;
+                m_pos = seg + segLen;
+                m_end = jpeg + len;
+                return decodeScan(sums, counts, cols, rows);
+            }
+            pos += 2 + 2 + segLen;
+        }
+        return false;
+    }
+
+    uint16_t width() const { return m_width; }
+    uint16_t height() const { return m_height; }
+
+private:
+    struct Huffman
+    {
+        uint16_t lookup[1 << JPEG_DC_LOOKAHEAD]; // symbol | length << 8, 0 for longer codes
+        int32_t maxCode[17];
+        int32_t valOffset[17]; // values[code + valOffset[length]]
+        uint8_t values[256];
+        bool defined;
+    };
+
+    struct Component
+    {
+        uint8_t id;
+        uint8_t h;
+        uint8_t v;
+        uint8_t tq;
+        uint8_t td;
+        uint8_t ta;
+        int32_t pred;
+    };
+
+    bool readQuantTables(const uint8_t *seg, size_t len)
+    {
+        size_t i = 0;
+        while (i < len)
+        {
+            uint8_t pq = seg[i] >> 4;
+            uint8_t tq = seg[i] & 0x0F;
+            size_t size = (pq ? 128 : 64);
+            if (tq > 3 || i + 1 + size > len)
+                return false;
+            // only the DC entry is ever needed
+            m_dcQuant[tq] = pq ? ((seg[i + 1] << 8) | seg[i + 2]) : seg[i + 1];
+            i += 1 + size;
+        }
+        return true;
+    }
+
+    bool readHuffmanTables(const uint8_t *seg, size_t len)
+    {
+        size_t i = 0;
+        while (i + 17 <= len)
+        {
+            uint8_t tc = seg[i] >> 4;
+            uint8_t th = seg[i] & 0x0F;
+            if (tc > 1 || th > 1)
+                return false;
+            Huffman &h = m_huffman[tc][th];
+            const uint8_t *bits = seg + i + 1;
+            size_t total = 0;
+            for (int l = 0; l < 16; l++)
+                total += bits[l];
+            if (total > 256 || i + 17 + total > len)
+                return false;
+            memcpy(h.values, seg + i + 17, total);
+
+            // canonical codes (JPEG F.2.2.3), plus the lookup table for the short ones
+            memset(h.lookup, 0, sizeof(h.lookup));
+            int32_t code = 0;
+            int32_t k = 0;
+            for (int l = 1; l <= 16; l++)
+            {
+                int n = bits[l - 1];
+                h.valOffset[l] = k - code;
+                if (code + n > (1 << l))
+                    return false; // more codes than this length has
+                for (int j = 0; j < n; j++, code++, k++)
+                {
+                    if (l <= JPEG_DC_LOOKAHEAD)
+                    {
+                        int shift = JPEG_DC_LOOKAHEAD - l;
+                        for (int f = 0; f < (1 << shift); f++)
+                            h.lookup[(code << shift) | f] = h.values[k] | (l << 8);
+                    }
+                }
+                h.maxCode[l] = n ? code - 1 : -1;
+                code <<= 1;
+            }
+            h.defined = true;
+            i += 17 + total;
+        }
+        return i == len;
+    }
+
+    bool readFrame(const uint8_t *seg, size_t len)
+    {
+        if (len < 6 || seg[0] != 8)
+            return false;
+        m_height = (seg[1] << 8) | seg[2];
+        m_width = (seg[3] << 8) | seg[4];
+        m_componentCount = seg[5];
+        if (m_width == 0 || m_height == 0 || m_componentCount == 0 || m_componentCount > 3 ||
+            len < 6 + 3 * (size_t)m_componentCount)
+            return false;
+
+        m_hMax = m_vMax = 1;
+        for (int c = 0; c < m_componentCount; c++)
+        {
+            Component &comp = m_components[c];
+            comp.id = seg[6 + 3 * c];
+            comp.h = seg[7 + 3 * c] >> 4;
+            comp.v = seg[7 + 3 * c] & 0x0F;
+            comp.tq = seg[8 + 3 * c] & 0x03;
+            if (comp.h == 0 || comp.h > 4 || comp.v == 0 || comp.v > 4)
+                return false;
+            if (comp.h > m_hMax)
+                m_hMax = comp.h;
+            if (comp.v > m_vMax)
+                m_vMax = comp.v;
+        }
+        return true;
+    }
+
+    // only single scans holding every component are supported, which is what baseline
+    // encoders (and the camera) produce
+    bool readScan(const uint8_t *seg, size_t len)
+    {
+        if (m_componentCount == 0 || len < 1 || seg[0] != m_componentCount || len < 1 + 2 * (size_t)seg[0] + 3)
+            return false;
+        for (int i = 0; i < m_componentCount; i++)
+        {
+            Component &comp = m_components[i];
+            if (comp.id != seg[1 + 2 * i])
+                return false;
+            comp.td = seg[2 + 2 * i] >> 4;
+            comp.ta = seg[2 + 2 * i] & 0x0F;
+            if (comp.td > 1 || comp.ta > 1 || !m_huffman[0][comp.td].defined || !m_huffman[1][comp.ta].defined)
+                return false;
+        }
+        return true;
+    }
+
+    bool decodeScan(uint32_t *sums, uint16_t *counts, uint16_t cols, uint16_t rows)
+    {
+        // a single component scan is not interleaved: one block per MCU, whatever the sampling
+        const Component &luma = m_components[0];
+        uint8_t lumaH = (m_componentCount == 1) ? 1 : luma.h;
+        uint8_t lumaV = (m_componentCount == 1) ? 1 : luma.v;
+        uint32_t mcuW = (m_componentCount == 1) ? 8 : 8 * m_hMax;
+        uint32_t mcuH = (m_componentCount == 1) ? 8 : 8 * m_vMax;
+        uint32_t mcusX = (m_width + mcuW - 1) / mcuW;
+        uint32_t mcusY = (m_height + mcuH - 1) / mcuH;
+
+        // luminance blocks that cover the picture, the rest is padding
+        uint32_t blocksX = ((uint32_t)m_width * luma.h / m_hMax + 7) / 8;
+        uint32_t blocksY = ((uint32_t)m_height * luma.v / m_vMax + 7) / 8;
+        int32_t quant = m_dcQuant[luma.tq];
+
+        m_bits = 0;
+        m_bitCount = 0;
+        m_padBytes = 0;
+        for (int c = 0; c < m_componentCount; c++)
+            m_components[c].pred = 0;
+
+        uint32_t restartsLeft = m_restartInterval;
+        for (uint32_t my = 0; my < mcusY; my++)
+        {
+            for (uint32_t mx = 0; mx < mcusX; mx++)
+            {
+                if (m_restartInterval)
+                {
+                    if (restartsLeft == 0)
+                    {
+                        if (!restart())
+                            return false;
+                        restartsLeft = m_restartInterval;
+                    }
+                    restartsLeft--;
+                }
+
+                for (int c = 0; c < m_componentCount; c++)
+                {
+                    Component &comp = m_components[c];
+                    int blocks = (m_componentCount == 1) ? 1 : comp.h * comp.v;
+                    for (int b = 0; b < blocks; b++)
+                    {
+                        int32_t dc;
+                        if (!decodeBlock(comp, dc))
+                            return false;
+                        if (c != 0)
+                            continue;
+
+                        uint32_t bx = mx * lumaH + b % lumaH;
+                        uint32_t by = my * lumaV + b / lumaH;
+                        if (bx >= blocksX || by >= blocksY)
+                            continue;
+
+                        // the DC coefficient is 8 times the block's mean less 128
+                        int32_t mean = dc * quant / 8 + 128;
+                        mean = mean < 0 ? 0 : (mean > 255 ? 255 : mean);
+                        uint32_t cell = (by * rows / blocksY) * cols + bx * cols / blocksX;
+                        sums[cell] += mean;
+                        counts[cell]++;
+                    }
+                }
+                if (m_padBytes > 4)
+                    return false; // ran past the end of the data
+            }
+        }
+        return true;
+    }
+
+    bool decodeBlock(Component &comp, int32_t &dc)
+    {
+        int s = decodeSymbol(m_huffman[0][comp.td]);
+        if (s < 0 || s > 11)
+            return false;
+        comp.pred += receiveExtend(s);
+        dc = comp.pred;
+
+        const Huffman &ac = m_huffman[1][comp.ta];
+        for (int k = 1; k < 64;)
+        {
+            int rs = decodeSymbol(ac);
+            if (rs < 0)
+                return false;
+            int r = rs >> 4;
+            s = rs & 0x0F;
+            if (s == 0)
+            {
+                if (r != 15)
+                    break; // end of block
+                k += 16;
+                continue;
+            }
+            skipBits(s);
+            k += r + 1;
+        }
+        return true;
+    }
+
+    // keeps at least 25 bits in m_bits; past a marker or the end, zeros are shifted in
+    void fill()
+    {
+        while (m_bitCount <= 24)
+        {
+            uint32_t byte = 0;
+            if (m_pos < m_end && m_pos[0] == 0xFF && m_pos + 1 < m_end && m_pos[1] == 0x00)
+            {
+                byte = 0xFF;
+                m_pos += 2;
+            }
+            else if (m_pos < m_end && m_pos[0] != 0xFF)
+                byte = *m_pos++;
+            else
+                m_padBytes++;
+            m_bits |= byte << (24 - m_bitCount);
+            m_bitCount += 8;
+        }
+    }
+
+    int decodeSymbol(const Huffman &h)
+    {
+        fill();
+        uint16_t entry = h.lookup[m_bits >> (32 - JPEG_DC_LOOKAHEAD)];
+        if (entry)
+        {
+            skipBits(entry >> 8);
+            return entry & 0xFF;
+        }
+        for (int l = JPEG_DC_LOOKAHEAD + 1; l <= 16; l++)
+        {
+            int32_t code = m_bits >> (32 - l);
+            if (code <= h.maxCode[l])
+            {
+                skipBits(l);
+                return h.values[code + h.valOffset[l]];
+            }
+        }
+        return -1;
+    }
+
+    void skipBits(int n)
+    {
+        fill();
+        m_bits <<= n;
+        m_bitCount -= n;
+    }
+
+    int32_t receiveExtend(int s)
+    {
+        if (s == 0)
+            return 0;
+        fill();
+        int32_t v = m_bits >> (32 - s);
+        m_bits <<= s;
+        m_bitCount -= s;
+        return v < (1 << (s - 1)) ? v - (1 << s) + 1 : v;
+    }
+
+    // drops the rest of the byte, steps over the next RSTn marker and resets the predictions
+    bool restart()
+    {
+        m_bits = 0;
+        m_bitCount = 0;
+        m_padBytes = 0;
+        while (m_pos + 1 < m_end && !(m_pos[0] == 0xFF && m_pos[1] >= 0xD0 && m_pos[1] <= 0xD7))
+            m_pos++;
+        if (m_pos + 1 >= m_end)
+            return false;
+        m_pos += 2;
+        for (int c = 0; c < m_componentCount; c++)
+            m_components[c].pred = 0;
+        return true;
+    }
+
+    Huffman m_huffman[2][2]; // [DC, AC][table]
+    uint16_t m_dcQuant[4];
+    Component m_components[3];
+    uint8_t m_componentCount;
+    uint8_t m_hMax;
+    uint8_t m_vMax;
+    uint16_t m_width;
+    uint16_t m_height;
+    uint16_t m_restartInterval;
+
+    const uint8_t *m_pos;
+    const uint8_t *m_end;
+    uint32_t m_bits; // next bits of the scan, most significant first
+    int m_bitCount;
+    uint32_t m_padBytes;
+};
+
+template <uint16_t Cols, uint16_t Rows>
+class MotionDetector
+{
+public:
+    static const size_t Cells = (size_t)Cols * Rows;
+
+    MotionDetector() : m_threshold(20), m_minCells(4), m_learnShift(4), m_width(0), m_height(0),
+                       m_frames(0), m_changed(0), m_motion(false), m_errors(0)
+    {
+        setZone(0, 0, Cols - 1, Rows - 1, true);
+    }
+
+    // how far (0..255) a cell must be from the background to count as changed
+    void setThreshold(uint8_t threshold) { m_threshold = threshold; }
+    uint8_t threshold() const { return m_threshold; }
+
+    // changed cells needed for motion
+    void setMinCells(uint16_t minCells) { m_minCells = minCells; }
+    uint16_t minCells() const { return m_minCells; }
+
+    // each frame moves the background 1/2^shift of the way to it; changed cells 8 times slower,
+    // so something that stops in the picture becomes background after a while
+    void setLearnShift(uint8_t shift) { m_learnShift = shift; }
+
+    // enables or disables the cells x0..x1, y0..y1 (inclusive); all are enabled to start with
+    void setZone(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, bool enabled)
+    {
+        for (uint16_t y = y0; y <= y1 && y < Rows; y++)
+            for (uint16_t x = x0; x <= x1 && x < Cols; x++)
+                m_zones[y * Cols + x] = enabled;
+    }
+
+    bool zone(uint16_t x, uint16_t y) const { return m_zones[y * Cols + x]; }
+
+    // Compares a frame with the background and learns from it. The number of changed cells
+    // inside the zones, -1 if the frame could not be read.
+    int update(const uint8_t *jpeg, size_t len)
+    {
+        if (!m_decoder.decode(jpeg, len, m_sums, m_counts, Cols, Rows))
+        {
+            m_errors++;
+            return -1;
+        }
+
+        for (size_t i = 0; i < Cells; i++)
+            m_luma[i] = m_counts[i] ? m_sums[i] / m_counts[i] : 0;
+
+        // a new size starts over, there is nothing to compare with
+        if (m_frames == 0 || m_decoder.width() != m_width || m_decoder.height() != m_height)
+        {
+            m_width = m_decoder.width();
+            m_height = m_decoder.height();
+            for (size_t i = 0; i < Cells; i++)
+                m_background[i] = m_luma[i] << 8;
+            m_frames = 1;
+            m_changed = 0;
+            m_motion = false;
+            return 0;
+        }
+        m_frames++;
+
+        // the scene as a whole getting brighter or darker is not motion
+        int32_t offset = 0;
+        int32_t zoneCells = 0;
+        for (size_t i = 0; i < Cells; i++)
+        {
+            if (m_zones[i] && m_counts[i])
+            {
+                offset += ((int32_t)m_luma[i] << 8) - m_background[i];
+                zoneCells++;
+            }
+        }
+        if (zoneCells)
+            offset /= zoneCells;
+
+        uint16_t changed = 0;
+        for (size_t i = 0; i < Cells; i++)
+        {
+            int32_t diff = ((int32_t)m_luma[i] << 8) - m_background[i];
+            bool cellChanged = abs32(diff - offset) > ((int32_t)m_threshold << 8);
+            if (cellChanged && m_zones[i] && m_counts[i])
+                changed++;
+            m_background[i] += diff / (1 << (cellChanged ? m_learnShift + 3 : m_learnShift));
+        }
+
+        m_changed = changed;
+        m_motion = changed >= m_minCells;
+        return changed;
+    }
+
+    bool motion() const { return m_motion; }
+    uint16_t changed() const { return m_changed; }
+    uint32_t frames() const { return m_frames; }
+    uint32_t errors() const { return m_errors; } // frames that could not be read
+
+    // the cells of the last frame and of the background, 0..255, row by row
+    const uint8_t *luma() const { return m_luma; }
+    uint8_t background(size_t cell) const { return m_background[cell] >> 8; }
+
+private:
+    static int32_t abs32(int32_t v) { return v < 0 ? -v : v; }
+
+    JpegDcDecoder m_decoder;
+    uint32_t m_sums[Cells];
+    uint16_t m_counts[Cells];
+    uint8_t m_luma[Cells];
+    int32_t m_background[Cells]; // 8.8 fixed point
+    bool m_zones[Cells];
+    uint8_t m_threshold;
+    uint16_t m_minCells;
+    uint8_t m_learnShift;
+    uint16_t m_width;
+    uint16_t m_height;
+    uint32_t m_frames;
+    uint16_t m_changed;
+    bool m_motion;
+    uint32_t m_errors;
+};
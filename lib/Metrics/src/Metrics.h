@@ -0,0 +1,296 @@
+#pragma once
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <atomic>
+
+// Counters, gauges and latency histograms that any task can update without a lock.
+//
+// Metrics are objects with static storage duration. Each one links itself into a global
+// list when it is constructed, so a module only defines its metrics at file scope and the
+// exporters find them:
+//
+//   static MetricHistogram s_sendTime("rtsp_packet_send_seconds", "Time to send one RTP packet");
+//   ...
+//   { MetricTimer t(s_sendTime); send(...); }
+//
+// A histogram has fixed log-scale buckets: the first one is METRICS_FIRST_BUCKET_US wide
+// and each later one doubles, so recording a sample costs a count-leading-zeros and two
+// relaxed atomic adds. Values are 32 bit. A counter that wraps looks like a restart to
+// Prometheus, which handles that.
+//
+// metricsWritePrometheus() produces the Prometheus text format, with times in seconds.
+// metricsWriteJson() produces a compact summary (count, sum and estimated quantiles in
+// milliseconds) that is small enough to publish over MQTT.
+
+#ifndef METRICS_BUCKETS
+#define METRICS_BUCKETS 16 // finite histogram buckets, the +Inf bucket comes on top
+#endif
+
+#ifndef METRICS_FIRST_BUCKET_US
+#define METRICS_FIRST_BUCKET_US 16 // must be a power of two; 16 buckets then reach 0.5 s
+#endif
+
+static_assert((METRICS_FIRST_BUCKET_US & (METRICS_FIRST_BUCKET_US - 1)) == 0,
+              "METRICS_FIRST_BUCKET_US must be a power of two");
+
+#ifdef ARDUINO
+#include <Arduino.h>
+inline uint32_t metricsMicros() { return micros(); }
+#else
+#include <time.h>
+inline uint32_t metricsMicros()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+}
+#endif
+
+// where the exporters write to; see MetricsPrintOut for an Arduino Print
+class MetricsOut
+{
+public:
+    virtual ~MetricsOut() {}
+    virtual void write(const char *text, size_t len) = 0;
+
+    void printf(const char *fmt, ...)
+    {
+        char buf[160];
+        va_list args;
+        va_start(args, fmt);
+        int n = vsnprintf(buf, sizeof(buf), fmt, args);
+        va_end(args);
+        if (n > 0)
+            write(buf, ((size_t)n < sizeof(buf)) ? n : sizeof(buf) - 1);
+    }
+};
+
+#ifdef ARDUINO
+class MetricsPrintOut : public MetricsOut
+{
+public:
+    explicit MetricsPrintOut(Print &out) : m_out(out) {}
+    virtual void write(const char *text, size_t len) { m_out.write((const uint8_t *)text, len); }
+
+private:
+    Print &m_out;
+};
+#endif
+
+class Metric
+{
+public:
+    Metric(const char *name, const char *help) : m_name(name), m_help(help), m_next(head())
+    {
+        head() = this;
+    }
+    virtual ~Metric() {}
+
+    const char *name() const { return m_name; }
+    const Metric *next() const { return m_next; }
+    static const Metric *first() { return head(); }
+
+    virtual void writePrometheus(MetricsOut &out) const = 0;
+    virtual void writeJson(MetricsOut &out) const = 0; // "name":value
+
+protected:
+    void writeHeader(MetricsOut &out, const char *type) const
+    {
+        out.printf("# HELP %s %s\n# TYPE %s %s\n", m_name, m_help, m_name, type);
+    }
+
+private:
+    // a function local static, so metrics in other translation units can register
+    // during static initialisation in any order
+    static Metric *&head()
+    {
+        static Metric *list = NULL;
+        return list;
+    }
+
+    const char *m_name;
+    const char *m_help;
+    Metric *m_next;
+};
+
+class MetricCounter : public Metric
+{
+public:
+    MetricCounter(const char *name, const char *help) : Metric(name, help), m_value(0) {}
+
+    void add(uint32_t n = 1) { m_value.fetch_add(n, std::memory_order_relaxed); }
+    uint32_t value() const { return m_value.load(std::memory_order_relaxed); }
+
+    virtual void writePrometheus(MetricsOut &out) const
+    {
+        writeHeader(out, "counter");
+        out.printf("%s %lu\n", name(), (unsigned long)value());
+    }
+
+    virtual void writeJson(MetricsOut &out) const
+    {
+        out.printf("\"%s\":%lu", name(), (unsigned long)value());
+    }
+
+private:
+    std::atomic<uint32_t> m_value;
+};
+
+// either set() from the code that knows the value, or give a function that is called
+// whenever the metrics are exported
+class MetricGauge : public Metric
+{
+public:
+    typedef double (*ReadFn)();
+
+    MetricGauge(const char *name, const char *help, ReadFn read = NULL)
+        : Metric(name, help), m_read(read), m_value(0) {}
+
+    void set(int32_t v) { m_value.store(v, std::memory_order_relaxed); }
+    double value() const { return m_read ? m_read() : (double)m_value.load(std::memory_order_relaxed); }
+
+    virtual void writePrometheus(MetricsOut &out) const
+    {
+        writeHeader(out, "gauge");
+        out.printf("%s %.9g\n", name(), value());
+    }
+
+    virtual void writeJson(MetricsOut &out) const
+    {
+        out.printf("\"%s\":%.9g", name(), value());
+    }
+
+private:
+    ReadFn m_read;
+    std::atomic<int32_t> m_value;
+};
+
+// durations in microseconds
+class MetricHistogram : public Metric
+{
+public:
+    MetricHistogram(const char *name, const char *help) : Metric(name, help), m_sumLow(0), m_sumHigh(0)
+    {
+        for (int i = 0; i <= METRICS_BUCKETS; i++)
+            m_buckets[i].store(0, std::memory_order_relaxed);
+    }
+
+    void observe(uint32_t us)
+    {
+        m_buckets[bucketOf(us)].fetch_add(1, std::memory_order_relaxed);
+        // 64 bit sum from two 32 bit atomics: whoever wraps the low word carries
+        uint32_t old = m_sumLow.fetch_add(us, std::memory_order_relaxed);
+        if (old + us < old)
+            m_sumHigh.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // upper bound of bucket i in microseconds, bucket METRICS_BUCKETS is +Inf
+    static uint32_t bucketLimit(int i) { return (uint32_t)METRICS_FIRST_BUCKET_US << i; }
+
+    static int bucketOf(uint32_t us)
+    {
+        if (us <= METRICS_FIRST_BUCKET_US)
+            return 0;
+        int i = 32 - __builtin_clz((us - 1) / METRICS_FIRST_BUCKET_US);
+        return (i < METRICS_BUCKETS) ? i : METRICS_BUCKETS;
+    }
+
+    uint32_t count() const
+    {
+        uint32_t n = 0;
+        for (int i = 0; i <= METRICS_BUCKETS; i++)
+            n += m_buckets[i].load(std::memory_order_relaxed);
+        return n;
+    }
+
+    uint64_t sum() const
+    {
+        return ((uint64_t)m_sumHigh.load(std::memory_order_relaxed) << 32) | m_sumLow.load(std::memory_order_relaxed);
+    }
+
+    // estimate in microseconds, interpolated inside the bucket holding the q-th sample;
+    // samples in the +Inf bucket are reported as the last finite limit
+    double quantile(double q) const
+    {
+        uint32_t counts[METRICS_BUCKETS + 1];
+        uint32_t total = 0;
+        for (int i = 0; i <= METRICS_BUCKETS; i++)
+            total += counts[i] = m_buckets[i].load(std::memory_order_relaxed);
+        if (total == 0)
+            return 0;
+
+        double target = q * total;
+        double below = 0;
+        for (int i = 0; i < METRICS_BUCKETS; i++)
+        {
+            if ((counts[i] > 0) && (below + counts[i] >= target))
+            {
+                double lower = (i == 0) ? 0 : bucketLimit(i - 1);
+                return lower + (bucketLimit(i) - lower) * (target - below) / counts[i];
+            }
+            below += counts[i];
+        }
+        return bucketLimit(METRICS_BUCKETS - 1);
+    }
+
+    virtual void writePrometheus(MetricsOut &out) const
+    {
+        writeHeader(out, "histogram");
+        uint32_t cumulative = 0;
+        for (int i = 0; i < METRICS_BUCKETS; i++)
+        {
+            cumulative += m_buckets[i].load(std::memory_order_relaxed);
+            out.printf("%s_bucket{le=\"%.6f\"} %lu\n", name(), bucketLimit(i) / 1e6, (unsigned long)cumulative);
+        }
+        cumulative += m_buckets[METRICS_BUCKETS].load(std::memory_order_relaxed);
+        out.printf("%s_bucket{le=\"+Inf\"} %lu\n", name(), (unsigned long)cumulative);
+        out.printf("%s_sum %.6f\n%s_count %lu\n", name(), sum() / 1e6, name(), (unsigned long)cumulative);
+    }
+
+    virtual void writeJson(MetricsOut &out) const
+    {
+        out.printf("\"%s\":{\"count\":%lu,\"sum_ms\":%.3f,\"p50_ms\":%.3f,\"p99_ms\":%.3f}", name(),
+                   (unsigned long)count(), sum() / 1e3, quantile(0.5) / 1e3, quantile(0.99) / 1e3);
+    }
+
+private:
+    std::atomic<uint32_t> m_buckets[METRICS_BUCKETS + 1];
+    std::atomic<uint32_t> m_sumLow;
+    std::atomic<uint32_t> m_sumHigh;
+};
+
+// observes the time from construction to the end of the scope
+class MetricTimer
+{
+public:
+    explicit MetricTimer(MetricHistogram &h) : m_h(h), m_start(metricsMicros()) {}
+    ~MetricTimer() { m_h.observe(metricsMicros() - m_start); }
+
+private:
+    MetricTimer(const MetricTimer &);
+    MetricTimer &operator=(const MetricTimer &);
+
+    MetricHistogram &m_h;
+    uint32_t m_start;
+};
+
+inline void metricsWritePrometheus(MetricsOut &out)
+{
+    for (const Metric *m = Metric::first(); m != NULL; m = m->next())
+        m->writePrometheus(out);
+}
+
+inline void metricsWriteJson(MetricsOut &out)
+{
+    out.write("{", 1);
+    for (const Metric *m = Metric::first(); m != NULL; m = m->next())
+    {
+        m->writeJson(out);
+        if (m->next() != NULL)
+            out.write(",", 1);
+    }
+    out.write("}", 1);
+}
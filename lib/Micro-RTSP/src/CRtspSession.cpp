@@ -1,6 +1,11 @@
 #include "CRtspSession.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <time.h>
+#include <Metrics.h>
+
+static MetricHistogram s_requestTime("rtsp_request_seconds", "Time to parse and answer one RTSP request");
+static MetricCounter s_requests("rtsp_requests_total", "RTSP requests handled");
 
 CRtspSession::CRtspSession(SOCKET aRtspClient, CStreamer * aStreamer) : m_RtspClient(aRtspClient),m_Streamer(aStreamer)
 {
@@ -15,11 +20,19 @@ CRtspSession::CRtspSession(SOCKET aRtspClient, CStreamer * aStreamer) : m_RtspCl
     m_TcpTransport   =  false;
     m_streaming = false;
     m_stopped = false;
+
+    m_Buffers = (CRtspSessionBuffers *) malloc(sizeof(CRtspSessionBuffers));
+    if (m_Buffers == nullptr)
+    {
+        printf("No memory for the RTSP session buffers\n");
+        m_stopped = true; // the caller closes it like a session the client ended
+    }
 };
 
 CRtspSession::~CRtspSession()
 {
     closesocket(m_RtspClient);
+    free(m_Buffers);
 };
 
 void CRtspSession::Init()
@@ -35,18 +48,19 @@ void CRtspSession::Init()
 bool CRtspSession::ParseRtspRequest(char const * aRequest, unsigned aRequestSize)
 {
     char CmdName[RTSP_PARAM_STRING_MAX];
-    static char CurRequest[RTSP_BUFFER_SIZE]; // Note: we assume single threaded, this large buf we keep off of the tiny stack
+    char * CurRequest = m_Buffers->Request;
     unsigned CurRequestSize;
 
     Init();
-    CurRequestSize = aRequestSize;
-    memcpy(CurRequest,aRequest,aRequestSize);
+    CurRequestSize = aRequestSize < RTSP_BUFFER_SIZE ? aRequestSize : RTSP_BUFFER_SIZE;
+    if (aRequest != CurRequest) // handleRequests() reads straight into it
+        memcpy(CurRequest,aRequest,CurRequestSize);
+    CurRequest[CurRequestSize] = 0x00;
 
     // check whether the request contains information about the RTP/RTCP UDP client ports (SETUP command)
-    char * ClientPortPtr;
-    char * TmpPtr;
-    static char CP[1024];
-    char * pCP;
+    char const * ClientPortPtr;
+    char const * TmpPtr;
+    char const * pCP;
 
     ClientPortPtr = strstr(CurRequest,"client_port");
     if (ClientPortPtr != nullptr)
@@ -54,18 +68,14 @@ bool CRtspSession::ParseRtspRequest(char const * aRequest, unsigned aRequestSize
         TmpPtr = strstr(ClientPortPtr,"\r\n");
         if (TmpPtr != nullptr)
         {
-            TmpPtr[0] = 0x00;
-            strcpy(CP,ClientPortPtr);
-            pCP = strstr(CP,"=");
-            if (pCP != nullptr)
+            pCP = strchr(ClientPortPtr,'=');
+            if (pCP != nullptr && pCP < TmpPtr)
             {
                 pCP++;
-                strcpy(CP,pCP);
-                pCP = strstr(CP,"-");
-                if (pCP != nullptr)
+                char const * Dash = strchr(pCP,'-');
+                if (Dash != nullptr && Dash < TmpPtr)
                 {
-                    pCP[0] = 0x00;
-                    m_ClientRTPPort  = atoi(CP);
+                    m_ClientRTPPort  = atoi(pCP);
                     m_ClientRTCPPort = m_ClientRTPPort + 1;
                 };
             };
@@ -214,6 +224,12 @@ bool CRtspSession::ParseRtspRequest(char const * aRequest, unsigned aRequestSize
 
 RTSP_CMD_TYPES CRtspSession::Handle_RtspRequest(char const * aRequest, unsigned aRequestSize)
 {
+    if (m_Buffers == nullptr)
+        return RTSP_UNKNOWN;
+
+    MetricTimer requestTimer(s_requestTime);
+    s_requests.add();
+
     if (ParseRtspRequest(aRequest,aRequestSize))
     {
         switch (m_RtspCmdType)
@@ -230,9 +246,9 @@ RTSP_CMD_TYPES CRtspSession::Handle_RtspRequest(char const * aRequest, unsigned
 
 void CRtspSession::Handle_RtspOPTION()
 {
-    static char Response[1024]; // Note: we assume single threaded, this large buf we keep off of the tiny stack
+    char * Response = m_Buffers->Response;
 
-    snprintf(Response,sizeof(Response),
+    snprintf(Response,RTSP_RESPONSE_SIZE,
              "RTSP/1.0 200 OK\r\nCSeq: %s\r\n"
              "Public: DESCRIBE, SETUP, TEARDOWN, PLAY, PAUSE\r\n\r\n",m_CSeq);
 
@@ -241,9 +257,9 @@ void CRtspSession::Handle_RtspOPTION()
 
 void CRtspSession::Handle_RtspDESCRIBE()
 {
-    static char Response[1024]; // Note: we assume single threaded, this large buf we keep off of the tiny stack
-    static char SDPBuf[1024];
-    static char URLBuf[1024];
+    char * Response = m_Buffers->Response;
+    char * SDPBuf = m_Buffers->SDP;
+    char * URLBuf = m_Buffers->URL;
 
     // check whether we know a stream with the URL which is requested
     m_StreamID = -1;        // invalid URL
@@ -251,7 +267,7 @@ void CRtspSession::Handle_RtspDESCRIBE()
     if ((strcmp(m_URLPreSuffix,"mjpeg") == 0) && (strcmp(m_URLSuffix,"2") == 0)) m_StreamID = 1;
     if (m_StreamID == -1)
     {   // Stream not available
-        snprintf(Response,sizeof(Response),
+        snprintf(Response,RTSP_RESPONSE_SIZE,
                  "RTSP/1.0 404 Stream Not Found\r\nCSeq: %s\r\n%s\r\n",
                  m_CSeq,
                  DateHeader());
@@ -261,13 +277,13 @@ void CRtspSession::Handle_RtspDESCRIBE()
     };
 
     // simulate DESCRIBE server response
-    static char OBuf[256];
+    char * OBuf = m_Buffers->Host;
     char * ColonPtr;
     strcpy(OBuf,m_URLHostPort);
     ColonPtr = strstr(OBuf,":");
     if (ColonPtr != nullptr) ColonPtr[0] = 0x00;
 
-    snprintf(SDPBuf,sizeof(SDPBuf),
+    snprintf(SDPBuf,RTSP_SDP_SIZE,
              "v=0\r\n"
              "o=- %d 1 IN IP4 %s\r\n"
              "s=\r\n"
@@ -283,11 +299,11 @@ void CRtspSession::Handle_RtspDESCRIBE()
     case 0: strcpy(StreamName,"mjpeg/1"); break;
     case 1: strcpy(StreamName,"mjpeg/2"); break;
     };
-    snprintf(URLBuf,sizeof(URLBuf),
+    snprintf(URLBuf,sizeof(m_Buffers->URL),
              "rtsp://%s/%s",
              m_URLHostPort,
              StreamName);
-    snprintf(Response,sizeof(Response),
+    snprintf(Response,RTSP_RESPONSE_SIZE,
              "RTSP/1.0 200 OK\r\nCSeq: %s\r\n"
              "%s\r\n"
              "Content-Base: %s/\r\n"
@@ -305,23 +321,23 @@ void CRtspSession::Handle_RtspDESCRIBE()
 
 void CRtspSession::Handle_RtspSETUP()
 {
-    static char Response[1024];
-    static char Transport[255];
+    char * Response = m_Buffers->Response;
+    char * Transport = m_Buffers->Transport;
 
     // init RTP streamer transport type (UDP or TCP) and ports for UDP transport
     m_Streamer->InitTransport(m_ClientRTPPort,m_ClientRTCPPort,m_TcpTransport);
 
     // simulate SETUP server response
     if (m_TcpTransport)
-        snprintf(Transport,sizeof(Transport),"RTP/AVP/TCP;unicast;interleaved=0-1");
+        snprintf(Transport,RTSP_PARAM_STRING_MAX,"RTP/AVP/TCP;unicast;interleaved=0-1");
     else
-        snprintf(Transport,sizeof(Transport),
+        snprintf(Transport,RTSP_PARAM_STRING_MAX,
                  "RTP/AVP;unicast;destination=127.0.0.1;source=127.0.0.1;client_port=%i-%i;server_port=%i-%i",
                  m_ClientRTPPort,
                  m_ClientRTCPPort,
                  m_Streamer->GetRtpServerPort(),
                  m_Streamer->GetRtcpServerPort());
-    snprintf(Response,sizeof(Response),
+    snprintf(Response,RTSP_RESPONSE_SIZE,
              "RTSP/1.0 200 OK\r\nCSeq: %s\r\n"
              "%s\r\n"
              "Transport: %s\r\n"
@@ -336,10 +352,10 @@ void CRtspSession::Handle_RtspSETUP()
 
 void CRtspSession::Handle_RtspPLAY()
 {
-    static char Response[1024];
+    char * Response = m_Buffers->Response;
 
     // simulate SETUP server response
-    snprintf(Response,sizeof(Response),
+    snprintf(Response,RTSP_RESPONSE_SIZE,
              "RTSP/1.0 200 OK\r\nCSeq: %s\r\n"
              "%s\r\n"
              "Range: npt=0.000-\r\n"
@@ -354,9 +370,10 @@ void CRtspSession::Handle_RtspPLAY()
 
 char const * CRtspSession::DateHeader()
 {
-    static char buf[200];
+    char * buf = m_Buffers->Date;
     time_t tt = time(NULL);
-    strftime(buf, sizeof buf, "Date: %a, %b %d %Y %H:%M:%S GMT", gmtime(&tt));
+    struct tm t;
+    strftime(buf, sizeof(m_Buffers->Date), "Date: %a, %b %d %Y %H:%M:%S GMT", gmtime_r(&tt, &t));
     return buf;
 }
 
@@ -375,10 +392,9 @@ bool CRtspSession::handleRequests(uint32_t readTimeoutMs)
     if(m_stopped)
         return false; // Already closed down
 
-    static char RecvBuf[RTSP_BUFFER_SIZE];   // Note: we assume single threaded, this large buf we keep off of the tiny stack
+    char * RecvBuf = m_Buffers->Request; // parsed where it is, ParseRtspRequest() terminates it
 
-    memset(RecvBuf,0x00,sizeof(RecvBuf));
-    int res = socketread(m_RtspClient,RecvBuf,sizeof(RecvBuf), readTimeoutMs);
+    int res = socketread(m_RtspClient,RecvBuf,RTSP_BUFFER_SIZE, readTimeoutMs);
     if(res > 0) {
         // we filter away everything which seems not to be an RTSP command: O-ption, D-escribe, S-etup, P-lay, T-eardown
         if ((RecvBuf[0] == 'O') || (RecvBuf[0] == 'D') || (RecvBuf[0] == 'S') || (RecvBuf[0] == 'P') || (RecvBuf[0] == 'T'))
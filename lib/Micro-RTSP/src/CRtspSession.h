@@ -14,10 +14,30 @@ enum RTSP_CMD_TYPES
     RTSP_UNKNOWN
 };
 
-#define RTSP_BUFFER_SIZE       10000    // for incoming requests, and outgoing responses
+#ifndef RTSP_BUFFER_SIZE
+#define RTSP_BUFFER_SIZE       2048     // for incoming requests, longer ones are cut off
+#endif
+#ifndef RTSP_RESPONSE_SIZE
+#define RTSP_RESPONSE_SIZE     1024     // for outgoing responses, the SDP of DESCRIBE included
+#endif
+#define RTSP_SDP_SIZE          512
 #define RTSP_PARAM_STRING_MAX  200
 #define MAX_HOSTNAME_LEN       256
 
+// The scratch space of one session, allocated in one piece when the session is created and
+// freed with it. Nothing is shared between sessions, so sessions may be served from different
+// tasks or threads; each one must only be used from one at a time.
+struct CRtspSessionBuffers
+{
+    char Request[RTSP_BUFFER_SIZE + 1];                       // the request being handled, NUL terminated
+    char Response[RTSP_RESPONSE_SIZE];
+    char SDP[RTSP_SDP_SIZE];
+    char URL[MAX_HOSTNAME_LEN + 80];                          // rtsp://host:port/stream
+    char Host[MAX_HOSTNAME_LEN];                              // host part of the URL, without port
+    char Transport[RTSP_PARAM_STRING_MAX];
+    char Date[64];
+};
+
 class CRtspSession
 {
 public:
@@ -54,6 +74,7 @@ private:
     void Handle_RtspPLAY();
 
     // global session state parameters
+    CRtspSessionBuffers * m_Buffers;                          // NULL when it could not be allocated
     int m_RtspSessionID;
     SOCKET m_RtspClient;                                      // RTSP socket of that session
     int m_StreamID;                                           // number of simulated stream of that session
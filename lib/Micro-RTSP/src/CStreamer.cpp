@@ -1,6 +1,28 @@
 #include "CStreamer.h"
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <Metrics.h>
+
+// pause after every RTP packet to pace the stream; the host benchmark builds with 0
+#ifndef MICRO_RTSP_PACKET_DELAY_MS
+#define MICRO_RTSP_PACKET_DELAY_MS 15
+#endif
+
+#define KRtpHeaderSize 12           // size of the RTP header
+#define KJpegHeaderSize 8           // size of the special JPEG payload header
+
+#define MAX_FRAGMENT_SIZE 1100 // FIXME, pick more carefully
+
+// the largest packet, the first of a frame: RTP over RTSP header, RTP and JPEG headers, quant tables and a fragment
+#define RTP_BUFFER_SIZE (4 + KRtpHeaderSize + KJpegHeaderSize + 4 + 64 * 2 + MAX_FRAGMENT_SIZE)
+
+static MetricHistogram s_jpegParseTime("rtsp_jpeg_parse_seconds", "Time to find the scan data and quant tables of a frame");
+static MetricHistogram s_packetizeTime("rtsp_packetize_seconds", "Time to build one RTP packet");
+static MetricHistogram s_packetSendTime("rtsp_packet_send_seconds", "Time to hand one RTP packet to the socket");
+static MetricCounter s_packetsSent("rtsp_packets_sent_total", "RTP packets sent");
+static MetricCounter s_bytesSent("rtsp_bytes_sent_total", "RTP bytes sent, headers included");
+static MetricCounter s_badFrames("rtsp_bad_frames_total", "Frames dropped because the JPEG data could not be parsed");
 
 CStreamer::CStreamer(SOCKET aClient, u_short width, u_short height) : m_Client(aClient)
 {
@@ -21,20 +43,23 @@ CStreamer::CStreamer(SOCKET aClient, u_short width, u_short height) : m_Client(a
     m_width = width;
     m_height = height;
     m_prevMsec = 0;
+
+    m_RtpBuf = (char *) malloc(RTP_BUFFER_SIZE); // ours alone, so streamers may run on different tasks
+    if (m_RtpBuf == nullptr)
+        printf("No memory for the RTP buffer\n");
 };
 
 CStreamer::~CStreamer()
 {
     udpsocketclose(m_RtpSocket);
     udpsocketclose(m_RtcpSocket);
+    free(m_RtpBuf);
 };
 
 int CStreamer::SendRtpPacket(unsigned const char * jpeg, int jpegLen, int fragmentOffset, BufPtr quant0tbl, BufPtr quant1tbl)
 {
-#define KRtpHeaderSize 12           // size of the RTP header
-#define KJpegHeaderSize 8           // size of the special JPEG payload header
+    uint32_t startUs = metricsMicros();
 
-#define MAX_FRAGMENT_SIZE 1100 // FIXME, pick more carefully
     int fragmentLen = MAX_FRAGMENT_SIZE;
     if(fragmentLen + fragmentOffset > jpegLen) // Shrink last fragment if needed
         fragmentLen = jpegLen - fragmentOffset;
@@ -46,10 +71,9 @@ int CStreamer::SendRtpPacket(unsigned const char * jpeg, int jpegLen, int fragme
     bool includeQuantTbl = quant0tbl && quant1tbl && fragmentOffset == 0;
     uint8_t q = includeQuantTbl ? 128 : 0x5e;
 
-    static char RtpBuf[2048]; // Note: we assume single threaded, this large buf we keep off of the tiny stack
+    char * RtpBuf = m_RtpBuf; // every byte of the packet is written below, no need to clear it
     int RtpPacketSize = fragmentLen + KRtpHeaderSize + KJpegHeaderSize + (includeQuantTbl ? (4 + 64 * 2) : 0);
 
-    memset(RtpBuf,0x00,sizeof(RtpBuf));
     // Prepare the first 4 byte of the packet. This is the Rtp over Rtsp header in case of TCP based transport
     RtpBuf[0]  = '$';        // magic number
     RtpBuf[1]  = 0;          // number of multiplexed subchannel on RTPS connection - here the RTP channel
@@ -114,12 +138,19 @@ int CStreamer::SendRtpPacket(unsigned const char * jpeg, int jpegLen, int fragme
     IPPORT otherport;
     socketpeeraddr(m_Client, &otherip, &otherport);
 
+    uint32_t builtUs = metricsMicros();
+    s_packetizeTime.observe(builtUs - startUs);
+
     // RTP marker bit must be set on last fragment
     if (m_TCPTransport) // RTP over RTSP - we send the buffer + 4 byte additional header
         socketsend(m_Client,RtpBuf,RtpPacketSize + 4);
     else                // UDP - we send just the buffer by skipping the 4 byte RTP over RTSP header
         udpsocketsend(m_RtpSocket,&RtpBuf[4],RtpPacketSize, otherip, m_RtpClientPort);
 
+    s_packetSendTime.observe(metricsMicros() - builtUs);
+    s_packetsSent.add();
+    s_bytesSent.add(RtpPacketSize);
+
     return isLastFragment ? 0 : fragmentOffset;
 };
 
@@ -175,15 +206,22 @@ void CStreamer::streamFrame(unsigned const char *data, uint32_t dataLen, uint32_
     // locate quant tables if possible
     BufPtr qtable0, qtable1;
 
-    if(!decodeJPEGfile(&data, &dataLen, &qtable0, &qtable1)) {
+    uint32_t parseStartUs = metricsMicros();
+    bool decoded = decodeJPEGfile(&data, &dataLen, &qtable0, &qtable1);
+    s_jpegParseTime.observe(metricsMicros() - parseStartUs);
+    if(!decoded) {
         printf("can't decode jpeg data\n");
+        s_badFrames.add();
         return;
     }
+    if(m_RtpBuf == nullptr)
+        return;
 
     int offset = 0;
     do {
         offset = SendRtpPacket(data, dataLen, offset, qtable0, qtable1);
-		delay(15);
+        if (MICRO_RTSP_PACKET_DELAY_MS > 0)
+            delay(MICRO_RTSP_PACKET_DELAY_MS);
     } while(offset != 0);
 
     // Increment ONLY after a full frame
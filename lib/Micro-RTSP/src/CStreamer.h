@@ -30,6 +30,8 @@ private:
     IPPORT m_RtpServerPort;      // RTP sender port on server
     IPPORT m_RtcpServerPort;     // RTCP sender port on server
 
+    char * m_RtpBuf;               // the packet being built
+
     u_short m_SequenceNumber;
     uint32_t m_Timestamp;
     int m_SendIdx;
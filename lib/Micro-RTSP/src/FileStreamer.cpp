@@ -0,0 +1,327 @@
+#include "FileStreamer.h"
+
+#if !defined(ARDUINO_ARCH_ESP32) || defined(HOST_PLATFORM)
+#include <algorithm>
+#include <dirent.h>
+#include <fcntl.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Walks the segments of the JPEG at p: returns its length up to and including EOI, or 0 if
+// it is cut off. The entropy coded data after SOS cannot contain 0xff 0xd9 (0xff is always
+// stuffed or a restart marker there), so a search for EOI ends it.
+static size_t jpegLength(BufPtr p, size_t avail, u_short *width = NULL, u_short *height = NULL)
+{
+    size_t i = 2; // SOI
+    while (i + 4 <= avail)
+    {
+        if (p[i] != 0xff)
+            return 0;
+        uint8_t marker = p[i + 1];
+        if (marker == 0xff) // fill byte
+        {
+            i++;
+            continue;
+        }
+        if (marker == 0xd9)
+            return i + 2;
+        if (marker == 0x01 || (marker >= 0xd0 && marker <= 0xd7)) // no length
+        {
+            i += 2;
+            continue;
+        }
+
+        size_t segLen = p[i + 2] * 256 + p[i + 3];
+        if (marker == 0xc0 && width && i + 9 <= avail)
+        {
+            *height = p[i + 5] * 256 + p[i + 6];
+            *width = p[i + 7] * 256 + p[i + 8];
+        }
+        i += 2 + segLen;
+        if (marker == 0xda)
+        {
+            BufPtr end = (BufPtr)memmem(p + i, (i < avail) ? avail - i : 0, "\xff\xd9", 2);
+            return end ? end - p + 2 : 0;
+        }
+    }
+    return 0;
+}
+
+bool jpegFrameSize(BufPtr jpeg, uint32_t len, u_short *width, u_short *height)
+{
+    *width = *height = 0;
+    if (len < 4 || jpeg[0] != 0xff || jpeg[1] != 0xd8)
+        return false;
+    jpegLength(jpeg, len, width, height);
+    return *width != 0;
+}
+
+MJPEGFile::MJPEGFile() : m_base(NULL), m_timed(false)
+{
+}
+
+MJPEGFile::~MJPEGFile()
+{
+    for (size_t i = 0; i < m_maps.size(); i++)
+        munmap(m_maps[i].addr, m_maps[i].size);
+}
+
+BufPtr MJPEGFile::map(const char *path, size_t *size)
+{
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        printf("can't open %s, errno=%d\n", path, errno);
+        return NULL;
+    }
+    struct stat st;
+    void *addr = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+        addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps the file
+    if (addr == MAP_FAILED)
+    {
+        printf("can't map %s\n", path);
+        return NULL;
+    }
+
+    Mapping m = { addr, (size_t)st.st_size };
+    m_maps.push_back(m);
+    *size = st.st_size;
+    return (BufPtr)addr;
+}
+
+bool MJPEGFile::open(const char *path)
+{
+    struct stat st;
+    if (stat(path, &st) != 0)
+    {
+        printf("can't find %s\n", path);
+        return false;
+    }
+
+    bool ok = S_ISDIR(st.st_mode) ? openDirectory(path) : openFile(path);
+    if (!ok || m_frames.empty())
+        return false;
+
+    // times that are all the same are no times
+    m_timed &= m_frames.back().msec > 0;
+    if (!m_timed)
+        for (size_t i = 0; i < m_frames.size(); i++)
+            m_frames[i].msec = i * DEFAULT_FRAME_MSEC;
+
+    printf("%s: %u frames, %u ms\n", path, (unsigned)m_frames.size(), durationMsec());
+    return true;
+}
+
+uint32_t MJPEGFile::durationMsec() const
+{
+    if (m_frames.empty())
+        return 0;
+    // the last frame is shown as long as the average one
+    uint32_t last = m_frames.back().msec;
+    return last + ((m_frames.size() > 1) ? last / (m_frames.size() - 1) : DEFAULT_FRAME_MSEC);
+}
+
+bool MJPEGFile::openFile(const char *path)
+{
+    size_t size;
+    BufPtr base = map(path, &size);
+    if (base == NULL)
+        return false;
+    m_base = base;
+
+    std::string indexPath = std::string(path) + ".idx";
+    if (access(indexPath.c_str(), R_OK) == 0 && readIndex(indexPath.c_str(), base, size))
+        return true;
+
+    scan(base, size);
+    return true;
+}
+
+// Every SOI starts a frame. Anything between frames, such as multipart boundaries and part
+// headers, is skipped, except for an X-Timestamp header
+void MJPEGFile::scan(BufPtr base, size_t size)
+{
+    const char timestampHeader[] = "X-Timestamp:";
+    double firstTimestamp = -1;
+    BufPtr p = base;
+    BufPtr end = base + size;
+
+    while (p + 4 <= end)
+    {
+        BufPtr soi = (BufPtr)memmem(p, end - p, "\xff\xd8\xff", 3);
+        if (soi == NULL)
+            break;
+
+        double timestamp = -1;
+        BufPtr header = (BufPtr)memmem(p, soi - p, timestampHeader, sizeof(timestampHeader) - 1);
+        if (header)
+        {
+            char text[32];
+            size_t n = std::min((size_t)(soi - header) - (sizeof(timestampHeader) - 1), sizeof(text) - 1);
+            memcpy(text, header + sizeof(timestampHeader) - 1, n);
+            text[n] = 0;
+            timestamp = atof(text);
+        }
+
+        size_t len = jpegLength(soi, end - soi);
+        if (len == 0)
+        {
+            printf("truncated JPEG at offset %u, ignoring the rest\n", (unsigned)(soi - base));
+            break;
+        }
+
+        MJPEGFrame frame = { soi, (uint32_t)len, 0 };
+        if (timestamp >= 0)
+        {
+            if (firstTimestamp < 0)
+                firstTimestamp = timestamp;
+            frame.msec = (uint32_t)((timestamp - firstTimestamp) * 1000 + 0.5);
+            m_timed = true;
+        }
+        m_frames.push_back(frame);
+        p = soi + len;
+    }
+}
+
+bool MJPEGFile::readIndex(const char *indexPath, BufPtr base, size_t size)
+{
+    FILE *f = fopen(indexPath, "r");
+    if (f == NULL)
+        return false;
+
+    unsigned long offset, len, msec;
+    bool ok = true;
+    while (ok && fscanf(f, "%lu %lu %lu", &offset, &len, &msec) == 3)
+    {
+        ok = (offset + len <= size) && (len >= 4) && (base[offset] == 0xff) && (base[offset + 1] == 0xd8);
+        MJPEGFrame frame = { base + offset, (uint32_t)len, (uint32_t)msec };
+        m_frames.push_back(frame);
+    }
+    ok = ok && feof(f);
+    fclose(f);
+
+    if (!ok)
+    {
+        printf("%s does not match the footage, rescanning\n", indexPath);
+        m_frames.clear();
+        return false;
+    }
+    m_timed = true;
+    return true;
+}
+
+bool MJPEGFile::writeIndex(const char *indexPath) const
+{
+    if (m_base == NULL)
+        return false; // a directory needs no index
+
+    FILE *f = fopen(indexPath, "w");
+    if (f == NULL)
+        return false;
+    for (size_t i = 0; i < m_frames.size(); i++)
+        fprintf(f, "%lu %lu %lu\n", (unsigned long)(m_frames[i].data - m_base), (unsigned long)m_frames[i].len,
+                (unsigned long)m_frames[i].msec);
+    return fclose(f) == 0;
+}
+
+bool MJPEGFile::openDirectory(const char *path)
+{
+    DIR *dir = opendir(path);
+    if (dir == NULL)
+        return false;
+
+    std::vector<std::string> names;
+    while (struct dirent *entry = readdir(dir))
+    {
+        const char *dot = strrchr(entry->d_name, '.');
+        if (dot && (strcasecmp(dot, ".jpg") == 0 || strcasecmp(dot, ".jpeg") == 0))
+            names.push_back(entry->d_name);
+    }
+    closedir(dir);
+    std::sort(names.begin(), names.end());
+
+    // <msec>.jpg names give the times, if every file has one
+    m_timed = !names.empty();
+    for (size_t i = 0; i < names.size(); i++)
+        m_timed &= strspn(names[i].c_str(), "0123456789") == names[i].find('.');
+    if (m_timed)
+        std::sort(names.begin(), names.end(), [](const std::string &a, const std::string &b) {
+            return strtoull(a.c_str(), NULL, 10) < strtoull(b.c_str(), NULL, 10);
+        });
+
+    uint64_t first = m_timed ? strtoull(names[0].c_str(), NULL, 10) : 0;
+    for (size_t i = 0; i < names.size(); i++)
+    {
+        std::string file = std::string(path) + "/" + names[i];
+        size_t size;
+        BufPtr data = map(file.c_str(), &size);
+        if (data == NULL)
+            continue;
+        size_t len = jpegLength(data, size);
+        if (len == 0)
+        {
+            printf("%s is not a complete JPEG, skipped\n", file.c_str());
+            continue;
+        }
+
+        uint32_t msec = m_timed ? (uint32_t)(strtoull(names[i].c_str(), NULL, 10) - first) : 0;
+        MJPEGFrame frame = { data, (uint32_t)len, msec };
+        m_frames.push_back(frame);
+    }
+    return true;
+}
+
+// the streamer sends every frame with the size of the first
+static u_short firstFrameSize(const MJPEGFile &file, bool height)
+{
+    u_short w = 0, h = 0;
+    if (file.frameCount() > 0)
+        jpegFrameSize(file.frame(0).data, file.frame(0).len, &w, &h);
+    return height ? h : w;
+}
+
+FileStreamer::FileStreamer(SOCKET aClient, const MJPEGFile &file, int frameMsec)
+    : CStreamer(aClient, firstFrameSize(file, false), firstFrameSize(file, true)), m_file(file), m_frameMsec(frameMsec)
+{
+    m_startMsec = 0;
+    m_started = false;
+    m_next = 0;
+}
+
+uint32_t FileStreamer::dueMsec(size_t n)
+{
+    if (m_frameMsec == RECORDED)
+        return (n / m_file.frameCount()) * m_file.durationMsec() + m_file.frame(n % m_file.frameCount()).msec;
+    return n * m_frameMsec;
+}
+
+void FileStreamer::streamImage(uint32_t curMsec)
+{
+    if (m_file.frameCount() == 0)
+        return;
+
+    if (!m_started)
+    {
+        m_started = true;
+        m_startMsec = curMsec;
+    }
+
+    uint32_t elapsed = curMsec - m_startMsec;
+    if (m_frameMsec != 0)
+    {
+        if (dueMsec(m_next) > elapsed)
+            return;
+        // if we fell behind, skip to the latest frame that is due rather than play catch up
+        while (dueMsec(m_next + 1) <= elapsed)
+            m_next++;
+    }
+
+    // the stream's RTP clock follows the footage, not the calls
+    const MJPEGFrame &frame = m_file.frame(m_next % m_file.frameCount());
+    streamFrame(frame.data, frame.len, (m_frameMsec == 0) ? curMsec : m_startMsec + dueMsec(m_next));
+    m_next++;
+}
+#endif
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "CStreamer.h"
+
+#if !defined(ARDUINO_ARCH_ESP32) || defined(HOST_PLATFORM)
+#include <string>
+#include <vector>
+
+// Recorded footage for host builds: an MJPEG file (JPEGs back to back, or a multipart
+// stream as saved from an HTTP MJPEG server) or a directory of .jpg files, memory-mapped
+// and indexed once so every frame is a pointer into the mapping.
+//
+// Frame times come from, in order of preference:
+// - an index file next to the footage, <path>.idx, one "offset length msec" line per frame.
+//   writeIndex() produces one, which can then be edited;
+// - X-Timestamp: <sec>.<usec> part headers in a multipart stream;
+// - file names of the form <msec>.jpg in a directory.
+// Otherwise frames are DEFAULT_FRAME_MSEC apart.
+
+struct MJPEGFrame
+{
+    BufPtr data;
+    uint32_t len;
+    uint32_t msec; // since the first frame
+};
+
+class MJPEGFile
+{
+public:
+    static const uint32_t DEFAULT_FRAME_MSEC = 100;
+
+    MJPEGFile();
+    ~MJPEGFile();
+
+    bool open(const char *path); // a file or a directory, false if no frames were found
+
+    size_t frameCount() const { return m_frames.size(); }
+    const MJPEGFrame &frame(size_t i) const { return m_frames[i]; }
+    uint32_t durationMsec() const; // one loop, including the gap after the last frame
+
+    bool writeIndex(const char *indexPath) const;
+
+private:
+    MJPEGFile(const MJPEGFile &);
+    MJPEGFile &operator=(const MJPEGFile &);
+
+    BufPtr map(const char *path, size_t *size);
+    bool openFile(const char *path);
+    bool openDirectory(const char *path);
+    bool readIndex(const char *indexPath, BufPtr base, size_t size);
+    void scan(BufPtr base, size_t size);
+
+    struct Mapping
+    {
+        void *addr;
+        size_t size;
+    };
+
+    std::vector<Mapping> m_maps;
+    std::vector<MJPEGFrame> m_frames;
+    BufPtr m_base; // of a single file, for writeIndex()
+    bool m_timed;  // the frames came with times
+};
+
+// Plays an MJPEGFile in a loop. streamImage() can be called as often as the session likes:
+// it sends the frame that is due, if that was not sent already. frameMsec overrides the
+// recorded times with a fixed interval; 0 sends the next frame on every call instead.
+class FileStreamer : public CStreamer
+{
+public:
+    static const int RECORDED = -1;
+
+    FileStreamer(SOCKET aClient, const MJPEGFile &file, int frameMsec = RECORDED);
+
+    virtual void    streamImage(uint32_t curMsec);
+
+private:
+    uint32_t dueMsec(size_t n); // when frame n is due, from the start of playback
+
+    const MJPEGFile &m_file;
+    int m_frameMsec;
+    uint32_t m_startMsec;
+    bool m_started;
+    size_t m_next;       // frame index, counting across loops
+};
+
+// the size from the SOF0 segment, false if the JPEG has none
+bool jpegFrameSize(BufPtr jpeg, uint32_t len, u_short *width, u_short *height);
+#endif
@@ -1,7 +1,11 @@
 #include "OV2640.h"
+#include <Metrics.h>
 
 #define TAG "OV2640"
 
+static MetricHistogram s_fbGetTime("camera_fb_get_seconds", "Time spent waiting in esp_camera_fb_get()");
+static MetricCounter s_fbGetFailures("camera_fb_get_failures_total", "esp_camera_fb_get() calls that returned no frame");
+
 // definitions appropriate for the ESP32-CAM devboard (and most clones)
 camera_config_t esp32cam_config {
 
@@ -104,13 +108,27 @@ camera_config_t esp32cam_ttgo_t_config {
 
 
 
-void OV2640::run(void)
+camera_fb_t *OV2640::grab(void)
+{
+    uint32_t startUs = metricsMicros();
+    camera_fb_t *frame = esp_camera_fb_get();
+    s_fbGetTime.observe(metricsMicros() - startUs);
+    if(!frame)
+        s_fbGetFailures.add();
+    return frame;
+}
+
+void OV2640::release(camera_fb_t *frame)
 {
-    if(fb)
-        //return the frame buffer back to the driver for reuse
-        esp_camera_fb_return(fb);
+    if(frame)
+        esp_camera_fb_return(frame);
+}
 
-    fb = esp_camera_fb_get();
+void OV2640::run(void)
+{
+    //return the frame buffer back to the driver for reuse
+    release(fb);
+    fb = grab();
 }
 
 void OV2640::runIfNeeded(void)
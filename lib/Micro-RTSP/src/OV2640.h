@@ -19,6 +19,13 @@ public:
     ~OV2640(){
     };
     esp_err_t init(camera_config_t config);
+
+    // A frame of the caller's own, NULL if the driver had none; give it back with release().
+    // Tasks that share the camera use these. run() and getfb() keep one frame for all callers,
+    // which is only safe while a single task uses them.
+    camera_fb_t *grab(void);
+    void release(camera_fb_t *frame);
+
     void run(void);
     size_t getSize(void);
     uint8_t *getfb(void);
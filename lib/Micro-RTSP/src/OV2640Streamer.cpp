@@ -1,6 +1,10 @@
 
 #include "OV2640Streamer.h"
 #include <assert.h>
+#include <Metrics.h>
+
+static MetricHistogram s_frameTime("rtsp_frame_seconds", "Time from asking the camera for a frame to sending its last RTP packet");
+static MetricCounter s_framesStreamed("rtsp_frames_streamed_total", "Frames handed to the RTP streamer");
 
 
 
@@ -11,6 +15,9 @@ OV2640Streamer::OV2640Streamer(SOCKET aClient, OV2640 &cam) : CStreamer(aClient,
 
 void OV2640Streamer::streamImage(uint32_t curMsec)
 {
+    MetricTimer frameTimer(s_frameTime);
+    s_framesStreamed.add();
+
     m_cam.run();// queue up a read for next time
 
     BufPtr bytes = m_cam.getfb();
@@ -23,6 +23,10 @@ inline void closesocket(SOCKET s) {
 
 #define getRandom() rand()
 
+inline void delay(uint32_t msec) {
+    usleep(msec * 1000);
+}
+
 inline void socketpeeraddr(SOCKET s, IPADDRESS *addr, IPPORT *port) {
 
     sockaddr_in r;
@@ -0,0 +1,316 @@
+#include "RTSPTestClient.h"
+#include "JPEGSamples.h"
+#include <Metrics.h>
+
+#include <assert.h>
+#include <fcntl.h>
+#include <thread>
+#include <vector>
+
+// Host benchmarks for the library, built with "make bench". Results go to stdout as one
+// JSON object, so runs can be diffed or checked into CI; anything the library prints is
+// sent to /dev/null.
+//
+//   jpeg_parse  decodeJPEGfile() on the two sample images, and on the footage
+//   packetize   streamFrame() into a UDP socket nobody reads: RTP packetization plus one
+//               sendto() per packet, with the per-packet delay compiled out
+//   rtsp_parse  Handle_RtspRequest() for OPTIONS, DESCRIBE, SETUP and PLAY
+//   sessions    N clients streaming over loopback TCP at the fastest rate the server
+//               manages, each served by a forked process like RTSPTestServer
+//
+// Packetize and sessions use capture_jpg, or with -f every frame of an MJPEG file or
+// directory of JPEGs in turn (see FileStreamer.h), for realistic and varied frame sizes.
+//
+// Usage: rtspbench [-c clients] [-d seconds per measurement] [-f footage]
+
+#define MAX_FRAGMENT_PAYLOAD 1100 // MAX_FRAGMENT_SIZE in CStreamer.cpp
+
+static FILE *s_json;
+
+typedef std::vector<MJPEGFrame> Frames;
+
+// streams the frames in turn through CStreamer::streamFrame
+class BenchStreamer : public CStreamer
+{
+public:
+    BenchStreamer(SOCKET aClient, const Frames &frames) : CStreamer(aClient, 800, 600), m_frames(frames), m_next(0) {}
+
+    virtual void streamImage(uint32_t curMsec)
+    {
+        const MJPEGFrame &frame = m_frames[m_next++ % m_frames.size()];
+        streamFrame(frame.data, frame.len, curMsec);
+    }
+
+private:
+    const Frames &m_frames;
+    size_t m_next;
+};
+
+// a connected UDP socket whose peer never reads: the kernel drops what does not fit
+static SOCKET nullSink()
+{
+    SOCKET sink = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(sink, (sockaddr *)&addr, sizeof(addr));
+    socklen_t len = sizeof(addr);
+    getsockname(sink, (sockaddr *)&addr, &len);
+
+    SOCKET s = socket(AF_INET, SOCK_DGRAM, 0);
+    connect(s, (sockaddr *)&addr, sizeof(addr));
+    return s;
+}
+
+// bytes is the average JPEG size
+static void benchJpegParse(const char *name, const Frames &jpegs, double seconds, bool last)
+{
+    uint64_t frames = 0, bytes = 0;
+    double start = nowSec();
+    double elapsed;
+    do {
+        for (int i = 0; i < 100; i++) {
+            const MJPEGFrame &jpeg = jpegs[frames++ % jpegs.size()];
+            BufPtr data = jpeg.data;
+            uint32_t len = jpeg.len;
+            BufPtr q0, q1;
+            bool ok = decodeJPEGfile(&data, &len, &q0, &q1);
+            assert(ok);
+            (void)ok;
+            bytes += jpeg.len;
+        }
+        elapsed = nowSec() - start;
+    } while (elapsed < seconds);
+
+    fprintf(s_json, "    \"%s\": {\"bytes\": %llu, \"frames\": %llu, \"frames_per_s\": %.1f, \"mb_per_s\": %.1f, \"ns_per_frame\": %.1f}%s\n",
+            name, (unsigned long long)(bytes / frames), (unsigned long long)frames, frames / elapsed,
+            bytes / elapsed / 1e6, elapsed * 1e9 / frames, last ? "" : ",");
+}
+
+// scan_bytes and packets_per_frame are averages over the frames
+static void benchPacketize(const Frames &jpegs, double seconds)
+{
+    SOCKET sink = nullSink();
+    BenchStreamer streamer(sink, jpegs);
+    streamer.InitTransport(0, 0, true);
+
+    uint64_t cycleScan = 0, cyclePackets = 0;
+    for (size_t i = 0; i < jpegs.size(); i++) {
+        BufPtr data = jpegs[i].data;
+        uint32_t scanLen = jpegs[i].len;
+        BufPtr q0, q1;
+        decodeJPEGfile(&data, &scanLen, &q0, &q1);
+        cycleScan += scanLen;
+        cyclePackets += (scanLen + MAX_FRAGMENT_PAYLOAD - 1) / MAX_FRAGMENT_PAYLOAD;
+    }
+    double scanPerFrame = (double)cycleScan / jpegs.size();
+    double packetsPerFrame = (double)cyclePackets / jpegs.size();
+
+    uint64_t frames = 0;
+    double start = nowSec();
+    double elapsed;
+    do {
+        for (int i = 0; i < 10; i++)
+            streamer.streamImage(nowMsec());
+        frames += 10;
+        elapsed = nowSec() - start;
+    } while (elapsed < seconds);
+    closesocket(sink);
+
+    fprintf(s_json, "  \"packetize\": {\"frames_used\": %u, \"scan_bytes\": %.0f, \"packets_per_frame\": %.1f, "
+                    "\"frames_per_s\": %.1f, \"packets_per_s\": %.1f, \"mb_per_s\": %.1f, \"ns_per_packet\": %.1f},\n",
+            (unsigned)jpegs.size(), scanPerFrame, packetsPerFrame, frames / elapsed, frames * packetsPerFrame / elapsed,
+            frames * scanPerFrame / elapsed / 1e6, elapsed * 1e9 / (frames * packetsPerFrame));
+}
+
+static void benchRtspParse(double seconds)
+{
+    static const char *requests[] = {
+        "OPTIONS rtsp://127.0.0.1:8554/mjpeg/1 RTSP/1.0\r\nCSeq: 1\r\nUser-Agent: rtspbench\r\n\r\n",
+        "DESCRIBE rtsp://127.0.0.1:8554/mjpeg/1 RTSP/1.0\r\nCSeq: 2\r\nAccept: application/sdp\r\n\r\n",
+        "SETUP rtsp://127.0.0.1:8554/mjpeg/1/track1 RTSP/1.0\r\nCSeq: 3\r\nTransport: RTP/AVP/TCP;unicast;interleaved=0-1\r\n\r\n",
+        "PLAY rtsp://127.0.0.1:8554/mjpeg/1 RTSP/1.0\r\nCSeq: 4\r\nSession: 1\r\nRange: npt=0.000-\r\n\r\n",
+    };
+    const int count = sizeof(requests) / sizeof(requests[0]);
+    unsigned lengths[count];
+    for (int i = 0; i < count; i++)
+        lengths[i] = strlen(requests[i]);
+
+    SOCKET sink = nullSink();
+    Frames none;
+    BenchStreamer streamer(sink, none);
+    CRtspSession session(sink, &streamer);
+
+    uint64_t handled = 0;
+    double start = nowSec();
+    double elapsed;
+    do {
+        for (int i = 0; i < 100; i++)
+            for (int r = 0; r < count; r++) {
+                RTSP_CMD_TYPES type = session.Handle_RtspRequest(requests[r], lengths[r]);
+                assert(type == (RTSP_CMD_TYPES)r);
+                (void)type;
+            }
+        handled += 100 * count;
+        elapsed = nowSec() - start;
+    } while (elapsed < seconds);
+    closesocket(sink);
+
+    fprintf(s_json, "  \"rtsp_parse\": {\"requests\": %llu, \"requests_per_s\": %.1f, \"ns_per_request\": %.1f},\n",
+            (unsigned long long)handled, handled / elapsed, elapsed * 1e9 / handled);
+}
+
+struct ClientResult
+{
+    bool ok;
+    double setupMs;      // connect to the PLAY reply
+    double firstFrameMs; // PLAY reply to the end of the first frame
+    uint64_t frames;
+    uint64_t bytes;
+    double streamSec;
+};
+
+static void runClient(int port, double seconds, ClientResult *result)
+{
+    memset(result, 0, sizeof(*result));
+    RTSPTestClient client;
+
+    double start = nowSec();
+    if (!client.connectServer("127.0.0.1", port) ||
+        !client.request("OPTIONS", "mjpeg/1", "") ||
+        !client.request("DESCRIBE", "mjpeg/1", "Accept: application/sdp\r\n") ||
+        !client.request("SETUP", "mjpeg/1/track1", "Transport: RTP/AVP/TCP;unicast;interleaved=0-1\r\n") ||
+        !client.request("PLAY", "mjpeg/1", "Range: npt=0.000-\r\n"))
+        return;
+    double playing = nowSec();
+    result->setupMs = (playing - start) * 1e3;
+
+    double end = playing + seconds;
+    double now = playing;
+    std::string packet;
+    uint8_t channel;
+    while (now < end) {
+        if (!client.readInterleaved(&packet, &channel))
+            return;
+        result->bytes += 4 + packet.size();
+        if ((packet.size() < 2) || !(packet[1] & 0x80))
+            continue; // the marker bit ends a frame
+        now = nowSec();
+        if (result->frames++ == 0)
+            result->firstFrameMs = (now - playing) * 1e3;
+    }
+    result->streamSec = now - playing;
+    result->ok = true;
+    client.teardown("mjpeg/1");
+}
+
+static void benchSessions(int clients, double seconds, const MJPEGFile *footage)
+{
+    int port;
+    pid_t server = startLoopbackServer(0, &port, footage);
+
+    std::vector<ClientResult> results(clients);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < clients; i++)
+        threads.push_back(std::thread(runClient, port, seconds, &results[i]));
+    for (size_t i = 0; i < threads.size(); i++)
+        threads[i].join();
+
+    stopLoopbackServer(server);
+
+    int ok = 0;
+    uint64_t frames = 0, bytes = 0;
+    double setupSum = 0, setupMax = 0, firstSum = 0, fpsMin = 1e9, fpsSum = 0;
+    for (int i = 0; i < clients; i++) {
+        const ClientResult &r = results[i];
+        if (!r.ok)
+            continue;
+        ok++;
+        frames += r.frames;
+        bytes += r.bytes;
+        setupSum += r.setupMs;
+        setupMax = r.setupMs > setupMax ? r.setupMs : setupMax;
+        firstSum += r.firstFrameMs;
+        double fps = r.frames / r.streamSec;
+        fpsSum += fps;
+        fpsMin = fps < fpsMin ? fps : fpsMin;
+    }
+
+    fprintf(s_json, "  \"sessions\": {\"clients\": %d, \"completed\": %d, \"seconds\": %.1f, \"frames\": %llu, "
+                    "\"fps_per_client\": %.1f, \"fps_min\": %.1f, \"mbit_per_s\": %.1f, \"setup_ms\": %.2f, "
+                    "\"setup_ms_max\": %.2f, \"first_frame_ms\": %.2f},\n",
+            clients, ok, seconds, (unsigned long long)frames, ok ? fpsSum / ok : 0.0, ok ? fpsMin : 0.0,
+            bytes * 8 / seconds / 1e6, ok ? setupSum / ok : 0.0, setupMax, ok ? firstSum / ok : 0.0);
+}
+
+class FileMetricsOut : public MetricsOut
+{
+public:
+    explicit FileMetricsOut(FILE *f) : m_f(f) {}
+    virtual void write(const char *text, size_t len) { fwrite(text, 1, len, m_f); }
+
+private:
+    FILE *m_f;
+};
+
+int main(int argc, char **argv)
+{
+    int clients = 4;
+    double seconds = 2;
+    const char *footagePath = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "c:d:f:")) != -1) {
+        switch (opt) {
+        case 'c': clients = atoi(optarg); break;
+        case 'd': seconds = atof(optarg); break;
+        case 'f': footagePath = optarg; break;
+        default:
+            fprintf(stderr, "usage: %s [-c clients] [-d seconds] [-f footage]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // the library logs with printf: keep stdout for the JSON alone
+    fflush(stdout);
+    s_json = fdopen(dup(1), "w");
+    int devnull = open("/dev/null", O_WRONLY);
+    dup2(devnull, 1);
+    close(devnull);
+    signal(SIGPIPE, SIG_IGN);
+
+    Frames capture(1), octo(1), footageFrames;
+    capture[0].data = capture_jpg;
+    capture[0].len = capture_jpg_len;
+    octo[0].data = octo_jpg;
+    octo[0].len = octo_jpg_len;
+    MJPEGFile footage;
+    if (footagePath) {
+        if (!footage.open(footagePath)) {
+            fprintf(stderr, "rtspbench: no frames in %s\n", footagePath);
+            return 1;
+        }
+        for (size_t i = 0; i < footage.frameCount(); i++)
+            footageFrames.push_back(footage.frame(i));
+    }
+
+    fprintf(s_json, "{\n  \"benchmark\": \"micro-rtsp\",\n  \"seconds_per_test\": %.1f,\n  \"footage\": \"%s\",\n",
+            seconds, footagePath ? footagePath : "capture_jpg");
+    fprintf(s_json, "  \"jpeg_parse\": {\n");
+    benchJpegParse("capture_jpg", capture, seconds, false);
+    benchJpegParse("octo_jpg", octo, seconds, !footagePath);
+    if (footagePath)
+        benchJpegParse("footage", footageFrames, seconds, true);
+    fprintf(s_json, "  },\n");
+    benchPacketize(footagePath ? footageFrames : capture, seconds);
+    benchRtspParse(seconds);
+    benchSessions(clients, seconds, footagePath ? &footage : NULL);
+
+    // the library's own stage histograms, for the in-process tests above
+    fprintf(s_json, "  \"metrics\": ");
+    FileMetricsOut out(s_json);
+    metricsWriteJson(out);
+    fprintf(s_json, "\n}\n");
+    fclose(s_json);
+    return 0;
+}
@@ -0,0 +1,496 @@
+#include "RTSPTestClient.h"
+#include "JPEGSamples.h"
+
+#include <fcntl.h>
+#include <math.h>
+#include <thread>
+#include <vector>
+
+// Load generator and acceptance test for CStreamer and CRtspSession. Opens a number of
+// concurrent sessions, TCP interleaved, UDP or alternating, reassembles the RTP/JPEG
+// (RFC 2435) frames each one receives and checks them against the JPEG the server was
+// given: the same scan data byte for byte, the same quantization tables (sent in band, or
+// rebuilt from Q with the RFC's MakeTables() in rfccode.cpp) and the same size.
+//
+// Without -h it starts a loopback server from the library, streaming capture_jpg like
+// RTSPTestServer. With -h it tests whatever server is there, e.g. "make run" or a device;
+// use -s none when the frames are not a known image (a camera), which keeps the checks
+// that frames are complete and consistent.
+//
+// Prints JSON per session and in total: setup latency, time to first frame, fps, goodput
+// (valid JPEG scan data), inter-frame interval and its jitter, and packets lost. Exits with
+// 1 if a session could not be set up or received no valid frame, if any frame was
+// corrupt, or if a TCP session lost anything (UDP loss is reported but allowed).
+//
+// Usage: rtspload [-h host] [-p port] [-u path] [-n sessions] [-t tcp|udp|mix]
+//                 [-d seconds] [-r server fps] [-s capture|octo|none]
+
+void MakeTables(int q, u_char *lqt, u_char *cqt); // rfccode.cpp
+
+struct Source
+{
+    const char *name;
+    BufPtr scan; // NULL when there is nothing to compare against
+    uint32_t scanLen;
+    BufPtr qtable0;
+    BufPtr qtable1;
+    unsigned width;
+    unsigned height;
+};
+
+struct SessionResult
+{
+    bool tcp;
+    bool setup;
+    double setupMs;      // connect to the PLAY reply
+    double firstFrameMs; // PLAY reply to the first complete frame
+    double streamSec;
+    uint64_t packets;
+    uint64_t rtpBytes;
+    uint64_t lost;        // gaps in the sequence numbers
+    uint64_t reordered;   // packets older than one already seen
+    uint64_t valid;       // frames that passed every check
+    uint64_t corrupt;     // complete frames that differ from the source
+    uint64_t incomplete;  // frames with missing fragments
+    uint64_t qChanged;    // frames whose fragments disagree on Q, see RFC 2435 3.1.4
+    uint64_t goodBytes;   // scan data of the valid frames
+    uint64_t intervals;   // between consecutive valid frames, for the mean and standard deviation
+    double intervalSum;
+    double intervalSumSq;
+    char error[64];
+};
+
+// collects the fragments of one frame, keyed by RTP timestamp
+class FrameAssembler
+{
+public:
+    FrameAssembler(const Source &source, SessionResult &result)
+        : m_source(source), m_result(result), m_active(false), m_seqStarted(false), m_lastFrameSec(0) {}
+
+    // one RTP packet, with its arrival time
+    void packet(const uint8_t *p, size_t len, double now)
+    {
+        m_result.packets++;
+        m_result.rtpBytes += len;
+
+        if (len < 12 || (p[0] >> 6) != 2) {
+            m_result.corrupt++;
+            return;
+        }
+        size_t header = 12 + 4 * (p[0] & 0x0f);
+        if ((p[0] & 0x10) && len >= header + 4)
+            header += 4 + 4 * ((p[header + 2] << 8) | p[header + 3]);
+        bool marker = p[1] & 0x80;
+        uint16_t seq = (p[2] << 8) | p[3];
+        uint32_t timestamp = ((uint32_t)p[4] << 24) | (p[5] << 16) | (p[6] << 8) | p[7];
+
+        if (m_seqStarted) {
+            uint16_t gap = seq - m_nextSeq;
+            if (gap >= 0x8000) {
+                m_result.reordered++;
+                return;
+            }
+            m_result.lost += gap;
+        }
+        m_seqStarted = true;
+        m_nextSeq = seq + 1;
+
+        if (m_active && timestamp != m_timestamp) {
+            m_result.incomplete++; // the marker packet never came
+            m_active = false;
+        }
+
+        // RFC 2435 main JPEG header
+        p += header;
+        len -= header;
+        if (len < 8) {
+            m_result.corrupt++;
+            return;
+        }
+        uint32_t offset = (p[1] << 16) | (p[2] << 8) | p[3];
+        uint8_t type = p[4];
+        uint8_t q = p[5];
+        unsigned width = p[6] * 8;
+        unsigned height = p[7] * 8;
+        p += 8;
+        len -= 8;
+        if (type >= 64) { // restart marker header
+            p += 4;
+            len -= 4;
+        }
+
+        if (!m_active) {
+            m_active = true;
+            m_timestamp = timestamp;
+            m_data.clear();
+            m_received = 0;
+            m_q = q;
+            m_qChanged = false;
+            m_tables.clear();
+            m_width = width;
+            m_height = height;
+        }
+        else if (q != m_q)
+            m_qChanged = true;
+
+        if (offset == 0 && q >= 128) { // quantization table header, first packet only
+            if (len < 4) {
+                m_result.corrupt++;
+                return;
+            }
+            size_t tablesLen = (p[2] << 8) | p[3];
+            if (len < 4 + tablesLen) {
+                m_result.corrupt++;
+                return;
+            }
+            m_tables.assign((const char *)p + 4, tablesLen);
+            p += 4 + tablesLen;
+            len -= 4 + tablesLen;
+        }
+
+        if (m_data.size() < offset + len)
+            m_data.resize(offset + len);
+        memcpy(&m_data[offset], p, len);
+        m_received += len;
+
+        if (marker) {
+            finishFrame(now);
+            m_active = false;
+        }
+    }
+
+private:
+    void finishFrame(double now)
+    {
+        if (m_received != m_data.size()) {
+            m_result.incomplete++;
+            return;
+        }
+        if (m_qChanged)
+            m_result.qChanged++;
+        if (!check()) {
+            m_result.corrupt++;
+            return;
+        }
+
+        m_result.valid++;
+        m_result.goodBytes += m_data.size();
+        if (m_lastFrameSec > 0) {
+            double interval = (now - m_lastFrameSec) * 1e3;
+            m_result.intervals++;
+            m_result.intervalSum += interval;
+            m_result.intervalSumSq += interval * interval;
+        }
+        m_lastFrameSec = now;
+    }
+
+    bool check()
+    {
+        if (m_source.scan == NULL)
+            return m_data.size() > 0;
+
+        if (m_width != m_source.width || m_height != m_source.height)
+            return false;
+
+        // the tables a receiver would decode with
+        uint8_t tables[128];
+        if (m_q >= 128) {
+            if (m_tables.size() != sizeof(tables))
+                return false;
+            memcpy(tables, m_tables.data(), sizeof(tables));
+        }
+        else
+            MakeTables(m_q, tables, tables + 64);
+        if (m_source.qtable0 && (memcmp(tables, m_source.qtable0, 64) != 0 || memcmp(tables + 64, m_source.qtable1, 64) != 0))
+            return false;
+
+        return m_data.size() == m_source.scanLen && memcmp(m_data.data(), m_source.scan, m_source.scanLen) == 0;
+    }
+
+    const Source &m_source;
+    SessionResult &m_result;
+
+    bool m_active;
+    uint32_t m_timestamp;
+    std::string m_data;
+    size_t m_received;
+    uint8_t m_q;
+    bool m_qChanged;
+    std::string m_tables;
+    unsigned m_width;
+    unsigned m_height;
+
+    bool m_seqStarted;
+    uint16_t m_nextSeq;
+    double m_lastFrameSec;
+};
+
+struct Options
+{
+    const char *host;
+    int port;
+    const char *path;
+    double seconds;
+};
+
+static void fail(SessionResult *result, const char *what)
+{
+    snprintf(result->error, sizeof(result->error), "%s", what);
+}
+
+static void runSession(const Options &options, const Source &source, bool tcp, SessionResult *result)
+{
+    memset(result, 0, sizeof(*result));
+    result->tcp = tcp;
+    RTSPTestClient client;
+    FrameAssembler frames(source, *result);
+
+    // UDP: RTP comes to this socket. The server never sends RTCP, so the second port of
+    // the pair is only announced
+    int rtp = -1;
+    char transport[96];
+    if (tcp)
+        snprintf(transport, sizeof(transport), "Transport: RTP/AVP/TCP;unicast;interleaved=0-1\r\n");
+    else {
+        rtp = socket(AF_INET, SOCK_DGRAM, 0);
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = INADDR_ANY;
+        bind(rtp, (sockaddr *)&addr, sizeof(addr));
+        socklen_t len = sizeof(addr);
+        getsockname(rtp, (sockaddr *)&addr, &len);
+        int size = 1 << 20;
+        setsockopt(rtp, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+        timeval tv = {0, 200000};
+        setsockopt(rtp, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        snprintf(transport, sizeof(transport), "Transport: RTP/AVP;unicast;client_port=%d-%d\r\n",
+                 ntohs(addr.sin_port), ntohs(addr.sin_port) + 1);
+    }
+
+    char setupPath[128];
+    snprintf(setupPath, sizeof(setupPath), "%s/track1", options.path);
+
+    double start = nowSec();
+    if (!client.connectServer(options.host, options.port))
+        fail(result, "connect");
+    else {
+        client.setTimeout(5000);
+        if (!client.request("OPTIONS", options.path, ""))
+            fail(result, "OPTIONS");
+        else if (!client.request("DESCRIBE", options.path, "Accept: application/sdp\r\n"))
+            fail(result, "DESCRIBE");
+        else if (!client.request("SETUP", setupPath, transport))
+            fail(result, "SETUP");
+        else if (!client.request("PLAY", options.path, "Range: npt=0.000-\r\n"))
+            fail(result, "PLAY");
+        else
+            result->setup = true;
+    }
+    if (!result->setup) {
+        if (rtp >= 0)
+            close(rtp);
+        return;
+    }
+
+    double playing = nowSec();
+    result->setupMs = (playing - start) * 1e3;
+    double end = playing + options.seconds;
+    double now = playing;
+    std::string packet;
+    uint8_t channel;
+    char datagram[2048];
+    while (now < end) {
+        uint64_t valid = result->valid;
+        if (tcp) {
+            if (!client.readInterleaved(&packet, &channel)) {
+                fail(result, "stream ended");
+                break;
+            }
+            now = nowSec();
+            if (channel == 0)
+                frames.packet((const uint8_t *)packet.data(), packet.size(), now);
+        }
+        else {
+            ssize_t n = recv(rtp, datagram, sizeof(datagram), 0);
+            now = nowSec();
+            if (n > 0)
+                frames.packet((const uint8_t *)datagram, n, now);
+        }
+        if (valid == 0 && result->valid == 1)
+            result->firstFrameMs = (now - playing) * 1e3;
+    }
+    result->streamSec = now - playing;
+
+    client.teardown(options.path);
+    if (rtp >= 0)
+        close(rtp);
+}
+
+static bool loadSource(const char *name, Source *source)
+{
+    memset(source, 0, sizeof(*source));
+    source->name = name;
+
+    BufPtr jpeg;
+    uint32_t len;
+    if (strcmp(name, "capture") == 0) {
+        jpeg = capture_jpg;
+        len = capture_jpg_len;
+    }
+    else if (strcmp(name, "octo") == 0) {
+        jpeg = octo_jpg;
+        len = octo_jpg_len;
+    }
+    else
+        return strcmp(name, "none") == 0;
+
+    // size from the SOF0 segment: length, precision, height, width
+    BufPtr sof = jpeg;
+    uint32_t sofLen = len;
+    if (!findJPEGheader(&sof, &sofLen, 0xc0))
+        return false;
+    source->height = (sof[3] << 8) | sof[4];
+    source->width = (sof[5] << 8) | sof[6];
+
+    source->scan = jpeg;
+    source->scanLen = len;
+    return decodeJPEGfile(&source->scan, &source->scanLen, &source->qtable0, &source->qtable1);
+}
+
+static void printSession(FILE *out, const SessionResult &r, const char *name, const char *transport)
+{
+    uint64_t frames = r.valid + r.corrupt + r.incomplete;
+    double mean = r.intervals ? r.intervalSum / r.intervals : 0;
+    double variance = r.intervals ? r.intervalSumSq / r.intervals - mean * mean : 0;
+    double seconds = r.streamSec > 0 ? r.streamSec : 1;
+
+    fprintf(out, "{\"session\": \"%s\", \"transport\": \"%s\", \"setup\": %s, \"error\": \"%s\", "
+                 "\"setup_ms\": %.2f, \"first_frame_ms\": %.2f, \"seconds\": %.2f, \"frames\": %llu, "
+                 "\"valid\": %llu, \"corrupt\": %llu, \"incomplete\": %llu, \"q_changed\": %llu, "
+                 "\"fps\": %.2f, \"goodput_mbit_per_s\": %.3f, \"rtp_mbit_per_s\": %.3f, "
+                 "\"interval_ms\": %.2f, \"jitter_ms\": %.2f, \"packets\": %llu, \"lost\": %llu, "
+                 "\"reordered\": %llu, \"loss_pct\": %.3f}",
+            name, transport, r.setup ? "true" : "false", r.error, r.setupMs, r.firstFrameMs,
+            r.streamSec, (unsigned long long)frames, (unsigned long long)r.valid,
+            (unsigned long long)r.corrupt, (unsigned long long)r.incomplete, (unsigned long long)r.qChanged,
+            r.valid / seconds, r.goodBytes * 8 / seconds / 1e6, r.rtpBytes * 8 / seconds / 1e6, mean,
+            variance > 0 ? sqrt(variance) : 0, (unsigned long long)r.packets, (unsigned long long)r.lost,
+            (unsigned long long)r.reordered, r.packets + r.lost ? 100.0 * r.lost / (r.packets + r.lost) : 0.0);
+}
+
+int main(int argc, char **argv)
+{
+    Options options = {NULL, 8554, "mjpeg/1", 10};
+    int sessions = 4;
+    const char *transport = "mix";
+    unsigned fps = 25;
+    const char *sourceName = "capture";
+
+    int opt;
+    while ((opt = getopt(argc, argv, "h:p:u:n:t:d:r:s:")) != -1) {
+        switch (opt) {
+        case 'h': options.host = optarg; break;
+        case 'p': options.port = atoi(optarg); break;
+        case 'u': options.path = optarg; break;
+        case 'n': sessions = atoi(optarg); break;
+        case 't': transport = optarg; break;
+        case 'd': options.seconds = atof(optarg); break;
+        case 'r': fps = atoi(optarg); break;
+        case 's': sourceName = optarg; break;
+        default:
+            fprintf(stderr, "usage: %s [-h host] [-p port] [-u path] [-n sessions] [-t tcp|udp|mix] "
+                            "[-d seconds] [-r server fps] [-s capture|octo|none]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (strcmp(transport, "tcp") != 0 && strcmp(transport, "udp") != 0 && strcmp(transport, "mix") != 0) {
+        fprintf(stderr, "transport must be tcp, udp or mix\n");
+        return 2;
+    }
+
+    // the library logs with printf: keep stdout for the JSON alone
+    fflush(stdout);
+    FILE *out = fdopen(dup(1), "w");
+    int devnull = open("/dev/null", O_WRONLY);
+    dup2(devnull, 1);
+    close(devnull);
+    signal(SIGPIPE, SIG_IGN);
+
+    Source source;
+    if (!loadSource(sourceName, &source)) {
+        fprintf(stderr, "unknown or undecodable source %s\n", sourceName);
+        return 2;
+    }
+
+    pid_t server = 0;
+    if (options.host == NULL) {
+        options.host = "127.0.0.1";
+        server = startLoopbackServer(fps, &options.port);
+    }
+
+    std::vector<SessionResult> results(sessions);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < sessions; i++) {
+        bool tcp = strcmp(transport, "tcp") == 0 || (strcmp(transport, "mix") == 0 && i % 2 == 0);
+        threads.push_back(std::thread(runSession, std::cref(options), std::cref(source), tcp, &results[i]));
+    }
+    for (size_t i = 0; i < threads.size(); i++)
+        threads[i].join();
+
+    if (server)
+        stopLoopbackServer(server);
+
+    // the total adds everything up, except times, which are averaged over the sessions set up
+    SessionResult total;
+    memset(&total, 0, sizeof(total));
+    total.setup = true;
+    int setUp = 0;
+    bool passed = true;
+    for (int i = 0; i < sessions; i++) {
+        const SessionResult &r = results[i];
+        passed &= (r.error[0] == 0) && (r.valid > 0) && (r.corrupt == 0);
+        if (r.tcp)
+            passed &= (r.lost == 0) && (r.incomplete == 0);
+        total.setup &= r.setup;
+        if (!r.setup)
+            continue;
+        setUp++;
+        total.setupMs += r.setupMs;
+        total.firstFrameMs += r.firstFrameMs;
+        total.streamSec += r.streamSec;
+        total.packets += r.packets;
+        total.rtpBytes += r.rtpBytes;
+        total.lost += r.lost;
+        total.reordered += r.reordered;
+        total.valid += r.valid;
+        total.corrupt += r.corrupt;
+        total.incomplete += r.incomplete;
+        total.qChanged += r.qChanged;
+        total.goodBytes += r.goodBytes;
+        total.intervals += r.intervals;
+        total.intervalSum += r.intervalSum;
+        total.intervalSumSq += r.intervalSumSq;
+    }
+    // so fps and goodput in total are for all the sessions together
+    if (setUp > 0) {
+        total.setupMs /= setUp;
+        total.firstFrameMs /= setUp;
+        total.streamSec /= setUp;
+    }
+
+    fprintf(out, "{\n  \"server\": \"%s:%d/%s\",\n  \"source\": \"%s\",\n  \"sessions\": [\n", options.host,
+            options.port, options.path, source.name);
+    for (int i = 0; i < sessions; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "%d", i);
+        fprintf(out, "    ");
+        printSession(out, results[i], name, results[i].tcp ? "tcp" : "udp");
+        fprintf(out, i < sessions - 1 ? ",\n" : "\n");
+    }
+    fprintf(out, "  ],\n  \"total\": ");
+    printSession(out, total, "total", transport);
+    fprintf(out, ",\n  \"passed\": %s\n}\n", passed ? "true" : "false");
+    fclose(out);
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,220 @@
+#pragma once
+
+#include "platglue.h"
+
+#include "SimStreamer.h"
+#include "FileStreamer.h"
+#include "CRtspSession.h"
+
+#include <netdb.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <string>
+
+// Pieces shared by the host tools: a minimal RTSP client and a loopback server built from
+// the library itself.
+
+inline double nowSec()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+inline uint32_t nowMsec()
+{
+    return (uint32_t)(nowSec() * 1000);
+}
+
+// Forks a server on 127.0.0.1 and an ephemeral port, which is returned in *port. Every
+// client gets its own process, as in RTSPTestServer, so the library's static buffers stay
+// single threaded. Frames are sent at most fps times a second, 0 for as fast as the
+// library goes. The frames are capture_jpg, or the frames of footage in turn (at the fps,
+// not their recorded times). Stop it with stopLoopbackServer().
+inline pid_t startLoopbackServer(unsigned fps, int *port, const MJPEGFile *footage = NULL)
+{
+    SOCKET listener = socket(AF_INET, SOCK_STREAM, 0);
+    int enable = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(int));
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(listener, (sockaddr *)&addr, sizeof(addr)) != 0 || listen(listener, 64) != 0) {
+        fprintf(stderr, "can't listen, errno=%d\n", errno);
+        exit(1);
+    }
+    socklen_t len = sizeof(addr);
+    getsockname(listener, (sockaddr *)&addr, &len);
+    *port = ntohs(addr.sin_port);
+
+    fflush(NULL);
+    pid_t server = fork();
+    if (server != 0) {
+        setpgid(server, server);
+        closesocket(listener);
+        return server;
+    }
+
+    setpgid(0, 0);
+    signal(SIGCHLD, SIG_IGN);
+    uint32_t interval = fps ? 1000 / fps : 0;
+    while (true) {
+        SOCKET s = accept(listener, NULL, NULL);
+        if (s < 0)
+            continue;
+        if (fork() != 0) {
+            closesocket(s);
+            continue;
+        }
+
+        closesocket(listener);
+        SimStreamer simStreamer(s, true);
+        FileStreamer *fileStreamer = footage ? new FileStreamer(s, *footage, 0) : NULL;
+        CRtspSession rtsp(s, fileStreamer ? (CStreamer *)fileStreamer : &simStreamer);
+        uint32_t lastMsec = 0;
+        while (!rtsp.m_stopped) {
+            if (rtsp.handleRequests(1))
+                continue;
+            uint32_t msec = nowMsec();
+            if (msec - lastMsec >= interval) {
+                lastMsec = msec;
+                rtsp.broadcastCurrentFrame(msec);
+            }
+        }
+        closesocket(s);
+        _exit(0);
+    }
+}
+
+inline void stopLoopbackServer(pid_t server)
+{
+    kill(-server, SIGTERM);
+    waitpid(server, NULL, 0);
+}
+
+// Blocking RTSP client for one session. Requests wait for their complete response; RTP over
+// the RTSP connection (interleaved) is read a packet at a time.
+class RTSPTestClient
+{
+public:
+    RTSPTestClient() : m_port(0), m_cseq(1), m_sock(-1) {}
+    ~RTSPTestClient() { if (m_sock >= 0) close(m_sock); }
+
+    bool connectServer(const char *host, int port)
+    {
+        m_host = host;
+        m_port = port;
+
+        addrinfo hints, *res;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        if (getaddrinfo(host, NULL, &hints, &res) != 0)
+            return false;
+        sockaddr_in addr = *(sockaddr_in *)res->ai_addr;
+        freeaddrinfo(res);
+        addr.sin_port = htons(port);
+
+        m_sock = socket(AF_INET, SOCK_STREAM, 0);
+        return connect(m_sock, (sockaddr *)&addr, sizeof(addr)) == 0;
+    }
+
+    // gives up on reads after timeoutMs, 0 to wait forever
+    void setTimeout(uint32_t timeoutMs)
+    {
+        timeval tv;
+        tv.tv_sec = timeoutMs / 1000;
+        tv.tv_usec = (timeoutMs % 1000) * 1000;
+        setsockopt(m_sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    }
+
+    // sends a request for rtsp://host:port/path and returns true on a 200 reply, whose
+    // headers and body are left in *reply
+    bool request(const char *method, const char *path, const char *extraHeaders, std::string *reply = NULL)
+    {
+        char buf[512];
+        int n = snprintf(buf, sizeof(buf), "%s rtsp://%s:%d/%s RTSP/1.0\r\nCSeq: %d\r\n%s\r\n",
+                         method, m_host.c_str(), m_port, path, m_cseq++, extraHeaders);
+        if (send(m_sock, buf, n, 0) != n)
+            return false;
+
+        // RTP may already be interleaved ahead of the reply
+        while (true) {
+            while (m_in.size() < 4)
+                if (!fill())
+                    return false;
+            if (m_in[0] != '$')
+                break;
+            size_t len = ((uint8_t)m_in[2] << 8) | (uint8_t)m_in[3];
+            while (m_in.size() < 4 + len)
+                if (!fill())
+                    return false;
+            m_in.erase(0, 4 + len);
+        }
+
+        size_t end;
+        while ((end = m_in.find("\r\n\r\n")) == std::string::npos)
+            if (!fill())
+                return false;
+        end += 4;
+        size_t length = 0;
+        size_t cl = m_in.find("Content-Length:");
+        if (cl != std::string::npos && cl < end)
+            length = atoi(m_in.c_str() + cl + 15);
+        while (m_in.size() < end + length)
+            if (!fill())
+                return false;
+        bool ok = m_in.compare(0, 15, "RTSP/1.0 200 OK") == 0;
+        if (reply)
+            reply->assign(m_in, 0, end + length);
+        m_in.erase(0, end + length);
+        return ok;
+    }
+
+    // reads the next interleaved packet into *packet (without the 4 byte framing) and its
+    // channel into *channel; false on EOF, timeout or a stream that is not interleaved RTP
+    bool readInterleaved(std::string *packet, uint8_t *channel)
+    {
+        while (m_in.size() < 4)
+            if (!fill())
+                return false;
+        if (m_in[0] != '$')
+            return false;
+        size_t len = ((uint8_t)m_in[2] << 8) | (uint8_t)m_in[3];
+        while (m_in.size() < 4 + len)
+            if (!fill())
+                return false;
+        *channel = m_in[1];
+        packet->assign(m_in, 4, len);
+        m_in.erase(0, 4 + len);
+        return true;
+    }
+
+    // fire and forget: the server closes the session without waiting for us
+    void teardown(const char *path)
+    {
+        char buf[256];
+        int n = snprintf(buf, sizeof(buf), "TEARDOWN rtsp://%s:%d/%s RTSP/1.0\r\nCSeq: %d\r\n\r\n",
+                         m_host.c_str(), m_port, path, m_cseq++);
+        send(m_sock, buf, n, 0);
+    }
+
+private:
+    bool fill()
+    {
+        char buf[16384];
+        ssize_t n = recv(m_sock, buf, sizeof(buf), 0);
+        if (n <= 0)
+            return false;
+        m_in.append(buf, n);
+        return true;
+    }
+
+    std::string m_host;
+    int m_port;
+    int m_cseq;
+    int m_sock;
+    std::string m_in;
+};
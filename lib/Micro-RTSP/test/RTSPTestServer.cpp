@@ -1,6 +1,7 @@
 #include "platglue.h"
 
 #include "SimStreamer.h"
+#include "FileStreamer.h"
 #include "CRtspSession.h"
 #include "JPEGSamples.h"
 #include <assert.h>
@@ -8,15 +9,17 @@
 
 
 
-void workerThread(SOCKET s)
+void workerThread(SOCKET s, const MJPEGFile *footage)
 {
-    SimStreamer streamer(s, true);                     // our streamer for UDP/TCP based RTP transport
+    SimStreamer simStreamer(s, true);                  // our streamer for UDP/TCP based RTP transport
+    FileStreamer *fileStreamer = footage ? new FileStreamer(s, *footage) : NULL;
+    CStreamer *streamer = fileStreamer ? (CStreamer *)fileStreamer : &simStreamer;
 
-    CRtspSession rtsp(s, &streamer);     // our threads RTSP session and state
+    CRtspSession rtsp(s, streamer);     // our threads RTSP session and state
 
     while (!rtsp.m_stopped)
     {
-        uint32_t timeout = 400;
+        uint32_t timeout = footage ? 5 : 400; // footage has its own frame times, poll for them
         if(!rtsp.handleRequests(timeout)) {
             struct timeval now;
             gettimeofday(&now, NULL); // crufty msecish timer
@@ -24,9 +27,12 @@ void workerThread(SOCKET s)
             rtsp.broadcastCurrentFrame(msec);
         }
     }
+    delete fileStreamer;
 }
 
-int main()
+// testserver [footage]: footage is an MJPEG file or a directory of JPEGs to stream instead
+// of the built-in sample, see FileStreamer.h
+int main(int argc, char **argv)
 {
     SOCKET MasterSocket;                                      // our masterSocket(socket that listens for RTSP client connections)
     SOCKET ClientSocket;                                      // RTSP socket to handle an client
@@ -34,6 +40,10 @@ int main()
     sockaddr_in ClientAddr;                                   // address parameters of a new RTSP client
     socklen_t ClientAddrLen = sizeof(ClientAddr);
 
+    MJPEGFile footage;
+    if (argc > 1 && !footage.open(argv[1]))
+        return 1;
+
     printf("running RTSP server\n");
 
     ServerAddr.sin_family      = AF_INET;
@@ -60,7 +70,7 @@ int main()
         ClientSocket = accept(MasterSocket,(struct sockaddr*)&ClientAddr,&ClientAddrLen);
         printf("Client connected. Client address: %s\r\n",inet_ntoa(ClientAddr.sin_addr));
         if(fork() == 0)
-            workerThread(ClientSocket);
+            workerThread(ClientSocket, argc > 1 ? &footage : NULL);
     }
 
     closesocket(MasterSocket);
@@ -12,6 +12,26 @@
 #include "web_server.h"
 #endif
 
+#ifdef USE_SD_CARD
+#include "image_journal.h"
+#endif
+
+#ifdef USE_AVI_RECORDER
+#include "avi_recorder.h"
+#endif
+
+#ifdef USE_EVENT_CLIPS
+#include "event_clips.h"
+#endif
+
+#ifdef USE_MOTION_DETECTION
+#include "motion_detection.h"
+#endif
+
+#if defined(USE_AVI_RECORDER) || defined(USE_EVENT_CLIPS) || defined(USE_MOTION_DETECTION)
+#define USE_FRAME_CAPTURE // they all take their frames from the frame capture task
+#endif
+
 #define BUTTON_PIN_BITMASK(GPIO) (1ULL << GPIO) // 2 ^ GPIO_NUMBER in hex
 #define USE_EXT0_WAKEUP 1                       // 1 = EXT0 wakeup, 0 = EXT1 wakeup
 #define WAKEUP_GPIO GPIO_NUM_2                  // Only RTC IO are allowed - ESP32 Pin example
@@ -37,22 +57,152 @@ char currentTime[6] = "00:00";
 char meridian[3] = "AM";
 
 TimerHandle_t mqttImageSendTimer;
+TaskHandle_t imagePublishTaskHandle = NULL;
 
 int baseFontSize = 72;
 int appNameFontSize = 56;
 int friendlyNameFontSize = 24;
 int appInstanceIDFontSize = 18;
 int timeFontSize = 128;
-int storedImageIndex = 0;
 
 bool rtspServerRunning = false;
 int pin2Val = 0;
 
+// ********** Image Publishing **********
+#ifndef IMAGE_PUBLISH_INTERVAL_MS
+#define IMAGE_PUBLISH_INTERVAL_MS 200
+#endif
+
+#ifndef IMAGE_PUBLISH_QOS
+#define IMAGE_PUBLISH_QOS 1
+#endif
+
+#ifndef IMAGE_PUBLISH_MAX_INFLIGHT
+#define IMAGE_PUBLISH_MAX_INFLIGHT 2 // QoS1/2 frames sent but not acked yet
+#endif
+
+#ifndef IMAGE_PUBLISH_ACK_TIMEOUT_MS
+#define IMAGE_PUBLISH_ACK_TIMEOUT_MS 5000 // a frame not acked by then stops counting as in flight
+#endif
+
+#ifndef IMAGE_PUBLISH_STACK_SIZE
+#define IMAGE_PUBLISH_STACK_SIZE 4096
+#endif
+
+#ifndef IMAGE_PUBLISH_PRIORITY
+#define IMAGE_PUBLISH_PRIORITY TASK_PRIORITY_NETWORK
+#endif
+
+#ifndef IMAGE_PUBLISH_CORE
+#define IMAGE_PUBLISH_CORE TASK_CORE_NETWORK
+#endif
+
+struct ImageInFlight
+{
+    bool reserved;     // taken, the publish has not returned yet
+    uint16_t packetId; // waiting for this ack; free when neither is set
+    uint32_t sentAt;
+};
+
+// An ack can come in on the async_tcp task before publish() has returned the packetId to store
+// in the slot. Those acks are kept here for a while so the slot is released when it is stored.
+struct ImageEarlyAck
+{
+    uint16_t packetId;
+    uint32_t ackedAt;
+};
+
+ImageInFlight imageInFlight[IMAGE_PUBLISH_MAX_INFLIGHT];
+ImageEarlyAck imageEarlyAcks[IMAGE_PUBLISH_MAX_INFLIGHT];
+int imageEarlyAckNext = 0;
+portMUX_TYPE imageInFlightMux = portMUX_INITIALIZER_UNLOCKED;
+uint32_t imagesPublished = 0;
+uint32_t imagesDropped = 0;
+
+#ifdef USE_SD_CARD
+#ifndef IMAGE_JOURNAL_REPLAY_BATCH
+#define IMAGE_JOURNAL_REPLAY_BATCH 2 // cached frames offered per publish tick once reconnected
+#endif
+
+ImageJournal imageJournal;
+#endif
+
+// ********** Recording **********
+#ifdef USE_FRAME_CAPTURE
+#ifndef FRAME_CAPTURE_STACK_SIZE
+#define FRAME_CAPTURE_STACK_SIZE 3072
+#endif
+
+#ifndef FRAME_CAPTURE_PRIORITY
+#define FRAME_CAPTURE_PRIORITY TASK_PRIORITY_CAPTURE
+#endif
+
+#ifndef FRAME_CAPTURE_CORE
+#define FRAME_CAPTURE_CORE TASK_CORE_CAPTURE
+#endif
+
+#ifndef AVI_STOP_TIMEOUT_MS
+#define AVI_STOP_TIMEOUT_MS 2000 // how long going to sleep waits for the open segment or clip to close
+#endif
+
+TaskHandle_t frameCaptureTaskHandle = NULL;
+TaskHandle_t frameCaptureStopRequester = NULL; // set to ask the capture task to close up and exit
+#endif
+
+#ifdef USE_AVI_RECORDER
+AviRecorder aviRecorder;
+#endif
+
+#ifdef USE_EVENT_CLIPS
+#ifndef EVENT_TRIGGER_GPIO
+#define EVENT_TRIGGER_GPIO -1 // input whose rising edge triggers a clip, -1 for none
+#endif
+
+#ifndef EVENT_CLIP_SLOT_WAIT_MS
+#define EVENT_CLIP_SLOT_WAIT_MS 2000 // how long a clip frame waits for an MQTT in-flight slot
+#endif
+
+EventClips eventClips;
+int eventTriggerLevel = 0;
+#endif
+
+#ifdef USE_MOTION_DETECTION
+#ifndef MOTION_IDLE_FPS
+#define MOTION_IDLE_FPS 1 // frames recorded and published a second while there is no motion
+#endif
+
+#ifndef MOTION_SNAPSHOT_DIR
+#define MOTION_SNAPSHOT_DIR "/motion"
+#endif
+
+#ifndef MOTION_KEEP_SNAPSHOTS
+#define MOTION_KEEP_SNAPSHOTS 200
+#endif
+
+MotionDetection motionDetection;
+char motionTopic[75];
+uint32_t motionSnapshotNumber = 0; // of the newest snapshot on the SD card
+uint32_t lastRecordedMs = 0;       // capture task only
+#endif
+
+// ********** Fast Wake **********
+#ifdef USE_FAST_WAKE
+#ifndef FAST_WAKE_SEND_TIMEOUT_MS
+#define FAST_WAKE_SEND_TIMEOUT_MS 10000 // longest the wake frame may hold off sleep
+#endif
+
+#ifndef FAST_WAKE_SKIP_FRAMES
+#define FAST_WAKE_SKIP_FRAMES 2 // frames dropped while exposure settles
+#endif
+
+uint8_t *wakeFrame = NULL; // the frame taken on waking, sent once MQTT is up
+size_t wakeFrameLen = 0;
+volatile uint16_t wakeFramePacketId = 0;
+volatile bool wakeFrameSent = false;
+#endif
+
 // ********** Possible Customizations Start ***********
 char imageTopic[75];
-int otherAppTopicCount = 0;
-char otherAppTopic[10][25];
-void (*otherAppMessageHandler[10])(char *topic, JsonDocument &doc);
 
 void printTimestamp(Print *_logOutput, int x);
 void loadPrefs();
@@ -61,7 +211,7 @@ void ProcessWifiConnectTasks();
 void ProcessWifiDisconnectTasks();
 void ProcessMqttConnectTasks();
 void ProcessMqttDisconnectTasks();
-void appMessageHandler(char *topic, JsonDocument &doc);
+void appMessageHandler(const MqttMessage &msg, JsonDocument &doc);
 
 void app_loop();
 void app_setup();
@@ -83,6 +233,37 @@ bool checkGoodTime();
 bool getNewTime();
 void drawTime();
 void mqttPublishImage();
+void imagePublishTask(void *pvParameters);
+void requestImagePublish(TimerHandle_t xTimer);
+void onImagePublishAck(uint16_t packetId);
+int reserveImageInFlightSlot();
+bool imageInFlightSlotFree();
+void commitImageInFlightSlot(int slot, uint16_t packetId);
+void releaseImageInFlightSlot(int slot);
+void clearImagesInFlight();
+#ifdef USE_SD_CARD
+bool publishJournalImage(const uint8_t *data, size_t len, const JournalRecordHeader &header);
+#endif
+#ifdef USE_FRAME_CAPTURE
+void frameCaptureTask(void *pvParameters);
+void stopFrameCapture();
+#endif
+#ifdef USE_EVENT_CLIPS
+bool publishClipFrame(uint32_t clip, uint32_t frame, const uint8_t *data, size_t len, uint32_t timeMs);
+#endif
+#ifdef USE_FAST_WAKE
+void captureWakeFrame();
+void publishWakeFrame();
+#endif
+bool readyToSleep();
+#ifdef USE_MOTION_DETECTION
+void onMotionEvent(bool started, uint16_t changedCells, const uint8_t *jpeg, size_t len);
+void setMotionZones(JsonArrayConst zones);
+#ifdef USE_SD_CARD
+void findMotionSnapshots();
+void saveMotionSnapshot(const uint8_t *jpeg, size_t len);
+#endif
+#endif
 
 void setflash(byte state);
 
@@ -104,15 +285,13 @@ void printTimestamp(Print *_logOutput, int x)
     }
     _logOutput->print(c);
     _logOutput->print(": ");
-    _logOutput->print(methodName);
+    _logOutput->print(traceCurrentName());
     _logOutput->print(": ");
 }
 
 void loadPrefs()
 {
-    String oldMethodName = methodName;
-    methodName = "loadPrefs()";
-    Log.verboseln("Entering...");
+    TRACE_SCOPE("loadPrefs()");
 
     bool doesExist = preferences.isKey("appInstanceID");
     if (doesExist)
@@ -129,16 +308,11 @@ void loadPrefs()
         Log.warningln("Could not find Preferences!");
         Log.noticeln("appInstanceID not set yet!");
     }
-
-    Log.verboseln("Exiting...");
-    methodName = oldMethodName;
 }
 
 void storePrefs()
 {
-    String oldMethodName = methodName;
-    methodName = "storePrefs()";
-    Log.verboseln("Entering...");
+    TRACE_SCOPE("storePrefs()");
 
     Log.infoln("Storing Preferences.");
 
@@ -147,16 +321,11 @@ void storePrefs()
     preferences.putInt("BootCount", bootCount);
     preferences.putString("FriendlyName", friendlyName);
     // preferences.putBool("EnableSnapshot", enableSnapshot);
-
-    Log.verboseln("Exiting...");
-    methodName = oldMethodName;
 }
 
 void ProcessWifiConnectTasks()
 {
-    String oldMethodName = methodName;
-    methodName = "ProcessAppWifiConnectTasks()";
-    Log.verboseln("Entering...");
+    TRACE_SCOPE("ProcessAppWifiConnectTasks()");
 
 #ifdef USE_WEB_SERVER
     initWebServer();
@@ -165,69 +334,71 @@ void ProcessWifiConnectTasks()
 #ifdef USE_RTSP
     initRTSPServer();
 #endif
-
-    Log.verboseln("Exiting...");
-    methodName = oldMethodName;
 }
 
 void ProcessWifiDisconnectTasks()
 {
-    String oldMethodName = methodName;
-    methodName = "ProcessAppWifiDisconnectTasks()";
-    Log.verboseln("Entering...");
-
-    Log.verboseln("Exiting...");
-    methodName = oldMethodName;
+    TRACE_SCOPE("ProcessAppWifiDisconnectTasks()");
 }
 
 void ProcessMqttConnectTasks()
 {
-    String oldMethodName = methodName;
-    methodName = "ProcessMqttConnectTasks()";
-    Log.verboseln("Entering...");
+    TRACE_SCOPE("ProcessMqttConnectTasks()");
+
+#ifdef USE_FAST_WAKE
+    publishWakeFrame();
+#endif
 
     uint16_t packetIdSub1 = mqttClient.subscribe(appSubTopic, 2);
     if (packetIdSub1 > 0)
         Log.infoln("Subscribing to %s at QoS 2, packetId: %u", appSubTopic, packetIdSub1);
     else
         Log.errorln("Failed to subscribe to %s!!!", appSubTopic);
-
-    Log.verboseln("Exiting...");
-    methodName = oldMethodName;
 }
 
 void ProcessMqttDisconnectTasks()
 {
-    String oldMethodName = methodName;
-    methodName = "ProcessMqttDisconnectTasks()";
-    Log.verboseln("Entering...");
+    TRACE_SCOPE("ProcessMqttDisconnectTasks()");
 
-    Log.verboseln("Exiting...");
-    methodName = oldMethodName;
+#ifdef USE_ESP32_CAM
+    // acks for these will never arrive now
+    clearImagesInFlight();
+#endif
 }
 
-void appMessageHandler(char *topic, JsonDocument &doc)
+// Called for commands addressed to this instance once the appSecret has been checked.
+// msg.levels[0] is the appName, levels[1] the target appInstanceID (ours or -1) and the
+// remaining levels are the command. Topics of other apps can be routed to handlers of
+// their own with mqttRouter.on() in app_setup() (and subscribed in ProcessMqttConnectTasks()).
+// doc only holds the fields named in the ingest filter, add the ones used here in app_setup()
+// with mqttIngest.filter()["field"] = true. It is reused for the next message.
+void appMessageHandler(const MqttMessage &msg, JsonDocument &doc)
 {
-    String oldMethodName = methodName;
-    methodName = "appMessageHandler()";
-    Log.verboseln("Entering...");
+    TRACE_SCOPE("appMessageHandler()");
 
     // Add your implementation here
-    char topics[10][25];
-    int topicCounter = 0;
-    char *token = strtok(topic, "/");
+#ifdef USE_EVENT_CLIPS
+    // <appName>/<id>/event: clip of the seconds before and after now
+    if (msg.levelCount > 2 && msg.levels[2].equals("event") && msg.index == 0)
+        eventClips.trigger("mqtt");
+#endif
 
-    while ((token != NULL) && (topicCounter < 11))
+#ifdef USE_MOTION_DETECTION
+    // <appName>/<id>/motion: {"threshold": 20, "minCells": 4, "zones": [[x0, y0, x1, y1], ...]}
+    // in grid cells, inclusive; zones replace the ones set before, [] watches the whole frame
+    if (msg.levelCount > 2 && msg.levels[2].equals("motion"))
     {
-        strcpy(topics[topicCounter++], token);
-        token = strtok(NULL, "/");
+        if (doc["threshold"].is<int>())
+            motionDetection.detector().setThreshold(doc["threshold"]);
+        if (doc["minCells"].is<int>())
+            motionDetection.detector().setMinCells(doc["minCells"]);
+        if (doc["zones"].is<JsonArrayConst>())
+            setMotionZones(doc["zones"]);
+        Log.infoln("Motion: threshold %u, %u cells", motionDetection.detector().threshold(),
+                   motionDetection.detector().minCells());
     }
+#endif
 
-    // We can assume the first 2 subtopics are the appName and the appInstanceID
-    // The rest of the subtopics are the command
-
-    Log.verboseln("Exiting...");
-    methodName = oldMethodName;
     return;
 }
 
@@ -247,9 +418,7 @@ void setflash(byte state)
 
 void setupDisplay()
 {
-    String oldMethodName = methodName;
-    methodName = "setupDisplay()";
-    Log.verboseln("Entering");
+    TRACE_SCOPE("setupDisplay()");
 
     Log.infoln("Setting up display.");
 
@@ -266,16 +435,11 @@ void setupDisplay()
 #endif
 
     drawSplashScreen();
-
-    Log.verboseln("Exiting...");
-    methodName = oldMethodName;
 }
 
 void drawSplashScreen()
 {
-    String oldMethodName = methodName;
-    methodName = "drawSplashScreen()";
-    Log.verboseln("Entering");
+    TRACE_SCOPE("drawSplashScreen()");
 
     char showText[100];
     if (appInstanceID < 0)
@@ -294,9 +458,6 @@ void drawSplashScreen()
 
     drawString(showText, screenCenterX, tft.height() - appInstanceIDFontSize / 2, appInstanceIDFontSize);
 #endif
-
-    Log.verboseln("Exiting...");
-    methodName = oldMethodName;
 }
 
 #endif
@@ -304,9 +465,7 @@ void drawSplashScreen()
 #ifdef USE_RTSP
 void initRTSPServer()
 {
-    String oldMethodName = methodName;
-    methodName = "initRTSPServer()";
-    Log.verboseln("Entering...");
+    TRACE_SCOPE("initRTSPServer()");
 
     initRTSP();
 
@@ -318,16 +477,12 @@ void initRTSPServer()
 
         streamer = new OV2640Streamer(&cam);
     */
-    Log.verboseln("Exiting...");
-    methodName = oldMethodName;
 }
 
 /*
 void handleRTSP_loop()
 {
-    String oldMethodName = methodName;
-    methodName = "ProcessAppWifiConnectTasks()";
-    Log.verboseln("Entering...");
+    TRACE_SCOPE("handleRTSP_loop()");
 
     uint32_t msecPerFrame = 100;
     static uint32_t lastimage = millis();
@@ -357,9 +512,6 @@ void handleRTSP_loop()
 
         streamer->addSession(&rtspClient);
     }
-
-    Log.verboseln("Exiting...");
-    methodName = oldMethodName;
 }
 */
 #endif
@@ -368,79 +520,487 @@ void initAppStrings()
 {
     sprintf(appSubTopic, "%s/#", appName);
     sprintf(imageTopic, "%s/image", appName);
+#ifdef USE_MOTION_DETECTION
+    sprintf(motionTopic, "%s/motion", appName);
+#endif
 }
 
 void mqttPublishImage()
 {
-    String oldMethodName = methodName;
-    methodName = "mqttPublishImage()";
-    Log.verboseln("Entering");
+    TRACE_SCOPE("mqttPublishImage()");
 
     if (!mqttConnected)
     {
-        Log.infoln("MQTT not connected. Caching images to SD.");
-        char ifn[30];
-        sprintf(ifn, "/imgtemp/cap_%i.jpg", storedImageIndex);
-        Log.infoln("Opening %s", ifn);
-        /*
-        File file = SD_MMC.open(ifn, FILE_WRITE);
-        if (file)
+#ifdef USE_SD_CARD
+        if (imageJournal.isReady())
+        {
+            logRing.verboseln("MQTT not connected. Caching image to SD.");
+            camera_fb_t *fb = cam.grab();
+            if (fb == NULL || !imageJournal.append(fb->buf, fb->len, isGoodTime ? (uint32_t)time(NULL) : 0, millis()))
+                imagesDropped++;
+            cam.release(fb);
+        }
+#endif
+    }
+    else
+    {
+#ifdef USE_SD_CARD
+        // drain the backlog a few frames per tick, sharing the in-flight slots with live frames
+        if (!imageJournal.isEmpty())
+        {
+            size_t sent = imageJournal.replay(IMAGE_JOURNAL_REPLAY_BATCH, publishJournalImage, imageInFlightSlotFree);
+            logRing.verboseln("Sent %u cached images, %u still cached.", sent, imageJournal.pending());
+        }
+#endif
+
+        // flow control: a new frame only goes out once the broker has acked enough of the
+        // previous ones, otherwise it is dropped rather than queued behind them
+        int slot = reserveImageInFlightSlot();
+        if (slot < 0)
+        {
+            imagesDropped++;
+            logRing.verboseln("Too many images in flight, dropping frame.");
+            return;
+        }
+
+        logRing.verboseln("Sending current image via MQTT.");
+        camera_fb_t *fb = cam.grab();
+        if (fb == NULL)
+        {
+            imagesDropped++;
+            releaseImageInFlightSlot(slot);
+            return;
+        }
+
+        // publish straight from the camera frame buffer, the client keeps its own copy.
+        // QoS0 has no ack, so its slot is released as soon as the publish is queued
+        uint16_t packetId = mqttClient.publish(imageTopic, IMAGE_PUBLISH_QOS, false, (char *)fb->buf, fb->len);
+        size_t frameLen = fb->len;
+        cam.release(fb);
+        if (packetId == 0)
         {
-            Log.infoln("Opened %s", ifn);
-            cam.run();
-            file.write(cam.getfb(), cam.getSize()); // payload (image), payload length
-            file.close();
-            Log.infoln("Saved image to: %s\n", ifn);
-            storedImageIndex++;
+            imagesDropped++;
+            releaseImageInFlightSlot(slot);
+            logRing.warningln("Image publish failed (%u bytes).", frameLen);
         }
         else
         {
-            Log.errorln("Failed to open file (%s) in writing mode!!!", ifn);
+            imagesPublished++;
+            commitImageInFlightSlot(slot, packetId);
         }
-        */
     }
-    else
+}
+
+#ifdef USE_SD_CARD
+// ImageJournal replay handler, false (try again later) while all in-flight slots are busy
+bool publishJournalImage(const uint8_t *data, size_t len, const JournalRecordHeader &header)
+{
+    int slot = reserveImageInFlightSlot();
+    if (slot < 0)
+        return false;
+
+    uint16_t packetId = mqttClient.publish(imageTopic, IMAGE_PUBLISH_QOS, false, (const char *)data, len);
+    if (packetId == 0)
+    {
+        releaseImageInFlightSlot(slot);
+        Log.warningln("Cached image %u publish failed.", header.seq);
+        return false;
+    }
+
+    imagesPublished++;
+    commitImageInFlightSlot(slot, packetId);
+    return true;
+}
+#endif
+
+// finds a free in-flight slot (expiring ones whose ack never came), -1 if all are busy
+int reserveImageInFlightSlot()
+{
+    int slot = -1;
+    uint32_t now = millis();
+
+    portENTER_CRITICAL(&imageInFlightMux);
+    for (int i = 0; i < IMAGE_PUBLISH_MAX_INFLIGHT; i++)
     {
-        if (storedImageIndex > 0)
+        ImageInFlight &entry = imageInFlight[i];
+        if ((entry.reserved || (entry.packetId != 0)) && (now - entry.sentAt > IMAGE_PUBLISH_ACK_TIMEOUT_MS))
         {
-            Log.infoln("Sending cached images to MQTT.");
-            for (int i = 0; i < storedImageIndex; i++)
-            {
-                char ifn[30];
-                sprintf(ifn, "/imgtmp/cap_%i", i);
-                File file = SD.open(ifn, "r");
-                if (!file)
-                {
-                    Log.errorln("Failed to open file (%s) in reading mode!!!", ifn);
-                }
-
-                Log.verboseln("Reading file: %s", ifn);
-                int len = file.size();
-                char imgBuf[len + 1];
-                file.readBytes(imgBuf, len);
-                imgBuf[len + 1] = '\0';
-                file.close();
-                Log.verboseln("Sending via MQTT.");
-                int pubRes = mqttClient.publish(imageTopic, 1, false, imgBuf, len);
-                // delete[] imgBuf;
-            }
+            entry.reserved = false;
+            entry.packetId = 0;
+        }
+
+        if ((slot < 0) && !entry.reserved && (entry.packetId == 0))
+        {
+            slot = i;
+            entry.reserved = true; // until the publish returns, see commitImageInFlightSlot()
+            entry.sentAt = now;
+        }
+    }
+    portEXIT_CRITICAL(&imageInFlightMux);
+
+    return slot;
+}
+
+// whether reserveImageInFlightSlot() would find a slot right now
+bool imageInFlightSlotFree()
+{
+    bool found = false;
+    uint32_t now = millis();
+
+    portENTER_CRITICAL(&imageInFlightMux);
+    for (int i = 0; !found && (i < IMAGE_PUBLISH_MAX_INFLIGHT); i++)
+    {
+        const ImageInFlight &entry = imageInFlight[i];
+        found = (!entry.reserved && (entry.packetId == 0)) || (now - entry.sentAt > IMAGE_PUBLISH_ACK_TIMEOUT_MS);
+    }
+    portEXIT_CRITICAL(&imageInFlightMux);
+
+    return found;
+}
+
+// stores the packetId publish() returned for a reserved slot, which then waits for its ack.
+// QoS0 has no ack and the ack may already have come, either way the slot is free again.
+void commitImageInFlightSlot(int slot, uint16_t packetId)
+{
+    uint32_t now = millis();
+
+    portENTER_CRITICAL(&imageInFlightMux);
+    bool acked = (IMAGE_PUBLISH_QOS == 0);
+    for (int i = 0; !acked && (i < IMAGE_PUBLISH_MAX_INFLIGHT); i++)
+    {
+        ImageEarlyAck &early = imageEarlyAcks[i];
+        if ((early.packetId == packetId) && (now - early.ackedAt <= IMAGE_PUBLISH_ACK_TIMEOUT_MS))
+        {
+            early.packetId = 0;
+            acked = true;
+        }
+    }
+    imageInFlight[slot].reserved = false;
+    imageInFlight[slot].packetId = acked ? 0 : packetId;
+    imageInFlight[slot].sentAt = now;
+    portEXIT_CRITICAL(&imageInFlightMux);
+}
+
+// gives back a reserved slot whose frame was not published
+void releaseImageInFlightSlot(int slot)
+{
+    portENTER_CRITICAL(&imageInFlightMux);
+    imageInFlight[slot].reserved = false;
+    imageInFlight[slot].packetId = 0;
+    portEXIT_CRITICAL(&imageInFlightMux);
+}
+
+// AsyncMqttClient onPublish callback, runs on the async_tcp task
+void onImagePublishAck(uint16_t packetId)
+{
+#ifdef USE_FAST_WAKE
+    if (wakeFramePacketId != 0 && packetId == wakeFramePacketId)
+        wakeFrameSent = true;
+#endif
+
+    portENTER_CRITICAL(&imageInFlightMux);
+    bool found = false;
+    bool anyReserved = false;
+    for (int i = 0; i < IMAGE_PUBLISH_MAX_INFLIGHT; i++)
+    {
+        if (imageInFlight[i].packetId == packetId)
+        {
+            imageInFlight[i].packetId = 0;
+            found = true;
         }
+        anyReserved |= imageInFlight[i].reserved;
+    }
 
-        Log.infoln("Sending current image via MQTT.");
-        cam.run();
+    // may be the ack of a frame whose publish() has not returned yet
+    if (!found && anyReserved)
+    {
+        imageEarlyAcks[imageEarlyAckNext].packetId = packetId;
+        imageEarlyAcks[imageEarlyAckNext].ackedAt = millis();
+        imageEarlyAckNext = (imageEarlyAckNext + 1) % IMAGE_PUBLISH_MAX_INFLIGHT;
+    }
+    portEXIT_CRITICAL(&imageInFlightMux);
+}
 
-        int pubRes = mqttClient.publish(imageTopic, 1, false, (char *)cam.getfb(), cam.getSize());
+void clearImagesInFlight()
+{
+    portENTER_CRITICAL(&imageInFlightMux);
+    for (int i = 0; i < IMAGE_PUBLISH_MAX_INFLIGHT; i++)
+    {
+        imageInFlight[i].reserved = false;
+        imageInFlight[i].packetId = 0;
+        imageEarlyAcks[i].packetId = 0;
     }
+    portEXIT_CRITICAL(&imageInFlightMux);
+}
 
-    Log.verboseln("Exiting...");
-    methodName = oldMethodName;
+// The timer only wakes this task, so capturing and publishing never runs on (and blocks)
+// the FreeRTOS timer service task. Wake-ups that arrive while a publish is still running
+// collapse into one.
+void imagePublishTask(void *pvParameters)
+{
+    (void)pvParameters;
+
+    while (true)
+    {
+        taskWatchdogFeed();
+        if (ulTaskNotifyTake(pdTRUE, TASK_IDLE_WAIT) > 0)
+            mqttPublishImage();
+    }
+}
+
+void requestImagePublish(TimerHandle_t xTimer)
+{
+    (void)xTimer;
+
+    if (imagePublishTaskHandle != NULL)
+        xTaskNotifyGive(imagePublishTaskHandle);
+}
+
+#ifdef USE_FRAME_CAPTURE
+// Hands every frame the camera delivers to the AVI recorder and the event clip ring. Frames it
+// grabs are its own, so it never returns a buffer another task is still reading; the copies
+// into the recorder's staging block and the ring are all it does while holding one, and
+// neither waits: a frame the SD card writer has no room for is dropped from the recording.
+void frameCaptureTask(void *pvParameters)
+{
+    (void)pvParameters;
+
+    while (frameCaptureStopRequester == NULL)
+    {
+        taskWatchdogFeed();
+        camera_fb_t *fb = cam.grab();
+        if (fb == NULL)
+        {
+            delay(100);
+            continue;
+        }
+        uint32_t now = millis();
+#ifdef USE_MOTION_DETECTION
+        motionDetection.offerFrame(fb->buf, fb->len, now);
+#endif
+#ifdef USE_AVI_RECORDER
+        bool record = aviRecorder.isReady();
+#ifdef USE_MOTION_DETECTION
+        // full rate only while there is motion; idle stretches play back sped up
+        if (record && motionDetection.isReady() && !motionDetection.isActive())
+            record = (lastRecordedMs == 0) || (now - lastRecordedMs >= 1000 / MOTION_IDLE_FPS);
+        if (record)
+            lastRecordedMs = now;
+#endif
+        if (record)
+            aviRecorder.addFrame(fb->buf, fb->len, fb->width, fb->height, now, 0);
+#endif
+#ifdef USE_EVENT_CLIPS
+        eventClips.addFrame(fb->buf, fb->len, now);
+#endif
+        cam.release(fb);
+    }
+
+#ifdef USE_AVI_RECORDER
+    if (aviRecorder.isReady())
+        aviRecorder.finish(AVI_STOP_TIMEOUT_MS);
+#endif
+    TaskHandle_t requester = frameCaptureStopRequester;
+    frameCaptureTaskHandle = NULL;
+    xTaskNotifyGive(requester);
+    taskWatchdogEnd();
+    vTaskDelete(NULL);
+}
+
+// closes the open segment and clip so they play without being recovered on the next boot
+void stopFrameCapture()
+{
+#ifdef USE_EVENT_CLIPS
+    if (!eventClips.end(AVI_STOP_TIMEOUT_MS))
+        Log.warningln("Event clip did not close in time, it will be recovered");
+#endif
+    if (frameCaptureTaskHandle == NULL)
+        return;
+
+    frameCaptureStopRequester = xTaskGetCurrentTaskHandle();
+    if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(AVI_STOP_TIMEOUT_MS)) == 0)
+        Log.warningln("AVI: recording did not stop in time, the last segment will be recovered");
+}
+#endif
+
+#ifdef USE_EVENT_CLIPS
+// EventClips publish handler, used when there is no SD card. Frames go to <appName>/clip/<n>
+// in order, then a summary to <appName>/clip/<n>/done. Runs on the clip task, so it may wait
+// for an in-flight slot; capture goes on meanwhile and the ring drops what the clip misses.
+bool publishClipFrame(uint32_t clip, uint32_t frame, const uint8_t *data, size_t len, uint32_t timeMs)
+{
+    char topic[100];
+    if (!mqttClient.connected())
+        return false;
+
+    if (data == NULL)
+    {
+        char summary[80];
+        snprintf(topic, sizeof(topic), "%s/clip/%u/done", appName, clip);
+        snprintf(summary, sizeof(summary), "{\"clip\":%u,\"frames\":%u,\"endMs\":%u}", clip, frame, timeMs);
+        return mqttClient.publish(topic, 1, false, summary) != 0;
+    }
+
+    int slot;
+    uint32_t start = millis();
+    while ((slot = reserveImageInFlightSlot()) < 0)
+    {
+        if (millis() - start > EVENT_CLIP_SLOT_WAIT_MS)
+        {
+            Log.warningln("Clip %u frame %u dropped, no publish slot", clip, frame);
+            return false;
+        }
+        delay(20);
+    }
+
+    snprintf(topic, sizeof(topic), "%s/clip/%u", appName, clip);
+    uint16_t packetId = mqttClient.publish(topic, IMAGE_PUBLISH_QOS, false, (const char *)data, len);
+    if (packetId == 0)
+    {
+        releaseImageInFlightSlot(slot);
+        return false;
+    }
+
+    commitImageInFlightSlot(slot, packetId);
+    return true;
+}
+#endif
+
+#ifdef USE_MOTION_DETECTION
+// Runs on the motion task. Publishes an alert, saves the frame that started the motion, starts
+// a clip and raises the publish rate; the rate goes back down when the motion ends.
+void onMotionEvent(bool started, uint16_t changedCells, const uint8_t *jpeg, size_t len)
+{
+    char alert[100];
+    snprintf(alert, sizeof(alert), "{\"appInstanceID\":%d,\"motion\":%s,\"cells\":%u}", appInstanceID,
+             started ? "true" : "false", changedCells);
+    if (mqttClient.connected())
+        mqttClient.publish(motionTopic, 1, false, alert);
+
+    if (started)
+    {
+#ifdef USE_SD_CARD
+        saveMotionSnapshot(jpeg, len);
+#endif
+#ifdef USE_EVENT_CLIPS
+        eventClips.trigger("motion");
+#endif
+    }
+
+    xTimerChangePeriod(mqttImageSendTimer, pdMS_TO_TICKS(started ? IMAGE_PUBLISH_INTERVAL_MS : 1000 / MOTION_IDLE_FPS),
+                       0);
+}
+
+// zones holds [x0, y0, x1, y1] cell rectangles; none means the whole frame
+void setMotionZones(JsonArrayConst zones)
+{
+    CameraMotionDetector &detector = motionDetection.detector();
+    detector.setZone(0, 0, MOTION_GRID_COLS - 1, MOTION_GRID_ROWS - 1, zones.size() == 0);
+    for (JsonVariantConst zone : zones)
+    {
+        if (zone.size() == 4)
+            detector.setZone(zone[0], zone[1], zone[2], zone[3], true);
+    }
+}
+
+#ifdef USE_SD_CARD
+void findMotionSnapshots()
+{
+    if (!SD.exists(MOTION_SNAPSHOT_DIR) && !SD.mkdir(MOTION_SNAPSHOT_DIR))
+    {
+        Log.warningln("Motion: cannot create %s", MOTION_SNAPSHOT_DIR);
+        return;
+    }
+
+    File dir = SD.open(MOTION_SNAPSHOT_DIR);
+    File entry;
+    while ((entry = dir.openNextFile()))
+    {
+        unsigned number;
+        const char *name = entry.name();
+        const char *slash = strrchr(name, '/');
+        if (slash)
+            name = slash + 1;
+        if (!entry.isDirectory() && (sscanf(name, "snap%u.jpg", &number) == 1) && (number > motionSnapshotNumber))
+            motionSnapshotNumber = number;
+        entry.close();
+    }
+    dir.close();
+}
+
+// keeps the frames that started the last MOTION_KEEP_SNAPSHOTS motion events
+void saveMotionSnapshot(const uint8_t *jpeg, size_t len)
+{
+    char path[40];
+    uint32_t number = ++motionSnapshotNumber;
+    snprintf(path, sizeof(path), "%s/snap%05u.jpg", MOTION_SNAPSHOT_DIR, number);
+    File file = SD.open(path, FILE_WRITE);
+    if (!file || file.write(jpeg, len) != len)
+        Log.warningln("Motion: saving %s failed", path);
+    file.close();
+
+    if (number > MOTION_KEEP_SNAPSHOTS)
+    {
+        snprintf(path, sizeof(path), "%s/snap%05u.jpg", MOTION_SNAPSHOT_DIR, number - MOTION_KEEP_SNAPSHOTS);
+        SD.remove(path);
+    }
+}
+#endif
+#endif
+
+#ifdef USE_FAST_WAKE
+// Runs in app_setup() while Wi-Fi associates, so the frame is ready by the time MQTT is up
+void captureWakeFrame()
+{
+    camera_fb_t *fb = NULL;
+    for (int i = 0; i <= FAST_WAKE_SKIP_FRAMES; i++)
+    {
+        cam.release(fb);
+        fb = cam.grab();
+    }
+    if (fb == NULL)
+    {
+        Log.warningln("Wake frame capture failed");
+        return;
+    }
+
+    wakeFrame = (uint8_t *)(psramFound() ? ps_malloc(fb->len) : malloc(fb->len));
+    if (wakeFrame != NULL)
+    {
+        memcpy(wakeFrame, fb->buf, fb->len);
+        wakeFrameLen = fb->len;
+        Log.infoln("Wake frame taken at %u ms", millis());
+    }
+    cam.release(fb);
+}
+
+// first thing once MQTT is connected; sleep waits for the broker's ack
+void publishWakeFrame()
+{
+    if (wakeFrame == NULL || wakeFramePacketId != 0)
+        return;
+
+    wakeFramePacketId = mqttClient.publish(imageTopic, 1, false, (const char *)wakeFrame, wakeFrameLen);
+    if (wakeFramePacketId == 0)
+        Log.warningln("Wake frame publish failed");
+    else
+        Log.infoln("Wake frame sent at %u ms", millis());
+}
+#endif
+
+// going back to sleep waits for the wake frame, within FAST_WAKE_SEND_TIMEOUT_MS
+bool readyToSleep()
+{
+#ifdef USE_FAST_WAKE
+    if (wakeFrame != NULL && !wakeFrameSent && millis() < FAST_WAKE_SEND_TIMEOUT_MS)
+        return false;
+#endif
+    return true;
 }
 
 bool checkGoodTime()
 {
-    String oldMethodName = methodName;
-    methodName = "checkGoodTime()";
-    Log.verboseln("Entering...");
+    TRACE_SCOPE("checkGoodTime()");
 
     struct tm timeinfo;
     if (!getLocalTime(&timeinfo))
@@ -455,23 +1015,17 @@ bool checkGoodTime()
         return false;
     }
 
-    Log.verboseln("Exiting...");
-    methodName = oldMethodName;
     return true;
 }
 
 bool getNewTime()
 {
-    String oldMethodName = methodName;
-    methodName = "getNewTime()";
-    Log.verboseln("Entering...");
+    TRACE_SCOPE("getNewTime()");
 
     struct tm timeinfo;
     if (!getLocalTime(&timeinfo))
     {
         Log.errorln("Failed to obtain time");
-        Log.verboseln("Exiting...");
-        methodName = oldMethodName;
         return false;
     }
 
@@ -483,13 +1037,9 @@ bool getNewTime()
     {
         strcpy(currentTime, newTime);
         Log.infoln("Time is now %s %s", currentTime, meridian);
-        Log.verboseln("Exiting...");
-        methodName = oldMethodName;
         return true;
     }
 
-    Log.verboseln("Exiting...");
-    methodName = oldMethodName;
     return false;
 }
 
@@ -500,9 +1050,7 @@ void redrawScreen()
 
 void drawTime()
 {
-    String oldMethodName = methodName;
-    methodName = "drawTime()";
-    Log.verboseln("Entering...");
+    TRACE_SCOPE("drawTime()");
 
 #ifdef USE_GRAPHICS
     tft.fillScreen(TFT_BLACK);
@@ -512,9 +1060,6 @@ void drawTime()
 #endif
 
 #endif
-
-    Log.verboseln("Exiting...");
-    methodName = oldMethodName;
 }
 
 /*
@@ -527,7 +1072,10 @@ IRAM_ATTR void mailboxOpened()
 
 void mailboxClosed()
 {
-    Log.infoln("Going to sleep now");
+    Log.infoln("Going to sleep now, %u ms after boot", millis());
+#ifdef USE_FRAME_CAPTURE
+    stopFrameCapture();
+#endif
     WiFi.mode(WIFI_OFF);
     // TODO: see if this is needed
     // adc_power_off();
@@ -536,9 +1084,7 @@ void mailboxClosed()
 
 void app_setup()
 {
-    String oldMethodName = methodName;
-    methodName = "app_setup()";
-    Log.verboseln("Entering...");
+    TRACE_SCOPE("app_setup()");
 
     // Add some custom code here
     initAppStrings();
@@ -570,22 +1116,83 @@ void app_setup()
 
 
 #ifdef USE_ESP32_CAM
-    mqttImageSendTimer = xTimerCreate("mqttImageSendTimer", pdMS_TO_TICKS(200), pdTRUE,
-                                      (void *)0, reinterpret_cast<TimerCallbackFunction_t>(mqttPublishImage));
+    startTask(imagePublishTask, "imagePublish", IMAGE_PUBLISH_STACK_SIZE, NULL, IMAGE_PUBLISH_PRIORITY,
+              IMAGE_PUBLISH_CORE, &imagePublishTaskHandle);
+
+    mqttClient.onPublish(onImagePublishAck);
+
+#ifdef USE_FAST_WAKE
+    // Wi-Fi is still associating, the frame is ready before MQTT is
+    if (fastWake)
+        captureWakeFrame();
+#endif
+
+#ifdef USE_SD_CARD
+    if (!imageJournal.begin(SD))
+        Log.warningln("Image journal unavailable, images taken offline will be dropped");
+#endif
+    mqttImageSendTimer = xTimerCreate("mqttImageSendTimer", pdMS_TO_TICKS(IMAGE_PUBLISH_INTERVAL_MS), pdTRUE,
+                                      (void *)0, requestImagePublish);
+#endif
+
+#ifdef USE_MOTION_DETECTION
+    mqttIngest.filter()["threshold"] = true;
+    mqttIngest.filter()["minCells"] = true;
+    mqttIngest.filter()["zones"] = true;
+#ifdef USE_SD_CARD
+    findMotionSnapshots();
+#endif
+    // images are published at the idle rate from now on, onMotionEvent() raises it while there is motion
+    if (!motionDetection.begin(onMotionEvent))
+        Log.warningln("Motion detection unavailable");
+    else
+        xTimerChangePeriod(mqttImageSendTimer, pdMS_TO_TICKS(1000 / MOTION_IDLE_FPS), 0);
+#endif
+
+#ifdef USE_AVI_RECORDER
+    if (!aviRecorder.begin(SD))
+        Log.warningln("AVI recorder unavailable, nothing will be recorded");
+#endif
+
+#ifdef USE_EVENT_CLIPS
+#ifdef USE_SD_CARD
+    if (!eventClips.begin(&SD, publishClipFrame))
+#else
+    if (!eventClips.begin(NULL, publishClipFrame))
 #endif
+        Log.warningln("Event clips unavailable");
 
-    ///*
-    File root = SD.open("/");
-    if (!root)
+    if (EVENT_TRIGGER_GPIO > -1)
     {
-        Log.errorln("Failed to open directory");
+        pinMode(EVENT_TRIGGER_GPIO, INPUT);
+        eventTriggerLevel = digitalRead(EVENT_TRIGGER_GPIO);
     }
-    else
+#endif
+
+#ifdef USE_FRAME_CAPTURE
+    bool capture = false;
+#ifdef USE_AVI_RECORDER
+    capture |= aviRecorder.isReady();
+#endif
+#ifdef USE_EVENT_CLIPS
+    capture |= eventClips.isReady();
+#endif
+#ifdef USE_MOTION_DETECTION
+    capture |= motionDetection.isReady();
+#endif
+    if (capture)
     {
-        printDirectory(root, 0);
+        startTask(frameCaptureTask, "frameCapture", FRAME_CAPTURE_STACK_SIZE, NULL, FRAME_CAPTURE_PRIORITY,
+                  FRAME_CAPTURE_CORE, &frameCaptureTaskHandle);
     }
-    root.close();
-    //*/
+#endif
+
+#ifdef USE_EVENT_CLIPS
+    // the wake-up pin going high is an event too; the clip has no pre-event part yet
+    if (wakeup_reason == ESP_SLEEP_WAKEUP_EXT1)
+        eventClips.trigger("wakeup");
+#endif
+
     // Turns off the ESP32-CAM white on-board LED (flash) connected to GPIO 4
     // uncomment if LED is still soldered to GPIO4
     pinMode(4, OUTPUT);
@@ -593,9 +1200,6 @@ void app_setup()
     gpio_hold_en(GPIO_NUM_4);
 
     // xTimerStart(mqttImageSendTimer, pdMS_TO_TICKS(5000));
-
-    Log.verboseln("Exiting...");
-    methodName = oldMethodName;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -607,10 +1211,20 @@ void app_setup()
 void app_loop()
 {
 #ifdef USE_DEEP_SLEEP
-    if (digitalRead(WAKEUP_GPIO) == 0)
+    if (digitalRead(WAKEUP_GPIO) == 0 && readyToSleep())
         mailboxClosed();
 #endif
 
+#ifdef USE_EVENT_CLIPS
+    if (EVENT_TRIGGER_GPIO > -1)
+    {
+        int level = digitalRead(EVENT_TRIGGER_GPIO);
+        if (level && !eventTriggerLevel)
+            eventClips.trigger("gpio");
+        eventTriggerLevel = level;
+    }
+#endif
+
 /*
 #ifdef USE_RTSP
     if (rtspServerRunning)
@@ -618,6 +1232,11 @@ void app_loop()
 #endif
 */
 
+#if defined(USE_WEB_SERVER) && defined(USE_ESP32_CAM)
+    if (wifiConnected)
+        wsPushFrame();
+#endif
+
     if ((millis() % 1000) == 0)
     {
         if (!isGoodTime)
@@ -0,0 +1,699 @@
+////////////////////////////////////////////////////////////////////
+/// @file avi_recorder.h
+/// @brief Continuous recording of camera frames into segmented
+/// MJPEG AVI files on the SD card
+////////////////////////////////////////////////////////////////////
+
+#ifndef AVI_RECORDER_H
+#define AVI_RECORDER_H
+
+#include "framework.h"
+
+// Frames are appended as '00dc' chunks to one AVI file per segment. The recording task only
+// copies each frame into one of two large staging blocks (PSRAM when there is some); a writer
+// task hands a block to the SD card in a single write once it is full, while the other block
+// fills. Every write but a segment's last one is a whole block at a block aligned offset, so
+// FAT sees long sequential cluster runs instead of a file create and a directory update per
+// frame.
+//
+// The idx1 index is built in memory as frames are added and written, with the final header
+// fields, when the segment is closed: after AVI_SEGMENT_SECONDS, or earlier when its index or
+// size limit is reached. The RIFF size stays 0 until then, so a segment cut short by a reset
+// is found on the next boot, its index rebuilt by walking the movi chunks and the file closed
+// as if it had ended there. Only the newest keepSegments files are kept.
+//
+// The defaults suit continuous recording into AVI_DIR; event clips use a second recorder with
+// their own directory and a smaller index.
+//
+// addFrame() and finish() must be called from one task; the writer task owns the files.
+
+#ifndef AVI_DIR
+#define AVI_DIR "/rec"
+#endif
+
+#ifndef AVI_SEGMENT_SECONDS
+#define AVI_SEGMENT_SECONDS 300
+#endif
+
+#ifndef AVI_MAX_FPS
+#define AVI_MAX_FPS 30 // sizes the in-memory index: AVI_SEGMENT_SECONDS * AVI_MAX_FPS entries
+#endif
+
+#ifndef AVI_SEGMENT_MAX_BYTES
+#define AVI_SEGMENT_MAX_BYTES (1024UL * 1024 * 1024) // AVI 1.0 files must stay below 2 GB
+#endif
+
+#ifndef AVI_KEEP_SEGMENTS
+#define AVI_KEEP_SEGMENTS 48 // oldest segments are deleted beyond this, 0 keeps them all
+#endif
+
+#ifndef AVI_STAGING_SIZE
+#define AVI_STAGING_SIZE (64UL * 1024) // bytes per staging block, a multiple of the cluster size
+#endif
+
+#ifndef AVI_WRITER_STACK_SIZE
+#define AVI_WRITER_STACK_SIZE 3072
+#endif
+
+#ifndef AVI_WRITER_PRIORITY
+#define AVI_WRITER_PRIORITY TASK_PRIORITY_STORAGE
+#endif
+
+#ifndef AVI_WRITER_CORE
+#define AVI_WRITER_CORE TASK_CORE_CAPTURE
+#endif
+
+#ifndef AVI_DEFAULT_FRAME_US
+#define AVI_DEFAULT_FRAME_US 40000 // frame period assumed until two frames have been seen
+#endif
+
+#define AVI_INDEX_CAPACITY (AVI_SEGMENT_SECONDS * AVI_MAX_FPS)
+#define AVI_HEADER_SIZE 512 // everything up to the first frame chunk, one sector
+#define AVI_MOVI_FOURCC_OFFSET (AVI_HEADER_SIZE - 4) // idx1 offsets count from the 'movi' fourcc
+
+#define AVI_FOURCC(a, b, c, d) ((uint32_t)(a) | ((uint32_t)(b) << 8) | ((uint32_t)(c) << 16) | ((uint32_t)(d) << 24))
+#define AVIF_HASINDEX 0x10
+#define AVIIF_KEYFRAME 0x10
+
+// RIFF 'AVI ' with one MJPEG video stream, padded with a JUNK chunk so the movi data starts
+// on a sector boundary
+struct __attribute__((packed)) AviHeader
+{
+    uint32_t riff;
+    uint32_t riffSize; // 0 while the segment is being recorded
+    uint32_t avi;
+
+    uint32_t hdrlList;
+    uint32_t hdrlSize;
+    uint32_t hdrl;
+
+    uint32_t avih;
+    uint32_t avihSize;
+    uint32_t usPerFrame;
+    uint32_t maxBytesPerSec;
+    uint32_t paddingGranularity;
+    uint32_t flags;
+    uint32_t totalFrames;
+    uint32_t initialFrames;
+    uint32_t streams;
+    uint32_t suggestedBufferSize;
+    uint32_t width;
+    uint32_t height;
+    uint32_t reserved[4];
+
+    uint32_t strlList;
+    uint32_t strlSize;
+    uint32_t strl;
+
+    uint32_t strh;
+    uint32_t strhSize;
+    uint32_t fccType;
+    uint32_t fccHandler;
+    uint32_t streamFlags;
+    uint16_t priority;
+    uint16_t language;
+    uint32_t streamInitialFrames;
+    uint32_t scale; // rate / scale = frames per second
+    uint32_t rate;
+    uint32_t start;
+    uint32_t length;
+    uint32_t streamSuggestedBufferSize;
+    uint32_t quality;
+    uint32_t sampleSize;
+    int16_t frameLeft;
+    int16_t frameTop;
+    int16_t frameRight;
+    int16_t frameBottom;
+
+    uint32_t strf;
+    uint32_t strfSize;
+    uint32_t biSize;
+    int32_t biWidth;
+    int32_t biHeight;
+    uint16_t biPlanes;
+    uint16_t biBitCount;
+    uint32_t biCompression;
+    uint32_t biSizeImage;
+    int32_t biXPelsPerMeter;
+    int32_t biYPelsPerMeter;
+    uint32_t biClrUsed;
+    uint32_t biClrImportant;
+
+    uint32_t junk;
+    uint32_t junkSize;
+    uint8_t junkData[280];
+
+    uint32_t moviList;
+    uint32_t moviSize;
+    uint32_t movi;
+};
+
+static_assert(sizeof(AviHeader) == AVI_HEADER_SIZE, "AviHeader must end where the first frame starts");
+
+struct AviChunkHeader
+{
+    uint32_t id;
+    uint32_t size;
+};
+
+struct AviIndexEntry
+{
+    uint32_t id;
+    uint32_t flags;
+    uint32_t offset; // of the chunk header, from the 'movi' fourcc
+    uint32_t size;
+};
+
+struct AviSegment
+{
+    uint32_t number;
+    File file;
+    AviIndexEntry *index; // indexCapacity entries, reused from segment to segment
+    uint32_t frames;
+    uint32_t length; // file bytes so far, header included
+    uint32_t maxFrame;
+    uint32_t firstMs;
+    uint32_t lastMs;
+    uint32_t usPerFrame; // estimate written when the segment is opened, kept by recovery
+    uint16_t width;
+    uint16_t height;
+    bool failed; // a write came up short, the file is closed without an index
+};
+
+struct AviWriteJob
+{
+    int buffer;     // staging block to write, -1 for none
+    uint32_t len;
+    AviSegment *segment;
+    bool close;     // finish the segment after the write
+};
+
+MetricCounter aviFramesRecorded("avi_frames_recorded_total", "Frames added to AVI segments");
+MetricCounter aviSegmentsClosed("avi_segments_closed_total", "AVI segments closed with an index");
+MetricCounter aviWriteErrors("avi_write_errors_total", "AVI staging blocks the SD card did not take completely");
+MetricHistogram aviBlockWriteTime("avi_block_write_seconds", "Time to write one AVI staging block to the SD card");
+MetricHistogram aviStagingWait("avi_staging_wait_seconds", "Time the recorder waited for the writer to free a staging block");
+MetricCounter aviFramesDropped("avi_frames_dropped_total", "Frames not recorded because the SD card writer was behind");
+
+class AviRecorder
+{
+public:
+    AviRecorder() : m_fs(NULL), m_ready(false), m_jobs(NULL), m_freeBlocks(NULL), m_freeSegments(NULL),
+                    m_writerTask(NULL), m_current(NULL), m_nextSlot(0), m_fill(-1), m_fillLen(0),
+                    m_lastNumber(0), m_lastFrameMs(0), m_frameUs(AVI_DEFAULT_FRAME_US), m_oldestNumber(1),
+                    m_dir(AVI_DIR), m_indexCapacity(AVI_INDEX_CAPACITY), m_keepSegments(AVI_KEEP_SEGMENTS)
+    {
+        m_staging[0] = m_staging[1] = NULL;
+        m_segments[0].index = m_segments[1].index = NULL;
+    }
+
+    // allocates the staging blocks and indexes, closes segments a reset left open in dir and
+    // starts the writer task. A segment holds at most indexCapacity frames.
+    bool begin(fs::FS &fs, const char *dir = AVI_DIR, uint32_t indexCapacity = AVI_INDEX_CAPACITY,
+               uint32_t keepSegments = AVI_KEEP_SEGMENTS)
+    {
+        m_fs = &fs;
+        m_ready = false;
+        m_dir = dir;
+        m_indexCapacity = indexCapacity;
+        m_keepSegments = keepSegments;
+
+        if (!m_fs->exists(m_dir) && !m_fs->mkdir(m_dir))
+        {
+            Log.errorln("AVI: cannot create %s", m_dir);
+            return false;
+        }
+
+        for (int i = 0; i < 2; i++)
+        {
+            m_staging[i] = (uint8_t *)allocate(AVI_STAGING_SIZE);
+            m_segments[i].index = (AviIndexEntry *)allocate(m_indexCapacity * sizeof(AviIndexEntry));
+            if (!m_staging[i] || !m_segments[i].index)
+            {
+                Log.errorln("AVI: no memory for the staging blocks and indexes");
+                release();
+                return false;
+            }
+        }
+
+        scanSegments();
+
+        m_jobs = xQueueCreate(4, sizeof(AviWriteJob));
+        m_freeBlocks = xQueueCreate(2, sizeof(int));
+        m_freeSegments = xSemaphoreCreateCounting(2, 2);
+        if (!m_jobs || !m_freeBlocks || !m_freeSegments)
+        {
+            release();
+            return false;
+        }
+        for (int i = 0; i < 2; i++)
+            xQueueSend(m_freeBlocks, &i, 0);
+
+        if (!startTask(writerTask, "aviWriter", AVI_WRITER_STACK_SIZE, this, AVI_WRITER_PRIORITY, AVI_WRITER_CORE,
+                       &m_writerTask))
+        {
+            release();
+            return false;
+        }
+
+        m_ready = true;
+        Log.infoln("AVI: recording to %s, next segment %u", m_dir, m_lastNumber + 1);
+        return true;
+    }
+
+    bool isReady() { return m_ready; }
+
+    // copies one JPEG frame into the current segment, opening or rotating segments as needed.
+    // Waits up to wait ticks while both staging blocks, or both segments, are waiting for the
+    // SD card; with wait 0 a frame that does not fit the free staging space is dropped and
+    // counted instead, so frames larger than two staging blocks are never recorded.
+    bool addFrame(const uint8_t *data, size_t len, uint16_t width, uint16_t height, uint32_t uptimeMs,
+                  TickType_t wait = portMAX_DELAY)
+    {
+        if (!m_ready)
+            return false;
+
+        uint32_t chunkSize = sizeof(AviChunkHeader) + len + (len & 1);
+        if (m_current &&
+            ((uptimeMs - m_current->firstMs >= AVI_SEGMENT_SECONDS * 1000UL) ||
+             (m_current->frames >= m_indexCapacity) ||
+             (m_current->width != width) || (m_current->height != height) ||
+             (m_current->length + chunkSize + 8 + (m_current->frames + 1) * sizeof(AviIndexEntry) > AVI_SEGMENT_MAX_BYTES)))
+            closeSegment();
+
+        if (m_lastFrameMs != 0 && uptimeMs - m_lastFrameMs < 1000)
+            m_frameUs = (m_frameUs * 7 + (uptimeMs - m_lastFrameMs) * 1000) / 8;
+        m_lastFrameMs = uptimeMs;
+
+        // a slot is free again once the writer has closed the segment that used it
+        bool opening = (m_current == NULL);
+        if (((wait == 0) && (stagingRoom() < chunkSize + (opening ? sizeof(AviHeader) : 0))) ||
+            (opening && (xSemaphoreTake(m_freeSegments, wait) != pdTRUE)))
+        {
+            aviFramesDropped.add();
+            return false;
+        }
+
+        if (opening)
+            openSegment(width, height, uptimeMs);
+
+        AviSegment *seg = m_current;
+        AviIndexEntry &entry = seg->index[seg->frames];
+        entry.id = AVI_FOURCC('0', '0', 'd', 'c');
+        entry.flags = AVIIF_KEYFRAME;
+        entry.offset = seg->length - AVI_MOVI_FOURCC_OFFSET;
+        entry.size = len;
+
+        AviChunkHeader chunk = {AVI_FOURCC('0', '0', 'd', 'c'), (uint32_t)len};
+        stage((const uint8_t *)&chunk, sizeof(chunk));
+        stage(data, len);
+        if (len & 1)
+        {
+            uint8_t pad = 0;
+            stage(&pad, 1);
+        }
+
+        seg->length += chunkSize;
+        seg->frames++;
+        seg->lastMs = uptimeMs;
+        if (len > seg->maxFrame)
+            seg->maxFrame = len;
+        aviFramesRecorded.add();
+        return true;
+    }
+
+    // closes the current segment and waits up to timeoutMs for the writer to finish it
+    bool finish(uint32_t timeoutMs)
+    {
+        if (!m_ready)
+            return true;
+        if (m_current)
+            closeSegment();
+
+        // both segment slots free means nothing is queued or being written
+        int taken = 0;
+        while (taken < 2 && xSemaphoreTake(m_freeSegments, pdMS_TO_TICKS(timeoutMs)) == pdTRUE)
+            taken++;
+        for (int i = 0; i < taken; i++)
+            xSemaphoreGive(m_freeSegments);
+        return taken == 2;
+    }
+
+private:
+    static void *allocate(size_t len)
+    {
+        return psramFound() ? ps_malloc(len) : malloc(len);
+    }
+
+    // undoes a begin() that failed part way, before the writer task runs
+    void release()
+    {
+        for (int i = 0; i < 2; i++)
+        {
+            free(m_staging[i]);
+            m_staging[i] = NULL;
+            free(m_segments[i].index);
+            m_segments[i].index = NULL;
+        }
+        if (m_jobs)
+            vQueueDelete(m_jobs);
+        if (m_freeBlocks)
+            vQueueDelete(m_freeBlocks);
+        if (m_freeSegments)
+            vSemaphoreDelete(m_freeSegments);
+        m_jobs = m_freeBlocks = NULL;
+        m_freeSegments = NULL;
+    }
+
+    String segmentPath(uint32_t number)
+    {
+        char path[40];
+        snprintf(path, sizeof(path), "%s/rec%05u.avi", m_dir, (unsigned)number);
+        return String(path);
+    }
+
+    // finds the segment numbers in use and recovers the ones left open
+    void scanSegments()
+    {
+        uint32_t lowest = UINT32_MAX;
+        File dir = m_fs->open(m_dir);
+        if (!dir)
+            return;
+
+        File entry;
+        while ((entry = dir.openNextFile()))
+        {
+            unsigned number;
+            const char *name = entry.name();
+            const char *slash = strrchr(name, '/');
+            if (slash)
+                name = slash + 1;
+            bool isSegment = !entry.isDirectory() && (sscanf(name, "rec%u.avi", &number) == 1);
+            entry.close();
+            if (!isSegment)
+                continue;
+
+            if (number > m_lastNumber)
+                m_lastNumber = number;
+            if (number < lowest)
+                lowest = number;
+
+            recoverSegment(number);
+        }
+        dir.close();
+
+        m_oldestNumber = (lowest == UINT32_MAX) ? m_lastNumber + 1 : lowest;
+    }
+
+    void recoverSegment(uint32_t number)
+    {
+        String path = segmentPath(number);
+        AviSegment &seg = m_segments[0];
+        seg.file = m_fs->open(path, "r+");
+        if (!seg.file)
+            return;
+
+        AviHeader header;
+        if ((seg.file.read((uint8_t *)&header, sizeof(header)) != sizeof(header)) ||
+            (header.riff != AVI_FOURCC('R', 'I', 'F', 'F')) || (header.riffSize != 0))
+        {
+            seg.file.close();
+            return;
+        }
+
+        seg.number = number;
+        seg.frames = 0;
+        seg.length = AVI_HEADER_SIZE;
+        seg.maxFrame = 0;
+        seg.firstMs = seg.lastMs = 0;
+        seg.usPerFrame = header.usPerFrame;
+        seg.width = header.width;
+        seg.height = header.height;
+        seg.failed = false;
+
+        // every chunk that was written completely is kept, the rest is cut off
+        uint32_t fileSize = seg.file.size();
+        AviChunkHeader chunk;
+        while ((seg.frames < m_indexCapacity) && (seg.length + sizeof(chunk) <= fileSize) &&
+               seg.file.seek(seg.length) &&
+               (seg.file.read((uint8_t *)&chunk, sizeof(chunk)) == sizeof(chunk)) &&
+               (chunk.id == AVI_FOURCC('0', '0', 'd', 'c')) &&
+               (seg.length + sizeof(chunk) + chunk.size + (chunk.size & 1) <= fileSize))
+        {
+            AviIndexEntry &entry = seg.index[seg.frames++];
+            entry.id = chunk.id;
+            entry.flags = AVIIF_KEYFRAME;
+            entry.offset = seg.length - AVI_MOVI_FOURCC_OFFSET;
+            entry.size = chunk.size;
+            if (chunk.size > seg.maxFrame)
+                seg.maxFrame = chunk.size;
+            seg.length += sizeof(chunk) + chunk.size + (chunk.size & 1);
+        }
+
+        Log.warningln("AVI: %s was not closed, recovered %u frames", path.c_str(), seg.frames);
+        finishSegment(&seg);
+        seg.file.close();
+    }
+
+    // needs a segment slot taken from m_freeSegments
+    void openSegment(uint16_t width, uint16_t height, uint32_t uptimeMs)
+    {
+        AviSegment *seg = &m_segments[m_nextSlot];
+        m_nextSlot ^= 1;
+        seg->number = ++m_lastNumber;
+        seg->frames = 0;
+        seg->length = AVI_HEADER_SIZE;
+        seg->maxFrame = 0;
+        seg->firstMs = seg->lastMs = uptimeMs;
+        seg->usPerFrame = m_frameUs;
+        seg->width = width;
+        seg->height = height;
+        seg->failed = false;
+        m_current = seg;
+
+        AviHeader header;
+        buildHeader(header, seg);
+        stage((const uint8_t *)&header, sizeof(header));
+    }
+
+    void closeSegment()
+    {
+        AviWriteJob job = {m_fill, m_fillLen, m_current, true};
+        xQueueSend(m_jobs, &job, portMAX_DELAY);
+        m_fill = -1;
+        m_current = NULL;
+    }
+
+    // bytes that can be staged without waiting: only this task takes blocks from m_freeBlocks,
+    // so the writer can only add to this until the next stage()
+    size_t stagingRoom()
+    {
+        size_t room = uxQueueMessagesWaiting(m_freeBlocks) * AVI_STAGING_SIZE;
+        if (m_fill >= 0)
+            room += AVI_STAGING_SIZE - m_fillLen;
+        return room;
+    }
+
+    void stage(const uint8_t *data, size_t len)
+    {
+        while (len > 0)
+        {
+            if (m_fill < 0)
+            {
+                uint32_t startUs = micros();
+                xQueueReceive(m_freeBlocks, &m_fill, portMAX_DELAY);
+                aviStagingWait.observe(micros() - startUs);
+                m_fillLen = 0;
+            }
+
+            size_t n = minimum(len, AVI_STAGING_SIZE - m_fillLen);
+            memcpy(m_staging[m_fill] + m_fillLen, data, n);
+            m_fillLen += n;
+            data += n;
+            len -= n;
+
+            if (m_fillLen == AVI_STAGING_SIZE)
+            {
+                AviWriteJob job = {m_fill, m_fillLen, m_current, false};
+                xQueueSend(m_jobs, &job, portMAX_DELAY);
+                m_fill = -1;
+            }
+        }
+    }
+
+    static void buildHeader(AviHeader &header, const AviSegment *seg)
+    {
+        memset(&header, 0, sizeof(header));
+        uint32_t moviSize = seg->length - AVI_MOVI_FOURCC_OFFSET;
+
+        header.riff = AVI_FOURCC('R', 'I', 'F', 'F');
+        header.avi = AVI_FOURCC('A', 'V', 'I', ' ');
+
+        header.hdrlList = AVI_FOURCC('L', 'I', 'S', 'T');
+        header.hdrlSize = offsetof(AviHeader, junk) - offsetof(AviHeader, hdrl);
+        header.hdrl = AVI_FOURCC('h', 'd', 'r', 'l');
+
+        header.avih = AVI_FOURCC('a', 'v', 'i', 'h');
+        header.avihSize = offsetof(AviHeader, strlList) - offsetof(AviHeader, usPerFrame);
+        header.usPerFrame = seg->usPerFrame;
+        uint64_t durationUs = (uint64_t)seg->usPerFrame * seg->frames;
+        header.maxBytesPerSec = (durationUs > 0) ? (uint32_t)((uint64_t)moviSize * 1000000 / durationUs) : 0;
+        header.flags = AVIF_HASINDEX;
+        header.totalFrames = seg->frames;
+        header.streams = 1;
+        header.suggestedBufferSize = seg->maxFrame + sizeof(AviChunkHeader);
+        header.width = seg->width;
+        header.height = seg->height;
+
+        header.strlList = AVI_FOURCC('L', 'I', 'S', 'T');
+        header.strlSize = offsetof(AviHeader, junk) - offsetof(AviHeader, strl);
+        header.strl = AVI_FOURCC('s', 't', 'r', 'l');
+
+        header.strh = AVI_FOURCC('s', 't', 'r', 'h');
+        header.strhSize = offsetof(AviHeader, strf) - offsetof(AviHeader, fccType);
+        header.fccType = AVI_FOURCC('v', 'i', 'd', 's');
+        header.fccHandler = AVI_FOURCC('M', 'J', 'P', 'G');
+        header.scale = seg->usPerFrame;
+        header.rate = 1000000;
+        header.length = seg->frames;
+        header.streamSuggestedBufferSize = header.suggestedBufferSize;
+        header.quality = UINT32_MAX;
+        header.frameRight = seg->width;
+        header.frameBottom = seg->height;
+
+        header.strf = AVI_FOURCC('s', 't', 'r', 'f');
+        header.strfSize = offsetof(AviHeader, junk) - offsetof(AviHeader, biSize);
+        header.biSize = header.strfSize;
+        header.biWidth = seg->width;
+        header.biHeight = seg->height;
+        header.biPlanes = 1;
+        header.biBitCount = 24;
+        header.biCompression = AVI_FOURCC('M', 'J', 'P', 'G');
+        header.biSizeImage = (uint32_t)seg->width * seg->height * 3;
+
+        header.junk = AVI_FOURCC('J', 'U', 'N', 'K');
+        header.junkSize = sizeof(header.junkData);
+
+        header.moviList = AVI_FOURCC('L', 'I', 'S', 'T');
+        header.moviSize = moviSize;
+        header.movi = AVI_FOURCC('m', 'o', 'v', 'i');
+    }
+
+    // appends idx1 and rewrites the header, the RIFF size last so a reset before it is
+    // recovered next boot
+    bool finishSegment(AviSegment *seg)
+    {
+        if (seg->frames > 1 && seg->lastMs != seg->firstMs)
+            seg->usPerFrame = (uint32_t)((uint64_t)(seg->lastMs - seg->firstMs) * 1000 / (seg->frames - 1));
+
+        AviChunkHeader idx1 = {AVI_FOURCC('i', 'd', 'x', '1'), seg->frames * (uint32_t)sizeof(AviIndexEntry)};
+        AviHeader header;
+        buildHeader(header, seg);
+        uint32_t riffSize = seg->length + sizeof(idx1) + idx1.size - 8;
+
+        bool ok = seg->file.seek(seg->length) &&
+                  (seg->file.write((const uint8_t *)&idx1, sizeof(idx1)) == sizeof(idx1)) &&
+                  (seg->file.write((const uint8_t *)seg->index, idx1.size) == idx1.size) &&
+                  seg->file.seek(0) &&
+                  (seg->file.write((const uint8_t *)&header, sizeof(header)) == sizeof(header));
+        seg->file.flush();
+        ok = ok && seg->file.seek(offsetof(AviHeader, riffSize)) &&
+             (seg->file.write((const uint8_t *)&riffSize, sizeof(riffSize)) == sizeof(riffSize));
+        seg->file.flush();
+
+        if (!ok)
+            Log.errorln("AVI: cannot write the index of segment %u", seg->number);
+        return ok;
+    }
+
+    void deleteOldSegments(uint32_t newest)
+    {
+        if (m_keepSegments == 0)
+            return;
+        while (newest - m_oldestNumber + 1 > m_keepSegments)
+        {
+            String path = segmentPath(m_oldestNumber++);
+            if (m_fs->exists(path))
+                m_fs->remove(path);
+        }
+    }
+
+    static void writerTask(void *pvParameters)
+    {
+        ((AviRecorder *)pvParameters)->writerLoop();
+    }
+
+    void writerLoop()
+    {
+        AviWriteJob job;
+        while (true)
+        {
+            taskWatchdogFeed();
+            if (xQueueReceive(m_jobs, &job, TASK_IDLE_WAIT) != pdTRUE)
+                continue;
+            AviSegment *seg = job.segment;
+
+            if (job.buffer >= 0)
+            {
+                if (!seg->file && !seg->failed)
+                {
+                    seg->file = m_fs->open(segmentPath(seg->number), FILE_WRITE);
+                    if (!seg->file)
+                    {
+                        Log.errorln("AVI: cannot create segment %u", seg->number);
+                        seg->failed = true;
+                    }
+                }
+                if (!seg->failed)
+                {
+                    uint32_t startUs = micros();
+                    size_t written = seg->file.write(m_staging[job.buffer], job.len);
+                    aviBlockWriteTime.observe(micros() - startUs);
+                    if (written != job.len)
+                    {
+                        aviWriteErrors.add();
+                        seg->failed = true;
+                        Log.errorln("AVI: write to segment %u failed", seg->number);
+                    }
+                }
+                xQueueSend(m_freeBlocks, &job.buffer, portMAX_DELAY);
+            }
+
+            if (job.close)
+            {
+                if (seg->file && !seg->failed && finishSegment(seg))
+                    aviSegmentsClosed.add();
+                seg->file.close();
+                deleteOldSegments(seg->number);
+                xSemaphoreGive(m_freeSegments);
+            }
+        }
+    }
+
+    fs::FS *m_fs;
+    bool m_ready;
+    uint8_t *m_staging[2];
+    AviSegment m_segments[2];
+    QueueHandle_t m_jobs;
+    QueueHandle_t m_freeBlocks;
+    SemaphoreHandle_t m_freeSegments;
+    TaskHandle_t m_writerTask;
+
+    // recording task side
+    AviSegment *m_current;
+    int m_nextSlot;
+    int m_fill; // staging block being filled, -1 for none
+    uint32_t m_fillLen;
+    uint32_t m_lastNumber;
+    uint32_t m_lastFrameMs;
+    uint32_t m_frameUs; // running estimate of the frame period
+
+    // writer task side
+    uint32_t m_oldestNumber;
+
+    const char *m_dir;
+    uint32_t m_indexCapacity;
+    uint32_t m_keepSegments;
+};
+
+#endif // AVI_RECORDER_H
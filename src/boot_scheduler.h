@@ -0,0 +1,196 @@
+////////////////////////////////////////////////////////////////////
+/// @file boot_scheduler.h
+/// @brief Runs the boot stages concurrently, in dependency order, and
+/// times them
+////////////////////////////////////////////////////////////////////
+
+#ifndef BOOT_SCHEDULER_H
+#define BOOT_SCHEDULER_H
+
+#include <Arduino.h>
+#include <ArduinoLog.h>
+#include <Metrics.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+// framework_setup() adds a stage for every subsystem, naming the stages it needs first, and
+// run() starts each one in a task of its own as soon as those are done, so stages that do not
+// depend on each other (camera, SD card, Wi-Fi association) overlap on both cores. run()
+// returns when every stage is done, apart from background ones, which only log and may finish
+// later; nothing may depend on a background stage.
+//
+// Every stage's start and duration are logged when the boot is done and kept as the gauges
+// boot_<stage>_ms. boot_setup_ms is the time from power on to the end of run(), and
+// boot_mqtt_connect_ms the time to the first MQTT connection, after which frames can go out.
+//
+// With BOOT_PARALLEL 0 the stages run one after the other on the calling task, in the order
+// they were added, which helps when two stages are suspected of getting in each other's way.
+
+#ifndef BOOT_PARALLEL
+#define BOOT_PARALLEL 1
+#endif
+
+#ifndef BOOT_MAX_STAGES
+#define BOOT_MAX_STAGES 16
+#endif
+
+static_assert(BOOT_MAX_STAGES < 32, "stages are bits of a uint32_t");
+
+#ifndef BOOT_STAGE_STACK_SIZE
+#define BOOT_STAGE_STACK_SIZE 6144
+#endif
+
+#ifndef BOOT_STAGE_PRIORITY
+#define BOOT_STAGE_PRIORITY 2 // above the loop task, which waits for them
+#endif
+
+typedef void (*BootStageFn)();
+
+MetricGauge bootSetupTime("boot_setup_ms", "Milliseconds from power on to the end of the boot stages");
+MetricGauge bootMqttConnectTime("boot_mqtt_connect_ms", "Milliseconds from power on to the first MQTT connection");
+
+portMUX_TYPE bootSchedulerMux = portMUX_INITIALIZER_UNLOCKED;
+
+class BootScheduler
+{
+public:
+    BootScheduler() : m_count(0), m_background(0), m_finished(0), m_done(NULL) {}
+
+    // the mask of stages to wait for; an id of -1 (a stage that was not added) is no wait
+    static uint32_t after(int id) { return id < 0 ? 0 : (1UL << id); }
+
+    // Returns the stage's id for after(), or -1 when there is no room. core is where its task
+    // runs; stages added later may only depend on stages added before them.
+    int add(const char *name, BootStageFn fn, uint32_t dependsOn = 0, BaseType_t core = tskNO_AFFINITY,
+            bool background = false, uint32_t stackSize = BOOT_STAGE_STACK_SIZE)
+    {
+        if (m_count == BOOT_MAX_STAGES || (dependsOn >> m_count) != 0 || (dependsOn & m_background) != 0)
+        {
+            Log.errorln("Boot: cannot add stage %s", name);
+            return -1;
+        }
+
+        Stage &stage = m_stages[m_count];
+        stage.name = name;
+        stage.fn = fn;
+        stage.dependsOn = dependsOn;
+        stage.core = core;
+        stage.stackSize = stackSize;
+        stage.startMs = 0;
+        stage.durationMs = 0;
+        stage.owner = this;
+        if (background)
+            m_background |= after(m_count);
+        return m_count++;
+    }
+
+    // from setup(), returns when all but the background stages are done
+    void run()
+    {
+        uint32_t all = (1UL << m_count) - 1;
+        uint32_t waitFor = all & ~m_background;
+        uint32_t started = 0;
+
+#if BOOT_PARALLEL
+        m_done = xSemaphoreCreateCounting(BOOT_MAX_STAGES, 0);
+        if (m_done == NULL)
+            Log.errorln("Boot: no semaphore, running the stages one by one");
+#endif
+
+        while (true)
+        {
+            int launched = 0;
+            for (int i = 0; i < m_count; i++)
+            {
+                if ((started & after(i)) || (m_stages[i].dependsOn & ~m_finished))
+                    continue;
+                started |= after(i);
+                launched++;
+                launch(m_stages[i]);
+            }
+
+            // background stages only depend on the others, so once those are done every stage
+            // has been started
+            if (((m_finished & waitFor) == waitFor) && (started == all))
+                break;
+            if (m_done != NULL)
+                xSemaphoreTake(m_done, portMAX_DELAY); // one stage finished
+            else if (launched == 0)
+                break; // not reached, add() only allows dependencies on earlier stages
+        }
+
+        bootSetupTime.set(millis());
+        for (int i = 0; i < m_count; i++)
+        {
+            Stage &stage = m_stages[i];
+            if (m_background & after(i))
+                continue;
+            Log.infoln("Boot: %s started at %u ms, took %u ms", stage.name, stage.startMs, stage.durationMs);
+
+            // created here rather than by the stage tasks, metrics register in a list without a lock
+            snprintf(stage.metricName, sizeof(stage.metricName), "boot_%s_ms", stage.name);
+            MetricGauge *gauge = new MetricGauge(stage.metricName, "Milliseconds a boot stage took");
+            gauge->set(stage.durationMs);
+        }
+        Log.infoln("Boot: stages done at %u ms", millis());
+    }
+
+private:
+    struct Stage
+    {
+        const char *name;
+        BootStageFn fn;
+        uint32_t dependsOn;
+        BaseType_t core;
+        uint32_t stackSize;
+        uint32_t startMs;
+        uint32_t durationMs;
+        char metricName[32];
+        BootScheduler *owner;
+    };
+
+    void launch(Stage &stage)
+    {
+        if (m_done != NULL)
+        {
+            TaskHandle_t task = NULL;
+            xTaskCreatePinnedToCore(stageTask, stage.name, stage.stackSize, &stage, BOOT_STAGE_PRIORITY, &task,
+                                    stage.core);
+            if (task != NULL)
+                return;
+            Log.errorln("Boot: create %s task failed, running it here", stage.name);
+        }
+        runStage(stage);
+    }
+
+    static void stageTask(void *pvParameters)
+    {
+        Stage &stage = *(Stage *)pvParameters;
+        stage.owner->runStage(stage);
+        vTaskDelete(NULL);
+    }
+
+    void runStage(Stage &stage)
+    {
+        stage.startMs = millis();
+        stage.fn();
+        stage.durationMs = millis() - stage.startMs;
+
+        portENTER_CRITICAL(&bootSchedulerMux);
+        m_finished |= after(&stage - m_stages);
+        portEXIT_CRITICAL(&bootSchedulerMux);
+        if (m_done != NULL)
+            xSemaphoreGive(m_done);
+    }
+
+    Stage m_stages[BOOT_MAX_STAGES];
+    int m_count;
+    uint32_t m_background;
+    volatile uint32_t m_finished;
+    SemaphoreHandle_t m_done; // given by every stage that finishes
+};
+
+BootScheduler bootScheduler;
+
+#endif // BOOT_SCHEDULER_H
@@ -7,10 +7,14 @@
 #define BUILD_OPTIONS_H
 
 #define USE_DEEP_SLEEP
+//#define USE_FAST_WAKE // needs USE_DEEP_SLEEP
 #define USE_ESP32_CAM
 //#define USE_GRAPHICS
 //#define USE_OPEN_FONT_RENDERER
 #define USE_SD_CARD
+//#define USE_AVI_RECORDER // needs USE_ESP32_CAM and USE_SD_CARD
+//#define USE_EVENT_CLIPS  // needs USE_ESP32_CAM, clips go to the SD card or over MQTT
+//#define USE_MOTION_DETECTION // needs USE_ESP32_CAM, uses the SD card and event clips when enabled
 //#define USE_AUDIO
 //#define USE_JPEG_DECODER
 //#define USE_PNG_DECODER
@@ -0,0 +1,304 @@
+////////////////////////////////////////////////////////////////////
+/// @file event_clips.h
+/// @brief Event-triggered clips that include the seconds before the
+/// trigger, from a ring of recent frames kept in PSRAM
+////////////////////////////////////////////////////////////////////
+
+#ifndef EVENT_CLIPS_H
+#define EVENT_CLIPS_H
+
+#include "framework.h"
+#include "avi_recorder.h"
+
+#include <FrameRing.h>
+
+// The capture task offers every frame; EVENT_RING_FPS of them a second are copied into a
+// FrameRing, which keeps EVENT_PRE_SECONDS of them within EVENT_RING_BYTES of PSRAM. Adding a
+// frame never waits: when the ring is full the oldest frames go, so under memory pressure the
+// pre-event part gets shorter rather than capture slowing down. When the buffer cannot be had
+// at all, a smaller one is tried, down to EVENT_RING_MIN_BYTES.
+//
+// trigger() can be called from any task (MQTT command, GPIO, motion). The clip task then
+// reads the ring from EVENT_PRE_SECONDS before the trigger until EVENT_POST_SECONDS after the
+// last trigger, at most EVENT_MAX_CLIP_SECONDS, and writes the frames as one AVI file into
+// EVENT_CLIP_DIR, or hands them to the publish callback when there is no SD card. If it falls
+// behind, frames the ring has already dropped are skipped and counted.
+
+#ifndef EVENT_PRE_SECONDS
+#define EVENT_PRE_SECONDS 5
+#endif
+
+#ifndef EVENT_POST_SECONDS
+#define EVENT_POST_SECONDS 10
+#endif
+
+#ifndef EVENT_MAX_CLIP_SECONDS
+#define EVENT_MAX_CLIP_SECONDS 60 // retriggers keep a clip going at most this long
+#endif
+
+#ifndef EVENT_RING_FPS
+#define EVENT_RING_FPS 5
+#endif
+
+#ifndef EVENT_RING_BYTES
+#define EVENT_RING_BYTES (1536UL * 1024) // the memory cap wins over EVENT_PRE_SECONDS
+#endif
+
+#ifndef EVENT_RING_MIN_BYTES
+#define EVENT_RING_MIN_BYTES (256UL * 1024)
+#endif
+
+#ifndef EVENT_RING_FRAMES
+#define EVENT_RING_FRAMES 64 // descriptors, at least (EVENT_PRE_SECONDS + 1) * EVENT_RING_FPS
+#endif
+
+#ifndef EVENT_CLIP_DIR
+#define EVENT_CLIP_DIR "/clips"
+#endif
+
+#ifndef EVENT_KEEP_CLIPS
+#define EVENT_KEEP_CLIPS 100
+#endif
+
+#ifndef EVENT_CLIP_FINISH_MS
+#define EVENT_CLIP_FINISH_MS 2000 // how long closing a clip file may take
+#endif
+
+#ifndef EVENT_CLIP_STACK_SIZE
+#define EVENT_CLIP_STACK_SIZE 4096
+#endif
+
+#ifndef EVENT_CLIP_PRIORITY
+#define EVENT_CLIP_PRIORITY TASK_PRIORITY_STORAGE
+#endif
+
+#ifndef EVENT_CLIP_CORE
+#define EVENT_CLIP_CORE TASK_CORE_CAPTURE
+#endif
+
+static_assert(EVENT_RING_FRAMES >= (EVENT_PRE_SECONDS + 1) * EVENT_RING_FPS,
+              "EVENT_RING_FRAMES cannot describe EVENT_PRE_SECONDS of frames");
+
+// sends one clip frame elsewhere (e.g. over MQTT), frame is 0 for the first frame of a clip.
+// Called once more with data NULL and frame the number of frames when the clip is over.
+typedef bool (*EventClipPublishFn)(uint32_t clip, uint32_t frame, const uint8_t *data, size_t len,
+                                   uint32_t timeMs);
+
+MetricCounter eventClipsStarted("event_clips_started_total", "Event clips triggered");
+MetricCounter eventClipFrames("event_clip_frames_total", "Frames written or published as part of event clips");
+MetricCounter eventClipFramesLost("event_clip_frames_lost_total", "Clip frames the ring dropped before the clip task read them");
+
+class EventClips
+{
+public:
+    EventClips() : m_ringBuf(NULL), m_publish(NULL), m_task(NULL), m_lastPushMs(0), m_clip(0), m_coveredMs(0),
+                   m_triggerMs(0), m_triggerSource("none"), m_active(false), m_endNow(false) {}
+
+    // sd may be NULL, clips then only go to publish (which may be NULL too)
+    bool begin(fs::FS *sd, EventClipPublishFn publish)
+    {
+        m_publish = publish;
+
+        size_t len = EVENT_RING_BYTES;
+        while (len >= EVENT_RING_MIN_BYTES && (m_ringBuf = (uint8_t *)(psramFound() ? ps_malloc(len) : malloc(len))) == NULL)
+            len /= 2;
+        if (m_ringBuf == NULL)
+        {
+            Log.errorln("Event clips: no memory for the pre-event ring");
+            return false;
+        }
+        m_ring.begin(m_ringBuf, len, EVENT_PRE_SECONDS * 1000UL);
+
+        if (sd && !m_recorder.begin(*sd, EVENT_CLIP_DIR, (EVENT_PRE_SECONDS + EVENT_MAX_CLIP_SECONDS) * EVENT_RING_FPS + 16,
+                                    EVENT_KEEP_CLIPS))
+            Log.warningln("Event clips: cannot record to SD");
+
+        if (!startTask(clipTask, "eventClip", EVENT_CLIP_STACK_SIZE, this, EVENT_CLIP_PRIORITY, EVENT_CLIP_CORE,
+                       &m_task))
+            return false;
+
+        Log.infoln("Event clips: %u KB pre-event ring", len / 1024);
+        return true;
+    }
+
+    bool isReady() { return m_task != NULL; }
+
+    bool isActive() { return m_active; }
+
+    // from the capture task, for every frame; copies the ones the ring keeps, never waits
+    void addFrame(const uint8_t *data, size_t len, uint32_t timeMs)
+    {
+        if (m_task == NULL || (m_lastPushMs != 0 && timeMs - m_lastPushMs < 1000 / EVENT_RING_FPS))
+            return;
+        m_lastPushMs = timeMs;
+        m_ring.push(data, len, timeMs);
+    }
+
+    // starts a clip, or extends the running one
+    void trigger(const char *source)
+    {
+        if (m_task == NULL)
+            return;
+        m_triggerSource = source;
+        m_triggerMs = millis();
+        xTaskNotifyGive(m_task);
+    }
+
+    // cuts the running clip short and waits for it to be closed, e.g. before deep sleep
+    bool end(uint32_t timeoutMs)
+    {
+        if (!m_active)
+            return true;
+        m_endNow = true;
+        uint32_t start = millis();
+        while (m_active && millis() - start < timeoutMs)
+            delay(10);
+        return !m_active;
+    }
+
+private:
+    static void clipTask(void *pvParameters)
+    {
+        ((EventClips *)pvParameters)->clipLoop();
+    }
+
+    void clipLoop()
+    {
+        uint8_t *frame = NULL;
+        size_t frameCap = 0;
+
+        while (true)
+        {
+            taskWatchdogFeed();
+            if (ulTaskNotifyTake(pdTRUE, TASK_IDLE_WAIT) == 0)
+                continue;
+
+            // triggers that arrived during the last clip are still pending; they only start a
+            // clip if they want frames after the ones it covered, and never get those again
+            uint32_t startMs = m_triggerMs;
+            uint32_t fromMs = startMs - EVENT_PRE_SECONDS * 1000UL;
+            if (m_clip > 0)
+            {
+                if ((int32_t)(startMs + EVENT_POST_SECONDS * 1000UL - m_coveredMs) <= 0)
+                    continue;
+                if ((int32_t)(fromMs - m_coveredMs) <= 0)
+                    fromMs = m_coveredMs + 1;
+            }
+            m_active = true;
+            m_endNow = false;
+
+            uint32_t clip = ++m_clip;
+            uint32_t seq = m_ring.seqAtOrAfter(fromMs);
+            uint32_t endMs = startMs;
+            uint32_t frames = 0;
+            uint32_t lost = 0;
+            eventClipsStarted.add();
+            Log.infoln("Event clip %u started by %s", clip, m_triggerSource);
+
+            while (!m_endNow)
+            {
+                taskWatchdogFeed();
+
+                // the last trigger decides when the clip ends, within the overall limit
+                endMs = m_triggerMs + EVENT_POST_SECONDS * 1000UL;
+                if ((int32_t)(endMs - (startMs + EVENT_MAX_CLIP_SECONDS * 1000UL)) > 0)
+                    endMs = startMs + EVENT_MAX_CLIP_SECONDS * 1000UL;
+
+                if (seq == m_ring.nextSeq())
+                {
+                    if ((int32_t)(millis() - endMs) >= 0)
+                        break;
+                    delay(1000 / EVENT_RING_FPS / 2);
+                    continue;
+                }
+
+                FrameRingInfo info;
+                if (!m_ring.info(seq, info))
+                {
+                    // fell behind, resume at the oldest frame still held
+                    uint32_t oldest = m_ring.oldestSeq();
+                    lost += oldest - seq;
+                    eventClipFramesLost.add(oldest - seq);
+                    seq = oldest;
+                    continue;
+                }
+                if ((int32_t)(info.timeMs - endMs) > 0)
+                    break;
+
+                if (info.len > frameCap)
+                {
+                    free(frame);
+                    frameCap = info.len + info.len / 4;
+                    frame = (uint8_t *)(psramFound() ? ps_malloc(frameCap) : malloc(frameCap));
+                    if (frame == NULL)
+                    {
+                        frameCap = 0;
+                        Log.errorln("Event clip %u: no memory for a %u byte frame", clip, info.len);
+                        break;
+                    }
+                }
+
+                if (!m_ring.copy(seq, frame, frameCap, info))
+                    continue; // retired while copying, the info() above sorts it out
+
+                if (m_recorder.isReady())
+                    m_recorder.addFrame(frame, info.len, jpegWidth(frame, info.len), jpegHeight(frame, info.len), info.timeMs);
+                else if (m_publish)
+                    m_publish(clip, frames, frame, info.len, info.timeMs);
+                frames++;
+                eventClipFrames.add();
+                seq++;
+            }
+
+            m_coveredMs = endMs;
+            if (m_recorder.isReady())
+                m_recorder.finish(EVENT_CLIP_FINISH_MS);
+            else if (m_publish)
+                m_publish(clip, frames, NULL, 0, millis());
+            Log.infoln("Event clip %u: %u frames, %u lost", clip, frames, lost);
+
+            // a small clip buffer is kept, the first frames of the next clip need it again
+            if (frameCap > EVENT_RING_BYTES / 4)
+            {
+                free(frame);
+                frame = NULL;
+                frameCap = 0;
+            }
+            m_active = false;
+        }
+    }
+
+    // frame size from the JPEG SOF0 marker; AVI wants it, the ring does not keep it
+    static uint16_t jpegWidth(const uint8_t *jpeg, size_t len) { return jpegDimension(jpeg, len, 7); }
+    static uint16_t jpegHeight(const uint8_t *jpeg, size_t len) { return jpegDimension(jpeg, len, 5); }
+
+    static uint16_t jpegDimension(const uint8_t *jpeg, size_t len, size_t offset)
+    {
+        size_t i = 2;
+        while (i + 9 < len)
+        {
+            if (jpeg[i] != 0xFF)
+                return 0;
+            uint8_t marker = jpeg[i + 1];
+            if (marker == 0xC0 || marker == 0xC1 || marker == 0xC2)
+                return (jpeg[i + offset] << 8) | jpeg[i + offset + 1];
+            i += 2 + ((jpeg[i + 2] << 8) | jpeg[i + 3]);
+        }
+        return 0;
+    }
+
+    FrameRing<EVENT_RING_FRAMES> m_ring;
+    uint8_t *m_ringBuf;
+    AviRecorder m_recorder;
+    EventClipPublishFn m_publish;
+    TaskHandle_t m_task;
+    uint32_t m_lastPushMs; // capture task only
+    uint32_t m_clip;
+    uint32_t m_coveredMs; // clip task only, end of the time the last clip covered
+    volatile uint32_t m_triggerMs;
+    const char *volatile m_triggerSource;
+    volatile bool m_active;
+    volatile bool m_endNow;
+};
+
+#endif // EVENT_CLIPS_H
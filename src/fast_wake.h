@@ -0,0 +1,163 @@
+////////////////////////////////////////////////////////////////////
+/// @file fast_wake.h
+/// @brief Shorter boots after deep sleep, from Wi-Fi details kept in
+/// RTC memory
+////////////////////////////////////////////////////////////////////
+
+#ifndef FAST_WAKE_H
+#define FAST_WAKE_H
+
+#include <Arduino.h>
+#include <ArduinoLog.h>
+#include <WiFi.h>
+#include <stddef.h>
+#include <time.h>
+
+// A wake from deep sleep is a fast wake: the framework leaves out what only matters on a cold
+// boot (chip info, SD card listings) and the app sends a frame, taken while Wi-Fi associates,
+// before it goes back to sleep. A device that only ever wakes from deep sleep still has to find
+// firmware updates, so a fast wake also checks for one once FAST_WAKE_UPDATE_CHECK_WAKES wakes
+// or FAST_WAKE_UPDATE_CHECK_S seconds have gone by without a check; the count and the time of
+// the last check are kept in RTC memory too.
+//
+// Every connection made through a scan and DHCP leaves the access point's BSSID and channel and
+// the address it handed out in FastWakeCache, which lives in RTC memory and so survives deep
+// sleep (not a power cycle). The next wake joins that access point directly, without scanning,
+// and configures the address statically, without DHCP. Once the details are FAST_WAKE_LEASE_S
+// old, a wake does a full connection again, which renews the lease before it runs out. If a
+// connection from the cache fails, the cache is dropped and the next attempt does a full one.
+
+#ifndef FAST_WAKE_LEASE_S
+#define FAST_WAKE_LEASE_S 1800 // should be well inside the DHCP server's lease time
+#endif
+
+#ifndef FAST_WAKE_UPDATE_CHECK_WAKES
+#define FAST_WAKE_UPDATE_CHECK_WAKES 24
+#endif
+
+#ifndef FAST_WAKE_UPDATE_CHECK_S
+#define FAST_WAKE_UPDATE_CHECK_S 86400
+#endif
+
+#define FAST_WAKE_MAGIC 0x46574B31 // "FWK1", change it when FastWakeCache changes
+
+struct FastWakeCache
+{
+    uint32_t magic;
+    uint8_t bssid[6];
+    int32_t channel;
+    uint32_t ip;
+    uint32_t gateway;
+    uint32_t subnet;
+    uint32_t dns;
+    uint32_t savedAt; // time(), the RTC keeps counting through deep sleep
+    uint32_t checksum;
+};
+
+struct FastWakeUpdateCheck
+{
+    uint32_t magic;
+    uint32_t wakes;     // fast wakes since the last firmware check
+    uint32_t checkedAt; // time() of the last firmware check
+};
+
+RTC_DATA_ATTR FastWakeCache fastWakeCache;
+RTC_DATA_ATTR FastWakeUpdateCheck fastWakeUpdateCheck;
+bool fastWakeConnecting = false; // joining from the cache, no scan or DHCP
+
+uint32_t fastWakeChecksum(const FastWakeCache &cache)
+{
+    // FNV-1a over everything but the checksum
+    const uint8_t *p = (const uint8_t *)&cache;
+    uint32_t hash = 2166136261UL;
+    for (size_t i = 0; i < offsetof(FastWakeCache, checksum); i++)
+        hash = (hash ^ p[i]) * 16777619UL;
+    return hash;
+}
+
+bool fastWakeCacheValid()
+{
+    return (fastWakeCache.magic == FAST_WAKE_MAGIC) && (fastWakeCache.checksum == fastWakeChecksum(fastWakeCache)) &&
+           ((uint32_t)time(NULL) - fastWakeCache.savedAt < FAST_WAKE_LEASE_S);
+}
+
+// true for wakes from deep sleep, which are counted for fastWakeUpdateDue(); the cache is only
+// used by fastWakeConnect()
+bool fastWakeBegin(esp_sleep_wakeup_cause_t cause)
+{
+    bool wake = (cause == ESP_SLEEP_WAKEUP_EXT0) || (cause == ESP_SLEEP_WAKEUP_EXT1) || (cause == ESP_SLEEP_WAKEUP_TIMER);
+    if (fastWakeUpdateCheck.magic != FAST_WAKE_MAGIC)
+    {
+        // RTC memory lost its contents: the next wake checks
+        fastWakeUpdateCheck.magic = FAST_WAKE_MAGIC;
+        fastWakeUpdateCheck.wakes = FAST_WAKE_UPDATE_CHECK_WAKES;
+        fastWakeUpdateCheck.checkedAt = time(NULL);
+    }
+    else if (wake)
+        fastWakeUpdateCheck.wakes++;
+    return wake;
+}
+
+// whether a fast wake should look for a firmware update this time
+bool fastWakeUpdateDue()
+{
+    return (fastWakeUpdateCheck.wakes >= FAST_WAKE_UPDATE_CHECK_WAKES) ||
+           ((uint32_t)time(NULL) - fastWakeUpdateCheck.checkedAt >= FAST_WAKE_UPDATE_CHECK_S);
+}
+
+void fastWakeUpdateChecked()
+{
+    fastWakeUpdateCheck.wakes = 0;
+    fastWakeUpdateCheck.checkedAt = time(NULL);
+}
+
+// starts joining from the cache, false if there is nothing usable in it
+bool fastWakeConnect(const char *ssid, const char *password)
+{
+    if (!fastWakeCacheValid())
+        return false;
+
+    Log.infoln("Connecting to cached access point on channel %d...", fastWakeCache.channel);
+    fastWakeConnecting = true;
+    WiFi.config(IPAddress(fastWakeCache.ip), IPAddress(fastWakeCache.gateway), IPAddress(fastWakeCache.subnet),
+                IPAddress(fastWakeCache.dns));
+    WiFi.begin(ssid, password, fastWakeCache.channel, fastWakeCache.bssid);
+    return true;
+}
+
+// on GOT_IP: a full connection refreshes the cache
+void fastWakeConnected()
+{
+    if (fastWakeConnecting)
+    {
+        fastWakeConnecting = false; // it worked, the cache stays as it is
+        return;
+    }
+
+    uint8_t *bssid = WiFi.BSSID();
+    if (bssid == NULL)
+        return;
+    memcpy(fastWakeCache.bssid, bssid, sizeof(fastWakeCache.bssid));
+    fastWakeCache.channel = WiFi.channel();
+    fastWakeCache.ip = WiFi.localIP();
+    fastWakeCache.gateway = WiFi.gatewayIP();
+    fastWakeCache.subnet = WiFi.subnetMask();
+    fastWakeCache.dns = WiFi.dnsIP();
+    fastWakeCache.savedAt = time(NULL);
+    fastWakeCache.magic = FAST_WAKE_MAGIC;
+    fastWakeCache.checksum = fastWakeChecksum(fastWakeCache);
+}
+
+// on DISCONNECTED: a cached access point that could not be joined is not tried again
+void fastWakeDisconnected()
+{
+    if (!fastWakeConnecting)
+        return;
+
+    Log.warningln("Cached access point failed, doing a full connection");
+    fastWakeConnecting = false;
+    fastWakeCache.magic = 0;
+    WiFi.config(IPAddress(), IPAddress(), IPAddress()); // back to DHCP
+}
+
+#endif // FAST_WAKE_H
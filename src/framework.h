@@ -8,6 +8,7 @@
 
 #include <Arduino.h>
 #include <time.h>
+#include <atomic>
 
 extern "C"
 {
@@ -67,6 +68,8 @@ AsyncWebServer webServer(80);
 
 #include <AsyncMqttClient.h>
 #include <ArduinoJson.h>
+#include "mqtt_router.h"
+#include "mqtt_ingest.h"
 
 #include <ArduinoLog.h>
 
@@ -115,9 +118,12 @@ bool isGoodTime = false;
 
 // ********** Connectivity Parameters **********
 AsyncMqttClient mqttClient;
+MqttRouter mqttRouter;
+MqttIngest mqttIngest;
 
 int volume = 50; // Volume is %
 int bootCount = 0;
+bool fastWake = false; // woken from deep sleep with USE_FAST_WAKE, see fast_wake.h
 esp_sleep_wakeup_cause_t wakeup_reason;
 esp_reset_reason_t reset_reason;
 int maxOtherIndex = -1;
@@ -125,11 +131,27 @@ bool shouldReboot = false;
 Preferences preferences;
 bool mqttConnected = false;
 bool wifiConnected = false;
+// Wi-Fi may connect before setup() is done; what needs the app set up waits for whichever of
+// the two comes last, see onWifiConnect() and framework_start()
+std::atomic<bool> setupDone(false);
+std::atomic<bool> wifiConnectTasksDue(false);
 
 uint8_t macAddress[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
 
 // **************** Debug Parameters ************************
-String methodName = "";
+#include "task_topology.h"
+#include "trace.h"
+#include "log_ring.h"
+LogRing logRing;
+#include <Metrics.h>
+MetricGauge logRingDropped("log_ring_dropped_records", "Deferred log records dropped because the ring was full",
+                            []() { return (double)logRing.dropped(); });
+#include "memory_telemetry.h"
+#include "boot_scheduler.h"
+
+#ifdef USE_FAST_WAKE
+#include "fast_wake.h"
+#endif
 
 #pragma region Standard Helper Functions
 
@@ -163,18 +185,25 @@ bool isNumeric(char *str)
     return true;
 }
 
-// Make size of files human readable
+// Make size of files human readable into a caller supplied buffer (no heap use)
 // source: https://github.com/CelliesProjects/minimalUploadAuthESP32
-String humanReadableSize(const size_t bytes)
+int formatHumanReadableSize(char *buf, size_t bufLen, const size_t bytes)
 {
     if (bytes < 1024)
-        return String(bytes) + " B";
+        return snprintf(buf, bufLen, "%u B", (unsigned)bytes);
     else if (bytes < (1024 * 1024))
-        return String(bytes / 1024.0) + " KB";
+        return snprintf(buf, bufLen, "%.2f KB", bytes / 1024.0);
     else if (bytes < (1024 * 1024 * 1024))
-        return String(bytes / 1024.0 / 1024.0) + " MB";
+        return snprintf(buf, bufLen, "%.2f MB", bytes / 1024.0 / 1024.0);
     else
-        return String(bytes / 1024.0 / 1024.0 / 1024.0) + " GB";
+        return snprintf(buf, bufLen, "%.2f GB", bytes / 1024.0 / 1024.0 / 1024.0);
+}
+
+String humanReadableSize(const size_t bytes)
+{
+    char buf[16];
+    formatHumanReadableSize(buf, sizeof(buf), bytes);
+    return String(buf);
 }
 
 #pragma endregion
@@ -360,9 +389,7 @@ void printDirectory(File dir, int numTabs)
 
 void initSD()
 {
-    String oldMethodName = methodName;
-    methodName = "initSD()";
-    Log.verboseln("Entering...");
+    TRACE_SCOPE("initSD()");
 
 #ifdef USE_GRAPHICS1
     if (!SD.begin(SD_CS, tftspi))
@@ -390,6 +417,15 @@ void initSD()
 
     uint64_t cardSize = SD.cardSize() / (1024 * 1024);
     Log.infoln("SD Card Size: %l MB", cardSize);
+}
+
+// a background boot stage, the boot does not wait for the log to take the whole card
+void listSD()
+{
+    TRACE_SCOPE("listSD()");
+
+    if (fastWake || SD.cardType() == CARD_NONE)
+        return; // the listing was in the log of the cold boot
 
     File root = SD.open("/");
     if (!root)
@@ -401,9 +437,6 @@ void initSD()
         printDirectory(root, 0);
         root.close();
     }
-
-    Log.verboseln("Exiting...");
-    methodName = oldMethodName;
 }
 #endif
 
@@ -730,8 +763,7 @@ void drawArrayJpeg(const uint8_t arrayname[], uint32_t array_size, int xpos, int
 
 int webGet(String req, String &res)
 {
-    String oldMethodName = methodName;
-    methodName = "webGet(String req, String &res)";
+    TRACE_SCOPE("webGet(String req, String &res)");
 
     int result = -1;
 
@@ -780,8 +812,6 @@ int webGet(String req, String &res)
         Log.warningln("[HTTP] Unable to connect");
     }
 
-    Log.verboseln("Exiting...");
-    methodName = oldMethodName;
     return result;
 }
 #pragma endregion
@@ -799,6 +829,18 @@ int webGet(String req, String &res)
 /** Forward dedclaration of the task handling RTSP */
 void rtspTask(void *pvParameters);
 
+#ifndef RTSP_TASK_STACK_SIZE
+#define RTSP_TASK_STACK_SIZE 4096 // see stackFree on /memory.json before changing it
+#endif
+
+#ifndef RTSP_TASK_PRIORITY
+#define RTSP_TASK_PRIORITY TASK_PRIORITY_NETWORK
+#endif
+
+#ifndef RTSP_TASK_CORE
+#define RTSP_TASK_CORE TASK_CORE_NETWORK
+#endif
+
 /** Task handle of the RTSP task */
 TaskHandle_t rtspTaskHandler;
 
@@ -819,26 +861,11 @@ boolean stopRTSPtask = false;
  */
 void initRTSP(void)
 {
-    String oldMethodName = methodName;
-    methodName = "ProcessAppWifiDisconnectTasks()";
-    Log.verboseln("Entering...");
+    TRACE_SCOPE("initRTSP()");
 
     // Create the task for the RTSP server
-    xTaskCreate(rtspTask, "RTSP", 4096, NULL, 1, &rtspTaskHandler);
-
-    // Check the results
-    if (rtspTaskHandler == NULL)
-    {
-        Log.errorln("Create RTSP task failed");
-    }
-    else
-    {
+    if (startTask(rtspTask, "RTSP", RTSP_TASK_STACK_SIZE, NULL, RTSP_TASK_PRIORITY, RTSP_TASK_CORE, &rtspTaskHandler))
         Log.infoln("RTSP task up and running");
-    }
-    
-    Log.verboseln("Exiting...");
-    methodName = oldMethodName;
-
 }
 
 /**
@@ -859,9 +886,7 @@ void stopRTSP(void)
  */
 void rtspTask(void *pvParameters)
 {
-    String oldMethodName = methodName;
-    methodName = "ProcessAppWifiDisconnectTasks()";
-    Log.verboseln("Entering...");
+    TRACE_SCOPE("rtspTask()");
 
     uint32_t msecPerFrame = 50;
     static uint32_t lastimage = millis();
@@ -872,6 +897,8 @@ void rtspTask(void *pvParameters)
 
     while (1)
     {
+        taskWatchdogFeed();
+
         // If we have an active client connection, just service that until gone
         if (session)
         {
@@ -888,7 +915,7 @@ void rtspTask(void *pvParameters)
             // Handle disconnection from RTSP client
             if (session->m_stopped)
             {
-                Log.infoln("RTSP client closed connection");
+                logRing.infoln("RTSP client closed connection");
                 delete session;
                 delete streamer;
                 session = NULL;
@@ -901,7 +928,7 @@ void rtspTask(void *pvParameters)
             // Handle connection request from RTSP client
             if (rtspClient)
             {
-                Log.infoln("RTSP client started connection");
+                logRing.infoln("RTSP client started connection");
                 streamer = new OV2640Streamer(&rtspClient, cam); // our streamer for UDP/TCP based RTP transport
 
                 session = new CRtspSession(&rtspClient, streamer); // our threads RTSP session and state
@@ -913,20 +940,18 @@ void rtspTask(void *pvParameters)
             // User requested RTSP server stop
             if (rtspClient)
             {
-                Log.infoln("Shut down RTSP server requested.");
+                logRing.infoln("Shut down RTSP server requested.");
                 delete session;
                 delete streamer;
                 session = NULL;
                 streamer = NULL;
             }
             // Delete this task
+            taskWatchdogEnd();
             vTaskDelete(NULL);
         }
         delay(10);
     }
-    Log.verboseln("Exiting...");
-    methodName = oldMethodName;
-
 }
 
 #endif
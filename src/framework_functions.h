@@ -7,6 +7,7 @@
 #define FRAMEWORK_FUNCTIONS_H
 
 #include "framework.h"
+#include "ota_update.h"
 
 // For US Pacific Time Zone
 const char *localTZ = "PST8PDT,M3.2.0/2:00:00,M11.1.0/2:00:00";
@@ -21,6 +22,7 @@ TimerHandle_t mqttReconnectTimer;
 TimerHandle_t wifiReconnectTimer;
 TimerHandle_t appInstanceIDWaitTimer;
 TimerHandle_t wifiFailCountTimer;
+TimerHandle_t metricsPublishTimer;
 
 void logESPChipInfo();
 void logWakeupReason(esp_sleep_wakeup_cause_t wakeup_reason);
@@ -30,6 +32,7 @@ void logMACAddress(uint8_t baseMac[6]);
 void connectToWifi();
 void resetWifiFailCount(TimerHandle_t xTimer);
 void onWifiConnect(const WiFiEvent_t &event);
+void wifiConnectTasks();
 void onWifiDisconnect(const WiFiEvent_t &event);
 void WiFiEvent(WiFiEvent_t event);
 
@@ -37,16 +40,21 @@ void connectToMqtt();
 void mqttPublishWill();
 void mqttPublishID();
 bool checkMessageForAppSecret(JsonDocument &doc);
+void registerMqttRoutes();
 void onMqttMessage(char *topic, char *payload, AsyncMqttClientMessageProperties properties, size_t len, size_t index, size_t total);
 
+void publishMetrics(TimerHandle_t xTimer);
+void reportFirmwareProgress(const char *fileName, size_t done, size_t total);
 void doUpdateFirmware(char *fileName);
-int getlatestFirmware(char *fileName);
 void checkFWUpdate();
 
 void setAppInstanceID();
 
+void initPrefs();
+void initConnectivity();
 void framework_setup();
 void framework_loop();
+void framework_start();
 
 
 void logESPChipInfo()
@@ -140,35 +148,30 @@ void logResetReason(esp_reset_reason_t reset_reason)
 
 void connectToWifi()
 {
-    String oldMethodName = methodName;
-    methodName = "connectToWifi()";
+    TRACE_SCOPE("connectToWifi()");
+
+#ifdef USE_FAST_WAKE
+    if (fastWakeConnect(WIFI_SSID, WIFI_PASSWORD))
+        return;
+#endif
 
     Log.infoln("Connecting...");
     WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
-
-    methodName = oldMethodName;
 }
 
 void resetWifiFailCount(TimerHandle_t xTimer)
 {
-    String oldMethodName = methodName;
-    methodName = "resetWifiFailCount(TimerHandle_t xTimer)";
-    Log.verboseln("Entering...");
+    TRACE_SCOPE("resetWifiFailCount(TimerHandle_t xTimer)");
 
     (void)xTimer;
 
     wifiFailCount = 0;
     xTimerStop(xTimer, 0);
-
-    Log.verboseln("Exiting...");
-    methodName = oldMethodName;
 }
 
 void onWifiConnect(const WiFiEvent_t &event)
 {
-    String oldMethodName = methodName;
-    methodName = "onWifiConnect(const WiFiEventStationModeGotIP &event)";
-    Log.verboseln("Entering...");
+    TRACE_SCOPE("onWifiConnect(const WiFiEventStationModeGotIP &event)");
 
     (void)event;
 
@@ -182,30 +185,51 @@ void onWifiConnect(const WiFiEvent_t &event)
     else
         Log.errorln("Failed to connect to NTP Server!");
 
-    if (appInstanceID >= 0)
+#ifdef USE_FAST_WAKE
+    fastWakeConnected();
+#endif
+
+    // Association overlaps the boot, the rest needs setup() done. Whichever comes second
+    // takes the flag, so the tasks run once.
+    wifiConnectTasksDue = true;
+    if (setupDone && wifiConnectTasksDue.exchange(false))
+        wifiConnectTasks();
+}
+
+void wifiConnectTasks()
+{
+    TRACE_SCOPE("wifiConnectTasks()");
+
+    // a fast wake only sends what it came for, and looks for updates every so often
+    bool updateDue = !fastWake;
+#ifdef USE_FAST_WAKE
+    updateDue |= fastWakeUpdateDue();
+#endif
+    if (appInstanceID >= 0 && updateDue)
     {
         Log.infoln("Checking for FW updates...");
         checkFWUpdate();
+#ifdef USE_FAST_WAKE
+        fastWakeUpdateChecked();
+#endif
     }
 
     connectToMqtt();
 
     ProcessWifiConnectTasks();
-
-    Log.verboseln("Exiting...");
-    methodName = oldMethodName;
 }
 
 void onWifiDisconnect(const WiFiEvent_t &event)
 {
-    String oldMethodName = methodName;
-    methodName = "onWifiDisconnect(const WiFiEventStationModeDisconnected &event)";
-    Log.verboseln("Entering...");
+    TRACE_SCOPE("onWifiDisconnect(const WiFiEventStationModeDisconnected &event)");
 
     (void)event;
 
     wifiConnected = false;
     Log.infoln("Disconnected from Wi-Fi.");
+#ifdef USE_FAST_WAKE
+    fastWakeDisconnected();
+#endif
 
     ProcessWifiDisconnectTasks();
     Log.infoln("Disconnecting mqttReconnectTimer");
@@ -225,16 +249,11 @@ void onWifiDisconnect(const WiFiEvent_t &event)
     Log.infoln("Reconnecting to WiFi...");
     xTimerStart(wifiReconnectTimer, 0);
     // wifiReconnectTimer.once(2, connectToWifi);
-
-    Log.verboseln("Exiting...");
-    methodName = oldMethodName;
 }
 
 void WiFiEvent(WiFiEvent_t event)
 {
-    String oldMethodName = methodName;
-    methodName = "WiFiEvent(WiFiEvent_t event)";
-    Log.verboseln("Entering...");
+    TRACE_SCOPE("WiFiEvent(WiFiEvent_t event)");
 
     switch (event)
     {
@@ -254,27 +273,19 @@ void WiFiEvent(WiFiEvent_t event)
         onWifiDisconnect(event);
         break;
     }
-
-    Log.verboseln("Exiting...");
-    methodName = oldMethodName;
 }
 
 void connectToMqtt()
 {
-    String oldMethodName = methodName;
-    methodName = "connectToMqtt()";
+    TRACE_SCOPE("connectToMqtt()");
 
     Log.infoln("Connecting to MQTT broker...");
     mqttClient.connect();
-
-    methodName = oldMethodName;
 }
 
 void mqttPublishID()
 {
-    String oldMethodName = methodName;
-    methodName = "mqttPublishID()";
-    Log.verboseln("Entering...");
+    TRACE_SCOPE("mqttPublishID()");
 
     char onlineTopic[51];
     char payloadJson[100];
@@ -284,16 +295,11 @@ void mqttPublishID()
 
     Log.infoln("Published %s topic", onlineTopic);
     int pubRes = mqttClient.publish(onlineTopic, 1, false, payloadJson);
-
-    Log.verboseln("Exiting...");
-    methodName = oldMethodName;
 }
 
 void mqttPublishWill()
 {
-    String oldMethodName = methodName;
-    methodName = "mqttPublishID()";
-    Log.verboseln("Entering...");
+    TRACE_SCOPE("mqttPublishWill()");
 
     char onlineTopic[51];
     char payloadJson[100];
@@ -301,18 +307,15 @@ void mqttPublishWill()
     sprintf(payloadJson, "{ \"appInstanceID\" : \"%i\" , \"online\" : \"false\" }", appInstanceID);
     Log.infoln("Published Last Will and Testament %s", onlineTopic);
     mqttClient.publish(onlineTopic, 1, true, payloadJson);
-
-    Log.verboseln("Exiting...");
-    methodName = oldMethodName;
 }
 
 void onMqttConnect(bool sessionPresent)
 {
-    String oldMethodName = methodName;
-    methodName = "onMqttConnect(bool sessionPresent)";
-    Log.verboseln("Entering...");
+    TRACE_SCOPE("onMqttConnect(bool sessionPresent)");
 
     mqttConnected = true;
+    if (bootMqttConnectTime.value() == 0)
+        bootMqttConnectTime.set(millis());
     Log.infoln("Connected to MQTT broker: %p , port: %d", MQTT_HOST, MQTT_PORT);
     Log.infoln("Session present: %T", sessionPresent);
 
@@ -330,16 +333,11 @@ void onMqttConnect(bool sessionPresent)
     }
 
     ProcessMqttConnectTasks();
-
-    Log.verboseln("Exiting...");
-    methodName = oldMethodName;
 }
 
 void onMqttDisconnect(AsyncMqttClientDisconnectReason reason)
 {
-    String oldMethodName = methodName;
-    methodName = "onMqttDisconnect(AsyncMqttClientDisconnectReason reason)";
-    Log.verboseln("Entering...");
+    TRACE_SCOPE("onMqttDisconnect(AsyncMqttClientDisconnectReason reason)");
 
     (void)reason;
 
@@ -352,76 +350,45 @@ void onMqttDisconnect(AsyncMqttClientDisconnectReason reason)
     {
         xTimerStart(mqttReconnectTimer, 0);
     }
-
-    Log.verboseln("Exiting...");
-    methodName = oldMethodName;
 }
 
-void logMQTTMessage(char *topic, int len, char *payload)
+void logMQTTMessage(const MqttMessage &msg)
 {
-    char msg[len + 1];
-    memcpy(msg, payload, len);
-    msg[len] = 0;
-
-    Log.verboseln("[%s] %s", topic, msg);
+#if LOG_LEVEL >= LOG_LEVEL_VERBOSE
+    // only the start of long payloads, the stack copy has a fixed size
+    char text[128];
+    size_t n = minimum(msg.len, sizeof(text) - 1);
+    memcpy(text, msg.payload, n);
+    text[n] = 0;
+
+    Log.verboseln("[%s] %s%s", msg.topic, text, (n < msg.len) ? "..." : "");
+#endif
 }
 
-void onMqttIDMessage(char *topic, char *payload, AsyncMqttClientMessageProperties properties, size_t len, size_t index, size_t total)
+// <appName>/online while we are still picking an appInstanceID: remember the highest one in use
+void onMqttInstanceAnnouncement(const MqttMessage &msg)
 {
-    String oldMethodName = methodName;
-    methodName = "onMqttIDMessage()";
-    Log.verboseln("Entering...");
+    TRACE_SCOPE("onMqttInstanceAnnouncement()");
 
-    logMQTTMessage(topic, len, payload);
+    logMQTTMessage(msg);
 
-    char topics[10][25];
-    int topicCounter = 0;
-    char *token = strtok(topic, "/");
-    Log.verboseln("Tokenizing...");
-
-    while (token != NULL)
+    JsonDocument *doc = mqttIngest.parse(msg);
+    if (doc)
     {
-        Log.verboseln("Tokenized another topic... %s", topics[topicCounter - 1]);
-        strcpy(topics[topicCounter++], token);
-        token = strtok(NULL, "/");
-    }
-
-    Log.verboseln("Tokenize complete!!");
-
-    if (strcmp(topic, appName) == 0) // Handle all wichime messages
-    {
-        if ((strstr(topic, "offline") != NULL) || (strstr(topic, "online") != NULL))
+        // published as a string by mqttPublishID(), accept a number too
+        JsonVariant id = (*doc)["appInstanceID"];
+        int otherIndex = -1;
+        if (id.is<int>())
+            otherIndex = id;
+        else if (id.is<const char *>())
+            otherIndex = atoi(id);
+
+        if (otherIndex >= 0)
         {
-            int otherIndex = -1;
-            // TODO: Load into JsonDocument to extract appInstanceID
-            char msg[len + 1];
-            memcpy(msg, payload, len);
-            msg[len] = 0;
-
-            JsonDocument doc;
-            DeserializationError error = deserializeJson(doc, msg);
-
-            // Test if parsing succeeds.
-            if (!error)
-            {
-                if (doc["appInstanceID"].is<int>())
-                {
-                    otherIndex = doc["appInstanceID"];
-                    Log.infoln("Got appInstanceID: %d", otherIndex);
-                }
-            }
-            else
-            {
-                Log.errorln("deserializeJson() failed: %s", error.c_str());
-            }
-
-            if (otherIndex >= 0)
-                maxOtherIndex = max(maxOtherIndex, otherIndex);
+            Log.infoln("Got appInstanceID: %d", otherIndex);
+            maxOtherIndex = max(maxOtherIndex, otherIndex);
         }
     }
-
-    Log.verboseln("Exiting...");
-    methodName = oldMethodName;
 }
 
 bool checkMessageForAppSecret(JsonDocument &doc)
@@ -440,232 +407,178 @@ bool checkMessageForAppSecret(JsonDocument &doc)
     return false;
 }
 
-void onMqttMessage(char *topic, char *payload, AsyncMqttClientMessageProperties properties, size_t len, size_t index, size_t total)
+// <appName>/<our appInstanceID or -1>/... : a command for this instance
+void onMqttAppCommand(const MqttMessage &msg)
 {
-    String oldMethodName = methodName;
-    methodName = "onMqttMessage()";
-    Log.verboseln("Entering...");
-
-    logMQTTMessage(topic, len, payload);
-
-    char topics[10][25];
-    int topicCounter = 0;
-    char *token = strtok(topic, "/");
+    TRACE_SCOPE("onMqttAppCommand()");
 
-    while ((token != NULL) && (topicCounter < 11))
-    {
-        strcpy(topics[topicCounter++], token);
-        token = strtok(NULL, "/");
-    }
+    logMQTTMessage(msg);
 
-    if (topicCounter > 10)
+    JsonDocument *doc = mqttIngest.parse(msg);
+    if (doc)
     {
-        Log.noticeln("MQTT Topic has > 10 levels.");
-
-        Log.verboseln("Exiting...");
-        methodName = oldMethodName;
-        return;
+        if (checkMessageForAppSecret(*doc))
+            appMessageHandler(msg, *doc);
+        else
+            Log.errorln("AppSecret not found in message!");
     }
+}
 
-    Log.verboseln("Processing MQTT message...");
-    if ((strcmp(topic, appName) == 0) && (topicCounter > 1))
-    {
-        // Handle all messages for our App (AppName is in topic #1)
-        Log.infoln("Got our topic");
+// Builds the framework's routes. Commands addressed to other instances, our own responses and
+// images all share the <appName>/# subscription but match no route, so they cost one trie
+// walk and are never parsed.
+void registerMqttRoutes()
+{
+    TRACE_SCOPE("registerMqttRoutes()");
 
-        // Check for appSecret
-        if (isNumeric(topics[1]))
-        {
-            char msg[len + 1];
-            memcpy(msg, payload, len);
-            msg[len] = 0;
+    char pattern[64];
+    mqttRouter.clear();
 
-            JsonDocument doc;
-            DeserializationError error = deserializeJson(doc, msg);
+    // the only fields the framework reads, apps add theirs in app_setup()
+    mqttIngest.filter()["appInstanceID"] = true;
+    mqttIngest.filter()["appSecret"] = true;
 
-            // Test if parsing succeeds.
-            if (!error)
-            {
-                if (checkMessageForAppSecret(doc))
-                {
-                    // This is a command because there is an AppInstanceID in topic #2
-                    int cmdTargetID = atoi(topics[1]);
-                    if ((cmdTargetID == appInstanceID) || (cmdTargetID == -1))
-                    { // This command is for us (AppInstanceID == our appInstanceID or ALL appInstanceID)
-                        appMessageHandler(topic, doc);
-                    }
-                    else
-                    { // This command is for another instance
-                    }
-                }
-                else
-                {
-                    Log.errorln("AppSecret not found in message!");
-                }
-            }
-            else
-            {
-                Log.errorln("deserializeJson() failed: %s", error.c_str());
-            }
-        }
-        else
-        { // This is not a properly formatted command (might be a response)
-            Log.infoln("Not a command. No appInstanceID in subtopic #2. Could be our response. Ignoring...");
-            logMQTTMessage(topic, len, payload);
-        }
+    if (appInstanceID < 0)
+    {
+        snprintf(pattern, sizeof(pattern), "%s/online", appName);
+        mqttRouter.on(pattern, onMqttInstanceAnnouncement);
     }
     else
     {
-        for (int i = 0; i < otherAppTopicCount; i++)
-        {
-            if (strcmp(topics[i], "otherAppTopic") == 0)
-            {
-                // This is another App's message we are interested in
-                Log.infoln("Got otherThing topic");
-
-                char msg[len + 1];
-                memcpy(msg, payload, len);
-                msg[len] = 0;
-
-                JsonDocument doc;
-                DeserializationError error = deserializeJson(doc, msg);
-
-                // Test if parsing succeeds.
-                if (!error)
-                {
-                    otherAppMessageHandler[i](topic, doc);
-                }
-                else
-                {
-                    Log.errorln("deserializeJson() failed: %s", error.c_str());
-                }
-            }
-        }
+        snprintf(pattern, sizeof(pattern), "%s/%d/#", appName, appInstanceID);
+        mqttRouter.on(pattern, onMqttAppCommand);
+        snprintf(pattern, sizeof(pattern), "%s/-1/#", appName);
+        mqttRouter.on(pattern, onMqttAppCommand);
     }
-
-    Log.verboseln("Exiting...");
-    methodName = oldMethodName;
 }
 
-void doUpdateFirmware(char *fileName)
+void onMqttMessage(char *topic, char *payload, AsyncMqttClientMessageProperties properties, size_t len, size_t index, size_t total)
 {
-    String oldMethodName = methodName;
-    methodName = "doUpdateFirmware(char *fileName)";
-    Log.verboseln("Entering...");
+    TRACE_SCOPE("onMqttMessage()");
+
+    MqttMessage msg;
+    msg.payload = payload;
+    msg.len = len;
+    msg.index = index;
+    msg.total = total;
+    msg.properties = properties;
+
+    // route first, so payloads nobody wants are never copied or parsed
+    uint32_t routes = mqttRouter.match(topic, msg);
+    if (routes == 0)
+        Log.verboseln("No route for %s, ignored", topic);
+    else if (mqttIngest.assemble(msg))
+        mqttRouter.dispatch(routes, msg);
+}
+
+#pragma region Metrics
 
-    String fsFileName = "/" + String(fileName);
+#ifndef METRICS_PUBLISH_INTERVAL_S
+#define METRICS_PUBLISH_INTERVAL_S 0 // 0 = only served on /metrics, otherwise also published to <app>/<id>/metrics
+#endif
 
-    File file = LittleFS.open(fsFileName);
+#ifndef METRICS_PUBLISH_BUFFER_SIZE
+#define METRICS_PUBLISH_BUFFER_SIZE 2048
+#endif
 
-    if (!file)
+// collects the JSON summary for an MQTT publish
+class MetricsBufferOut : public MetricsOut
+{
+public:
+    MetricsBufferOut(char *buf, size_t size) : m_buf(buf), m_size(size), m_len(0), m_overflow(false) {}
+
+    virtual void write(const char *text, size_t len)
     {
-        Log.errorln("Failed to open file for reading");
-        return;
+        if (m_len + len >= m_size)
+        {
+            m_overflow = true;
+            return;
+        }
+        memcpy(m_buf + m_len, text, len);
+        m_len += len;
+        m_buf[m_len] = 0;
     }
 
-    Log.infoln("Starting update..");
+    size_t length() const { return m_len; }
+    bool overflowed() const { return m_overflow; }
 
-    size_t fileSize = file.size();
+private:
+    char *m_buf;
+    size_t m_size;
+    size_t m_len;
+    bool m_overflow;
+};
 
-    if (!Update.begin(fileSize))
-    {
-
-        Log.warningln("Cannot do the update!");
-        // TODO: publish a message that the update failed
+void publishMetrics(TimerHandle_t xTimer)
+{
+    (void)xTimer;
 
+    if (!mqttConnected || (appInstanceID < 0))
         return;
-    };
 
-    Update.writeStream(file);
-
-    if (Update.end())
+    // static: this runs on the timer task, whose stack is small
+    static char payload[METRICS_PUBLISH_BUFFER_SIZE];
+    MetricsBufferOut out(payload, sizeof(payload));
+    metricsWriteJson(out);
+    if (out.overflowed())
     {
-        Log.infoln("Successful update");
-    }
-    else
-    {
-
-        Log.errorln("Error Occurred: %s", String(Update.getError()));
-        // TODO: publish a message that the update failed
+        Log.warningln("Metrics do not fit METRICS_PUBLISH_BUFFER_SIZE, not published");
         return;
     }
 
-    file.close();
-
-    Log.infoln("Reset in 2 seconds...");
-    delay(2000);
-
-    reboot("Firmware update complete.");
+    char topic[64];
+    snprintf(topic, sizeof(topic), "%s/%d/metrics", appName, appInstanceID);
+    mqttClient.publish(topic, 0, false, payload, out.length());
 }
 
-int getlatestFirmware(char *fileName)
-{
-    String oldMethodName = methodName;
-    methodName = "int getlatestFirmware(char *fileName)";
-
-    int result = -1;
-    int httpCode = -1;
+#pragma endregion
 
-    WiFiClient client;
-    HTTPClient http;
-    String payload;
+void reportFirmwareProgress(const char *fileName, size_t done, size_t total)
+{
+    if (total == 0)
+        return;
 
-    String fsFileName = "/" + String(fileName);
+    int percent = done * 100 / total;
+    Log.infoln("Firmware %s: %d%% (%u of %u bytes)", fileName, percent, done, total);
 
-    File f = LittleFS.open(fsFileName, FILE_WRITE);
-    if (f)
+    if (mqttConnected)
     {
-        Log.verboseln("[HTTP] begin...");
-
-        // int connRes = client.connect(IPAddress(192,168,0,12), 5000);
-        // Log.verboseln("Connected: %d", connRes);
-
-        // if (http.begin(client, req))
-        String url = String("/firmware/") + fileName;
+        char progressTopic[64];
+        char payloadJson[128];
+        snprintf(progressTopic, sizeof(progressTopic), "%s/%d/ota", appName, appInstanceID);
+        snprintf(payloadJson, sizeof(payloadJson), "{ \"file\" : \"%s\", \"done\" : %u, \"total\" : %u }",
+                 fileName, (unsigned)done, (unsigned)total);
+        mqttClient.publish(progressTopic, 0, false, payloadJson);
+    }
+}
 
-        if (http.begin(client, HTTP_SERVER, HTTP_PORT, url))
-        { // HTTP
+void doUpdateFirmware(char *fileName)
+{
+    TRACE_SCOPE("doUpdateFirmware(char *fileName)");
 
-            Log.verboseln("[HTTP] GET...");
-            // start connection and send HTTP header
-            int httpCode = http.GET();
-            result = httpCode;
-            if (httpCode > 0)
-            {
-                if (httpCode == HTTP_CODE_OK)
-                {
-                    WiFiClient *stream = http.getStreamPtr();
-                    while (stream->available())
-                    {
-                        char c = stream->read();
-                        f.print(c);
-                    }
-                }
-            }
-            else
-            {
-                Log.verboseln("[HTTP] GET... failed, error: %s\n",
-                              http.errorToString(httpCode).c_str());
-            }
+    Log.infoln("Starting update..");
 
-            f.close();
-            http.end();
-        }
-        else
-        {
-            Log.warningln("[HTTP] Unable to connect");
-        }
+    String url = String(firmwareUrl) + fileName;
+    OtaResult result = String(fileName).endsWith(".delta")
+                           ? otaStreamDelta(url, fileName, reportFirmwareProgress)
+                           : otaStreamFirmware(url, fileName, reportFirmwareProgress);
+    if (result != OTA_OK)
+    {
+        // TODO: publish a message that the update failed
+        Log.errorln("Firmware update failed: %s", otaResultString(result));
+        return;
     }
 
-    Log.verboseln("Exiting...");
-    methodName = oldMethodName;
-    return httpCode;
+    Log.infoln("Successful update");
+    Log.infoln("Reset in 2 seconds...");
+    delay(2000);
+
+    reboot("Firmware update complete.");
 }
 
 void checkFWUpdate()
 {
-    String oldMethodName = methodName;
-    methodName = "checkFWUpdate()";
+    TRACE_SCOPE("checkFWUpdate()");
 
     String fileList;
     String server_req;
@@ -692,36 +605,40 @@ void checkFWUpdate()
     if (latestFWImageIndex > appVersion)
     {
         Log.infoln("New firmware available: v%d", latestFWImageIndex);
-        sprintf(latestFirmwareFileName, "%s_%d.bin", appName, latestFWImageIndex);
-        Log.infoln("Downloading %s", latestFirmwareFileName);
-        code = getlatestFirmware(latestFirmwareFileName);
 
-        Log.infoln("Updating firmware...");
+        // a patch from the version we run to the latest one is tried first: <appName>_<from>-<to>.delta
+        char deltaFileName[100];
+        snprintf(deltaFileName, sizeof(deltaFileName), "%s_%d-%d.delta", appName, appVersion, latestFWImageIndex);
+        for (size_t i = 0; i < doc.size(); i++)
+        {
+            if ((doc[i]["type"] == "file") && (doc[i]["name"] == deltaFileName))
+            {
+                Log.infoln("Updating firmware from %s", deltaFileName);
+                doUpdateFirmware(deltaFileName); // only returns if the patch failed
+                Log.warningln("Delta update failed, falling back to the full image");
+                break;
+            }
+        }
+
+        sprintf(latestFirmwareFileName, "%s_%d.bin", appName, latestFWImageIndex);
+        Log.infoln("Updating firmware from %s", latestFirmwareFileName);
         doUpdateFirmware(latestFirmwareFileName);
     }
     else
     {
         Log.infoln("No new firmware available.");
     }
-
-    Log.verboseln("Exiting...");
-    methodName = oldMethodName;
 }
 
 void setAppInstanceID()
 {
-    String oldMethodName = methodName;
-    methodName = "setAppInstanceID()";
-    Log.verboseln("Entering...");
+    TRACE_SCOPE("setAppInstanceID()");
 
     appInstanceID = maxOtherIndex + 1;
     storePrefs();
 
     Log.infoln("Got appInstanceID, restarting...");
     esp_restart();
-
-    Log.verboseln("Exiting...");
-    methodName = oldMethodName;
 }
 
 void framework_setup()
@@ -754,8 +671,18 @@ void framework_setup()
 
     Log.begin(LOG_LEVEL, &TLogPlus::Log, false);
     Log.setPrefix(printTimestamp);
+    taskWatchdogBegin(); // see task_topology.h
+    logRing.begin(&TLogPlus::Log);
 
-    logESPChipInfo();
+    wakeup_reason = esp_sleep_get_wakeup_cause();
+    reset_reason = esp_reset_reason();
+#ifdef USE_FAST_WAKE
+    fastWake = fastWakeBegin(wakeup_reason);
+#endif
+
+    if (!fastWake)
+        logESPChipInfo();
+    memoryTelemetryBegin();
     esp_base_mac_addr_get(macAddress);
     logMACAddress(macAddress);
 
@@ -763,15 +690,50 @@ void framework_setup()
 
     Log.infoln("Boot count: %d", bootCount);
 
-    wakeup_reason = esp_sleep_get_wakeup_cause();
-    reset_reason = esp_reset_reason();
     logWakeupReason(wakeup_reason);
     logResetReason(reset_reason);
 
     Log.noticeln("Starting %s v%d...", appName, appVersion);
 
-    // Framework: Setting up app framework
-    Log.verboseln("Entering ...");
+    // Wi-Fi associates while the hardware comes up, see boot_scheduler.h
+    int prefsStage = bootScheduler.add("prefs", initPrefs);
+    int connectivityStage = bootScheduler.add("connectivity", initConnectivity, BootScheduler::after(prefsStage));
+    bootScheduler.add("wifi", connectToWifi, BootScheduler::after(connectivityStage), 0); // with the Wi-Fi driver
+
+    int camStage = -1;
+#ifdef USE_ESP32_CAM
+    camStage = bootScheduler.add("camera", initCAM);
+#endif
+
+    bootScheduler.add("fs", initFS);
+
+    int displayStage = -1;
+#ifdef USE_GRAPHICS
+    displayStage = bootScheduler.add("display", setupDisplay);
+#endif
+
+#ifdef USE_SD_CARD
+#ifdef USE_GRAPHICS1
+    int sdStage = bootScheduler.add("sd", initSD, BootScheduler::after(displayStage)); // on the display's SPI bus
+#else
+    int sdStage = bootScheduler.add("sd", initSD);
+#endif
+    bootScheduler.add("sdList", listSD, BootScheduler::after(sdStage), tskNO_AFFINITY, true);
+#endif
+
+#ifdef USE_AUDIO
+    // the camera drives its parallel bus through I2S0 too
+    bootScheduler.add("audio", initAudioOutput, BootScheduler::after(camStage));
+#endif
+    (void)camStage;
+    (void)displayStage;
+
+    bootScheduler.run();
+}
+
+void initPrefs()
+{
+    TRACE_SCOPE("initPrefs()");
 
     preferences.begin(appName, false);
     loadPrefs();
@@ -783,26 +745,13 @@ void framework_setup()
     {
         Log.infoln("AppInstanceID: %d", appInstanceID);
     }
+}
 
-#ifdef USE_ESP32_CAM
-    initCAM();
-#endif
-
-    initFS();
-
-#ifdef USE_SD_CARD
-    initSD();
-#endif
-
-#ifdef USE_AUDIO
-    initAudioOutput();
-#endif
-
-#ifdef USE_GRAPHICS
-    setupDisplay();
-#endif
+// everything connectToWifi() needs: timers, event handlers, the MQTT client and the hostname
+void initConnectivity()
+{
+    TRACE_SCOPE("initConnectivity()");
 
-    // This is connectivity setup code
     mqttReconnectTimer = xTimerCreate("mqttTimer", pdMS_TO_TICKS(2000), pdFALSE,
                                       (void *)0, reinterpret_cast<TimerCallbackFunction_t>(connectToMqtt));
     wifiReconnectTimer = xTimerCreate("wifiTimer", pdMS_TO_TICKS(2000), pdFALSE,
@@ -826,21 +775,30 @@ void framework_setup()
             hostname = friendlyName;
         else
             hostname += '_' + appInstanceID;
-        mqttClient.onMessage(onMqttMessage);
     }
     else
     {
-        mqttClient.onMessage(onMqttIDMessage);
         appInstanceIDWaitTimer = xTimerCreate("appInstanceIDWaitTimer", pdMS_TO_TICKS(10000),
                                               pdFALSE, (void *)0,
                                               reinterpret_cast<TimerCallbackFunction_t>(setAppInstanceID));
         xTimerStart(appInstanceIDWaitTimer, 0);
     }
     WiFi.hostname(hostname);
+
+    registerMqttRoutes();
+    mqttClient.onMessage(onMqttMessage);
+
+    if (METRICS_PUBLISH_INTERVAL_S > 0)
+    {
+        metricsPublishTimer = xTimerCreate("metricsTimer", pdMS_TO_TICKS(METRICS_PUBLISH_INTERVAL_S * 1000), pdTRUE,
+                                           (void *)0, publishMetrics);
+        xTimerStart(metricsPublishTimer, 0);
+    }
 }
 
 void framework_loop()
 {
+    taskWatchdogFeed();
     TLogPlus::Log.loop();
 
 #ifdef USE_WEB_SERVER
@@ -857,7 +815,14 @@ void framework_loop()
 #endif
 }
 
+// Wi-Fi was started by the boot stages; if it is up already, what waited for setup() runs now
 void framework_start()
 {
-    connectToWifi();
+#if TASK_WDT_TIMEOUT_S > 0
+    esp_task_wdt_add(NULL); // the loop task, a housekeeping task like the others
+#endif
+
+    setupDone = true;
+    if (wifiConnectTasksDue.exchange(false))
+        wifiConnectTasks();
 }
@@ -0,0 +1,456 @@
+////////////////////////////////////////////////////////////////////
+/// @file image_journal.h
+/// @brief Append-only store-and-forward journal for images captured
+/// while MQTT is unavailable
+////////////////////////////////////////////////////////////////////
+
+#ifndef IMAGE_JOURNAL_H
+#define IMAGE_JOURNAL_H
+
+#include "framework.h"
+
+#include <esp_rom_crc.h>
+
+// Frames are appended back to back into a ring of large, preallocated segment files so that a
+// cached frame costs one seek and one sequential write instead of creating a file. A small
+// checkpoint file records where the unsent frames start and end. It is written to alternating
+// slots so a power cut during the write always leaves the previous checkpoint readable, and
+// on boot records appended after the last checkpoint are found again by their sequence
+// numbers. When the ring is full the oldest segment is dropped.
+//
+// Not thread safe: append() and replay() are both called from the image publish task.
+
+#ifndef JOURNAL_DIR
+#define JOURNAL_DIR "/journal"
+#endif
+
+#ifndef JOURNAL_SEGMENT_COUNT
+#define JOURNAL_SEGMENT_COUNT 8
+#endif
+
+#ifndef JOURNAL_SEGMENT_SIZE
+#define JOURNAL_SEGMENT_SIZE (4UL * 1024 * 1024)
+#endif
+
+#ifndef JOURNAL_CHECKPOINT_INTERVAL
+#define JOURNAL_CHECKPOINT_INTERVAL 8 // appends or replays between checkpoints
+#endif
+
+#define JOURNAL_ALIGN 512 // records start on sector boundaries
+#define JOURNAL_RECORD_MAGIC 0x4A524543  // "JREC"
+#define JOURNAL_END_MAGIC 0x4A454E44     // "JEND", rest of the segment is unused
+#define JOURNAL_CHECKPOINT_MAGIC 0x4A43504B // "JCPK"
+
+struct JournalRecordHeader
+{
+    uint32_t magic;
+    uint32_t seq;
+    uint32_t epoch;    // capture time (unix seconds), 0 if the clock was not set yet
+    uint32_t uptimeMs; // capture millis()
+    uint32_t length;   // image bytes following the header
+    uint32_t crc;      // crc32 of the image bytes
+    uint32_t reserved[2];
+};
+
+struct JournalCheckpoint
+{
+    uint32_t magic;
+    uint32_t generation; // the valid slot with the highest generation wins
+    uint32_t headSeg;    // where the next record is written
+    uint32_t headOff;
+    uint32_t headSeq;
+    uint32_t tailSeg; // oldest record not yet replayed
+    uint32_t tailOff;
+    uint32_t tailSeq;
+    uint32_t evicted; // frames lost to eviction, lifetime total
+    uint32_t crc;     // crc32 of the fields above
+};
+
+typedef bool (*JournalReplayHandler)(const uint8_t *data, size_t len, const JournalRecordHeader &header);
+// asked before each frame is read, false when the handler could not take one now
+typedef bool (*JournalReplayReady)();
+
+class ImageJournal
+{
+public:
+    ImageJournal() : m_fs(NULL), m_ready(false), m_replayBuf(NULL), m_replayBufLen(0), m_sinceCheckpoint(0)
+    {
+        memset(&m_state, 0, sizeof(m_state));
+    }
+
+    // opens (creating and preallocating if needed) the journal on fs and recovers its state
+    bool begin(fs::FS &fs)
+    {
+        m_fs = &fs;
+        m_ready = false;
+
+        if (!m_fs->exists(JOURNAL_DIR) && !m_fs->mkdir(JOURNAL_DIR))
+        {
+            Log.errorln("Journal: cannot create %s", JOURNAL_DIR);
+            return false;
+        }
+
+        for (uint32_t i = 0; i < JOURNAL_SEGMENT_COUNT; i++)
+        {
+            if (!preallocateSegment(i))
+                return false;
+        }
+
+        if (!loadCheckpoint())
+        {
+            Log.infoln("Journal: no checkpoint, starting empty");
+            memset(&m_state, 0, sizeof(m_state));
+        }
+        recoverHead();
+
+        m_ready = openHeadSegment();
+        if (m_ready)
+            Log.infoln("Journal: %u frames pending, %u evicted", pending(), m_state.evicted);
+        return m_ready;
+    }
+
+    bool isReady() { return m_ready; }
+
+    bool isEmpty() { return (m_state.tailSeg == m_state.headSeg) && (m_state.tailOff == m_state.headOff); }
+
+    uint32_t pending() { return m_state.headSeq - m_state.tailSeq; }
+
+    uint32_t evicted() { return m_state.evicted; }
+
+    bool append(const uint8_t *data, size_t len, uint32_t epoch, uint32_t uptimeMs)
+    {
+        if (!m_ready)
+            return false;
+
+        uint32_t recordSize = alignUp(sizeof(JournalRecordHeader) + len);
+        if (recordSize > JOURNAL_SEGMENT_SIZE)
+        {
+            Log.errorln("Journal: %u byte frame does not fit a segment", len);
+            return false;
+        }
+
+        if (m_state.headOff + recordSize > JOURNAL_SEGMENT_SIZE)
+        {
+            if (!nextHeadSegment())
+                return false;
+        }
+
+        JournalRecordHeader header;
+        memset(&header, 0, sizeof(header));
+        header.magic = JOURNAL_RECORD_MAGIC;
+        header.seq = m_state.headSeq;
+        header.epoch = epoch;
+        header.uptimeMs = uptimeMs;
+        header.length = len;
+        header.crc = esp_rom_crc32_le(0, data, len);
+
+        m_head.seek(m_state.headOff);
+        if ((m_head.write((const uint8_t *)&header, sizeof(header)) != sizeof(header)) ||
+            (m_head.write(data, len) != len))
+        {
+            Log.errorln("Journal: write failed");
+            return false;
+        }
+        m_head.flush();
+
+        m_state.headOff += recordSize;
+        m_state.headSeq++;
+        maybeCheckpoint();
+        return true;
+    }
+
+    // hands up to maxFrames of the oldest frames to handler, stopping early when it returns
+    // false (that frame is offered again next time). ready, when given, is asked first so a
+    // frame is not read from the card only to be refused. Returns the number of frames replayed.
+    size_t replay(size_t maxFrames, JournalReplayHandler handler, JournalReplayReady ready = NULL)
+    {
+        size_t replayed = 0;
+        if (!m_ready)
+            return 0;
+
+        File seg;
+        uint32_t openSeg = UINT32_MAX;
+
+        while ((replayed < maxFrames) && !isEmpty())
+        {
+            if ((ready != NULL) && !ready())
+                break;
+
+            if (openSeg != m_state.tailSeg)
+            {
+                seg.close();
+                seg = m_fs->open(segmentPath(m_state.tailSeg), FILE_READ);
+                openSeg = m_state.tailSeg;
+            }
+
+            JournalRecordHeader header;
+            bool valid = seg && (m_state.tailOff + sizeof(header) <= JOURNAL_SEGMENT_SIZE) &&
+                         seg.seek(m_state.tailOff) &&
+                         (seg.read((uint8_t *)&header, sizeof(header)) == sizeof(header)) &&
+                         (header.magic == JOURNAL_RECORD_MAGIC) &&
+                         (m_state.tailOff + alignUp(sizeof(header) + header.length) <= JOURNAL_SEGMENT_SIZE);
+
+            if (!valid)
+            {
+                // end of this segment's data
+                if (m_state.tailSeg == m_state.headSeg)
+                {
+                    Log.errorln("Journal: unreadable record at the tail, dropping the rest");
+                    m_state.tailOff = m_state.headOff;
+                    m_state.tailSeq = m_state.headSeq;
+                    break;
+                }
+                m_state.tailSeg = (m_state.tailSeg + 1) % JOURNAL_SEGMENT_COUNT;
+                m_state.tailOff = 0;
+                continue;
+            }
+
+            if (!reserveReplayBuffer(header.length) ||
+                (seg.read(m_replayBuf, header.length) != header.length))
+                break;
+
+            bool intact = esp_rom_crc32_le(0, m_replayBuf, header.length) == header.crc;
+            if (intact && !handler(m_replayBuf, header.length, header))
+                break;
+
+            if (!intact)
+                Log.warningln("Journal: frame %u failed its crc, skipped", header.seq);
+
+            m_state.tailOff += alignUp(sizeof(header) + header.length);
+            m_state.tailSeq = header.seq + 1;
+            replayed++;
+            m_sinceCheckpoint++;
+        }
+        seg.close();
+
+        if (isEmpty())
+        {
+            // all sent, give the buffer back until the next outage
+            releaseReplayBuffer();
+            writeCheckpoint();
+        }
+        else if (replayed > 0)
+            maybeCheckpoint();
+
+        return replayed;
+    }
+
+private:
+    static uint32_t alignUp(uint32_t n)
+    {
+        return (n + JOURNAL_ALIGN - 1) & ~(uint32_t)(JOURNAL_ALIGN - 1);
+    }
+
+    static String segmentPath(uint32_t seg)
+    {
+        char path[40];
+        snprintf(path, sizeof(path), JOURNAL_DIR "/seg%u.dat", (unsigned)seg);
+        return String(path);
+    }
+
+    bool preallocateSegment(uint32_t seg)
+    {
+        String path = segmentPath(seg);
+        File f = m_fs->open(path, FILE_READ);
+        bool ok = f && (f.size() >= JOURNAL_SEGMENT_SIZE);
+        f.close();
+        if (ok)
+            return true;
+
+        // extending by seeking past the end allocates the clusters once, up front
+        Log.infoln("Journal: preallocating %s", path.c_str());
+        f = m_fs->open(path, FILE_WRITE);
+        uint8_t zero = 0;
+        ok = f && f.seek(JOURNAL_SEGMENT_SIZE - 1) && (f.write(&zero, 1) == 1);
+        f.close();
+        if (!ok)
+            Log.errorln("Journal: cannot preallocate %s", path.c_str());
+        return ok;
+    }
+
+    bool openHeadSegment()
+    {
+        m_head.close();
+        m_head = m_fs->open(segmentPath(m_state.headSeg), "r+");
+        if (!m_head)
+            Log.errorln("Journal: cannot open head segment %u", m_state.headSeg);
+        return (bool)m_head;
+    }
+
+    bool nextHeadSegment()
+    {
+        // mark where this segment's data ends so the reader moves on without guessing
+        if (m_state.headOff + sizeof(JournalRecordHeader) <= JOURNAL_SEGMENT_SIZE)
+        {
+            JournalRecordHeader end;
+            memset(&end, 0, sizeof(end));
+            end.magic = JOURNAL_END_MAGIC;
+            end.seq = m_state.headSeq;
+            m_head.seek(m_state.headOff);
+            m_head.write((const uint8_t *)&end, sizeof(end));
+        }
+
+        uint32_t next = (m_state.headSeg + 1) % JOURNAL_SEGMENT_COUNT;
+        if (next == m_state.tailSeg && !isEmpty())
+            evictTailSegment();
+        else if (isEmpty())
+        {
+            m_state.tailSeg = next;
+            m_state.tailOff = 0;
+        }
+
+        m_state.headSeg = next;
+        m_state.headOff = 0;
+        writeCheckpoint();
+        return openHeadSegment();
+    }
+
+    // drops the oldest segment to make room, its first surviving record is found on replay
+    void evictTailSegment()
+    {
+        uint32_t newTailSeq = m_state.headSeq;
+        uint32_t seg = (m_state.tailSeg + 1) % JOURNAL_SEGMENT_COUNT;
+
+        File f = m_fs->open(segmentPath(seg), FILE_READ);
+        JournalRecordHeader header;
+        if (f && (f.read((uint8_t *)&header, sizeof(header)) == sizeof(header)) &&
+            (header.magic == JOURNAL_RECORD_MAGIC) && (header.seq >= m_state.tailSeq))
+            newTailSeq = header.seq;
+        f.close();
+
+        m_state.evicted += newTailSeq - m_state.tailSeq;
+        Log.warningln("Journal: full, evicted %u oldest frames", newTailSeq - m_state.tailSeq);
+        m_state.tailSeg = seg;
+        m_state.tailOff = 0;
+        m_state.tailSeq = newTailSeq;
+    }
+
+    // walks forward from the checkpointed head over records written after it was saved
+    void recoverHead()
+    {
+        uint32_t found = 0;
+        for (int hops = 0; hops < JOURNAL_SEGMENT_COUNT; hops++)
+        {
+            File f = m_fs->open(segmentPath(m_state.headSeg), FILE_READ);
+            if (!f)
+                break;
+
+            while (m_state.headOff + sizeof(JournalRecordHeader) <= JOURNAL_SEGMENT_SIZE)
+            {
+                JournalRecordHeader header;
+                if (!f.seek(m_state.headOff) ||
+                    (f.read((uint8_t *)&header, sizeof(header)) != sizeof(header)) ||
+                    (header.magic != JOURNAL_RECORD_MAGIC) || (header.seq != m_state.headSeq) ||
+                    (m_state.headOff + alignUp(sizeof(header) + header.length) > JOURNAL_SEGMENT_SIZE))
+                    break;
+                m_state.headOff += alignUp(sizeof(header) + header.length);
+                m_state.headSeq++;
+                found++;
+            }
+            f.close();
+
+            // did the writer move on to the next segment after the checkpoint?
+            uint32_t next = (m_state.headSeg + 1) % JOURNAL_SEGMENT_COUNT;
+            f = m_fs->open(segmentPath(next), FILE_READ);
+            JournalRecordHeader header;
+            bool continues = f && (f.read((uint8_t *)&header, sizeof(header)) == sizeof(header)) &&
+                             (header.magic == JOURNAL_RECORD_MAGIC) && (header.seq == m_state.headSeq);
+            f.close();
+            if (!continues)
+                break;
+
+            if (next == m_state.tailSeg)
+                evictTailSegment();
+            m_state.headSeg = next;
+            m_state.headOff = 0;
+        }
+
+        if (found > 0)
+        {
+            Log.infoln("Journal: recovered %u frames written after the last checkpoint", found);
+            writeCheckpoint();
+        }
+    }
+
+    bool loadCheckpoint()
+    {
+        File f = m_fs->open(JOURNAL_DIR "/index.dat", FILE_READ);
+        if (!f)
+            return false;
+
+        JournalCheckpoint slots[2];
+        bool valid[2];
+        for (int i = 0; i < 2; i++)
+        {
+            valid[i] = (f.read((uint8_t *)&slots[i], sizeof(JournalCheckpoint)) == sizeof(JournalCheckpoint)) &&
+                       (slots[i].magic == JOURNAL_CHECKPOINT_MAGIC) &&
+                       (slots[i].crc == esp_rom_crc32_le(0, (const uint8_t *)&slots[i], offsetof(JournalCheckpoint, crc))) &&
+                       (slots[i].headSeg < JOURNAL_SEGMENT_COUNT) && (slots[i].tailSeg < JOURNAL_SEGMENT_COUNT);
+        }
+        f.close();
+
+        if (!valid[0] && !valid[1])
+            return false;
+
+        int best = (valid[0] && (!valid[1] || (slots[0].generation > slots[1].generation))) ? 0 : 1;
+        m_state = slots[best];
+        return true;
+    }
+
+    void writeCheckpoint()
+    {
+        m_state.magic = JOURNAL_CHECKPOINT_MAGIC;
+        m_state.generation++;
+        m_state.crc = esp_rom_crc32_le(0, (const uint8_t *)&m_state, offsetof(JournalCheckpoint, crc));
+
+        const char *path = JOURNAL_DIR "/index.dat";
+        File f = m_fs->exists(path) ? m_fs->open(path, "r+") : m_fs->open(path, FILE_WRITE);
+        if (f)
+        {
+            f.seek((m_state.generation & 1) * sizeof(JournalCheckpoint));
+            f.write((const uint8_t *)&m_state, sizeof(JournalCheckpoint));
+            f.close();
+        }
+        m_sinceCheckpoint = 0;
+    }
+
+    void maybeCheckpoint()
+    {
+        if (++m_sinceCheckpoint >= JOURNAL_CHECKPOINT_INTERVAL)
+            writeCheckpoint();
+    }
+
+    // replay reads into one heap buffer (PSRAM when there is some) reused across frames
+    bool reserveReplayBuffer(size_t len)
+    {
+        if (len <= m_replayBufLen)
+            return true;
+
+        releaseReplayBuffer();
+        m_replayBuf = (uint8_t *)(psramFound() ? ps_malloc(len) : malloc(len));
+        if (!m_replayBuf)
+        {
+            Log.errorln("Journal: no memory for a %u byte frame", len);
+            return false;
+        }
+        m_replayBufLen = len;
+        return true;
+    }
+
+    void releaseReplayBuffer()
+    {
+        free(m_replayBuf);
+        m_replayBuf = NULL;
+        m_replayBufLen = 0;
+    }
+
+    fs::FS *m_fs;
+    bool m_ready;
+    File m_head;
+    JournalCheckpoint m_state;
+    uint8_t *m_replayBuf;
+    size_t m_replayBufLen;
+    uint32_t m_sinceCheckpoint;
+};
+
+#endif // IMAGE_JOURNAL_H
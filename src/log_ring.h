@@ -0,0 +1,507 @@
+////////////////////////////////////////////////////////////////////
+/// @file log_ring.h
+/// @brief Deferred logging: records now, formats later on a low
+/// priority task
+////////////////////////////////////////////////////////////////////
+
+#ifndef LOG_RING_H
+#define LOG_RING_H
+
+#include <Arduino.h>
+#include <ArduinoLog.h>
+#include <atomic>
+#include <time.h>
+
+#include "task_topology.h"
+#include "trace.h"
+
+// logRing.infoln("fmt", args...) mirrors Log.infoln() for code on a hot path. The caller only
+// copies the format pointer, the trace scope, millis() and the raw arguments into a fixed size
+// slot; localtime/strftime, the formatting and the sinks (Serial, syslog, ...) run later on the
+// "logRing" task. Formats are printf style (%d %u %x %s %f %p, with the usual flags, width and
+// precision, * included) rather than ArduinoLog's, and the format and any char* that is not copied must be
+// a string literal. String arguments are copied into the slot and truncated to what fits.
+//
+// The ring is a bounded multi-producer queue (one sequence number per slot, claimed with a
+// compare-and-swap), so recording never takes a lock or blocks. When the drain task falls
+// behind, new records are dropped and counted, and the drain reports the count in the log.
+// Drained slots are left as they are, so dump() also returns the recent history for
+// tools/decode_log_ring.py.
+
+#ifndef LOG_RING_SLOTS
+#define LOG_RING_SLOTS 64 // must be a power of two
+#endif
+
+#ifndef LOG_RING_ARG_WORDS
+#define LOG_RING_ARG_WORDS 8 // 32 bit words per record; 64 bit and double arguments take two
+#endif
+
+#ifndef LOG_RING_TEXT_SIZE
+#define LOG_RING_TEXT_SIZE 36 // bytes per record for copies of string arguments
+#endif
+
+#ifndef LOG_RING_DRAIN_MS
+#define LOG_RING_DRAIN_MS 20 // how long the drain task sleeps once the ring is empty
+#endif
+
+#ifndef LOG_RING_TASK_PRIORITY
+#define LOG_RING_TASK_PRIORITY TASK_PRIORITY_HOUSEKEEPING
+#endif
+
+#ifndef LOG_RING_TASK_CORE
+#define LOG_RING_TASK_CORE TASK_CORE_HOUSEKEEPING
+#endif
+
+#ifndef LOG_RING_TASK_STACK
+#define LOG_RING_TASK_STACK 3072
+#endif
+
+#define LOG_RING_LINE_SIZE 256
+
+static_assert((LOG_RING_SLOTS & (LOG_RING_SLOTS - 1)) == 0, "LOG_RING_SLOTS must be a power of two");
+static_assert(LOG_RING_ARG_WORDS <= 8, "argument types are packed 4 bits each into 32 bits");
+
+enum LogArgType : uint8_t
+{
+    LOG_ARG_NONE,
+    LOG_ARG_INT,
+    LOG_ARG_UINT,
+    LOG_ARG_INT64,
+    LOG_ARG_UINT64,
+    LOG_ARG_DOUBLE,
+    LOG_ARG_STR, // the word is the offset of a NUL terminated copy in text
+    LOG_ARG_PTR
+};
+
+// the layout is read back by tools/decode_log_ring.py, keep the two in step
+struct LogRecord
+{
+    std::atomic<uint32_t> seq; // index while free, index + 1 once written
+    uint32_t index;            // position of the record in the log
+    uint32_t ms;               // millis() when recorded
+    const char *fmt;
+    const char *scope; // traceCurrentName() when recorded
+    uint32_t types;    // LogArgType per word-consuming argument, 4 bits each, lowest first
+    uint8_t level;
+    uint8_t textLen;
+    uint16_t reserved;
+    uint32_t words[LOG_RING_ARG_WORDS];
+    char text[LOG_RING_TEXT_SIZE];
+};
+
+// header of dump()
+struct LogRingDumpHeader
+{
+    char magic[4]; // "LRG1"
+    uint32_t slots;
+    uint32_t slotSize;
+    uint32_t argWords;
+    uint32_t textSize;
+    uint32_t enqueued; // records claimed so far
+    uint32_t dequeued; // records formatted so far
+    uint32_t dropped;
+    uint32_t ms; // millis() at the time of the dump
+};
+
+// collects the arguments of one call into a slot
+class LogArgWriter
+{
+public:
+    explicit LogArgWriter(LogRecord &r) : m_r(r), m_word(0), m_arg(0), m_text(0)
+    {
+        m_r.types = 0;
+    }
+
+    void add(bool v) { put(LOG_ARG_INT, v ? 1 : 0); }
+    void add(char v) { put(LOG_ARG_INT, (uint32_t)(int32_t)v); }
+    void add(signed char v) { put(LOG_ARG_INT, (uint32_t)(int32_t)v); }
+    void add(unsigned char v) { put(LOG_ARG_UINT, v); }
+    void add(short v) { put(LOG_ARG_INT, (uint32_t)(int32_t)v); }
+    void add(unsigned short v) { put(LOG_ARG_UINT, v); }
+    void add(int v) { put(LOG_ARG_INT, (uint32_t)v); }
+    void add(unsigned int v) { put(LOG_ARG_UINT, v); }
+    void add(long v)
+    {
+        if (sizeof(long) > 4)
+            add((long long)v);
+        else
+            put(LOG_ARG_INT, (uint32_t)v);
+    }
+    void add(unsigned long v)
+    {
+        if (sizeof(long) > 4)
+            add((unsigned long long)v);
+        else
+            put(LOG_ARG_UINT, (uint32_t)v);
+    }
+    void add(long long v) { put64(LOG_ARG_INT64, (uint64_t)v); }
+    void add(unsigned long long v) { put64(LOG_ARG_UINT64, v); }
+    void add(float v) { add((double)v); }
+    void add(double v)
+    {
+        uint64_t bits;
+        memcpy(&bits, &v, sizeof(bits));
+        put64(LOG_ARG_DOUBLE, bits);
+    }
+    void add(const char *s) { putString(s); }
+    void add(char *s) { putString(s); }
+    void add(const String &s) { putString(s.c_str()); }
+    void add(const void *p) { put(LOG_ARG_PTR, (uint32_t)(uintptr_t)p); }
+
+    void finish() { m_r.textLen = m_text; }
+
+private:
+    bool claim(LogArgType type, int words)
+    {
+        if ((m_word + words > LOG_RING_ARG_WORDS) || (m_arg >= 8))
+        {
+            // keep later arguments from taking the place of this one
+            m_word = LOG_RING_ARG_WORDS;
+            return false;
+        }
+        m_r.types |= (uint32_t)type << (4 * m_arg++);
+        return true;
+    }
+
+    void put(LogArgType type, uint32_t v)
+    {
+        if (claim(type, 1))
+            m_r.words[m_word++] = v;
+    }
+
+    void put64(LogArgType type, uint64_t v)
+    {
+        if (!claim(type, 2))
+            return;
+        m_r.words[m_word++] = (uint32_t)v;
+        m_r.words[m_word++] = (uint32_t)(v >> 32);
+    }
+
+    void putString(const char *s)
+    {
+        if (s == NULL)
+            s = "(null)";
+        if ((m_text >= LOG_RING_TEXT_SIZE) || !claim(LOG_ARG_STR, 1))
+            return;
+        m_r.words[m_word++] = m_text;
+        size_t n = strnlen(s, LOG_RING_TEXT_SIZE - m_text - 1);
+        memcpy(m_r.text + m_text, s, n);
+        m_text += n;
+        m_r.text[m_text++] = 0;
+    }
+
+    LogRecord &m_r;
+    uint8_t m_word;
+    uint8_t m_arg;
+    uint8_t m_text;
+};
+
+class LogRing
+{
+public:
+    LogRing() : m_out(NULL), m_level(LOG_LEVEL), m_task(NULL), m_dequeue(0), m_reported(0)
+    {
+        m_enqueue.store(0);
+        m_dropped.store(0);
+        for (uint32_t i = 0; i < LOG_RING_SLOTS; i++)
+        {
+            m_slots[i].seq.store(i);
+            m_slots[i].index = 0;
+            m_slots[i].fmt = NULL;
+        }
+    }
+
+    // starts the drain task, which writes finished lines to out
+    bool begin(Print *out, int level = LOG_LEVEL)
+    {
+        m_out = out;
+        m_level = level;
+        if (m_task == NULL)
+            startTask(drainTask, "logRing", LOG_RING_TASK_STACK, this, LOG_RING_TASK_PRIORITY, LOG_RING_TASK_CORE,
+                      &m_task);
+        return m_task != NULL;
+    }
+
+    template <class... Args>
+    void fatalln(const char *fmt, Args... args) { record(LOG_LEVEL_FATAL, fmt, args...); }
+    template <class... Args>
+    void errorln(const char *fmt, Args... args) { record(LOG_LEVEL_ERROR, fmt, args...); }
+    template <class... Args>
+    void warningln(const char *fmt, Args... args) { record(LOG_LEVEL_WARNING, fmt, args...); }
+    template <class... Args>
+    void noticeln(const char *fmt, Args... args) { record(LOG_LEVEL_NOTICE, fmt, args...); }
+    template <class... Args>
+    void infoln(const char *fmt, Args... args) { record(LOG_LEVEL_INFO, fmt, args...); }
+    template <class... Args>
+    void traceln(const char *fmt, Args... args) { record(LOG_LEVEL_TRACE, fmt, args...); }
+    template <class... Args>
+    void verboseln(const char *fmt, Args... args) { record(LOG_LEVEL_VERBOSE, fmt, args...); }
+
+    uint32_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+    uint32_t recorded() const { return m_enqueue.load(std::memory_order_relaxed); }
+    uint32_t pending() const { return m_enqueue.load(std::memory_order_relaxed) - m_dequeue; }
+
+    // writes a LogRingDumpHeader and the raw slots, for tools/decode_log_ring.py; records
+    // being written while the dump runs are skipped by the decoder
+    void dump(Print *out)
+    {
+        LogRingDumpHeader h;
+        memcpy(h.magic, "LRG1", 4);
+        h.slots = LOG_RING_SLOTS;
+        h.slotSize = sizeof(LogRecord);
+        h.argWords = LOG_RING_ARG_WORDS;
+        h.textSize = LOG_RING_TEXT_SIZE;
+        h.enqueued = m_enqueue.load();
+        h.dequeued = m_dequeue;
+        h.dropped = m_dropped.load();
+        h.ms = millis();
+        out->write((const uint8_t *)&h, sizeof(h));
+        out->write((const uint8_t *)m_slots, sizeof(m_slots));
+    }
+
+private:
+#ifdef DISABLE_LOGGING
+    template <class... Args>
+    void record(int level, const char *fmt, Args... args) {}
+#else
+    template <class... Args>
+    void record(int level, const char *fmt, Args... args)
+    {
+        if (level > m_level)
+            return;
+
+        uint32_t pos = m_enqueue.load(std::memory_order_relaxed);
+        LogRecord *r;
+        while (true)
+        {
+            r = &m_slots[pos & (LOG_RING_SLOTS - 1)];
+            int32_t diff = (int32_t)(r->seq.load(std::memory_order_acquire) - pos);
+            if (diff == 0)
+            {
+                if (m_enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                // the drain has not reached this slot yet
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            else
+                pos = m_enqueue.load(std::memory_order_relaxed);
+        }
+
+        r->index = pos;
+        r->ms = millis();
+        r->fmt = fmt;
+        r->scope = traceCurrentName();
+        r->level = level;
+        LogArgWriter w(*r);
+        int unused[] = {0, (w.add(args), 0)...};
+        (void)unused;
+        w.finish();
+        r->seq.store(pos + 1, std::memory_order_release);
+    }
+#endif
+
+    // formats and prints everything recorded so far, returns the count; the queue has a single
+    // consumer, so this only ever runs on the drain task
+    int drain()
+    {
+        int n = 0;
+        while (drainOne())
+            n++;
+
+        uint32_t dropped = m_dropped.load(std::memory_order_relaxed);
+        if ((dropped != m_reported) && (m_out != NULL))
+        {
+            m_out->printf("logRing: ring full, %lu records dropped\r\n", (unsigned long)(dropped - m_reported));
+            m_reported = dropped;
+        }
+        return n;
+    }
+
+    bool drainOne()
+    {
+        LogRecord &r = m_slots[m_dequeue & (LOG_RING_SLOTS - 1)];
+        if (r.seq.load(std::memory_order_acquire) != m_dequeue + 1)
+            return false;
+
+        if (m_out != NULL)
+        {
+            char line[LOG_RING_LINE_SIZE];
+            size_t n = formatPrefix(r, line, sizeof(line));
+            n += formatMessage(r, line + n, sizeof(line) - n);
+            m_out->write((const uint8_t *)line, n);
+            m_out->print("\r\n");
+        }
+
+        // free the slot for the producer that comes round next time
+        r.seq.store(m_dequeue + LOG_RING_SLOTS, std::memory_order_release);
+        m_dequeue++;
+        return true;
+    }
+
+    // the same prefix as printTimestamp(), but for the time the record was made
+    size_t formatPrefix(const LogRecord &r, char *out, size_t size)
+    {
+        time_t now = time(NULL);
+        struct tm timeinfo;
+        char stamp[20];
+        if (now < 24 * 3600 * 365)
+        {
+            snprintf(stamp, sizeof(stamp), "%10lu ", (unsigned long)r.ms);
+        }
+        else
+        {
+            time_t then = now - (time_t)((millis() - r.ms) / 1000);
+            localtime_r(&then, &timeinfo);
+            strftime(stamp, sizeof(stamp), "%Y%m%d %H:%M:%S", &timeinfo);
+        }
+        int n = snprintf(out, size, "%s: %s: ", stamp, r.scope);
+        return (n < 0) ? 0 : minimum((size_t)n, size - 1);
+    }
+
+    // the next saved argument and its type, LOG_ARG_NONE once they run out
+    static uint64_t nextArg(const LogRecord &r, int &arg, int &word, LogArgType &type)
+    {
+        type = (arg < 8) ? (LogArgType)((r.types >> (4 * arg)) & 0xF) : LOG_ARG_NONE;
+        arg++;
+        uint64_t v = 0;
+        if ((type == LOG_ARG_INT64) || (type == LOG_ARG_UINT64) || (type == LOG_ARG_DOUBLE))
+        {
+            v = r.words[word] | ((uint64_t)r.words[word + 1] << 32);
+            word += 2;
+        }
+        else if (type != LOG_ARG_NONE)
+            v = r.words[word++];
+        return v;
+    }
+
+    // printf for the saved arguments: each conversion is handed to snprintf on its own with
+    // the length modifier replaced to match the type that was actually recorded. A * width or
+    // precision takes the next saved argument and is written into the conversion as a number
+    size_t formatMessage(const LogRecord &r, char *out, size_t size)
+    {
+        const char *f = r.fmt;
+        size_t len = 0;
+        int word = 0;
+        int arg = 0;
+
+        while ((*f != 0) && (len + 1 < size))
+        {
+            if (*f != '%')
+            {
+                out[len++] = *f++;
+                continue;
+            }
+            if (f[1] == '%')
+            {
+                out[len++] = '%';
+                f += 2;
+                continue;
+            }
+
+            char spec[40];
+            size_t s = 0;
+            spec[s++] = *f++;
+            while ((*f != 0) && (strchr("-+ #0123456789.*", *f) != NULL) && (s < sizeof(spec) - 16))
+            {
+                if (*f++ != '*')
+                {
+                    spec[s++] = f[-1];
+                    continue;
+                }
+                LogArgType starType;
+                int32_t star = (int32_t)nextArg(r, arg, word, starType);
+                if ((s > 1) && (spec[s - 1] == '.') && (star < 0))
+                    s--; // a negative precision is taken as if there were none
+                else
+                    s += snprintf(spec + s, sizeof(spec) - s, "%ld", (long)star);
+            }
+            while ((*f != 0) && (strchr("hlLqjzt", *f) != NULL))
+                f++;
+            char conv = *f;
+            if (conv == 0)
+                break;
+            f++;
+
+            LogArgType type;
+            uint64_t v = nextArg(r, arg, word, type);
+
+            int n;
+            if (type == LOG_ARG_NONE)
+                n = snprintf(out + len, size - len, "<?>");
+            else if (strchr("sS", conv) != NULL)
+            {
+                spec[s++] = 's';
+                spec[s] = 0;
+                n = snprintf(out + len, size - len, spec, (type == LOG_ARG_STR) ? r.text + v : "<?>");
+            }
+            else if (strchr("fFeEgGaA", conv) != NULL)
+            {
+                double d;
+                if (type == LOG_ARG_DOUBLE)
+                    memcpy(&d, &v, sizeof(d));
+                else
+                    d = (type == LOG_ARG_INT) ? (double)(int32_t)v : (double)v;
+                spec[s++] = conv;
+                spec[s] = 0;
+                n = snprintf(out + len, size - len, spec, d);
+            }
+            else if (conv == 'p')
+                n = snprintf(out + len, size - len, "%p", (void *)(uintptr_t)v);
+            else if (conv == 'c')
+            {
+                spec[s++] = 'c';
+                spec[s] = 0;
+                n = snprintf(out + len, size - len, spec, (int)v);
+            }
+            else
+            {
+                // integers: sign extend only for a signed conversion of a signed argument
+                long long i = (long long)v;
+                if ((type == LOG_ARG_INT) && (strchr("di", conv) != NULL))
+                    i = (int32_t)v;
+                else if (type == LOG_ARG_DOUBLE)
+                {
+                    double d;
+                    memcpy(&d, &v, sizeof(d));
+                    i = (long long)d;
+                }
+                spec[s++] = 'l';
+                spec[s++] = 'l';
+                spec[s++] = (strchr("diouxX", conv) != NULL) ? conv : 'd';
+                spec[s] = 0;
+                n = snprintf(out + len, size - len, spec, i);
+            }
+
+            if (n > 0)
+                len = minimum(len + n, size - 1);
+        }
+        out[len] = 0;
+        return len;
+    }
+
+    static void drainTask(void *arg)
+    {
+        LogRing *ring = (LogRing *)arg;
+        while (true)
+        {
+            taskWatchdogFeed();
+            if (ring->drain() == 0)
+                vTaskDelay(pdMS_TO_TICKS(LOG_RING_DRAIN_MS));
+        }
+    }
+
+    LogRecord m_slots[LOG_RING_SLOTS];
+    std::atomic<uint32_t> m_enqueue;
+    std::atomic<uint32_t> m_dropped;
+    Print *m_out;
+    int m_level;
+    TaskHandle_t m_task;
+    uint32_t m_dequeue;  // only touched by the drain
+    uint32_t m_reported; // drops already reported
+};
+
+#endif // LOG_RING_H
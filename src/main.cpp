@@ -23,17 +23,13 @@
 
 void setup()
 {
-  String oldMethodName = methodName;
-  methodName = "setup()";
+  TRACE_SCOPE("setup()");
 
   framework_setup();
 
   app_setup();
 
   framework_start();
-
-  Log.verboseln("Exiting...");
-  methodName = oldMethodName;
 }
 
 void loop()
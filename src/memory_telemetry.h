@@ -0,0 +1,354 @@
+////////////////////////////////////////////////////////////////////
+/// @file memory_telemetry.h
+/// @brief Periodic heap, PSRAM and task stack telemetry
+////////////////////////////////////////////////////////////////////
+
+#ifndef MEMORY_TELEMETRY_H
+#define MEMORY_TELEMETRY_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <ArduinoLog.h>
+#include <Metrics.h>
+#include <esp_heap_caps.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/timers.h"
+#include "task_topology.h"
+
+// Every MEMORY_SAMPLE_INTERVAL_S a timer wakes the memoryTelemetry task, which takes a
+// MemorySnapshot: free, minimum-ever free and largest free block of internal RAM and PSRAM,
+// the stack high-water mark of every task (the MEMORY_MAX_TASKS with the least stack left are
+// kept), and the allocations that have failed since boot (counted by a heap_caps hook). A
+// falling largest block with steady free memory is fragmentation; a falling minimum is a leak
+// or a peak that came close.
+//
+// Crossing a MEMORY_WARN_* threshold logs a warning (and a notice when it recovers) and
+// publishes the snapshot at once. Otherwise it goes to <app>/<id>/memory every
+// MEMORY_PUBLISH_EVERY samples. GET /memory.json returns a fresh one, and the main figures
+// are also gauges on /metrics.
+
+#ifndef MEMORY_SAMPLE_INTERVAL_S
+#define MEMORY_SAMPLE_INTERVAL_S 30
+#endif
+
+#ifndef MEMORY_PUBLISH_EVERY
+#define MEMORY_PUBLISH_EVERY 10 // samples between MQTT publishes, 0 = never
+#endif
+
+#ifndef MEMORY_WARN_INTERNAL_FREE
+#define MEMORY_WARN_INTERNAL_FREE 24576 // bytes
+#endif
+
+#ifndef MEMORY_WARN_INTERNAL_BLOCK
+#define MEMORY_WARN_INTERNAL_BLOCK 8192 // largest free internal block, bytes
+#endif
+
+#ifndef MEMORY_WARN_PSRAM_FREE
+#define MEMORY_WARN_PSRAM_FREE 262144 // bytes, ignored without PSRAM
+#endif
+
+#ifndef MEMORY_WARN_STACK_FREE
+#define MEMORY_WARN_STACK_FREE 512 // bytes of stack a task has never touched
+#endif
+
+#ifndef MEMORY_MAX_TASKS
+#define MEMORY_MAX_TASKS 24 // tasks kept in a snapshot
+#endif
+
+#ifndef MEMORY_TELEMETRY_STACK_SIZE
+#define MEMORY_TELEMETRY_STACK_SIZE 4096
+#endif
+
+#ifndef MEMORY_TELEMETRY_PRIORITY
+#define MEMORY_TELEMETRY_PRIORITY TASK_PRIORITY_HOUSEKEEPING
+#endif
+
+#ifndef MEMORY_TELEMETRY_CORE
+#define MEMORY_TELEMETRY_CORE TASK_CORE_HOUSEKEEPING
+#endif
+
+struct MemoryPoolStats
+{
+    uint32_t total;
+    uint32_t free;
+    uint32_t minFree; // lowest free since boot
+    uint32_t largest; // largest free block
+};
+
+struct MemoryTaskStats
+{
+    char name[configMAX_TASK_NAME_LEN];
+    uint32_t stackFree; // high-water mark, bytes
+    uint8_t priority;
+};
+
+struct MemorySnapshot
+{
+    uint32_t ms;
+    MemoryPoolStats internal;
+    MemoryPoolStats psram;
+    MemoryTaskStats tasks[MEMORY_MAX_TASKS];
+    uint8_t taskCount;
+    uint16_t taskTotal; // tasks sampled, more than taskCount when some were left out
+    uint32_t allocFailures;
+    uint32_t lastFailedSize;
+    uint32_t lastFailedCaps;
+};
+
+TimerHandle_t memoryTelemetryTimer;
+TaskHandle_t memoryTelemetryTaskHandle = NULL;
+MemorySnapshot memorySnapshot; // the last periodic sample
+uint32_t memorySamples = 0;
+
+MetricCounter memoryAllocFailures("memory_alloc_failures_total", "heap_caps allocations that failed");
+volatile uint32_t memoryLastFailedSize = 0;
+volatile uint32_t memoryLastFailedCaps = 0;
+
+MetricGauge memoryInternalFree("memory_internal_free_bytes", "Free internal RAM",
+                               []() { return (double)heap_caps_get_free_size(MALLOC_CAP_INTERNAL); });
+MetricGauge memoryInternalMinFree("memory_internal_min_free_bytes", "Lowest free internal RAM since boot",
+                                  []() { return (double)heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL); });
+MetricGauge memoryInternalLargest("memory_internal_largest_block_bytes", "Largest free internal RAM block",
+                                  []() { return (double)heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL); });
+MetricGauge memoryPsramFree("memory_psram_free_bytes", "Free PSRAM",
+                            []() { return (double)heap_caps_get_free_size(MALLOC_CAP_SPIRAM); });
+MetricGauge memoryPsramMinFree("memory_psram_min_free_bytes", "Lowest free PSRAM since boot",
+                               []() { return (double)heap_caps_get_minimum_free_size(MALLOC_CAP_SPIRAM); });
+MetricGauge memoryPsramLargest("memory_psram_largest_block_bytes", "Largest free PSRAM block",
+                               []() { return (double)heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM); });
+
+// warning state, so each threshold is reported when it is crossed rather than every sample
+bool memoryInternalLow = false;
+bool memoryFragmented = false;
+bool memoryPsramLow = false;
+char memoryStackWarned[MEMORY_MAX_TASKS][configMAX_TASK_NAME_LEN];
+uint8_t memoryStackWarnedCount = 0;
+
+void memoryTelemetryTick(TimerHandle_t xTimer);
+void memoryTelemetryTask(void *pvParameters);
+
+// runs in whatever task failed to allocate, possibly with interrupts off: no logging here
+void memoryAllocFailed(size_t size, uint32_t caps, const char *functionName)
+{
+    (void)functionName;
+    memoryAllocFailures.add();
+    memoryLastFailedSize = size;
+    memoryLastFailedCaps = caps;
+}
+
+void memoryPoolStats(uint32_t caps, MemoryPoolStats &s)
+{
+    multi_heap_info_t info;
+    heap_caps_get_info(&info, caps);
+    s.total = heap_caps_get_total_size(caps);
+    s.free = info.total_free_bytes;
+    s.minFree = info.minimum_free_bytes;
+    s.largest = info.largest_free_block;
+}
+
+void memorySample(MemorySnapshot &s)
+{
+    s.ms = millis();
+    memoryPoolStats(MALLOC_CAP_INTERNAL, s.internal);
+    memoryPoolStats(MALLOC_CAP_SPIRAM, s.psram);
+    s.allocFailures = memoryAllocFailures.value();
+    s.lastFailedSize = memoryLastFailedSize;
+    s.lastFailedCaps = memoryLastFailedCaps;
+
+    // one consistent pass over all tasks, including ones the framework did not create. The
+    // buffer is allocated per call as both the telemetry task and the web server sample, with
+    // room for a few tasks created in between: uxTaskGetSystemState() returns nothing at all
+    // when they do not all fit
+    s.taskCount = 0;
+    s.taskTotal = 0;
+    UBaseType_t size = uxTaskGetNumberOfTasks() + 4;
+    TaskStatus_t *status = (TaskStatus_t *)malloc(size * sizeof(TaskStatus_t));
+    if (status == NULL)
+        return;
+    UBaseType_t n = uxTaskGetSystemState(status, size, NULL);
+
+    for (UBaseType_t i = 0; i < n; i++)
+    {
+        // when the snapshot is full the task with the most stack left makes way
+        int slot = s.taskCount;
+        if (slot >= MEMORY_MAX_TASKS)
+        {
+            slot = 0;
+            for (int j = 1; j < MEMORY_MAX_TASKS; j++)
+            {
+                if (s.tasks[j].stackFree > s.tasks[slot].stackFree)
+                    slot = j;
+            }
+            if (s.tasks[slot].stackFree <= status[i].usStackHighWaterMark)
+                continue;
+        }
+        else
+            s.taskCount++;
+
+        strlcpy(s.tasks[slot].name, status[i].pcTaskName, sizeof(s.tasks[slot].name));
+        // StackType_t is a byte on the ESP32, so this is in bytes
+        s.tasks[slot].stackFree = status[i].usStackHighWaterMark;
+        s.tasks[slot].priority = status[i].uxCurrentPriority;
+    }
+    s.taskTotal = n;
+    free(status);
+}
+
+void memoryToJson(const MemorySnapshot &s, JsonDocument &doc)
+{
+    doc["uptimeMs"] = s.ms;
+
+    JsonObject internal = doc["internal"].to<JsonObject>();
+    internal["total"] = s.internal.total;
+    internal["free"] = s.internal.free;
+    internal["minFree"] = s.internal.minFree;
+    internal["largestBlock"] = s.internal.largest;
+
+    if (s.psram.total > 0)
+    {
+        JsonObject psram = doc["psram"].to<JsonObject>();
+        psram["total"] = s.psram.total;
+        psram["free"] = s.psram.free;
+        psram["minFree"] = s.psram.minFree;
+        psram["largestBlock"] = s.psram.largest;
+    }
+
+    JsonObject failures = doc["allocFailures"].to<JsonObject>();
+    failures["count"] = s.allocFailures;
+    if (s.allocFailures > 0)
+    {
+        failures["lastSize"] = s.lastFailedSize;
+        failures["lastCaps"] = s.lastFailedCaps;
+    }
+
+    doc["tasks"] = s.taskTotal;
+    JsonObject tasks = doc["stackFree"].to<JsonObject>();
+    for (int i = 0; i < s.taskCount; i++)
+        tasks[(const char *)s.tasks[i].name] = s.tasks[i].stackFree; // copied, the snapshot may be a local
+}
+
+bool memoryPublish(const MemorySnapshot &s)
+{
+    if (!mqttConnected || (appInstanceID < 0))
+        return false;
+
+    JsonDocument doc;
+    memoryToJson(s, doc);
+
+    // on the heap, the size grows with the number of tasks
+    size_t len = measureJson(doc);
+    char *payload = (char *)malloc(len + 1);
+    if (payload == NULL)
+        return false;
+    serializeJson(doc, payload, len + 1);
+
+    char topic[64];
+    snprintf(topic, sizeof(topic), "%s/%d/memory", appName, appInstanceID);
+    bool sent = mqttClient.publish(topic, 0, false, payload, len) != 0;
+    free(payload);
+    return sent;
+}
+
+// true when a threshold was crossed in either direction
+bool memoryCheckThresholds(const MemorySnapshot &s)
+{
+    bool changed = false;
+
+    bool low = s.internal.free < MEMORY_WARN_INTERNAL_FREE;
+    if (low != memoryInternalLow)
+    {
+        if (low)
+            Log.warningln("Internal RAM low: %u bytes free (min %u)", s.internal.free, s.internal.minFree);
+        else
+            Log.noticeln("Internal RAM recovered: %u bytes free", s.internal.free);
+        memoryInternalLow = low;
+        changed = true;
+    }
+
+    bool fragmented = s.internal.largest < MEMORY_WARN_INTERNAL_BLOCK;
+    if (fragmented != memoryFragmented)
+    {
+        if (fragmented)
+            Log.warningln("Internal RAM fragmented: largest block %u of %u bytes free", s.internal.largest, s.internal.free);
+        else
+            Log.noticeln("Internal RAM largest block back to %u bytes", s.internal.largest);
+        memoryFragmented = fragmented;
+        changed = true;
+    }
+
+    low = (s.psram.total > 0) && (s.psram.free < MEMORY_WARN_PSRAM_FREE);
+    if (low != memoryPsramLow)
+    {
+        if (low)
+            Log.warningln("PSRAM low: %u bytes free (min %u)", s.psram.free, s.psram.minFree);
+        else
+            Log.noticeln("PSRAM recovered: %u bytes free", s.psram.free);
+        memoryPsramLow = low;
+        changed = true;
+    }
+
+    // high-water marks only ever fall, so each task is reported once
+    for (int i = 0; i < s.taskCount; i++)
+    {
+        if (s.tasks[i].stackFree >= MEMORY_WARN_STACK_FREE)
+            continue;
+
+        bool warned = false;
+        for (int j = 0; j < memoryStackWarnedCount; j++)
+            warned |= strcmp(memoryStackWarned[j], s.tasks[i].name) == 0;
+        if (warned || (memoryStackWarnedCount >= MEMORY_MAX_TASKS))
+            continue;
+
+        Log.warningln("Task %s is close to overflowing its stack: %u bytes never used", s.tasks[i].name, s.tasks[i].stackFree);
+        strlcpy(memoryStackWarned[memoryStackWarnedCount++], s.tasks[i].name, configMAX_TASK_NAME_LEN);
+        changed = true;
+    }
+
+    return changed;
+}
+
+// The timer only wakes this task, so the pass over every task, the logging and the publish
+// never run on (and block) the FreeRTOS timer service task.
+void memoryTelemetryTask(void *pvParameters)
+{
+    (void)pvParameters;
+
+    while (true)
+    {
+        taskWatchdogFeed();
+        if (ulTaskNotifyTake(pdTRUE, TASK_IDLE_WAIT) == 0)
+            continue;
+
+        memorySample(memorySnapshot);
+        memorySamples++;
+
+        bool crossed = memoryCheckThresholds(memorySnapshot);
+        if (crossed || ((MEMORY_PUBLISH_EVERY > 0) && (memorySamples % MEMORY_PUBLISH_EVERY == 0)))
+            memoryPublish(memorySnapshot);
+    }
+}
+
+void memoryTelemetryTick(TimerHandle_t xTimer)
+{
+    (void)xTimer;
+
+    if (memoryTelemetryTaskHandle != NULL)
+        xTaskNotifyGive(memoryTelemetryTaskHandle);
+}
+
+void memoryTelemetryBegin()
+{
+    heap_caps_register_failed_alloc_callback(memoryAllocFailed);
+
+    memorySample(memorySnapshot);
+    memoryCheckThresholds(memorySnapshot);
+
+    startTask(memoryTelemetryTask, "memoryTelemetry", MEMORY_TELEMETRY_STACK_SIZE, NULL, MEMORY_TELEMETRY_PRIORITY,
+              MEMORY_TELEMETRY_CORE, &memoryTelemetryTaskHandle);
+    memoryTelemetryTimer = xTimerCreate("memoryTimer", pdMS_TO_TICKS(MEMORY_SAMPLE_INTERVAL_S * 1000), pdTRUE,
+                                        (void *)0, memoryTelemetryTick);
+    xTimerStart(memoryTelemetryTimer, 0);
+}
+
+#endif // MEMORY_TELEMETRY_H
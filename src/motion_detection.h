@@ -0,0 +1,182 @@
+////////////////////////////////////////////////////////////////////
+/// @file motion_detection.h
+/// @brief Motion detection on the camera's JPEG frames, from their
+/// DC coefficients only
+////////////////////////////////////////////////////////////////////
+
+#ifndef MOTION_DETECTION_H
+#define MOTION_DETECTION_H
+
+#include "framework.h"
+
+#include <JpegMotion.h>
+
+// The capture task offers every frame; MOTION_CHECK_FPS of them a second are copied and handed
+// to the motion task, which runs them through a MotionDetector (see JpegMotion.h). Offering
+// never waits: a frame that arrives while the last one is still being checked is skipped.
+//
+// Motion starts when a frame has MOTION_MIN_CELLS changed cells and ends MOTION_HOLD_SECONDS
+// after the last such frame. The event handler is called on the motion task at both ends, with
+// the frame that started it, and may take its time (save a snapshot, publish an alert).
+
+#ifndef MOTION_GRID_COLS
+#define MOTION_GRID_COLS 20
+#endif
+
+#ifndef MOTION_GRID_ROWS
+#define MOTION_GRID_ROWS 15
+#endif
+
+#ifndef MOTION_CHECK_FPS
+#define MOTION_CHECK_FPS 4
+#endif
+
+#ifndef MOTION_CELL_THRESHOLD
+#define MOTION_CELL_THRESHOLD 20 // brightness change (0..255) that makes a cell count as changed
+#endif
+
+#ifndef MOTION_MIN_CELLS
+#define MOTION_MIN_CELLS 4 // changed cells that make a frame count as motion
+#endif
+
+#ifndef MOTION_LEARN_SHIFT
+#define MOTION_LEARN_SHIFT 4 // the background follows 1/16 of each difference per checked frame
+#endif
+
+#ifndef MOTION_HOLD_SECONDS
+#define MOTION_HOLD_SECONDS 10
+#endif
+
+#ifndef MOTION_FRAME_BYTES
+#define MOTION_FRAME_BYTES (160UL * 1024) // larger frames are not checked
+#endif
+
+#ifndef MOTION_STACK_SIZE
+#define MOTION_STACK_SIZE 4096
+#endif
+
+#ifndef MOTION_PRIORITY
+#define MOTION_PRIORITY TASK_PRIORITY_PROCESSING
+#endif
+
+#ifndef MOTION_CORE
+#define MOTION_CORE TASK_CORE_CAPTURE
+#endif
+
+typedef MotionDetector<MOTION_GRID_COLS, MOTION_GRID_ROWS> CameraMotionDetector;
+
+// started is false when motion ends, jpeg is then NULL
+typedef void (*MotionEventFn)(bool started, uint16_t changedCells, const uint8_t *jpeg, size_t len);
+
+MetricCounter motionFramesChecked("motion_frames_checked_total", "Frames checked for motion");
+MetricCounter motionFramesUnreadable("motion_frames_unreadable_total", "Frames the motion detector could not read");
+MetricCounter motionEvents("motion_events_total", "Times motion started");
+MetricHistogram motionCheckTime("motion_check_seconds", "Time to check one frame for motion");
+
+class MotionDetection
+{
+public:
+    MotionDetection() : m_frame(NULL), m_frameLen(0), m_frameMs(0), m_task(NULL), m_onEvent(NULL),
+                        m_lastOfferMs(0), m_busy(false), m_active(false), m_lastMotionMs(0)
+    {
+        m_detector.setThreshold(MOTION_CELL_THRESHOLD);
+        m_detector.setMinCells(MOTION_MIN_CELLS);
+        m_detector.setLearnShift(MOTION_LEARN_SHIFT);
+    }
+
+    bool begin(MotionEventFn onEvent)
+    {
+        m_onEvent = onEvent;
+
+        m_frame = (uint8_t *)(psramFound() ? ps_malloc(MOTION_FRAME_BYTES) : malloc(MOTION_FRAME_BYTES));
+        if (m_frame == NULL)
+        {
+            Log.errorln("Motion: no memory for the frame buffer");
+            return false;
+        }
+
+        return startTask(motionTask, "motion", MOTION_STACK_SIZE, this, MOTION_PRIORITY, MOTION_CORE, &m_task);
+    }
+
+    bool isReady() { return m_task != NULL; }
+
+    // true from the frame that started motion until MOTION_HOLD_SECONDS after the last one
+    bool isActive() { return m_active; }
+
+    // Zones and thresholds. They are read by the motion task without a lock; a change made
+    // while a frame is being checked may apply to part of it only.
+    CameraMotionDetector &detector() { return m_detector; }
+
+    // from the capture task, for every frame; never waits
+    void offerFrame(const uint8_t *data, size_t len, uint32_t timeMs)
+    {
+        if (m_task == NULL || m_busy || len > MOTION_FRAME_BYTES ||
+            (m_lastOfferMs != 0 && timeMs - m_lastOfferMs < 1000 / MOTION_CHECK_FPS))
+            return;
+        m_lastOfferMs = timeMs;
+
+        memcpy(m_frame, data, len);
+        m_frameLen = len;
+        m_frameMs = timeMs;
+        m_busy = true;
+        xTaskNotifyGive(m_task);
+    }
+
+private:
+    static void motionTask(void *pvParameters)
+    {
+        ((MotionDetection *)pvParameters)->motionLoop();
+    }
+
+    void motionLoop()
+    {
+        while (true)
+        {
+            taskWatchdogFeed();
+            if (ulTaskNotifyTake(pdTRUE, TASK_IDLE_WAIT) == 0)
+                continue;
+
+            uint32_t start = micros();
+            int changed = m_detector.update(m_frame, m_frameLen);
+            motionCheckTime.observe(micros() - start);
+            motionFramesChecked.add();
+
+            if (changed < 0)
+                motionFramesUnreadable.add();
+            else if (m_detector.motion())
+            {
+                m_lastMotionMs = m_frameMs;
+                if (!m_active)
+                {
+                    m_active = true;
+                    motionEvents.add();
+                    Log.infoln("Motion: started, %d cells changed", changed);
+                    if (m_onEvent)
+                        m_onEvent(true, changed, m_frame, m_frameLen);
+                }
+            }
+            else if (m_active && m_frameMs - m_lastMotionMs >= MOTION_HOLD_SECONDS * 1000UL)
+            {
+                m_active = false;
+                Log.infoln("Motion: ended");
+                if (m_onEvent)
+                    m_onEvent(false, 0, NULL, 0);
+            }
+
+            m_busy = false;
+        }
+    }
+
+    CameraMotionDetector m_detector;
+    uint8_t *m_frame;
+    size_t m_frameLen;
+    uint32_t m_frameMs;
+    TaskHandle_t m_task;
+    MotionEventFn m_onEvent;
+    uint32_t m_lastOfferMs; // capture task only
+    volatile bool m_busy;   // m_frame belongs to the motion task while set
+    volatile bool m_active;
+    uint32_t m_lastMotionMs;
+};
+
+#endif // MOTION_DETECTION_H
@@ -0,0 +1,200 @@
+////////////////////////////////////////////////////////////////////
+/// @file mqtt_ingest.h
+/// @brief Reassembles and parses routed MQTT JSON payloads using fixed
+/// buffers only
+////////////////////////////////////////////////////////////////////
+
+#ifndef MQTT_INGEST_H
+#define MQTT_INGEST_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <ArduinoLog.h>
+#include "mqtt_router.h"
+
+// Command payloads are parsed into one JsonDocument whose memory comes from a static pool that is
+// reset before every parse, so steady MQTT traffic never touches (or fragments) the heap. Payloads
+// that AsyncMqttClient hands over in pieces are gathered in a static buffer first. Anything larger
+// than MQTT_INGEST_MAX_PAYLOAD is refused before it is copied. The filter keeps only the fields
+// the handlers read; apps add theirs in app_setup().
+//
+// Everything here runs on the async_tcp task that delivers MQTT messages. A parsed document is
+// only valid until the handler returns.
+
+#ifndef MQTT_INGEST_MAX_PAYLOAD
+#define MQTT_INGEST_MAX_PAYLOAD 2048 // longest command payload accepted
+#endif
+
+#ifndef MQTT_INGEST_POOL_SIZE
+#define MQTT_INGEST_POOL_SIZE 4096 // bytes for the parsed document
+#endif
+
+// bump allocator for ArduinoJson: frees are ignored (except for the newest block, which is also
+// the one ArduinoJson grows and shrinks) and reset() reclaims everything at once
+class MqttJsonPool : public ArduinoJson::Allocator
+{
+public:
+    MqttJsonPool() : m_used(0), m_last(SIZE_MAX), m_peak(0), m_failures(0) {}
+
+    void *allocate(size_t size) override
+    {
+        size_t start = align(m_used);
+        if (start + size > sizeof(m_buf))
+        {
+            m_failures++;
+            return NULL;
+        }
+        m_last = start;
+        m_used = start + size;
+        if (m_used > m_peak)
+            m_peak = m_used;
+        return m_buf + start;
+    }
+
+    void deallocate(void *ptr) override
+    {
+        if ((ptr != NULL) && ((uint8_t *)ptr == m_buf + m_last))
+        {
+            m_used = m_last;
+            m_last = SIZE_MAX;
+        }
+    }
+
+    void *reallocate(void *ptr, size_t newSize) override
+    {
+        if (ptr == NULL)
+            return allocate(newSize);
+
+        size_t offset = (uint8_t *)ptr - m_buf;
+        if (offset == m_last)
+        {
+            if (offset + newSize > sizeof(m_buf))
+            {
+                m_failures++;
+                return NULL;
+            }
+            m_used = offset + newSize;
+            if (m_used > m_peak)
+                m_peak = m_used;
+            return ptr;
+        }
+
+        // an older block: move it (the old size is unknown, but never more than what follows it)
+        void *moved = allocate(newSize);
+        if (moved != NULL)
+            memcpy(moved, ptr, (newSize < m_last - offset) ? newSize : m_last - offset);
+        return moved;
+    }
+
+    void reset()
+    {
+        m_used = 0;
+        m_last = SIZE_MAX;
+    }
+
+    size_t peak() { return m_peak; }
+    uint32_t failures() { return m_failures; }
+
+private:
+    static size_t align(size_t n) { return (n + alignof(max_align_t) - 1) & ~(alignof(max_align_t) - 1); }
+
+    alignas(max_align_t) uint8_t m_buf[MQTT_INGEST_POOL_SIZE];
+    size_t m_used;
+    size_t m_last; // offset of the newest block, SIZE_MAX if it was freed
+    size_t m_peak;
+    uint32_t m_failures;
+};
+
+class MqttIngest
+{
+public:
+    MqttIngest() : m_doc(&m_pool), m_assembling(false), m_received(0), m_total(0), m_rejected(0) {}
+
+    // fields kept when parsing, anything else in a payload is skipped without being stored
+    JsonDocument &filter() { return m_filter; }
+
+    // Feeds one AsyncMqttClient delivery that matched a route. Returns true and points msg at
+    // the whole payload once it is complete, false while pieces are still missing or when the
+    // payload was refused.
+    bool assemble(MqttMessage &msg)
+    {
+        if (msg.total > MQTT_INGEST_MAX_PAYLOAD)
+        {
+            if (msg.index == 0)
+            {
+                m_rejected++;
+                Log.warningln("MQTT payload on %s is %u bytes, over the %u byte limit, ignored",
+                              msg.topic, msg.total, MQTT_INGEST_MAX_PAYLOAD);
+            }
+            m_assembling = false;
+            return false;
+        }
+
+        if ((msg.index == 0) && (msg.len == msg.total))
+        {
+            // the usual case: the whole payload is already in the client's buffer
+            m_assembling = false;
+            return true;
+        }
+
+        if (msg.index == 0)
+        {
+            m_assembling = true;
+            m_received = 0;
+            m_total = msg.total;
+        }
+
+        if (!m_assembling || (msg.index != m_received) || (msg.total != m_total) ||
+            (m_received + msg.len > m_total))
+        {
+            // a piece out of order, or of a message whose start we never saw
+            m_assembling = false;
+            return false;
+        }
+
+        memcpy(m_payload + m_received, msg.payload, msg.len);
+        m_received += msg.len;
+        if (m_received < m_total)
+            return false;
+
+        m_assembling = false;
+        msg.payload = m_payload;
+        msg.len = m_total;
+        msg.index = 0;
+        return true;
+    }
+
+    // parses a complete payload into the pooled document, NULL (logged) if it is not valid JSON
+    JsonDocument *parse(const MqttMessage &msg)
+    {
+        m_doc.clear();
+        m_pool.reset();
+
+        DeserializationError error = m_filter.isNull()
+                                         ? deserializeJson(m_doc, msg.payload, msg.len)
+                                         : deserializeJson(m_doc, msg.payload, msg.len,
+                                                           DeserializationOption::Filter(m_filter));
+        if (error)
+        {
+            Log.errorln("deserializeJson() on %s failed: %s", msg.topic, error.c_str());
+            return NULL;
+        }
+        return &m_doc;
+    }
+
+    size_t poolPeak() { return m_pool.peak(); }
+    uint32_t poolFailures() { return m_pool.failures(); }
+    uint32_t rejected() { return m_rejected; }
+
+private:
+    MqttJsonPool m_pool;
+    JsonDocument m_doc;
+    JsonDocument m_filter; // built once at startup, on the heap
+    char m_payload[MQTT_INGEST_MAX_PAYLOAD];
+    bool m_assembling;
+    size_t m_received;
+    size_t m_total;
+    uint32_t m_rejected;
+};
+
+#endif // MQTT_INGEST_H
@@ -0,0 +1,305 @@
+////////////////////////////////////////////////////////////////////
+/// @file mqtt_router.h
+/// @brief Routes incoming MQTT messages to handlers through a trie of
+/// subscribed topic patterns
+////////////////////////////////////////////////////////////////////
+
+#ifndef MQTT_ROUTER_H
+#define MQTT_ROUTER_H
+
+#include <Arduino.h>
+#include <AsyncMqttClient.h>
+#include <ArduinoLog.h>
+
+// Patterns (which may use the + and # wildcards) are compiled into a trie of topic levels when
+// they are registered. An incoming topic is then matched in a single left to right pass. Every
+// trie branch that could still match is followed at the same time, so no topic is copied or
+// tokenised and nothing is parsed for messages that no route wants. All storage is fixed size.
+
+#ifndef MQTT_ROUTER_MAX_ROUTES
+#define MQTT_ROUTER_MAX_ROUTES 16 // at most 32, matches are collected in a bitmask
+#endif
+
+#ifndef MQTT_ROUTER_MAX_NODES
+#define MQTT_ROUTER_MAX_NODES 48
+#endif
+
+#ifndef MQTT_ROUTER_MAX_LABEL
+#define MQTT_ROUTER_MAX_LABEL 31 // longest literal topic level in a pattern
+#endif
+
+#ifndef MQTT_ROUTER_MAX_LEVELS
+#define MQTT_ROUTER_MAX_LEVELS 10 // deeper topics only reach the # routes that matched above this depth
+#endif
+
+#ifndef MQTT_ROUTER_MAX_BRANCHES
+#define MQTT_ROUTER_MAX_BRANCHES 8 // trie branches followed at once (literal and + per level)
+#endif
+
+// one topic level, pointing into the topic string received from the client
+struct MqttTopicLevel
+{
+    const char *ptr;
+    uint8_t len;
+
+    bool equals(const char *s) const { return (strncmp(ptr, s, len) == 0) && (s[len] == '\0'); }
+};
+
+struct MqttMessage
+{
+    const char *topic;
+    MqttTopicLevel levels[MQTT_ROUTER_MAX_LEVELS];
+    uint8_t levelCount;
+    const char *payload; // not null terminated
+    size_t len;
+    size_t index; // offset of this piece when the client delivers a large payload in pieces
+    size_t total;
+    AsyncMqttClientMessageProperties properties;
+};
+
+static_assert(MQTT_ROUTER_MAX_ROUTES <= 32, "MQTT_ROUTER_MAX_ROUTES must fit the match bitmask");
+
+typedef void (*MqttRouteHandler)(const MqttMessage &msg);
+
+class MqttRouter
+{
+public:
+    MqttRouter() { clear(); }
+
+    void clear()
+    {
+        m_nodeCount = 1;
+        m_routeCount = 0;
+        resetNode(0);
+    }
+
+    // registers handler for pattern, false if the pattern is invalid or the tables are full
+    bool on(const char *pattern, MqttRouteHandler handler)
+    {
+        if ((m_routeCount >= MQTT_ROUTER_MAX_ROUTES) || (pattern == NULL) || (handler == NULL))
+        {
+            Log.errorln("MQTT route %s not added, route table full", pattern ? pattern : "(null)");
+            return false;
+        }
+
+        int16_t node = 0;
+        const char *p = pattern;
+        while (true)
+        {
+            const char *end = strchr(p, '/');
+            size_t len = end ? (size_t)(end - p) : strlen(p);
+
+            if ((len == 1) && (*p == '#'))
+            {
+                if (end != NULL)
+                    return invalidPattern(pattern); // # must be the last level
+                if (m_nodes[node].hashRoute >= 0)
+                    return invalidPattern(pattern);
+                m_nodes[node].hashRoute = m_routeCount;
+                break;
+            }
+
+            node = (len == 1) && (*p == '+') ? plusChild(node) : literalChild(node, p, len);
+            if (node < 0)
+                return invalidPattern(pattern);
+
+            if (end == NULL)
+            {
+                if (m_nodes[node].route >= 0)
+                    return invalidPattern(pattern);
+                m_nodes[node].route = m_routeCount;
+                break;
+            }
+            p = end + 1;
+        }
+
+        m_handlers[m_routeCount++] = handler;
+        Log.verboseln("MQTT route %s added", pattern);
+        return true;
+    }
+
+    // AsyncMqttClient onMessage callback body, returns the number of handlers called
+    int dispatch(const char *topic, const char *payload, AsyncMqttClientMessageProperties properties,
+                 size_t len, size_t index, size_t total)
+    {
+        MqttMessage msg;
+        msg.payload = payload;
+        msg.len = len;
+        msg.index = index;
+        msg.total = total;
+        msg.properties = properties;
+
+        return dispatch(match(topic, msg), msg);
+    }
+
+    // matches topic against the routes, filling in msg.topic and msg.levels. Returns a bitmask
+    // of the matching routes for dispatch(), 0 if no route wants the message.
+    uint32_t match(const char *topic, MqttMessage &msg)
+    {
+        msg.topic = topic;
+        msg.levelCount = 0;
+
+        int16_t branches[MQTT_ROUTER_MAX_BRANCHES];
+        int16_t nextBranches[MQTT_ROUTER_MAX_BRANCHES];
+        int branchCount = 1;
+        branches[0] = 0;
+        uint32_t matched = 0;
+
+        // topics starting with $ (broker internals) are never matched by a leading wildcard
+        bool system = (topic[0] == '$');
+
+        const char *p = topic;
+        while (true)
+        {
+            const char *end = strchr(p, '/');
+            size_t segLen = end ? (size_t)(end - p) : strlen(p);
+
+            if ((msg.levelCount >= MQTT_ROUTER_MAX_LEVELS) || (segLen > 0xFF))
+            {
+                // a # that matched, here or above, still gets it, with the levels split so far
+                for (int b = 0; !(system && (msg.levelCount == 0)) && (b < branchCount); b++)
+                {
+                    if (m_nodes[branches[b]].hashRoute >= 0)
+                        matched |= 1UL << m_nodes[branches[b]].hashRoute;
+                }
+                if (matched == 0)
+                    Log.noticeln("MQTT topic %s too deep, ignored", topic);
+                return matched;
+            }
+            msg.levels[msg.levelCount].ptr = p;
+            msg.levels[msg.levelCount].len = segLen;
+            bool wildcardsAllowed = !(system && (msg.levelCount == 0));
+            msg.levelCount++;
+
+            int nextCount = 0;
+            for (int b = 0; b < branchCount; b++)
+            {
+                const MqttTrieNode &node = m_nodes[branches[b]];
+                if (wildcardsAllowed)
+                {
+                    if (node.hashRoute >= 0)
+                        matched |= 1UL << node.hashRoute;
+                    if ((node.plusChild >= 0) && (nextCount < MQTT_ROUTER_MAX_BRANCHES))
+                        nextBranches[nextCount++] = node.plusChild;
+                }
+
+                for (int16_t c = node.firstChild; c >= 0; c = m_nodes[c].nextSibling)
+                {
+                    if ((m_nodes[c].labelLen == segLen) && (memcmp(m_nodes[c].label, p, segLen) == 0))
+                    {
+                        if (nextCount < MQTT_ROUTER_MAX_BRANCHES)
+                            nextBranches[nextCount++] = c;
+                        break;
+                    }
+                }
+            }
+
+            memcpy(branches, nextBranches, nextCount * sizeof(int16_t));
+            branchCount = nextCount;
+            // once nothing can match any more stop, unless a # matched and wants all the levels
+            if ((end == NULL) || ((branchCount == 0) && (matched == 0)))
+                break;
+            p = end + 1;
+        }
+
+        // the whole topic was consumed: exact ends, and "a/#" also matches "a" itself
+        for (int b = 0; b < branchCount; b++)
+        {
+            const MqttTrieNode &node = m_nodes[branches[b]];
+            if (node.route >= 0)
+                matched |= 1UL << node.route;
+            if (node.hashRoute >= 0)
+                matched |= 1UL << node.hashRoute;
+        }
+        return matched;
+    }
+
+    // calls the handlers of the routes in matched, in the order they were registered
+    int dispatch(uint32_t matched, const MqttMessage &msg)
+    {
+        int called = 0;
+        for (int r = 0; (r < m_routeCount) && (matched != 0); r++)
+        {
+            if (matched & (1UL << r))
+            {
+                matched &= ~(1UL << r);
+                m_handlers[r](msg);
+                called++;
+            }
+        }
+        return called;
+    }
+
+private:
+    struct MqttTrieNode
+    {
+        char label[MQTT_ROUTER_MAX_LABEL + 1];
+        uint8_t labelLen;
+        int16_t firstChild; // literal children, linked through nextSibling
+        int16_t nextSibling;
+        int16_t plusChild;
+        int8_t route;     // route for topics ending at this node
+        int8_t hashRoute; // route for this node's "/#"
+    };
+
+    void resetNode(int16_t n)
+    {
+        m_nodes[n].label[0] = '\0';
+        m_nodes[n].labelLen = 0;
+        m_nodes[n].firstChild = -1;
+        m_nodes[n].nextSibling = -1;
+        m_nodes[n].plusChild = -1;
+        m_nodes[n].route = -1;
+        m_nodes[n].hashRoute = -1;
+    }
+
+    int16_t newNode()
+    {
+        if (m_nodeCount >= MQTT_ROUTER_MAX_NODES)
+            return -1;
+        resetNode(m_nodeCount);
+        return m_nodeCount++;
+    }
+
+    int16_t plusChild(int16_t parent)
+    {
+        if (m_nodes[parent].plusChild < 0)
+            m_nodes[parent].plusChild = newNode();
+        return m_nodes[parent].plusChild;
+    }
+
+    int16_t literalChild(int16_t parent, const char *label, size_t len)
+    {
+        if ((len > MQTT_ROUTER_MAX_LABEL) || (memchr(label, '+', len) != NULL) || (memchr(label, '#', len) != NULL))
+            return -1;
+
+        for (int16_t c = m_nodes[parent].firstChild; c >= 0; c = m_nodes[c].nextSibling)
+        {
+            if ((m_nodes[c].labelLen == len) && (memcmp(m_nodes[c].label, label, len) == 0))
+                return c;
+        }
+
+        int16_t c = newNode();
+        if (c < 0)
+            return -1;
+        memcpy(m_nodes[c].label, label, len);
+        m_nodes[c].label[len] = '\0';
+        m_nodes[c].labelLen = len;
+        m_nodes[c].nextSibling = m_nodes[parent].firstChild;
+        m_nodes[parent].firstChild = c;
+        return c;
+    }
+
+    bool invalidPattern(const char *pattern)
+    {
+        Log.errorln("MQTT route %s not added, invalid, duplicate or out of nodes", pattern);
+        return false;
+    }
+
+    MqttTrieNode m_nodes[MQTT_ROUTER_MAX_NODES];
+    int16_t m_nodeCount;
+    MqttRouteHandler m_handlers[MQTT_ROUTER_MAX_ROUTES];
+    int8_t m_routeCount;
+};
+
+#endif // MQTT_ROUTER_H
@@ -0,0 +1,475 @@
+////////////////////////////////////////////////////////////////////
+/// @file ota_update.h
+/// @brief Streams a firmware image from the HTTP server straight into
+/// the OTA partition
+////////////////////////////////////////////////////////////////////
+
+#ifndef OTA_UPDATE_H
+#define OTA_UPDATE_H
+
+#include "framework.h"
+
+#include <mbedtls/sha256.h>
+#include <esp_ota_ops.h>
+#include <DeltaPatch.h>
+
+// The response body is read in OTA_CHUNK_SIZE blocks and each block goes straight to
+// Update.write() and into a running SHA-256, so nothing is staged on LittleFS. When the
+// connection drops the download carries on with a Range request from the last byte written.
+// The image is only marked bootable if its hash matches <image>.sha256 from the server.
+// The server must send a Content-Length: the body is read raw, so chunked transfer encoding is
+// not decoded, and without a length a connection that drops early cannot be told from the end.
+
+#ifndef OTA_CHUNK_SIZE
+#define OTA_CHUNK_SIZE 4096
+#endif
+
+#ifndef OTA_MAX_RESUMES
+#define OTA_MAX_RESUMES 5 // reconnects after a dropped download before giving up
+#endif
+
+#ifndef OTA_IDLE_TIMEOUT_MS
+#define OTA_IDLE_TIMEOUT_MS 10000 // no data for this long counts as a dropped connection
+#endif
+
+#ifndef OTA_PROGRESS_STEP
+#define OTA_PROGRESS_STEP 10 // percent between progress reports
+#endif
+
+#ifndef OTA_REQUIRE_SHA256
+#define OTA_REQUIRE_SHA256 0 // 1 = refuse images published without a .sha256 file
+#endif
+
+enum OtaResult
+{
+    OTA_OK,
+    OTA_ERR_CONNECT,  // server unreachable, unexpected HTTP status or no Content-Length
+    OTA_ERR_NO_HASH,  // OTA_REQUIRE_SHA256 and no .sha256 on the server
+    OTA_ERR_BEGIN,    // image does not fit the OTA partition
+    OTA_ERR_WRITE,    // flash write failed
+    OTA_ERR_DROPPED,  // ran out of resume attempts
+    OTA_ERR_HASH,     // SHA-256 mismatch, image discarded
+    OTA_ERR_FINALIZE, // Update.end() rejected the image
+    OTA_ERR_NO_MEMORY
+};
+
+// called every OTA_PROGRESS_STEP percent and once at the end, where total is 0 if the update failed
+typedef void (*OtaProgressHandler)(const char *fileName, size_t done, size_t total);
+
+const char *otaResultString(OtaResult result)
+{
+    switch (result)
+    {
+    case OTA_OK:
+        return "ok";
+    case OTA_ERR_CONNECT:
+        return "connect failed";
+    case OTA_ERR_NO_HASH:
+        return "no sha256";
+    case OTA_ERR_BEGIN:
+        return "does not fit";
+    case OTA_ERR_WRITE:
+        return "flash write failed";
+    case OTA_ERR_DROPPED:
+        return "download dropped";
+    case OTA_ERR_HASH:
+        return "sha256 mismatch";
+    case OTA_ERR_FINALIZE:
+        return "image rejected";
+    case OTA_ERR_NO_MEMORY:
+        return "out of memory";
+    }
+    return "unknown";
+}
+
+int hexNibble(char c)
+{
+    if ((c >= '0') && (c <= '9'))
+        return c - '0';
+    if ((c >= 'a') && (c <= 'f'))
+        return c - 'a' + 10;
+    if ((c >= 'A') && (c <= 'F'))
+        return c - 'A' + 10;
+    return -1;
+}
+
+// fetches url (a sha256sum style "<64 hex digits>  name" file) into digest
+bool otaFetchSha256(const String &url, uint8_t digest[32])
+{
+    String body;
+    if (webGet(url, body) != HTTP_CODE_OK)
+        return false;
+
+    body.trim();
+    if (body.length() < 64)
+        return false;
+
+    for (int i = 0; i < 32; i++)
+    {
+        int hi = hexNibble(body[2 * i]);
+        int lo = hexNibble(body[2 * i + 1]);
+        if ((hi < 0) || (lo < 0))
+            return false;
+        digest[i] = (hi << 4) | lo;
+    }
+    return true;
+}
+
+// receives the body of an OTA download in order; total is the body size
+typedef bool (*OtaSink)(void *ctx, const uint8_t *data, size_t len, size_t total);
+
+// Streams the body of url into sink, resuming dropped connections. Returns OTA_OK once the
+// whole body has been delivered, OTA_ERR_WRITE if the sink refused a block.
+OtaResult otaDownload(const String &url, const char *fileName, OtaSink sink, void *ctx, OtaProgressHandler progress)
+{
+    uint8_t *buf = (uint8_t *)malloc(OTA_CHUNK_SIZE);
+    if (buf == NULL)
+        return OTA_ERR_NO_MEMORY;
+
+    OtaResult result = OTA_ERR_DROPPED;
+    size_t done = 0;
+    size_t total = 0; // 0 until the first response
+    int nextReport = 0;
+    const char *headerKeys[] = {"Content-Range"};
+
+    for (int attempt = 0; attempt <= OTA_MAX_RESUMES; attempt++)
+    {
+        if (attempt > 0)
+        {
+            Log.warningln("OTA download dropped at %u of %u bytes, resuming (%d/%d)", done, total, attempt,
+                          OTA_MAX_RESUMES);
+            for (int s = 0; s < attempt; s++)
+            {
+                taskWatchdogFeed();
+                delay(1000);
+            }
+        }
+
+        WiFiClient client;
+        HTTPClient http;
+        if (!http.begin(client, HTTP_SERVER, HTTP_PORT, url))
+            continue;
+
+        http.collectHeaders(headerKeys, 1);
+        if (done > 0)
+            http.addHeader("Range", "bytes=" + String(done) + "-");
+
+        int httpCode = http.GET();
+        size_t skip = 0;
+        if ((done > 0) && (httpCode == HTTP_CODE_PARTIAL_CONTENT))
+        {
+            // the server must resume exactly where we stopped
+            String range = http.header("Content-Range");
+            if (!range.startsWith("bytes " + String(done) + "-"))
+            {
+                Log.errorln("OTA resume got range %s, expected %u onwards", range.c_str(), done);
+                http.end();
+                result = OTA_ERR_CONNECT;
+                break;
+            }
+        }
+        else if (httpCode == HTTP_CODE_OK)
+        {
+            // first request, or a server that ignores Range: skip what we already have
+            skip = done;
+            if (total == 0)
+            {
+                int size = http.getSize(); // -1 for chunked bodies too
+                if (size <= 0)
+                {
+                    Log.errorln("OTA %s has no Content-Length, not downloading it", fileName);
+                    http.end();
+                    result = OTA_ERR_CONNECT;
+                    break;
+                }
+                total = size;
+                Log.infoln("OTA downloading %s (%u bytes)", fileName, total);
+            }
+        }
+        else
+        {
+            Log.errorln("OTA GET %s failed: %d %s", url.c_str(), httpCode, http.errorToString(httpCode).c_str());
+            http.end();
+            if (httpCode > 0)
+            {
+                result = OTA_ERR_CONNECT;
+                break;
+            }
+            continue;
+        }
+
+        WiFiClient *stream = http.getStreamPtr();
+        uint32_t lastData = millis();
+        bool writeFailed = false;
+        while (done < total)
+        {
+            taskWatchdogFeed(); // the loop task may be the one downloading, and it is watched
+            size_t avail = stream->available();
+            if (avail == 0)
+            {
+                if (!stream->connected() || (millis() - lastData > OTA_IDLE_TIMEOUT_MS))
+                    break;
+                delay(1);
+                continue;
+            }
+
+            size_t want = minimum(avail, (size_t)OTA_CHUNK_SIZE);
+            if (skip > 0)
+                want = minimum(want, skip);
+            else
+                want = minimum(want, total - done);
+
+            int n = stream->read(buf, want);
+            if (n <= 0)
+                continue;
+            lastData = millis();
+
+            if (skip > 0)
+            {
+                skip -= n;
+                continue;
+            }
+
+            if (!sink(ctx, buf, n, total))
+            {
+                writeFailed = true;
+                break;
+            }
+            done += n;
+
+            if ((progress != NULL) && ((int)(done * 100 / total) >= nextReport))
+            {
+                progress(fileName, done, total);
+                nextReport = (done * 100 / total) + OTA_PROGRESS_STEP;
+            }
+        }
+        http.end();
+
+        if (writeFailed)
+        {
+            result = OTA_ERR_WRITE;
+            break;
+        }
+        if (done == total)
+        {
+            result = OTA_OK;
+            break;
+        }
+    }
+
+    free(buf);
+    if ((progress != NULL) && (result != OTA_OK))
+        progress(fileName, done, 0);
+    return result;
+}
+
+// writes an image into the OTA partition while hashing it
+struct OtaImageWriter
+{
+    mbedtls_sha256_context sha;
+    size_t size; // expected image size, 0 if unknown
+    size_t written;
+    bool started;
+    bool failed;
+};
+
+void otaImageInit(OtaImageWriter &w, size_t size)
+{
+    mbedtls_sha256_init(&w.sha);
+    mbedtls_sha256_starts(&w.sha, 0);
+    w.size = size;
+    w.written = 0;
+    w.started = false;
+    w.failed = false;
+}
+
+bool otaImageWrite(OtaImageWriter &w, const uint8_t *data, size_t len)
+{
+    if (!w.started)
+    {
+        if (!Update.begin((w.size > 0) ? w.size : UPDATE_SIZE_UNKNOWN))
+        {
+            Log.errorln("OTA cannot begin update of %u bytes: %s", w.size, Update.errorString());
+            w.failed = true;
+            return false;
+        }
+        w.started = true;
+    }
+
+    if (Update.write((uint8_t *)data, len) != len)
+    {
+        Log.errorln("OTA flash write failed at %u: %s", w.written, Update.errorString());
+        w.failed = true;
+        return false;
+    }
+    mbedtls_sha256_update(&w.sha, data, len);
+    w.written += len;
+    return true;
+}
+
+// checks the hash (when expected is given) and marks the image bootable, or discards it
+OtaResult otaImageFinish(OtaImageWriter &w, const uint8_t *expected, OtaResult result, const char *fileName)
+{
+    uint8_t actual[32];
+    mbedtls_sha256_finish(&w.sha, actual);
+    mbedtls_sha256_free(&w.sha);
+
+    if ((result == OTA_ERR_WRITE) && w.failed && !w.started)
+        result = OTA_ERR_BEGIN;
+
+    if ((result == OTA_OK) && (expected != NULL) && (memcmp(actual, expected, sizeof(actual)) != 0))
+    {
+        Log.errorln("OTA %s failed verification, discarding", fileName);
+        result = OTA_ERR_HASH;
+    }
+
+    if (w.started)
+    {
+        if (result != OTA_OK)
+            Update.abort();
+        else if (!Update.end(true))
+        {
+            Log.errorln("OTA image rejected: %s", Update.errorString());
+            result = OTA_ERR_FINALIZE;
+        }
+    }
+
+    Log.infoln("OTA %s: %s (%u bytes written)", fileName, otaResultString(result), w.written);
+    return result;
+}
+
+bool otaImageSink(void *ctx, const uint8_t *data, size_t len, size_t total)
+{
+    OtaImageWriter *w = (OtaImageWriter *)ctx;
+    if (!w->started)
+        w->size = total;
+    return otaImageWrite(*w, data, len);
+}
+
+// Downloads the full image url into the inactive OTA partition. Returns OTA_OK once the image is
+// verified and set to boot; on any failure the partially written image is discarded.
+OtaResult otaStreamFirmware(const String &url, const char *fileName, OtaProgressHandler progress)
+{
+    TRACE_SCOPE("otaStreamFirmware()");
+
+    uint8_t expected[32];
+    bool haveHash = otaFetchSha256(url + ".sha256", expected);
+    if (!haveHash)
+    {
+        Log.warningln("No %s.sha256 on the server, image cannot be verified", fileName);
+        if (OTA_REQUIRE_SHA256)
+        {
+            return OTA_ERR_NO_HASH;
+        }
+    }
+
+    OtaImageWriter image;
+    otaImageInit(image, 0);
+    OtaResult result = otaDownload(url, fileName, otaImageSink, &image, progress);
+    result = otaImageFinish(image, haveHash ? expected : NULL, result, fileName);
+
+    return result;
+}
+
+#pragma region Delta Updates
+
+// A delta patch (tools/make_delta.py) rebuilds the new image from the one we are running, so
+// only the differences cross the network. The patch is applied as it streams in: old bytes are
+// read back from the running partition and the output goes through the same hashing writer as a
+// full image, checked against the digest in the patch header.
+
+struct OtaDeltaContext
+{
+    const esp_partition_t *running;
+    OtaImageWriter image;
+    DeltaPatcher *patcher;
+    DeltaResult state;
+};
+
+bool otaDeltaReadOld(void *ctx, uint32_t offset, uint8_t *buf, size_t len)
+{
+    OtaDeltaContext *d = (OtaDeltaContext *)ctx;
+    return esp_partition_read(d->running, offset, buf, len) == ESP_OK;
+}
+
+bool otaDeltaWriteNew(void *ctx, const uint8_t *buf, size_t len)
+{
+    return otaImageWrite(((OtaDeltaContext *)ctx)->image, buf, len);
+}
+
+// refuses patches made against a different build than the one running
+bool otaDeltaCheckHeader(void *ctx, const DeltaHeader &header)
+{
+    OtaDeltaContext *d = (OtaDeltaContext *)ctx;
+    if (header.oldSize > d->running->size)
+    {
+        Log.errorln("Delta expects a %u byte base image, partition holds %u", header.oldSize, d->running->size);
+        return false;
+    }
+
+    mbedtls_sha256_context sha;
+    uint8_t block[512];
+    uint8_t digest[32];
+    mbedtls_sha256_init(&sha);
+    mbedtls_sha256_starts(&sha, 0);
+    for (uint32_t offset = 0; offset < header.oldSize; offset += sizeof(block))
+    {
+        if (offset % (64 * 1024) == 0)
+            taskWatchdogFeed();
+        uint32_t n = minimum((uint32_t)sizeof(block), header.oldSize - offset);
+        if (esp_partition_read(d->running, offset, block, n) != ESP_OK)
+            break;
+        mbedtls_sha256_update(&sha, block, n);
+    }
+    mbedtls_sha256_finish(&sha, digest);
+    mbedtls_sha256_free(&sha);
+
+    if (memcmp(digest, header.oldSha256, sizeof(digest)) != 0)
+    {
+        Log.errorln("Delta was made for a different base image");
+        return false;
+    }
+
+    d->image.size = header.newSize;
+    return true;
+}
+
+bool otaDeltaSink(void *ctx, const uint8_t *data, size_t len, size_t total)
+{
+    OtaDeltaContext *d = (OtaDeltaContext *)ctx;
+    (void)total;
+
+    d->state = d->patcher->feed(data, len);
+    if ((d->state != DELTA_MORE) && (d->state != DELTA_DONE))
+    {
+        Log.errorln("Delta patch failed at output byte %u: error %d", d->patcher->written(), d->state);
+        return false;
+    }
+    return true;
+}
+
+OtaResult otaStreamDelta(const String &url, const char *fileName, OtaProgressHandler progress)
+{
+    TRACE_SCOPE("otaStreamDelta()");
+
+    OtaDeltaContext d;
+    d.running = esp_ota_get_running_partition();
+    d.state = DELTA_MORE;
+    otaImageInit(d.image, 0);
+    d.patcher = new DeltaPatcher(otaDeltaReadOld, otaDeltaWriteNew, &d, otaDeltaCheckHeader);
+
+    OtaResult result = otaDownload(url, fileName, otaDeltaSink, &d, progress);
+    if ((result == OTA_OK) && (d.state != DELTA_DONE))
+    {
+        Log.errorln("Delta patch ended early, %u bytes produced", d.patcher->written());
+        result = OTA_ERR_DROPPED;
+    }
+    result = otaImageFinish(d.image, d.patcher->header().newSha256, result, fileName);
+    delete d.patcher;
+
+    return result;
+}
+
+#pragma endregion
+
+#endif // OTA_UPDATE_H
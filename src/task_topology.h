@@ -0,0 +1,125 @@
+////////////////////////////////////////////////////////////////////
+/// @file task_topology.h
+/// @brief Which core and priority each task runs at, and the task
+/// watchdog that watches them
+////////////////////////////////////////////////////////////////////
+
+#ifndef TASK_TOPOLOGY_H
+#define TASK_TOPOLOGY_H
+
+#include <Arduino.h>
+#include <ArduinoLog.h>
+#include <esp_task_wdt.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// The Wi-Fi driver and lwIP run on core 0 at priorities 23 and 18; the Arduino loop runs on
+// core 1 at priority 1. The app's tasks are placed around them by role:
+//
+//   role          core  priority  tasks
+//   capture       1     5         frameCapture
+//   storage       1     3         aviWriter, eventClip
+//   processing    1     2         motion
+//   network       0     3         imagePublish, RTSP
+//   housekeeping  any   1         logRing, the Arduino loop
+//
+// Capture has core 1 to itself at the top, so frames are taken when the sensor has them rather
+// than when the network or a handler lets it; what works on the frames afterwards sits below it
+// on the same core and never holds it up. Sending runs next to the stack it feeds. Every task
+// has a <NAME>_CORE, <NAME>_PRIORITY and stack size of its own, next to its code, that default
+// to its role's.
+//
+// startTask() also subscribes the task to the task watchdog. A watched task calls
+// taskWatchdogFeed() at least every TASK_WDT_TIMEOUT_S, so its waits are bounded by
+// TASK_IDLE_WAIT, and one that ends calls taskWatchdogEnd() before vTaskDelete(NULL). A task
+// that stops making progress then restarts the device (TASK_WDT_PANIC) instead of quietly
+// leaving the camera without a stream.
+
+#ifndef TASK_CORE_CAPTURE
+#define TASK_CORE_CAPTURE 1 // APP_CPU
+#endif
+
+#ifndef TASK_CORE_NETWORK
+#define TASK_CORE_NETWORK 0 // PRO_CPU, with the Wi-Fi driver
+#endif
+
+#ifndef TASK_CORE_HOUSEKEEPING
+#define TASK_CORE_HOUSEKEEPING tskNO_AFFINITY
+#endif
+
+#ifndef TASK_PRIORITY_CAPTURE
+#define TASK_PRIORITY_CAPTURE 5
+#endif
+
+#ifndef TASK_PRIORITY_STORAGE
+#define TASK_PRIORITY_STORAGE 3
+#endif
+
+#ifndef TASK_PRIORITY_PROCESSING
+#define TASK_PRIORITY_PROCESSING 2
+#endif
+
+#ifndef TASK_PRIORITY_NETWORK
+#define TASK_PRIORITY_NETWORK 3
+#endif
+
+#ifndef TASK_PRIORITY_HOUSEKEEPING
+#define TASK_PRIORITY_HOUSEKEEPING 1
+#endif
+
+#ifndef TASK_WDT_TIMEOUT_S
+#define TASK_WDT_TIMEOUT_S 15 // 0 leaves the app's tasks unwatched
+#endif
+
+#ifndef TASK_WDT_PANIC
+#define TASK_WDT_PANIC true // restart when a task misses it, otherwise only log
+#endif
+
+#if TASK_WDT_TIMEOUT_S > 0
+#define TASK_IDLE_WAIT pdMS_TO_TICKS(TASK_WDT_TIMEOUT_S * 500UL) // longest a watched task may block
+#else
+#define TASK_IDLE_WAIT portMAX_DELAY
+#endif
+
+// from setup(), before any watched task starts
+void taskWatchdogBegin()
+{
+#if TASK_WDT_TIMEOUT_S > 0
+    if (esp_task_wdt_init(TASK_WDT_TIMEOUT_S, TASK_WDT_PANIC) != ESP_OK)
+        Log.warningln("Task watchdog not configured");
+#endif
+}
+
+bool startTask(TaskFunction_t fn, const char *name, uint32_t stackSize, void *arg, UBaseType_t priority,
+               BaseType_t core, TaskHandle_t *handle = NULL)
+{
+    TaskHandle_t task = NULL;
+    xTaskCreatePinnedToCore(fn, name, stackSize, arg, priority, &task, core);
+    if (handle != NULL)
+        *handle = task;
+    if (task == NULL)
+    {
+        Log.errorln("Create %s task failed", name);
+        return false;
+    }
+#if TASK_WDT_TIMEOUT_S > 0
+    esp_task_wdt_add(task);
+#endif
+    return true;
+}
+
+inline void taskWatchdogFeed()
+{
+#if TASK_WDT_TIMEOUT_S > 0
+    esp_task_wdt_reset();
+#endif
+}
+
+inline void taskWatchdogEnd()
+{
+#if TASK_WDT_TIMEOUT_S > 0
+    esp_task_wdt_delete(NULL);
+#endif
+}
+
+#endif // TASK_TOPOLOGY_H
@@ -0,0 +1,114 @@
+////////////////////////////////////////////////////////////////////
+/// @file trace.h
+/// @brief Per-task "current function" trace scopes used as the log
+/// prefix
+////////////////////////////////////////////////////////////////////
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <Arduino.h>
+#include <ArduinoLog.h>
+
+// TRACE_SCOPE("name") at the top of a function makes name the calling task's current function
+// until the scope closes, whichever way the function returns, and logs Entering/Exiting at
+// verbose level. The name is a string literal kept in a thread_local pointer (ESP-IDF gives
+// every task its own copy), so nothing is allocated and tasks never see each other's names.
+// printTimestamp() reads it through traceCurrentName().
+//
+// With TRACE_RING_SIZE > 0 every task also keeps its last TRACE_RING_SIZE entries and exits
+// with micros() timestamps, which traceDump() prints for the calling task.
+
+#ifndef TRACE_SCOPES
+#ifdef DISABLE_LOGGING
+#define TRACE_SCOPES 0
+#else
+#define TRACE_SCOPES 1
+#endif
+#endif
+
+#ifndef TRACE_RING_SIZE
+#define TRACE_RING_SIZE 0 // entries per task, each one costs 8 bytes of every task's TLS
+#endif
+
+#if TRACE_SCOPES
+
+thread_local const char *traceName = NULL;
+
+#if TRACE_RING_SIZE > 0
+struct TraceEvent
+{
+    const char *name;
+    uint32_t us; // micros(), lowest bit set for an exit
+};
+
+thread_local TraceEvent traceRing[TRACE_RING_SIZE];
+thread_local uint16_t traceRingNext = 0;
+
+inline void traceRecord(const char *name, bool exit)
+{
+    TraceEvent &e = traceRing[traceRingNext];
+    e.name = name;
+    e.us = (micros() & ~1UL) | (exit ? 1 : 0);
+    traceRingNext = (traceRingNext + 1) % TRACE_RING_SIZE;
+}
+#else
+inline void traceRecord(const char *name, bool exit) {}
+#endif
+
+class TraceScope
+{
+public:
+    explicit TraceScope(const char *name) : m_prev(traceName)
+    {
+        traceName = name;
+        traceRecord(name, false);
+        Log.verboseln("Entering...");
+    }
+
+    ~TraceScope()
+    {
+        Log.verboseln("Exiting...");
+        traceRecord(traceName, true);
+        traceName = m_prev;
+    }
+
+private:
+    TraceScope(const TraceScope &);
+    TraceScope &operator=(const TraceScope &);
+
+    const char *m_prev;
+};
+
+#define TRACE_SCOPE(name) TraceScope traceScope_(name)
+
+inline const char *traceCurrentName() { return traceName ? traceName : ""; }
+
+#else
+
+#define TRACE_SCOPE(name) \
+    do                    \
+    {                     \
+    } while (0)
+
+inline const char *traceCurrentName() { return ""; }
+
+#endif
+
+// prints the calling task's recent entries and exits, oldest first
+inline void traceDump(Print *out)
+{
+#if TRACE_SCOPES && (TRACE_RING_SIZE > 0)
+    for (int i = 0; i < TRACE_RING_SIZE; i++)
+    {
+        const TraceEvent &e = traceRing[(traceRingNext + i) % TRACE_RING_SIZE];
+        if (e.name == NULL)
+            continue;
+        out->printf("%10lu %s %s\n", (unsigned long)(e.us & ~1UL), (e.us & 1) ? "<" : ">", e.name);
+    }
+#else
+    out->println("trace ring disabled (TRACE_RING_SIZE 0)");
+#endif
+}
+
+#endif // TRACE_H
@@ -14,89 +14,586 @@ void handleUpload(AsyncWebServerRequest *request, String filename, size_t index,
 bool checkUserWebAuth(AsyncWebServerRequest *request);
 void notFound(AsyncWebServerRequest *request);
 void initWebServer();
-String processor(const String &var);
-String listFiles(fs::FS &fs, bool ishtml);
+void sendWebAsset(AsyncWebServerRequest *request, const WebAsset &asset, int code = 200);
+void sendStatusJson(AsyncWebServerRequest *request);
+void sendFileList(AsyncWebServerRequest *request, fs::FS &fs);
 
-// list all of the files, if ishtml=true, return html rather than simple text
-String listFiles(fs::FS &fs, bool ishtml)
+#ifndef DIR_LIST_MAX_DEPTH
+#define DIR_LIST_MAX_DEPTH 8 // deepest directory nesting followed by ?recursive=1
+#endif
+
+enum DirListFormat
+{
+    DIR_LIST_HTML,
+    DIR_LIST_TEXT,
+    DIR_LIST_JSON
+};
+
+// Walks a directory with openNextFile() and renders one entry at a time straight into the
+// chunk buffers handed out by the async web server, so the memory used does not depend on
+// how many files there are. Entries before ?offset= are skipped by name only (no open/stat).
+class DirListStream
 {
-    String returnText = "";
-    Log.infoln("Listing files stored on LittleFS");
-    File root = fs.open("/");
-    File foundfile = root.openNextFile();
-    if (ishtml)
+public:
+    DirListStream(fs::FS &fs, const char *path, DirListFormat format, size_t offset, size_t limit, bool recursive)
+        : m_fs(fs), m_depth(-1), m_format(format), m_offset(offset), m_limit(limit), m_recursive(recursive),
+          m_index(0), m_emitted(0), m_more(false), m_state(0), m_lineLen(0), m_linePos(0)
+    {
+        File root = m_fs.open(path);
+        if (root && root.isDirectory())
+            m_dirs[++m_depth] = root;
+    }
+
+    ~DirListStream()
     {
-        returnText += "<table><tr><th align='left'>Name</th><th align='left'>Size</th><th></th><th></th></tr>";
+        while (m_depth >= 0)
+            m_dirs[m_depth--].close();
     }
-    while (foundfile)
+
+    // AwsResponseFiller: fill up to maxLen bytes, 0 ends the response
+    size_t fill(uint8_t *buffer, size_t maxLen)
     {
-        if (ishtml)
+        size_t written = 0;
+        while (written < maxLen)
         {
-            if (foundfile.isDirectory())
+            if (m_linePos == m_lineLen)
             {
-                returnText += "<tr align='left'><td>" + String(foundfile.name()) + "</td><td></td>";
-                returnText += "<td></td>";
-                returnText += "<td></td></tr>";
+                m_lineLen = m_linePos = 0;
+                if (!renderNext())
+                    break;
+                continue;
             }
-            else
+            size_t n = minimum(m_lineLen - m_linePos, maxLen - written);
+            memcpy(buffer + written, m_line + m_linePos, n);
+            m_linePos += n;
+            written += n;
+        }
+        return written;
+    }
+
+private:
+    // renders the next piece of output into m_line, returns false when there is nothing left
+    bool renderNext()
+    {
+        switch (m_state)
+        {
+        case 0:
+            m_state = 1;
+            if (m_format == DIR_LIST_HTML)
+                append("<table><tr><th align='left'>Name</th><th align='left'>Size</th><th></th><th></th></tr>");
+            else if (m_format == DIR_LIST_JSON)
+                appendf("{\"offset\":%u,\"files\":[", (unsigned)m_offset);
+            return true;
+
+        case 1:
+            if (renderEntry())
+                return true;
+            m_state = 2;
+            // fall through
+
+        case 2:
+            m_state = 3;
+            if (m_format == DIR_LIST_HTML)
+            {
+                if (m_more)
+                    appendf("<tr><td colspan='4'><button onclick=\"listPage(%u)\">Next page</button></td></tr>",
+                            (unsigned)(m_offset + m_emitted));
+                append("</table>");
+            }
+            else if (m_format == DIR_LIST_JSON)
+                appendf("],\"count\":%u,\"more\":%s}", (unsigned)m_emitted, m_more ? "true" : "false");
+            else if (m_more)
+                appendf("More: offset=%u\n", (unsigned)(m_offset + m_emitted));
+            return true;
+
+        default:
+            return false;
+        }
+    }
+
+    // renders the next listed entry, false once the walk (or the page) is complete
+    bool renderEntry()
+    {
+        while (m_depth >= 0)
+        {
+            if (m_index < m_offset)
+            {
+                bool isDir = false;
+                String name = m_dirs[m_depth].getNextFileName(&isDir);
+                if (name.length() == 0)
+                {
+                    m_dirs[m_depth--].close();
+                    continue;
+                }
+                m_index++;
+                if (isDir)
+                    descend(m_fs.open(name));
+                continue;
+            }
+
+            if ((m_limit > 0) && (m_emitted >= m_limit))
             {
-                returnText += "<tr align='left'><td>" + String(foundfile.name()) + "</td><td>" + humanReadableSize(foundfile.size()) + "</td>";
-                returnText += "<td><button onclick=\"downloadDeleteButton(\'" + String(foundfile.name()) + "\', \'download\')\">Download</button>";
-                returnText += "<td><button onclick=\"downloadDeleteButton(\'" + String(foundfile.name()) + "\', \'delete\')\">Delete</button></tr>";
+                // one more name tells us whether to offer a next page
+                while ((m_depth >= 0) && !m_more)
+                {
+                    bool isDir = false;
+                    if (m_dirs[m_depth].getNextFileName(&isDir).length() > 0)
+                        m_more = true;
+                    else
+                        m_dirs[m_depth--].close();
+                }
+                return false;
             }
+
+            File entry = m_dirs[m_depth].openNextFile();
+            if (!entry)
+            {
+                m_dirs[m_depth--].close();
+                continue;
+            }
+            m_index++;
+            renderFile(entry);
+            m_emitted++;
+            if (entry.isDirectory())
+                descend(entry);
+            else
+                entry.close();
+            return true;
         }
+        return false;
+    }
+
+    void descend(File dir)
+    {
+        if (m_recursive && dir && (m_depth + 1 < DIR_LIST_MAX_DEPTH))
+            m_dirs[++m_depth] = dir;
         else
+            dir.close();
+    }
+
+    void renderFile(File &entry)
+    {
+        // nested entries show their full path so they can be told apart
+        const char *name = (m_depth > 0) ? entry.path() : entry.name();
+        bool isDir = entry.isDirectory();
+        char size[16] = "";
+        if (!isDir)
+            formatHumanReadableSize(size, sizeof(size), entry.size());
+
+        switch (m_format)
+        {
+        case DIR_LIST_HTML:
+            append("<tr align='left'><td>");
+            appendEscaped(name);
+            appendf("</td><td>%s</td>", size);
+            if (isDir)
+            {
+                append("<td></td><td></td></tr>");
+            }
+            else
+            {
+                append("<td><button onclick=\"downloadDeleteButton('");
+                appendEscaped(name);
+                append("', 'download')\">Download</button><td><button onclick=\"downloadDeleteButton('");
+                appendEscaped(name);
+                append("', 'delete')\">Delete</button></tr>");
+            }
+            break;
+
+        case DIR_LIST_JSON:
+            append((m_emitted > 0) ? ",{\"name\":\"" : "{\"name\":\"");
+            appendEscaped(entry.path());
+            if (isDir)
+                append("\",\"dir\":true}");
+            else
+                appendf("\",\"dir\":false,\"size\":%u}", (unsigned)entry.size());
+            break;
+
+        default:
+            if (isDir)
+                appendf("Dir: %s\n", name);
+            else
+                appendf("File: %s Size: %s\n", name, size);
+            break;
+        }
+    }
+
+    void append(const char *text)
+    {
+        appendf("%s", text);
+    }
+
+    void appendf(const char *fmt, ...)
+    {
+        va_list args;
+        va_start(args, fmt);
+        int n = vsnprintf(m_line + m_lineLen, sizeof(m_line) - m_lineLen, fmt, args);
+        va_end(args);
+        if (n > 0)
+            m_lineLen = minimum(m_lineLen + n, sizeof(m_line) - 1);
+    }
+
+    // file names end up inside html attributes / json strings, keep them from breaking out
+    void appendEscaped(const char *text)
+    {
+        for (const char *c = text; *c && (m_lineLen < sizeof(m_line) - 8); c++)
+        {
+            if (m_format == DIR_LIST_JSON)
+            {
+                if ((*c == '"') || (*c == '\\'))
+                    m_line[m_lineLen++] = '\\';
+                m_line[m_lineLen++] = *c;
+            }
+            else if (*c == '<')
+                append("&lt;");
+            else if (*c == '&')
+                append("&amp;");
+            else if ((*c == '\'') || (*c == '"'))
+                appendf("&#%d;", *c);
+            else
+                m_line[m_lineLen++] = *c;
+        }
+        m_line[m_lineLen] = '\0';
+    }
+
+    fs::FS &m_fs;
+    File m_dirs[DIR_LIST_MAX_DEPTH];
+    int m_depth;
+    DirListFormat m_format;
+    size_t m_offset;
+    size_t m_limit;
+    bool m_recursive;
+    size_t m_index;   // entries walked so far (skipped or listed)
+    size_t m_emitted; // entries listed on this page
+    bool m_more;
+    int m_state; // 0 = header, 1 = entries, 2 = footer, 3 = done
+    char m_line[512];
+    size_t m_lineLen;
+    size_t m_linePos;
+};
+
+// streams a listing of fs as a chunked response
+// query parameters: path=/dir, offset=N, limit=N (0 = all), format=html|text|json, recursive=1
+void sendFileList(AsyncWebServerRequest *request, fs::FS &fs)
+{
+    DirListFormat format = DIR_LIST_HTML;
+    const char *contentType = "text/html";
+    if (request->hasParam("format"))
+    {
+        const String &f = request->getParam("format")->value();
+        if (f == "json")
+        {
+            format = DIR_LIST_JSON;
+            contentType = "application/json";
+        }
+        else if (f == "text")
+        {
+            format = DIR_LIST_TEXT;
+            contentType = "text/plain";
+        }
+    }
+
+    size_t offset = request->hasParam("offset") ? request->getParam("offset")->value().toInt() : 0;
+    size_t limit = request->hasParam("limit") ? request->getParam("limit")->value().toInt() : 0;
+    bool recursive = request->hasParam("recursive") && (request->getParam("recursive")->value() != "0");
+    String path = request->hasParam("path") ? request->getParam("path")->value() : String("/");
+
+    std::shared_ptr<DirListStream> lister =
+        std::make_shared<DirListStream>(fs, path.c_str(), format, offset, limit, recursive);
+
+    AsyncWebServerResponse *response = request->beginChunkedResponse(contentType,
+                                                                      [lister](uint8_t *buffer, size_t maxLen, size_t index) -> size_t
+                                                                      { return lister->fill(buffer, maxLen); });
+    response->addHeader("Cache-Control", "no-store");
+    request->send(response);
+}
+
+#ifndef WEB_ASSET_CACHE_CONTROL
+#define WEB_ASSET_CACHE_CONTROL "private, max-age=604800" // css etc. may be reused for a week without asking
+#endif
+
+// sends one of the gzipped assets from webpages.h
+// answers 304 when the browser already holds the same ETag. html pages are marked no-cache so
+// they are always revalidated (cheap 304) and a new firmware shows up, everything else is cached
+void sendWebAsset(AsyncWebServerRequest *request, const WebAsset &asset, int code)
+{
+    AsyncWebServerResponse *response;
+    const AsyncWebHeader *ifNoneMatch = request->getHeader("If-None-Match");
+
+    if ((code == 200) && ifNoneMatch && (ifNoneMatch->value() == asset.etag))
+    {
+        response = request->beginResponse(304);
+    }
+    else
+    {
+        response = request->beginResponse(code, asset.contentType, asset.data, asset.len);
+        response->addHeader("Content-Encoding", "gzip");
+    }
+
+    response->addHeader("ETag", asset.etag);
+    if (strcmp(asset.contentType, "text/html") == 0)
+        response->addHeader("Cache-Control", "private, no-cache");
+    else
+        response->addHeader("Cache-Control", WEB_ASSET_CACHE_CONTROL);
+    request->send(response);
+}
+
+// the values the admin page used to get through template placeholders
+void sendStatusJson(AsyncWebServerRequest *request)
+{
+    JsonDocument doc;
+    doc["appName"] = appName;
+    doc["firmware"] = FIRMWARE_VERSION;
+    doc["freeSpace"] = humanReadableSize((LittleFS.totalBytes() - LittleFS.usedBytes()));
+    doc["usedSpace"] = humanReadableSize(LittleFS.usedBytes());
+    doc["totalSpace"] = humanReadableSize(LittleFS.totalBytes());
+
+    AsyncResponseStream *response = request->beginResponseStream("application/json");
+    response->addHeader("Cache-Control", "no-store");
+    serializeJson(doc, *response);
+    request->send(response);
+}
+
+#pragma region Web Sessions
+
+// After one successful username/password check the browser gets a random session token
+// (cookie, or "Authorization: Bearer" for scripts). Later requests are authorised by comparing
+// that token against a small fixed table instead of re-checking the credentials every time.
+// All handlers run on the async_tcp task, so the table needs no locking.
+
+#ifndef WEB_SESSION_SLOTS
+#define WEB_SESSION_SLOTS 4 // concurrent logged in browsers/scripts, oldest is dropped
+#endif
+
+#ifndef WEB_SESSION_TTL_MS
+#define WEB_SESSION_TTL_MS (12UL * 60 * 60 * 1000) // tokens expire after 12 hours
+#endif
+
+#define WEB_SESSION_TOKEN_LEN 32 // hex chars, 128 random bits
+
+struct WebSession
+{
+    char token[WEB_SESSION_TOKEN_LEN + 1];
+    uint32_t issuedAt;
+    bool inUse;
+};
+
+WebSession webSessions[WEB_SESSION_SLOTS];
+
+// compares the full length whatever the content so the time taken leaks nothing
+bool sessionTokenEquals(const char *a, const char *b)
+{
+    uint8_t diff = 0;
+    for (int i = 0; i < WEB_SESSION_TOKEN_LEN; i++)
+        diff |= a[i] ^ b[i];
+    return diff == 0;
+}
+
+// finds the token in "Authorization: Bearer <token>" or the "session" cookie
+bool getRequestSessionToken(AsyncWebServerRequest *request, char *token)
+{
+    const char *value = NULL;
+
+    const AsyncWebHeader *auth = request->getHeader("Authorization");
+    if (auth && auth->value().startsWith("Bearer "))
+        value = auth->value().c_str() + 7;
+
+    // only a cookie named session, at the start of the header or after "; ", not xsession=
+    const AsyncWebHeader *cookie = request->getHeader("Cookie");
+    if (!value && cookie)
+    {
+        const char *header = cookie->value().c_str();
+        for (const char *c = header; (c = strstr(c, "session=")) != NULL; c++)
         {
-            returnText += "File: " + String(foundfile.name()) + " Size: " + humanReadableSize(foundfile.size()) + "\n";
+            if ((c == header) || ((c - header >= 2) && (c[-2] == ';') && (c[-1] == ' ')))
+            {
+                value = c + 8;
+                break;
+            }
         }
-        foundfile = root.openNextFile();
     }
-    if (ishtml)
+
+    if (!value)
+        return false;
+
+    for (int i = 0; i < WEB_SESSION_TOKEN_LEN; i++)
     {
-        returnText += "</table>";
+        if (!isxdigit(value[i]))
+            return false;
+        token[i] = value[i];
     }
-    root.close();
-    foundfile.close();
-    return returnText;
+    token[WEB_SESSION_TOKEN_LEN] = '\0';
+    return true;
 }
 
-// parses and processes webpages
-// if the webpage has %SOMETHING% or %SOMETHINGELSE% it will replace those strings with the ones defined
-String processor(const String &var)
+bool checkSessionToken(AsyncWebServerRequest *request)
 {
-    if (var == "FIRMWARE")
+    char token[WEB_SESSION_TOKEN_LEN + 1];
+    if (!getRequestSessionToken(request, token))
+        return false;
+
+    bool match = false;
+    uint32_t now = millis();
+    for (int i = 0; i < WEB_SESSION_SLOTS; i++)
     {
-        return FIRMWARE_VERSION;
+        if (webSessions[i].inUse && (now - webSessions[i].issuedAt > WEB_SESSION_TTL_MS))
+            webSessions[i].inUse = false;
+        if (webSessions[i].inUse && sessionTokenEquals(webSessions[i].token, token))
+            match = true;
     }
+    return match;
+}
 
-    if (var == "FREESPACE")
+const char *issueSessionToken()
+{
+    int slot = 0;
+    uint32_t now = millis();
+    for (int i = 0; i < WEB_SESSION_SLOTS; i++)
     {
-        return humanReadableSize((LittleFS.totalBytes() - LittleFS.usedBytes()));
+        if (!webSessions[i].inUse)
+        {
+            slot = i;
+            break;
+        }
+        if (now - webSessions[i].issuedAt > now - webSessions[slot].issuedAt)
+            slot = i;
     }
 
-    if (var == "USEDSPACE")
+    uint8_t random[WEB_SESSION_TOKEN_LEN / 2];
+    esp_fill_random(random, sizeof(random));
+    for (size_t i = 0; i < sizeof(random); i++)
+        sprintf(&webSessions[slot].token[i * 2], "%02x", random[i]);
+    webSessions[slot].issuedAt = now;
+    webSessions[slot].inUse = true;
+
+    return webSessions[slot].token;
+}
+
+void revokeSessionToken(AsyncWebServerRequest *request)
+{
+    char token[WEB_SESSION_TOKEN_LEN + 1];
+    if (!getRequestSessionToken(request, token))
+        return;
+
+    for (int i = 0; i < WEB_SESSION_SLOTS; i++)
     {
-        return humanReadableSize(LittleFS.usedBytes());
+        if (webSessions[i].inUse && sessionTokenEquals(webSessions[i].token, token))
+            webSessions[i].inUse = false;
     }
+}
+
+#pragma endregion
+
+// the client address costs a String, so only build the line when it will be printed
+void logWebRequest(AsyncWebServerRequest *request, int level, const char *result)
+{
+    if (level > LOG_LEVEL)
+        return;
+
+    String client = request->client()->remoteIP().toString();
+    if (level >= LOG_LEVEL_VERBOSE)
+        Log.verboseln("Client:%s %s %s", client.c_str(), request->url().c_str(), result);
+    else
+        Log.noticeln("Client:%s %s %s", client.c_str(), request->url().c_str(), result);
+}
 
-    if (var == "TOTALSPACE")
+// checks the request and asks the browser for credentials if it fails
+bool authorizeWebRequest(AsyncWebServerRequest *request)
+{
+    if (checkUserWebAuth(request))
     {
-        return humanReadableSize(LittleFS.totalBytes());
+        logWebRequest(request, LOG_LEVEL_VERBOSE, "Auth: Success");
+        return true;
     }
 
-    if (var == "APP_NAME")
+    logWebRequest(request, LOG_LEVEL_NOTICE, "Auth: Failed");
+    request->requestAuthentication();
+    return false;
+}
+
+#pragma region WebSocket Frame Push
+
+#ifdef USE_ESP32_CAM
+
+#ifndef WS_FRAME_INTERVAL_MS
+#define WS_FRAME_INTERVAL_MS 100 // fastest rate frames are pushed to /ws clients
+#endif
+
+// Pushes each new JPEG to every /ws client as one binary message, preceded by a small text
+// message with its metadata. The client list belongs to the async_tcp task, so frames go out
+// through the socket's locked textAll()/binaryAll() rather than a walk over getClients(). A slow
+// client keeps its connection and has messages discarded once WS_MAX_QUEUED_MESSAGES are queued
+// for it, so it skips frames instead of building up a longer backlog.
+AsyncWebSocket wsFrames("/ws");
+uint32_t wsFrameSeq = 0;
+uint32_t wsFramesDropped = 0;
+uint32_t wsLastFrameMs = 0;
+
+void onWsFramesEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len)
+{
+    if (type == WS_EVT_CONNECT)
     {
-        return String(appName);
+        client->setCloseClientOnQueueFull(false);
+        Log.infoln("WebSocket client #%u connected", client->id());
     }
+    else if (type == WS_EVT_DISCONNECT)
+        Log.infoln("WebSocket client #%u disconnected", client->id());
+}
 
-    return "Undefined!";
+// called from the app loop, captures and pushes a frame when a client is connected
+void wsPushFrame()
+{
+    if (wsFrames.count() == 0)
+        return;
+
+    uint32_t now = millis();
+    if (now - wsLastFrameMs < WS_FRAME_INTERVAL_MS)
+        return;
+    wsLastFrameMs = now;
+
+    wsFrames.cleanupClients();
+
+    camera_fb_t *fb = cam.grab();
+    if (fb == NULL)
+        return;
+    size_t frameLen = fb->len;
+    // the driver stamps frames with the time since boot, the same clock as millis()
+    uint32_t captureMs = (uint32_t)(fb->timestamp.tv_sec * 1000UL + fb->timestamp.tv_usec / 1000);
+    wsFrameSeq++;
+
+    // one copy of the frame, shared by every client it is queued for
+    AsyncWebSocketSharedBuffer frame = std::make_shared<std::vector<uint8_t>>(fb->buf, fb->buf + frameLen);
+    cam.release(fb);
+
+    char meta[96];
+    snprintf(meta, sizeof(meta), "{\"seq\":%u,\"ts\":%u,\"size\":%u,\"dropped\":%u}",
+             (unsigned)wsFrameSeq, (unsigned)captureMs, (unsigned)frameLen, (unsigned)wsFramesDropped);
+
+    // counted once per frame that some client missed
+    wsFrames.textAll(meta);
+    if (wsFrames.binaryAll(frame) != AsyncWebSocket::ENQUEUED)
+        wsFramesDropped++;
 }
 
+#endif
+
+#pragma endregion
+
+MetricHistogram httpHandlerTime("http_handler_seconds", "Time spent in web request handlers");
+MetricCounter httpRequests("http_requests_total", "Web requests handled");
+
 void initWebServer()
 {
     // configure web webServer
     Log.infoln("Initializing Web Server on Port 80");
 
+    // times every handler; responses that stream later are only timed up to send()
+    webServer.addMiddleware([](AsyncWebServerRequest *request, ArMiddlewareNext next)
+                            {
+    MetricTimer timer(httpHandlerTime);
+    httpRequests.add();
+    next(); });
+
     // if url isn't found
     webServer.onNotFound(notFound);
 
@@ -106,186 +603,183 @@ void initWebServer()
     // Handle static files
     // webServer.serveStatic("", LittleFS, "/www/");
 
+    // exchanges username and password for a session token
+    // only for the user name and password: a session token must not be able to renew itself
+    webServer.on("/login", HTTP_GET, [](AsyncWebServerRequest *request)
+                 {
+                   if (!request->authenticate(appName, appSecret))
+                   {
+                       logWebRequest(request, LOG_LEVEL_NOTICE, "Auth: Failed");
+                       request->requestAuthentication();
+                       return;
+                   }
+
+                   char body[64];
+                   const char *token = issueSessionToken();
+                   snprintf(body, sizeof(body), "{\"token\":\"%s\",\"expiresIn\":%lu}", token, WEB_SESSION_TTL_MS / 1000);
+
+                   AsyncWebServerResponse *response = request->beginResponse(200, "application/json", body);
+                   response->addHeader("Set-Cookie", String("session=") + token + "; Path=/; HttpOnly; SameSite=Strict; Max-Age=" + String(WEB_SESSION_TTL_MS / 1000));
+                   response->addHeader("Cache-Control", "no-store");
+                   request->send(response); });
+
     // visiting this page will cause you to be logged out
     webServer.on("/logout", HTTP_GET, [](AsyncWebServerRequest *request)
                  {
-    request->requestAuthentication();
-    request->send(401); });
+    revokeSessionToken(request);
+    AsyncWebServerResponse *response = request->beginResponse(401);
+    response->addHeader("Set-Cookie", "session=; Path=/; Max-Age=0");
+    response->addHeader("WWW-Authenticate", "Basic realm=\"Login Required\"");
+    request->send(response); });
 
     // presents a "you are now logged out webpage
     webServer.on("/logged-out", HTTP_GET, [](AsyncWebServerRequest *request)
                  {
-    String logmessage = "Client:" + request->client()->remoteIP().toString() + " " + request->url();
-    Log.infoln(logmessage.c_str());
-    request->send(401, "text/html", logout_html, processor); });
+    logWebRequest(request, LOG_LEVEL_NOTICE, "");
+    sendWebAsset(request, logout_html, 401); });
 
     webServer.on("/jpg", HTTP_GET, [](AsyncWebServerRequest *request)
                  {
-                   String logmessage = "Client:" + request->client()->remoteIP().toString() + +" " + request->url();
+                   if (!authorizeWebRequest(request))
+                       return;
 
-                   if (checkUserWebAuth(request))
+                   // a copy, the response is sent after the handler returns
+                   camera_fb_t *fb = cam.grab();
+                   if (fb == NULL)
                    {
-                       logmessage += " Auth: Success";
-                       Log.infoln(logmessage.c_str());
-                       
-                       cam.run();
-
-                       //int len = cam.getSize();
-
-                       //Log.infoln("Got frame size: %i", len);
-                       request->send(200, "image/jpeg", cam.getfb(), cam.getSize());
+                       request->send(503);
+                       return;
                    }
-                   else
-                   {
-                       logmessage += " Auth: Failed";
-                       Log.infoln(logmessage.c_str());
-                       return request->requestAuthentication();
-                   } });
+                   AsyncResponseStream *response = request->beginResponseStream("image/jpeg", fb->len);
+                   response->write(fb->buf, fb->len);
+                   cam.release(fb);
+                   request->send(response); });
 
     webServer.on("/mjpg", HTTP_GET, [](AsyncWebServerRequest *request)
                  {
-                   String logmessage = "Client:" + request->client()->remoteIP().toString() + +" " + request->url();
+                   if (!authorizeWebRequest(request))
+                       return;
 
-                   if (checkUserWebAuth(request))
+                   camera_fb_t *fb = cam.grab();
+                   if (fb == NULL)
                    {
-                       logmessage += " Auth: Success";
-                       Log.infoln(logmessage.c_str());
-                       
-
-                       //int len = cam.getSize();
-
-                       //Log.infoln("Got frame size: %i", len);
-                       request->sendChunked("image/jpeg", [](uint8_t *buffer, size_t maxLen, size_t index)
-                                            {
-                              int len = cam.getSize();
-                              memcpy(buffer, cam.getfb(), len);
-                              return len; });
+                       request->send(503);
+                       return;
                    }
-                   else
-                   {
-                       logmessage += " Auth: Failed";
-                       Log.infoln(logmessage.c_str());
-                       return request->requestAuthentication();
-                   } });
+                   auto frame = std::make_shared<std::vector<uint8_t>>(fb->buf, fb->buf + fb->len);
+                   cam.release(fb);
+
+                   request->sendChunked("image/jpeg", [frame](uint8_t *buffer, size_t maxLen, size_t index) -> size_t
+                                        {
+                              size_t len = minimum(maxLen, frame->size() - index);
+                              memcpy(buffer, frame->data() + index, len);
+                              return len; }); });
+
+#ifdef USE_ESP32_CAM
+    // live view, the handshake carries the session cookie like any other request
+    wsFrames.onEvent(onWsFramesEvent);
+    wsFrames.handleHandshake([](AsyncWebServerRequest *request)
+                             { return checkUserWebAuth(request); });
+    webServer.addHandler(&wsFrames);
+#endif
 
     webServer.on("/", HTTP_GET, [](AsyncWebServerRequest *request)
                  {
-                   String logmessage = "Client:" + request->client()->remoteIP().toString() + +" " + request->url();
-
-                   if (checkUserWebAuth(request))
-                   {
-                       logmessage += " Auth: Success";
-                       Log.infoln(logmessage.c_str());
-                       request->send(200, "text/html", index_html, processor);
-                   }
-                   else
-                   {
-                       logmessage += " Auth: Failed";
-                       Log.infoln(logmessage.c_str());
-                       return request->requestAuthentication();
-                   } });
+                   if (authorizeWebRequest(request))
+                       sendWebAsset(request, index_html); });
 
     webServer.on("/simple.css", HTTP_GET, [](AsyncWebServerRequest *request)
                  {
-                   String logmessage = "Client:" + request->client()->remoteIP().toString() + +" " + request->url();
+                   if (authorizeWebRequest(request))
+                       sendWebAsset(request, simple_css); });
 
-                   if (checkUserWebAuth(request))
-                   {
-                       logmessage += " Auth: Success";
-                       Log.infoln(logmessage.c_str());
-                       request->send(200, "text/css", simple_css, processor);
-                   }
-                   else
-                   {
-                       logmessage += " Auth: Failed";
-                       Log.infoln(logmessage.c_str());
-                       return request->requestAuthentication();
-                   } });
+    webServer.on("/status.json", HTTP_GET, [](AsyncWebServerRequest *request)
+                 {
+                   if (authorizeWebRequest(request))
+                       sendStatusJson(request); });
 
-    webServer.on("/reboot", HTTP_GET, [](AsyncWebServerRequest *request)
+    // raw dump of the deferred log ring, decoded with tools/decode_log_ring.py
+    webServer.on("/logring", HTTP_GET, [](AsyncWebServerRequest *request)
+                 {
+    if (!authorizeWebRequest(request))
+      return;
+
+    AsyncResponseStream *response = request->beginResponseStream("application/octet-stream");
+    response->addHeader("Cache-Control", "no-store");
+    logRing.dump(response);
+    request->send(response); });
+
+    webServer.on("/memory.json", HTTP_GET, [](AsyncWebServerRequest *request)
+                 {
+    if (!authorizeWebRequest(request))
+      return;
+
+    MemorySnapshot snapshot;
+    memorySample(snapshot);
+    JsonDocument doc;
+    memoryToJson(snapshot, doc);
+
+    AsyncResponseStream *response = request->beginResponseStream("application/json");
+    response->addHeader("Cache-Control", "no-store");
+    serializeJson(doc, *response);
+    request->send(response); });
+
+    // Prometheus text format
+    webServer.on("/metrics", HTTP_GET, [](AsyncWebServerRequest *request)
                  {
-    String logmessage = "Client:" + request->client()->remoteIP().toString() + " " + request->url();
+    if (!authorizeWebRequest(request))
+      return;
 
-    if (checkUserWebAuth(request)) {
-      request->send(200, "text/html", reboot_html);
-      logmessage += " Auth: Success";
-      Log.infoln(logmessage.c_str());
+    AsyncResponseStream *response = request->beginResponseStream("text/plain; version=0.0.4");
+    response->addHeader("Cache-Control", "no-store");
+    MetricsPrintOut out(*response);
+    metricsWritePrometheus(out);
+    request->send(response); });
+
+    webServer.on("/reboot", HTTP_GET, [](AsyncWebServerRequest *request)
+                 {
+    if (authorizeWebRequest(request)) {
+      sendWebAsset(request, reboot_html);
       shouldReboot = true;
-    } else {
-      logmessage += " Auth: Failed";
-      Log.infoln(logmessage.c_str());
-      return request->requestAuthentication();
     } });
 
     webServer.on("/listfiles", HTTP_GET, [](AsyncWebServerRequest *request)
                  {
-    String logmessage = "Client:" + request->client()->remoteIP().toString() + " " + request->url();
-    if (checkUserWebAuth(request)) {
-      logmessage += " Auth: Success";
-      Log.infoln(logmessage.c_str());
-      request->send(200, "text/plain", listFiles(LittleFS, true));
-    } else {
-      logmessage += " Auth: Failed";
-      Log.infoln(logmessage.c_str());
-      return request->requestAuthentication();
-    } });
+    if (authorizeWebRequest(request))
+      sendFileList(request, LittleFS); });
 
 #ifdef USE_SD_CARD
     webServer.on("/listSDfiles", HTTP_GET, [](AsyncWebServerRequest *request)
                  {
-    String logmessage = "Client:" + request->client()->remoteIP().toString() + " " + request->url();
-    if (checkUserWebAuth(request)) {
-      logmessage += " Auth: Success";
-      Log.infoln(logmessage.c_str());
-      request->send(200, "text/plain", listFiles(SD, true));
-    } else {
-      logmessage += " Auth: Failed";
-      Log.infoln(logmessage.c_str());
-      return request->requestAuthentication();
-    } });
+    if (authorizeWebRequest(request))
+      sendFileList(request, SD); });
 #endif
 
     webServer.on("/file", HTTP_GET, [](AsyncWebServerRequest *request)
                  {
-    String logmessage = "Client:" + request->client()->remoteIP().toString() + " " + request->url();
-    if (checkUserWebAuth(request)) {
-      logmessage += " Auth: Success";
-      Log.infoln(logmessage.c_str());
-
-      if (request->hasParam("name") && request->hasParam("action")) {
-        const char *fileName = request->getParam("name")->value().c_str();
-        const char *fileAction = request->getParam("action")->value().c_str();
-
-        logmessage = "Client:" + request->client()->remoteIP().toString() + " " + request->url() + "?name=" + String(fileName) + "&action=" + String(fileAction);
-
-        if (!LittleFS.exists(fileName)) {
-            logmessage += " ERROR: file does not exist";
-            Log.infoln(logmessage.c_str());
-            request->send(400, "text/plain", "ERROR: file does not exist");
-        } else {
-            logmessage += " file exists";
-            Log.infoln(logmessage.c_str());
-            if (strcmp(fileAction, "download") == 0)
-            {
-                logmessage += " downloaded";
-                request->send(LittleFS, fileName, "application/octet-stream");
-          } else if (strcmp(fileAction, "delete") == 0) {
-            logmessage += " deleted";
-            LittleFS.remove(fileName);
-            request->send(200, "text/plain", "Deleted File: " + String(fileName));
-          } else {
-            logmessage += " ERROR: invalid action param supplied";
-            request->send(400, "text/plain", "ERROR: invalid action param supplied");
-          }
-          Log.infoln(logmessage.c_str());
-        }
+    if (!authorizeWebRequest(request))
+      return;
+
+    if (request->hasParam("name") && request->hasParam("action")) {
+      const char *fileName = request->getParam("name")->value().c_str();
+      const char *fileAction = request->getParam("action")->value().c_str();
+
+      if (!LittleFS.exists(fileName)) {
+        Log.infoln("%s ERROR: file does not exist", fileName);
+        request->send(400, "text/plain", "ERROR: file does not exist");
+      } else if (strcmp(fileAction, "download") == 0) {
+        Log.infoln("%s downloaded", fileName);
+        request->send(LittleFS, fileName, "application/octet-stream");
+      } else if (strcmp(fileAction, "delete") == 0) {
+        Log.infoln("%s deleted", fileName);
+        LittleFS.remove(fileName);
+        request->send(200, "text/plain", "Deleted File: " + String(fileName));
       } else {
-        request->send(400, "text/plain", "ERROR: name and action params required");
+        Log.infoln("%s ERROR: invalid action param supplied", fileName);
+        request->send(400, "text/plain", "ERROR: invalid action param supplied");
       }
     } else {
-      logmessage += " Auth: Failed";
-      Log.infoln(logmessage.c_str());
-      return request->requestAuthentication();
+      request->send(400, "text/plain", "ERROR: name and action params required");
     } });
 
     webServer.begin();
@@ -293,22 +787,22 @@ void initWebServer()
 
 void notFound(AsyncWebServerRequest *request)
 {
-    String logmessage = "Client:" + request->client()->remoteIP().toString() + " " + request->url();
-    Log.infoln(logmessage.c_str());
+    logWebRequest(request, LOG_LEVEL_NOTICE, "Not found");
     request->send(404, "text/plain", "Not found");
 }
 
-// used by webServer.on functions to discern whether a user has the correct httpapitoken OR is authenticated by username and password
+// used by webServer.on functions to discern whether a user has a valid session token OR is authenticated by username and password
 bool checkUserWebAuth(AsyncWebServerRequest *request)
 {
-    bool isAuthenticated = false;
+    if (checkSessionToken(request))
+        return true;
 
     if (request->authenticate(appName, appSecret))
     {
-        Log.infoln("is authenticated via username and password");
-        isAuthenticated = true;
+        Log.verboseln("is authenticated via username and password");
+        return true;
     }
-    return isAuthenticated;
+    return false;
 }
 
 // handles uploads to the filserver
@@ -317,31 +811,26 @@ void handleUpload(AsyncWebServerRequest *request, String filename, size_t index,
     // make sure authenticated before allowing upload
     if (checkUserWebAuth(request))
     {
-        String logmessage = "Client:" + request->client()->remoteIP().toString() + " " + request->url();
-        Log.infoln(logmessage.c_str());
-
         if (!index)
         {
-            logmessage = "Upload Start: " + String(filename);
+            logWebRequest(request, LOG_LEVEL_NOTICE, "Upload Start");
+            Log.infoln("Upload Start: %s", filename.c_str());
             // open the file on first call and store the file handle in the request object
             request->_tempFile = LittleFS.open("/" + filename, "w");
-            Log.infoln(logmessage.c_str());
         }
 
         if (len)
         {
             // stream the incoming chunk to the opened file
             request->_tempFile.write(data, len);
-            logmessage = "Writing file: " + String(filename) + " index=" + String(index) + " len=" + String(len);
-            Log.infoln(logmessage.c_str());
+            Log.verboseln("Writing file: %s index=%u len=%u", filename.c_str(), index, len);
         }
 
         if (final)
         {
-            logmessage = "Upload Complete: " + String(filename) + ",size: " + String(index + len);
             // close the file handle as the upload is now done
             request->_tempFile.close();
-            Log.infoln(logmessage.c_str());
+            Log.infoln("Upload Complete: %s,size: %u", filename.c_str(), index + len);
             request->redirect("/");
         }
     }
@@ -352,4 +841,4 @@ void handleUpload(AsyncWebServerRequest *request, String filename, size_t index,
     }
 }
 
-#endif // WEB_SERVER_H
\ No newline at end of file
+#endif // WEB_SERVER_H
@@ -1,179 +1,377 @@
 ////////////////////////////////////////////////////////////////////
 /// @file webpages.h
-/// @brief Contains all functions related to the webserver
+/// @brief Gzipped admin UI assets. GENERATED by tools/embed_webpages.py
+/// from the files in web/ - edit those and rebuild, not this file.
 ////////////////////////////////////////////////////////////////////
 
-const char index_html[] PROGMEM = R"rawliteral(
-<!DOCTYPE HTML>
-<html lang="en">
-<head>
-  <meta charset="UTF-8">
-  <meta name="viewport" content="width=device-width, initial-scale=1">
-  <title>%APP_NAME%</title>
-  <link rel="stylesheet" href="/simple.css">
-</head>
-<body id="top">
-  <header>
-    <h1>%APP_NAME% Admin page</h1>
-  </header>
-  <p>Firmware: %FIRMWARE%</p>
-  <p>Free Storage: <span id="freespiffs">%FREESPACE%</span> | Used Storage: <span id="usedspiffs">%USEDSPACE%</span> | Total Storage: <span id="totalspiffs">%TOTALSPACE%</span></p>
-  <p>
-  <button onclick="logoutButton()">Logout</button>
-  <button onclick="rebootButton()">Reboot</button>
-  <button onclick="listFilesButton()">List Files</button>
-  <button onclick="listSDFilesButton()">List SD Files</button>
-  <button onclick="showUploadButtonFancy()">Upload File</button>
-  </p>
-  <p id="status"></p>
-  <p id="detailsheader"></p>
-  <p id="details"></p>
-<script>
-function logoutButton() {
-  var xhr = new XMLHttpRequest();
-  xhr.open("GET", "/logout", true);
-  xhr.send();
-  setTimeout(function(){ window.open("/logged-out","_self"); }, 1000);
-}
-function rebootButton() {
-  document.getElementById("status").innerHTML = "Invoking Reboot ...";
-  var xhr = new XMLHttpRequest();
-  xhr.open("GET", "/reboot", true);
-  xhr.send();
-  window.open("/reboot","_self");
-}
-function listFilesButton() {
-  xmlhttp=new XMLHttpRequest();
-  xmlhttp.open("GET", "/listfiles", false);
-  xmlhttp.send();
-  document.getElementById("detailsheader").innerHTML = "<h3>LittleFS Files<h3>";
-  document.getElementById("details").innerHTML = xmlhttp.responseText;
-}
-function listSDFilesButton() {
-  xmlhttp=new XMLHttpRequest();
-  xmlhttp.open("GET", "/listSDfiles", false);
-  xmlhttp.send();
-  document.getElementById("detailsheader").innerHTML = "<h3>SD Files<h3>";
-  document.getElementById("details").innerHTML = xmlhttp.responseText;
-}
-function downloadDeleteButton(filename, action) {
-  var urltocall = "/file?name=" + filename + "&action=" + action;
-  xmlhttp=new XMLHttpRequest();
-  if (action == "delete") {
-    xmlhttp.open("GET", urltocall, false);
-    xmlhttp.send();
-    document.getElementById("status").innerHTML = xmlhttp.responseText;
-    xmlhttp.open("GET", "/listfiles", false);
-    xmlhttp.send();
-    document.getElementById("details").innerHTML = xmlhttp.responseText;
-  }
-  if (action == "download") {
-    document.getElementById("status").innerHTML = "";
-    window.open(urltocall,"_blank");
-  }
-}
-function showUploadButtonFancy() {
-  document.getElementById("detailsheader").innerHTML = "<h3>Upload File<h3>"
-  document.getElementById("status").innerHTML = "";
-  var uploadform = "<form method = \"POST\" action = \"/\" enctype=\"multipart/form-data\"><input type=\"file\" name=\"data\"/><input type=\"submit\" name=\"upload\" value=\"Upload\" title = \"Upload File\"></form>"
-  document.getElementById("details").innerHTML = uploadform;
-  var uploadform =
-  "<form id=\"upload_form\" enctype=\"multipart/form-data\" method=\"post\">" +
-  "<input type=\"file\" name=\"file1\" id=\"file1\" onchange=\"uploadFile()\"><br>" +
-  "<progress id=\"progressBar\" value=\"0\" max=\"100\" style=\"width:300px;\"></progress>" +
-  "<h3 id=\"status\"></h3>" +
-  "<p id=\"loaded_n_total\"></p>" +
-  "</form>";
-  document.getElementById("details").innerHTML = uploadform;
-}
-function _(el) {
-  return document.getElementById(el);
-}
-function uploadFile() {
-  var file = _("file1").files[0];
-  // alert(file.name+" | "+file.size+" | "+file.type);
-  var formdata = new FormData();
-  formdata.append("file1", file);
-  var ajax = new XMLHttpRequest();
-  ajax.upload.addEventListener("progress", progressHandler, false);
-  ajax.addEventListener("load", completeHandler, false); // doesnt appear to ever get called even upon success
-  ajax.addEventListener("error", errorHandler, false);
-  ajax.addEventListener("abort", abortHandler, false);
-  ajax.open("POST", "/");
-  ajax.send(formdata);
-}
-function progressHandler(event) {
-  //_("loaded_n_total").innerHTML = "Uploaded " + event.loaded + " bytes of " + event.total; // event.total doesnt show accurate total file size
-  _("loaded_n_total").innerHTML = "Uploaded " + event.loaded + " bytes";
-  var percent = (event.loaded / event.total) * 100;
-  _("progressBar").value = Math.round(percent);
-  _("status").innerHTML = Math.round(percent) + "% uploaded... please wait";
-  if (percent >= 100) {
-    _("status").innerHTML = "Please wait, writing file to filesystem";
-  }
-}
-function completeHandler(event) {
-  _("status").innerHTML = "Upload Complete";
-  _("progressBar").value = 0;
-  xmlhttp=new XMLHttpRequest();
-  xmlhttp.open("GET", "/listfiles", false);
-  xmlhttp.send();
-  document.getElementById("status").innerHTML = "File Uploaded";
-  document.getElementById("detailsheader").innerHTML = "<h3>Files<h3>";
-  document.getElementById("details").innerHTML = xmlhttp.responseText;
-}
-function errorHandler(event) {
-  _("status").innerHTML = "Upload Failed";
-}
-function abortHandler(event) {
-  _("status").innerHTML = "inUpload Aborted";
-}
-</script>
-</body>
-</html>
-)rawliteral";
+#ifndef WEBPAGES_H
+#define WEBPAGES_H
 
-const char logout_html[] PROGMEM = R"rawliteral(
-<!DOCTYPE HTML>
-<html lang="en">
-<head>
-  <meta name="viewport" content="width=device-width, initial-scale=1">
-  <meta charset="UTF-8">
-</head>
-<body>
-  <p><a href="/">Log Back In</a></p>
-</body>
-</html>
-)rawliteral";
+struct WebAsset
+{
+    const uint8_t *data; // gzip stream
+    size_t len;
+    const char *contentType;
+    const char *etag; // quoted strong ETag
+};
 
-// reboot.html base upon https://gist.github.com/Joel-James/62d98e8cb3a1b6b05102
-const char reboot_html[] PROGMEM = R"rawliteral(
-<!DOCTYPE HTML>
-<html lang="en">
-<head>
-  <meta charset="UTF-8">
-</head>
-<body>
-<h3>
-  Rebooting, returning to main page in <span id="countdown">30</span> seconds
-</h3>
-<script type="text/javascript">
-  var seconds = 20;
-  function countdown() {
-    seconds = seconds - 1;
-    if (seconds < 0) {
-      window.location = "/";
-    } else {
-      document.getElementById("countdown").innerHTML = seconds;
-      window.setTimeout("countdown()", 1000);
-    }
-  }
-  countdown();
-</script>
-</body>
-</html>
-)rawliteral";
+// index.html: 6924 bytes -> 2132 bytes gzipped
+const uint8_t index_html_gz[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xad, 0x19, 0xd9, 0x72, 0x1b, 0x37,
+    0xf2, 0x5d, 0x5f, 0x01, 0xa3, 0x6a, 0x77, 0xc9, 0x58, 0x9a, 0x91, 0xd6, 0x2f, 0x29, 0xf1, 0x70,
+    0xc5, 0x91, 0xb5, 0xce, 0x96, 0x1d, 0xbb, 0x4c, 0x2a, 0x9b, 0xd4, 0x6a, 0x4b, 0x05, 0xce, 0x80,
+    0xe2, 0x58, 0x43, 0x60, 0x02, 0x80, 0xa4, 0xb8, 0xb1, 0xff, 0x3d, 0xdd, 0x8d, 0xc1, 0x1c, 0x3c,
+    0x74, 0xe6, 0x45, 0xc2, 0xd1, 0x37, 0xfa, 0x1c, 0xf6, 0x5f, 0x9c, 0x7d, 0xfc, 0x71, 0xfc, 0xdb,
+    0xa7, 0xb7, 0xec, 0xdd, 0xf8, 0xc3, 0xfb, 0xe1, 0x41, 0x7f, 0xe6, 0xe6, 0x39, 0xcb, 0x85, 0xba,
+    0x1e, 0x70, 0xa9, 0x38, 0x1e, 0x48, 0x91, 0x0e, 0x0f, 0x18, 0xeb, 0xcf, 0xa5, 0x13, 0x2c, 0x99,
+    0x09, 0x63, 0xa5, 0x1b, 0xf0, 0x8b, 0xf1, 0xf9, 0xd1, 0xf7, 0xbc, 0xbe, 0x50, 0x62, 0x2e, 0x07,
+    0x7c, 0x99, 0xc9, 0x55, 0xa1, 0x8d, 0xe3, 0x2c, 0xd1, 0xca, 0x49, 0x05, 0x80, 0xab, 0x2c, 0x75,
+    0xb3, 0x41, 0x2a, 0x97, 0x59, 0x22, 0x8f, 0x68, 0x73, 0xc8, 0x32, 0x95, 0xb9, 0x4c, 0xe4, 0x47,
+    0x36, 0x11, 0xb9, 0x1c, 0x9c, 0x78, 0x32, 0x2e, 0x73, 0xb9, 0x1c, 0xfe, 0x90, 0xce, 0x33, 0xd5,
+    0x8f, 0xfd, 0x06, 0x8f, 0xf3, 0x4c, 0xdd, 0x30, 0x23, 0xf3, 0x01, 0xb7, 0x6e, 0x9d, 0x4b, 0x3b,
+    0x93, 0x12, 0xc8, 0xcf, 0x8c, 0x9c, 0x0e, 0x78, 0x6c, 0xb3, 0x79, 0x91, 0xcb, 0x28, 0xb1, 0x16,
+    0x45, 0x8d, 0xbd, 0xac, 0xfd, 0x89, 0x4e, 0xd7, 0x2c, 0x4b, 0x07, 0xdc, 0xe9, 0xc2, 0xd3, 0xc6,
+    0x0b, 0x69, 0x70, 0x89, 0x9b, 0x93, 0x61, 0xdf, 0x16, 0x42, 0x11, 0x88, 0x28, 0x0a, 0x14, 0x9d,
+    0x0f, 0xfb, 0x31, 0x9e, 0x0d, 0x19, 0x09, 0xc0, 0x0a, 0x71, 0x2d, 0x81, 0xde, 0x09, 0x61, 0xc7,
+    0x35, 0x7a, 0xbf, 0x18, 0x9e, 0x67, 0x66, 0xbe, 0x12, 0x46, 0x9e, 0xb2, 0x9a, 0xca, 0xb4, 0x3c,
+    0xab, 0xc8, 0xf4, 0xe3, 0x22, 0x80, 0x1b, 0x29, 0xd9, 0xc8, 0x69, 0x03, 0x14, 0x5b, 0x28, 0x70,
+    0x6e, 0x8b, 0x6c, 0x3a, 0xb5, 0x35, 0xef, 0xaf, 0xec, 0xc2, 0xca, 0x74, 0x17, 0xf4, 0x02, 0xce,
+    0xb7, 0xa1, 0xc7, 0xda, 0x89, 0x7c, 0x17, 0xb8, 0xc3, 0x8b, 0x0d, 0xf8, 0x5a, 0x24, 0xfc, 0x3b,
+    0x59, 0x38, 0xa7, 0x15, 0xd3, 0x2a, 0xc9, 0xb3, 0xe4, 0x66, 0xc0, 0x73, 0x7d, 0xad, 0x17, 0xee,
+    0x0d, 0x9d, 0x76, 0xba, 0x7c, 0xf8, 0x9e, 0xf6, 0xfd, 0xd8, 0xc3, 0xed, 0x44, 0x31, 0x72, 0xa2,
+    0x75, 0x03, 0xe5, 0x33, 0xed, 0xef, 0x44, 0xc9, 0x33, 0xeb, 0xce, 0x33, 0x78, 0xc5, 0x06, 0x23,
+    0x38, 0x62, 0x74, 0x76, 0x2f, 0xe6, 0xe8, 0x6c, 0x17, 0xee, 0xe8, 0xec, 0x01, 0xe8, 0x76, 0xa6,
+    0x57, 0x17, 0x45, 0xae, 0x45, 0xea, 0xb1, 0xcf, 0x85, 0x4a, 0xd6, 0x48, 0xc2, 0x1f, 0x12, 0x85,
+    0x7b, 0xf8, 0x2f, 0xe5, 0x2f, 0xe0, 0xdd, 0x4d, 0xe6, 0x4b, 0xc9, 0xf0, 0xa8, 0x85, 0x17, 0x8c,
+    0x4c, 0xcf, 0x60, 0x9d, 0x70, 0x0b, 0x7a, 0x81, 0xe6, 0x69, 0x0a, 0xf1, 0x92, 0xe5, 0xd6, 0x3b,
+    0xd5, 0x9e, 0xcb, 0xf2, 0xb8, 0x6f, 0x13, 0x93, 0x15, 0x6e, 0x78, 0x30, 0x5d, 0xa8, 0xc4, 0x65,
+    0x20, 0x10, 0xf8, 0xbd, 0x81, 0x20, 0x18, 0x11, 0xe5, 0x4e, 0x97, 0xfd, 0x01, 0xa8, 0x4b, 0x61,
+    0xd8, 0xed, 0xcc, 0xb0, 0x01, 0x53, 0x72, 0xc5, 0x7e, 0xfd, 0xf0, 0xfe, 0x9d, 0x73, 0xc5, 0x67,
+    0xf9, 0xfb, 0x42, 0x5a, 0xd7, 0xe9, 0xf6, 0x00, 0x02, 0x6e, 0x23, 0x5d, 0x48, 0xd5, 0xe1, 0xff,
+    0x7a, 0x3b, 0xe6, 0x87, 0x0c, 0x22, 0x87, 0x08, 0x44, 0x5f, 0xac, 0x56, 0xb0, 0x77, 0x66, 0x21,
+    0x6b, 0x40, 0x45, 0x26, 0x19, 0xb0, 0xc0, 0xb4, 0x64, 0xc3, 0x58, 0x36, 0x65, 0x1d, 0x84, 0xf0,
+    0xc8, 0xec, 0xc5, 0x80, 0xfd, 0xf3, 0xf8, 0xb8, 0x0b, 0x32, 0xb9, 0x85, 0x51, 0x3d, 0x02, 0x41,
+    0x59, 0xe0, 0x51, 0x06, 0xec, 0xdf, 0xa3, 0x8f, 0x3f, 0x47, 0x05, 0x66, 0x0b, 0x42, 0x01, 0xa1,
+    0x0b, 0xad, 0xac, 0x1c, 0xcb, 0x5b, 0xd7, 0xf5, 0xa0, 0xa9, 0x4e, 0x16, 0x73, 0xc8, 0x11, 0x11,
+    0x05, 0x3b, 0xa0, 0x58, 0x17, 0x41, 0x38, 0xfe, 0x0c, 0xe1, 0xb8, 0x01, 0x70, 0x2d, 0xdd, 0xdb,
+    0x5c, 0xe2, 0xf2, 0xcd, 0xfa, 0xa7, 0xb4, 0x53, 0x05, 0x6d, 0x37, 0xca, 0x94, 0x92, 0x06, 0x53,
+    0xd7, 0x63, 0xd0, 0xab, 0x68, 0xdd, 0xc2, 0x0f, 0x37, 0xf7, 0x11, 0xa8, 0x63, 0x77, 0x9b, 0x04,
+    0xdc, 0x8d, 0x0a, 0x91, 0xdc, 0x47, 0xa3, 0x11, 0xd1, 0x5b, 0x34, 0xf0, 0xee, 0x21, 0x34, 0x9a,
+    0x61, 0xbe, 0x45, 0x84, 0x2e, 0x2b, 0x2a, 0xdf, 0xc2, 0xeb, 0x5a, 0xa9, 0x52, 0x74, 0x8a, 0x6f,
+    0xb5, 0x4f, 0x41, 0xec, 0x67, 0xe1, 0x91, 0xe3, 0x98, 0xd9, 0x95, 0x28, 0x98, 0x9b, 0x49, 0x36,
+    0x31, 0x7a, 0x65, 0xa5, 0xf9, 0x87, 0x65, 0x89, 0x91, 0x29, 0x70, 0x85, 0x9c, 0x6d, 0xd9, 0x54,
+    0x1b, 0x26, 0x98, 0x95, 0xd6, 0x22, 0x6e, 0xa2, 0xf5, 0x4d, 0x26, 0x99, 0xd5, 0x84, 0xe1, 0xd3,
+    0xbc, 0x27, 0x93, 0x6a, 0x69, 0x99, 0xd2, 0x8e, 0xcd, 0x04, 0x04, 0x8a, 0xd3, 0x50, 0x3b, 0x64,
+    0x72, 0x43, 0x60, 0x85, 0xb0, 0x76, 0xa5, 0x4d, 0x0a, 0xe1, 0xc5, 0xe4, 0x52, 0x9a, 0x35, 0xb8,
+    0x10, 0x79, 0xeb, 0x13, 0x9d, 0x99, 0x14, 0xd8, 0x74, 0xe3, 0x5a, 0xd1, 0x52, 0xbf, 0xde, 0xc1,
+    0x46, 0xf0, 0xf4, 0x5a, 0x26, 0x68, 0xa4, 0xbf, 0x27, 0x47, 0x95, 0x27, 0xb3, 0x4f, 0x12, 0x06,
+    0x56, 0x73, 0xe3, 0x6c, 0x2e, 0x01, 0xa6, 0x53, 0x07, 0xd7, 0x1f, 0x6c, 0x95, 0xa9, 0x54, 0xaf,
+    0x4a, 0x5a, 0x48, 0xe4, 0x5a, 0xa6, 0x47, 0x44, 0x88, 0x5f, 0x59, 0x99, 0x4f, 0x79, 0xb7, 0xc7,
+    0xbe, 0x1d, 0xb2, 0x93, 0x63, 0x88, 0xb6, 0xd6, 0xcb, 0xb5, 0x53, 0x30, 0x89, 0xbd, 0xd7, 0x59,
+    0xca, 0x64, 0xd4, 0xf6, 0x13, 0xfe, 0x93, 0x5a, 0xc2, 0x03, 0xaa, 0x6b, 0xe6, 0xb3, 0x37, 0x8b,
+    0xa2, 0x88, 0xf7, 0x9e, 0xa8, 0xbd, 0x97, 0x66, 0xbf, 0xf6, 0x6d, 0x35, 0x03, 0x74, 0xa5, 0x22,
+    0x28, 0x86, 0x5c, 0x31, 0xd3, 0x5f, 0x98, 0x1c, 0x85, 0x8b, 0x71, 0x3d, 0xc5, 0xe4, 0x0e, 0x32,
+    0x85, 0xbb, 0x4f, 0x50, 0xeb, 0x46, 0xd9, 0xff, 0x31, 0x61, 0x80, 0x41, 0x9a, 0x6f, 0x58, 0x5e,
+    0x76, 0x34, 0xc4, 0x83, 0x74, 0xde, 0x1c, 0xb7, 0xf3, 0x7c, 0x06, 0x92, 0x0f, 0xf6, 0x6a, 0xe1,
+    0xef, 0x5b, 0x9a, 0x04, 0x09, 0x5e, 0x32, 0xfe, 0x3a, 0xcf, 0xe6, 0x19, 0x74, 0x31, 0xb0, 0x6e,
+    0xf1, 0x86, 0xab, 0xbf, 0x7b, 0x36, 0x74, 0xe7, 0x97, 0x87, 0x6c, 0x0a, 0x01, 0x22, 0x5b, 0x74,
+    0x6b, 0xed, 0xf7, 0x3e, 0x4c, 0x48, 0xf9, 0xed, 0x97, 0x09, 0x04, 0x9a, 0x89, 0xb3, 0x1d, 0xb5,
+    0x9b, 0xb5, 0x94, 0xf4, 0xdd, 0x67, 0xbd, 0xfb, 0xf9, 0x97, 0xf5, 0x68, 0xc3, 0x3f, 0xfa, 0xb3,
+    0x57, 0x50, 0xe9, 0x1c, 0x24, 0xe8, 0xf3, 0x51, 0x59, 0x67, 0xe1, 0x84, 0x08, 0x56, 0xf6, 0xde,
+    0x70, 0xca, 0x1d, 0xa5, 0x7a, 0xa7, 0x68, 0xa3, 0xb3, 0xbf, 0x42, 0xb8, 0xaa, 0xfc, 0xdf, 0x27,
+    0x16, 0xb8, 0x1e, 0x15, 0xb6, 0x33, 0x99, 0x4b, 0x27, 0x4b, 0xc9, 0x50, 0x02, 0x2c, 0x25, 0x87,
+    0x4c, 0x10, 0x54, 0x1d, 0xfa, 0x0b, 0x93, 0x3b, 0x0d, 0xfd, 0xa9, 0x97, 0x17, 0xe1, 0x5e, 0xfb,
+    0x1e, 0x17, 0x9e, 0x3b, 0x60, 0x91, 0x1b, 0x78, 0x44, 0x3a, 0xf7, 0xcb, 0xde, 0x03, 0xdc, 0x0e,
+    0x2b, 0xa9, 0x87, 0x66, 0x03, 0xa0, 0x9f, 0x92, 0x4c, 0x3c, 0xd4, 0xd9, 0x5d, 0x4e, 0x59, 0xc9,
+    0xd3, 0xf4, 0xb2, 0x5d, 0x7e, 0xf6, 0xd8, 0x14, 0xb0, 0xdb, 0xd1, 0xf6, 0x89, 0xd1, 0xf4, 0xaa,
+    0x67, 0x48, 0xf2, 0x18, 0x9f, 0x47, 0x42, 0x5b, 0x99, 0x1b, 0x2a, 0xda, 0x0e, 0x33, 0x96, 0x4f,
+    0x5c, 0x19, 0xf2, 0x91, 0xc9, 0x90, 0x7b, 0x66, 0xcd, 0x3c, 0x55, 0x9b, 0x9d, 0x5f, 0x4d, 0x60,
+    0x2e, 0xba, 0xe1, 0x25, 0xf3, 0x86, 0x67, 0xed, 0x69, 0x2e, 0xef, 0x4e, 0xc7, 0xf7, 0x3a, 0x76,
+    0xb3, 0x33, 0x45, 0xdf, 0x3e, 0x78, 0x9a, 0x3a, 0xe4, 0xcb, 0x44, 0x0a, 0x0a, 0xf7, 0x9c, 0x88,
+    0xd3, 0x02, 0xa6, 0xb6, 0x99, 0xc6, 0x2e, 0xef, 0x92, 0x7f, 0xfa, 0x38, 0x1a, 0x5f, 0x72, 0x16,
+    0x0c, 0x09, 0x27, 0x31, 0x6c, 0x25, 0x68, 0xb7, 0x2e, 0xe4, 0xe0, 0x92, 0xcf, 0x17, 0xb9, 0xcb,
+    0xa0, 0x95, 0x73, 0x31, 0x62, 0x1e, 0xa5, 0xc2, 0x89, 0x4b, 0x68, 0x50, 0x33, 0x55, 0x2c, 0x1c,
+    0x2b, 0x61, 0xd0, 0x23, 0x00, 0x89, 0x42, 0xe4, 0x92, 0x7b, 0x90, 0x78, 0x03, 0xc6, 0x2e, 0x26,
+    0x90, 0x4c, 0x6b, 0x28, 0x2f, 0x16, 0xec, 0x97, 0x22, 0x5f, 0xe0, 0xc1, 0x45, 0x38, 0x08, 0x1d,
+    0x61, 0x38, 0x22, 0x2b, 0x20, 0x4f, 0x92, 0xe0, 0x6e, 0x5b, 0xec, 0x76, 0xad, 0xda, 0x04, 0xbb,
+    0x8c, 0x02, 0x47, 0xa5, 0x59, 0xa0, 0x07, 0x0f, 0x82, 0x5d, 0xe1, 0xc1, 0xfd, 0x86, 0x28, 0x2d,
+    0x09, 0xd7, 0x85, 0xb6, 0xa0, 0xdd, 0x10, 0x32, 0x01, 0xd1, 0xbb, 0xc3, 0x3e, 0xb8, 0x3b, 0x81,
+    0x2d, 0x71, 0x0b, 0x1b, 0x98, 0x35, 0x66, 0x30, 0x78, 0xd7, 0x96, 0x41, 0xa5, 0x3b, 0x5d, 0x54,
+    0x7b, 0x62, 0x2a, 0xaa, 0x85, 0xd1, 0xd7, 0x10, 0x0a, 0xd6, 0xe3, 0x86, 0xdd, 0x1b, 0x61, 0x1a,
+    0x76, 0x3c, 0x46, 0xa9, 0xc4, 0x2d, 0xac, 0xa0, 0x42, 0xc2, 0x9a, 0x26, 0x67, 0xd8, 0xd1, 0xf8,
+    0x7d, 0xfa, 0xea, 0xf8, 0xb8, 0xb8, 0xed, 0x91, 0x35, 0x03, 0x7a, 0x45, 0x7d, 0xf6, 0xca, 0xd3,
+    0xf5, 0x0e, 0x45, 0x30, 0xe8, 0x7b, 0x81, 0xb7, 0xbf, 0x44, 0xd9, 0x64, 0x7a, 0xa5, 0xae, 0xa8,
+    0xc5, 0xf4, 0x84, 0x2a, 0x98, 0xf2, 0x85, 0x7a, 0xcf, 0x7b, 0xa2, 0xd0, 0x0a, 0x2c, 0xe5, 0x48,
+    0x27, 0x37, 0x12, 0x07, 0x0a, 0xb5, 0xc8, 0xf3, 0x56, 0xb5, 0x6f, 0x0f, 0x64, 0xcf, 0x8c, 0xb6,
+    0x7a, 0x9a, 0x0b, 0x75, 0xe4, 0x91, 0xd2, 0xc3, 0x7b, 0xcf, 0xaf, 0x4b, 0xfb, 0x00, 0x2d, 0xb4,
+    0x4a, 0x51, 0x6f, 0x33, 0x35, 0xd5, 0xc1, 0x50, 0x21, 0xff, 0xd7, 0xda, 0x75, 0x1b, 0x9a, 0x46,
+    0x49, 0xae, 0x61, 0x66, 0xea, 0xfa, 0x52, 0xd6, 0xd4, 0x1f, 0x4a, 0xc9, 0x7f, 0xe4, 0xc4, 0xef,
+    0x3b, 0x9d, 0x1c, 0xb2, 0x12, 0x1a, 0x22, 0x82, 0x37, 0x84, 0x0c, 0xa5, 0x73, 0xca, 0x80, 0x98,
+    0x3e, 0xed, 0x29, 0x67, 0xaf, 0x19, 0x5f, 0x59, 0x7b, 0x1a, 0xc7, 0x9c, 0x9d, 0xe2, 0x12, 0x57,
+    0x5d, 0x6c, 0x62, 0x02, 0xd6, 0x0c, 0x7c, 0x15, 0xcb, 0x57, 0xbc, 0xb2, 0x7c, 0x83, 0x57, 0x34,
+    0xc9, 0x94, 0x30, 0xeb, 0x31, 0x38, 0x2e, 0xea, 0x35, 0xc9, 0xf5, 0x84, 0x6f, 0x40, 0x68, 0x35,
+    0x07, 0xaf, 0x81, 0x22, 0xdb, 0x9c, 0x12, 0xa1, 0x93, 0x57, 0x2e, 0x64, 0x5e, 0x7c, 0x3e, 0x34,
+    0xc8, 0x80, 0x5d, 0x75, 0xc8, 0x02, 0xbc, 0x2c, 0x09, 0xa8, 0xf9, 0x0b, 0xb8, 0x09, 0x80, 0x34,
+    0x2b, 0x28, 0xb1, 0xcc, 0xae, 0x85, 0x93, 0x29, 0xce, 0x09, 0x02, 0x86, 0x86, 0x99, 0x34, 0x0c,
+    0x3f, 0x26, 0x95, 0x20, 0xbb, 0xcd, 0xd3, 0xbe, 0xa9, 0x5c, 0xc4, 0x5f, 0x34, 0x87, 0xd2, 0x6f,
+    0x15, 0x67, 0x8c, 0x46, 0x3d, 0x65, 0x24, 0x6a, 0x84, 0xf1, 0x0b, 0x56, 0x03, 0x1d, 0xad, 0x33,
+    0xd0, 0x03, 0xf3, 0x5a, 0x26, 0x14, 0x9f, 0xbe, 0x6b, 0xb5, 0x06, 0xd9, 0x1a, 0xad, 0xe2, 0x5f,
+    0x6a, 0x87, 0xef, 0xbb, 0xe9, 0x10, 0xe7, 0x06, 0x5b, 0x04, 0xec, 0x0b, 0x90, 0x12, 0xd4, 0xc5,
+    0xdf, 0xd1, 0xe0, 0xec, 0x6b, 0xe3, 0xa8, 0x6c, 0x25, 0xd9, 0x64, 0xed, 0x60, 0x58, 0xfa, 0xca,
+    0x52, 0xa3, 0x8b, 0x02, 0xac, 0x50, 0x41, 0x94, 0x07, 0xfb, 0x95, 0x42, 0x41, 0x75, 0x8e, 0x79,
+    0x1c, 0x6c, 0x1a, 0x59, 0x93, 0x94, 0x56, 0xf6, 0x1b, 0x38, 0xbe, 0xf8, 0xfc, 0x3e, 0x82, 0xf1,
+    0x0d, 0x8c, 0xfb, 0x71, 0xf2, 0x45, 0x26, 0x0e, 0xf6, 0xdb, 0x7a, 0xa0, 0x69, 0x80, 0x4a, 0x97,
+    0xa0, 0x8d, 0x84, 0x91, 0xa0, 0x01, 0x8d, 0x17, 0xe5, 0x08, 0xd9, 0x28, 0x7a, 0x57, 0x1d, 0x99,
+    0x7b, 0x7b, 0x79, 0xa1, 0xf6, 0xc6, 0x0b, 0x80, 0xb5, 0x10, 0x9b, 0xb9, 0xad, 0xea, 0xb6, 0x30,
+    0x07, 0x7a, 0x5f, 0xa1, 0x6c, 0x08, 0xa6, 0xa4, 0x16, 0xe3, 0xbf, 0xc7, 0xff, 0xeb, 0xf9, 0x69,
+    0x52, 0xe4, 0xd2, 0x38, 0x6a, 0xd7, 0x22, 0xcc, 0xa1, 0x2f, 0xc9, 0x8e, 0x2f, 0x69, 0x8f, 0x56,
+    0x6c, 0xee, 0xf1, 0x8d, 0xbb, 0x21, 0xcb, 0x63, 0x3a, 0xf1, 0xef, 0x4c, 0x01, 0x74, 0x0e, 0xdb,
+    0x33, 0xd8, 0x7a, 0x07, 0x0a, 0x97, 0xf8, 0xdd, 0x00, 0xbb, 0x96, 0x92, 0xf9, 0x21, 0x89, 0x53,
+    0x91, 0x10, 0x5f, 0xc4, 0xed, 0x1d, 0x73, 0x10, 0x5e, 0x47, 0x5e, 0xa9, 0x48, 0xa4, 0xe9, 0x5b,
+    0xb4, 0x2d, 0x7e, 0x98, 0x92, 0xe0, 0x0a, 0x9d, 0x2a, 0x41, 0x03, 0xd1, 0xb0, 0x7c, 0x27, 0x54,
+    0x0a, 0xda, 0x34, 0xbb, 0x27, 0xa2, 0xb1, 0x8d, 0x4c, 0xbd, 0xcc, 0x21, 0xcc, 0xd8, 0xf8, 0x95,
+    0xd3, 0xc9, 0x4d, 0xc4, 0x30, 0x65, 0x2b, 0xc7, 0x50, 0x01, 0x10, 0x15, 0xa2, 0x07, 0xe7, 0x69,
+    0x06, 0x4f, 0xc0, 0xb0, 0x69, 0x01, 0x57, 0xc2, 0xb7, 0x06, 0x9b, 0x63, 0x9b, 0xb2, 0x48, 0x12,
+    0x60, 0xbf, 0x9f, 0x9d, 0x34, 0x46, 0x1b, 0xe0, 0x47, 0xff, 0x1f, 0x2e, 0xa5, 0x98, 0xe0, 0x17,
+    0x5f, 0xe8, 0xa0, 0xf1, 0xff, 0x3e, 0x34, 0xdf, 0x43, 0x62, 0xa7, 0x41, 0x4d, 0x24, 0xaf, 0x6f,
+    0xa8, 0x5f, 0x0c, 0x2f, 0xd1, 0x76, 0x95, 0x0d, 0x8b, 0x35, 0x33, 0x4c, 0x1c, 0x5f, 0x75, 0x36,
+    0x0a, 0xd1, 0x66, 0xfc, 0xf9, 0xd6, 0xa1, 0x8c, 0x26, 0xef, 0xf2, 0xe5, 0x41, 0x1d, 0x72, 0x90,
+    0x0b, 0xea, 0x5b, 0xa2, 0x42, 0x56, 0x6d, 0xec, 0x83, 0x85, 0xb1, 0xc9, 0x83, 0x16, 0x29, 0x59,
+    0x18, 0x08, 0x25, 0xe6, 0xaf, 0xc8, 0x6b, 0xd1, 0xfd, 0x0e, 0x7c, 0x22, 0x78, 0xae, 0x38, 0x55,
+    0xc3, 0x56, 0x48, 0x93, 0x00, 0x00, 0xa0, 0x75, 0x5a, 0x90, 0x2d, 0xc9, 0xba, 0xec, 0x3b, 0x3f,
+    0x01, 0x13, 0xf3, 0x46, 0x27, 0x00, 0x9c, 0xa9, 0x13, 0x00, 0xf4, 0x0f, 0xc2, 0xcd, 0x22, 0xa3,
+    0x17, 0x60, 0xe2, 0x92, 0x66, 0xb7, 0x84, 0xdf, 0xd9, 0x32, 0xee, 0x00, 0x47, 0xe9, 0xfe, 0x56,
+    0x06, 0xad, 0x4c, 0xa3, 0x28, 0x62, 0xe0, 0x8b, 0xc2, 0x4a, 0xb6, 0x12, 0x99, 0xab, 0x6a, 0x59,
+    0x10, 0x78, 0x48, 0x43, 0x79, 0xc8, 0xa3, 0xfb, 0xd8, 0xf0, 0x4f, 0x35, 0x89, 0x43, 0xb6, 0x32,
+    0x99, 0xc3, 0x2f, 0x10, 0x64, 0x4d, 0xf0, 0x60, 0x8a, 0xfc, 0x35, 0x78, 0xd7, 0x9c, 0x6f, 0xb5,
+    0xda, 0x1b, 0xa1, 0xd0, 0xf4, 0x88, 0xbd, 0xcc, 0xca, 0x16, 0xf2, 0xc7, 0x12, 0x95, 0xdf, 0x69,
+    0xb0, 0xe3, 0xde, 0x13, 0x3f, 0x1a, 0xec, 0x1b, 0x8c, 0x1e, 0xf1, 0x21, 0x60, 0xb7, 0xf8, 0x98,
+    0x29, 0x59, 0x70, 0x9e, 0x67, 0x0e, 0xcb, 0xed, 0x49, 0xf9, 0x2f, 0x9a, 0xce, 0xb6, 0x66, 0xb3,
+    0xc6, 0x7b, 0x35, 0x53, 0xc9, 0x63, 0x1e, 0xeb, 0x1c, 0xf8, 0x93, 0xb6, 0x0d, 0x5a, 0xcd, 0xfc,
+    0xf2, 0x20, 0x5a, 0x99, 0x2a, 0xa9, 0xfd, 0x80, 0x98, 0x25, 0xb9, 0x7e, 0x1c, 0xbe, 0xa9, 0xf7,
+    0x63, 0xfc, 0xa1, 0x88, 0x7e, 0x37, 0x72, 0xf3, 0x7c, 0x78, 0xf0, 0x27, 0x1c, 0x24, 0xfb, 0x96,
+    0x0c, 0x1b, 0x00, 0x00,
+};
+const WebAsset index_html = {index_html_gz, sizeof(index_html_gz), "text/html", "\"8c40bae83b5bc7d2\""};
 
-const char simple_css[] PROGMEM = R"rawliteral(
-:root{--sans-font:-apple-system,BlinkMacSystemFont,"Avenir Next",Avenir,"Nimbus Sans L",Roboto,"Noto Sans","Segoe UI",Arial,Helvetica,"Helvetica Neue",sans-serif;--mono-font:Consolas,Menlo,Monaco,"Andale Mono","Ubuntu Mono",monospace;--standard-border-radius:5px;--bg:#fff;--accent-bg:#f5f7ff;--text:#212121;--text-light:#585858;--border:#898ea4;--accent:#0d47a1;--accent-hover:#1266e2;--accent-text:var(--bg);--code:#d81b60;--preformatted:#444;--marked:#fd3;--disabled:#efefef}@media (prefers-color-scheme:dark){:root{color-scheme:dark;--bg:#212121;--accent-bg:#2b2b2b;--text:#dcdcdc;--text-light:#ababab;--accent:#ffb300;--accent-hover:#ffe099;--accent-text:var(--bg);--code:#f06292;--preformatted:#ccc;--disabled:#111}img,video{opacity:.8}}*,:before,:after{box-sizing:border-box}textarea,select,input,progress{-webkit-appearance:none;-moz-appearance:none;appearance:none}html{font-family:var(--sans-font);scroll-behavior:smooth}body{color:var(--text);background-color:var(--bg);grid-template-columns:1fr min(45rem,90%) 1fr;margin:0;font-size:1.15rem;line-height:1.5;display:grid}body>*{grid-column:2}body>header{background-color:var(--accent-bg);border-bottom:1px solid var(--border);text-align:center;grid-column:1/-1;padding:0 .5rem 2rem}body>header>:only-child{margin-block-start:2rem}body>header h1{max-width:1200px;margin:1rem auto}body>header p{max-width:40rem;margin:1rem auto}main{padding-top:1.5rem}body>footer{color:var(--text-light);text-align:center;border-top:1px solid var(--border);margin-top:4rem;padding:2rem 1rem 1.5rem;font-size:.9rem}h1{font-size:3rem}h2{margin-top:3rem;font-size:2.6rem}h3{margin-top:3rem;font-size:2rem}h4{font-size:1.44rem}h5{font-size:1.15rem}h6{font-size:.96rem}p{margin:1.5rem 0}p,h1,h2,h3,h4,h5,h6{overflow-wrap:break-word}h1,h2,h3{line-height:1.1}@media only screen and (width<=720px){h1{font-size:2.5rem}h2{font-size:2.1rem}h3{font-size:1.75rem}h4{font-size:1.25rem}}a,a:visited{color:var(--accent)}a:hover{text-decoration:none}button,.button,a.button,input[type=submit],input[type=reset],input[type=button]{border:1px solid var(--accent);background-color:var(--accent);color:var(--accent-text);padding:.5rem .9rem;line-height:normal;text-decoration:none}.button[aria-disabled=true],input:disabled,textarea:disabled,select:disabled,button[disabled]{cursor:not-allowed;background-color:var(--disabled);border-color:var(--disabled);color:var(--text-light)}input[type=range]{padding:0}abbr[title]{cursor:help;text-decoration-line:underline;text-decoration-style:dotted}button:enabled:hover,.button:not([aria-disabled=true]):hover,input[type=submit]:enabled:hover,input[type=reset]:enabled:hover,input[type=button]:enabled:hover{background-color:var(--accent-hover);border-color:var(--accent-hover);cursor:pointer}.button:focus-visible,button:focus-visible:where(:enabled),input:enabled:focus-visible:where([type=submit],[type=reset],[type=button]){outline:2px solid var(--accent);outline-offset:1px}header>nav{padding:1rem 0 0;font-size:1rem;line-height:2}header>nav ul,header>nav ol{flex-flow:wrap;place-content:space-around center;align-items:center;margin:0;padding:0;list-style-type:none;display:flex}header>nav ul li,header>nav ol li{display:inline-block}header>nav a,header>nav a:visited{border:1px solid var(--border);border-radius:var(--standard-border-radius);color:var(--text);margin:0 .5rem 1rem;padding:.1rem 1rem;text-decoration:none;display:inline-block}header>nav a:hover,header>nav a.current,header>nav a[aria-current=page],header>nav a[aria-current=true]{border-color:var(--accent);color:var(--accent);cursor:pointer}@media only screen and (width<=720px){header>nav a{border:none;padding:0;line-height:1;text-decoration:underline}}aside,details,pre,progress{background-color:var(--accent-bg);border:1px solid var(--border);border-radius:var(--standard-border-radius);margin-bottom:1rem}aside{float:right;width:30%;margin-inline-start:15px;padding:0 15px;font-size:1rem}[dir=rtl] aside{float:left}@media only screen and (width<=720px){aside{float:none;width:100%;margin-inline-start:0}}article,fieldset,dialog{border:1px solid var(--border);border-radius:var(--standard-border-radius);margin-bottom:1rem;padding:1rem}article h2:first-child,section h2:first-child,article h3:first-child,section h3:first-child{margin-top:1rem}section{border-top:1px solid var(--border);border-bottom:1px solid var(--border);margin:3rem 0;padding:2rem 1rem}section+section,section:first-child{border-top:0;padding-top:0}section+section{margin-top:0}section:last-child{border-bottom:0;padding-bottom:0}details{padding:.7rem 1rem}summary{cursor:pointer;word-break:break-all;margin:-.7rem -1rem;padding:.7rem 1rem;font-weight:700}details[open]>summary+*{margin-top:0}details[open]>summary{margin-bottom:.5rem}details[open]>:last-child{margin-bottom:0}table{border-collapse:collapse;margin:1.5rem 0}figure>table{width:max-content;margin:0}td,th{border:1px solid var(--border);text-align:start;padding:.5rem}th{background-color:var(--accent-bg);font-weight:700}tr:nth-child(2n){background-color:var(--accent-bg)}table caption{margin-bottom:.5rem;font-weight:700}textarea,select,input,button,.button{font-size:inherit;border-radius:var(--standard-border-radius);box-shadow:none;max-width:100%;margin-bottom:.5rem;padding:.5rem;font-family:inherit;display:inline-block}textarea,select,input{color:var(--text);background-color:var(--bg);border:1px solid var(--border)}label{display:block}textarea:not([cols]){width:100%}select:not([multiple]){background-image:linear-gradient(45deg,transparent 49%,var(--text)51%),linear-gradient(135deg,var(--text)51%,transparent 49%);background-position:calc(100% - 15px),calc(100% - 10px);background-repeat:no-repeat;background-size:5px 5px,5px 5px;padding-inline-end:25px}[dir=rtl] select:not([multiple]){background-position:10px,15px}input[type=checkbox],input[type=radio]{vertical-align:middle;width:min-content;position:relative}input[type=checkbox]+label,input[type=radio]+label{display:inline-block}input[type=radio]{border-radius:100%}input[type=checkbox]:checked,input[type=radio]:checked{background-color:var(--accent)}input[type=checkbox]:checked:after{content:" ";border-right:solid var(--bg).08em;border-bottom:solid var(--bg).08em;background-color:#0000;border-radius:0;width:.18em;height:.32em;font-size:1.8em;position:absolute;top:.05em;left:.17em;transform:rotate(45deg)}input[type=radio]:checked:after{content:" ";background-color:var(--bg);border-radius:100%;width:.25em;height:.25em;font-size:32px;position:absolute;top:.125em;left:.125em}@media only screen and (width<=720px){textarea,select,input{width:100%}}input[type=color]{height:2.5rem;padding:.2rem}input[type=file]{border:0}hr{background:var(--border);border:none;height:1px;margin:1rem auto}mark{border-radius:var(--standard-border-radius);background-color:var(--marked);color:#000;padding:2px 5px}mark a{color:#0d47a1}img,video{border-radius:var(--standard-border-radius);max-width:100%;height:auto}figure{margin:0;display:block;overflow-x:auto}figure>img,figure>picture>img{margin-inline:auto;display:block}figcaption{text-align:center;color:var(--text-light);margin-block:1rem;font-size:.9rem}blockquote{border-inline-start:.35rem solid var(--accent);color:var(--text-light);margin-block:2rem;margin-inline:2rem 0;padding:.4rem .8rem;font-style:italic}cite{color:var(--text-light);font-size:.9rem;font-style:normal}dt{color:var(--text-light)}code,pre,pre span,kbd,samp{font-family:var(--mono-font);color:var(--code)}kbd{color:var(--preformatted);border:1px solid var(--preformatted);border-bottom:3px solid var(--preformatted);border-radius:var(--standard-border-radius);padding:.1rem .4rem}pre{max-width:100%;color:var(--preformatted);padding:1rem 1.4rem;overflow:auto}pre code{color:var(--preformatted);background:0 0;margin:0;padding:0}progress{width:100%}progress:indeterminate{background-color:var(--accent-bg)}progress::-webkit-progress-bar{border-radius:var(--standard-border-radius);background-color:var(--accent-bg)}progress::-webkit-progress-value{border-radius:var(--standard-border-radius);background-color:var(--accent)}progress::-moz-progress-bar{border-radius:var(--standard-border-radius);background-color:var(--accent);transition-property:width;transition-duration:.3s}progress:indeterminate::-moz-progress-bar{background-color:var(--accent-bg)}dialog{background-color:var(--bg);max-width:40rem;margin:auto}dialog::backdrop{background-color:var(--bg);opacity:.8}@media only screen and (width<=720px){dialog{max-width:100%;margin:auto 1em}}sup,sub{vertical-align:baseline;position:relative}sup{top:-.4em}sub{top:.3em}.notice{background:var(--accent-bg);border:2px solid var(--border);border-radius:var(--standard-border-radius);margin:2rem 0;padding:1.5rem}@media print{@page{margin:1cm}body{display:block}body>header{background-color:unset}body>header nav,body>footer{display:none}article{border:none;padding:0}a[href^=http]:after{content:" <" attr(href)">"}abbr[title]:after{content:" (" attr(title)")"}a{text-decoration:none}p{widows:3;orphans:3}hr{border-top:1px solid var(--border)}mark{border:1px solid var(--border)}pre,table,figure,img,svg{break-inside:avoid}pre code{white-space:pre-wrap}}
-)rawliteral";
\ No newline at end of file
+// simple.css: 9168 bytes -> 2760 bytes gzipped
+const uint8_t simple_css_gz[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xb5, 0x19, 0x5d, 0x6f, 0xe3, 0x36,
+    0xf2, 0xfd, 0x7e, 0x85, 0xe0, 0x60, 0x81, 0xb8, 0x2b, 0xf9, 0x2c, 0xd9, 0xd9, 0x24, 0x74, 0x77,
+    0xd1, 0xde, 0x01, 0x87, 0x3b, 0xe0, 0xda, 0x87, 0x2b, 0xfa, 0xb4, 0xc8, 0x01, 0x94, 0x44, 0x59,
+    0x44, 0x64, 0x51, 0x47, 0x51, 0x4e, 0x52, 0x41, 0xff, 0xfd, 0x66, 0x28, 0x4a, 0x26, 0x2d, 0x39,
+    0xc9, 0x02, 0xdb, 0x1a, 0xdd, 0x88, 0xc3, 0xe1, 0x70, 0x66, 0x38, 0x5f, 0x1c, 0x12, 0x29, 0x84,
+    0x6a, 0x83, 0xa0, 0xa6, 0x65, 0x1d, 0x64, 0xa2, 0x54, 0x24, 0xa0, 0x55, 0x55, 0xb0, 0xa0, 0x7e,
+    0xa9, 0x15, 0x3b, 0xf8, 0x7f, 0x2b, 0x78, 0xf9, 0xf8, 0x0b, 0x4d, 0x7e, 0xd3, 0xc3, 0x7f, 0x00,
+    0x82, 0xbf, 0xf8, 0xf9, 0xc8, 0x4a, 0x2e, 0xbd, 0x5f, 0xd9, 0xb3, 0x5a, 0xf8, 0xfd, 0xc0, 0x5f,
+    0xfc, 0xca, 0x0f, 0x71, 0x53, 0x7b, 0xbf, 0x01, 0x1d, 0xef, 0xdf, 0x0b, 0xff, 0x3f, 0x22, 0x16,
+    0x4a, 0x00, 0x18, 0xfe, 0xd5, 0xc0, 0x85, 0xbf, 0xf8, 0x8d, 0xed, 0x05, 0xf3, 0x7e, 0xff, 0x17,
+    0x2c, 0x92, 0x9c, 0x16, 0xfe, 0x3f, 0x59, 0x71, 0x64, 0x8a, 0x27, 0xd4, 0x5f, 0x8c, 0x9f, 0x40,
+    0xb5, 0x61, 0x0b, 0x5f, 0xb3, 0x53, 0x33, 0xc9, 0xb3, 0x5d, 0x10, 0x1c, 0x44, 0x29, 0x7a, 0xde,
+    0xfe, 0x2e, 0xca, 0x5a, 0x14, 0xb4, 0xf6, 0x7f, 0x61, 0x65, 0x21, 0xfc, 0x5f, 0x44, 0x49, 0x13,
+    0xd8, 0xe4, 0xe7, 0x32, 0xa5, 0x05, 0xf3, 0x60, 0x28, 0x60, 0x9b, 0xdf, 0xe3, 0xa6, 0x54, 0x8d,
+    0x19, 0xe1, 0xda, 0xba, 0xa2, 0x09, 0x03, 0x3a, 0xb5, 0xa2, 0x80, 0x28, 0xd3, 0x20, 0x16, 0x32,
+    0x65, 0x32, 0x90, 0x34, 0xe5, 0x4d, 0x4d, 0x6e, 0xaa, 0x67, 0x98, 0x8c, 0xf7, 0xe4, 0x2a, 0xcb,
+    0x70, 0x3b, 0x9a, 0x24, 0xac, 0x54, 0x3d, 0xe0, 0x26, 0xbb, 0xd5, 0x30, 0x05, 0xb2, 0x92, 0xab,
+    0x28, 0xc4, 0x9f, 0x19, 0x06, 0x05, 0xdf, 0xe7, 0x00, 0xbc, 0xb9, 0xc3, 0x1f, 0x52, 0xd0, 0x54,
+    0xc9, 0xd5, 0xdd, 0xfd, 0x1d, 0xa3, 0xdb, 0x91, 0x10, 0xb9, 0x5a, 0xa7, 0xdb, 0x5b, 0x1a, 0x9e,
+    0x28, 0xe7, 0xe2, 0x88, 0x78, 0x61, 0xf4, 0xe9, 0x13, 0x8b, 0x4e, 0x60, 0xbd, 0xc7, 0x91, 0xca,
+    0x6b, 0x64, 0x66, 0x09, 0xf0, 0x44, 0xa4, 0x8c, 0x5c, 0xa5, 0x77, 0x61, 0xfc, 0x69, 0x0d, 0xc3,
+    0x4a, 0xb2, 0x4c, 0xc8, 0x03, 0x55, 0x8a, 0xa5, 0xe4, 0x6a, 0xbb, 0xc5, 0x2d, 0x0e, 0x54, 0x3e,
+    0xe2, 0x28, 0x4b, 0x37, 0x30, 0x4a, 0x79, 0x4d, 0xe3, 0x02, 0xc7, 0x2c, 0xc3, 0x5f, 0xf7, 0xd3,
+    0x81, 0xa5, 0x9c, 0x7a, 0xd7, 0xb8, 0x94, 0xc9, 0x1a, 0x28, 0x16, 0x42, 0x06, 0x75, 0x92, 0xb3,
+    0x03, 0x23, 0xa0, 0x8a, 0xc7, 0x65, 0x4b, 0xb4, 0x01, 0x4c, 0x26, 0x8c, 0x46, 0x46, 0x89, 0x2d,
+    0xa5, 0x44, 0x31, 0xfe, 0x46, 0xa5, 0xa4, 0x09, 0xfe, 0xce, 0x94, 0x42, 0x63, 0xfc, 0x59, 0x3a,
+    0xc8, 0xb2, 0x78, 0xb3, 0x5e, 0x4f, 0x74, 0x90, 0x65, 0x6c, 0x7d, 0x7f, 0xff, 0xa6, 0x0e, 0xb2,
+    0xf5, 0xa7, 0xe8, 0x3e, 0x9a, 0xe8, 0x20, 0x49, 0x12, 0x47, 0xea, 0x30, 0x0c, 0x3b, 0x7e, 0xd8,
+    0xfb, 0x47, 0x9e, 0x32, 0xd1, 0x0a, 0x38, 0x76, 0xae, 0x5e, 0xc8, 0xea, 0xae, 0xeb, 0x7e, 0xf0,
+    0x49, 0x8c, 0x2b, 0x99, 0x4f, 0x68, 0xa6, 0x98, 0x6c, 0x63, 0xf1, 0x1c, 0xd4, 0xfc, 0x0f, 0x5e,
+    0xee, 0x89, 0xb1, 0x06, 0x80, 0x74, 0xb8, 0x3d, 0x95, 0x8c, 0xfa, 0x35, 0x2b, 0x58, 0xa2, 0x7c,
+    0x5e, 0x56, 0x8d, 0xf2, 0x2b, 0x29, 0xf6, 0x92, 0xd5, 0x75, 0x1b, 0x3c, 0xb1, 0xf8, 0x91, 0x2b,
+    0xf4, 0x10, 0x46, 0x25, 0x2d, 0x13, 0x46, 0x4a, 0x51, 0x82, 0x69, 0x1d, 0xc4, 0x1f, 0x13, 0xe0,
+    0xd9, 0xb8, 0xcb, 0xd5, 0xa1, 0x68, 0xd1, 0x8a, 0x83, 0x8c, 0x1e, 0x78, 0xf1, 0x62, 0xc4, 0x1c,
+    0x1d, 0x6f, 0xb9, 0xab, 0x13, 0x29, 0x8a, 0x22, 0x88, 0x59, 0x4e, 0x8f, 0x5c, 0x48, 0x52, 0x1f,
+    0xe0, 0x68, 0xf2, 0x2e, 0x16, 0xe9, 0x4b, 0x7f, 0x40, 0x66, 0x09, 0x72, 0xb9, 0xdc, 0xc5, 0x34,
+    0x79, 0xdc, 0x4b, 0xd1, 0x94, 0x69, 0x60, 0x4f, 0xa2, 0xda, 0xf6, 0x92, 0xa7, 0x80, 0x75, 0xa8,
+    0x0a, 0xaa, 0x18, 0xce, 0x36, 0x87, 0xb2, 0x26, 0x61, 0x26, 0xbd, 0x03, 0x2f, 0xaf, 0xb7, 0x37,
+    0x12, 0x1c, 0xfb, 0x7e, 0xfd, 0x61, 0xe9, 0x01, 0x68, 0x07, 0x26, 0xb4, 0xe7, 0x25, 0x59, 0xef,
+    0x34, 0x6f, 0xa0, 0x13, 0x46, 0xc2, 0x55, 0x88, 0x38, 0x3b, 0xf0, 0x7d, 0x16, 0xe4, 0x4c, 0x1f,
+    0x69, 0xb8, 0xba, 0xd9, 0x81, 0xa6, 0x81, 0xe4, 0x0b, 0x41, 0xfa, 0x9a, 0xad, 0x2f, 0x3f, 0xb4,
+    0x7a, 0xaf, 0x7e, 0x0b, 0x12, 0xf5, 0xc0, 0x9c, 0xd1, 0x14, 0x55, 0x3c, 0xcf, 0xe0, 0x68, 0x49,
+    0x20, 0xc2, 0xa0, 0x79, 0xa5, 0xc4, 0x81, 0x84, 0xd5, 0xb3, 0x07, 0xde, 0xcd, 0x53, 0xcf, 0x48,
+    0xa2, 0x67, 0x97, 0x3b, 0x6d, 0x57, 0x14, 0x0c, 0xab, 0x24, 0xb8, 0x92, 0xc9, 0x9d, 0xbd, 0x67,
+    0xf8, 0xd7, 0x20, 0xdc, 0x55, 0x34, 0x4d, 0xf1, 0x28, 0xd7, 0xde, 0x0a, 0x19, 0xf7, 0x22, 0xf8,
+    0xc7, 0xe6, 0xe5, 0x0b, 0x11, 0x65, 0xf1, 0x12, 0x24, 0x39, 0x2f, 0xd2, 0xb6, 0x17, 0x38, 0x88,
+    0x0b, 0x91, 0x3c, 0x62, 0x4c, 0x90, 0x8a, 0x9c, 0xe3, 0x7b, 0x79, 0x08, 0x68, 0xcf, 0xc1, 0x13,
+    0x4f, 0x55, 0x4e, 0xc2, 0x68, 0xbd, 0x86, 0x18, 0x61, 0x14, 0x15, 0xe2, 0x06, 0xb4, 0x51, 0xc2,
+    0x59, 0x50, 0x59, 0xf8, 0xdb, 0x35, 0x2a, 0x6f, 0x82, 0x7e, 0xa0, 0xbc, 0x6c, 0x0d, 0xa7, 0x81,
+    0x12, 0x15, 0xaa, 0x74, 0xdc, 0x37, 0x83, 0xa3, 0x06, 0x9d, 0x9d, 0x1f, 0x73, 0xef, 0x4f, 0x73,
+    0x3a, 0x30, 0xba, 0xd3, 0x74, 0x2e, 0x28, 0xce, 0x08, 0x8a, 0x28, 0x5b, 0xe4, 0x68, 0xd0, 0x12,
+    0x4a, 0xeb, 0x69, 0xbe, 0x7a, 0x0e, 0xac, 0x93, 0x5f, 0xdd, 0x23, 0x47, 0x20, 0xfd, 0x09, 0xb4,
+    0xd1, 0x90, 0xa8, 0xb5, 0xa8, 0x6d, 0xdc, 0x45, 0xd1, 0xea, 0x93, 0xc6, 0xd9, 0xbc, 0x86, 0xa3,
+    0x31, 0xb6, 0xad, 0x6d, 0x64, 0xdb, 0xad, 0x06, 0xde, 0xb4, 0x13, 0xcb, 0xeb, 0xf2, 0x4f, 0xad,
+    0xcd, 0x94, 0xa6, 0x5f, 0xb5, 0x83, 0x4a, 0xfb, 0x43, 0x5e, 0x77, 0x95, 0x9f, 0x87, 0x7e, 0x1e,
+    0xf9, 0xf9, 0xc6, 0xcf, 0xb7, 0x7e, 0x7e, 0xe3, 0xc3, 0x32, 0x8c, 0x2b, 0x59, 0x21, 0x9e, 0x82,
+    0x27, 0x49, 0x2b, 0x12, 0x83, 0x33, 0x3f, 0x06, 0x4f, 0xa0, 0x90, 0x6e, 0x40, 0x6d, 0x5d, 0xab,
+    0x0e, 0x87, 0x20, 0x89, 0x16, 0xe2, 0x81, 0x0b, 0x32, 0x56, 0x7a, 0x90, 0x27, 0xbc, 0x6b, 0x7d,
+    0x98, 0x3f, 0x7e, 0xbe, 0x8d, 0xe0, 0xf0, 0x97, 0xad, 0xa3, 0x93, 0xa8, 0x3f, 0x39, 0xd0, 0x8a,
+    0x0d, 0x0b, 0x8d, 0x16, 0x6c, 0x71, 0x6e, 0x6f, 0x66, 0x04, 0x8f, 0x34, 0xb0, 0xa3, 0x3e, 0x25,
+    0x47, 0x5e, 0x73, 0x88, 0x65, 0xed, 0xd4, 0x43, 0x96, 0x1d, 0x25, 0x3a, 0x4a, 0xb6, 0xfa, 0xf0,
+    0x53, 0x96, 0x08, 0x49, 0x15, 0x17, 0x65, 0x1f, 0x4e, 0xe2, 0x06, 0x9c, 0xa6, 0xf4, 0x57, 0xe6,
+    0x2f, 0x1d, 0x3e, 0x74, 0xc8, 0xfa, 0xaa, 0x5e, 0x2a, 0xf6, 0xb9, 0x6e, 0xe2, 0x03, 0x57, 0x0f,
+    0x36, 0x08, 0xc2, 0x18, 0x73, 0x21, 0xfd, 0xb2, 0x87, 0xd6, 0x64, 0xaf, 0x73, 0x5b, 0x32, 0xbc,
+    0xec, 0x5e, 0x75, 0xe6, 0xe5, 0x6e, 0xc6, 0xc1, 0xfb, 0x28, 0x35, 0xd8, 0x5c, 0x7f, 0x64, 0xda,
+    0xbc, 0x9c, 0xb0, 0x52, 0x62, 0x34, 0x2f, 0x76, 0xb3, 0x22, 0x1a, 0x91, 0xbe, 0x52, 0xa8, 0x16,
+    0xc6, 0x28, 0xff, 0x59, 0xc9, 0x86, 0x19, 0x09, 0xc8, 0x00, 0xf4, 0x87, 0xc0, 0x7d, 0x82, 0xf4,
+    0x11, 0xfc, 0x34, 0x36, 0xb4, 0x86, 0xf1, 0x43, 0x9b, 0x34, 0xb2, 0x06, 0x9e, 0x4b, 0x81, 0x8e,
+    0x05, 0x06, 0xc3, 0xd2, 0x4b, 0x42, 0x0e, 0x6b, 0xc6, 0x80, 0x35, 0x3f, 0x79, 0xc1, 0x77, 0x3b,
+    0x5b, 0xfd, 0xb4, 0xdc, 0xb3, 0x87, 0x76, 0x0c, 0x57, 0x1d, 0x8d, 0x63, 0xf9, 0x55, 0x71, 0x55,
+    0xb0, 0x91, 0xa1, 0x9c, 0x15, 0xd5, 0xb9, 0x3e, 0x02, 0x54, 0x19, 0x01, 0xbe, 0x98, 0xc4, 0xaf,
+    0xc9, 0x74, 0xad, 0x5e, 0x0a, 0xc8, 0xdb, 0x02, 0xd3, 0xa2, 0xb1, 0x0c, 0xc2, 0xca, 0x3e, 0x2b,
+    0x6a, 0x1b, 0x1a, 0xec, 0x04, 0xc5, 0xbd, 0x9e, 0x53, 0xe8, 0xd2, 0xe0, 0x4d, 0xcd, 0xe7, 0x8c,
+    0xd0, 0xc4, 0x98, 0x2e, 0xcf, 0x1b, 0xd3, 0x72, 0x11, 0xde, 0x48, 0x0b, 0x1a, 0x67, 0x56, 0xd1,
+    0x2e, 0x82, 0x51, 0x56, 0x25, 0x38, 0x46, 0xc3, 0xc1, 0x54, 0x48, 0x26, 0x92, 0xa6, 0x0e, 0xd0,
+    0xa9, 0x60, 0x47, 0x7f, 0x0e, 0x48, 0x9e, 0x72, 0x26, 0xd9, 0xf5, 0xc0, 0xd4, 0xd2, 0x58, 0xd2,
+    0xc0, 0xe3, 0x1c, 0xae, 0xeb, 0x4d, 0x8e, 0x23, 0x39, 0x82, 0x2e, 0x5b, 0xd1, 0x28, 0x7d, 0x52,
+    0xd1, 0x05, 0x2f, 0x32, 0xf3, 0x81, 0xc8, 0x32, 0x58, 0x8e, 0xce, 0xd6, 0x99, 0x04, 0x55, 0xd2,
+    0xe3, 0x68, 0x16, 0x3a, 0x34, 0xaf, 0x3d, 0x27, 0x23, 0x9f, 0xfb, 0x4d, 0x64, 0x2d, 0xf4, 0x9a,
+    0xc2, 0xb7, 0x46, 0x02, 0xca, 0x8c, 0x82, 0x3d, 0x07, 0x18, 0x05, 0x09, 0x46, 0xc1, 0x1d, 0x24,
+    0xed, 0x04, 0xeb, 0x00, 0x50, 0x15, 0xd4, 0x62, 0xba, 0x1c, 0x0e, 0xa8, 0x3e, 0x02, 0xcf, 0x64,
+    0x13, 0x9d, 0x5a, 0x02, 0x88, 0x44, 0x87, 0x7a, 0x48, 0x30, 0x63, 0x5d, 0x30, 0x5a, 0x2b, 0x30,
+    0x50, 0xab, 0xde, 0xd6, 0x02, 0x94, 0xbb, 0xaf, 0x73, 0x86, 0xa2, 0x00, 0xf7, 0x74, 0x99, 0xf2,
+    0x0a, 0xee, 0xf2, 0x05, 0x80, 0x76, 0x40, 0xe7, 0xa5, 0x16, 0x47, 0x67, 0x61, 0x7b, 0x19, 0xb5,
+    0x97, 0x9c, 0xe2, 0xe3, 0x85, 0xf0, 0x34, 0xa4, 0x3a, 0xb7, 0xa2, 0x37, 0x95, 0xd5, 0x6c, 0xb9,
+    0x3f, 0xf5, 0xd3, 0xe5, 0x28, 0xaa, 0xa9, 0x1e, 0x42, 0x3b, 0x59, 0xae, 0xc2, 0x11, 0x34, 0x17,
+    0xa4, 0x76, 0x6f, 0xca, 0x63, 0xfc, 0xc2, 0x06, 0xad, 0xc0, 0x7a, 0x25, 0x68, 0xd9, 0x01, 0xf6,
+    0x5e, 0x69, 0x66, 0x3e, 0x57, 0x14, 0x02, 0xc5, 0x2b, 0xf3, 0xda, 0x69, 0xdb, 0x8b, 0x6e, 0x32,
+    0x17, 0x91, 0x27, 0x4e, 0xf3, 0xce, 0xc4, 0x67, 0xf1, 0x30, 0x1c, 0x83, 0x96, 0xdc, 0xb6, 0x0b,
+    0x2b, 0xa3, 0x4e, 0xd4, 0x34, 0x86, 0x2d, 0xc8, 0x78, 0x35, 0x54, 0xe6, 0x7e, 0xca, 0x14, 0xe5,
+    0x45, 0x0d, 0x75, 0x35, 0x3b, 0xd5, 0xd6, 0xef, 0xad, 0x16, 0xbf, 0x8b, 0x09, 0x0c, 0x25, 0xa0,
+    0x29, 0x3c, 0x31, 0x1b, 0x6b, 0xd6, 0xc0, 0x71, 0x04, 0x55, 0x44, 0xa2, 0x24, 0xbb, 0xbe, 0x98,
+    0xdb, 0xac, 0x3f, 0x0c, 0xe8, 0xe6, 0x88, 0xfb, 0x92, 0x31, 0xc4, 0x6b, 0xe3, 0xa9, 0xee, 0xd4,
+    0x43, 0xd7, 0x5f, 0x3b, 0x48, 0x36, 0xf2, 0xb3, 0x54, 0xc5, 0x83, 0x67, 0x13, 0x2f, 0x58, 0xa6,
+    0xde, 0xa9, 0x7a, 0x7b, 0x99, 0x56, 0xb9, 0xa9, 0x47, 0xd7, 0x17, 0x78, 0x5a, 0x83, 0x86, 0x25,
+    0xdc, 0xa2, 0x21, 0xf4, 0x65, 0x9c, 0x15, 0x29, 0xc4, 0x18, 0x1f, 0xb6, 0x29, 0xc4, 0xbe, 0xfd,
+    0x53, 0x95, 0xb7, 0xb3, 0x23, 0xd7, 0xc0, 0x82, 0x97, 0x47, 0x24, 0xe3, 0x12, 0x22, 0x86, 0x2e,
+    0xbb, 0x21, 0x21, 0x27, 0x68, 0x0e, 0xe7, 0xe0, 0x11, 0x7b, 0x33, 0x8f, 0xed, 0x80, 0xed, 0x02,
+    0x53, 0xef, 0x65, 0xd0, 0xda, 0x77, 0x54, 0xc3, 0xef, 0xbb, 0x6c, 0x98, 0x50, 0xb0, 0xd1, 0x21,
+    0x78, 0x5a, 0x31, 0x0f, 0x1b, 0x7e, 0x34, 0x7f, 0x07, 0x3e, 0x1d, 0x26, 0x2d, 0x66, 0x46, 0x12,
+    0xfd, 0xe8, 0x7c, 0xb9, 0x2d, 0xcf, 0x38, 0x49, 0x0a, 0x7a, 0x4e, 0xca, 0x30, 0x7d, 0xa2, 0x36,
+    0x00, 0x3a, 0xe3, 0x4b, 0x63, 0xee, 0x58, 0xdd, 0x9e, 0x58, 0x6d, 0x0e, 0x40, 0xfe, 0xa5, 0x75,
+    0xbd, 0x7e, 0x87, 0xc5, 0x70, 0xa0, 0xeb, 0x62, 0x53, 0x1d, 0x43, 0xf5, 0x33, 0x88, 0x1d, 0xf4,
+    0xcb, 0x03, 0x37, 0x02, 0x8e, 0x24, 0x7b, 0x03, 0x7f, 0xea, 0x1d, 0xfd, 0x76, 0x3d, 0xee, 0xfe,
+    0x55, 0x54, 0xac, 0x7c, 0xf8, 0x62, 0x36, 0xfc, 0xf8, 0x83, 0x2b, 0xd6, 0x2c, 0x52, 0xeb, 0x5a,
+    0x51, 0x5f, 0x4f, 0xbb, 0x98, 0xb6, 0x1e, 0x5c, 0xec, 0x75, 0xa7, 0x30, 0x5b, 0x5b, 0xe1, 0xaf,
+    0xa0, 0x55, 0xcd, 0xc8, 0xf0, 0xb1, 0x3b, 0xbf, 0x28, 0x64, 0x7c, 0xdf, 0x48, 0xf6, 0xa5, 0x5f,
+    0xd5, 0x3b, 0x11, 0x5e, 0xd7, 0x4c, 0x46, 0x1c, 0xe3, 0x7f, 0xa7, 0xa0, 0x92, 0xcc, 0xdf, 0xf2,
+    0x15, 0xeb, 0x2e, 0xa6, 0xdd, 0xce, 0xad, 0x71, 0x3b, 0x24, 0xf0, 0x66, 0x2c, 0x3b, 0x57, 0xa4,
+    0x82, 0x98, 0xaa, 0xf2, 0x5e, 0xd8, 0xeb, 0xa8, 0x5c, 0xbe, 0x4d, 0xa2, 0x57, 0x81, 0x97, 0xd0,
+    0xca, 0x36, 0x24, 0x5b, 0x9d, 0xd3, 0x4d, 0x66, 0xbb, 0x1b, 0xee, 0x45, 0xc2, 0xba, 0xa7, 0xf0,
+    0x12, 0xaa, 0x1f, 0xae, 0xbe, 0x29, 0x36, 0xe8, 0xb6, 0x4a, 0x4e, 0x53, 0xa8, 0x3c, 0x74, 0xc0,
+    0xb2, 0x2e, 0xd1, 0x56, 0xd0, 0x72, 0xb8, 0x74, 0xb4, 0xb7, 0xb3, 0x1b, 0x24, 0x03, 0x03, 0xb3,
+    0x29, 0x76, 0x56, 0x98, 0x6f, 0x6b, 0x93, 0xbc, 0x7e, 0xce, 0x5d, 0x41, 0x63, 0x56, 0x8c, 0xf5,
+    0x8a, 0xbb, 0x6b, 0x5f, 0x47, 0x03, 0xc1, 0x1a, 0xaa, 0xbe, 0x93, 0x80, 0x9d, 0xb9, 0x75, 0xe8,
+    0xd9, 0x43, 0x53, 0x28, 0x5e, 0x41, 0x65, 0xef, 0x9c, 0x26, 0x3f, 0x40, 0x66, 0x27, 0x28, 0x08,
+    0x95, 0xc1, 0x1e, 0xf5, 0x06, 0x07, 0x7a, 0xbd, 0xbd, 0x49, 0xd9, 0xde, 0x57, 0x70, 0x3f, 0x80,
+    0xea, 0x0c, 0x13, 0xbc, 0xb7, 0xbd, 0xff, 0xe0, 0x5b, 0x72, 0xdc, 0x84, 0x1f, 0x96, 0xfe, 0xf9,
+    0xaa, 0x70, 0xa3, 0x97, 0xb9, 0x68, 0xe7, 0x54, 0x1c, 0x15, 0x54, 0x02, 0xca, 0x29, 0x8c, 0x31,
+    0x09, 0x2d, 0x92, 0x6b, 0x64, 0xd9, 0x0b, 0x74, 0xee, 0x5a, 0xfa, 0x0e, 0x04, 0xd3, 0x8f, 0xbd,
+    0x4e, 0xb2, 0x8a, 0xe9, 0x24, 0x64, 0xbe, 0xec, 0x39, 0x6d, 0x2c, 0x40, 0xc2, 0x83, 0xff, 0x7d,
+    0xf3, 0x77, 0x0c, 0x54, 0xe6, 0xcc, 0x58, 0x99, 0x92, 0x08, 0xe0, 0x56, 0x4e, 0x7c, 0x5b, 0x55,
+    0x23, 0xb3, 0xc8, 0x8e, 0x8f, 0x5c, 0xda, 0x77, 0xa9, 0x24, 0x67, 0xc9, 0x23, 0xd8, 0x9b, 0x7b,
+    0xbf, 0x05, 0xcd, 0x88, 0x87, 0x16, 0x0a, 0x2e, 0x6c, 0x26, 0x17, 0xc6, 0x4d, 0x0f, 0x3c, 0x4d,
+    0x8b, 0x21, 0x7b, 0x1e, 0xc0, 0x00, 0x07, 0xc7, 0x1f, 0x77, 0x90, 0xac, 0x80, 0x62, 0xe5, 0xc8,
+    0x66, 0x37, 0xf8, 0xa8, 0x2d, 0x61, 0xba, 0xcd, 0x47, 0xd7, 0x42, 0x1c, 0xf3, 0x9c, 0xf2, 0xe4,
+    0xba, 0x91, 0xb6, 0x96, 0xb9, 0xcd, 0x88, 0xfe, 0x82, 0x0b, 0xeb, 0x84, 0xc2, 0x30, 0xf3, 0x7a,
+    0x6c, 0x58, 0xbe, 0x4a, 0xd5, 0x74, 0x3f, 0x87, 0xab, 0xc0, 0xc2, 0x5b, 0x8c, 0xee, 0xad, 0xc3,
+    0x84, 0xe3, 0x07, 0xfb, 0xe5, 0x6a, 0x7d, 0x07, 0x3e, 0xe9, 0x26, 0xa1, 0x79, 0x94, 0x73, 0x96,
+    0xae, 0xd6, 0xf0, 0xdf, 0x59, 0xe8, 0x58, 0x9b, 0x13, 0x58, 0x85, 0xb8, 0xc4, 0xd4, 0x8b, 0xab,
+    0x4d, 0xe4, 0x34, 0x8a, 0xc2, 0x15, 0x4e, 0x8e, 0x07, 0x43, 0x63, 0xd8, 0xaf, 0x51, 0x70, 0xe5,
+    0x85, 0x5c, 0xb2, 0x5a, 0xdf, 0xe0, 0x35, 0x08, 0x0a, 0x28, 0xa0, 0x71, 0x8b, 0x15, 0x39, 0x9a,
+    0x3a, 0x36, 0x84, 0x89, 0x14, 0x8a, 0x2a, 0xd6, 0xfb, 0xd1, 0xb2, 0xbb, 0xa8, 0xbb, 0x39, 0xf9,
+    0xdf, 0x0a, 0x10, 0xf6, 0x91, 0x0d, 0x12, 0x44, 0x37, 0x96, 0x04, 0x7a, 0x60, 0x35, 0xcc, 0x22,
+    0xb4, 0xff, 0x79, 0x01, 0xc2, 0xc8, 0x92, 0x00, 0xbf, 0xdf, 0x59, 0x09, 0xce, 0x47, 0x3b, 0x2b,
+    0xf0, 0x38, 0xa7, 0x8e, 0x62, 0x3c, 0xb4, 0xc3, 0x4d, 0xf1, 0x2c, 0xcc, 0xea, 0x4e, 0x9c, 0x85,
+    0x9d, 0xf1, 0x62, 0xbc, 0x49, 0x40, 0x0a, 0xcc, 0xed, 0x1b, 0x3a, 0x99, 0x2b, 0xa1, 0xfa, 0xc8,
+    0x3e, 0x94, 0xfb, 0x73, 0x8d, 0x51, 0x7c, 0x95, 0x68, 0xbf, 0x29, 0x6d, 0xcc, 0x9f, 0x41, 0xff,
+    0xba, 0x31, 0xdc, 0x65, 0xd0, 0xa4, 0x4e, 0x15, 0x59, 0x1f, 0x67, 0xf4, 0x56, 0x70, 0x2f, 0x19,
+    0x30, 0xf4, 0x4b, 0x8b, 0xf5, 0x06, 0xf0, 0x6d, 0x75, 0xad, 0x93, 0xab, 0x8c, 0x80, 0x5a, 0xa0,
+    0xbe, 0x7e, 0x68, 0xc7, 0x2b, 0xb1, 0x93, 0x14, 0x76, 0x63, 0xcb, 0xf1, 0xd9, 0xc6, 0xfe, 0x82,
+    0x5c, 0x98, 0xcf, 0x8a, 0x27, 0xca, 0x80, 0x5a, 0xa7, 0x70, 0xd7, 0x0b, 0x5c, 0x72, 0xb8, 0x7c,
+    0xc8, 0xea, 0xd3, 0xb6, 0xef, 0xa5, 0x06, 0xb1, 0xdd, 0xd4, 0x26, 0xe1, 0x5c, 0x53, 0x57, 0x4f,
+    0xfd, 0xaf, 0x11, 0x6a, 0xac, 0x9b, 0x9c, 0xbb, 0xc3, 0x6a, 0xa3, 0x6b, 0xa5, 0xb9, 0xae, 0xc5,
+    0xbb, 0xf6, 0x8c, 0x4e, 0x3d, 0xef, 0x41, 0xb6, 0xc8, 0x2d, 0xa2, 0x57, 0x5b, 0xdd, 0x02, 0xbc,
+    0x3b, 0x31, 0xa7, 0xbb, 0x56, 0x5c, 0x81, 0x80, 0x49, 0x97, 0xc0, 0x35, 0xff, 0x62, 0xfb, 0xfb,
+    0x4c, 0x16, 0x7b, 0x79, 0xdf, 0x40, 0xec, 0x52, 0x75, 0x69, 0x71, 0x87, 0x4f, 0x48, 0xe6, 0xae,
+    0xc9, 0x3c, 0x48, 0x8c, 0xa5, 0xff, 0x18, 0xc3, 0x05, 0x83, 0x1e, 0xaa, 0x99, 0xe7, 0x98, 0xf1,
+    0xad, 0xd1, 0x15, 0x1b, 0x69, 0x2c, 0x3b, 0x58, 0xe7, 0xec, 0x62, 0xbf, 0x46, 0x5d, 0x2c, 0x27,
+    0xe6, 0x90, 0x86, 0x58, 0xba, 0x79, 0x0f, 0xee, 0xbb, 0x8c, 0xd7, 0x6d, 0x57, 0x68, 0x55, 0x77,
+    0x95, 0x36, 0x59, 0xc7, 0xa8, 0x2f, 0x73, 0xef, 0x34, 0x9f, 0x42, 0x4d, 0x60, 0x34, 0xec, 0xde,
+    0xac, 0x51, 0x7d, 0xa8, 0x87, 0xd7, 0x54, 0x70, 0x8a, 0x1c, 0xd8, 0xbf, 0x9a, 0xb6, 0x90, 0xba,
+    0xf1, 0xbe, 0x6f, 0xc5, 0xae, 0x01, 0x06, 0x19, 0x14, 0x6e, 0x00, 0x4c, 0x42, 0x86, 0xa6, 0x68,
+    0xa5, 0x6f, 0x96, 0xc0, 0xe3, 0x42, 0x32, 0xbc, 0xcc, 0x0d, 0x90, 0x20, 0xa6, 0xf2, 0x7b, 0x44,
+    0xa0, 0xf7, 0x6d, 0x76, 0xa4, 0x45, 0xc3, 0xbe, 0xdf, 0x76, 0xce, 0x5e, 0xf8, 0xb4, 0xf8, 0xe7,
+    0x48, 0xb5, 0xec, 0xd3, 0xa7, 0x4e, 0x53, 0xb8, 0x45, 0x05, 0x45, 0xd3, 0x0b, 0xd1, 0xe7, 0x62,
+    0xcf, 0xa4, 0x8d, 0xe9, 0xe3, 0xac, 0x36, 0xf5, 0x85, 0xa3, 0x9a, 0x65, 0xf3, 0x4d, 0x85, 0x0e,
+    0x9d, 0x89, 0xcb, 0xf9, 0xf7, 0xc2, 0x93, 0x9a, 0xb6, 0xc6, 0x7e, 0x35, 0x21, 0xb8, 0x3c, 0x05,
+    0xe6, 0x5f, 0xa3, 0x63, 0xbd, 0x04, 0xbf, 0x2f, 0xdd, 0x1a, 0xd6, 0x66, 0x6f, 0x2f, 0x7a, 0x7b,
+    0x2f, 0xc4, 0x07, 0x9c, 0xba, 0xa9, 0xfc, 0xba, 0x89, 0xcf, 0xcb, 0xcd, 0x98, 0x42, 0x96, 0xc6,
+    0x36, 0xfd, 0xb4, 0xbc, 0x84, 0x15, 0x2d, 0x16, 0x02, 0xc1, 0x6a, 0xab, 0x6f, 0xe8, 0xb1, 0x1e,
+    0xad, 0x36, 0x30, 0x58, 0x41, 0x25, 0xcc, 0x13, 0x36, 0xcd, 0xbe, 0xd3, 0x16, 0x58, 0xf4, 0xdd,
+    0xba, 0x38, 0xe7, 0x31, 0xda, 0x3c, 0x49, 0x1a, 0x2d, 0x55, 0x92, 0x97, 0xaa, 0xfd, 0x09, 0x7b,
+    0x91, 0xe3, 0xdb, 0x5b, 0xd2, 0x3f, 0x58, 0x9e, 0xdd, 0x8b, 0x5e, 0x7d, 0xf7, 0x6d, 0xca, 0x9a,
+    0x29, 0xe7, 0xb5, 0xb4, 0xa4, 0x47, 0xdf, 0x7e, 0xf6, 0x1c, 0x88, 0xe9, 0x67, 0x1f, 0xd3, 0x11,
+    0x9a, 0xef, 0x35, 0x76, 0xf4, 0x6b, 0x0e, 0x21, 0xe7, 0xbf, 0x9f, 0x73, 0xa5, 0xaa, 0x87, 0x49,
+    0x39, 0xf7, 0xe3, 0xc2, 0x83, 0x50, 0x24, 0xaf, 0x11, 0x67, 0xb9, 0xf8, 0xb2, 0xb0, 0x1f, 0x58,
+    0x26, 0xc8, 0xd7, 0x06, 0x59, 0x4f, 0x2f, 0x17, 0x4b, 0xc0, 0x9e, 0x7f, 0x6b, 0xab, 0x30, 0x5a,
+    0x89, 0xa7, 0x9a, 0x6c, 0x76, 0x42, 0x56, 0x39, 0xb8, 0x06, 0xd9, 0xe8, 0x42, 0xe9, 0xcd, 0xae,
+    0x93, 0x5d, 0x0a, 0x5d, 0xc4, 0xc1, 0xdc, 0xa4, 0x6f, 0xf3, 0xa6, 0x5c, 0xf0, 0xb1, 0x72, 0xa8,
+    0x8f, 0xe0, 0x1a, 0xba, 0x3f, 0xc3, 0x4b, 0x6c, 0x03, 0x12, 0x7a, 0x14, 0x3c, 0x3d, 0x05, 0xe1,
+    0xa7, 0x1c, 0x12, 0x66, 0xa0, 0x7b, 0xf9, 0x04, 0x80, 0xfa, 0xb9, 0xb3, 0xeb, 0xfe, 0xf2, 0x7f,
+    0x0c, 0x75, 0x80, 0xc9, 0xd0, 0x23, 0x00, 0x00,
+};
+const WebAsset simple_css = {simple_css_gz, sizeof(simple_css_gz), "text/css", "\"5c9a427848ecfc48\""};
+
+// logout.html: 204 bytes -> 179 bytes gzipped
+const uint8_t logout_html_gz[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x45, 0x8e, 0xbb, 0x0e, 0xc2, 0x30,
+    0x14, 0x43, 0xf7, 0x7e, 0xc5, 0x25, 0x33, 0x55, 0xc4, 0xc6, 0x90, 0x64, 0xe0, 0x25, 0x90, 0x8a,
+    0x60, 0x28, 0x03, 0xe3, 0x25, 0xb9, 0x34, 0x11, 0x69, 0x52, 0xb5, 0x51, 0x2b, 0xfe, 0x9e, 0x3e,
+    0x06, 0x46, 0x5b, 0x3e, 0xb6, 0xc5, 0xea, 0x70, 0xdb, 0x97, 0xcf, 0xfb, 0x11, 0xce, 0xe5, 0xb5,
+    0x50, 0x99, 0xb0, 0xa9, 0xf6, 0xe0, 0x31, 0x54, 0x92, 0x51, 0x60, 0x93, 0x41, 0x68, 0x54, 0x06,
+    0x20, 0x6a, 0x4a, 0x08, 0x01, 0x6b, 0x92, 0xac, 0x77, 0x34, 0x34, 0xb1, 0x4d, 0x0c, 0x74, 0x0c,
+    0x89, 0x42, 0x92, 0x6c, 0x70, 0x26, 0x59, 0x69, 0xa8, 0x77, 0x9a, 0xf2, 0x59, 0xac, 0xc1, 0x05,
+    0x97, 0x1c, 0xfa, 0xbc, 0xd3, 0xe8, 0x49, 0x6e, 0xd8, 0xbf, 0x46, 0x5b, 0x6c, 0x3b, 0x1a, 0xb1,
+    0x47, 0x79, 0xca, 0xb7, 0xd3, 0x0c, 0x5f, 0x76, 0xc4, 0x2b, 0x9a, 0xef, 0x9c, 0x6b, 0x94, 0x40,
+    0xb0, 0x2d, 0xbd, 0x25, 0xe3, 0x4c, 0x15, 0xb1, 0x82, 0x1d, 0xea, 0x0f, 0x5c, 0x82, 0xe0, 0xa8,
+    0x04, 0x6f, 0x26, 0x66, 0x09, 0x8f, 0xec, 0x78, 0x5a, 0x65, 0x3f, 0xe2, 0xa6, 0xaf, 0x2a, 0xcc,
+    0x00, 0x00, 0x00,
+};
+const WebAsset logout_html = {logout_html_gz, sizeof(logout_html_gz), "text/html", "\"dec0bfdc59a92bf3\""};
+
+// reboot.html: 499 bytes -> 318 bytes gzipped
+const uint8_t reboot_html_gz[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x55, 0x51, 0x41, 0x4e, 0xc3, 0x30,
+    0x10, 0xbc, 0xe7, 0x15, 0x8b, 0x4f, 0x89, 0x44, 0x9b, 0x94, 0x5e, 0x90, 0xe2, 0xe4, 0x00, 0x14,
+    0x81, 0x04, 0x02, 0xa1, 0x70, 0xe0, 0xe8, 0xda, 0xdb, 0xd4, 0x28, 0xb1, 0xa3, 0x64, 0xd3, 0x52,
+    0x21, 0xfe, 0x8e, 0xdd, 0x34, 0x25, 0x1c, 0x2c, 0xaf, 0x66, 0x67, 0x76, 0xec, 0x59, 0x7e, 0x71,
+    0xf7, 0x72, 0x5b, 0x7c, 0xbc, 0xae, 0xe0, 0xa1, 0x78, 0x7e, 0xca, 0x03, 0xbe, 0xa5, 0xba, 0x82,
+    0x4a, 0x98, 0x32, 0x63, 0x68, 0x98, 0x07, 0x50, 0xa8, 0x3c, 0x00, 0xe0, 0x35, 0x92, 0x00, 0xb9,
+    0x15, 0x6d, 0x87, 0x94, 0xb1, 0xf7, 0xe2, 0x7e, 0x76, 0xed, 0xfb, 0xf1, 0x40, 0xe0, 0x6b, 0xab,
+    0x0e, 0x9e, 0xbe, 0xf4, 0xe4, 0x37, 0x5c, 0x5b, 0x4b, 0xda, 0x94, 0x97, 0xd0, 0x22, 0xf5, 0xad,
+    0x71, 0x25, 0x90, 0x85, 0x5a, 0x68, 0x03, 0x8d, 0x28, 0x11, 0xdc, 0xcd, 0xbb, 0x46, 0x18, 0xd0,
+    0x2a, 0x63, 0xd2, 0xf6, 0x86, 0x94, 0xdd, 0x3b, 0xc3, 0x65, 0xc2, 0x63, 0x8f, 0xe7, 0xd0, 0xa1,
+    0xb4, 0x46, 0x75, 0xde, 0xc1, 0xcd, 0xe4, 0x9d, 0x6c, 0x75, 0x43, 0x40, 0x87, 0x06, 0x33, 0x46,
+    0xf8, 0x45, 0xf1, 0xa7, 0xd8, 0x89, 0x01, 0x65, 0xde, 0x73, 0x27, 0xda, 0x51, 0x03, 0x19, 0x5c,
+    0x25, 0xa9, 0xc3, 0x36, 0xbd, 0x91, 0xa4, 0xad, 0x81, 0xb3, 0x43, 0x18, 0xc1, 0xb7, 0x6b, 0xc0,
+    0x84, 0x3a, 0x56, 0x33, 0x58, 0xa4, 0xc7, 0x96, 0xde, 0x40, 0x38, 0x82, 0x1c, 0x92, 0x51, 0x01,
+    0xb0, 0xd7, 0xc6, 0xcd, 0x98, 0x57, 0x56, 0x8a, 0xe3, 0xd4, 0x0c, 0x58, 0xcc, 0x06, 0xcd, 0x0f,
+    0x60, 0xd5, 0xe1, 0x99, 0xa9, 0xac, 0xec, 0x6b, 0x34, 0x34, 0x2f, 0x91, 0x56, 0x15, 0xfa, 0xf2,
+    0xe6, 0xf0, 0xa8, 0xc2, 0xc9, 0x57, 0xa3, 0xb9, 0x36, 0x06, 0x5b, 0x9f, 0xfb, 0xdf, 0x23, 0xd2,
+    0xff, 0x4e, 0x2e, 0xea, 0x42, 0xd7, 0x68, 0x7b, 0x9a, 0x28, 0xc3, 0x88, 0x5d, 0xc2, 0x22, 0x49,
+    0x92, 0xe8, 0x64, 0x1d, 0x0c, 0x67, 0x42, 0x48, 0x5d, 0x6a, 0x43, 0x34, 0x7e, 0x43, 0xa7, 0xd5,
+    0xc4, 0x7e, 0xb7, 0x79, 0xf0, 0x0b, 0xc5, 0x8f, 0xf2, 0xfc, 0xf3, 0x01, 0x00, 0x00,
+};
+const WebAsset reboot_html = {reboot_html_gz, sizeof(reboot_html_gz), "text/html", "\"b4bdaeca821f8119\""};
+
+#endif // WEBPAGES_H
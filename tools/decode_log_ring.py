@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+"""Decode a dump of the deferred log ring (src/log_ring.h) into text.
+
+    curl -u user:pass http://<device>/logring -o ring.bin
+    python3 tools/decode_log_ring.py ring.bin .pio/build/esp32cam/firmware.elf
+
+Records only hold pointers to their format strings and trace scopes, so the firmware ELF the
+device runs is needed to turn those back into text. Every slot whose sequence number shows a
+complete record is printed in log order, including records the device has already drained,
+which makes the dump a short history of what led up to it. Slots being written while the dump
+was taken are skipped.
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+LEVELS = {1: "F", 2: "E", 3: "W", 4: "I", 5: "T", 6: "V"}
+ARG_NONE, ARG_INT, ARG_UINT, ARG_INT64, ARG_UINT64, ARG_DOUBLE, ARG_STR, ARG_PTR = range(8)
+SPEC = re.compile(r"%([-+ #0-9.*]*)[hlLqjzt]*([diouxXcsSfFeEgGaAp%])")
+
+
+class Elf:
+    """Just enough of ELF32 to read strings at their load addresses."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        if self.data[:4] != b"\x7fELF" or self.data[4] != 1:
+            sys.exit("%s is not a 32 bit ELF file" % path)
+        shoff, = struct.unpack_from("<I", self.data, 0x20)
+        shentsize, shnum = struct.unpack_from("<HH", self.data, 0x2E)
+        self.sections = []
+        for i in range(shnum):
+            _, sh_type, flags, addr, offset, size = struct.unpack_from("<IIIIII", self.data, shoff + i * shentsize)
+            if (flags & 0x2) and sh_type == 1 and addr:   # SHF_ALLOC, SHT_PROGBITS
+                self.sections.append((addr, offset, size))
+
+    def string(self, addr):
+        if addr == 0:
+            return None
+        for base, offset, size in self.sections:
+            if base <= addr < base + size:
+                start = offset + addr - base
+                end = self.data.find(b"\0", start, offset + size)
+                return self.data[start:end].decode("utf-8", "replace")
+        return "<0x%08x>" % addr
+
+
+def format_record(fmt, types, words, text):
+    args = []
+    w = 0
+    for k in range(8):
+        t = (types >> (4 * k)) & 0xF
+        if t == ARG_NONE:
+            break
+        if t in (ARG_INT64, ARG_UINT64, ARG_DOUBLE):
+            raw = words[w] | (words[w + 1] << 32)
+            w += 2
+            if t == ARG_INT64:
+                args.append(struct.unpack("<q", struct.pack("<Q", raw))[0])
+            elif t == ARG_DOUBLE:
+                args.append(struct.unpack("<d", struct.pack("<Q", raw))[0])
+            else:
+                args.append(raw)
+        else:
+            v = words[w]
+            w += 1
+            if t == ARG_INT:
+                args.append(struct.unpack("<i", struct.pack("<I", v))[0])
+            elif t == ARG_STR:
+                args.append(text[v:text.index(b"\0", v)].decode("utf-8", "replace"))
+            elif t == ARG_PTR:
+                args.append("0x%x" % v)
+            else:
+                args.append(v)
+
+    it = iter(args)
+
+    # a * width or precision takes the next argument, as printf does
+    def star(m):
+        v = next(it, 0)
+        if not isinstance(v, int):
+            v = 0
+        if m.group(0).startswith("."):
+            return ".%d" % v if v >= 0 else ""
+        return str(v)
+
+    def convert(m):
+        flags, conv = m.group(1), m.group(2)
+        if conv == "%":
+            return "%"
+        flags = re.sub(r"\.?\*", star, flags)
+        try:
+            v = next(it)
+        except StopIteration:
+            return "<?>"
+        if conv == "p":
+            return str(v)
+        if conv in "sS":
+            return ("%" + flags + "s") % (v,)
+        if conv == "u":
+            conv = "d"
+        if conv in "xXo" and isinstance(v, int) and v < 0:
+            v &= 0xFFFFFFFF
+        try:
+            return ("%" + flags + conv) % (v,)
+        except (TypeError, ValueError):
+            return "<?>"
+
+    return SPEC.sub(convert, fmt)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("dump")
+    parser.add_argument("elf")
+    args = parser.parse_args()
+
+    with open(args.dump, "rb") as f:
+        dump = f.read()
+    elf = Elf(args.elf)
+
+    if dump[:4] != b"LRG1":
+        sys.exit("%s is not a log ring dump" % args.dump)
+    slots, slot_size, arg_words, text_size, enqueued, dequeued, dropped, now = struct.unpack_from("<8I", dump, 4)
+    base = 36
+
+    records = []
+    for i in range(slots):
+        off = base + i * slot_size
+        seq, index, ms, fmt, scope, types, level, text_len = struct.unpack_from("<6IBB", dump, off)
+        if seq != index + 1 and seq != index + slots:
+            continue   # free, or being written during the dump
+        if index & (slots - 1) != i or fmt == 0:
+            continue
+        words = struct.unpack_from("<%dI" % arg_words, dump, off + 28)
+        text = dump[off + 28 + 4 * arg_words:off + 28 + 4 * arg_words + text_size]
+        records.append((index, ms, level, elf.string(scope) or "", elf.string(fmt), types, words, text,
+                        seq == index + 1))
+
+    print("# %d records in %d slots, %d recorded, %d formatted, %d dropped, dumped at %lu ms"
+          % (len(records), slots, enqueued, dequeued, dropped, now))
+    for index, ms, level, scope, fmt, types, words, text, pending in sorted(records):
+        print("%10lu %s%s %s: %s" % (ms, LEVELS.get(level, "?"), "*" if pending else " ", scope,
+                                     format_record(fmt, types, words, text)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,90 @@
+#!/usr/bin/env python3
+"""Gzip the admin UI assets in web/ and emit them as PROGMEM arrays in src/webpages.h.
+
+Runs automatically as a PlatformIO pre-build script (see platformio.ini) and can
+also be run by hand from the project root:  python3 tools/embed_webpages.py
+
+The output is deterministic (gzip mtime is zeroed) so the generated header only
+changes when an asset changes, and each asset gets a strong ETag derived from
+the SHA-256 of its uncompressed content.
+"""
+
+import gzip
+import hashlib
+import os
+import sys
+
+# (source file in web/, C identifier, MIME type)
+ASSETS = [
+    ("index.html", "index_html", "text/html"),
+    ("simple.css", "simple_css", "text/css"),
+    ("logout.html", "logout_html", "text/html"),
+    ("reboot.html", "reboot_html", "text/html"),
+]
+
+HEADER_TOP = """////////////////////////////////////////////////////////////////////
+/// @file webpages.h
+/// @brief Gzipped admin UI assets. GENERATED by tools/embed_webpages.py
+/// from the files in web/ - edit those and rebuild, not this file.
+////////////////////////////////////////////////////////////////////
+
+#ifndef WEBPAGES_H
+#define WEBPAGES_H
+
+struct WebAsset
+{
+    const uint8_t *data; // gzip stream
+    size_t len;
+    const char *contentType;
+    const char *etag; // quoted strong ETag
+};
+
+"""
+
+HEADER_BOTTOM = """#endif // WEBPAGES_H
+"""
+
+
+def c_array(name, blob):
+    lines = []
+    for i in range(0, len(blob), 16):
+        chunk = blob[i:i + 16]
+        lines.append("    " + ", ".join("0x%02x" % b for b in chunk) + ",")
+    return "const uint8_t %s_gz[] PROGMEM = {\n%s\n};\n" % (name, "\n".join(lines))
+
+
+def generate(project_dir):
+    web_dir = os.path.join(project_dir, "web")
+    out_path = os.path.join(project_dir, "src", "webpages.h")
+
+    parts = [HEADER_TOP]
+    for file_name, ident, mime in ASSETS:
+        with open(os.path.join(web_dir, file_name), "rb") as f:
+            raw = f.read()
+        packed = gzip.compress(raw, compresslevel=9, mtime=0)
+        etag = hashlib.sha256(raw).hexdigest()[:16]
+        parts.append("// %s: %d bytes -> %d bytes gzipped\n" % (file_name, len(raw), len(packed)))
+        parts.append(c_array(ident, packed))
+        parts.append("const WebAsset %s = {%s_gz, sizeof(%s_gz), \"%s\", \"\\\"%s\\\"\"};\n\n"
+                     % (ident, ident, ident, mime, etag))
+    parts.append(HEADER_BOTTOM)
+    text = "".join(parts)
+
+    try:
+        with open(out_path, "r") as f:
+            if f.read() == text:
+                return
+    except FileNotFoundError:
+        pass
+
+    with open(out_path, "w") as f:
+        f.write(text)
+    print("embed_webpages: regenerated %s" % os.path.relpath(out_path, project_dir))
+
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO/SCons
+    generate(env.subst("$PROJECT_DIR"))  # noqa: F821
+except NameError:
+    if __name__ == "__main__":
+        generate(os.path.dirname(os.path.dirname(os.path.abspath(sys.argv[0]))))
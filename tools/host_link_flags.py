@@ -0,0 +1,13 @@
+"""PlatformIO extra script for the native envs: pass the flags the linker needs too.
+
+build_flags only reach the compiler, but -pthread and -fsanitize=... must also be on
+the link line or the program fails to link (or links without the sanitizer runtime).
+"""
+
+Import("env")  # noqa: F821 - provided by PlatformIO
+
+LINK_PREFIXES = ("-pthread", "-fsanitize=", "-fno-omit-frame-pointer")
+
+flags = env.ParseFlags(env["BUILD_FLAGS"])  # noqa: F821
+link = [f for f in flags.get("CCFLAGS", []) if isinstance(f, str) and f.startswith(LINK_PREFIXES)]
+env.Append(LINKFLAGS=link)  # noqa: F821
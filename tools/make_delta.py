@@ -0,0 +1,205 @@
+#!/usr/bin/env python3
+"""Build a delta patch that turns one firmware image into another.
+
+    python3 tools/make_delta.py OLD.bin NEW.bin OUT.delta
+
+Publish the patch next to the full images as <APP_NAME>_<from>-<to>.delta (for example
+ESP32FWApp_3-4.delta); checkFWUpdate() fetches it instead of <APP_NAME>_<to>.bin when the
+device runs version <from>, and falls back to the full image if patching fails.
+
+The format is described in lib/DeltaPatch/src/DeltaPatch.h. Matching is bsdiff style: a
+region of the new image is coded against the most similar region of the old one as a
+byte-wise difference, which is mostly zeros even where addresses moved, and those zero runs
+are run-length coded. Bytes with no usable match are stored verbatim.
+"""
+
+import argparse
+import hashlib
+import struct
+import sys
+
+MAGIC = b"EDP1"
+KEY = 8            # bytes hashed to find match candidates
+MIN_MATCH = 16     # shorter matches are stored as extra bytes
+SLACK = 32         # mismatches tolerated past the best point while extending a match
+MERGE_ZEROS = 3    # zero runs shorter than this stay inside a literal token
+
+
+def varint(n):
+    out = bytearray()
+    while True:
+        b = n & 0x7F
+        n >>= 7
+        if n:
+            out.append(b | 0x80)
+        else:
+            out.append(b)
+            return bytes(out)
+
+
+def zigzag(n):
+    return (n << 1) if n >= 0 else ((-n << 1) - 1)
+
+
+def extend(old, new, o, n):
+    """Length of the approximate match old[o:], new[n:] (bsdiff: equal bytes minus unequal)."""
+    score = best = best_len = 0
+    k = 0
+    limit = min(len(old) - o, len(new) - n)
+    while k < limit:
+        score += 1 if old[o + k] == new[n + k] else -1
+        k += 1
+        if score > best:
+            best, best_len = score, k
+        elif score < best - SLACK:
+            break
+    return best_len
+
+
+def find_matches(old, new):
+    index = {}
+    for j in range(len(old) - KEY, -1, -1):
+        index[old[j:j + KEY]] = j   # keeps the first occurrence
+
+    matches = []   # (new_start, old_start, length)
+    i = 0
+    shift = 0      # old - new offset of the previous match, usually still right after a change
+    while i + KEY <= len(new):
+        candidates = []
+        if 0 <= i + shift and i + shift + KEY <= len(old) and old[i + shift:i + shift + KEY] == new[i:i + KEY]:
+            candidates.append(i + shift)
+        j = index.get(new[i:i + KEY])
+        if j is not None and j != i + shift:
+            candidates.append(j)
+
+        best_len, best_old = 0, 0
+        for j in candidates:
+            length = extend(old, new, j, i)
+            if length > best_len:
+                best_len, best_old = length, j
+
+        if best_len >= MIN_MATCH:
+            matches.append((i, best_old, best_len))
+            shift = best_old - i
+            i += best_len
+        else:
+            i += 1
+    return matches
+
+
+def encode_diff(old, new, o, n, length):
+    out = bytearray()
+    diff = bytes((new[n + k] - old[o + k]) & 0xFF for k in range(length))
+    k = 0
+    while k < length:
+        if diff[k] == 0:
+            z = k
+            while z < length and diff[z] == 0:
+                z += 1
+            out += varint((z - k) << 1)
+            k = z
+            continue
+        # literal run, absorbing short zero runs
+        e = k
+        while e < length:
+            if diff[e] == 0:
+                z = e
+                while z < length and diff[z] == 0 and z - e < MERGE_ZEROS:
+                    z += 1
+                if z - e >= MERGE_ZEROS or z == length:
+                    break
+                e = z
+            else:
+                e += 1
+        out += varint(((e - k) << 1) | 1) + diff[k:e]
+        k = e
+    return bytes(out)
+
+
+def make_delta(old, new):
+    out = bytearray(MAGIC)
+    out += struct.pack("<III", len(old), len(new), 0)
+    out += hashlib.sha256(new).digest() + hashlib.sha256(old).digest()
+
+    matches = find_matches(old, new)
+    old_pos = 0
+    pos = 0
+    if not matches or matches[0][0] > 0:
+        first = matches[0][0] if matches else len(new)
+        out += varint(0) + varint(0) + varint(first) + new[:first]
+        pos = first
+    for k, (n, o, length) in enumerate(matches):
+        end = matches[k + 1][0] if k + 1 < len(matches) else len(new)
+        extra = new[n + length:end]
+        out += varint(zigzag(o - old_pos)) + varint(length) + varint(len(extra))
+        out += encode_diff(old, new, o, n, length) + extra
+        old_pos = o + length
+        pos = end
+    assert pos == len(new)
+    return bytes(out)
+
+
+def apply_delta(old, patch):
+    """Reference applier, used to check every patch before it is written."""
+    assert patch[:4] == MAGIC
+    old_size, new_size, _ = struct.unpack_from("<III", patch, 4)
+    p = 80
+    out = bytearray()
+    old_pos = 0
+
+    def read_varint():
+        nonlocal p
+        n = shift = 0
+        while True:
+            b = patch[p]
+            p += 1
+            n |= (b & 0x7F) << shift
+            shift += 7
+            if not b & 0x80:
+                return n
+
+    while len(out) < new_size:
+        zz = read_varint()
+        old_pos += (zz >> 1) ^ -(zz & 1)
+        diff_len, extra_len = read_varint(), read_varint()
+        left = diff_len
+        while left:
+            t = read_varint()
+            n = t >> 1
+            if t & 1:
+                out += bytes((old[old_pos + k] + patch[p + k]) & 0xFF for k in range(n))
+                p += n
+            else:
+                out += old[old_pos:old_pos + n]
+            old_pos += n
+            left -= n
+        out += patch[p:p + extra_len]
+        p += extra_len
+    assert p == len(patch)
+    return bytes(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("old")
+    parser.add_argument("new")
+    parser.add_argument("out")
+    args = parser.parse_args()
+
+    with open(args.old, "rb") as f:
+        old = f.read()
+    with open(args.new, "rb") as f:
+        new = f.read()
+
+    patch = make_delta(old, new)
+    if apply_delta(old, patch) != new:
+        sys.exit("make_delta: patch does not reproduce %s" % args.new)
+
+    with open(args.out, "wb") as f:
+        f.write(patch)
+    print("make_delta: %s -> %s: %d bytes (%.1f%% of %d)" % (args.old, args.new, len(patch),
+                                                            100.0 * len(patch) / max(len(new), 1), len(new)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,141 @@
+#!/usr/bin/env python3
+"""Local stand-in for the firmware HTTP server, for testing OTA downloads.
+
+Serves a directory the way the device expects from HTTP_SERVER:HTTP_PORT:
+
+  GET /firmware/             JSON listing  [{"name": ..., "type": "file", "size": ...}]
+  GET /firmware/<name>       the file, honouring "Range: bytes=N-" with 206 responses
+  GET /firmware/<name>.sha256  sha256sum style digest, computed from <name> when
+                             there is no such file on disk
+
+Faults can be injected to exercise the resume logic:
+
+  --drop-after N   close every body after N bytes, so a download needs several resumes
+  --no-range       ignore Range headers and always answer 200 with the whole file
+  --no-sha256      do not synthesise .sha256 files
+  --rate KBPS      throttle bodies to roughly KBPS kilobytes per second
+
+Example:  python3 tools/ota_server.py --dir .pio/build/esp32cam --drop-after 200000
+(name the image <APP_NAME>_<version>.bin so checkFWUpdate() picks it up)
+"""
+
+import argparse
+import hashlib
+import json
+import os
+import re
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from urllib.parse import unquote
+
+PREFIX = "/firmware/"
+CHUNK = 4096
+
+
+class FirmwareHandler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+    opts = None
+
+    def do_GET(self):
+        path = unquote(self.path.split("?", 1)[0])
+        if not path.startswith(PREFIX):
+            return self.send_error(404)
+
+        name = path[len(PREFIX):]
+        if name == "":
+            return self.send_listing()
+        if "/" in name or name.startswith("."):
+            return self.send_error(404)
+
+        file_path = os.path.join(self.opts.dir, name)
+        if os.path.isfile(file_path):
+            return self.send_file(file_path)
+
+        if name.endswith(".sha256") and not self.opts.no_sha256:
+            image = os.path.join(self.opts.dir, name[:-len(".sha256")])
+            if os.path.isfile(image):
+                with open(image, "rb") as f:
+                    digest = hashlib.sha256(f.read()).hexdigest()
+                return self.send_bytes(("%s  %s\n" % (digest, os.path.basename(image))).encode(), "text/plain")
+
+        self.send_error(404)
+
+    def send_listing(self):
+        entries = []
+        for entry in sorted(os.listdir(self.opts.dir)):
+            full = os.path.join(self.opts.dir, entry)
+            entries.append({"name": entry,
+                            "type": "file" if os.path.isfile(full) else "directory",
+                            "size": os.path.getsize(full) if os.path.isfile(full) else 0})
+        self.send_bytes(json.dumps(entries).encode(), "application/json")
+
+    def send_bytes(self, body, content_type):
+        self.send_response(200)
+        self.send_header("Content-Type", content_type)
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def send_file(self, file_path):
+        size = os.path.getsize(file_path)
+        start = 0
+        match = re.match(r"bytes=(\d+)-$", self.headers.get("Range", ""))
+        if match and not self.opts.no_range:
+            start = int(match.group(1))
+            if start >= size:
+                self.send_response(416)
+                self.send_header("Content-Range", "bytes */%d" % size)
+                self.send_header("Content-Length", "0")
+                self.end_headers()
+                return
+            self.send_response(206)
+            self.send_header("Content-Range", "bytes %d-%d/%d" % (start, size - 1, size))
+        else:
+            self.send_response(200)
+        self.send_header("Content-Type", "application/octet-stream")
+        self.send_header("Content-Length", str(size - start))
+        self.send_header("Accept-Ranges", "none" if self.opts.no_range else "bytes")
+        self.end_headers()
+
+        sent = 0
+        with open(file_path, "rb") as f:
+            f.seek(start)
+            while True:
+                want = CHUNK
+                if self.opts.drop_after:
+                    want = min(want, self.opts.drop_after - sent)
+                    if want <= 0:
+                        self.log_message("dropping connection after %d bytes (offset %d)", sent, start + sent)
+                        self.close_connection = True
+                        return
+                data = f.read(want)
+                if not data:
+                    return
+                self.wfile.write(data)
+                sent += len(data)
+                if self.opts.rate:
+                    time.sleep(len(data) / (self.opts.rate * 1024.0))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--dir", default=".", help="directory holding the firmware images")
+    parser.add_argument("--bind", default="0.0.0.0")
+    parser.add_argument("--port", type=int, default=5000)
+    parser.add_argument("--drop-after", type=int, default=0, metavar="N")
+    parser.add_argument("--no-range", action="store_true")
+    parser.add_argument("--no-sha256", action="store_true")
+    parser.add_argument("--rate", type=float, default=0, metavar="KBPS")
+    FirmwareHandler.opts = parser.parse_args()
+
+    server = ThreadingHTTPServer((FirmwareHandler.opts.bind, FirmwareHandler.opts.port), FirmwareHandler)
+    print("Serving %s on http://%s:%d%s" % (os.path.abspath(FirmwareHandler.opts.dir), FirmwareHandler.opts.bind,
+                                            FirmwareHandler.opts.port, PREFIX))
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()